@@ -25,6 +25,8 @@
 #ifndef RINGBUFFER_H
 #define RINGBUFFER_H
 
+#include <sys/uio.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -88,6 +90,26 @@ int ringbuffer_add_one(ringbuffer_t *__restrict rb, char c);
 unsigned ringbuffer_add(ringbuffer_t *__restrict rb, const char *buf,
                         unsigned n);
 
+/**
+ * @brief           Get the free space of the ringbuffer as up to two linear regions.
+ * @details         The caller may write into the regions directly and then call
+ *                  ringbuffer_commit() to append the written elements.
+ *                  Unused regions have a length of 0.
+ * @param[in]       rb    Ringbuffer to operate on.
+ * @param[out]      iov   The regions, in order.
+ * @param[in]       n     Reserve at most n elements.
+ * @returns         Number of elements in @p iov.
+ */
+unsigned ringbuffer_reserve_iov(const ringbuffer_t *__restrict rb,
+                                struct iovec iov[2], unsigned n);
+
+/**
+ * @brief           Append elements written to the regions of ringbuffer_reserve_iov().
+ * @param[in,out]   rb    Ringbuffer to operate on.
+ * @param[in]       n     Number of elements written, at most the number reserved.
+ */
+void ringbuffer_commit(ringbuffer_t *__restrict rb, unsigned n);
+
 /**
  * @brief           Peek and remove oldest element from the ringbuffer.
  * @param[in,out]   rb   Ringbuffer to operate on.
@@ -160,6 +182,19 @@ int ringbuffer_peek_one(const ringbuffer_t *__restrict rb);
 unsigned ringbuffer_peek(const ringbuffer_t *__restrict rb, char *buf,
                          unsigned n);
 
+/**
+ * @brief           Get the oldest elements of the buffer as up to two linear regions,
+ *                  without removing them.
+ * @details         Call ringbuffer_remove() once the elements have been processed.
+ *                  Unused regions have a length of 0.
+ * @param[in]       rb    Ringbuffer to operate on.
+ * @param[out]      iov   The regions, in order.
+ * @param[in]       n     Peek at most n elements.
+ * @returns         Number of elements in @p iov.
+ */
+unsigned ringbuffer_peek_iov(const ringbuffer_t *__restrict rb,
+                             struct iovec iov[2], unsigned n);
+
 #ifdef __cplusplus
 }
 #endif
@@ -203,6 +203,20 @@ extern clist_node_t sched_runqueues[SCHED_PRIO_LEVELS];
  */
 NORETURN void sched_task_exit(void);
 
+/**
+ * @brief   Called by sched_task_exit() for the exiting thread
+ *
+ * The default implementation is empty and defined as weak symbol. A module
+ * keeping state per thread overrides it to release that state, so that the
+ * next thread created with the same PID does not inherit it. Only one module
+ * can do so.
+ *
+ * @note    Called with interrupts disabled
+ *
+ * @param[in] pid   PID of the exiting thread
+ */
+void sched_thread_exit_hook(kernel_pid_t pid);
+
 #ifdef MODULE_SCHED_CB
 /**
  *  @brief  Register a callback that will be called on every scheduler run
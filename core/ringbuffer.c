@@ -20,6 +20,8 @@
 
 #include <string.h>
 
+#include "assert.h"
+
 /**
  * @brief           Add an element to the end of the ringbuffer.
  * @details         This helper function does not check the pre-requirements for adding,
@@ -54,17 +56,62 @@ static char get_head(ringbuffer_t *restrict rb)
     return result;
 }
 
+/**
+ * @brief           Describe @p n elements starting at @p pos as up to two linear regions.
+ * @param[in]       rb   Ringbuffer to operate on.
+ * @param[in]       pos  Position of the first element, may exceed the size once.
+ * @param[in]       n    Number of elements.
+ * @param[out]      iov  The regions.
+ * @returns         @p n
+ */
+static unsigned get_regions(const ringbuffer_t *restrict rb, unsigned pos,
+                            unsigned n, struct iovec iov[2])
+{
+    if (pos >= rb->size) {
+        pos -= rb->size;
+    }
+    unsigned bytes_till_end = rb->size - pos;
+
+    iov[0].iov_base = rb->buf + pos;
+    iov[0].iov_len = (n < bytes_till_end) ? n : bytes_till_end;
+    iov[1].iov_base = rb->buf;
+    iov[1].iov_len = n - iov[0].iov_len;
+    return n;
+}
+
 unsigned ringbuffer_add(ringbuffer_t *restrict rb, const char *buf, unsigned n)
 {
-    unsigned i;
+    struct iovec iov[2];
 
-    for (i = 0; i < n; i++) {
-        if (ringbuffer_full(rb)) {
-            break;
-        }
-        add_tail(rb, buf[i]);
+    n = ringbuffer_reserve_iov(rb, iov, n);
+    memcpy(iov[0].iov_base, buf, iov[0].iov_len);
+    memcpy(iov[1].iov_base, buf + iov[0].iov_len, iov[1].iov_len);
+    rb->avail += n;
+    return n;
+}
+
+unsigned ringbuffer_reserve_iov(const ringbuffer_t *restrict rb,
+                                struct iovec iov[2], unsigned n)
+{
+    if (n > ringbuffer_get_free(rb)) {
+        n = ringbuffer_get_free(rb);
+    }
+    return get_regions(rb, rb->start + rb->avail, n, iov);
+}
+
+void ringbuffer_commit(ringbuffer_t *restrict rb, unsigned n)
+{
+    assert(n <= ringbuffer_get_free(rb));
+    rb->avail += n;
+}
+
+unsigned ringbuffer_peek_iov(const ringbuffer_t *restrict rb,
+                             struct iovec iov[2], unsigned n)
+{
+    if (n > rb->avail) {
+        n = rb->avail;
     }
-    return i;
+    return get_regions(rb, rb->start, n, iov);
 }
 
 int ringbuffer_add_one(ringbuffer_t *restrict rb, char c)
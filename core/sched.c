@@ -198,6 +198,11 @@ void sched_switch(uint16_t other_prio)
     }
 }
 
+void __attribute__((weak)) sched_thread_exit_hook(kernel_pid_t pid)
+{
+    (void)pid;
+}
+
 NORETURN void sched_task_exit(void)
 {
     DEBUG("sched_task_exit: ending thread %" PRIkernel_pid "...\n",
@@ -207,6 +212,8 @@ NORETURN void sched_task_exit(void)
     sched_threads[sched_active_pid] = NULL;
     sched_num_threads--;
 
+    sched_thread_exit_hook(sched_active_pid);
+
     sched_set_status((thread_t *)sched_active_thread, STATUS_STOPPED);
 
     sched_active_thread = NULL;
@@ -20,10 +20,17 @@
 #include <fcntl.h>
 #include <stdarg.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "vfs.h"
 
+/**
+ * @brief   Number of iovec elements passed to the VFS in one go by readv()
+ *          and writev()
+ */
+#define NATIVE_VFS_IOV_BATCH (8)
+
 int open(const char *name, int flags, ...)
 {
     unsigned mode = 0;
@@ -68,6 +75,58 @@ ssize_t write(int fd, const void *src, size_t count)
     return res;
 }
 
+/**
+ * @brief   Transfer @p iov in batches of NATIVE_VFS_IOV_BATCH elements using
+ *          vfs_readv() or vfs_writev()
+ */
+static ssize_t _xferv(int fd, const struct iovec *iov, int iovcnt,
+                      ssize_t (*xfer)(int, const iolist_t *))
+{
+    iolist_t iol[NATIVE_VFS_IOV_BATCH];
+    ssize_t total = 0;
+
+    if (iovcnt < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    while (iovcnt > 0) {
+        int n = (iovcnt < NATIVE_VFS_IOV_BATCH) ? iovcnt : NATIVE_VFS_IOV_BATCH;
+        size_t len = 0;
+        for (int i = 0; i < n; i++) {
+            iol[i].iol_base = iov[i].iov_base;
+            iol[i].iol_len = iov[i].iov_len;
+            iol[i].iol_next = (i + 1 < n) ? &iol[i + 1] : NULL;
+            len += iov[i].iov_len;
+        }
+        ssize_t res = xfer(fd, iol);
+        if (res < 0) {
+            if (total > 0) {
+                break;
+            }
+            /* vfs returns negative error codes */
+            errno = -res;
+            return -1;
+        }
+        total += res;
+        if ((size_t)res < len) {
+            break;
+        }
+        iov += n;
+        iovcnt -= n;
+    }
+    return total;
+}
+
+ssize_t readv(int fd, const struct iovec *iov, int iovcnt)
+{
+    return _xferv(fd, iov, iovcnt, vfs_readv);
+}
+
+ssize_t writev(int fd, const struct iovec *iov, int iovcnt)
+{
+    return _xferv(fd, iov, iovcnt, vfs_writev);
+}
+
 int close(int fd)
 {
     int res = vfs_close(fd);
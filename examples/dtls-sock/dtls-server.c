@@ -115,7 +115,7 @@ void *dtls_server_wrapper(void *arg)
             res = sock_dtls_recv(&sock, &session, rcv, sizeof(rcv),
                                   10 * US_PER_SEC);
             if (res < 0) {
-                if (res != -ETIMEDOUT) {
+                if ((res != -ETIMEDOUT) && (res != -SOCK_DTLS_HANDSHAKE)) {
                     printf("Error receiving UDP over DTLS %d", (int)res);
                 }
                 continue;
@@ -10,6 +10,7 @@ PSEUDOMODULES += cord_ep_standalone
 PSEUDOMODULES += core_%
 PSEUDOMODULES += cortexm_fpu
 PSEUDOMODULES += cpu_check_address
+PSEUDOMODULES += credman_vfs
 PSEUDOMODULES += crypto_%	# crypto_aes or crypto_3des
 PSEUDOMODULES += devfs_%
 PSEUDOMODULES += dhcpv6_%
@@ -17,6 +18,9 @@ PSEUDOMODULES += ecc_%
 PSEUDOMODULES += emb6_router
 PSEUDOMODULES += event_%
 PSEUDOMODULES += fmt_%
+PSEUDOMODULES += gcoap_cocoa
+PSEUDOMODULES += gcoap_dtls
+PSEUDOMODULES += gcoap_forward_proxy
 PSEUDOMODULES += gnrc_dhcpv6_%
 PSEUDOMODULES += gnrc_ipv6_default
 PSEUDOMODULES += gnrc_ipv6_ext_frag_stats
@@ -58,6 +62,7 @@ PSEUDOMODULES += log
 PSEUDOMODULES += log_printfnoformat
 PSEUDOMODULES += log_color
 PSEUDOMODULES += lora
+PSEUDOMODULES += memarray_grow
 PSEUDOMODULES += mpu_stack_guard
 PSEUDOMODULES += mpu_noexec_ram
 PSEUDOMODULES += nanocoap_%
@@ -89,8 +94,11 @@ PSEUDOMODULES += scanf_float
 PSEUDOMODULES += sched_cb
 PSEUDOMODULES += semtech_loramac_rx
 PSEUDOMODULES += slipdev_stdio
+PSEUDOMODULES += sntp_async
 PSEUDOMODULES += sock
 PSEUDOMODULES += sock_async
+PSEUDOMODULES += sock_dns_async
+PSEUDOMODULES += sock_dns_cache
 PSEUDOMODULES += sock_dtls
 PSEUDOMODULES += sock_ip
 PSEUDOMODULES += sock_tcp
@@ -227,10 +235,21 @@ PSEUDOMODULES += skald_eddystone
 # define optimized read function of DS18 driver as a pseudo module
 PSEUDOMODULES += ds18_optimized
 
+# Use the bitsliced, constant-time AES implementation instead of T tables
+PSEUDOMODULES += crypto_aes_ct
+# Use the x86 AES instructions for AES if the CPU supports them (native only)
+PSEUDOMODULES += crypto_aes_ni
 # By using this pseudomodule, T tables will be precalculated.
 PSEUDOMODULES += crypto_aes_precalculated
 # This pseudomodule causes a loop in AES to be unrolled (more flash, less CPU)
 PSEUDOMODULES += crypto_aes_unroll
+# Compute several ChaCha20 keystream blocks at once using vector instructions
+PSEUDOMODULES += crypto_chacha20poly1305_simd
+
+# This pseudomodule causes the SHA-256 rounds to be unrolled (more flash, less CPU)
+PSEUDOMODULES += hashes_sha256_unroll
+# Use the x86 SHA extensions for SHA-256 if the CPU supports them (native only)
+PSEUDOMODULES += hashes_sha256_shani
 
 # declare shell version of test_utils_interactive_sync
 PSEUDOMODULES += test_utils_interactive_sync_shell
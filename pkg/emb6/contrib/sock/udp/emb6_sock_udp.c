@@ -268,6 +268,30 @@ int sock_udp_send(sock_udp_t *sock, const void *data, size_t len,
     return send_cmd.res;
 }
 
+ssize_t sock_udp_sendv(sock_udp_t *sock, const iolist_t *snips,
+                       const sock_udp_ep_t *remote)
+{
+    /* emb6 can only send from a single buffer */
+    static uint8_t buf[UIP_BUFSIZE - (UIP_LLH_LEN + UIP_IPUDPH_LEN)];
+    static mutex_t lock = MUTEX_INIT;
+    size_t len = iolist_size(snips);
+    ssize_t res;
+
+    if (len > sizeof(buf)) {
+        return -ENOMEM;
+    }
+    mutex_lock(&lock);
+    for (size_t offset = 0; snips; snips = snips->iol_next) {
+        if (snips->iol_len) {
+            memcpy(&buf[offset], snips->iol_base, snips->iol_len);
+            offset += snips->iol_len;
+        }
+    }
+    res = sock_udp_send(sock, buf, len, remote);
+    mutex_unlock(&lock);
+    return res;
+}
+
 static void _timeout_callback(void *arg)
 {
     msg_t msg = { .type = _MSG_TYPE_TIMEOUT };
@@ -49,10 +49,28 @@
 #define ETHERNET_IFNAME1 'E'
 #define ETHERNET_IFNAME2 'T'
 
-static kernel_pid_t _pid = KERNEL_PID_UNDEF;
-static char _stack[LWIP_NETDEV_STACKSIZE];
-static msg_t _queue[LWIP_NETDEV_QUEUE_LEN];
+#ifdef MODULE_LWIP_NETDEV_THREAD_PER_NETIF
+#define LWIP_NETDEV_THREADS         (LWIP_NETDEV_THREAD_NUMOF)
+#else
+#define LWIP_NETDEV_THREADS         (1U)
+#endif
+
+/**
+ * @brief   Receive thread, the last one is shared by all interfaces not
+ *          having a thread of their own
+ */
+typedef struct {
+    netdev_t *dev;                      /**< interface the thread was started for */
+    kernel_pid_t pid;                   /**< PID of the thread */
+    msg_t queue[LWIP_NETDEV_QUEUE_LEN]; /**< message queue */
+    char stack[LWIP_NETDEV_STACKSIZE];  /**< thread stack */
+} _rx_thread_t;
+
+static _rx_thread_t _threads[LWIP_NETDEV_THREADS];
+static unsigned _threads_numof;
+#ifndef MODULE_LWIP_NETDEV_ZEROCOPY
 static char _tmp_buf[LWIP_NETDEV_BUFLEN];
+#endif
 
 #ifdef MODULE_NETDEV_ETH
 static err_t _eth_link_output(struct netif *netif, struct pbuf *p);
@@ -81,18 +99,23 @@ err_t lwip_netdev_init(struct netif *netif)
     uint16_t dev_type;
     err_t res = ERR_OK;
 
-    /* start multiplexing thread (only one needed) */
-    if (_pid <= KERNEL_PID_UNDEF) {
-        _pid = thread_create(_stack, LWIP_NETDEV_STACKSIZE, LWIP_NETDEV_PRIO,
-                             THREAD_CREATE_STACKTEST, _event_loop, netif,
-                             LWIP_NETDEV_NAME);
-        if (_pid <= 0) {
+    netdev = (netdev_t *)netif->state;
+
+    /* start a receive thread for this interface while there are some left,
+     * otherwise it is multiplexed onto the last one */
+    if (_threads_numof < LWIP_NETDEV_THREADS) {
+        _rx_thread_t *t = &_threads[_threads_numof];
+        t->dev = netdev;
+        t->pid = thread_create(t->stack, sizeof(t->stack), LWIP_NETDEV_PRIO,
+                               THREAD_CREATE_STACKTEST, _event_loop, t,
+                               LWIP_NETDEV_NAME);
+        if (t->pid <= 0) {
             return ERR_IF;
         }
+        _threads_numof++;
     }
 
     /* initialize netdev and netif */
-    netdev = (netdev_t *)netif->state;
     netdev->driver->init(netdev);
     _configure_netdev(netdev);
     netdev->event_callback = _event_cb;
@@ -238,6 +261,43 @@ static err_t _ieee802154_link_output(struct netif *netif, struct pbuf *p)
 }
 #endif
 
+#ifdef MODULE_LWIP_NETDEV_ZEROCOPY
+static struct pbuf *_get_recv_pkt(netdev_t *dev)
+{
+    /* ask for the frame length first, so it can be read into the pbuf
+     * directly */
+    int len = dev->driver->recv(dev, NULL, 0, NULL);
+
+    if (len < 0) {
+        DEBUG("lwip_netdev: an error occurred while reading the packet\n");
+        return NULL;
+    }
+    assert(((unsigned)len) <= UINT16_MAX);
+    struct pbuf *p = pbuf_alloc(PBUF_RAW, (u16_t)len, PBUF_POOL);
+
+    /* drivers can only receive into one contiguous buffer, so use the heap
+     * for frames not fitting into a single pool buffer */
+    if ((p != NULL) && (p->next != NULL)) {
+        pbuf_free(p);
+        p = pbuf_alloc(PBUF_RAW, (u16_t)len, PBUF_RAM);
+    }
+    if (p == NULL) {
+        DEBUG("lwip_netdev: can not allocate in pbuf\n");
+        /* drop frame */
+        dev->driver->recv(dev, NULL, len, NULL);
+        return NULL;
+    }
+    len = dev->driver->recv(dev, p->payload, len, NULL);
+    if (len < 0) {
+        DEBUG("lwip_netdev: an error occurred while reading the packet\n");
+        pbuf_free(p);
+        return NULL;
+    }
+    /* only shrinks if the driver delivered less than announced */
+    pbuf_realloc(p, (u16_t)len);
+    return p;
+}
+#else
 static struct pbuf *_get_recv_pkt(netdev_t *dev)
 {
     int len = dev->driver->recv(dev, _tmp_buf, sizeof(_tmp_buf), NULL);
@@ -256,17 +316,28 @@ static struct pbuf *_get_recv_pkt(netdev_t *dev)
     pbuf_take(p, _tmp_buf, len);
     return p;
 }
+#endif
+
+static kernel_pid_t _thread_pid(netdev_t *dev)
+{
+    for (unsigned i = 0; i < (_threads_numof - 1); i++) {
+        if (_threads[i].dev == dev) {
+            return _threads[i].pid;
+        }
+    }
+    return _threads[_threads_numof - 1].pid;
+}
 
 static void _event_cb(netdev_t *dev, netdev_event_t event)
 {
     if (event == NETDEV_EVENT_ISR) {
-        assert(_pid != KERNEL_PID_UNDEF);
+        assert(_threads_numof > 0);
         msg_t msg;
 
         msg.type = LWIP_NETDEV_MSG_TYPE_EVENT;
         msg.content.ptr = dev;
 
-        if (msg_send(&msg, _pid) <= 0) {
+        if (msg_send(&msg, _thread_pid(dev)) <= 0) {
             DEBUG("lwip_netdev: possibly lost interrupt.\n");
         }
     }
@@ -299,8 +370,8 @@ static void _event_cb(netdev_t *dev, netdev_event_t event)
 
 static void *_event_loop(void *arg)
 {
-    (void)arg;
-    msg_init_queue(_queue, LWIP_NETDEV_QUEUE_LEN);
+    _rx_thread_t *t = arg;
+    msg_init_queue(t->queue, LWIP_NETDEV_QUEUE_LEN);
     while (1) {
         msg_t msg;
         msg_receive(&msg);
@@ -556,9 +556,18 @@ int lwip_sock_recv(struct netconn *conn, uint32_t timeout, struct netbuf **buf)
 ssize_t lwip_sock_send(struct netconn *conn, const void *data, size_t len,
                        int proto, const struct _sock_tl_ep *remote, int type)
 {
+    iolist_t snip = { .iol_base = (void *)data, .iol_len = len };
+
+    return lwip_sock_sendv(conn, &snip, proto, remote, type);
+}
+
+ssize_t lwip_sock_sendv(struct netconn *conn, const iolist_t *snips,
+                        int proto, const struct _sock_tl_ep *remote, int type)
+{
+    size_t len = iolist_size(snips);
     ip_addr_t remote_addr;
     struct netconn *tmp;
-    struct netbuf *buf;
+    struct netbuf *buf = NULL;
     int res;
     err_t err;
     u16_t remote_port = 0;
@@ -577,15 +586,8 @@ ssize_t lwip_sock_send(struct netconn *conn, const void *data, size_t len,
         }
     }
 
-    buf = netbuf_new();
-    if ((buf == NULL) || (netbuf_alloc(buf, len) == NULL) ||
-        (netbuf_take(buf, data, len) != ERR_OK)) {
-        netbuf_delete(buf);
-        return -ENOMEM;
-    }
     if ((conn == NULL) && (remote != NULL)) {
         if ((res = _create(type, proto, 0, &tmp)) < 0) {
-            netbuf_delete(buf);
             return res;
         }
     }
@@ -602,21 +604,60 @@ ssize_t lwip_sock_send(struct netconn *conn, const void *data, size_t len,
         tmp = conn;
     }
     else {
-        netbuf_delete(buf);
         return -ENOTCONN;
     }
-    res = len;  /* set for non-TCP calls */
-    if (remote != NULL) {
-        err = netconn_sendto(tmp, buf, &remote_addr, remote_port);
-    }
 #if LWIP_TCP
-    else if (tmp->type & NETCONN_TCP) {
-        err = netconn_write_partly(tmp, data, len, 0, (size_t *)(&res));
+    if ((remote == NULL) && (tmp->type & NETCONN_TCP)) {
+        /* TCP keeps the data queued until it is acknowledged, so let lwIP
+         * copy it instead of gathering it into a netbuf first */
+        res = 0;
+        err = ERR_OK;
+        for (; snips && (err == ERR_OK); snips = snips->iol_next) {
+            size_t written = 0;
+            u8_t flags = NETCONN_COPY | (snips->iol_next ? NETCONN_MORE : 0);
+
+            if (snips->iol_len == 0) {
+                continue;
+            }
+            err = netconn_write_partly(tmp, snips->iol_base, snips->iol_len,
+                                       flags, &written);
+            res += written;
+            if (written < snips->iol_len) {
+                /* non-blocking connection ran out of send buffer */
+                break;
+            }
+        }
+        if ((err != ERR_OK) && (res > 0)) {
+            /* report the part that was queued */
+            err = ERR_OK;
+        }
     }
+    else
 #endif /* LWIP_TCP */
-    else {
-        err = netconn_send(tmp, buf);
+    {
+        buf = netbuf_new();
+        if ((buf == NULL) || (netbuf_alloc(buf, len) == NULL)) {
+            err = ERR_MEM;
+            goto out;
+        }
+        for (size_t offset = 0; snips; snips = snips->iol_next) {
+            if (snips->iol_len &&
+                (pbuf_take_at(buf->p, snips->iol_base, snips->iol_len,
+                              offset) != ERR_OK)) {
+                err = ERR_MEM;
+                goto out;
+            }
+            offset += snips->iol_len;
+        }
+        res = len;
+        if (remote != NULL) {
+            err = netconn_sendto(tmp, buf, &remote_addr, remote_port);
+        }
+        else {
+            err = netconn_send(tmp, buf);
+        }
     }
+out:
     switch (err) {
         case ERR_OK:
             break;
@@ -633,7 +674,9 @@ ssize_t lwip_sock_send(struct netconn *conn, const void *data, size_t len,
             res = -EINVAL;
             break;
     }
-    netbuf_delete(buf);
+    if (buf != NULL) {
+        netbuf_delete(buf);
+    }
     if (conn == NULL) {
         netconn_delete(tmp);
     }
@@ -34,11 +34,24 @@ extern "C" {
 /**
  * @brief   Length of the temporary copying buffer for receival.
  * @note    It should be as long as the maximum packet length of all the netdev you use.
+ * @note    Not used with module `lwip_netdev_zerocopy`, which receives
+ *          directly into the pbuf handed to lwIP.
  */
 #ifndef LWIP_NETDEV_BUFLEN
 #define LWIP_NETDEV_BUFLEN      (ETHERNET_MAX_LEN)
 #endif
 
+/**
+ * @brief   Maximum number of receive threads with module
+ *          `lwip_netdev_thread_per_netif`
+ *
+ * Each interface gets its own receive thread, until this number is reached.
+ * All further interfaces share the last thread.
+ */
+#ifndef LWIP_NETDEV_THREAD_NUMOF
+#define LWIP_NETDEV_THREAD_NUMOF    (2U)
+#endif
+
 /**
  * @brief   Initializes the netdev adapter.
  *
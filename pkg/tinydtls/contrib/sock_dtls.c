@@ -19,6 +19,9 @@
 #include "dtls.h"
 #include "net/sock/dtls.h"
 #include "net/credman.h"
+#ifdef SOCK_HAS_ASYNC
+#include "net/sock/async.h"
+#endif
 
 #define ENABLE_DEBUG (0)
 #include "debug.h"
@@ -135,8 +138,6 @@ static int _get_psk_info(struct dtls_context_t *ctx, const session_t *session,
                          unsigned char *result, size_t result_length)
 {
     (void)ctx;
-    (void)desc;
-    (void)desc_len;
     int ret;
     sock_dtls_session_t _session;
     sock_udp_ep_t ep;
@@ -147,7 +148,14 @@ static int _get_psk_info(struct dtls_context_t *ctx, const session_t *session,
     memcpy(&_session.dtls_session, session, sizeof(session_t));
 
     credman_credential_t credential;
-    ret = credman_get(&credential, sock->tag, CREDMAN_TYPE_PSK);
+    if ((type == DTLS_PSK_KEY) && (desc_len > 0)) {
+        /* the identity of the client, or the own one chosen before */
+        ret = credman_get_psk(&credential, sock->tag, desc, desc_len);
+    }
+    else {
+        /* for the identity, desc is the hint of the server */
+        ret = credman_get(&credential, sock->tag, CREDMAN_TYPE_PSK);
+    }
     if (ret < 0) {
         DEBUG("sock_dtls: no matching PSK credential found\n");
         return dtls_alert_fatal_create(DTLS_ALERT_DECRYPT_ERROR);
@@ -257,6 +265,9 @@ int sock_dtls_create(sock_dtls_t *sock, sock_udp_t *udp_sock,
     sock->buf = NULL;
     sock->role = role;
     sock->tag = tag;
+#ifdef SOCK_HAS_ASYNC
+    sock->async_cb = NULL;
+#endif
     sock->dtls_ctx = dtls_new_context(sock);
     if (!sock->dtls_ctx) {
         DEBUG("sock_dtls: error getting DTLS context\n");
@@ -319,6 +330,31 @@ int sock_dtls_session_create(sock_dtls_t *sock, const sock_udp_ep_t *ep,
     return 0;
 }
 
+int sock_dtls_session_init(sock_dtls_t *sock, const sock_udp_ep_t *ep,
+                           sock_dtls_session_t *remote)
+{
+    assert(sock);
+    assert(ep);
+    assert(remote);
+
+    memcpy(&remote->ep, ep, sizeof(sock_udp_ep_t));
+    _ep_to_session(ep, &remote->dtls_session);
+
+    /* dtls_connect() also returns 0 for a peer still in its handshake */
+    dtls_peer_t *peer = dtls_get_peer(sock->dtls_ctx, &remote->dtls_session);
+    if (peer) {
+        return (peer->state == DTLS_STATE_CONNECTED) ? 0 : 1;
+    }
+
+    /* sends the ClientHello, sock_dtls_recv() handles the rest */
+    int res = dtls_connect(sock->dtls_ctx, &remote->dtls_session);
+    if (res < 0) {
+        DEBUG("sock_dtls: error initiating handshake: %d\n", res);
+        return -ENOMEM;
+    }
+    return (res > 0) ? 1 : 0;
+}
+
 void sock_dtls_session_destroy(sock_dtls_t *sock, sock_dtls_session_t *remote)
 {
     dtls_close(sock->dtls_ctx, &remote->dtls_session);
@@ -405,6 +441,16 @@ ssize_t sock_dtls_recv(sock_dtls_t *sock, sock_dtls_session_t *remote,
         res = dtls_handle_message(sock->dtls_ctx, &remote->dtls_session,
                                   (uint8_t *)data, res);
 
+        /* drain events, a session created with sock_dtls_session_init()
+         * completes here */
+        msg_t msg;
+        bool connected = false;
+        while (mbox_try_get(&sock->mbox, &msg)) {
+            if (msg.type == DTLS_EVENT_CONNECTED) {
+                connected = true;
+            }
+        }
+
         if ((timeout != SOCK_NO_TIMEOUT) && (timeout != 0)) {
             uint32_t time_passed = (xtimer_now_usec() - start_recv);
             timeout = (time_passed > timeout) ? 0: timeout - time_passed;
@@ -413,6 +459,9 @@ ssize_t sock_dtls_recv(sock_dtls_t *sock, sock_dtls_session_t *remote,
         if (sock->buf != NULL) {
             return _copy_buffer(sock, data, max_len);
         }
+        else if (connected) {
+            return -SOCK_DTLS_HANDSHAKE;
+        }
         else if (timeout == 0) {
             DEBUG("sock_dtls: timed out while decrypting message\n");
             return -ETIMEDOUT;
@@ -426,6 +475,33 @@ void sock_dtls_close(sock_dtls_t *sock)
     dtls_free_context(sock->dtls_ctx);
 }
 
+#ifdef SOCK_HAS_ASYNC
+static void _udp_cb(sock_udp_t *udp_sock, sock_async_flags_t type, void *arg)
+{
+    sock_dtls_t *sock = arg;
+
+    (void)udp_sock;
+    if (sock->async_cb) {
+        /* records are only decrypted in sock_dtls_recv() */
+        sock->async_cb(sock, type, sock->async_cb_arg);
+    }
+}
+
+void sock_dtls_set_cb(sock_dtls_t *sock, sock_dtls_cb_t cb, void *cb_arg)
+{
+    sock->async_cb = cb;
+    sock->async_cb_arg = cb_arg;
+    sock_udp_set_cb(sock->udp_sock, (cb) ? _udp_cb : NULL, sock);
+}
+
+#ifdef SOCK_HAS_ASYNC_CTX
+sock_async_ctx_t *sock_dtls_get_async_ctx(sock_dtls_t *sock)
+{
+    return &sock->async_ctx;
+}
+#endif
+#endif /* SOCK_HAS_ASYNC */
+
 void sock_dtls_init(void)
 {
     dtls_init();
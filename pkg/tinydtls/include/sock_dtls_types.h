@@ -22,6 +22,9 @@
 #include "dtls.h"
 #include "net/sock/udp.h"
 #include "net/credman.h"
+#ifdef SOCK_HAS_ASYNC
+#include "net/sock/async/types.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -47,6 +50,14 @@ struct sock_dtls {
     credman_tag_t tag;                      /**< Credential tag of a registered
                                                 (D)TLS credential */
     dtls_peer_type role;                    /**< DTLS role of the socket */
+#if defined(SOCK_HAS_ASYNC) || defined(DOXYGEN)
+    sock_dtls_cb_t async_cb;                /**< asynchronous event callback */
+    void *async_cb_arg;                     /**< asynchronous callback
+                                                argument */
+#if defined(SOCK_HAS_ASYNC_CTX) || defined(DOXYGEN)
+    sock_async_ctx_t async_ctx;             /**< asynchronous event context */
+#endif
+#endif
 };
 
 /**
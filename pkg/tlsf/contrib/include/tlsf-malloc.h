@@ -23,6 +23,38 @@
  * control block should be initialized as the first thing before the stdlib is
  * used. Boards should use tlsf_add_global_pool() at startup to add all the memory
  * regions they want to make available for dynamic allocation via malloc().
+ * If no pool was added when the first allocation takes place, the default heap
+ * of the platform is used: the linker provided heap for newlib with the
+ * default or the fe310 syscalls, a static buffer of
+ * @ref CONFIG_TLSF_MALLOC_NATIVE_HEAP_SIZE bytes on native. Other platforms
+ * have to add a pool.
+ *
+ * Arenas
+ * ------
+ *
+ * Besides the global heap, further TLSF heaps (arenas) can be created from
+ * dedicated memory regions using tlsf_arena_init(), e.g. to keep a module with
+ * a lot of short-lived allocations from fragmenting the global heap.
+ * Allocations are done explicitly with tlsf_arena_malloc() or, with the
+ * `tlsf-malloc_thread_arena` module, implicitly by binding a thread to an
+ * arena using tlsf_arena_bind_thread(): all malloc() calls of that thread are
+ * then served from the arena. free() and realloc() always return memory to
+ * the arena it was allocated from, regardless of the calling thread. The
+ * binding ends when the thread exits.
+ *
+ * Every arena keeps track of its used bytes, high-water mark and allocation
+ * counters. Together with the fragmentation of its free space these are
+ * printed by the `heap` shell command and by `ps`.
+ *
+ * Fast path
+ * ---------
+ *
+ * With the `tlsf-malloc_fast` module, every arena keeps a small cache of free
+ * blocks for @ref CONFIG_TLSF_MALLOC_FAST_CLASSES size classes, starting at
+ * @ref CONFIG_TLSF_MALLOC_FAST_MIN_SIZE bytes and doubling with every class.
+ * Allocations and deallocations that can be served from that cache use atomic
+ * operations only and neither disable interrupts nor enter TLSF. Requests
+ * fitting a size class are rounded up to the class size.
  *
  * @{
  * @file
@@ -37,13 +69,90 @@
 #define TLSF_MALLOC_H
 
 #include <stddef.h>
+#include <stdint.h>
 
+#include "kernel_types.h"
 #include "tlsf.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @defgroup pkg_tlsf_malloc_config TLSF-based malloc compile configurations
+ * @ingroup  config
+ * @{
+ */
+/**
+ * @brief   Size of the default heap on native
+ */
+#ifndef CONFIG_TLSF_MALLOC_NATIVE_HEAP_SIZE
+#define CONFIG_TLSF_MALLOC_NATIVE_HEAP_SIZE     (256U * 1024U)
+#endif
+
+/**
+ * @brief   Number of size classes cached by the `tlsf-malloc_fast` module
+ */
+#ifndef CONFIG_TLSF_MALLOC_FAST_CLASSES
+#define CONFIG_TLSF_MALLOC_FAST_CLASSES         (3U)
+#endif
+
+/**
+ * @brief   Block size of the smallest class of the `tlsf-malloc_fast` module
+ *
+ * Must be a power of two.
+ */
+#ifndef CONFIG_TLSF_MALLOC_FAST_MIN_SIZE
+#define CONFIG_TLSF_MALLOC_FAST_MIN_SIZE        (16U)
+#endif
+
+/**
+ * @brief   Number of free blocks cached per size class
+ */
+#ifndef CONFIG_TLSF_MALLOC_FAST_DEPTH
+#define CONFIG_TLSF_MALLOC_FAST_DEPTH           (4U)
+#endif
+/** @} */
+
+/**
+ * @brief   Usage statistics of an arena
+ */
+typedef struct {
+    size_t size;            /**< bytes available for allocations */
+    size_t used;            /**< bytes in allocated blocks, including
+                             *   blocks cached by the fast path */
+    size_t max_used;        /**< high-water mark of tlsf_arena_stats_t::used */
+    size_t free_max;        /**< largest free block */
+    uint32_t allocs;        /**< number of successful allocations */
+    uint32_t frees;         /**< number of deallocations */
+    uint32_t failed;        /**< number of failed allocations */
+} tlsf_arena_stats_t;
+
+/**
+ * @brief   TLSF arena
+ *
+ * @note    All members are private, use the functions below.
+ */
+typedef struct tlsf_arena {
+    struct tlsf_arena *next;    /**< next registered arena */
+    const char *name;           /**< name of the arena */
+    tlsf_t tlsf;                /**< TLSF control block */
+    uintptr_t start;            /**< start of the arena's memory region */
+    uintptr_t end;              /**< end of the arena's memory region */
+    struct tlsf_pool_hdr *pools;    /**< further pools of the heap */
+    size_t used;                /**< bytes in allocated blocks */
+    size_t max_used;            /**< high-water mark of used */
+    uint32_t allocs;            /**< number of successful allocations */
+    uint32_t frees;             /**< number of deallocations */
+    uint32_t failed;            /**< number of failed allocations */
+#if defined(MODULE_TLSF_MALLOC_FAST) || defined(DOXYGEN)
+    /**
+     * @brief   Cached free blocks per size class, NULL if a slot is empty
+     */
+    void *fast[CONFIG_TLSF_MALLOC_FAST_CLASSES][CONFIG_TLSF_MALLOC_FAST_DEPTH];
+#endif
+} tlsf_arena_t;
+
 /**
  * @brief Struct to hold the total sizes of free and used blocks
  * Used for @ref tlsf_size_walker()
@@ -70,7 +179,8 @@ void tlsf_size_walker(void* ptr, size_t size, int used, void* user);
  * Add an area of memory to the global allocator pool.
  *
  * The first time this function is called, it will automatically perform a
- * tlsf_create() on the global tlsf_control block.
+ * tlsf_create() on the global tlsf_control block. Later pools lose a few
+ * bytes at their start to a header linking them for the statistics.
  *
  * @warning If this module is used, then this function MUST be called at least
  *          once, before any allocations take place.
@@ -89,6 +199,116 @@ int tlsf_add_global_pool(void *mem, size_t bytes);
  */
 tlsf_t _tlsf_get_global_control(void);
 
+/**
+ * @brief   Create an arena from a memory region and register it
+ *
+ * @param[out]  arena   arena to initialize
+ * @param[in]   name    name of the arena, shown in the statistics
+ * @param[in]   mem     memory region to use, should be aligned to 4 bytes
+ * @param[in]   bytes   size of @p mem in bytes
+ *
+ * @return  0 on success
+ * @return  -EINVAL if @p mem is too small to hold a TLSF heap
+ */
+int tlsf_arena_init(tlsf_arena_t *arena, const char *name, void *mem,
+                    size_t bytes);
+
+/**
+ * @brief   Get the arena of the global heap
+ */
+tlsf_arena_t *tlsf_arena_global(void);
+
+/**
+ * @brief   Iterate over all registered arenas, starting with the global heap
+ *
+ * @param[in]   prev    previous arena or NULL to get the first one
+ *
+ * @return  the arena following @p prev, NULL when done
+ */
+tlsf_arena_t *tlsf_arena_iter(const tlsf_arena_t *prev);
+
+/**
+ * @brief   Get the arena a block was allocated from
+ *
+ * @param[in]   ptr     block returned by one of the allocation functions
+ *
+ * @return  the arena @p ptr belongs to
+ */
+tlsf_arena_t *tlsf_arena_find(const void *ptr);
+
+/**
+ * @brief   Allocate memory from an arena
+ *
+ * @param[in]   arena   arena to allocate from
+ * @param[in]   bytes   number of bytes to allocate
+ *
+ * @return  pointer to the allocated memory, NULL if out of memory
+ */
+void *tlsf_arena_malloc(tlsf_arena_t *arena, size_t bytes);
+
+/**
+ * @brief   Allocate aligned memory from an arena
+ *
+ * @param[in]   arena   arena to allocate from
+ * @param[in]   align   alignment, must be a power of two
+ * @param[in]   bytes   number of bytes to allocate
+ *
+ * @return  pointer to the allocated memory, NULL if out of memory
+ */
+void *tlsf_arena_memalign(tlsf_arena_t *arena, size_t align, size_t bytes);
+
+/**
+ * @brief   Resize a block within the arena it was allocated from
+ *
+ * @param[in]   arena   arena to allocate from if @p ptr is NULL
+ * @param[in]   ptr     block to resize, may be NULL
+ * @param[in]   bytes   new size in bytes
+ *
+ * @return  pointer to the resized block, NULL if out of memory
+ */
+void *tlsf_arena_realloc(tlsf_arena_t *arena, void *ptr, size_t bytes);
+
+/**
+ * @brief   Return a block to the arena it was allocated from
+ *
+ * @param[in]   ptr     block to free, may be NULL
+ */
+void tlsf_arena_free(void *ptr);
+
+/**
+ * @brief   Get the usage statistics of an arena
+ *
+ * @note    This walks all blocks of the arena with interrupts disabled to
+ *          determine tlsf_arena_stats_t::free_max, so it runs in O(n).
+ *
+ * @param[in]   arena   arena to get statistics for
+ * @param[out]  stats   statistics of @p arena
+ */
+void tlsf_arena_get_stats(tlsf_arena_t *arena, tlsf_arena_stats_t *stats);
+
+/**
+ * @brief   Print the usage statistics of all arenas
+ */
+void tlsf_arena_print_stats(void);
+
+#if defined(MODULE_TLSF_MALLOC_THREAD_ARENA) || defined(DOXYGEN)
+/**
+ * @brief   Serve all allocations of a thread from an arena
+ *
+ * @param[in]   pid     thread to bind
+ * @param[in]   arena   arena to use, NULL to use the global heap again
+ */
+void tlsf_arena_bind_thread(kernel_pid_t pid, tlsf_arena_t *arena);
+#endif
+
+/**
+ * @brief   Get the arena used by malloc() in the current context
+ *
+ * This is the arena bound to the running thread, or the global heap when
+ * called from interrupt context or if no arena was bound.
+ */
+tlsf_arena_t *tlsf_arena_current(void);
+
 
 #ifdef __cplusplus
 }
@@ -23,7 +23,6 @@
 #include <string.h>
 #include <errno.h>
 
-#include "irq.h"
 #include "tlsf.h"
 #include "tlsf-malloc.h"
 #include "tlsf-malloc-internal.h"
@@ -47,21 +46,27 @@
 
 #endif /* __GNUC__ */
 
-extern tlsf_t tlsf_malloc_gheap;
+static uint32_t _heap[CONFIG_TLSF_MALLOC_NATIVE_HEAP_SIZE / sizeof(uint32_t)];
+
+/**
+ * Use a static buffer if the application did not add pools
+ */
+void tlsf_malloc_add_default_pool(void)
+{
+    tlsf_add_global_pool(_heap, sizeof(_heap));
+}
 
 /**
  * Allocate a block of size "bytes"
  */
 ATTR_MALLOC void *malloc(size_t bytes)
 {
-    unsigned old_state = irq_disable();
-    void *result = tlsf_malloc(tlsf_malloc_gheap, bytes);
+    void *result = tlsf_arena_malloc(tlsf_arena_current(), bytes);
 
     if (result == NULL) {
         errno = ENOMEM;
     }
 
-    irq_restore(old_state);
     return result;
 }
 
@@ -83,14 +88,12 @@ ATTR_CALLOC void *calloc(size_t count, size_t bytes)
  */
 ATTR_MALIGN void *memalign(size_t align, size_t bytes)
 {
-    unsigned old_state = irq_disable();
-    void *result = tlsf_memalign(tlsf_malloc_gheap, align, bytes);
+    void *result = tlsf_arena_memalign(tlsf_arena_current(), align, bytes);
 
     if (result == NULL) {
         errno = ENOMEM;
     }
 
-    irq_restore(old_state);
     return result;
 }
 
@@ -99,14 +102,12 @@ ATTR_MALIGN void *memalign(size_t align, size_t bytes)
  */
 ATTR_REALLOC void *realloc(void *ptr, size_t size)
 {
-    unsigned old_state = irq_disable();
-    void *result = tlsf_realloc(tlsf_malloc_gheap, ptr, size);
+    void *result = tlsf_arena_realloc(tlsf_arena_current(), ptr, size);
 
-    if (result == NULL) {
+    if ((result == NULL) && (size != 0)) {
         errno = ENOMEM;
     }
 
-    irq_restore(old_state);
     return result;
 }
 
@@ -116,8 +117,5 @@ ATTR_REALLOC void *realloc(void *ptr, size_t size)
  */
 void free(void *ptr)
 {
-    unsigned old_state = irq_disable();
-
-    tlsf_free(tlsf_malloc_gheap, ptr);
-    irq_restore(old_state);
+    tlsf_arena_free(ptr);
 }
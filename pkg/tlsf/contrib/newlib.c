@@ -25,11 +25,23 @@
 #include <reent.h>
 #include <errno.h>
 
-#include "irq.h"
 #include "tlsf.h"
 #include "tlsf-malloc.h"
 #include "tlsf-malloc-internal.h"
 
+/* The heap bounds are named differently by the linker scripts, use those of
+ * the syscalls implementation that would otherwise manage the heap */
+#if defined(MODULE_NEWLIB_SYSCALLS_DEFAULT)
+extern char _sheap;                 /* start of the heap */
+extern char _eheap;                 /* end of the heap */
+#define HEAP_START      (&_sheap)
+#define HEAP_END        (&_eheap)
+#elif defined(MODULE_NEWLIB_SYSCALLS_FE310)
+extern char _heap_start;            /* start of the heap */
+extern char _heap_end;              /* end of the heap */
+#define HEAP_START      (&_heap_start)
+#define HEAP_END        (&_heap_end)
+#endif
 
 /* TODO: Add defines for other compilers */
 #if defined(__GNUC__) && !defined(__clang__)    /* Clang supports __GNUC__ but
@@ -50,19 +62,29 @@
 
 #endif /* __GNUC__ */
 
+#ifdef HEAP_START
+/**
+ * Use the heap provided by the linker script if the board did not add pools
+ *
+ * Other platforms keep the empty default, their boards have to add pools.
+ */
+void tlsf_malloc_add_default_pool(void)
+{
+    tlsf_add_global_pool(HEAP_START, HEAP_END - HEAP_START);
+}
+#endif
+
 /**
  * Allocate a block of size "bytes"
  */
 ATTR_MALLOCR void *_malloc_r(struct _reent *reent_ptr, size_t bytes)
 {
-    unsigned old_state = irq_disable();
-    void *result = tlsf_malloc(tlsf_malloc_gheap, bytes);
+    void *result = tlsf_arena_malloc(tlsf_arena_current(), bytes);
 
     if (result == NULL) {
         reent_ptr->_errno = ENOMEM;
     }
 
-    irq_restore(old_state);
     return result;
 }
 
@@ -84,14 +106,12 @@ ATTR_CALLOCR void *_calloc_r(struct _reent *reent_ptr, size_t count, size_t byte
  */
 ATTR_MALIGNR void *_memalign_r(struct _reent *reent_ptr, size_t align, size_t bytes)
 {
-    unsigned old_state = irq_disable();
-    void *result = tlsf_memalign(tlsf_malloc_gheap, align, bytes);
+    void *result = tlsf_arena_memalign(tlsf_arena_current(), align, bytes);
 
     if (result == NULL) {
         reent_ptr->_errno = ENOMEM;
     }
 
-    irq_restore(old_state);
     return result;
 }
 
@@ -100,14 +120,12 @@ ATTR_MALIGNR void *_memalign_r(struct _reent *reent_ptr, size_t align, size_t by
  */
 ATTR_REALLOCR void *_realloc_r(struct _reent *reent_ptr, void *ptr, size_t size)
 {
-    unsigned old_state = irq_disable();
-    void *result = tlsf_realloc(tlsf_malloc_gheap, ptr, size);
+    void *result = tlsf_arena_realloc(tlsf_arena_current(), ptr, size);
 
-    if (result == NULL) {
+    if ((result == NULL) && (size != 0)) {
         reent_ptr->_errno = ENOMEM;
     }
 
-    irq_restore(old_state);
     return result;
 }
 
@@ -116,11 +134,9 @@ ATTR_REALLOCR void *_realloc_r(struct _reent *reent_ptr, void *ptr, size_t size)
  */
 void _free_r(struct _reent *reent_ptr, void *ptr)
 {
-    unsigned old_state = irq_disable();
     (void)reent_ptr;
 
-    tlsf_free(tlsf_malloc_gheap, ptr);
-    irq_restore(old_state);
+    tlsf_arena_free(ptr);
 }
 
 /**
@@ -25,7 +25,14 @@
 extern "C" {
 #endif
 
-extern tlsf_t tlsf_malloc_gheap;
+/**
+ * @brief   Add the default heap of the platform to the global heap
+ *
+ * Called on the first allocation if no pool was added using
+ * tlsf_add_global_pool() before. Implemented by the platform specific
+ * malloc backend, the default implementation does nothing.
+ */
+void tlsf_malloc_add_default_pool(void);
 
 #ifdef __cplusplus
 }
@@ -17,31 +17,85 @@
  *
  */
 
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
 #include <stdio.h>
 
+#include "irq.h"
+#include "sched.h"
+#include "thread.h"
 #include "tlsf.h"
 #include "tlsf-malloc.h"
 #include "tlsf-malloc-internal.h"
 
 /**
  * Global memory heap (really a collection of pools, or areas)
+ *
+ * Always the head of the list of registered arenas.
  **/
-tlsf_t tlsf_malloc_gheap = NULL;
+static tlsf_arena_t _global = { .name = "global" };
+
+#ifdef MODULE_TLSF_MALLOC_THREAD_ARENA
+static tlsf_arena_t *_thread_arenas[KERNEL_PID_LAST + 1];
+#endif
+
+#ifdef MODULE_TLSF_MALLOC_FAST
+#define FAST_MAX_SIZE   (CONFIG_TLSF_MALLOC_FAST_MIN_SIZE << \
+                         (CONFIG_TLSF_MALLOC_FAST_CLASSES - 1))
+#endif
+
+/**
+ * Header in front of every pool added to an existing heap
+ *
+ * TLSF only knows the first pool of a heap, the others are linked here so that
+ * tlsf_arena_get_stats() can walk them.
+ */
+struct tlsf_pool_hdr {
+    struct tlsf_pool_hdr *next;
+};
+
+__attribute__((weak)) void tlsf_malloc_add_default_pool(void)
+{
+}
+
+/* keeps the pool behind the header aligned */
+static size_t _pool_hdr_size(void)
+{
+    size_t align = tlsf_align_size();
+
+    return (sizeof(struct tlsf_pool_hdr) + align - 1) & ~(align - 1);
+}
+
+static void *_pool_of(struct tlsf_pool_hdr *hdr)
+{
+    return (uint8_t *)hdr + _pool_hdr_size();
+}
 
 int tlsf_add_global_pool(void *mem, size_t bytes)
 {
-    if (tlsf_malloc_gheap == NULL) {
-        tlsf_malloc_gheap = tlsf_create_with_pool(mem, bytes);
-        return tlsf_malloc_gheap == NULL;
+    if (_global.tlsf == NULL) {
+        _global.tlsf = tlsf_create_with_pool(mem, bytes);
+        return _global.tlsf == NULL;
     }
-    else {
-        return tlsf_add_pool(tlsf_malloc_gheap, mem, bytes) == NULL;
+
+    struct tlsf_pool_hdr *hdr = mem;
+    if ((bytes <= _pool_hdr_size()) ||
+        (tlsf_add_pool(_global.tlsf, _pool_of(hdr),
+                       bytes - _pool_hdr_size()) == NULL)) {
+        return 1;
     }
+    unsigned state = irq_disable();
+    hdr->next = _global.pools;
+    _global.pools = hdr;
+    irq_restore(state);
+    return 0;
 }
 
 tlsf_t _tlsf_get_global_control(void)
 {
-    return tlsf_malloc_gheap;
+    return _global.tlsf;
 }
 
 void tlsf_size_walker(void* ptr, size_t size, int used, void* user)
@@ -56,6 +110,299 @@ void tlsf_size_walker(void* ptr, size_t size, int used, void* user)
     }
 }
 
+int tlsf_arena_init(tlsf_arena_t *arena, const char *name, void *mem,
+                    size_t bytes)
+{
+    *arena = (tlsf_arena_t){ .name = name };
+    arena->tlsf = tlsf_create_with_pool(mem, bytes);
+    if (arena->tlsf == NULL) {
+        return -EINVAL;
+    }
+    arena->start = (uintptr_t)mem;
+    arena->end = (uintptr_t)mem + bytes;
+
+    unsigned state = irq_disable();
+    arena->next = _global.next;
+    _global.next = arena;
+    irq_restore(state);
+    return 0;
+}
+
+tlsf_arena_t *tlsf_arena_global(void)
+{
+    return &_global;
+}
+
+tlsf_arena_t *tlsf_arena_iter(const tlsf_arena_t *prev)
+{
+    return (prev == NULL) ? &_global : prev->next;
+}
+
+tlsf_arena_t *tlsf_arena_find(const void *ptr)
+{
+    /* the global heap may consist of several pools, so it is the fallback for
+     * everything not within any of the other arenas */
+    for (tlsf_arena_t *arena = _global.next; arena; arena = arena->next) {
+        if (((uintptr_t)ptr >= arena->start) && ((uintptr_t)ptr < arena->end)) {
+            return arena;
+        }
+    }
+    return &_global;
+}
+
+#ifdef MODULE_TLSF_MALLOC_THREAD_ARENA
+void tlsf_arena_bind_thread(kernel_pid_t pid, tlsf_arena_t *arena)
+{
+    assert(pid_is_valid(pid));
+    _thread_arenas[pid] = arena;
+}
+
+void sched_thread_exit_hook(kernel_pid_t pid)
+{
+    /* the next thread with this PID must not inherit the arena */
+    _thread_arenas[pid] = NULL;
+}
+#endif
+
+tlsf_arena_t *tlsf_arena_current(void)
+{
+#ifdef MODULE_TLSF_MALLOC_THREAD_ARENA
+    if (!irq_is_in()) {
+        tlsf_arena_t *arena = _thread_arenas[thread_getpid()];
+
+        if (arena) {
+            return arena;
+        }
+    }
+#endif
+    return &_global;
+}
+
+static inline void _count(uint32_t *counter)
+{
+    __atomic_fetch_add(counter, 1, __ATOMIC_RELAXED);
+}
+
+#ifdef MODULE_TLSF_MALLOC_FAST
+static void *_fast_pop(tlsf_arena_t *arena, size_t bytes)
+{
+    unsigned cls = 0;
+
+    for (size_t size = CONFIG_TLSF_MALLOC_FAST_MIN_SIZE; size < bytes;
+         size <<= 1) {
+        cls++;
+    }
+    for (unsigned i = 0; i < CONFIG_TLSF_MALLOC_FAST_DEPTH; i++) {
+        void **slot = &arena->fast[cls][i];
+
+        if (__atomic_load_n(slot, __ATOMIC_RELAXED) != NULL) {
+            /* exchange hands over the block exclusively, so there is no ABA
+             * problem even if the slot was refilled in the meantime */
+            void *ptr = __atomic_exchange_n(slot, NULL, __ATOMIC_ACQUIRE);
+            if (ptr != NULL) {
+                return ptr;
+            }
+        }
+    }
+    return NULL;
+}
+
+static bool _fast_push(tlsf_arena_t *arena, void *ptr)
+{
+    size_t bsize = tlsf_block_size(ptr);
+
+    if ((bsize < CONFIG_TLSF_MALLOC_FAST_MIN_SIZE) ||
+        (bsize >= (2 * FAST_MAX_SIZE))) {
+        return false;
+    }
+
+    /* a block serves all requests up to the largest class size it covers */
+    unsigned cls = 0;
+    for (size_t size = CONFIG_TLSF_MALLOC_FAST_MIN_SIZE << 1;
+         (size <= bsize) && (cls < (CONFIG_TLSF_MALLOC_FAST_CLASSES - 1));
+         size <<= 1) {
+        cls++;
+    }
+    for (unsigned i = 0; i < CONFIG_TLSF_MALLOC_FAST_DEPTH; i++) {
+        void *expected = NULL;
+
+        if (__atomic_compare_exchange_n(&arena->fast[cls][i], &expected, ptr,
+                                        false, __ATOMIC_RELEASE,
+                                        __ATOMIC_RELAXED)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static size_t _fast_size(size_t bytes)
+{
+    size_t size = CONFIG_TLSF_MALLOC_FAST_MIN_SIZE;
+
+    while (size < bytes) {
+        size <<= 1;
+    }
+    return size;
+}
+#endif /* MODULE_TLSF_MALLOC_FAST */
+
+static void _add_used(tlsf_arena_t *arena, void *ptr)
+{
+    arena->used += tlsf_block_size(ptr);
+    if (arena->used > arena->max_used) {
+        arena->max_used = arena->used;
+    }
+}
+
+void *tlsf_arena_memalign(tlsf_arena_t *arena, size_t align, size_t bytes)
+{
+    unsigned state = irq_disable();
+
+    if ((arena == &_global) && (_global.tlsf == NULL)) {
+        tlsf_malloc_add_default_pool();
+    }
+
+    void *ptr = NULL;
+    if (arena->tlsf != NULL) {
+        ptr = (align) ? tlsf_memalign(arena->tlsf, align, bytes)
+                      : tlsf_malloc(arena->tlsf, bytes);
+    }
+    if (ptr != NULL) {
+        _add_used(arena, ptr);
+    }
+    irq_restore(state);
+
+    _count((ptr) ? &arena->allocs : &arena->failed);
+    return ptr;
+}
+
+void *tlsf_arena_malloc(tlsf_arena_t *arena, size_t bytes)
+{
+#ifdef MODULE_TLSF_MALLOC_FAST
+    if (bytes <= FAST_MAX_SIZE) {
+        void *ptr = _fast_pop(arena, bytes);
+
+        if (ptr != NULL) {
+            _count(&arena->allocs);
+            return ptr;
+        }
+        /* round up, so the block can be cached when freed */
+        bytes = _fast_size(bytes);
+    }
+#endif
+    return tlsf_arena_memalign(arena, 0, bytes);
+}
+
+void *tlsf_arena_realloc(tlsf_arena_t *arena, void *ptr, size_t bytes)
+{
+    if (ptr == NULL) {
+        return tlsf_arena_malloc(arena, bytes);
+    }
+
+    arena = tlsf_arena_find(ptr);
+
+    unsigned state = irq_disable();
+    size_t old_size = tlsf_block_size(ptr);
+    void *res = tlsf_realloc(arena->tlsf, ptr, bytes);
+
+    if (res != NULL) {
+        arena->used -= old_size;
+        _add_used(arena, res);
+    }
+    else if (bytes == 0) {
+        /* TLSF frees the block in that case */
+        arena->used -= old_size;
+    }
+    irq_restore(state);
+
+    if (res == NULL) {
+        _count((bytes == 0) ? &arena->frees : &arena->failed);
+    }
+    return res;
+}
+
+void tlsf_arena_free(void *ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+
+    tlsf_arena_t *arena = tlsf_arena_find(ptr);
+
+    _count(&arena->frees);
+#ifdef MODULE_TLSF_MALLOC_FAST
+    if (_fast_push(arena, ptr)) {
+        return;
+    }
+#endif
+
+    unsigned state = irq_disable();
+    arena->used -= tlsf_block_size(ptr);
+    tlsf_free(arena->tlsf, ptr);
+    irq_restore(state);
+}
+
+static void _stats_walker(void *ptr, size_t size, int used, void *user)
+{
+    tlsf_arena_stats_t *stats = user;
+
+    (void)ptr;
+    stats->size += size;
+    if (!used && (size > stats->free_max)) {
+        stats->free_max = size;
+    }
+}
+
+void tlsf_arena_get_stats(tlsf_arena_t *arena, tlsf_arena_stats_t *stats)
+{
+    *stats = (tlsf_arena_stats_t){ 0 };
+
+    unsigned state = irq_disable();
+    if (arena->tlsf != NULL) {
+        tlsf_walk_pool(tlsf_get_pool(arena->tlsf), _stats_walker, stats);
+        for (struct tlsf_pool_hdr *hdr = arena->pools; hdr; hdr = hdr->next) {
+            tlsf_walk_pool(_pool_of(hdr), _stats_walker, stats);
+        }
+    }
+    stats->used = arena->used;
+    stats->max_used = arena->max_used;
+    irq_restore(state);
+
+    stats->allocs = __atomic_load_n(&arena->allocs, __ATOMIC_RELAXED);
+    stats->frees = __atomic_load_n(&arena->frees, __ATOMIC_RELAXED);
+    stats->failed = __atomic_load_n(&arena->failed, __ATOMIC_RELAXED);
+}
+
+void tlsf_arena_print_stats(void)
+{
+    printf("\t%-12s %8s %8s %8s %8s %5s %8s %8s %6s\n", "arena", "size",
+           "used", "max used", "free max", "frag", "allocs", "frees",
+           "failed");
+    for (tlsf_arena_t *arena = tlsf_arena_iter(NULL); arena;
+         arena = tlsf_arena_iter(arena)) {
+        tlsf_arena_stats_t stats;
+        unsigned frag = 0;
+
+        tlsf_arena_get_stats(arena, &stats);
+        /* share of free memory not usable for an allocation of the size of
+         * all free memory */
+        if (stats.size > stats.used) {
+            frag = 100 - (unsigned)((stats.free_max * 100) /
+                                    (stats.size - stats.used));
+        }
+        printf("\t%-12s %8u %8u %8u %8u %4u%% %8" PRIu32 " %8" PRIu32
+               " %6" PRIu32 "\n", arena->name, (unsigned)stats.size,
+               (unsigned)stats.used, (unsigned)stats.max_used,
+               (unsigned)stats.free_max, frag, stats.allocs, stats.frees,
+               stats.failed);
+    }
+}
+
+void heap_stats(void)
+{
+    tlsf_arena_print_stats();
+}
+
 /**
  * @}
  */
@@ -18,19 +18,275 @@
  * @}
  */
 
+#include <errno.h>
+#include <inttypes.h>
 #include <stdio.h>
 
 #include "benchmark.h"
+#include "matstat.h"
+
+#if defined(CPU_NATIVE) && !defined(BENCHMARK_CLOCK_CYCLES)
+#include <time.h>
+#include "native_internal.h"
+#endif
+
+#ifndef RIOT_BOARD
+#define RIOT_BOARD      "unknown"
+#endif
+
+#ifndef RIOT_VERSION
+#define RIOT_VERSION    "unknown"
+#endif
+
+/* "4294967295.000" */
+#define PER_CALL_LEN    (15U)
+
+static benchmark_t *_benchmarks;
+static uint32_t _samples[CONFIG_BENCHMARK_SAMPLES_MAX];
 
 void benchmark_print_time(uint32_t time, unsigned long runs, const char *name)
 {
-    uint32_t full = (time / runs);
-    uint32_t div  = (time - (full * runs)) / (runs / 1000);
-
-    uint32_t per_sec = (uint32_t)(((uint64_t)1000000UL * runs) / time);
+    /* in ns, so that calls shorter than a microsecond are not rounded away */
+    uint64_t per_call = ((uint64_t)time * 1000) / runs;
+    uint32_t per_sec = (time) ? (uint32_t)(((uint64_t)1000000UL * runs) / time)
+                              : UINT32_MAX;
 
     printf("%25s: %9" PRIu32 "us"
            "  ---  %2" PRIu32 ".%03" PRIu32 "us per call"
            "  ---  %9" PRIu32 " calls per sec\n",
-           name, time, full, div, per_sec);
+           name, time, (uint32_t)(per_call / 1000),
+           (uint32_t)(per_call % 1000), per_sec);
+}
+
+#if defined(CPU_NATIVE) && !defined(BENCHMARK_CLOCK_CYCLES)
+uint32_t benchmark_clock_now(void)
+{
+    struct timespec t;
+
+    real_clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint32_t)((uint64_t)t.tv_sec * 1000000000LU + t.tv_nsec);
+}
+#endif
+
+void benchmark_clock_init(void)
+{
+#if !defined(CPU_NATIVE) && defined(DWT_CTRL_CYCCNTENA_Msk)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+static void _nop(void *arg)
+{
+    (void)arg;
+}
+
+static uint32_t _sample(void (*func)(void *), void *arg, uint32_t runs,
+                        uint8_t flags)
+{
+    unsigned state = 0;
+
+    if (!(flags & BENCHMARK_FLAG_IRQ)) {
+        state = irq_disable();
+    }
+    uint32_t start = benchmark_clock_now();
+    for (uint32_t i = 0; i < runs; i++) {
+        func(arg);
+    }
+    uint32_t time = benchmark_clock_now() - start;
+    if (!(flags & BENCHMARK_FLAG_IRQ)) {
+        irq_restore(state);
+    }
+    return time;
+}
+
+static void _sort(uint32_t *values, unsigned num)
+{
+    /* insertion sort, the number of samples is small */
+    for (unsigned i = 1; i < num; i++) {
+        uint32_t tmp = values[i];
+        unsigned j = i;
+
+        for (; (j > 0) && (values[j - 1] > tmp); j--) {
+            values[j] = values[j - 1];
+        }
+        values[j] = tmp;
+    }
+}
+
+static uint32_t _percentile(const uint32_t *sorted, unsigned num, unsigned p)
+{
+    /* nearest rank method */
+    unsigned rank = ((p * num) + 99) / 100;
+
+    return sorted[(rank > 0) ? rank - 1 : 0];
+}
+
+static uint32_t _sqrt(uint64_t value)
+{
+    uint64_t res = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (value >= res + bit) {
+            value -= res + bit;
+            res = (res >> 1) + bit;
+        }
+        else {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)res;
+}
+
+int benchmark_run(benchmark_t *bench, benchmark_result_t *res)
+{
+    uint32_t runs = (bench->runs) ? bench->runs : CONFIG_BENCHMARK_RUNS;
+    unsigned num = (bench->samples) ? bench->samples
+                                    : CONFIG_BENCHMARK_SAMPLES;
+
+    if (num > CONFIG_BENCHMARK_SAMPLES_MAX) {
+        return -EINVAL;
+    }
+
+    benchmark_clock_init();
+
+    /* the cost of the loop and the indirect call is the fastest of a few
+     * samples of an empty function */
+    uint32_t overhead = UINT32_MAX;
+    for (unsigned i = 0; i < CONFIG_BENCHMARK_WARMUP + 1; i++) {
+        uint32_t time = _sample(_nop, NULL, runs, bench->flags);
+        if (time < overhead) {
+            overhead = time;
+        }
+    }
+
+    if (bench->setup) {
+        bench->setup(bench->arg);
+    }
+    for (unsigned i = 0; i < CONFIG_BENCHMARK_WARMUP; i++) {
+        _sample(bench->func, bench->arg, runs, bench->flags);
+    }
+
+    matstat_state_t stats = MATSTAT_STATE_INIT;
+    for (unsigned i = 0; i < num; i++) {
+        uint32_t time = _sample(bench->func, bench->arg, runs, bench->flags);
+
+        /* the totals are kept, dividing by runs here would truncate calls
+         * shorter than one clock unit to 0 */
+        _samples[i] = (time > overhead) ? (time - overhead) : 0;
+        matstat_add(&stats, (int32_t)_samples[i]);
+    }
+    if (bench->teardown) {
+        bench->teardown(bench->arg);
+    }
+
+    _sort(_samples, num);
+    *res = (benchmark_result_t){
+        .name = bench->name,
+        .runs = runs,
+        .samples = num,
+        .min = _samples[0],
+        .median = _percentile(_samples, num, 50),
+        .p99 = _percentile(_samples, num, 99),
+        .max = _samples[num - 1],
+        .mean = (uint32_t)matstat_mean(&stats),
+        .stddev = _sqrt(matstat_variance(&stats)),
+    };
+    return 0;
+}
+
+void benchmark_register(benchmark_t *bench)
+{
+    benchmark_t **tail = &_benchmarks;
+
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
+    bench->next = NULL;
+    *tail = bench;
+}
+
+unsigned benchmark_run_all(benchmark_output_t format)
+{
+    unsigned count = 0;
+
+    benchmark_print_header(format);
+    for (benchmark_t *bench = _benchmarks; bench; bench = bench->next) {
+        benchmark_result_t res;
+
+        if (benchmark_run(bench, &res) < 0) {
+            printf("%s: too many samples\n", bench->name);
+            continue;
+        }
+        benchmark_print_result(&res, format);
+        count++;
+    }
+    return count;
+}
+
+void benchmark_print_header(benchmark_output_t format)
+{
+    switch (format) {
+    case BENCHMARK_OUTPUT_CSV:
+        puts("name,unit,runs,samples,min,median,p99,max,mean,stddev");
+        break;
+    case BENCHMARK_OUTPUT_JSON:
+        printf("{\"riot\": \"%s\", \"board\": \"%s\", \"unit\": \"%s\"}\n",
+               RIOT_VERSION, RIOT_BOARD, BENCHMARK_CLOCK_UNIT);
+        break;
+    default:
+        printf("%25s  %12s %12s %12s %12s %12s %12s  [%s per call]\n", "",
+               "min", "median", "p99", "max", "mean", "stddev",
+               BENCHMARK_CLOCK_UNIT);
+        break;
+    }
+}
+
+/* per call time of a sample total with three decimal places */
+static char *_per_call(char *buf, uint32_t total, uint32_t runs)
+{
+    uint64_t milli = (((uint64_t)total * 1000) + (runs / 2)) / runs;
+
+    snprintf(buf, PER_CALL_LEN, "%" PRIu32 ".%03" PRIu32,
+             (uint32_t)(milli / 1000), (uint32_t)(milli % 1000));
+    return buf;
+}
+
+void benchmark_print_result(const benchmark_result_t *res,
+                            benchmark_output_t format)
+{
+    char min[PER_CALL_LEN], median[PER_CALL_LEN], p99[PER_CALL_LEN];
+    char max[PER_CALL_LEN], mean[PER_CALL_LEN], stddev[PER_CALL_LEN];
+
+    _per_call(min, res->min, res->runs);
+    _per_call(median, res->median, res->runs);
+    _per_call(p99, res->p99, res->runs);
+    _per_call(max, res->max, res->runs);
+    _per_call(mean, res->mean, res->runs);
+    _per_call(stddev, res->stddev, res->runs);
+
+    switch (format) {
+    case BENCHMARK_OUTPUT_CSV:
+        printf("\"%s\",%s,%" PRIu32 ",%" PRIu32 ",%s,%s,%s,%s,%s,%s\n",
+               res->name, BENCHMARK_CLOCK_UNIT, res->runs, res->samples,
+               min, median, p99, max, mean, stddev);
+        break;
+    case BENCHMARK_OUTPUT_JSON:
+        printf("{\"name\": \"%s\", \"runs\": %" PRIu32
+               ", \"samples\": %" PRIu32 ", \"min\": %s"
+               ", \"median\": %s, \"p99\": %s, \"max\": %s"
+               ", \"mean\": %s, \"stddev\": %s}\n",
+               res->name, res->runs, res->samples, min, median, p99, max,
+               mean, stddev);
+        break;
+    default:
+        printf("%25s: %12s %12s %12s %12s %12s %12s\n", res->name, min,
+               median, p99, max, mean, stddev);
+        break;
+    }
 }
@@ -161,10 +161,20 @@ can_rx_data_t *can_pkt_alloc_rx_data(void *data, size_t len, void *arg)
     rx->data.iov_base = data;
     rx->data.iov_len = len;
     rx->arg = arg;
+    rx->ref_count = 1;
 
     return rx;
 }
 
+void can_pkt_ref_rx_data(can_rx_data_t *data)
+{
+    assert(data);
+
+    mutex_lock(&_mutex);
+    data->ref_count++;
+    mutex_unlock(&_mutex);
+}
+
 void can_pkt_free_rx_data(can_rx_data_t *data)
 {
     if (!data) {
@@ -174,6 +184,9 @@ void can_pkt_free_rx_data(can_rx_data_t *data)
     DEBUG("can_pkt_free_rx_data: rx=%p\n", (void *)data);
 
     mutex_lock(&_mutex);
-    memarray_free(&_pkt_array, data);
+    assert(data->ref_count > 0);
+    if (--data->ref_count == 0) {
+        memarray_free(&_pkt_array, data);
+    }
     mutex_unlock(&_mutex);
 }
@@ -51,36 +51,93 @@ typedef struct filter_el {
     void *data;              /**< Private data */
 } filter_el_t;
 
+#ifndef CAN_ROUTER_MAX_FILTER
+#define CAN_ROUTER_MAX_FILTER   64
+#endif
+
 /**
- * This table contains @p CAN_ROUTER_APP_MAX lists of CAN IDs per interface
+ * Number of hash buckets per interface, must be a power of 2
  */
-static can_reg_entry_t *table[CAN_DLL_NUMOF];
+#ifndef CAN_ROUTER_HASH_SIZE
+#define CAN_ROUTER_HASH_SIZE    32
+#endif
 
-#ifndef CAN_ROUTER_MAX_FILTER
-#define CAN_ROUTER_MAX_FILTER   64
+/**
+ * Number of distinct masks per interface which are looked up by hash,
+ * filters with further masks are checked one by one
+ */
+#ifndef CAN_ROUTER_MAX_MASKS
+#define CAN_ROUTER_MAX_MASKS    4
+#endif
+
+/**
+ * Number of subscriber params for which one RX data is shared per frame
+ */
+#ifndef CAN_ROUTER_SHARED_RX_MAX
+#define CAN_ROUTER_SHARED_RX_MAX    4
 #endif
 
+#if (CAN_ROUTER_HASH_SIZE & (CAN_ROUTER_HASH_SIZE - 1)) != 0
+#error "CAN_ROUTER_HASH_SIZE must be a power of 2"
+#endif
+
+/**
+ * This is a group of filters sharing the same mask
+ */
+typedef struct {
+    canid_t mask;            /**< Mask of the group */
+    unsigned users;          /**< Number of filters in the group, 0 if unused */
+} mask_group_t;
+
+/**
+ * This is the filter index of an interface
+ *
+ * Filters of a mask group are hashed by CAN ID, so a received frame needs one
+ * bucket lookup per mask group instead of a walk over all filters.
+ */
+typedef struct {
+    can_reg_entry_t *buckets[CAN_ROUTER_HASH_SIZE]; /**< Filters in a mask group */
+    mask_group_t groups[CAN_ROUTER_MAX_MASKS];      /**< Mask groups */
+    can_reg_entry_t *others;                        /**< Filters without group */
+} filter_table_t;
+
+static filter_table_t table[CAN_DLL_NUMOF];
+
 static filter_el_t _filter_buf[CAN_ROUTER_MAX_FILTER];
 static memarray_t _filter_array;
 static mutex_t lock = MUTEX_INIT;
 
 static filter_el_t *_alloc_filter_el(canid_t can_id, canid_t mask, void *data);
 static void _free_filter_el(filter_el_t *el);
-static void _insert_to_list(can_reg_entry_t **list, filter_el_t *el);
-static filter_el_t *_find_filter_el(can_reg_entry_t *list, can_reg_entry_t *entry, canid_t can_id, canid_t mask, void *data);
+static filter_el_t *_find_filter_el(filter_table_t *t, can_reg_entry_t *entry, canid_t can_id, canid_t mask, void *data);
 static int _filter_is_used(unsigned int ifnum, canid_t can_id, canid_t mask);
 
+static unsigned _hash(canid_t can_id)
+{
+    can_id ^= can_id >> 16;
+    can_id ^= can_id >> 8;
+    return can_id & (CAN_ROUTER_HASH_SIZE - 1);
+}
+
 #if ENABLE_DEBUG
+static void _print_list(can_reg_entry_t *list)
+{
+    can_reg_entry_t *entry;
+    LL_FOREACH(list, entry) {
+        filter_el_t *el = container_of(entry, filter_el_t, entry);
+        DEBUG("App pid=%" PRIkernel_pid ", el=%p, can_id=0x%" PRIx32 ", mask=0x%" PRIx32 ", data=%p\n",
+              el->entry.target.pid, (void*)el, el->can_id, el->mask, el->data);
+    }
+}
+
 static void _print_filters(void)
 {
     for (int i = 0; i < (int)CAN_DLL_NUMOF; i++) {
         DEBUG("--- Ifnum: %d ---\n", i);
-        can_reg_entry_t *entry;
-        LL_FOREACH(table[i], entry) {
-            filter_el_t *el = container_of(entry, filter_el_t, entry);
-            DEBUG("App pid=%" PRIkernel_pid ", el=%p, can_id=0x%" PRIx32 ", mask=0x%" PRIx32 ", data=%p\n",
-                  el->entry.target.pid, (void*)el, el->can_id, el->mask, el->data);
+        for (unsigned j = 0; j < CAN_ROUTER_HASH_SIZE; j++) {
+            _print_list(table[i].buckets[j]);
         }
+        _print_list(table[i].others);
     }
 }
 
@@ -123,40 +180,66 @@ static void _free_filter_el(filter_el_t *el)
     memarray_free(&_filter_array, el);
 }
 
-/* Insert to the list in a sorted way
- * Lower CAN IDs are inserted first */
-static void _insert_to_list(can_reg_entry_t **list, filter_el_t *el)
+static mask_group_t *_find_group(filter_table_t *t, canid_t mask)
 {
-    can_reg_entry_t *next_entry = *list;
-    filter_el_t *next_el = container_of(next_entry, filter_el_t, entry);
+    for (unsigned i = 0; i < CAN_ROUTER_MAX_MASKS; i++) {
+        if (t->groups[i].users && (t->groups[i].mask == mask)) {
+            return &t->groups[i];
+        }
+    }
+    return NULL;
+}
 
-    DEBUG("_insert_to_list: list=%p, el=%p\n", (void *)list, (void *)el);
+/* Insert to the bucket of the filter's mask group, if the group does not
+ * exist and cannot be created, the filter goes to the list of filters
+ * checked one by one */
+static void _insert_filter_el(filter_table_t *t, filter_el_t *el)
+{
+    mask_group_t *group = _find_group(t, el->mask);
 
-    if (!(*list) || (next_el->can_id > el->can_id)) {
-        LL_PREPEND(*list, &el->entry);
-        DEBUG("_insert_to_list: inserting first el, list=%p\n", (void *)list);
+    if (!group) {
+        for (unsigned i = 0; i < CAN_ROUTER_MAX_MASKS; i++) {
+            if (!t->groups[i].users) {
+                group = &t->groups[i];
+                group->mask = el->mask;
+                break;
+            }
+        }
+    }
+    if (group) {
+        group->users++;
+        LL_PREPEND(t->buckets[_hash(el->can_id)], &el->entry);
+        DEBUG("_insert_filter_el: el=%p in bucket %u\n", (void *)el, _hash(el->can_id));
     }
     else {
-        do {
-            if (el->can_id <= next_el->can_id) {
-                DEBUG("_insert_to_list: found next_el can_id:0x%" PRIx32
-                      "\n", next_el->can_id);
-                LL_PREPEND_ELEM(*list, next_entry, &el->entry);
-                return;
-            }
-            else if (next_el->entry.next == NULL) {
-                DEBUG("_insert_to_list: insert at the end\n");
-                LL_APPEND(next_entry, &el->entry);
-                return;
-            }
-            else {
-                next_entry = next_entry->next;
-                next_el = container_of(next_entry, filter_el_t, entry);
-                DEBUG("_insert_to_list: going to next el: %p\n", (void*) next_el);
-            }
-        } while (next_el);
+        LL_PREPEND(t->others, &el->entry);
+        DEBUG("_insert_filter_el: el=%p in others\n", (void *)el);
+    }
+}
 
+static can_reg_entry_t **_list_of(filter_table_t *t, filter_el_t *el)
+{
+    can_reg_entry_t **list = &t->buckets[_hash(el->can_id)];
+    can_reg_entry_t *entry;
+
+    LL_FOREACH(*list, entry) {
+        if (entry == &el->entry) {
+            return list;
+        }
     }
+    return &t->others;
+}
+
+static void _remove_filter_el(filter_table_t *t, filter_el_t *el)
+{
+    can_reg_entry_t **list = _list_of(t, el);
+
+    if (list != &t->others) {
+        mask_group_t *group = _find_group(t, el->mask);
+        assert(group);
+        group->users--;
+    }
+    LL_DELETE(*list, &el->entry);
 }
 
 #ifdef MODULE_CAN_MBOX
@@ -167,40 +250,36 @@ static void _insert_to_list(can_reg_entry_t **list, filter_el_t *el)
 #define ENTRY_MATCHES(e1, e2)  ((e1)->target.pid == (e2)->target.pid)
 #endif
 
-static filter_el_t *_find_filter_el(can_reg_entry_t *list, can_reg_entry_t *entry, canid_t can_id, canid_t mask, void *data)
+static filter_el_t *_find_in_list(can_reg_entry_t *list, can_reg_entry_t *entry, canid_t can_id, canid_t mask, void *data)
 {
-    filter_el_t *el = container_of(list, filter_el_t, entry);
-    if (!el) {
-        return el;
-    }
-    do {
-        if ((el->can_id == can_id) && (el->mask == mask) && (el->data == data) &&
-                ENTRY_MATCHES(&el->entry, entry)) {
-            DEBUG("_find_filter_el: found el=%p, can_id=%" PRIx32 ", mask=%" PRIx32 ", data=%p\n",
+    can_reg_entry_t *e;
+    LL_FOREACH(list, e) {
+        filter_el_t *el = container_of(e, filter_el_t, entry);
+        if ((el->can_id == can_id) && (el->mask == mask) &&
+                (!entry || ((el->data == data) && ENTRY_MATCHES(&el->entry, entry)))) {
+            DEBUG("_find_in_list: found el=%p, can_id=%" PRIx32 ", mask=%" PRIx32 ", data=%p\n",
                   (void *)el, el->can_id, el->mask, el->data);
             return el;
         }
-        el = container_of(el->entry.next, filter_el_t, entry);
-    }  while (el);
-
+    }
     return NULL;
 }
 
-static int _filter_is_used(unsigned int ifnum, canid_t can_id, canid_t mask)
+/* Find a filter, if entry is NULL any filter with can_id and mask matches */
+static filter_el_t *_find_filter_el(filter_table_t *t, can_reg_entry_t *entry, canid_t can_id, canid_t mask, void *data)
 {
-    filter_el_t *el = container_of(table[ifnum], filter_el_t, entry);
+    filter_el_t *el = _find_in_list(t->buckets[_hash(can_id)], entry, can_id, mask, data);
     if (!el) {
-        DEBUG("_filter_is_used: empty list\n");
-        return 0;
+        el = _find_in_list(t->others, entry, can_id, mask, data);
+    }
+    return el;
+}
+
+static int _filter_is_used(unsigned int ifnum, canid_t can_id, canid_t mask)
+{
+    if (_find_filter_el(&table[ifnum], NULL, can_id, mask, NULL)) {
+        return 1;
     }
-    do {
-        if ((el->can_id == can_id) && (el->mask == mask)) {
-            DEBUG("_filter_is_used: found el=%p, can_id=%" PRIx32 ", mask=%" PRIx32 ", data=%p\n",
-                  (void *)el, el->can_id, el->mask, el->data);
-            return 1;
-        }
-        el = container_of(el->entry.next, filter_el_t, entry);
-    }  while (el);
 
     DEBUG("_filter_is_used: filter not found\n");
 
@@ -247,7 +326,7 @@ int can_router_register(can_reg_entry_t *entry, canid_t can_id, canid_t mask, vo
     filter->entry.target.pid = entry->target.pid;
 #endif
     filter->entry.ifnum = entry->ifnum;
-    _insert_to_list(&table[entry->ifnum], filter);
+    _insert_filter_el(&table[entry->ifnum], filter);
     mutex_unlock(&lock);
 
     PRINT_FILTERS();
@@ -273,12 +352,12 @@ int can_router_unregister(can_reg_entry_t *entry, canid_t can_id,
 #endif
 
     mutex_lock(&lock);
-    el = _find_filter_el(table[entry->ifnum], entry, can_id, mask, param);
+    el = _find_filter_el(&table[entry->ifnum], entry, can_id, mask, param);
     if (!el) {
         mutex_unlock(&lock);
         return -EINVAL;
     }
-    LL_DELETE(table[entry->ifnum], &el->entry);
+    _remove_filter_el(&table[entry->ifnum], el);
     _free_filter_el(el);
     ret = _filter_is_used(entry->ifnum, can_id, mask);
     mutex_unlock(&lock);
@@ -305,6 +384,59 @@ static int _send_msg(msg_t *msg, can_reg_entry_t *entry)
 #endif
 }
 
+/**
+ * RX data handed out while dispatching frames
+ *
+ * The RX data of a frame is shared by the subscribers registered with the same
+ * param, as the param is passed along with it. Each delivery holds a reference
+ * on both the frame and the RX data, which raw_can_free_frame() drops.
+ */
+typedef struct {
+    can_rx_data_t *rx[CAN_ROUTER_SHARED_RX_MAX];    /**< shared RX data */
+    unsigned numof;                                 /**< used entries of rx */
+} shared_rx_t;
+
+static can_rx_data_t *_get_rx_data(shared_rx_t *shared, can_pkt_t *pkt, void *arg)
+{
+    for (unsigned i = 0; i < shared->numof; i++) {
+        can_rx_data_t *rx = shared->rx[i];
+        if ((rx->data.iov_base == &pkt->frame) && (rx->arg == arg)) {
+            can_pkt_ref_rx_data(rx);
+            return rx;
+        }
+    }
+
+    can_rx_data_t *rx = can_pkt_alloc_rx_data(&pkt->frame, sizeof(pkt->frame), arg);
+    if (rx && (shared->numof < CAN_ROUTER_SHARED_RX_MAX)) {
+        /* keep a reference while dispatching, so the RX data stays valid
+         * even if the first subscriber is done with it already */
+        can_pkt_ref_rx_data(rx);
+        shared->rx[shared->numof++] = rx;
+    }
+    return rx;
+}
+
+static int _deliver(can_pkt_t *pkt, filter_el_t *el, shared_rx_t *shared)
+{
+    msg_t msg;
+    msg.type = CAN_MSG_RX_INDICATION;
+
+    DEBUG("can_router_dispatch_rx_indic: found el=%p, data=%p\n",
+          (void *)el, (void *)el->data);
+    DEBUG("can_router_dispatch_rx_indic: rx_ind to pid: %"
+          PRIkernel_pid "\n", el->entry.target.pid);
+    atomic_fetch_add(&pkt->ref_count, 1);
+    msg.content.ptr = _get_rx_data(shared, pkt, el->data);
+    if (!msg.content.ptr || (_send_msg(&msg, &el->entry) <= 0)) {
+        can_pkt_free_rx_data(msg.content.ptr);
+        atomic_fetch_sub(&pkt->ref_count, 1);
+        DEBUG("can_router_dispatch_rx_indic: failed to send msg to "
+              "pid=%" PRIkernel_pid "\n", el->entry.target.pid);
+        return -EBUSY;
+    }
+    return 0;
+}
+
 /* send received pkt to all interested users */
 int can_router_dispatch_rx_indic(can_pkt_t *pkt)
 {
@@ -314,43 +446,50 @@ int can_router_dispatch_rx_indic(can_pkt_t *pkt)
     }
 
     int res = 0;
-    msg_t msg;
-    msg.type = CAN_MSG_RX_INDICATION;
-#if ENABLE_DEBUG
-    int msg_cnt = 0;
-#endif
+    shared_rx_t shared = { .numof = 0 };
+    canid_t can_id = pkt->frame.can_id;
+    filter_table_t *t = &table[pkt->entry.ifnum];
     DEBUG("can_router_dispatch_rx_indic: pkt=%p, ifnum=%d, can_id=%" PRIx32 "\n",
-          (void *)pkt, pkt->entry.ifnum, pkt->frame.can_id);
+          (void *)pkt, pkt->entry.ifnum, can_id);
 
     mutex_lock(&lock);
     can_reg_entry_t *entry = NULL;
     filter_el_t *el;
-    LL_FOREACH(table[pkt->entry.ifnum], entry) {
-        el = container_of(entry, filter_el_t, entry);
-        if ((pkt->frame.can_id & el->mask) == el->can_id) {
-            DEBUG("can_router_dispatch_rx_indic: found el=%p, data=%p\n",
-                  (void *)el, (void *)el->data);
-            DEBUG("can_router_dispatch_rx_indic: rx_ind to pid: %"
-                  PRIkernel_pid "\n", entry->target.pid);
-            atomic_fetch_add(&pkt->ref_count, 1);
-            msg.content.ptr = can_pkt_alloc_rx_data(&pkt->frame, sizeof(pkt->frame), el->data);
-#if ENABLE_DEBUG
-            msg_cnt++;
-#endif
-            if (!msg.content.ptr || (_send_msg(&msg, entry) <= 0)) {
-                can_pkt_free_rx_data(msg.content.ptr);
-                atomic_fetch_sub(&pkt->ref_count, 1);
-                DEBUG("can_router_dispatch_rx_indic: failed to send msg to "
-                      "pid=%" PRIkernel_pid "\n", entry->target.pid);
-                res = -EBUSY;
-                break;
+    /* one bucket lookup per mask group */
+    for (unsigned i = 0; (i < CAN_ROUTER_MAX_MASKS) && !res; i++) {
+        if (!t->groups[i].users) {
+            continue;
+        }
+        canid_t mask = t->groups[i].mask;
+        canid_t key = can_id & mask;
+        LL_FOREACH(t->buckets[_hash(key)], entry) {
+            el = container_of(entry, filter_el_t, entry);
+            if ((el->mask == mask) && (el->can_id == key)) {
+                res = _deliver(pkt, el, &shared);
+                if (res) {
+                    break;
+                }
+            }
+        }
+    }
+    /* filters whose mask did not get a group */
+    if (!res) {
+        LL_FOREACH(t->others, entry) {
+            el = container_of(entry, filter_el_t, entry);
+            if ((can_id & el->mask) == el->can_id) {
+                res = _deliver(pkt, el, &shared);
+                if (res) {
+                    break;
+                }
             }
         }
     }
     mutex_unlock(&lock);
-#if ENABLE_DEBUG
-    DEBUG("can_router_dispatch_rx: msg send to %d threads\n", msg_cnt);
-#endif
+
+    /* drop the references held while dispatching */
+    for (unsigned i = 0; i < shared.numof; i++) {
+        can_pkt_free_rx_data(shared.rx[i]);
+    }
     if (atomic_load(&pkt->ref_count) == 0) {
         can_pkt_free(pkt);
     }
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sys_coro
+ * @{
+ *
+ * @file
+ * @brief       Stackless coroutine runtime implementation
+ *
+ * @}
+ */
+
+#include <assert.h>
+
+#include "coro.h"
+
+static void _handler(event_t *event)
+{
+    coro_t *coro = container_of(event, coro_t, super);
+
+    /* a wakeup may still be queued after the coroutine exited */
+    if (!coro_is_running(coro)) {
+        return;
+    }
+
+    switch (coro->func(coro)) {
+        case CORO_YIELDED:
+            coro_wake(coro);
+            break;
+        case CORO_EXITED:
+            coro->lc = CORO_LC_EXITED;
+            coro_clear_timeout(coro);
+            /* a wakeup that raced the exit must not stay queued: done() may
+             * release the memory of the coroutine */
+            event_cancel(coro->queue, &coro->super);
+            if (coro->done) {
+                coro->done(coro);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void _timeout_cb(void *arg)
+{
+    coro_t *coro = arg;
+
+    coro->timed_out = true;
+    coro_wake(coro);
+}
+
+void coro_init(coro_t *coro, coro_func_t func, coro_done_t done)
+{
+    assert(coro && func);
+
+    coro->super.list_node.next = NULL;
+    coro->super.handler = _handler;
+    coro->queue = NULL;
+    coro->func = func;
+    coro->done = done;
+    coro->timer.callback = _timeout_cb;
+    coro->timer.arg = coro;
+    coro->lc = CORO_LC_EXITED;
+    coro->timed_out = false;
+}
+
+void coro_start(coro_t *coro, event_queue_t *queue)
+{
+    assert(!coro_is_running(coro));
+
+    coro->queue = queue;
+    coro->lc = 0;
+    coro->timed_out = false;
+    coro_wake(coro);
+}
+
+void coro_run(coro_t *coro)
+{
+    event_queue_t queue;
+
+    event_queue_init(&queue);
+    coro_start(coro, &queue);
+    while (coro_is_running(coro)) {
+        event_t *event = event_wait(&queue);
+        event->handler(event);
+    }
+
+    /* drop whatever is left, e.g. wakeups of sources that raced the exit,
+     * the queue goes out of scope */
+    while (event_get(&queue)) {}
+}
+
+void coro_set_timeout(coro_t *coro, uint32_t timeout_us)
+{
+    coro->timed_out = false;
+    xtimer_set(&coro->timer, timeout_us);
+}
+
+void coro_clear_timeout(coro_t *coro)
+{
+    xtimer_remove(&coro->timer);
+}
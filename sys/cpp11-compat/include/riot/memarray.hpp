@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup cpp11-compat
+ * @{
+ *
+ * @file
+ * @brief   Type-safe object pool on top of @ref sys_memarray
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~ {.cpp}
+ * static riot::memarray<request, 8> requests;
+ *
+ * auto req = requests.make_unique(42);
+ * if (!req) {
+ *     // pool exhausted
+ * }
+ * ~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * @note    Like the underlying memarray, the pool is not thread-safe.
+ *
+ * @}
+ */
+
+#ifndef RIOT_MEMARRAY_HPP
+#define RIOT_MEMARRAY_HPP
+
+#include "memarray.h"
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace riot {
+
+/**
+ * @brief Pool of up to @p N objects of type @p T
+ *
+ * Objects are constructed in place by create() and have to be returned
+ * using destroy(), or are managed by the std::unique_ptr returned by
+ * make_unique().
+ */
+template <class T, std::size_t N>
+class memarray {
+  static_assert(N > 0, "memarray needs at least one element");
+
+public:
+  /**
+   * @brief Deleter returning an object to its pool
+   */
+  class deleter {
+  public:
+    deleter(memarray *pool = nullptr) noexcept : m_pool{pool} {}
+    void operator()(T *obj) const noexcept { m_pool->destroy(obj); }
+
+  private:
+    memarray *m_pool;
+  };
+
+  /**
+   * @brief Owning pointer to an object of the pool
+   */
+  using unique_ptr = std::unique_ptr<T, deleter>;
+
+  memarray() noexcept {
+    memarray_init(&m_pool, m_data, sizeof(m_data[0]), N);
+  }
+  memarray(const memarray&) = delete;
+  memarray& operator=(const memarray&) = delete;
+
+  /**
+   * @brief Construct an object in the pool
+   *
+   * @return pointer to the object, nullptr if the pool is exhausted
+   */
+  template <class... Args>
+  T *create(Args&&... args) {
+    void *mem = memarray_alloc(&m_pool);
+    return (mem) ? new (mem) T(std::forward<Args>(args)...) : nullptr;
+  }
+
+  /**
+   * @brief Destruct an object and return it to the pool
+   *
+   * @param[in] obj   object created by create(), may be nullptr
+   */
+  void destroy(T *obj) noexcept {
+    if (obj) {
+      obj->~T();
+      memarray_free(&m_pool, obj);
+    }
+  }
+
+  /**
+   * @brief Construct an object in the pool, owned by a std::unique_ptr
+   *
+   * @return owning pointer to the object, empty if the pool is exhausted
+   */
+  template <class... Args>
+  unique_ptr make_unique(Args&&... args) {
+    return unique_ptr{create(std::forward<Args>(args)...), deleter{this}};
+  }
+
+  /**
+   * @brief Number of objects that can still be created
+   */
+  std::size_t available() const noexcept { return memarray_available(&m_pool); }
+
+  /**
+   * @brief Number of objects currently alive
+   */
+  std::size_t used() const noexcept { return memarray_used(&m_pool); }
+
+  /**
+   * @brief Maximum number of objects alive at the same time
+   */
+  std::size_t max_used() const noexcept { return memarray_max_used(&m_pool); }
+
+  /**
+   * @brief Number of failed calls to create()
+   */
+  std::size_t failed() const noexcept { return memarray_failed(&m_pool); }
+
+  /**
+   * @brief The underlying memarray pool
+   */
+  memarray_t *native_handle() noexcept { return &m_pool; }
+
+private:
+  /* the free list is kept within unused elements */
+  union storage {
+    void *next;
+    alignas(T) unsigned char obj[sizeof(T)];
+  };
+
+  memarray_t m_pool;
+  storage m_data[N];
+};
+
+} // namespace riot
+
+#endif // RIOT_MEMARRAY_HPP
@@ -40,6 +40,10 @@
 #include "crypto/aes.h"
 #include "crypto/ciphers.h"
 
+#ifdef MODULE_CRYPTO_AES_NI
+#include "aes_ni.h"
+#endif
+
 /**
  * Interface to the aes cipher
  */
@@ -48,7 +52,10 @@ static const cipher_interface_t aes_interface = {
     AES_KEY_SIZE,
     aes_init,
     aes_encrypt,
-    aes_decrypt
+    aes_decrypt,
+    aes_encrypt_blocks,
+    aes_decrypt_blocks,
+    aes_cbc_mac_blocks
 };
 const cipher_id_t CIPHER_AES_128 = &aes_interface;
 
@@ -1025,23 +1032,12 @@ static int aes_set_decrypt_key(const unsigned char *userKey, const int bits,
 
 #ifndef AES_ASM
 /*
- * Encrypt a single block
+ * Encrypt a single block with an expanded key
  * in and out can overlap
  */
-int aes_encrypt(const cipher_context_t *context, const uint8_t *plainBlock,
-                uint8_t *cipherBlock)
+static void aes_encrypt_block(const AES_KEY *key, const uint8_t *plainBlock,
+                              uint8_t *cipherBlock)
 {
-    /* setup AES_KEY */
-    int res;
-    AES_KEY aeskey;
-    const AES_KEY *key = &aeskey;
-
-    res = aes_set_encrypt_key((unsigned char *)context->context,
-                              AES_KEY_SIZE * 8, &aeskey);
-    if (res < 0) {
-        return res;
-    }
-
     const u32 *rk;
     u32 s0, s1, s2, s3, t0, t1, t2, t3;
 #ifndef MODULE_CRYPTO_AES_UNROLL
@@ -1289,28 +1285,15 @@ int aes_encrypt(const cipher_context_t *context, const uint8_t *plainBlock,
         (Te4((t2) & 0xff)       & 0x000000ff) ^
         rk[3];
     PUTU32(cipherBlock + 12, s3);
-    return 1;
 }
 
 /*
- * Decrypt a single block
+ * Decrypt a single block with an expanded key
  * in and out can overlap
  */
-int aes_decrypt(const cipher_context_t *context, const uint8_t *cipherBlock,
-                uint8_t *plainBlock)
+static void aes_decrypt_block(const AES_KEY *key, const uint8_t *cipherBlock,
+                              uint8_t *plainBlock)
 {
-    /* setup AES_KEY */
-    int res;
-    AES_KEY aeskey;
-    const AES_KEY *key = &aeskey;
-
-    res = aes_set_decrypt_key((unsigned char *)context->context,
-                              AES_KEY_SIZE * 8, &aeskey);
-
-    if (res < 0) {
-        return res;
-    }
-
     const u32 *rk;
     u32 s0, s1, s2, s3, t0, t1, t2, t3;
 #ifndef MODULE_CRYPTO_AES_UNROLL
@@ -1550,6 +1533,98 @@ int aes_decrypt(const cipher_context_t *context, const uint8_t *cipherBlock,
         (Td4((t0) & 0xff)       & 0x000000ff) ^
         rk[3];
     PUTU32(plainBlock + 12, s3);
+}
+
+/*
+ * The context only holds the raw key, so the key schedule has to be expanded
+ * on every call. The *_blocks variants do this once for all blocks.
+ */
+int aes_encrypt(const cipher_context_t *context, const uint8_t *plainBlock,
+                uint8_t *cipherBlock)
+{
+    return aes_encrypt_blocks(context, plainBlock, cipherBlock, 1);
+}
+
+int aes_encrypt_blocks(const cipher_context_t *context, const uint8_t *plain,
+                       uint8_t *cipher, size_t nblocks)
+{
+#ifdef MODULE_CRYPTO_AES_NI
+    if (aes_ni_supported()) {
+        aes_ni_encrypt_blocks(context->context, plain, cipher, nblocks);
+        return 1;
+    }
+#endif
+    AES_KEY aeskey;
+    int res = aes_set_encrypt_key((unsigned char *)context->context,
+                                  AES_KEY_SIZE * 8, &aeskey);
+
+    if (res < 0) {
+        return res;
+    }
+
+    for (; nblocks > 0; nblocks--) {
+        aes_encrypt_block(&aeskey, plain, cipher);
+        plain += AES_BLOCK_SIZE;
+        cipher += AES_BLOCK_SIZE;
+    }
+    return 1;
+}
+
+int aes_decrypt(const cipher_context_t *context, const uint8_t *cipherBlock,
+                uint8_t *plainBlock)
+{
+    return aes_decrypt_blocks(context, cipherBlock, plainBlock, 1);
+}
+
+int aes_decrypt_blocks(const cipher_context_t *context, const uint8_t *cipher,
+                       uint8_t *plain, size_t nblocks)
+{
+#ifdef MODULE_CRYPTO_AES_NI
+    if (aes_ni_supported()) {
+        aes_ni_decrypt_blocks(context->context, cipher, plain, nblocks);
+        return 1;
+    }
+#endif
+    AES_KEY aeskey;
+    int res = aes_set_decrypt_key((unsigned char *)context->context,
+                                  AES_KEY_SIZE * 8, &aeskey);
+
+    if (res < 0) {
+        return res;
+    }
+
+    for (; nblocks > 0; nblocks--) {
+        aes_decrypt_block(&aeskey, cipher, plain);
+        cipher += AES_BLOCK_SIZE;
+        plain += AES_BLOCK_SIZE;
+    }
+    return 1;
+}
+
+int aes_cbc_mac_blocks(const cipher_context_t *context, uint8_t *mac,
+                       const uint8_t *input, size_t nblocks)
+{
+#ifdef MODULE_CRYPTO_AES_NI
+    if (aes_ni_supported()) {
+        aes_ni_cbc_mac_blocks(context->context, mac, input, nblocks);
+        return 1;
+    }
+#endif
+    AES_KEY aeskey;
+    int res = aes_set_encrypt_key((unsigned char *)context->context,
+                                  AES_KEY_SIZE * 8, &aeskey);
+
+    if (res < 0) {
+        return res;
+    }
+
+    for (; nblocks > 0; nblocks--) {
+        for (unsigned i = 0; i < AES_BLOCK_SIZE; i++) {
+            mac[i] ^= input[i];
+        }
+        aes_encrypt_block(&aeskey, mac, mac);
+        input += AES_BLOCK_SIZE;
+    }
     return 1;
 }
 
@@ -0,0 +1,536 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sys_crypto
+ * @{
+ *
+ * @file
+ * @brief       Bitsliced, constant-time implementation of the AES cipher
+ *
+ * Used instead of the T-table implementation in aes.c with the pseudomodule
+ * `crypto_aes_ct`. Two blocks are processed in parallel: the 256 bits of
+ * both states are spread over eight 32-bit words, so that word i holds bit i
+ * of all 32 bytes. The S-box is then evaluated as a boolean circuit (Boyar
+ * and Peralta, "A depth-16 circuit for the AES S-box", 2011) on all bytes at
+ * once. There are neither table lookups nor branches depending on the key or
+ * the data, so the timing does not leak them through the cache.
+ *
+ * @}
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "crypto/aes.h"
+#include "crypto/ciphers.h"
+
+#ifdef MODULE_CRYPTO_AES_NI
+#include "aes_ni.h"
+#endif
+
+/**
+ * Interface to the aes cipher
+ */
+static const cipher_interface_t aes_interface = {
+    AES_BLOCK_SIZE,
+    AES_KEY_SIZE,
+    aes_init,
+    aes_encrypt,
+    aes_decrypt,
+    aes_encrypt_blocks,
+    aes_decrypt_blocks,
+    aes_cbc_mac_blocks
+};
+const cipher_id_t CIPHER_AES_128 = &aes_interface;
+
+#define ROUNDS          (10U)
+
+/* round keys in bitsliced form, 8 words per round */
+typedef struct {
+    uint32_t sk[(ROUNDS + 1) * 8];
+} aes_ct_key_t;
+
+static inline uint32_t _dec32le(const uint8_t *src)
+{
+    return (uint32_t)src[0] | ((uint32_t)src[1] << 8) |
+           ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+static inline void _enc32le(uint8_t *dst, uint32_t x)
+{
+    dst[0] = (uint8_t)x;
+    dst[1] = (uint8_t)(x >> 8);
+    dst[2] = (uint8_t)(x >> 16);
+    dst[3] = (uint8_t)(x >> 24);
+}
+
+static inline uint32_t _rotr8(uint32_t x)
+{
+    return (x >> 8) | (x << 24);
+}
+
+static inline uint32_t _rotr16(uint32_t x)
+{
+    return (x >> 16) | (x << 16);
+}
+
+#define SWAPN(cl, ch, s, x, y) do { \
+        uint32_t a = (x), b = (y); \
+        (x) = (a & (cl)) | ((b & (cl)) << (s)); \
+        (y) = ((a & (ch)) >> (s)) | (b & (ch)); \
+} while (0)
+
+/*
+ * Converts between the byte-wise and the bitsliced representation. Word
+ * 2j (2j + 1) holds column j of the first (second) block, byte i of a column
+ * is its row i. Afterwards, bit 8 * r + 2 * j (+ 1) of word i holds bit i of
+ * row r, column j of the first (second) block. Its own inverse.
+ */
+static void _ortho(uint32_t *q)
+{
+    for (unsigned i = 0; i < 8; i += 2) {
+        SWAPN(0x55555555, 0xAAAAAAAA, 1, q[i], q[i + 1]);
+    }
+    for (unsigned i = 0; i < 8; i += 4) {
+        SWAPN(0x33333333, 0xCCCCCCCC, 2, q[i], q[i + 2]);
+        SWAPN(0x33333333, 0xCCCCCCCC, 2, q[i + 1], q[i + 3]);
+    }
+    for (unsigned i = 0; i < 4; i++) {
+        SWAPN(0x0F0F0F0F, 0xF0F0F0F0, 4, q[i], q[i + 4]);
+    }
+}
+
+/* S-box circuit of Boyar and Peralta: a linear layer, a non-linear one
+ * computing the inverse in GF(2^8) and another linear layer */
+static void _sub_bytes(uint32_t *q)
+{
+    uint32_t x0 = q[7], x1 = q[6], x2 = q[5], x3 = q[4];
+    uint32_t x4 = q[3], x5 = q[2], x6 = q[1], x7 = q[0];
+
+    uint32_t y14 = x3 ^ x5;
+    uint32_t y13 = x0 ^ x6;
+    uint32_t y9 = x0 ^ x3;
+    uint32_t y8 = x0 ^ x5;
+    uint32_t t0 = x1 ^ x2;
+    uint32_t y1 = t0 ^ x7;
+    uint32_t y4 = y1 ^ x3;
+    uint32_t y12 = y13 ^ y14;
+    uint32_t y2 = y1 ^ x0;
+    uint32_t y5 = y1 ^ x6;
+    uint32_t y3 = y5 ^ y8;
+    uint32_t t1 = x4 ^ y12;
+    uint32_t y15 = t1 ^ x5;
+    uint32_t y20 = t1 ^ x1;
+    uint32_t y6 = y15 ^ x7;
+    uint32_t y10 = y15 ^ t0;
+    uint32_t y11 = y20 ^ y9;
+    uint32_t y7 = x7 ^ y11;
+    uint32_t y17 = y10 ^ y11;
+    uint32_t y19 = y10 ^ y8;
+    uint32_t y16 = t0 ^ y11;
+    uint32_t y21 = y13 ^ y16;
+    uint32_t y18 = x0 ^ y16;
+
+    uint32_t t2 = y12 & y15;
+    uint32_t t3 = y3 & y6;
+    uint32_t t4 = t3 ^ t2;
+    uint32_t t5 = y4 & x7;
+    uint32_t t6 = t5 ^ t2;
+    uint32_t t7 = y13 & y16;
+    uint32_t t8 = y5 & y1;
+    uint32_t t9 = t8 ^ t7;
+    uint32_t t10 = y2 & y7;
+    uint32_t t11 = t10 ^ t7;
+    uint32_t t12 = y9 & y11;
+    uint32_t t13 = y14 & y17;
+    uint32_t t14 = t13 ^ t12;
+    uint32_t t15 = y8 & y10;
+    uint32_t t16 = t15 ^ t12;
+    uint32_t t17 = t4 ^ t14;
+    uint32_t t18 = t6 ^ t16;
+    uint32_t t19 = t9 ^ t14;
+    uint32_t t20 = t11 ^ t16;
+    uint32_t t21 = t17 ^ y20;
+    uint32_t t22 = t18 ^ y19;
+    uint32_t t23 = t19 ^ y21;
+    uint32_t t24 = t20 ^ y18;
+
+    uint32_t t25 = t21 ^ t22;
+    uint32_t t26 = t21 & t23;
+    uint32_t t27 = t24 ^ t26;
+    uint32_t t28 = t25 & t27;
+    uint32_t t29 = t28 ^ t22;
+    uint32_t t30 = t23 ^ t24;
+    uint32_t t31 = t22 ^ t26;
+    uint32_t t32 = t31 & t30;
+    uint32_t t33 = t32 ^ t24;
+    uint32_t t34 = t23 ^ t33;
+    uint32_t t35 = t27 ^ t33;
+    uint32_t t36 = t24 & t35;
+    uint32_t t37 = t36 ^ t34;
+    uint32_t t38 = t27 ^ t36;
+    uint32_t t39 = t29 & t38;
+    uint32_t t40 = t25 ^ t39;
+
+    uint32_t t41 = t40 ^ t37;
+    uint32_t t42 = t29 ^ t33;
+    uint32_t t43 = t29 ^ t40;
+    uint32_t t44 = t33 ^ t37;
+    uint32_t t45 = t42 ^ t41;
+    uint32_t z0 = t44 & y15;
+    uint32_t z1 = t37 & y6;
+    uint32_t z2 = t33 & x7;
+    uint32_t z3 = t43 & y16;
+    uint32_t z4 = t40 & y1;
+    uint32_t z5 = t29 & y7;
+    uint32_t z6 = t42 & y11;
+    uint32_t z7 = t45 & y17;
+    uint32_t z8 = t41 & y10;
+    uint32_t z9 = t44 & y12;
+    uint32_t z10 = t37 & y3;
+    uint32_t z11 = t33 & y4;
+    uint32_t z12 = t43 & y13;
+    uint32_t z13 = t40 & y5;
+    uint32_t z14 = t29 & y2;
+    uint32_t z15 = t42 & y9;
+    uint32_t z16 = t45 & y14;
+    uint32_t z17 = t41 & y8;
+
+    uint32_t t46 = z15 ^ z16;
+    uint32_t t47 = z10 ^ z11;
+    uint32_t t48 = z5 ^ z13;
+    uint32_t t49 = z9 ^ z10;
+    uint32_t t50 = z2 ^ z12;
+    uint32_t t51 = z2 ^ z5;
+    uint32_t t52 = z7 ^ z8;
+    uint32_t t53 = z0 ^ z3;
+    uint32_t t54 = z6 ^ z7;
+    uint32_t t55 = z16 ^ z17;
+    uint32_t t56 = z12 ^ t48;
+    uint32_t t57 = t50 ^ t53;
+    uint32_t t58 = z4 ^ t46;
+    uint32_t t59 = z3 ^ t54;
+    uint32_t t60 = t46 ^ t57;
+    uint32_t t61 = z14 ^ t57;
+    uint32_t t62 = t52 ^ t58;
+    uint32_t t63 = t49 ^ t58;
+    uint32_t t64 = z4 ^ t59;
+    uint32_t t65 = t61 ^ t62;
+    uint32_t t66 = z1 ^ t63;
+    uint32_t s0 = t59 ^ t63;
+    uint32_t s6 = t56 ^ ~t62;
+    uint32_t s7 = t48 ^ ~t60;
+    uint32_t t67 = t64 ^ t65;
+    uint32_t s3 = t53 ^ t66;
+    uint32_t s4 = t51 ^ t66;
+    uint32_t s5 = t47 ^ t65;
+    uint32_t s1 = t64 ^ ~s3;
+    uint32_t s2 = t55 ^ ~t67;
+
+    q[7] = s0;
+    q[6] = s1;
+    q[5] = s2;
+    q[4] = s3;
+    q[3] = s4;
+    q[2] = s5;
+    q[1] = s6;
+    q[0] = s7;
+}
+
+/* inverse of the affine transformation of the S-box */
+static void _inv_affine(uint32_t *q)
+{
+    uint32_t q0 = ~q[0], q1 = ~q[1], q2 = q[2], q3 = q[3];
+    uint32_t q4 = q[4], q5 = ~q[5], q6 = ~q[6], q7 = q[7];
+
+    q[7] = q1 ^ q4 ^ q6;
+    q[6] = q0 ^ q3 ^ q5;
+    q[5] = q7 ^ q2 ^ q4;
+    q[4] = q6 ^ q1 ^ q3;
+    q[3] = q5 ^ q0 ^ q2;
+    q[2] = q4 ^ q7 ^ q1;
+    q[1] = q3 ^ q6 ^ q0;
+    q[0] = q2 ^ q5 ^ q7;
+}
+
+/* S(x) is the affine transformation of the inverse of x, so the inverse
+ * S-box is A^-1(S(A^-1(x))) */
+static void _inv_sub_bytes(uint32_t *q)
+{
+    _inv_affine(q);
+    _sub_bytes(q);
+    _inv_affine(q);
+}
+
+static void _shift_rows(uint32_t *q)
+{
+    for (unsigned i = 0; i < 8; i++) {
+        uint32_t x = q[i];
+        q[i] = (x & 0x000000FF)
+             | ((x & 0x0000FC00) >> 2) | ((x & 0x00000300) << 6)
+             | ((x & 0x00F00000) >> 4) | ((x & 0x000F0000) << 4)
+             | ((x & 0xC0000000) >> 6) | ((x & 0x3F000000) << 2);
+    }
+}
+
+static void _inv_shift_rows(uint32_t *q)
+{
+    for (unsigned i = 0; i < 8; i++) {
+        uint32_t x = q[i];
+        q[i] = (x & 0x000000FF)
+             | ((x & 0x00003F00) << 2) | ((x & 0x0000C000) >> 6)
+             | ((x & 0x00F00000) >> 4) | ((x & 0x000F0000) << 4)
+             | ((x & 0x03000000) << 6) | ((x & 0xFC000000) >> 2);
+    }
+}
+
+/* b_r = 2 * (a_r + a_r+1) + a_r+1 + a_r+2 + a_r+3, the rows of a column are
+ * 8 bits apart, so rotating by 8 yields row r + 1 at the place of row r */
+static void _mix_columns(uint32_t *q)
+{
+    uint32_t a[8], r[8];
+
+    for (unsigned i = 0; i < 8; i++) {
+        a[i] = q[i];
+        r[i] = _rotr8(q[i]);
+    }
+    /* multiplication by 2 in GF(2^8): shift and reduce by 0x1b */
+    q[0] = a[7] ^ r[7] ^ r[0] ^ _rotr16(a[0] ^ r[0]);
+    q[1] = a[0] ^ r[0] ^ a[7] ^ r[7] ^ r[1] ^ _rotr16(a[1] ^ r[1]);
+    q[2] = a[1] ^ r[1] ^ r[2] ^ _rotr16(a[2] ^ r[2]);
+    q[3] = a[2] ^ r[2] ^ a[7] ^ r[7] ^ r[3] ^ _rotr16(a[3] ^ r[3]);
+    q[4] = a[3] ^ r[3] ^ a[7] ^ r[7] ^ r[4] ^ _rotr16(a[4] ^ r[4]);
+    q[5] = a[4] ^ r[4] ^ r[5] ^ _rotr16(a[5] ^ r[5]);
+    q[6] = a[5] ^ r[5] ^ r[6] ^ _rotr16(a[6] ^ r[6]);
+    q[7] = a[6] ^ r[6] ^ r[7] ^ _rotr16(a[7] ^ r[7]);
+}
+
+/* InvMixColumns is MixColumns after multiplying every column by
+ * {04}x^2 + {05}: a_r += 4 * (a_r + a_r+2) */
+static void _inv_mix_columns(uint32_t *q)
+{
+    uint32_t t[8];
+
+    for (unsigned i = 0; i < 8; i++) {
+        t[i] = q[i] ^ _rotr16(q[i]);
+    }
+    /* multiply t by 4 in GF(2^8), i.e. by 2 twice */
+    for (unsigned n = 0; n < 2; n++) {
+        uint32_t t7 = t[7];
+        t[7] = t[6];
+        t[6] = t[5];
+        t[5] = t[4];
+        t[4] = t[3] ^ t7;
+        t[3] = t[2] ^ t7;
+        t[2] = t[1];
+        t[1] = t[0] ^ t7;
+        t[0] = t7;
+    }
+    for (unsigned i = 0; i < 8; i++) {
+        q[i] ^= t[i];
+    }
+    _mix_columns(q);
+}
+
+static inline void _add_round_key(uint32_t *q, const uint32_t *sk)
+{
+    for (unsigned i = 0; i < 8; i++) {
+        q[i] ^= sk[i];
+    }
+}
+
+static uint32_t _sub_word(uint32_t x)
+{
+    uint32_t q[8] = { x };
+
+    _ortho(q);
+    _sub_bytes(q);
+    _ortho(q);
+    return q[0];
+}
+
+static void _keysched(aes_ct_key_t *key, const uint8_t *user_key)
+{
+    static const uint8_t rcon[ROUNDS] = {
+        0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36
+    };
+    uint32_t w[4];
+
+    for (unsigned i = 0; i < 4; i++) {
+        w[i] = _dec32le(user_key + (i * 4));
+    }
+    for (unsigned round = 0; round <= ROUNDS; round++) {
+        uint32_t *sk = &key->sk[round * 8];
+
+        if (round > 0) {
+            /* words are little endian, so RotWord is a rotation by 8 */
+            w[0] ^= _sub_word(_rotr8(w[3])) ^ rcon[round - 1];
+            w[1] ^= w[0];
+            w[2] ^= w[1];
+            w[3] ^= w[2];
+        }
+        /* the same round key for both blocks */
+        for (unsigned i = 0; i < 4; i++) {
+            sk[2 * i] = sk[(2 * i) + 1] = w[i];
+        }
+        _ortho(sk);
+    }
+    memset(w, 0, sizeof(w));
+}
+
+static void _load(uint32_t *q, const uint8_t *in, size_t nblocks)
+{
+    for (unsigned i = 0; i < 4; i++) {
+        q[2 * i] = _dec32le(in + (i * 4));
+        q[(2 * i) + 1] = (nblocks > 1)
+                       ? _dec32le(in + AES_BLOCK_SIZE + (i * 4)) : 0;
+    }
+    _ortho(q);
+}
+
+static void _store(uint8_t *out, uint32_t *q, size_t nblocks)
+{
+    _ortho(q);
+    for (unsigned i = 0; i < 4; i++) {
+        _enc32le(out + (i * 4), q[2 * i]);
+        if (nblocks > 1) {
+            _enc32le(out + AES_BLOCK_SIZE + (i * 4), q[(2 * i) + 1]);
+        }
+    }
+}
+
+static void _encrypt(const aes_ct_key_t *key, uint32_t *q)
+{
+    _add_round_key(q, key->sk);
+    for (unsigned round = 1; round < ROUNDS; round++) {
+        _sub_bytes(q);
+        _shift_rows(q);
+        _mix_columns(q);
+        _add_round_key(q, &key->sk[round * 8]);
+    }
+    _sub_bytes(q);
+    _shift_rows(q);
+    _add_round_key(q, &key->sk[ROUNDS * 8]);
+}
+
+static void _decrypt(const aes_ct_key_t *key, uint32_t *q)
+{
+    _add_round_key(q, &key->sk[ROUNDS * 8]);
+    for (unsigned round = ROUNDS - 1; round > 0; round--) {
+        _inv_shift_rows(q);
+        _inv_sub_bytes(q);
+        _add_round_key(q, &key->sk[round * 8]);
+        _inv_mix_columns(q);
+    }
+    _inv_shift_rows(q);
+    _inv_sub_bytes(q);
+    _add_round_key(q, key->sk);
+}
+
+static void _process(const cipher_context_t *context, const uint8_t *in,
+                     uint8_t *out, size_t nblocks,
+                     void (*fn)(const aes_ct_key_t *, uint32_t *))
+{
+    aes_ct_key_t key;
+    uint32_t q[8];
+
+    _keysched(&key, context->context);
+    while (nblocks > 0) {
+        size_t n = (nblocks > 1) ? 2 : 1;
+
+        _load(q, in, n);
+        fn(&key, q);
+        _store(out, q, n);
+        in += n * AES_BLOCK_SIZE;
+        out += n * AES_BLOCK_SIZE;
+        nblocks -= n;
+    }
+    memset(&key, 0, sizeof(key));
+    memset(q, 0, sizeof(q));
+}
+
+int aes_init(cipher_context_t *context, const uint8_t *key, uint8_t keySize)
+{
+    /* This implementation only supports a single key size (defined in AES_KEY_SIZE) */
+    if (keySize != AES_KEY_SIZE) {
+        return CIPHER_ERR_INVALID_KEY_SIZE;
+    }
+
+    /* the context only holds the raw key, the bitsliced key schedule is
+     * expanded on every call */
+    memcpy(context->context, key, AES_KEY_SIZE);
+
+    return CIPHER_INIT_SUCCESS;
+}
+
+int aes_encrypt(const cipher_context_t *context, const uint8_t *plainBlock,
+                uint8_t *cipherBlock)
+{
+    return aes_encrypt_blocks(context, plainBlock, cipherBlock, 1);
+}
+
+int aes_encrypt_blocks(const cipher_context_t *context, const uint8_t *plain,
+                       uint8_t *cipher, size_t nblocks)
+{
+#ifdef MODULE_CRYPTO_AES_NI
+    if (aes_ni_supported()) {
+        aes_ni_encrypt_blocks(context->context, plain, cipher, nblocks);
+        return 1;
+    }
+#endif
+    _process(context, plain, cipher, nblocks, _encrypt);
+    return 1;
+}
+
+int aes_decrypt(const cipher_context_t *context, const uint8_t *cipherBlock,
+                uint8_t *plainBlock)
+{
+    return aes_decrypt_blocks(context, cipherBlock, plainBlock, 1);
+}
+
+int aes_decrypt_blocks(const cipher_context_t *context, const uint8_t *cipher,
+                       uint8_t *plain, size_t nblocks)
+{
+#ifdef MODULE_CRYPTO_AES_NI
+    if (aes_ni_supported()) {
+        aes_ni_decrypt_blocks(context->context, cipher, plain, nblocks);
+        return 1;
+    }
+#endif
+    _process(context, cipher, plain, nblocks, _decrypt);
+    return 1;
+}
+
+int aes_cbc_mac_blocks(const cipher_context_t *context, uint8_t *mac,
+                       const uint8_t *input, size_t nblocks)
+{
+#ifdef MODULE_CRYPTO_AES_NI
+    if (aes_ni_supported()) {
+        aes_ni_cbc_mac_blocks(context->context, mac, input, nblocks);
+        return 1;
+    }
+#endif
+    aes_ct_key_t key;
+    uint32_t q[8];
+
+    /* the blocks are chained, so only one lane is used */
+    _keysched(&key, context->context);
+    for (; nblocks > 0; nblocks--) {
+        for (unsigned i = 0; i < AES_BLOCK_SIZE; i++) {
+            mac[i] ^= input[i];
+        }
+        _load(q, mac, 1);
+        _encrypt(&key, q);
+        _store(mac, q, 1);
+        input += AES_BLOCK_SIZE;
+    }
+    memset(&key, 0, sizeof(key));
+    memset(q, 0, sizeof(q));
+    return 1;
+}
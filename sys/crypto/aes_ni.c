@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sys_crypto
+ * @{
+ *
+ * @file
+ * @brief       AES-128 using the x86 AES instructions
+ *
+ * The instructions run in constant time, so this is also used instead of the
+ * bitsliced code of `crypto_aes_ct` if the CPU supports them. Four blocks are
+ * encrypted in an interleaved way to hide the latency of the instructions.
+ *
+ * @}
+ */
+
+#if !defined(__i386__) && !defined(__x86_64__)
+#error "crypto_aes_ni requires an x86 CPU"
+#endif
+
+#include <string.h>
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+#include "crypto/aes.h"
+#include "aes_ni.h"
+
+#define ROUNDS          (10U)
+#define INTERLEAVE      (4U)
+
+#define AES_NI_TARGET   __attribute__((target("aes,sse2")))
+
+bool aes_ni_supported(void)
+{
+    static int has_aes_ni = -1;
+
+    if (has_aes_ni < 0) {
+        unsigned eax, ebx, ecx, edx;
+        has_aes_ni = __get_cpuid(1, &eax, &ebx, &ecx, &edx) &&
+                     (ecx & bit_AES) && (edx & bit_SSE2);
+    }
+    return has_aes_ni;
+}
+
+AES_NI_TARGET
+static inline __m128i _expand(__m128i key, __m128i assist)
+{
+    assist = _mm_shuffle_epi32(assist, 0xff);
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, assist);
+}
+
+/* the round constant has to be an immediate */
+#define EXPAND(rk, i, rcon) \
+    rk[i] = _expand(rk[i - 1], _mm_aeskeygenassist_si128(rk[i - 1], rcon))
+
+AES_NI_TARGET
+static void _keysched(__m128i *rk, const uint8_t *key)
+{
+    rk[0] = _mm_loadu_si128((const __m128i *)key);
+    EXPAND(rk, 1, 0x01);
+    EXPAND(rk, 2, 0x02);
+    EXPAND(rk, 3, 0x04);
+    EXPAND(rk, 4, 0x08);
+    EXPAND(rk, 5, 0x10);
+    EXPAND(rk, 6, 0x20);
+    EXPAND(rk, 7, 0x40);
+    EXPAND(rk, 8, 0x80);
+    EXPAND(rk, 9, 0x1b);
+    EXPAND(rk, 10, 0x36);
+}
+
+/* round keys for the equivalent inverse cipher, in the order of use */
+AES_NI_TARGET
+static void _keysched_dec(__m128i *rk, const uint8_t *key)
+{
+    __m128i enc[ROUNDS + 1];
+
+    _keysched(enc, key);
+    rk[0] = enc[ROUNDS];
+    for (unsigned i = 1; i < ROUNDS; i++) {
+        rk[i] = _mm_aesimc_si128(enc[ROUNDS - i]);
+    }
+    rk[ROUNDS] = enc[0];
+    memset(enc, 0, sizeof(enc));
+}
+
+AES_NI_TARGET
+void aes_ni_encrypt_blocks(const uint8_t *key, const uint8_t *in,
+                           uint8_t *out, size_t nblocks)
+{
+    __m128i rk[ROUNDS + 1];
+    __m128i b[INTERLEAVE];
+
+    _keysched(rk, key);
+    while (nblocks > 0) {
+        unsigned n = (nblocks < INTERLEAVE) ? nblocks : INTERLEAVE;
+
+        for (unsigned j = 0; j < n; j++) {
+            b[j] = _mm_loadu_si128((const __m128i *)&in[j * AES_BLOCK_SIZE]);
+            b[j] = _mm_xor_si128(b[j], rk[0]);
+        }
+        for (unsigned i = 1; i < ROUNDS; i++) {
+            for (unsigned j = 0; j < n; j++) {
+                b[j] = _mm_aesenc_si128(b[j], rk[i]);
+            }
+        }
+        for (unsigned j = 0; j < n; j++) {
+            b[j] = _mm_aesenclast_si128(b[j], rk[ROUNDS]);
+            _mm_storeu_si128((__m128i *)&out[j * AES_BLOCK_SIZE], b[j]);
+        }
+        in += n * AES_BLOCK_SIZE;
+        out += n * AES_BLOCK_SIZE;
+        nblocks -= n;
+    }
+    memset(rk, 0, sizeof(rk));
+    memset(b, 0, sizeof(b));
+}
+
+AES_NI_TARGET
+void aes_ni_decrypt_blocks(const uint8_t *key, const uint8_t *in,
+                           uint8_t *out, size_t nblocks)
+{
+    __m128i rk[ROUNDS + 1];
+    __m128i b[INTERLEAVE];
+
+    _keysched_dec(rk, key);
+    while (nblocks > 0) {
+        unsigned n = (nblocks < INTERLEAVE) ? nblocks : INTERLEAVE;
+
+        for (unsigned j = 0; j < n; j++) {
+            b[j] = _mm_loadu_si128((const __m128i *)&in[j * AES_BLOCK_SIZE]);
+            b[j] = _mm_xor_si128(b[j], rk[0]);
+        }
+        for (unsigned i = 1; i < ROUNDS; i++) {
+            for (unsigned j = 0; j < n; j++) {
+                b[j] = _mm_aesdec_si128(b[j], rk[i]);
+            }
+        }
+        for (unsigned j = 0; j < n; j++) {
+            b[j] = _mm_aesdeclast_si128(b[j], rk[ROUNDS]);
+            _mm_storeu_si128((__m128i *)&out[j * AES_BLOCK_SIZE], b[j]);
+        }
+        in += n * AES_BLOCK_SIZE;
+        out += n * AES_BLOCK_SIZE;
+        nblocks -= n;
+    }
+    memset(rk, 0, sizeof(rk));
+    memset(b, 0, sizeof(b));
+}
+
+AES_NI_TARGET
+void aes_ni_cbc_mac_blocks(const uint8_t *key, uint8_t *mac,
+                           const uint8_t *in, size_t nblocks)
+{
+    __m128i rk[ROUNDS + 1];
+    __m128i m = _mm_loadu_si128((const __m128i *)mac);
+
+    _keysched(rk, key);
+    /* every block depends on the previous one, nothing to interleave */
+    for (; nblocks > 0; nblocks--, in += AES_BLOCK_SIZE) {
+        m = _mm_xor_si128(m, _mm_loadu_si128((const __m128i *)in));
+        m = _mm_xor_si128(m, rk[0]);
+        for (unsigned i = 1; i < ROUNDS; i++) {
+            m = _mm_aesenc_si128(m, rk[i]);
+        }
+        m = _mm_aesenclast_si128(m, rk[ROUNDS]);
+    }
+    _mm_storeu_si128((__m128i *)mac, m);
+    memset(rk, 0, sizeof(rk));
+}
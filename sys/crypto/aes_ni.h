@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     sys_crypto
+ * @{
+ *
+ * @file
+ * @internal
+ * @brief       AES-128 using the x86 AES instructions
+ *
+ * Used by aes.c and aes_ct.c with the pseudomodule `crypto_aes_ni`, whenever
+ * the CPU reports support for the instructions.
+ */
+
+#ifndef AES_NI_H
+#define AES_NI_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Check if the CPU implements the AES instructions
+ */
+bool aes_ni_supported(void);
+
+/**
+ * @brief   Encrypt @p nblocks consecutive blocks with the 16 byte @p key
+ */
+void aes_ni_encrypt_blocks(const uint8_t *key, const uint8_t *in,
+                           uint8_t *out, size_t nblocks);
+
+/**
+ * @brief   Decrypt @p nblocks consecutive blocks with the 16 byte @p key
+ */
+void aes_ni_decrypt_blocks(const uint8_t *key, const uint8_t *in,
+                           uint8_t *out, size_t nblocks);
+
+/**
+ * @brief   Feed @p nblocks consecutive blocks into the CBC-MAC @p mac
+ */
+void aes_ni_cbc_mac_blocks(const uint8_t *key, uint8_t *mac,
+                           const uint8_t *in, size_t nblocks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AES_NI_H */
+/** @} */
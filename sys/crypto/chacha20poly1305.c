@@ -52,110 +52,226 @@ static uint32_t u8to32(const uint8_t *p)
 }
 
 /* Single round */
-void _r(uint32_t *a, uint32_t *b, uint32_t *d, unsigned c)
+static void _r(uint32_t *a, uint32_t *b, uint32_t *d, unsigned c)
 {
     *a += *b;
     uint32_t tmp = *a ^ *d;
     *d = (tmp << c) | (tmp >> (32 - c));
 }
 
-void _add_initial(chacha20poly1305_ctx_t *ctx, const uint8_t *key,
-                  const uint8_t *nonce, uint32_t blk)
+static void _add_initial(uint32_t *state, const uint8_t *key,
+                         const uint8_t *nonce, uint32_t blk)
 {
     for (unsigned i = 0; i < 4; i++) {
-        ctx->state[i] += constant[i];
+        state[i] += constant[i];
     }
     for (unsigned i = 0; i < 8; i++) {
-        ctx->state[i+4] += u8to32(key + 4*i);
+        state[i+4] += u8to32(key + 4*i);
     }
-    ctx->state[12] += u8to32((uint8_t*)&blk);
-    ctx->state[13] += u8to32(nonce);
-    ctx->state[14] += u8to32(nonce+4);
-    ctx->state[15] += u8to32(nonce+8);
+    state[12] += u8to32((uint8_t*)&blk);
+    state[13] += u8to32(nonce);
+    state[14] += u8to32(nonce+4);
+    state[15] += u8to32(nonce+8);
 }
 
-void _keystream(chacha20poly1305_ctx_t *ctx, const uint8_t *key,
-                const uint8_t *nonce, uint32_t blk)
+static void _keystream(uint32_t *state, const uint8_t *key,
+                       const uint8_t *nonce, uint32_t blk)
 {
     /* Initialize block state */
-    memset(ctx->state, 0, sizeof(ctx->state));
-    _add_initial(ctx, key, nonce, blk);
+    memset(state, 0, 16 * sizeof(uint32_t));
+    _add_initial(state, key, nonce, blk);
 
     /* perform rounds */
     for (unsigned i = 0; i < 80; ++i) {
-        uint32_t *a = &ctx->state[((i                    ) & 3)          ];
-        uint32_t *b = &ctx->state[((i + ((i & 4) ? 1 : 0)) & 3) + (4 * 1)];
-        uint32_t *c = &ctx->state[((i + ((i & 4) ? 2 : 0)) & 3) + (4 * 2)];
-        uint32_t *d = &ctx->state[((i + ((i & 4) ? 3 : 0)) & 3) + (4 * 3)];
+        uint32_t *a = &state[((i                    ) & 3)          ];
+        uint32_t *b = &state[((i + ((i & 4) ? 1 : 0)) & 3) + (4 * 1)];
+        uint32_t *c = &state[((i + ((i & 4) ? 2 : 0)) & 3) + (4 * 2)];
+        uint32_t *d = &state[((i + ((i & 4) ? 3 : 0)) & 3) + (4 * 3)];
         _r(a, b, d, 16);
         _r(c, d, b, 12);
         _r(a, b, d, 8);
         _r(c, d, b, 7);
     }
     /* add initial state */
-    _add_initial(ctx, key, nonce, blk);
+    _add_initial(state, key, nonce, blk);
 }
 
-void _xcrypt(chacha20poly1305_ctx_t *ctx, const uint8_t *key,
-              const uint8_t *nonce, const uint8_t *in, uint8_t *out, size_t len)
+#ifdef MODULE_CRYPTO_CHACHA20POLY1305_SIMD
+/* One lane per block, the compiler maps this to SSE/AVX/NEON registers where
+ * available and to plain 32 bit operations otherwise */
+typedef uint32_t _vec_t __attribute__((vector_size(4 * CHACHA20POLY1305_SIMD_BLOCKS)));
+
+#define _VROTL(v, c)    (((v) << (c)) | ((v) >> (32 - (c))))
+
+static inline void _vqr(_vec_t *x, unsigned a, unsigned b, unsigned c,
+                        unsigned d)
+{
+    x[a] += x[b]; x[d] ^= x[a]; x[d] = _VROTL(x[d], 16);
+    x[c] += x[d]; x[b] ^= x[c]; x[b] = _VROTL(x[b], 12);
+    x[a] += x[b]; x[d] ^= x[a]; x[d] = _VROTL(x[d], 8);
+    x[c] += x[d]; x[b] ^= x[c]; x[b] = _VROTL(x[b], 7);
+}
+
+/* Generate CHACHA20POLY1305_SIMD_BLOCKS consecutive keystream blocks at once */
+static void _keystream_blocks(uint32_t *out, const uint8_t *key,
+                              const uint8_t *nonce, uint32_t blk)
 {
-    /* Number of full 64 byte blocks */
-    const size_t num_blocks = len >> 6;
-    size_t pos = 0;
-    /* xcrypt full blocks */
-    for (size_t i = 0; i < num_blocks; i++, pos += 64) {
-        _keystream(ctx, key, nonce, i+1);
-        for (size_t j = 0; j < 64; j++) {
-            out[pos+j] = in[pos+j] ^ ((uint8_t*)ctx->state)[j];
+    _vec_t init[16];
+    _vec_t x[16];
+
+    for (unsigned i = 0; i < 4; i++) {
+        init[i] = (_vec_t){ 0 } + constant[i];
+    }
+    for (unsigned i = 0; i < 8; i++) {
+        init[i + 4] = (_vec_t){ 0 } + u8to32(key + 4 * i);
+    }
+    for (unsigned j = 0; j < CHACHA20POLY1305_SIMD_BLOCKS; j++) {
+        init[12][j] = blk + j;
+    }
+    for (unsigned i = 0; i < 3; i++) {
+        init[i + 13] = (_vec_t){ 0 } + u8to32(nonce + 4 * i);
+    }
+
+    memcpy(x, init, sizeof(x));
+    for (unsigned i = 0; i < 10; i++) {
+        /* column rounds */
+        _vqr(x, 0, 4,  8, 12);
+        _vqr(x, 1, 5,  9, 13);
+        _vqr(x, 2, 6, 10, 14);
+        _vqr(x, 3, 7, 11, 15);
+        /* diagonal rounds */
+        _vqr(x, 0, 5, 10, 15);
+        _vqr(x, 1, 6, 11, 12);
+        _vqr(x, 2, 7,  8, 13);
+        _vqr(x, 3, 4,  9, 14);
+    }
+
+    /* add initial state and transpose lanes into consecutive blocks */
+    for (unsigned i = 0; i < 16; i++) {
+        x[i] += init[i];
+        for (unsigned j = 0; j < CHACHA20POLY1305_SIMD_BLOCKS; j++) {
+            out[16 * j + i] = x[i][j];
         }
     }
-    /* xcrypt remaining bytes */
-    if (len - pos) {
-        _keystream(ctx, key, nonce, num_blocks+1);
-        for (size_t j = 0; j < len - pos; j++) {
-            out[pos+j] = in[pos+j] ^ ((uint8_t*)ctx->state)[j];
+    crypto_secure_wipe(x, sizeof(x));
+}
+#define KEYSTREAM_BLOCKS    CHACHA20POLY1305_SIMD_BLOCKS
+#else
+#define _keystream_blocks   _keystream
+#define KEYSTREAM_BLOCKS    (1U)
+#endif
+
+/* En-/decryption state carried across the parts of a message */
+typedef struct {
+    uint32_t ks[16 * KEYSTREAM_BLOCKS];     /* buffered keystream */
+    const uint8_t *key;
+    const uint8_t *nonce;
+    uint32_t blk;                           /* counter of the next block */
+    size_t pos;                             /* consumed bytes of ks */
+} _xcrypt_ctx_t;
+
+static void _xcrypt_init(_xcrypt_ctx_t *xctx, const uint8_t *key,
+                         const uint8_t *nonce)
+{
+    xctx->key = key;
+    xctx->nonce = nonce;
+    /* block 0 is used for the poly1305 key */
+    xctx->blk = 1;
+    xctx->pos = sizeof(xctx->ks);
+}
+
+static void _xcrypt(_xcrypt_ctx_t *xctx, const uint8_t *in, uint8_t *out,
+                    size_t len)
+{
+    while (len) {
+        if (xctx->pos == sizeof(xctx->ks)) {
+            _keystream_blocks(xctx->ks, xctx->key, xctx->nonce, xctx->blk);
+            xctx->blk += KEYSTREAM_BLOCKS;
+            xctx->pos = 0;
+        }
+        size_t n = sizeof(xctx->ks) - xctx->pos;
+        if (n > len) {
+            n = len;
         }
+        const uint8_t *ks = (uint8_t *)xctx->ks + xctx->pos;
+        for (size_t j = 0; j < n; j++) {
+            out[j] = in[j] ^ ks[j];
+        }
+        xctx->pos += n;
+        in += n;
+        out += n;
+        len -= n;
     }
 }
 
-void _poly1305_padded(poly1305_ctx_t *pctx, const uint8_t *data, size_t len)
+static void _poly1305_padded(poly1305_ctx_t *pctx, const uint8_t *data, size_t len)
 {
     poly1305_update(pctx, data, len);
     const size_t padlen = (16 - len) & 0xF;
     poly1305_update(pctx, padding, padlen);
 }
 
-/* Generate a poly1305 tag */
-void _poly1305_gentag(uint8_t *mac, const uint8_t *key, const uint8_t *nonce,
-                      const uint8_t *cipher, size_t cipherlen,
-                      const uint8_t *aad, size_t aadlen)
+static void _poly1305_start(poly1305_ctx_t *pctx, const uint8_t *key,
+                            const uint8_t *nonce)
 {
-    chacha20poly1305_ctx_t ctx;
+    uint32_t state[16];
     /* generate one time key */
-    _keystream(&ctx, key, nonce, 0);
-    poly1305_init(&ctx.poly, (uint8_t*)ctx.state);
-    /* Add aad */
-    _poly1305_padded(&ctx.poly, aad, aadlen);
-    /* Add ciphertext */
-    _poly1305_padded(&ctx.poly, cipher, cipherlen);
+    _keystream(state, key, nonce, 0);
+    poly1305_init(pctx, (uint8_t*)state);
+    crypto_secure_wipe(state, sizeof(state));
+}
+
+static void _poly1305_finish(poly1305_ctx_t *pctx, uint8_t *mac,
+                             size_t cipherlen, size_t aadlen)
+{
+    /* Add padding of the ciphertext */
+    poly1305_update(pctx, padding, (16 - cipherlen) & 0xF);
     /* Add aad length */
     const uint64_t lengths[2] = {aadlen, cipherlen};
-    poly1305_update(&ctx.poly, (uint8_t*)lengths, sizeof(lengths));
-    poly1305_finish(&ctx.poly, mac);
-    crypto_secure_wipe(&ctx, sizeof(ctx));
+    poly1305_update(pctx, (uint8_t*)lengths, sizeof(lengths));
+    poly1305_finish(pctx, mac);
+    crypto_secure_wipe(pctx, sizeof(*pctx));
+}
+
+/* Generate a poly1305 tag */
+static void _poly1305_gentag(uint8_t *mac, const uint8_t *key,
+                             const uint8_t *nonce,
+                             const uint8_t *cipher, size_t cipherlen,
+                             const uint8_t *aad, size_t aadlen)
+{
+    poly1305_ctx_t pctx;
+    _poly1305_start(&pctx, key, nonce);
+    /* Add aad */
+    _poly1305_padded(&pctx, aad, aadlen);
+    /* Add ciphertext */
+    poly1305_update(&pctx, cipher, cipherlen);
+    _poly1305_finish(&pctx, mac, cipherlen, aadlen);
+}
+
+/* Add all parts of the aad to the tag, returns the total aad length */
+static size_t _poly1305_aad_iolist(poly1305_ctx_t *pctx, const iolist_t *aad)
+{
+    size_t aadlen = 0;
+    for (; aad; aad = aad->iol_next) {
+        poly1305_update(pctx, aad->iol_base, aad->iol_len);
+        aadlen += aad->iol_len;
+    }
+    poly1305_update(pctx, padding, (16 - aadlen) & 0xF);
+    return aadlen;
 }
 
 void chacha20poly1305_encrypt(uint8_t *cipher, const uint8_t *msg,
                               size_t msglen, const uint8_t *aad, size_t aadlen,
                               const uint8_t *key, const uint8_t *nonce)
 {
-    chacha20poly1305_ctx_t ctx;
-    _xcrypt(&ctx, key, nonce, msg, cipher, msglen);
-    crypto_secure_wipe(&ctx, sizeof(ctx));
+    _xcrypt_ctx_t xctx;
+    _xcrypt_init(&xctx, key, nonce);
+    _xcrypt(&xctx, msg, cipher, msglen);
+    /* Wipe structures */
+    crypto_secure_wipe(&xctx, sizeof(xctx));
     /* Generate tag */
     _poly1305_gentag(&cipher[msglen], key, nonce,
                     cipher, msglen, aad, aadlen);
-    /* Wipe structures */
 }
 
 int chacha20poly1305_decrypt(const uint8_t *cipher, size_t cipherlen,
@@ -170,8 +286,61 @@ int chacha20poly1305_decrypt(const uint8_t *cipher, size_t cipherlen,
     if (crypto_equals(cipher+*msglen, mac, CHACHA20POLY1305_TAG_BYTES) == 0) {
         return 0;
     }
-    chacha20poly1305_ctx_t ctx;
-    /* Number of full blocks */
-    _xcrypt(&ctx, key, nonce, cipher, msg, *msglen);
+    _xcrypt_ctx_t xctx;
+    _xcrypt_init(&xctx, key, nonce);
+    _xcrypt(&xctx, cipher, msg, *msglen);
+    crypto_secure_wipe(&xctx, sizeof(xctx));
+    return 1;
+}
+
+void chacha20poly1305_encrypt_iolist(iolist_t *data, const iolist_t *aad,
+                                     uint8_t *tag, const uint8_t *key,
+                                     const uint8_t *nonce)
+{
+    poly1305_ctx_t pctx;
+    _xcrypt_ctx_t xctx;
+    size_t cipherlen = 0;
+
+    _poly1305_start(&pctx, key, nonce);
+    size_t aadlen = _poly1305_aad_iolist(&pctx, aad);
+
+    /* encrypt and authenticate each part while it is still in cache */
+    _xcrypt_init(&xctx, key, nonce);
+    for (; data; data = data->iol_next) {
+        _xcrypt(&xctx, data->iol_base, data->iol_base, data->iol_len);
+        poly1305_update(&pctx, data->iol_base, data->iol_len);
+        cipherlen += data->iol_len;
+    }
+    crypto_secure_wipe(&xctx, sizeof(xctx));
+
+    _poly1305_finish(&pctx, tag, cipherlen, aadlen);
+}
+
+int chacha20poly1305_decrypt_iolist(iolist_t *data, const iolist_t *aad,
+                                    const uint8_t *tag, const uint8_t *key,
+                                    const uint8_t *nonce)
+{
+    poly1305_ctx_t pctx;
+    size_t cipherlen = 0;
+    uint8_t mac[16];
+
+    /* the tag has to be verified before touching the ciphertext */
+    _poly1305_start(&pctx, key, nonce);
+    size_t aadlen = _poly1305_aad_iolist(&pctx, aad);
+    for (const iolist_t *iol = data; iol; iol = iol->iol_next) {
+        poly1305_update(&pctx, iol->iol_base, iol->iol_len);
+        cipherlen += iol->iol_len;
+    }
+    _poly1305_finish(&pctx, mac, cipherlen, aadlen);
+    if (crypto_equals(tag, mac, CHACHA20POLY1305_TAG_BYTES) == 0) {
+        return 0;
+    }
+
+    _xcrypt_ctx_t xctx;
+    _xcrypt_init(&xctx, key, nonce);
+    for (; data; data = data->iol_next) {
+        _xcrypt(&xctx, data->iol_base, data->iol_base, data->iol_len);
+    }
+    crypto_secure_wipe(&xctx, sizeof(xctx));
     return 1;
 }
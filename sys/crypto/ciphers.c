@@ -46,6 +46,70 @@ int cipher_decrypt(const cipher_t *cipher, const uint8_t *input,
 }
 
 
+int cipher_encrypt_blocks(const cipher_t *cipher, const uint8_t *input,
+                          uint8_t *output, size_t nblocks)
+{
+    if (cipher->interface->encrypt_blocks) {
+        return cipher->interface->encrypt_blocks(&cipher->context, input,
+                                                 output, nblocks);
+    }
+
+    uint8_t block_size = cipher->interface->block_size;
+    for (size_t i = 0; i < nblocks; i++) {
+        int res = cipher->interface->encrypt(&cipher->context,
+                                             &input[i * block_size],
+                                             &output[i * block_size]);
+        if (res != 1) {
+            return res;
+        }
+    }
+    return 1;
+}
+
+
+int cipher_decrypt_blocks(const cipher_t *cipher, const uint8_t *input,
+                          uint8_t *output, size_t nblocks)
+{
+    if (cipher->interface->decrypt_blocks) {
+        return cipher->interface->decrypt_blocks(&cipher->context, input,
+                                                 output, nblocks);
+    }
+
+    uint8_t block_size = cipher->interface->block_size;
+    for (size_t i = 0; i < nblocks; i++) {
+        int res = cipher->interface->decrypt(&cipher->context,
+                                             &input[i * block_size],
+                                             &output[i * block_size]);
+        if (res != 1) {
+            return res;
+        }
+    }
+    return 1;
+}
+
+
+int cipher_cbc_mac_blocks(const cipher_t *cipher, uint8_t *mac,
+                          const uint8_t *input, size_t nblocks)
+{
+    if (cipher->interface->cbc_mac_blocks) {
+        return cipher->interface->cbc_mac_blocks(&cipher->context, mac,
+                                                 input, nblocks);
+    }
+
+    uint8_t block_size = cipher->interface->block_size;
+    for (size_t i = 0; i < nblocks; i++) {
+        for (unsigned j = 0; j < block_size; j++) {
+            mac[j] ^= input[i * block_size + j];
+        }
+        int res = cipher->interface->encrypt(&cipher->context, mac, mac);
+        if (res != 1) {
+            return res;
+        }
+    }
+    return 1;
+}
+
+
 int cipher_get_block_size(const cipher_t *cipher)
 {
     return cipher->interface->block_size;
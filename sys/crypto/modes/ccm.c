@@ -37,34 +37,36 @@ static inline int min(int a, int b)
 static int ccm_compute_cbc_mac(cipher_t *cipher, const uint8_t iv[16],
                         const uint8_t *input, size_t length, uint8_t *mac)
 {
-    uint8_t block_size, mac_enc[16] = { 0 };
-    uint32_t offset;
+    uint8_t block_size;
+    size_t nblocks, offset;
 
     block_size = cipher_get_block_size(cipher);
     memmove(mac, iv, 16);
-    offset = 0;
 
     /* no input message */
     if(length == 0) {
         return 0;
     }
 
-    do {
-        uint8_t block_size_input = (length - offset > block_size) ?
-                                   block_size : length - offset;
+    /* all complete blocks in one call, so the cipher sets up the key once */
+    nblocks = length / block_size;
+    if ((nblocks > 0) &&
+        (cipher_cbc_mac_blocks(cipher, mac, input, nblocks) != 1)) {
+        return CIPHER_ERR_ENC_FAILED;
+    }
+    offset = nblocks * block_size;
 
-        /* CBC-Mode: XOR plaintext with ciphertext of (n-1)-th block */
-        for (int i = 0; i < block_size_input; ++i) {
+    /* the last block is padded with zeros */
+    if (offset < length) {
+        for (unsigned i = 0; i < length - offset; ++i) {
             mac[i] ^= input[offset + i];
         }
 
-        if (cipher_encrypt(cipher, mac, mac_enc) != 1) {
+        if (cipher_encrypt(cipher, mac, mac) != 1) {
             return CIPHER_ERR_ENC_FAILED;
         }
-
-        memcpy(mac, mac_enc, block_size);
-        offset += block_size_input;
-    } while (offset < length);
+        offset = length;
+    }
 
     return offset;
 }
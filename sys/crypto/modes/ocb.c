@@ -77,32 +77,38 @@ static void xor_block(uint8_t block1[16], uint8_t block2[16],
     }
 }
 
-static void processBlock(ocb_state_t *state, size_t blockNumber,
-                         uint8_t input[16], uint8_t output[16], uint8_t mode)
+static void process_blocks(ocb_state_t *state, size_t first_block,
+                           uint8_t *input, uint8_t *output, size_t nblocks,
+                           uint8_t mode)
 {
-    /* Offset_i = Offset_{i-1} xor L_{ntz(i)} */
-    uint8_t l_i[16];
-
-    calculate_l_i(state->l_zero, ntz(blockNumber + 1), l_i);
-    xor_block(state->offset, l_i, state->offset);
-    /* Sum_i = Sum_{i-1} xor ENCIPHER(K, A_i xor Offset_i) */
-    uint8_t cipher_output[16], cipher_input[16];
-    xor_block(input, state->offset, cipher_input);
-    if (mode == OCB_MODE_ENCRYPT) {
-        state->cipher->interface->encrypt(&(state->cipher->context),
-                                          cipher_input, cipher_output);
-    }
-    else if (mode == OCB_MODE_DECRYPT) {
-        state->cipher->interface->decrypt(&(state->cipher->context),
-                                          cipher_input, cipher_output);
+    uint8_t offsets[CIPHER_BATCH_BLOCKS][16];
+    uint8_t buf[CIPHER_BATCH_BLOCKS * 16];
+
+    for (size_t i = 0; i < nblocks; ++i) {
+        /* Offset_i = Offset_{i-1} xor L_{ntz(i)} */
+        uint8_t l_i[16];
+        calculate_l_i(state->l_zero, ntz(first_block + i + 1), l_i);
+        xor_block(state->offset, l_i, state->offset);
+        memcpy(offsets[i], state->offset, 16);
+        xor_block(&input[i * 16], offsets[i], &buf[i * 16]);
     }
-    xor_block(state->offset, cipher_output, output);
-    /* Checksum_i = Checksum_{i-1} xor P_i */
+    /* the offsets only depend on the block number, so all blocks can be
+     * passed to the cipher at once */
     if (mode == OCB_MODE_ENCRYPT) {
-        xor_block(state->checksum, input, state->checksum);
+        cipher_encrypt_blocks(state->cipher, buf, buf, nblocks);
     }
     else if (mode == OCB_MODE_DECRYPT) {
-        xor_block(state->checksum, output, state->checksum);
+        cipher_decrypt_blocks(state->cipher, buf, buf, nblocks);
+    }
+    for (size_t i = 0; i < nblocks; ++i) {
+        /* Checksum_i = Checksum_{i-1} xor P_i */
+        if (mode == OCB_MODE_ENCRYPT) {
+            xor_block(state->checksum, &input[i * 16], state->checksum);
+        }
+        xor_block(offsets[i], &buf[i * 16], &output[i * 16]);
+        if (mode == OCB_MODE_DECRYPT) {
+            xor_block(state->checksum, &output[i * 16], state->checksum);
+        }
     }
 }
 
@@ -118,19 +124,24 @@ static void hash(ocb_state_t *state, uint8_t *data, size_t data_len,
     /* Offset_0 = zeros(128) */
     uint8_t offset[16];
     memset(offset, 0, 16);
-    for (size_t i = 0; i < m; ++i) {
-        /* Offset_i = Offset_{i-1} xor L_{ntz(i)} */
-        uint8_t l_i[16];
-        calculate_l_i(state->l_zero, ntz(i + 1), l_i);
-        xor_block(offset, l_i, offset);
+    for (size_t i = 0; i < m;) {
+        uint8_t buf[CIPHER_BATCH_BLOCKS * 16];
+        size_t nblocks = (m - i < CIPHER_BATCH_BLOCKS) ? m - i : CIPHER_BATCH_BLOCKS;
+        for (size_t n = 0; n < nblocks; ++n) {
+            /* Offset_i = Offset_{i-1} xor L_{ntz(i)} */
+            uint8_t l_i[16];
+            calculate_l_i(state->l_zero, ntz(i + n + 1), l_i);
+            xor_block(offset, l_i, offset);
+            /* CipherInput_i = A_i xor Offset_i */
+            xor_block(data, offset, &buf[n * 16]);
+            data += 16;
+        }
         /* Sum_i = Sum_{i-1} xor ENCIPHER(K, A_i xor Offset_i) */
-        uint8_t enciphered_block[16], cipher_input[16];
-        xor_block(data, offset, cipher_input);
-        state->cipher->interface->encrypt(&(state->cipher->context),
-                                          cipher_input, enciphered_block);
-        xor_block(output, enciphered_block, output);
-
-        data += 16;
+        cipher_encrypt_blocks(state->cipher, buf, buf, nblocks);
+        for (size_t n = 0; n < nblocks; ++n) {
+            xor_block(output, &buf[n * 16], output);
+        }
+        i += nblocks;
     }
     if (remaining_data_len > 0) {
         /* Offset_* = Offset_m xor L_* */
@@ -235,10 +246,12 @@ static int32_t run_ocb(cipher_t *cipher, uint8_t *auth_data,
 
     /* Process any whole blocks */
     size_t output_pos = 0;
-    for (size_t i = 0; i < m; ++i) {
-        processBlock(&state, i, input, output + output_pos, mode);
-        output_pos += 16;
-        input += 16;
+    for (size_t i = 0; i < m;) {
+        size_t nblocks = (m - i < CIPHER_BATCH_BLOCKS) ? m - i : CIPHER_BATCH_BLOCKS;
+        process_blocks(&state, i, input, output + output_pos, nblocks, mode);
+        output_pos += 16 * nblocks;
+        input += 16 * nblocks;
+        i += nblocks;
     }
 
     /* Process any final partial block and compute raw tag */
@@ -22,7 +22,8 @@
  */
 
 #include <assert.h>
-
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <string.h>
 
 #include "event.h"
@@ -33,41 +34,155 @@
 #include "xtimer.h"
 #endif
 
+/*
+ * Posting is lock-free: producers (threads or ISRs) atomically mark an event
+ * as queued by swapping its list_node.next from NULL to non-NULL, then push it
+ * onto the queue's `pending` LIFO using compare-and-swap. The consumer side
+ * (with IRQs disabled, so there is only ever one consumer at a time) takes the
+ * whole LIFO with a single exchange, reverses it and appends it to the
+ * event_list clist, from which events are popped in FIFO order.
+ *
+ * Wakeup protocol: a producer publishes the event *before* loading the
+ * waiter, while a claiming thread stores the waiter *before* checking the
+ * queue. With sequentially consistent ordering on both sides, either the
+ * producer sees the new waiter and sets the thread flag, or the claiming
+ * thread sees the event and sets the flag itself.
+ */
+
+/* terminates the pending LIFO, so every queued event has a non-NULL next */
+static clist_node_t _pending_end;
+
+/* clist_node_t is shared with the clist API and can not be declared atomic,
+ * the queued mark in the list node of an event is accessed through this type
+ * of the same layout */
+typedef _Atomic(clist_node_t *) _atomic_node_t;
+
+static_assert(sizeof(_atomic_node_t) == sizeof(clist_node_t *),
+              "atomic pointers must have the layout of plain pointers");
+
+static inline _atomic_node_t *_mark(event_t *event)
+{
+    return (_atomic_node_t *)&event->list_node.next;
+}
+
+static inline bool _is_empty(event_queue_t *queue)
+{
+    return (atomic_load(&queue->pending) == NULL) &&
+           (queue->event_list.next == NULL);
+}
+
+/* must be called with IRQs disabled */
+static void _drain(event_queue_t *queue)
+{
+    clist_node_t *node = atomic_exchange(&queue->pending, NULL);
+    if (node == NULL) {
+        return;
+    }
+
+    /* pending is LIFO, reverse it to restore posting order */
+    clist_node_t *fifo = &_pending_end;
+    while (node != &_pending_end) {
+        clist_node_t *next = node->next;
+        node->next = fifo;
+        fifo = node;
+        node = next;
+    }
+
+    while (fifo != &_pending_end) {
+        clist_node_t *next = fifo->next;
+        clist_rpush(&queue->event_list, fifo);
+        fifo = next;
+    }
+}
+
+/* marks an event as no longer queued, so it can be posted again */
+static inline void _unmark(event_t *event)
+{
+    atomic_store_explicit(_mark(event), NULL, memory_order_release);
+}
+
+/* must be called with IRQs disabled */
+static event_t *_pop(event_queue_t *queue)
+{
+    _drain(queue);
+    event_t *result = (event_t *)clist_lpop(&queue->event_list);
+    if (result) {
+        _unmark(result);
+    }
+    return result;
+}
+
 void event_queue_init_detached(event_queue_t *queue)
 {
     assert(queue);
     memset(queue, '\0', sizeof(*queue));
 }
 
+void event_queues_init_detached(event_queue_t *queues, size_t n_queues)
+{
+    assert(queues && n_queues);
+    memset(queues, '\0', sizeof(*queues) * n_queues);
+}
+
 void event_queue_init(event_queue_t *queue)
 {
-    assert(queue);
-    memset(queue, '\0', sizeof(*queue));
-    queue->waiter = (thread_t *)sched_active_thread;
+    event_queues_init(queue, 1);
+}
+
+void event_queues_init(event_queue_t *queues, size_t n_queues)
+{
+    event_queues_init_detached(queues, n_queues);
+    for (size_t i = 0; i < n_queues; i++) {
+        atomic_init(&queues[i].waiter, (thread_t *)sched_active_thread);
+    }
 }
 
 void event_queue_claim(event_queue_t *queue)
 {
-    assert(queue && (queue->waiter == NULL));
-    queue->waiter = (thread_t *)sched_active_thread;
+    event_queues_claim(queue, 1);
+}
+
+void event_queues_claim(event_queue_t *queues, size_t n_queues)
+{
+    assert(queues && n_queues);
+    thread_t *me = (thread_t *)sched_active_thread;
+    bool notify = false;
+
+    for (size_t i = 0; i < n_queues; i++) {
+        assert(queues[i].waiter == NULL);
+        atomic_store(&queues[i].waiter, me);
+        /* events posted before we became the waiter did not set our flag */
+        notify |= !_is_empty(&queues[i]);
+    }
+
+    if (notify) {
+        thread_flags_set(me, THREAD_FLAG_EVENT);
+    }
 }
 
 void event_post(event_queue_t *queue, event_t *event)
 {
     assert(queue && event);
 
-    unsigned state = irq_disable();
-    if (!event->list_node.next) {
-        clist_rpush(&queue->event_list, &event->list_node);
+    /* mark event as queued, reposting a queued event ends here */
+    clist_node_t *expected = NULL;
+    if (!atomic_compare_exchange_strong_explicit(_mark(event), &expected,
+                                                 &_pending_end,
+                                                 memory_order_acquire,
+                                                 memory_order_relaxed)) {
+        return;
     }
-    thread_t *waiter = queue->waiter;
-    irq_restore(state);
 
-    /* WARNING: there is a minimal chance, that a waiter claims a formerly
-     *          detached queue between the end of the critical section above and
-     *          the block below. In that case, the new waiter will not be woken
-     *          up. This should be fixed at some point once it is safe to call
-     *          thread_flags_set() inside a critical section on all platforms. */
+    clist_node_t *head = atomic_load_explicit(&queue->pending,
+                                              memory_order_relaxed);
+    do {
+        event->list_node.next = head ? head : &_pending_end;
+    } while (!atomic_compare_exchange_weak_explicit(&queue->pending, &head,
+                                                    &event->list_node,
+                                                    memory_order_seq_cst,
+                                                    memory_order_relaxed));
+
+    thread_t *waiter = atomic_load(&queue->waiter);
     if (waiter) {
         thread_flags_set(waiter, THREAD_FLAG_EVENT);
     }
@@ -79,38 +194,48 @@ void event_cancel(event_queue_t *queue, event_t *event)
     assert(event);
 
     unsigned state = irq_disable();
-    clist_remove(&queue->event_list, &event->list_node);
-    event->list_node.next = NULL;
+    _drain(queue);
+    /* an event that is marked, but not yet pushed by a preempted producer
+     * stays marked, that post completes after the cancellation */
+    if (clist_remove(&queue->event_list, &event->list_node)) {
+        _unmark(event);
+    }
     irq_restore(state);
 }
 
 event_t *event_get(event_queue_t *queue)
 {
     unsigned state = irq_disable();
-    event_t *result = (event_t *) clist_lpop(&queue->event_list);
+    event_t *result = _pop(queue);
     irq_restore(state);
 
-    if (result) {
-        result->list_node.next = NULL;
-    }
     return result;
 }
 
 event_t *event_wait(event_queue_t *queue)
 {
-    assert(queue);
-    event_t *result;
+    return event_wait_multi(queue, 1);
+}
+
+event_t *event_wait_multi(event_queue_t *queues, size_t n_queues)
+{
+    assert(queues && n_queues);
+    event_t *result = NULL;
 
     do {
         unsigned state = irq_disable();
-        result = (event_t *)clist_lpop(&queue->event_list);
+        for (size_t i = 0; i < n_queues; i++) {
+            result = _pop(&queues[i]);
+            if (result) {
+                break;
+            }
+        }
         irq_restore(state);
         if (result == NULL) {
             thread_flags_wait_any(THREAD_FLAG_EVENT);
         }
     } while (result == NULL);
 
-    result->list_node.next = NULL;
     return result;
 }
 
@@ -160,3 +285,12 @@ void event_loop(event_queue_t *queue)
         event->handler(event);
     }
 }
+
+void event_loop_multi(event_queue_t *queues, size_t n_queues)
+{
+    event_t *event;
+
+    while ((event = event_wait_multi(queues, n_queues))) {
+        event->handler(event);
+    }
+}
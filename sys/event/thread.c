@@ -34,6 +34,17 @@ static void *_handler(void *event_queue)
     return NULL;
 }
 
+static void *_handler_multi(void *arg)
+{
+    const event_thread_multi_t *multi = arg;
+
+    event_queues_claim(multi->queues, multi->n_queues);
+    event_loop_multi(multi->queues, multi->n_queues);
+
+    /* should be never reached */
+    return NULL;
+}
+
 void event_thread_init(event_queue_t *queue, char *stack, size_t stack_size,
                        unsigned priority)
 {
@@ -48,6 +59,17 @@ void event_thread_init(event_queue_t *queue, char *stack, size_t stack_size,
     thread_create(stack, stack_size, priority, 0, _handler, queue, "event");
 }
 
+void event_thread_init_multi(const event_thread_multi_t *multi,
+                             char *stack, size_t stack_size,
+                             unsigned priority)
+{
+    /* see event_thread_init() */
+    event_queues_init_detached(multi->queues, multi->n_queues);
+
+    thread_create(stack, stack_size, priority, 0, _handler_multi,
+                  (void *)multi, "event");
+}
+
 #ifndef EVENT_THREAD_STACKSIZE_DEFAULT
 # ifdef ISR_STACKSIZE
 #  define EVENT_THREAD_STACKSIZE_DEFAULT ISR_STACKSIZE
@@ -78,18 +100,51 @@ void event_thread_init(event_queue_t *queue, char *stack, size_t stack_size,
 #define EVENT_THREAD_LOWEST_PRIO   (THREAD_PRIORITY_IDLE - 1)
 #endif
 
+#if defined(MODULE_EVENT_THREAD_HIGHEST) || \
+    defined(MODULE_EVENT_THREAD_MEDIUM) || \
+    defined(MODULE_EVENT_THREAD_LOWEST)
+#define HAS_EVENT_THREAD_QUEUES
+event_queue_t event_thread_queues[EVENT_QUEUE_PRIO_NUMOF];
+#endif
+
+#ifdef MODULE_EVENT_THREAD_SINGLE
+
+#ifndef EVENT_THREAD_STACKSIZE
+#define EVENT_THREAD_STACKSIZE  EVENT_THREAD_STACKSIZE_DEFAULT
+#endif
+/* not the highest priority: the handlers of all queues run at this
+ * priority, including those only meant to run when nothing else does */
+#ifndef EVENT_THREAD_PRIO
+#define EVENT_THREAD_PRIO       EVENT_THREAD_MEDIUM_PRIO
+#endif
+
+#ifdef HAS_EVENT_THREAD_QUEUES
+static char _evq_stack[EVENT_THREAD_STACKSIZE];
+static const event_thread_multi_t _evq_multi = {
+    .queues = event_thread_queues,
+    .n_queues = EVENT_QUEUE_PRIO_NUMOF,
+};
+#endif
+
+void auto_init_event_thread(void)
+{
+#ifdef HAS_EVENT_THREAD_QUEUES
+    event_thread_init_multi(&_evq_multi, _evq_stack, sizeof(_evq_stack),
+                            EVENT_THREAD_PRIO);
+#endif
+}
+
+#else /* MODULE_EVENT_THREAD_SINGLE */
+
 #ifdef MODULE_EVENT_THREAD_HIGHEST
-event_queue_t event_queue_highest;
 static char _evq_highest_stack[EVENT_THREAD_HIGHEST_STACKSIZE];
 #endif
 
 #ifdef MODULE_EVENT_THREAD_MEDIUM
-event_queue_t event_queue_medium;
 static char _evq_medium_stack[EVENT_THREAD_MEDIUM_STACKSIZE];
 #endif
 
 #ifdef MODULE_EVENT_THREAD_LOWEST
-event_queue_t event_queue_lowest;
 static char _evq_lowest_stack[EVENT_THREAD_LOWEST_STACKSIZE];
 #endif
 
@@ -102,15 +157,15 @@ typedef struct {
 
 const event_threads_t _event_threads[] = {
 #ifdef MODULE_EVENT_THREAD_HIGHEST
-    { &event_queue_highest, _evq_highest_stack, sizeof(_evq_highest_stack),
+    { EVENT_PRIO_HIGHEST, _evq_highest_stack, sizeof(_evq_highest_stack),
         EVENT_THREAD_HIGHEST_PRIO },
 #endif
 #ifdef MODULE_EVENT_THREAD_MEDIUM
-    { &event_queue_medium, _evq_medium_stack, sizeof(_evq_medium_stack),
+    { EVENT_PRIO_MEDIUM, _evq_medium_stack, sizeof(_evq_medium_stack),
         EVENT_THREAD_MEDIUM_PRIO },
 #endif
 #ifdef MODULE_EVENT_THREAD_LOWEST
-    { &event_queue_lowest, _evq_lowest_stack, sizeof(_evq_lowest_stack),
+    { EVENT_PRIO_LOWEST, _evq_lowest_stack, sizeof(_evq_lowest_stack),
         EVENT_THREAD_LOWEST_PRIO },
 #endif
 };
@@ -123,3 +178,5 @@ void auto_init_event_thread(void)
                 _event_threads[i].priority);
     }
 }
+
+#endif /* MODULE_EVENT_THREAD_SINGLE */
@@ -22,109 +22,145 @@
  * @}
  */
 
-#include "div.h"
+#include <assert.h>
+#include <stdio.h>
+
 #include "irq.h"
-#include "xtimer.h"
+#include "ztimer.h"
 
 #include "evtimer.h"
 
 #define ENABLE_DEBUG (0)
 #include "debug.h"
 
-static void _add_event_to_list(evtimer_t *evtimer, evtimer_event_t *event)
+/*
+ * Events are kept in a pairing heap ordered by their absolute deadline on
+ * EVTIMER_ZTIMER. Deadlines are compared by their (signed) difference, which is
+ * safe as long as all deadlines lie within 2^31 ms of each other; offsets
+ * larger than EVTIMER_MAX_OFFSET are thus split into multiple periods.
+ */
+
+static inline bool _before(const evtimer_event_t *a, const evtimer_event_t *b)
 {
-    DEBUG("evtimer: new event offset %" PRIu32 " ms\n", event->offset);
-    evtimer_event_t **list = &evtimer->events;
-
-    while (*list) {
-        /* Stop when new event time is nearer then next */
-        if (event->offset < (*list)->offset) {
-            DEBUG("evtimer: next %" PRIu32 " < %" PRIu32 " ms\n",
-                  event->offset, (*list)->offset);
-            break;
-        }
-        /* Set event offset relative to previous event */
-        event->offset -= (*list)->offset;
-        list = &(*list)->next;
-    }
+    return (int32_t)(a->deadline - b->deadline) < 0;
+}
 
-    DEBUG("evtimer: new event relative offset %" PRIu32 " ms\n", event->offset);
+static inline bool _is_due(const evtimer_event_t *event, uint32_t now)
+{
+    return (int32_t)(event->deadline - now) <= 0;
+}
 
-    /* Set found next bigger event after new event */
-    event->next = *list;
-    if (*list) {
-        /* Set offset following event relative to new event */
-        DEBUG("evtimer: recalculate offset for %" PRIu32 " ms\n",
-              (*list)->offset);
+/* melds two detached heaps, returns the new root */
+static evtimer_event_t *_meld(evtimer_event_t *a, evtimer_event_t *b)
+{
+    if (a == NULL) {
+        return b;
+    }
+    if (b == NULL) {
+        return a;
+    }
+    if (_before(b, a)) {
+        evtimer_event_t *tmp = a;
+        a = b;
+        b = tmp;
+    }
+    /* b becomes first child of a */
+    b->prev = a;
+    b->next = a->child;
+    if (a->child) {
+        a->child->prev = b;
+    }
+    a->child = b;
+    return a;
+}
 
-        (*list)->offset -= event->offset;
+/* standard two-pass pairing of a list of siblings */
+static evtimer_event_t *_merge_pairs(evtimer_event_t *first)
+{
+    evtimer_event_t *pairs = NULL;
+
+    /* first pass: meld pairs from left to right, collecting the results in
+     * reverse order */
+    while (first) {
+        evtimer_event_t *a = first;
+        evtimer_event_t *b = a->next;
+
+        first = b ? b->next : NULL;
+        a->next = a->prev = NULL;
+        if (b) {
+            b->next = b->prev = NULL;
+        }
+        a = _meld(a, b);
+        a->next = pairs;
+        pairs = a;
+    }
 
-        DEBUG("evtimer: resulting new event offset %" PRIu32 " ms\n",
-              (*list)->offset);
+    /* second pass: meld the results from right to left */
+    evtimer_event_t *root = NULL;
+    while (pairs) {
+        evtimer_event_t *a = pairs;
+        pairs = a->next;
+        a->next = NULL;
+        root = _meld(root, a);
     }
 
-    *list = event;
+    return root;
 }
 
-static void _del_event_from_list(evtimer_t *evtimer, evtimer_event_t *event)
+static void _remove(evtimer_t *evtimer, evtimer_event_t *event)
 {
-    evtimer_event_t **list = &evtimer->events;
+    evtimer_event_t *children = _merge_pairs(event->child);
 
-    /* Find the entry to delete from the list */
-    while (*list) {
-        if (*list == event) {
-            break;
+    if (event == evtimer->events) {
+        evtimer->events = children;
+    }
+    else {
+        if (event->prev->child == event) {
+            event->prev->child = event->next;
+        }
+        else {
+            event->prev->next = event->next;
         }
-        list = &(*list)->next;
-    }
-
-    if (*list) {
-        /* This is the entry we want to remove */
-        *list = (*list)->next;
-        /* If the deleted entry was _not_ the last one
-         * then update 'offset' of the entry that
-         * followed.
-         */
-        if (*list) {
-            (*list)->offset += event->offset;
+        if (event->next) {
+            event->next->prev = event->prev;
         }
+        evtimer->events = _meld(evtimer->events, children);
     }
-}
-
-static void _set_timer(xtimer_t *timer, uint32_t offset_ms)
-{
-    uint64_t offset_us = (uint64_t)offset_ms * US_PER_MS;
-
-    DEBUG("evtimer: now=%" PRIu32 " us setting xtimer to %" PRIu32 ":%" PRIu32 " us\n",
-          xtimer_now_usec(), (uint32_t)(offset_us >> 32), (uint32_t)(offset_us));
 
-    xtimer_set64(timer, offset_us);
+    event->next = event->prev = event->child = NULL;
 }
 
-static void _update_timer(evtimer_t *evtimer)
+static void _schedule(evtimer_t *evtimer, evtimer_event_t *event, uint32_t now)
 {
-    if (evtimer->events) {
-        evtimer_event_t *event = evtimer->events;
-        _set_timer(&evtimer->timer, event->offset);
+    uint32_t offset = event->offset;
+
+    if (offset > EVTIMER_MAX_OFFSET) {
+        event->offset = offset - EVTIMER_MAX_OFFSET;
+        offset = EVTIMER_MAX_OFFSET;
     }
     else {
-        xtimer_remove(&evtimer->timer);
+        event->offset = 0;
     }
-}
+    DEBUG("evtimer: scheduling event %p in %" PRIu32 " ms\n",
+          (void *)event, offset);
 
-static uint32_t _get_offset(xtimer_t *timer)
-{
-    uint64_t left = xtimer_left_usec(timer);
-    /* add half of 125 so integer division rounds to nearest */
-    return div_u64_by_125((left >> 3) + 62);
+    event->deadline = now + offset;
+    evtimer->events = _meld(evtimer->events, event);
 }
 
-static void _update_head_offset(evtimer_t *evtimer)
+static void _update_timer(evtimer_t *evtimer)
 {
     if (evtimer->events) {
-        evtimer_event_t *event = evtimer->events;
-        event->offset = _get_offset(&evtimer->timer);
-        DEBUG("evtimer: _update_head_offset(): new head offset %" PRIu32 "\n", event->offset);
+        uint32_t now = ztimer_now(EVTIMER_ZTIMER);
+        uint32_t left = _is_due(evtimer->events, now)
+                      ? 0 : evtimer->events->deadline - now;
+
+        DEBUG("evtimer: now=%" PRIu32 " ms setting ztimer to %" PRIu32 " ms\n",
+              now, left);
+        ztimer_set(EVTIMER_ZTIMER, &evtimer->timer, left);
+    }
+    else {
+        ztimer_remove(EVTIMER_ZTIMER, &evtimer->timer);
     }
 }
 
@@ -134,10 +170,13 @@ void evtimer_add(evtimer_t *evtimer, evtimer_event_t *event)
 
     DEBUG("evtimer_add(): adding event with offset %" PRIu32 "\n", event->offset);
 
-    _update_head_offset(evtimer);
-    _add_event_to_list(evtimer, event);
-    if (evtimer->events == event) {
-        _set_timer(&evtimer->timer, event->offset);
+    evtimer_event_t *head = evtimer->events;
+    if (evtimer_is_scheduled(evtimer, event)) {
+        _remove(evtimer, event);
+    }
+    _schedule(evtimer, event, ztimer_now(EVTIMER_ZTIMER));
+    if ((evtimer->events != head) || (event == head)) {
+        _update_timer(evtimer);
     }
     irq_restore(state);
     if (sched_context_switch_request) {
@@ -149,25 +188,53 @@ void evtimer_del(evtimer_t *evtimer, evtimer_event_t *event)
 {
     unsigned state = irq_disable();
 
-    DEBUG("evtimer_del(): removing event with offset %" PRIu32 "\n", event->offset);
+    DEBUG("evtimer_del(): removing event %p\n", (void *)event);
 
-    _update_head_offset(evtimer);
-    _del_event_from_list(evtimer, event);
-    _update_timer(evtimer);
+    if (evtimer_is_scheduled(evtimer, event)) {
+        bool was_head = (event == evtimer->events);
+        _remove(evtimer, event);
+        if (was_head) {
+            _update_timer(evtimer);
+        }
+    }
     irq_restore(state);
 }
 
-static evtimer_event_t *_get_next(evtimer_t *evtimer)
+uint32_t evtimer_left_msec(const evtimer_t *evtimer,
+                           const evtimer_event_t *event)
 {
-    evtimer_event_t *event = evtimer->events;
+    assert(evtimer_is_scheduled(evtimer, event));
+    (void)evtimer;
 
-    if (event && (event->offset == 0)) {
-        evtimer->events = event->next;
-        return event;
+    uint32_t now = ztimer_now(EVTIMER_ZTIMER);
+    uint32_t left = _is_due(event, now) ? 0 : event->deadline - now;
+
+    /* event->offset holds what exceeds the current period, if anything */
+    return (left > UINT32_MAX - event->offset) ? UINT32_MAX
+                                               : left + event->offset;
+}
+
+evtimer_event_t *evtimer_iter(const evtimer_t *evtimer,
+                              const evtimer_event_t *event)
+{
+    if (event == NULL) {
+        return evtimer->events;
     }
-    else {
-        return NULL;
+    /* pre-order traversal of the heap */
+    if (event->child) {
+        return event->child;
+    }
+    while (event) {
+        if (event->next) {
+            return event->next;
+        }
+        /* walk back to the first sibling, its prev is the parent */
+        while (event->prev && (event->prev->child != event)) {
+            event = event->prev;
+        }
+        event = event->prev;
     }
+    return NULL;
 }
 
 static void _evtimer_handler(void *arg)
@@ -175,15 +242,20 @@ static void _evtimer_handler(void *arg)
     DEBUG("_evtimer_handler()\n");
 
     evtimer_t *evtimer = (evtimer_t *)arg;
-
-    /* this function gets called directly by xtimer if the set xtimer expired.
-     * Thus the offset of the first event is down to zero. */
-    evtimer_event_t *event = evtimer->events;
-    event->offset = 0;
-
-    /* iterate the event list */
-    while ((event = _get_next(evtimer))) {
-        evtimer->callback(event);
+    uint32_t now = ztimer_now(EVTIMER_ZTIMER);
+    evtimer_event_t *event;
+
+    /* handle all events that are due in one pass, so the timer only needs
+     * to be set once afterwards */
+    while ((event = evtimer->events) && _is_due(event, now)) {
+        _remove(evtimer, event);
+        if (event->offset) {
+            /* long offset, only one period of it passed */
+            _schedule(evtimer, event, event->deadline);
+        }
+        else {
+            evtimer->callback(event);
+        }
     }
 
     _update_timer(evtimer);
@@ -199,12 +271,12 @@ void evtimer_init(evtimer_t *evtimer, evtimer_callback_t handler)
 
 void evtimer_print(const evtimer_t *evtimer)
 {
-    evtimer_event_t *list = evtimer->events;
+    evtimer_event_t *event = NULL;
     int nr = 0;
 
-    while (list) {
+    while ((event = evtimer_iter(evtimer, event))) {
         nr++;
-        printf("ev #%d offset=%u\n", nr, (unsigned)list->offset);
-        list = list->next;
+        printf("ev #%d offset=%u\n", nr,
+               (unsigned)evtimer_left_msec(evtimer, event));
     }
 }
@@ -46,6 +46,7 @@
  */
 
 #include <string.h>
+#include <stdbool.h>
 #include <assert.h>
 
 #include "hashes/sha256.h"
@@ -122,6 +123,7 @@ static const uint32_t K[64] = {
     0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
 };
 
+#ifndef MODULE_HASHES_SHA256_UNROLL
 /*
  * SHA256 block compression function.  The 256-bit state is transformed via
  * the 512-bit input block to produce a new state.
@@ -159,6 +161,152 @@ static void sha256_transform(uint32_t *state, const unsigned char block[64])
         state[i] += S[i];
     }
 }
+#else /* MODULE_HASHES_SHA256_UNROLL */
+/* One round, the caller rotates the names of the working variables instead
+ * of moving the values around */
+#define RND(a, b, c, d, e, f, g, h, i)                           \
+    do {                                                         \
+        uint32_t t0 = h + S1(e) + Ch(e, f, g) + W[i] + K[i];     \
+        uint32_t t1 = S0(a) + Maj(a, b, c);                      \
+        d += t0;                                                 \
+        h = t0 + t1;                                             \
+    } while (0)
+
+/*
+ * SHA256 block compression function, eight rounds per loop iteration with
+ * the working variables kept in locals (more flash, less CPU)
+ */
+static void sha256_transform(uint32_t *state, const unsigned char block[64])
+{
+    uint32_t W[64];
+
+    be32dec_vect(W, block, 64);
+    for (int i = 16; i < 64; i++) {
+        W[i] = s1(W[i - 2]) + W[i - 7] + s0(W[i - 15]) + W[i - 16];
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (int i = 0; i < 64; i += 8) {
+        RND(a, b, c, d, e, f, g, h, i + 0);
+        RND(h, a, b, c, d, e, f, g, i + 1);
+        RND(g, h, a, b, c, d, e, f, i + 2);
+        RND(f, g, h, a, b, c, d, e, i + 3);
+        RND(e, f, g, h, a, b, c, d, i + 4);
+        RND(d, e, f, g, h, a, b, c, i + 5);
+        RND(c, d, e, f, g, h, a, b, i + 6);
+        RND(b, c, d, e, f, g, h, a, i + 7);
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+#endif /* MODULE_HASHES_SHA256_UNROLL */
+
+#ifdef MODULE_HASHES_SHA256_SHANI
+#if !defined(__i386__) && !defined(__x86_64__)
+#error "hashes_sha256_shani requires an x86 CPU"
+#endif
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+/* Check once whether the CPU implements the SHA extensions and SSE4.1 */
+static bool _has_shani(void)
+{
+    static int has_shani = -1;
+
+    if (has_shani < 0) {
+        unsigned eax, ebx, ecx, edx;
+        has_shani = 0;
+        if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSE4_1) &&
+            __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & bit_SHA)) {
+            has_shani = 1;
+        }
+    }
+    return has_shani;
+}
+
+/*
+ * SHA256 block compression function using the x86 SHA extensions for
+ * @p nblocks consecutive blocks
+ */
+__attribute__((target("sha,sse4.1")))
+static void sha256_transform_shani(uint32_t *state, const unsigned char *data,
+                                   size_t nblocks)
+{
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,
+                                        0x0405060700010203ULL);
+    __m128i tmp = _mm_loadu_si128((const __m128i *)&state[0]);
+    __m128i state1 = _mm_loadu_si128((const __m128i *)&state[4]);
+
+    /* the instructions use the state in ABEF/CDGH order */
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);
+    state1 = _mm_shuffle_epi32(state1, 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    for (; nblocks > 0; nblocks--, data += 64) {
+        __m128i abef = state0;
+        __m128i cdgh = state1;
+        __m128i msg[4];
+
+        for (unsigned i = 0; i < 4; i++) {
+            msg[i] = _mm_shuffle_epi8(
+                _mm_loadu_si128((const __m128i *)&data[16 * i]), mask);
+        }
+        /* 16 times four rounds, computing the message schedule on the fly */
+        for (unsigned i = 0; i < 16; i++) {
+            __m128i m = _mm_add_epi32(msg[i % 4],
+                                      _mm_loadu_si128((const __m128i *)&K[4 * i]));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, m);
+            m = _mm_shuffle_epi32(m, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, m);
+            if (i < 12) {
+                __m128i w = _mm_sha256msg1_epu32(msg[i % 4], msg[(i + 1) % 4]);
+                w = _mm_add_epi32(w, _mm_alignr_epi8(msg[(i + 3) % 4],
+                                                     msg[(i + 2) % 4], 4));
+                msg[i % 4] = _mm_sha256msg2_epu32(w, msg[(i + 3) % 4]);
+            }
+        }
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+    }
+
+    /* back to ABCD/EFGH order */
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128((__m128i *)&state[0], state0);
+    _mm_storeu_si128((__m128i *)&state[4], state1);
+}
+#endif /* MODULE_HASHES_SHA256_SHANI */
+
+/*
+ * Feed @p nblocks consecutive 64 byte blocks into the state, using the
+ * fastest compression function available
+ */
+static void sha256_transform_blocks(uint32_t *state, const unsigned char *data,
+                                    size_t nblocks)
+{
+#ifdef MODULE_HASHES_SHA256_SHANI
+    if (_has_shani()) {
+        sha256_transform_shani(state, data, nblocks);
+        return;
+    }
+#endif
+    for (; nblocks > 0; nblocks--, data += 64) {
+        sha256_transform(state, data);
+    }
+}
 
 static unsigned char PAD[64] = {
     0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -233,16 +381,14 @@ void sha256_update(sha256_context_t *ctx, const void *data, size_t len)
     const unsigned char *src = data;
 
     memcpy(&ctx->buf[r], src, 64 - r);
-    sha256_transform(ctx->state, ctx->buf);
+    sha256_transform_blocks(ctx->state, ctx->buf, 1);
     src += 64 - r;
     len -= 64 - r;
 
     /* Perform complete blocks */
-    while (len >= 64) {
-        sha256_transform(ctx->state, src);
-        src += 64;
-        len -= 64;
-    }
+    sha256_transform_blocks(ctx->state, src, len / 64);
+    src += len & ~0x3f;
+    len &= 0x3f;
 
     /* Copy left over data into buffer */
     memcpy(ctx->buf, src, len);
@@ -10,6 +10,44 @@
  * @defgroup    sys_benchmark Benchmark
  * @ingroup     sys
  * @brief       Framework for running simple runtime benchmarks
+ *
+ * Besides the simple @ref BENCHMARK_FUNC macro, this module offers a small
+ * benchmark runner: a benchmark (@ref benchmark_t) is a function that is called
+ * @ref benchmark_t::runs times per sample. After a number of warm-up samples,
+ * @ref benchmark_t::samples samples are taken, each timed with the most
+ * precise clock source available (@ref benchmark_clock_now()):
+ *
+ * - the DWT cycle counter on Cortex-M3 and up,
+ * - `rdtsc` on native on x86, `clock_gettime()` otherwise on native,
+ * - @ref xtimer_now_usec() everywhere else.
+ *
+ * The per-call cost is reported as minimum, median, 99th percentile, maximum,
+ * mean and standard deviation over all samples, after subtracting the
+ * overhead of the measurement loop itself. Mean and deviation are computed
+ * using @ref sys_matstat.
+ *
+ * Benchmarks can be registered with @ref benchmark_register() and run as a
+ * suite with @ref benchmark_run_all(). Results are printed as human readable
+ * text, CSV or JSON (one object per line), so that the output of different
+ * builds can be compared by scripts.
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~ {.c}
+ * static void _lock_unlock(void *arg)
+ * {
+ *     mutex_lock(arg);
+ *     mutex_unlock(arg);
+ * }
+ *
+ * static benchmark_t _bench_mutex = BENCHMARK_INIT("mutex lock/unlock",
+ *                                                  _lock_unlock, &_lock, 100);
+ *
+ * int main(void)
+ * {
+ *     benchmark_register(&_bench_mutex);
+ *     benchmark_run_all(BENCHMARK_OUTPUT_JSON);
+ * }
+ * ~~~~~~~~~~~~~~~~~~~~~~~~
+ *
  * @{
  *
  * @file
@@ -23,6 +61,7 @@
 
 #include <stdint.h>
 
+#include "cpu.h"
 #include "irq.h"
 #include "xtimer.h"
 
@@ -62,6 +101,222 @@ extern "C" {
  */
 void benchmark_print_time(uint32_t time, unsigned long runs, const char *name);
 
+/**
+ * @defgroup sys_benchmark_config   Benchmark runner compile configurations
+ * @ingroup  config
+ * @{
+ */
+/**
+ * @brief   Maximum number of samples per benchmark
+ *
+ * The samples of a benchmark are kept in a static buffer of this length to
+ * compute median and percentiles.
+ */
+#ifndef CONFIG_BENCHMARK_SAMPLES_MAX
+#define CONFIG_BENCHMARK_SAMPLES_MAX    (128U)
+#endif
+
+/**
+ * @brief   Default number of samples, if not set in @ref benchmark_t
+ */
+#ifndef CONFIG_BENCHMARK_SAMPLES
+#define CONFIG_BENCHMARK_SAMPLES        (32U)
+#endif
+
+/**
+ * @brief   Default number of calls per sample, if not set in @ref benchmark_t
+ */
+#ifndef CONFIG_BENCHMARK_RUNS
+#define CONFIG_BENCHMARK_RUNS           (100U)
+#endif
+
+/**
+ * @brief   Number of samples taken and discarded before measuring
+ */
+#ifndef CONFIG_BENCHMARK_WARMUP
+#define CONFIG_BENCHMARK_WARMUP         (2U)
+#endif
+/** @} */
+
+/**
+ * @name    Clock source used by the benchmark runner
+ * @{
+ */
+#if defined(CPU_NATIVE) && (defined(__x86_64__) || defined(__i386__))
+#define BENCHMARK_CLOCK_UNIT    "cycles"    /**< unit of the clock source */
+#define BENCHMARK_CLOCK_CYCLES  (1)         /**< clock counts CPU cycles */
+#elif defined(CPU_NATIVE)
+#define BENCHMARK_CLOCK_UNIT    "ns"
+#elif defined(DWT_CTRL_CYCCNTENA_Msk)
+#define BENCHMARK_CLOCK_UNIT    "cycles"
+#define BENCHMARK_CLOCK_CYCLES  (1)
+#else
+#define BENCHMARK_CLOCK_UNIT    "us"
+#endif
+/** @} */
+
+/**
+ * @brief   Benchmark flags
+ */
+enum {
+    /**
+     * @brief   Keep interrupts enabled while measuring
+     *
+     * Needed for benchmarks involving context switches or timers.
+     */
+    BENCHMARK_FLAG_IRQ = 0x01,
+};
+
+/**
+ * @brief   Output formats of the benchmark runner
+ */
+typedef enum {
+    BENCHMARK_OUTPUT_TEXT,      /**< human readable, aligned columns */
+    BENCHMARK_OUTPUT_CSV,       /**< comma separated values with header */
+    BENCHMARK_OUTPUT_JSON,      /**< one JSON object per line */
+} benchmark_output_t;
+
+/**
+ * @brief   Benchmark type forward declaration
+ */
+typedef struct benchmark benchmark_t;
+
+/**
+ * @brief   Benchmark description
+ */
+struct benchmark {
+    benchmark_t *next;              /**< next registered benchmark */
+    const char *name;               /**< name to label the results */
+    void (*func)(void *arg);        /**< function to benchmark */
+    void (*setup)(void *arg);       /**< called before the warm-up, may be
+                                         NULL */
+    void (*teardown)(void *arg);    /**< called after the last sample, may
+                                         be NULL */
+    void *arg;                      /**< argument for the functions */
+    uint32_t runs;                  /**< calls per sample, 0 for
+                                         @ref CONFIG_BENCHMARK_RUNS */
+    uint16_t samples;               /**< samples to take, 0 for
+                                         @ref CONFIG_BENCHMARK_SAMPLES */
+    uint8_t flags;                  /**< benchmark flags */
+};
+
+/**
+ * @brief   Static initializer for @ref benchmark_t
+ *
+ * @param[in] NAME  name of the benchmark
+ * @param[in] FUNC  function to benchmark
+ * @param[in] ARG   argument for @p FUNC
+ * @param[in] RUNS  number of calls to @p FUNC per sample
+ */
+#define BENCHMARK_INIT(NAME, FUNC, ARG, RUNS) \
+    { .name = (NAME), .func = (FUNC), .arg = (ARG), .runs = (RUNS) }
+
+/**
+ * @brief   Results of a benchmark
+ *
+ * All times are totals of the @ref benchmark_result_t::runs calls of
+ * @ref benchmark_t::func in a sample, in units of @ref BENCHMARK_CLOCK_UNIT.
+ * They are only divided by the number of runs when printed, with three
+ * decimal places, so calls shorter than one unit are not truncated to 0.
+ */
+typedef struct {
+    const char *name;       /**< name of the benchmark */
+    uint32_t runs;          /**< calls per sample */
+    uint32_t samples;       /**< number of samples taken */
+    uint32_t min;           /**< fastest sample */
+    uint32_t median;        /**< median of all samples */
+    uint32_t p99;           /**< 99th percentile of all samples */
+    uint32_t max;           /**< slowest sample */
+    uint32_t mean;          /**< mean of all samples */
+    uint32_t stddev;        /**< standard deviation of all samples */
+} benchmark_result_t;
+
+/**
+ * @brief   Initialize the clock source of the benchmark runner
+ *
+ * This is called by @ref benchmark_run(), it only needs to be called before
+ * using @ref benchmark_clock_now() directly.
+ */
+void benchmark_clock_init(void);
+
+/**
+ * @brief   Read the clock source of the benchmark runner
+ *
+ * @return  current time in @ref BENCHMARK_CLOCK_UNIT, only differences of
+ *          two values are meaningful
+ */
+#if defined(CPU_NATIVE) && (defined(__x86_64__) || defined(__i386__))
+static inline uint32_t benchmark_clock_now(void)
+{
+    return (uint32_t)__builtin_ia32_rdtsc();
+}
+#elif defined(CPU_NATIVE)
+uint32_t benchmark_clock_now(void);
+#elif defined(DWT_CTRL_CYCCNTENA_Msk)
+static inline uint32_t benchmark_clock_now(void)
+{
+    return DWT->CYCCNT;
+}
+#else
+static inline uint32_t benchmark_clock_now(void)
+{
+    return xtimer_now_usec();
+}
+#endif
+
+/**
+ * @brief   Run a single benchmark
+ *
+ * @note    The runner uses a static sample buffer, so only one benchmark
+ *          can be run at a time.
+ *
+ * @param[in]  bench    benchmark to run
+ * @param[out] res      results of the benchmark
+ *
+ * @return  0 on success
+ * @return  -EINVAL if @p bench requests more than
+ *          @ref CONFIG_BENCHMARK_SAMPLES_MAX samples
+ */
+int benchmark_run(benchmark_t *bench, benchmark_result_t *res);
+
+/**
+ * @brief   Add a benchmark to the suite run by @ref benchmark_run_all()
+ *
+ * Benchmarks are run in the order they are registered.
+ *
+ * @param[in] bench     benchmark to register, must not be registered yet
+ */
+void benchmark_register(benchmark_t *bench);
+
+/**
+ * @brief   Run all registered benchmarks and print their results
+ *
+ * @param[in] format    output format
+ *
+ * @return  number of benchmarks run
+ */
+unsigned benchmark_run_all(benchmark_output_t format);
+
+/**
+ * @brief   Print the header for results in the given format
+ *
+ * For CSV this is the column header, for JSON an object describing the build
+ * (RIOT version, board and clock unit), so that results from different builds
+ * can be told apart.
+ *
+ * @param[in] format    output format
+ */
+void benchmark_print_header(benchmark_output_t format);
+
+/**
+ * @brief   Print the results of a benchmark in the given format
+ *
+ * @param[in] res       results to print
+ * @param[in] format    output format
+ */
+void benchmark_print_result(const benchmark_result_t *res,
+                            benchmark_output_t format);
+
 #ifdef __cplusplus
 }
 #endif
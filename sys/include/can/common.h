@@ -122,6 +122,7 @@ enum can_msg {
 typedef struct can_rx_data {
     struct iovec data;    /**< iovec containing received data */
     void *arg;            /**< upper layer private param */
+    unsigned ref_count;   /**< number of users, the data may be shared */
 } can_rx_data_t;
 
 /**
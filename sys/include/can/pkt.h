@@ -113,9 +113,23 @@ void can_pkt_free(can_pkt_t *pkt);
  */
 can_rx_data_t *can_pkt_alloc_rx_data(void *data, size_t len, void *arg);
 
+/**
+ * @brief Take an additional reference on rx data
+ *
+ * This allows to hand the same rx data to several users, each of them
+ * calling can_pkt_free_rx_data() when done. The data must not be modified
+ * by the users.
+ *
+ * @param[in] data  rx data returned by can_pkt_alloc_rx_data()
+ */
+void can_pkt_ref_rx_data(can_rx_data_t *data);
+
 /**
  * @brief Free rx data previously allocated by can_pkt_alloc_rx_data()
  *
+ * The data is only released once all references taken by
+ * can_pkt_ref_rx_data() are freed as well.
+ *
  * @param[in] data  the pointer to free
  */
 void can_pkt_free_rx_data(can_rx_data_t *data);
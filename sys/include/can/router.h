@@ -80,9 +80,11 @@ int can_router_free_frame(struct can_frame *frame);
 /**
  * @brief Dispatch a RX indication to subscribers threads
  *
- * This function goes through the list of subscribed filters to send a message to each
- * subscriber's thread. If all the subscriber's threads cannot receive message,
- * the packet is freed.
+ * This function looks up the subscribed filters matching the packet to send a message
+ * to each subscriber's thread. Subscribers registered with the same param share
+ * the rx data of the frame passed along with the message, it is reference
+ * counted like the frame itself. If all the subscriber's threads cannot receive
+ * message, the packet is freed.
  *
  * @param[in] pkt   the packet to dispatch
  *
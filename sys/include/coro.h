@@ -0,0 +1,270 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    sys_coro Stackless coroutines
+ * @ingroup     sys
+ * @brief       Protothread-style stackless coroutines driven by event queues
+ *
+ * A coroutine is a function that can suspend itself and be resumed later,
+ * continuing right after the point where it suspended. Coroutines in this
+ * module are *stackless*: they do not have a stack of their own but run on the
+ * stack of the thread serving their @ref event_queue_t, so many of them can
+ * be outstanding at the same time without one thread stack each.
+ *
+ * As a consequence, local variables are **not** preserved across suspension
+ * points. All state that needs to survive must be kept in a structure that
+ * embeds the @ref coro_t (see @ref container_of).
+ *
+ * A coroutine is resumed whenever it is woken up using coro_wake(), e.g. from
+ * a @ref net_sock_async "sock_async" callback, or when its timeout expires.
+ * coro_wake() is safe to call from interrupt context.
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~ {.c}
+ * typedef struct {
+ *     coro_t coro;
+ *     sock_udp_t sock;
+ *     uint8_t buf[64];
+ *     ssize_t res;
+ * } my_request_t;
+ *
+ * static coro_state_t _request(coro_t *coro)
+ * {
+ *     my_request_t *req = container_of(coro, my_request_t, coro);
+ *
+ *     CORO_BEGIN(coro);
+ *     sock_udp_send(&req->sock, "ping", 4, NULL);
+ *     coro_set_timeout(coro, US_PER_SEC);
+ *     do {
+ *         CORO_WAIT(coro);
+ *         req->res = sock_udp_recv(&req->sock, req->buf, sizeof(req->buf),
+ *                                  0, NULL);
+ *     } while ((req->res == -EAGAIN) && !coro_timed_out(coro));
+ *     CORO_END(coro);
+ * }
+ * ~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * @{
+ *
+ * @file
+ * @brief       Stackless coroutine API
+ */
+
+#ifndef CORO_H
+#define CORO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "event.h"
+#include "kernel_defines.h"
+#include "xtimer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Continuation value of a coroutine that is not running
+ */
+#define CORO_LC_EXITED      (UINT16_MAX)
+
+/**
+ * @brief   Return values of a coroutine function
+ */
+typedef enum {
+    CORO_WAITING,       /**< suspended until woken up by coro_wake() */
+    CORO_YIELDED,       /**< suspended, resume as soon as possible */
+    CORO_EXITED,        /**< coroutine finished */
+} coro_state_t;
+
+/**
+ * @brief   Coroutine forward declaration
+ */
+typedef struct coro coro_t;
+
+/**
+ * @brief   Coroutine function
+ *
+ * Called every time the coroutine is resumed. Must use @ref CORO_BEGIN and
+ * @ref CORO_END around its body.
+ */
+typedef coro_state_t (*coro_func_t)(coro_t *coro);
+
+/**
+ * @brief   Callback called after a coroutine exited
+ *
+ * The coroutine's memory is not touched by the runtime after this callback
+ * was called, so it may be released or the coroutine restarted from within.
+ * Events the coroutine posted to its queue on its own behalf, e.g. the event
+ * of an asynchronous sock, must be cancelled by the coroutine before it exits.
+ */
+typedef void (*coro_done_t)(coro_t *coro);
+
+/**
+ * @brief   Coroutine structure
+ */
+struct coro {
+    event_t super;              /**< event used to resume the coroutine */
+    event_queue_t *queue;       /**< queue the coroutine runs on */
+    coro_func_t func;           /**< coroutine function */
+    coro_done_t done;           /**< called when the coroutine exited */
+    xtimer_t timer;             /**< timer for coro_set_timeout() */
+    uint16_t lc;                /**< local continuation */
+    volatile bool timed_out;    /**< true if the timeout fired */
+};
+
+/**
+ * @name    Coroutine body macros
+ *
+ * These macros implement the local continuations by means of a `switch`
+ * statement over source line numbers. Consequently, a coroutine body must not
+ * use `switch` statements spanning suspension points itself.
+ * @{
+ */
+/**
+ * @brief   Start of a coroutine body
+ */
+#define CORO_BEGIN(coro)    switch ((coro)->lc) { case 0:
+
+/**
+ * @brief   End of a coroutine body
+ */
+#define CORO_END(coro)      } (coro)->lc = CORO_LC_EXITED; return CORO_EXITED
+
+/**
+ * @brief   Exit the coroutine from anywhere in its body
+ */
+#define CORO_EXIT(coro)     do {                \
+        (coro)->lc = CORO_LC_EXITED;            \
+        return CORO_EXITED;                     \
+    } while (0)
+
+/**
+ * @brief   Suspend until woken up by coro_wake() or the timeout
+ */
+#define CORO_WAIT(coro)     do {                \
+        (coro)->lc = __LINE__;                  \
+        return CORO_WAITING;                    \
+        case __LINE__:;                         \
+    } while (0)
+
+/**
+ * @brief   Suspend until @p cond is true
+ *
+ * @p cond is re-evaluated every time the coroutine is woken up.
+ */
+#define CORO_WAIT_UNTIL(coro, cond) do {        \
+        (coro)->lc = __LINE__;                  \
+        if (0) {                                \
+        case __LINE__:;                         \
+        }                                       \
+        if (!(cond)) {                          \
+            return CORO_WAITING;                \
+        }                                       \
+    } while (0)
+
+/**
+ * @brief   Let other events on the queue run, then continue
+ */
+#define CORO_YIELD(coro)    do {                \
+        (coro)->lc = __LINE__;                  \
+        return CORO_YIELDED;                    \
+        case __LINE__:;                         \
+    } while (0)
+/** @} */
+
+/**
+ * @brief   Initialize a coroutine
+ *
+ * @param[out]  coro    coroutine to initialize
+ * @param[in]   func    coroutine function
+ * @param[in]   done    called after the coroutine exited, may be NULL
+ */
+void coro_init(coro_t *coro, coro_func_t func, coro_done_t done);
+
+/**
+ * @brief   Start a coroutine on an event queue
+ *
+ * The coroutine function is first called from the thread serving @p queue.
+ *
+ * @pre     @p coro is not running
+ *
+ * @param[in]   coro    coroutine to start
+ * @param[in]   queue   event queue to run the coroutine on
+ */
+void coro_start(coro_t *coro, event_queue_t *queue);
+
+/**
+ * @brief   Run a coroutine to completion in the calling thread
+ *
+ * This blocks the calling thread while the coroutine is running, serving a
+ * temporary event queue. It allows to implement blocking APIs on top of
+ * coroutines.
+ *
+ * @param[in]   coro    coroutine to run
+ */
+void coro_run(coro_t *coro);
+
+/**
+ * @brief   Wake up a suspended coroutine
+ *
+ * Waking a coroutine that is already scheduled to resume has no effect.
+ *
+ * @note    This function can be called from interrupt context.
+ *
+ * @param[in]   coro    coroutine to wake up
+ */
+static inline void coro_wake(coro_t *coro)
+{
+    event_post(coro->queue, &coro->super);
+}
+
+/**
+ * @brief   Check if a coroutine is running, i.e., started and not exited yet
+ *
+ * @param[in]   coro    coroutine to check
+ */
+static inline bool coro_is_running(const coro_t *coro)
+{
+    return coro->lc != CORO_LC_EXITED;
+}
+
+/**
+ * @brief   Wake up a coroutine after a timeout
+ *
+ * The timeout is cleared automatically when the coroutine exits.
+ *
+ * @param[in]   coro        coroutine to wake up
+ * @param[in]   timeout_us  timeout in microseconds
+ */
+void coro_set_timeout(coro_t *coro, uint32_t timeout_us);
+
+/**
+ * @brief   Clear the timeout of a coroutine
+ *
+ * @param[in]   coro    coroutine to clear the timeout for
+ */
+void coro_clear_timeout(coro_t *coro);
+
+/**
+ * @brief   Check if the timeout of a coroutine fired
+ *
+ * @param[in]   coro    coroutine to check
+ */
+static inline bool coro_timed_out(const coro_t *coro)
+{
+    return coro->timed_out;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CORO_H */
+/** @} */
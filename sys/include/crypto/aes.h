@@ -126,6 +126,62 @@ int aes_encrypt(const cipher_context_t *context, const uint8_t *plain_block,
 int aes_decrypt(const cipher_context_t *context, const uint8_t *cipher_block,
                 uint8_t *plain_block);
 
+/**
+ * @brief   encrypts @p nblocks consecutive blocks of data
+ *
+ * The key schedule is only expanded once for all blocks, which makes this
+ * considerably faster than calling aes_encrypt() for every block.
+ *
+ * @param       context     the cipher_context_t-struct to use for this
+ *                          encryption
+ * @param       plain       pointer to the plaintext blocks
+ * @param       cipher      pointer to the output buffer, may be equal to
+ *                          @p plain
+ * @param       nblocks     number of blocks of AES_BLOCK_SIZE bytes
+ *
+ * @return  1 on success
+ * @return  A negative value if the cipher key cannot be expanded with the
+ *          AES key schedule
+ */
+int aes_encrypt_blocks(const cipher_context_t *context, const uint8_t *plain,
+                       uint8_t *cipher, size_t nblocks);
+
+/**
+ * @brief   decrypts @p nblocks consecutive blocks of data
+ *
+ * @param       context     the cipher_context_t-struct to use for this
+ *                          decryption
+ * @param       cipher      pointer to the ciphertext blocks
+ * @param       plain       pointer to the output buffer, may be equal to
+ *                          @p cipher
+ * @param       nblocks     number of blocks of AES_BLOCK_SIZE bytes
+ *
+ * @return  1 on success
+ * @return  A negative value if the cipher key cannot be expanded with the
+ *          AES key schedule
+ */
+int aes_decrypt_blocks(const cipher_context_t *context, const uint8_t *cipher,
+                       uint8_t *plain, size_t nblocks);
+
+/**
+ * @brief   feeds @p nblocks consecutive blocks into a CBC-MAC
+ *
+ * For every block, @p mac is XORed with the block and then encrypted in
+ * place. The key schedule is only expanded once for all blocks.
+ *
+ * @param       context     the cipher_context_t-struct to use
+ * @param       mac         the CBC-MAC of the preceding blocks (or the IV),
+ *                          is updated in place
+ * @param       input       pointer to the input blocks
+ * @param       nblocks     number of blocks of AES_BLOCK_SIZE bytes
+ *
+ * @return  1 on success
+ * @return  A negative value if the cipher key cannot be expanded with the
+ *          AES key schedule
+ */
+int aes_cbc_mac_blocks(const cipher_context_t *context, uint8_t *mac,
+                       const uint8_t *input, size_t nblocks);
+
 #ifdef __cplusplus
 }
 #endif
@@ -29,6 +29,7 @@
 #define CRYPTO_CHACHA20POLY1305_H
 
 #include "crypto/poly1305.h"
+#include "iolist.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -38,6 +39,16 @@ extern "C" {
 #define CHACHA20POLY1305_NONCE_BYTES    (12U)   /**< Nonce length in bytes */
 #define CHACHA20POLY1305_TAG_BYTES      (16U)   /**< Tag length in bytes */
 
+/**
+ * @brief   Number of keystream blocks computed in parallel when the
+ *          `crypto_chacha20poly1305_simd` module is used
+ *
+ * 4 fits 128 bit vector units (SSE, NEON), 8 fits 256 bit ones (AVX2).
+ */
+#ifndef CHACHA20POLY1305_SIMD_BLOCKS
+#define CHACHA20POLY1305_SIMD_BLOCKS    (4U)
+#endif
+
 /**
  * @brief Chacha20poly1305 state struct
  */
@@ -96,6 +107,51 @@ int chacha20poly1305_decrypt(const uint8_t *cipher, size_t cipherlen,
                              const uint8_t *aad, size_t aadlen,
                              const uint8_t *key, const uint8_t *nonce);
 
+/**
+ * @brief Encrypt a scattered plaintext in place and generate a tag to protect
+ * the ciphertext and additional data.
+ *
+ * The message is processed part by part, so a packet spread over several
+ * buffers can be sealed without merging it first.  As the first fields of
+ * @ref gnrc_pktsnip_t match @ref iolist_t, a packet snip chain can be passed
+ * directly.
+ *
+ * @param[in,out] data      message parts, encrypted in place
+ * @param[in]   aad         additional authenticated data to protect, may be
+ *                          NULL
+ * @param[out]  tag         resulting tag, must be CHACHA20POLY1305_TAG_BYTES
+ *                          long
+ * @param[in]   key         key to encrypt with, must be
+ *                          CHACHA20POLY1305_KEY_BYTES long
+ * @param[in]   nonce       Nonce to use. Must be CHACHA20POLY1305_NONCE_BYTES
+ *                          long
+ */
+void chacha20poly1305_encrypt_iolist(iolist_t *data, const iolist_t *aad,
+                                     uint8_t *tag, const uint8_t *key,
+                                     const uint8_t *nonce);
+
+/**
+ * @brief Verify the tag and decrypt a scattered ciphertext in place.
+ *
+ * @p data is only modified if the tag is valid.
+ *
+ * @param[in,out] data      ciphertext parts, decrypted in place
+ * @param[in]   aad         additional authenticated data to verify, may be
+ *                          NULL
+ * @param[in]   tag         tag to verify, must be CHACHA20POLY1305_TAG_BYTES
+ *                          long
+ * @param[in]   key         key to decrypt with, must be
+ *                          CHACHA20POLY1305_KEY_BYTES long
+ * @param[in]   nonce       Nonce to use. Must be CHACHA20POLY1305_NONCE_BYTES
+ *                          long
+ *
+ * @return  1 if the tag is valid and @p data was decrypted
+ * @return  0 if the tag is invalid
+ */
+int chacha20poly1305_decrypt_iolist(iolist_t *data, const iolist_t *aad,
+                                    const uint8_t *tag, const uint8_t *key,
+                                    const uint8_t *nonce);
+
 #ifdef __cplusplus
 }
 #endif
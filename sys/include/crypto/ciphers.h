@@ -22,6 +22,7 @@
 #ifndef CRYPTO_CIPHERS_H
 #define CRYPTO_CIPHERS_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -34,6 +35,18 @@ extern "C" {
 #define CIPHERS_MAX_KEY_SIZE 20
 #define CIPHER_MAX_BLOCK_SIZE 16
 
+#ifndef CIPHER_BATCH_BLOCKS
+/**
+ * @brief   Number of blocks the modes of operation hand to the cipher in one
+ *          call to cipher_encrypt_blocks()
+ *
+ * Larger values amortize the per call setup (e.g. the AES key schedule) over
+ * more blocks, at the cost of CIPHER_BATCH_BLOCKS * CIPHER_MAX_BLOCK_SIZE
+ * bytes of stack.
+ */
+#define CIPHER_BATCH_BLOCKS 4
+#endif
+
 /**
  * Context sizes needed for the different ciphers.
  * Always order by number of bytes descending!!! <br><br>
@@ -89,6 +102,18 @@ typedef struct cipher_interface_st {
     /** the decrypt function */
     int (*decrypt)(const cipher_context_t *ctx, const uint8_t *cipher_block,
                    uint8_t *plain_block);
+
+    /** encrypt multiple consecutive blocks, optional (may be NULL) */
+    int (*encrypt_blocks)(const cipher_context_t *ctx, const uint8_t *plain,
+                          uint8_t *cipher, size_t nblocks);
+
+    /** decrypt multiple consecutive blocks, optional (may be NULL) */
+    int (*decrypt_blocks)(const cipher_context_t *ctx, const uint8_t *cipher,
+                          uint8_t *plain, size_t nblocks);
+
+    /** CBC-MAC over multiple consecutive blocks, optional (may be NULL) */
+    int (*cbc_mac_blocks)(const cipher_context_t *ctx, uint8_t *mac,
+                          const uint8_t *input, size_t nblocks);
 } cipher_interface_t;
 
 
@@ -162,6 +187,61 @@ int cipher_decrypt(const cipher_t *cipher, const uint8_t *input,
                    uint8_t *output);
 
 
+/**
+ * @brief Encrypt @p nblocks consecutive blocks of BLOCK_SIZE length
+ *
+ * Equivalent to calling cipher_encrypt() for every block, but allows the
+ * cipher to do its per key setup only once.
+ *
+ * @param cipher     Already initialized cipher struct
+ * @param input      pointer to input data to encrypt
+ * @param output     pointer to allocated memory for encrypted data. It has to
+ *                   be of size nblocks * BLOCK_SIZE, may be equal to @p input
+ * @param nblocks    number of blocks to encrypt
+ *
+ * @return           1 in case of success
+ * @return           A negative value for an error
+ */
+int cipher_encrypt_blocks(const cipher_t *cipher, const uint8_t *input,
+                          uint8_t *output, size_t nblocks);
+
+
+/**
+ * @brief Decrypt @p nblocks consecutive blocks of BLOCK_SIZE length
+ *
+ * @param cipher     Already initialized cipher struct
+ * @param input      pointer to input data to decrypt
+ * @param output     pointer to allocated memory for decrypted data. It has to
+ *                   be of size nblocks * BLOCK_SIZE, may be equal to @p input
+ * @param nblocks    number of blocks to decrypt
+ *
+ * @return           1 in case of success
+ * @return           A negative value for an error
+ */
+int cipher_decrypt_blocks(const cipher_t *cipher, const uint8_t *input,
+                          uint8_t *output, size_t nblocks);
+
+
+/**
+ * @brief Feed @p nblocks consecutive blocks of BLOCK_SIZE length into a
+ *        CBC-MAC
+ *
+ * For every block, @p mac is XORed with the block and then encrypted in
+ * place. Equivalent to doing this with cipher_encrypt(), but allows the
+ * cipher to do its per key setup only once.
+ *
+ * @param cipher     Already initialized cipher struct
+ * @param mac        CBC-MAC of the preceding blocks (or the IV) of size
+ *                   BLOCK_SIZE, is updated in place
+ * @param input      pointer to the input blocks
+ * @param nblocks    number of blocks to process
+ * @return           1 in case of success
+ * @return           A negative value for an error
+ */
+int cipher_cbc_mac_blocks(const cipher_t *cipher, uint8_t *mac,
+                          const uint8_t *input, size_t nblocks);
+
+
 /**
  * @brief Get block size of cipher
  * *
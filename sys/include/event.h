@@ -47,6 +47,11 @@
  * to be queued. Thus event queues can be used safely and efficiently in combination
  * with thread flags and msg queues.
  *
+ * A single thread can also serve multiple event queues of different priority
+ * by passing them as an ordered array to event_wait_multi() or
+ * event_loop_multi(). Events are then always taken from the first non-empty
+ * queue, which saves one thread (and stack) per additional priority.
+ *
  * Examples:
  *
  * ~~~~~~~~~~~~~~~~~~~~~~~~ {.c}
@@ -96,7 +101,16 @@
 #ifndef EVENT_H
 #define EVENT_H
 
+#include <stddef.h>
 #include <stdint.h>
+/* The stdatomic.h in GCC gives compilation errors with C++
+ * see: https://gcc.gnu.org/bugzilla/show_bug.cgi?id=60932
+ */
+#ifdef __cplusplus
+#include "c11_atomics_compat.hpp"
+#else
+#include <stdatomic.h>
+#endif
 
 #include "irq.h"
 #include "thread_flags.h"
@@ -146,7 +160,16 @@ struct event {
  */
 typedef struct {
     clist_node_t event_list;    /**< list of queued events              */
-    thread_t *waiter;           /**< thread ownning event queue         */
+#if defined(__cplusplus) && !defined(DOXYGEN)
+    /* same layout, but opaque to C++ */
+    atomic_uintptr_t pending;
+    atomic_uintptr_t waiter;
+#else
+    _Atomic(clist_node_t *) pending;    /**< lock-free LIFO of freshly
+                                             posted events, moved to
+                                             event_list by the consumer */
+    _Atomic(thread_t *) waiter; /**< thread ownning event queue         */
+#endif
 } event_queue_t;
 
 /**
@@ -158,6 +181,16 @@ typedef struct {
  */
 void event_queue_init(event_queue_t *queue);
 
+/**
+ * @brief   Initialize an array of event queues
+ *
+ * This will set the calling thread as owner of all queues in @p queues.
+ *
+ * @param[out]  queues      event queue objects to initialize
+ * @param[in]   n_queues    number of queues in @p queues
+ */
+void event_queues_init(event_queue_t *queues, size_t n_queues);
+
 /**
  * @brief   Initialize an event queue not binding it to a thread
  *
@@ -165,6 +198,14 @@ void event_queue_init(event_queue_t *queue);
  */
 void event_queue_init_detached(event_queue_t *queue);
 
+/**
+ * @brief   Initialize an array of event queues not binding it to a thread
+ *
+ * @param[out]  queues      event queue objects to initialize
+ * @param[in]   n_queues    number of queues in @p queues
+ */
+void event_queues_init_detached(event_queue_t *queues, size_t n_queues);
+
 /**
  * @brief   Bind an event queue to the calling thread
  *
@@ -177,6 +218,19 @@ void event_queue_init_detached(event_queue_t *queue);
  */
 void event_queue_claim(event_queue_t *queue);
 
+/**
+ * @brief   Bind an array of event queues to the calling thread
+ *
+ * This function must only be called once and only if none of the given queues
+ * is bound to a thread yet.
+ *
+ * @pre     (queues[i].waiter == NULL for all i < n_queues)
+ *
+ * @param[out]  queues      event queue objects to bind to a thread
+ * @param[in]   n_queues    number of queues in @p queues
+ */
+void event_queues_claim(event_queue_t *queues, size_t n_queues);
+
 /**
  * @brief   Queue an event
  *
@@ -185,6 +239,11 @@ void event_queue_claim(event_queue_t *queue);
  * in the previous position on the queue. So reposting an event while it is
  * already on the queue will have no effect.
  *
+ * This function is lock-free and does not disable interrupts: the event is
+ * pushed onto the queue using atomic compare-and-swap operations, and
+ * reposting an already queued event costs a single failing compare-and-swap.
+ * This makes it suitable for posting from high-rate interrupt handlers.
+ *
  * @param[in]   queue   event queue to queue event in
  * @param[in]   event   event to queue in event queue
  */
@@ -193,7 +252,9 @@ void event_post(event_queue_t *queue, event_t *event);
 /**
  * @brief   Cancel a queued event
  *
- * This will remove a queued event from an event queue.
+ * This will remove a queued event from an event queue. An event_post() of
+ * the same event that was interrupted before it completed is not canceled,
+ * the event is queued once it completes.
  *
  * @note    Due to the underlying list implementation, this will run in O(n).
  *
@@ -231,6 +292,27 @@ event_t *event_get(event_queue_t *queue);
  */
 event_t *event_wait(event_queue_t *queue);
 
+/**
+ * @brief   Get next event from an ordered array of event queues, blocking
+ *
+ * The queues are checked starting with `queues[0]`, so an event from
+ * `queues[i]` is only returned if all queues with a lower index are empty.
+ * This allows a single thread to serve queues of different priorities,
+ * always dispatching from the highest non-empty one.
+ *
+ * This function will block until an event becomes available in any of the
+ * queues.
+ *
+ * @pre     All queues in @p queues are bound to the calling thread
+ *
+ * @param[in]   queues      event queues to get event from, highest priority
+ *                          first
+ * @param[in]   n_queues    number of queues in @p queues
+ *
+ * @returns     pointer to next event
+ */
+event_t *event_wait_multi(event_queue_t *queues, size_t n_queues);
+
 #if defined(MODULE_XTIMER) || defined(DOXYGEN)
 /**
  * @brief   Get next event from event queue, blocking until timeout expires
@@ -273,6 +355,17 @@ event_t *event_wait_timeout64(event_queue_t *queue, uint64_t timeout);
  */
 void event_loop(event_queue_t *queue);
 
+/**
+ * @brief   Simple event loop serving multiple event queues
+ *
+ * Same as @ref event_loop(), but uses @ref event_wait_multi() to always
+ * execute the next event from the first non-empty queue in @p queues.
+ *
+ * @param[in]   queues      event queues to process, highest priority first
+ * @param[in]   n_queues    number of queues in @p queues
+ */
+void event_loop_multi(event_queue_t *queues, size_t n_queues);
+
 #ifdef __cplusplus
 }
 #endif
@@ -42,19 +42,108 @@ extern "C" {
 void event_thread_init(event_queue_t *queue, char *stack, size_t stack_size,
                        unsigned priority);
 
+/**
+ * @brief   Event queues served by one thread
+ */
+typedef struct {
+    event_queue_t *queues;  /**< queues, highest priority first */
+    size_t n_queues;        /**< number of queues */
+} event_thread_multi_t;
+
+/**
+ * @brief   Convenience function for initializing a thread serving multiple
+ *          event queues
+ *
+ * The thread will run event_loop_multi() on the queues of @p multi, so events
+ * are always handled from the first non-empty queue.
+ *
+ * @note    @p multi is used by the new thread, so it must stay valid for
+ *          as long as the thread runs (e.g. static storage).
+ *
+ * @param[in]   multi       ptr to the preallocated queues to serve
+ * @param[in]   stack       ptr to stack space
+ * @param[in]   stack_size  size of stack
+ * @param[in]   priority    priority to use
+ */
+void event_thread_init_multi(const event_thread_multi_t *multi,
+                             char *stack, size_t stack_size,
+                             unsigned priority);
+
+/**
+ * @brief   Indices of the enabled event thread queues in
+ *          @ref event_thread_queues, highest priority first
+ */
+enum {
 #ifdef MODULE_EVENT_THREAD_HIGHEST
-extern event_queue_t event_queue_highest;
-#define EVENT_PRIO_HIGHEST (&event_queue_highest)
+    EVENT_QUEUE_PRIO_HIGHEST,   /**< index of the highest priority queue */
+#endif
+#ifdef MODULE_EVENT_THREAD_MEDIUM
+    EVENT_QUEUE_PRIO_MEDIUM,    /**< index of the medium priority queue */
+#endif
+#ifdef MODULE_EVENT_THREAD_LOWEST
+    EVENT_QUEUE_PRIO_LOWEST,    /**< index of the lowest priority queue */
+#endif
+    EVENT_QUEUE_PRIO_NUMOF      /**< number of enabled queues */
+};
+
+#if defined(MODULE_EVENT_THREAD_HIGHEST) || \
+    defined(MODULE_EVENT_THREAD_MEDIUM) || \
+    defined(MODULE_EVENT_THREAD_LOWEST)
+/**
+ * @brief   Event queues of the enabled event threads, highest priority first
+ *
+ * With `event_thread_single`, a single thread serves all of them using
+ * event_loop_multi(). Otherwise, each queue has its own thread.
+ *
+ * @warning With `event_thread_single`, the queue priorities only order the
+ *          events relative to each other. All handlers run at the priority
+ *          of the single thread, `EVENT_THREAD_PRIO`, which defaults to
+ *          `EVENT_THREAD_MEDIUM_PRIO` (`THREAD_PRIORITY_MAIN - 1`). So
+ *          @ref EVENT_PRIO_LOWEST handlers preempt the main thread and every
+ *          other thread below that priority, and @ref EVENT_PRIO_HIGHEST
+ *          handlers no longer preempt threads above it. A running handler
+ *          is never preempted by events of a higher priority queue.
+ */
+extern event_queue_t event_thread_queues[EVENT_QUEUE_PRIO_NUMOF];
+#endif
+
+#ifdef MODULE_EVENT_THREAD_HIGHEST
+#define EVENT_PRIO_HIGHEST (&event_thread_queues[EVENT_QUEUE_PRIO_HIGHEST])
+
+/**
+ * @brief   Event queue of the highest priority event thread
+ *
+ * @deprecated  Use @ref EVENT_PRIO_HIGHEST instead. The queue is part of
+ *              @ref event_thread_queues now, this alias will be removed after
+ *              the 2021.01 release.
+ */
+#define event_queue_highest (event_thread_queues[EVENT_QUEUE_PRIO_HIGHEST])
 #endif
 
 #ifdef MODULE_EVENT_THREAD_MEDIUM
-extern event_queue_t event_queue_medium;
-#define EVENT_PRIO_MEDIUM (&event_queue_medium)
+#define EVENT_PRIO_MEDIUM (&event_thread_queues[EVENT_QUEUE_PRIO_MEDIUM])
+
+/**
+ * @brief   Event queue of the medium priority event thread
+ *
+ * @deprecated  Use @ref EVENT_PRIO_MEDIUM instead. The queue is part of
+ *              @ref event_thread_queues now, this alias will be removed after
+ *              the 2021.01 release.
+ */
+#define event_queue_medium (event_thread_queues[EVENT_QUEUE_PRIO_MEDIUM])
 #endif
 
 #ifdef MODULE_EVENT_THREAD_LOWEST
-extern event_queue_t event_queue_lowest;
-#define EVENT_PRIO_LOWEST (&event_queue_lowest)
+#define EVENT_PRIO_LOWEST (&event_thread_queues[EVENT_QUEUE_PRIO_LOWEST])
+
+/**
+ * @brief   Event queue of the lowest priority event thread
+ *
+ * @deprecated  Use @ref EVENT_PRIO_LOWEST instead. The queue is part of
+ *              @ref event_thread_queues now, this alias will be removed after
+ *              the 2021.01 release.
+ */
+#define event_queue_lowest (event_thread_queues[EVENT_QUEUE_PRIO_LOWEST])
 #endif
 
 #ifdef __cplusplus
@@ -29,7 +29,17 @@
  *   the necessary fields, which can be extended as needed, and handlers define
  *   actions taken on timer triggers. Check out @ref evtimer_msg_event_t as
  *   example.
- * - uses @ref sys_xtimer "xtimer" as backend
+ * - uses @ref sys_ztimer "ztimer" (`ZTIMER_MSEC`, see @ref EVTIMER_ZTIMER)
+ *   as backend
+ * - keeps its events in a pairing heap ordered by deadline, so adding an
+ *   event is O(1) and removing one is O(log n) amortized, independent of how
+ *   many other events are scheduled
+ * - handles all events that are due at the same time in one pass of the
+ *   timer callback
+ *
+ * Offsets larger than @ref EVTIMER_MAX_OFFSET are split internally, so the
+ * full 32-bit offset range is safe against overflow of the 32-bit millisecond
+ * clock.
  *
  * @{
  *
@@ -43,21 +53,58 @@
 #ifndef EVTIMER_H
 #define EVTIMER_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "xtimer.h"
+#include "ztimer.h"
 #include "timex.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief   Maximum offset in milliseconds a single timer period of an evtimer
+ *          may span
+ *
+ * Events with larger offsets are re-scheduled internally after this time, so
+ * all deadlines in an evtimer stay comparable despite the 32-bit clock
+ * wrapping around.
+ */
+#define EVTIMER_MAX_OFFSET  (UINT32_MAX >> 1)
+
+/**
+ * @brief   Millisecond clock all event timers run on
+ *
+ * Can be overridden by tests, e.g. with a @ref ztimer_mock_t clock.
+ */
+#ifndef EVTIMER_ZTIMER
+#define EVTIMER_ZTIMER      ZTIMER_MSEC
+#endif
+
+/**
+ * @brief   Declaration of @ref EVTIMER_ZTIMER, if overridden
+ */
+extern ztimer_clock_t *const EVTIMER_ZTIMER;
+
 /**
  * @brief   Generic event
+ *
+ * The heap links `next`, `prev` and `child` of an event that is not scheduled
+ * must be NULL, e.g. by zero-initializing the event. evtimer resets them when
+ * the event is removed or expires, so an event can be added again right away.
  */
 typedef struct evtimer_event {
-    struct evtimer_event *next; /**< the next event in the queue */
-    uint32_t offset;            /**< offset in milliseconds from previous event */
+    struct evtimer_event *next; /**< next sibling in the event heap */
+    uint32_t offset;            /**< offset in milliseconds relative to the
+                                     call of evtimer_add(), holds the part
+                                     exceeding @ref EVTIMER_MAX_OFFSET
+                                     afterwards */
+    uint32_t deadline;          /**< absolute deadline (@ref EVTIMER_ZTIMER) */
+    struct evtimer_event *child;    /**< first child in the event heap */
+    struct evtimer_event *prev;     /**< parent, if first child, or previous
+                                         sibling in the event heap */
 } evtimer_event_t;
 
 /**
@@ -69,10 +116,10 @@ typedef void(*evtimer_callback_t)(evtimer_event_t* event);
  * @brief   Event timer
  */
 typedef struct {
-    xtimer_t timer;                 /**< Timer */
+    ztimer_t timer;                 /**< Timer */
     evtimer_callback_t callback;    /**< Handler function for this evtimer's
                                          event type */
-    evtimer_event_t *events;        /**< Event queue */
+    evtimer_event_t *events;        /**< Event heap, NULL if empty */
 } evtimer_t;
 
 /**
@@ -86,6 +133,14 @@ void evtimer_init(evtimer_t *evtimer, evtimer_callback_t handler);
 /**
  * @brief   Adds event to an event timer
  *
+ * The event will expire `event->offset` milliseconds from now. If @p event
+ * is already scheduled on @p evtimer, it is rescheduled.
+ *
+ * @pre     `event->prev` and `event->child` are NULL if @p event is not
+ *          scheduled on @p evtimer, i.e. a new event must be zeroed, see
+ *          @ref evtimer_event_t. Otherwise evtimer_is_scheduled() mistakes it
+ *          for a scheduled one and the heap gets corrupted.
+ *
  * @param[in] evtimer       An event timer
  * @param[in] event         An event
  */
@@ -99,6 +154,49 @@ void evtimer_add(evtimer_t *evtimer, evtimer_event_t *event);
  */
 void evtimer_del(evtimer_t *evtimer, evtimer_event_t *event);
 
+/**
+ * @brief   Check if an event is scheduled on an event timer
+ *
+ * @param[in] evtimer       An event timer
+ * @param[in] event         An event
+ *
+ * @return  true if @p event is scheduled and did not expire yet
+ */
+static inline bool evtimer_is_scheduled(const evtimer_t *evtimer,
+                                        const evtimer_event_t *event)
+{
+    return (event == evtimer->events) || (event->prev != NULL);
+}
+
+/**
+ * @brief   Get the time left until a scheduled event expires
+ *
+ * @pre     evtimer_is_scheduled(@p evtimer, @p event)
+ *
+ * @param[in] evtimer       An event timer
+ * @param[in] event         A scheduled event
+ *
+ * @return  time in milliseconds until @p event expires
+ */
+uint32_t evtimer_left_msec(const evtimer_t *evtimer,
+                           const evtimer_event_t *event);
+
+/**
+ * @brief   Iterate over all scheduled events of an event timer
+ *
+ * Events are returned in no particular order. The event timer must not be
+ * modified during iteration.
+ *
+ * @param[in] evtimer       An event timer
+ * @param[in] event         The event returned by the previous call or NULL
+ *                          to get the first event
+ *
+ * @return  the next scheduled event
+ * @return  NULL if there are no more events
+ */
+evtimer_event_t *evtimer_iter(const evtimer_t *evtimer,
+                              const evtimer_event_t *event);
+
 /**
  * @brief   Print overview of current state of an event timer
  *
@@ -111,7 +209,7 @@ void evtimer_print(const evtimer_t *evtimer);
  */
 static inline uint32_t evtimer_now_msec(void)
 {
-    return xtimer_now_usec64() / US_PER_MS;
+    return ztimer_now(EVTIMER_ZTIMER);
 }
 
 /**
@@ -65,6 +65,46 @@ void isrpipe_init(isrpipe_t *isrpipe, uint8_t *buf, size_t bufsize);
  */
 int isrpipe_write_one(isrpipe_t *isrpipe, uint8_t c);
 
+/**
+ * @brief   Put a block of data into the isrpipe's buffer
+ *
+ * @param[in]   isrpipe     isrpipe object to operate on
+ * @param[in]   buf         data to add to isrpipe buffer
+ * @param[in]   count       number of bytes to add
+ *
+ * @returns     number of bytes added, less than @p count if the buffer was
+ *              full
+ */
+int isrpipe_write(isrpipe_t *isrpipe, const uint8_t *buf, size_t count);
+
+/**
+ * @brief   Get free regions of the isrpipe's buffer to write to directly
+ *
+ * Call isrpipe_commit() to hand the written bytes to the reader.
+ *
+ * @see     tsrb_reserve_iov()
+ *
+ * @param[in]   isrpipe     isrpipe object to operate on
+ * @param[out]  iov         up to two regions, in order
+ * @param[in]   count       max number of bytes to reserve
+ *
+ * @returns     number of bytes in @p iov
+ */
+static inline size_t isrpipe_reserve_iov(isrpipe_t *isrpipe,
+                                         struct iovec iov[2], size_t count)
+{
+    return tsrb_reserve_iov(&isrpipe->tsrb, iov, count);
+}
+
+/**
+ * @brief   Hand bytes written to the regions of isrpipe_reserve_iov() to the
+ *          reader
+ *
+ * @param[in]   isrpipe     isrpipe object to operate on
+ * @param[in]   count       number of bytes written
+ */
+void isrpipe_commit(isrpipe_t *isrpipe, size_t count);
+
 /**
  * @brief   Read data from isrpipe (blocking)
  *
@@ -76,6 +116,36 @@ int isrpipe_write_one(isrpipe_t *isrpipe, uint8_t c);
  */
 int isrpipe_read(isrpipe_t *isrpipe, uint8_t *buf, size_t count);
 
+/**
+ * @brief   Get regions of the isrpipe's buffer holding received data
+ *          (blocking)
+ *
+ * Blocks until data is available.  The data stays in the buffer until it is
+ * removed by isrpipe_drop().
+ *
+ * @see     tsrb_peek_iov()
+ *
+ * @param[in]   isrpipe    isrpipe object to operate on
+ * @param[out]  iov        up to two regions, in order
+ * @param[in]   count      max number of bytes to peek at
+ *
+ * @returns     number of bytes in @p iov
+ */
+size_t isrpipe_peek_iov(isrpipe_t *isrpipe, struct iovec iov[2], size_t count);
+
+/**
+ * @brief   Remove data from the isrpipe's buffer
+ *
+ * @param[in]   isrpipe    isrpipe object to operate on
+ * @param[in]   count      max number of bytes to remove
+ *
+ * @returns     number of bytes removed
+ */
+static inline int isrpipe_drop(isrpipe_t *isrpipe, size_t count)
+{
+    return tsrb_drop(&isrpipe->tsrb, count);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -12,6 +12,24 @@
  * @{
  *
  * @brief       pseudo dynamic allocation in static memory arrays
+ *
+ * A memarray is an object pool: it hands out fixed-size elements from one or
+ * more user provided arrays in O(1), by keeping the free elements in a singly
+ * linked list stored within the elements themselves. Elements that were never
+ * allocated are taken from the end of the array, so a memarray can also be
+ * defined statically with @ref MEMARRAY_INIT without any initialization at
+ * run time.
+ *
+ * Every pool keeps track of the number of allocated elements, its high-water
+ * mark and the number of failed allocations.
+ *
+ * With the `memarray_grow` module, a pool can be configured to add a chunk
+ * of elements allocated from the heap when exhausted, see
+ * memarray_set_grow(). These chunks are never returned to the heap.
+ *
+ * @note    memarray is not thread-safe, users have to serialize accesses to
+ *          a pool themselves.
+ *
  * @author      Tobias Heider <heidert@nm.ifi.lmu.de>
  */
 
@@ -29,11 +47,32 @@ extern "C" {
  * @brief Memory pool
  */
 typedef struct {
-    void *free_data;    /**< memory pool data / head of the free list */
+    void *free_data;    /**< head of the free list */
+    void *unused;       /**< elements never allocated so far */
+    size_t unused_num;  /**< number of elements at memarray_t::unused */
     size_t size;        /**< size of single list element */
     size_t num;         /**< max number of elements in list */
+    size_t used;        /**< number of allocated elements */
+    size_t max_used;    /**< high-water mark of memarray_t::used */
+    size_t failed;      /**< number of failed allocations */
+#if defined(MODULE_MEMARRAY_GROW) || defined(DOXYGEN)
+    size_t grow;        /**< elements to allocate from the heap when
+                         *   exhausted, 0 to not grow */
+#endif
 } memarray_t;
 
+/**
+ * @brief   Static initializer for a memarray pool
+ *
+ * @pre `SIZE >= sizeof(void*)`
+ *
+ * @param[in]   DATA    array to take the elements from
+ * @param[in]   SIZE    size of a single element in @p DATA
+ * @param[in]   NUM     number of elements in @p DATA
+ */
+#define MEMARRAY_INIT(DATA, SIZE, NUM) \
+    { .unused = (DATA), .unused_num = (NUM), .size = (SIZE), .num = (NUM) }
+
 /**
  * @brief Initialize memarray pool with free list
  *
@@ -72,6 +111,84 @@ void *memarray_alloc(memarray_t *mem);
  */
 void memarray_free(memarray_t *mem, void *ptr);
 
+/**
+ * @brief Add elements to a memarray pool
+ *
+ * @pre `mem != NULL`
+ * @pre `data != NULL`
+ *
+ * @param[in,out] mem   memarray pool to extend
+ * @param[in]     data  pointer to user-allocated data with elements of
+ *                      memarray_t::size bytes
+ * @param[in]     num   number of elements in data
+ */
+void memarray_extend(memarray_t *mem, void *data, size_t num);
+
+#if defined(MODULE_MEMARRAY_GROW) || defined(DOXYGEN)
+/**
+ * @brief Let a memarray pool grow from the heap when exhausted
+ *
+ * @param[in,out] mem   memarray pool to configure
+ * @param[in]     num   number of elements to allocate at once, 0 to disable
+ *                      growing
+ */
+static inline void memarray_set_grow(memarray_t *mem, size_t num)
+{
+    mem->grow = num;
+}
+#endif
+
+/**
+ * @brief Get the number of elements that can still be allocated
+ *
+ * @note    Elements the pool would be able to add from the heap are not
+ *          included.
+ *
+ * @param[in] mem   memarray pool
+ *
+ * @return number of free elements
+ */
+static inline size_t memarray_available(const memarray_t *mem)
+{
+    return mem->num - mem->used;
+}
+
+/**
+ * @brief Get the number of allocated elements
+ *
+ * @param[in] mem   memarray pool
+ *
+ * @return number of allocated elements
+ */
+static inline size_t memarray_used(const memarray_t *mem)
+{
+    return mem->used;
+}
+
+/**
+ * @brief Get the maximum number of elements allocated at the same time
+ *
+ * @param[in] mem   memarray pool
+ *
+ * @return high-water mark of allocated elements
+ */
+static inline size_t memarray_max_used(const memarray_t *mem)
+{
+    return mem->max_used;
+}
+
+/**
+ * @brief Get the number of failed allocations
+ *
+ * @param[in] mem   memarray pool
+ *
+ * @return number of allocations that returned NULL
+ */
+static inline size_t memarray_failed(const memarray_t *mem)
+{
+    return mem->failed;
+}
+
 #ifdef __cplusplus
 }
 #endif
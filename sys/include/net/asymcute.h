@@ -26,6 +26,19 @@
  * - Subscription to topics
  * - Pre-defined topic IDs as well as short and normal topic names
  *
+ * # Publishing bursts
+ *
+ * Any number of QoS 1 publishes can be issued on a connection, each with its
+ * own request context, but at most @ref ASYMCUTE_PUBLISH_WINDOW of them are in
+ * flight at a time. The others are queued and sent as soon as PUBACKs arrive.
+ * asymcute_publishv() sends the payload from the caller's buffers instead of
+ * copying it into the request context.
+ *
+ * Topic IDs assigned by the gateway are remembered per connection (see
+ * @ref ASYMCUTE_TOPIC_CACHE_SIZE). After reconnecting to the same gateway
+ * without clean session, registering a known topic name completes without
+ * sending a REGISTER message.
+ *
  * Missing features:
  * - Gateway discovery process not implemented
  * - Last will feature not implemented
@@ -48,6 +61,7 @@
 #include <stdbool.h>
 
 #include "assert.h"
+#include "iolist.h"
 #include "event/timeout.h"
 #include "event/callback.h"
 #include "net/mqttsn.h"
@@ -143,6 +157,24 @@ extern "C" {
 #define ASYMCUTE_N_RETRY            (3U)
 #endif
 
+#ifndef ASYMCUTE_PUBLISH_WINDOW
+/**
+ * @brief   Maximum number of QoS 1 publishes in flight per connection
+ *
+ * Further QoS 1 publishes are queued until PUBACKs are received.
+ */
+#define ASYMCUTE_PUBLISH_WINDOW     (4U)
+#endif
+
+#ifndef ASYMCUTE_TOPIC_CACHE_SIZE
+/**
+ * @brief   Number of topic IDs remembered per connection
+ *
+ * Set to 0 to disable the topic ID cache.
+ */
+#define ASYMCUTE_TOPIC_CACHE_SIZE   (4U)
+#endif
+
 /**
  * @brief   Return values used by public Asymcute functions
  */
@@ -243,10 +275,20 @@ struct asymcute_req {
     event_timeout_t to_timer;       /**< timeout timer */
     uint8_t data[ASYMCUTE_BUFSIZE]; /**< buffer holding the request's data */
     size_t data_len;                /**< length of the request packet in byte */
+    const iolist_t *payload;        /**< payload sent after @p data, not
+                                     *   copied */
     uint16_t msg_id;                /**< used message id for this request */
     uint8_t retry_cnt;              /**< retransmission counter */
 };
 
+/**
+ * @brief   Topic ID remembered by a connection
+ */
+typedef struct {
+    uint16_t id;                            /**< topic ID, 0 if unused */
+    char name[ASYMCUTE_TOPIC_MAXLEN + 1];   /**< topic name */
+} asymcute_topic_cache_t;
+
 /**
  * @brief   Asymcute connection context
  */
@@ -256,6 +298,8 @@ struct asymcute_con {
     sock_udp_ep_t server_ep;            /**< the gateway's UDP endpoint */
     asymcute_req_t *pending;            /**< list holding pending requests */
     asymcute_sub_t *subscriptions;      /**< list holding active subscriptions */
+    asymcute_req_t *pub_queue;          /**< QoS 1 publishes waiting for the
+                                         *   publish window */
     asymcute_evt_cb_t user_cb;          /**< event callback provided by user */
     event_callback_t keepalive_evt;     /**< keep alive event */
     event_timeout_t keepalive_timer;    /**< keep alive timer */
@@ -263,6 +307,11 @@ struct asymcute_con {
                                          *   connection */
     uint8_t keepalive_retry_cnt;        /**< keep alive transmission counter */
     uint8_t state;                      /**< connection state */
+    uint8_t pub_inflight;               /**< QoS 1 publishes in flight */
+#if ASYMCUTE_TOPIC_CACHE_SIZE || defined(DOXYGEN)
+    /** remembered topic IDs */
+    asymcute_topic_cache_t topic_cache[ASYMCUTE_TOPIC_CACHE_SIZE];
+#endif
     uint8_t rxbuf[ASYMCUTE_BUFSIZE];    /**< connection specific receive buf */
     char cli_id[MQTTSN_CLI_ID_MAXLEN + 1];  /**< buffer to store client ID */
 };
@@ -477,6 +526,10 @@ int asymcute_disconnect(asymcute_con_t *con, asymcute_req_t *req);
  * @param[in,out] req   request context to use for REGISTER procedure
  * @param[in,out] topic topic to register
  *
+ * The topic ID is taken from the topic ID cache if possible, without sending
+ * a REGISTER message. The result is reported to the event callback in either
+ * case.
+ *
  * @return  ASYMCUTE_OK if REGISTER message has been sent
  * @return  ASYMCUTE_REGERR if topic is already registered
  * @return  ASYMCUTE_GWERR if not connected to a gateway
@@ -495,7 +548,7 @@ int asymcute_register(asymcute_con_t *con, asymcute_req_t *req,
  * @param[in] data_len  size of @p data in bytes
  * @param[in] flags     additional flags (QoS level, DUP, and RETAIN)
  *
- * @return  ASYMCUTE_OK if PUBLISH message has been sent
+ * @return  ASYMCUTE_OK if PUBLISH message has been sent or queued
  * @return  ASYMCUTE_NOTSUP if unsupported flags have been set
  * @return  ASYMCUTE_OVERFLOW if data does not fit into transmit buffer
  * @return  ASYMCUTE_REGERR if given topic is not registered
@@ -506,6 +559,34 @@ int asymcute_publish(asymcute_con_t *con, asymcute_req_t *req,
                      const asymcute_topic_t *topic,
                      const void *data, size_t data_len, uint8_t flags);
 
+/**
+ * @brief   Publish data gathered from several buffers to the given topic
+ *
+ * Unlike asymcute_publish(), the payload is not copied into @p req, so it is
+ * not limited by @ref ASYMCUTE_BUFSIZE. It is read again for
+ * retransmissions.
+ *
+ * @warning The buffers in @p data must not be changed until the request is
+ *          finished, i.e., until the function returned for QoS 0 or until
+ *          the event callback was called for @p req for QoS 1.
+ *
+ * @param[in] con       connection to use
+ * @param[in,out] req   request context used for PUBLISH procedure
+ * @param[in] topic     publish data to this topic
+ * @param[in] data      payload to send, may be NULL
+ * @param[in] flags     additional flags (QoS level, DUP, and RETAIN)
+ *
+ * @return  ASYMCUTE_OK if PUBLISH message has been sent or queued
+ * @return  ASYMCUTE_NOTSUP if unsupported flags have been set
+ * @return  ASYMCUTE_OVERFLOW if data does not fit into a message
+ * @return  ASYMCUTE_REGERR if given topic is not registered
+ * @return  ASYMCUTE_GWERR if not connected to a gateway
+ * @return  ASYMCUTE_BUSY if the given request context is already in use
+ */
+int asymcute_publishv(asymcute_con_t *con, asymcute_req_t *req,
+                      const asymcute_topic_t *topic, const iolist_t *data,
+                      uint8_t flags);
+
 /**
  * @brief   Subscribe to a given topic
  *
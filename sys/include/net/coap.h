@@ -35,19 +35,42 @@ extern "C" {
  * @name    CoAP option numbers
  * @{
  */
+#define COAP_OPT_IF_MATCH       (1)
 #define COAP_OPT_URI_HOST       (3)
+#define COAP_OPT_ETAG           (4)
+#define COAP_OPT_IF_NONE_MATCH  (5)
 #define COAP_OPT_OBSERVE        (6)
+#define COAP_OPT_URI_PORT       (7)
 #define COAP_OPT_LOCATION_PATH  (8)
 #define COAP_OPT_URI_PATH       (11)
 #define COAP_OPT_CONTENT_FORMAT (12)
+#define COAP_OPT_MAX_AGE        (14)
 #define COAP_OPT_URI_QUERY      (15)
+#define COAP_OPT_ACCEPT         (17)
 #define COAP_OPT_LOCATION_QUERY (20)
 #define COAP_OPT_BLOCK2         (23)
 #define COAP_OPT_BLOCK1         (27)
+#define COAP_OPT_SIZE2          (28)
 #define COAP_OPT_PROXY_URI      (35)
 #define COAP_OPT_PROXY_SCHEME   (39)
+#define COAP_OPT_SIZE1          (60)
 /** @} */
 
+/**
+ * @brief   Maximum length of a token
+ */
+#define COAP_TOKEN_LENGTH_MAX   (8U)
+
+/**
+ * @brief   Maximum length of an ETag option value
+ */
+#define COAP_ETAG_LENGTH_MAX    (8U)
+
+/**
+ * @brief   Max-Age of a response without Max-Age option, in seconds
+ */
+#define COAP_MAX_AGE_DEFAULT    (60U)
+
 /**
  * @name    Message types -- confirmable, non-confirmable, etc.
  * @{
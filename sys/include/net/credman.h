@@ -21,6 +21,22 @@
  *              The user must make sure that these pointers are valid during the
  *              lifetime of the application.
  *
+ * Credentials are found by tag and type through a hash index, so the time of
+ * a lookup does not depend on the number of credentials in the pool.
+ *
+ * Persistent store
+ * ================
+ *
+ * With the `credman_vfs` module, credentials can be saved to a directory of a
+ * mounted file system with @ref credman_vfs_save(). After
+ * @ref credman_vfs_init() selected the directory, @ref credman_get() loads a
+ * credential that is not in the pool from that directory on demand, so a
+ * device does not need to provision all its credentials on every boot.
+ * Loaded credentials are kept in a cache of @ref CREDMAN_VFS_CACHE_SIZE
+ * entries, which own the key material; when the cache or the credential pool
+ * is full, loaded credentials are removed from the pool again in round-robin
+ * order to make room for a newly loaded one.
+ *
  * @author      Aiman Ismail <muhammadaimanbin.ismail@haw-hamburg.de>
  */
 
@@ -41,6 +57,63 @@ extern "C" {
 #define CREDMAN_MAX_CREDENTIALS  (2)
 #endif
 
+/**
+ * @brief Number of slots of the hash index over the credential pool
+ *
+ * Must be greater than @ref CREDMAN_MAX_CREDENTIALS. Lookups slow down when
+ * the pool is full and the index is not much bigger than the pool.
+ */
+#ifndef CREDMAN_INDEX_SIZE
+#define CREDMAN_INDEX_SIZE  (2 * CREDMAN_MAX_CREDENTIALS)
+#endif
+
+#if defined(MODULE_CREDMAN_VFS) || defined(DOXYGEN)
+/**
+ * @brief Number of credentials loaded from the persistent store that are
+ *        kept at the same time
+ */
+#ifndef CREDMAN_VFS_CACHE_SIZE
+#define CREDMAN_VFS_CACHE_SIZE  (2)
+#endif
+
+/**
+ * @brief Maximum length of the path of a stored credential
+ *
+ * The path is the directory given to @ref credman_vfs_init() followed by a
+ * slash and a file name of five characters.
+ */
+#ifndef CREDMAN_VFS_PATH_MAX
+#define CREDMAN_VFS_PATH_MAX    (63)
+#endif
+
+/**
+ * @brief Size of a ECDSA key (and of either part of a public key) in bytes
+ */
+#ifndef CREDMAN_VFS_ECDSA_KEY_SIZE
+#define CREDMAN_VFS_ECDSA_KEY_SIZE  (32)
+#endif
+
+/**
+ * @brief Maximum number of client public keys of a stored ECDSA credential
+ */
+#ifndef CREDMAN_VFS_CLIENT_KEYS_MAX
+#define CREDMAN_VFS_CLIENT_KEYS_MAX (1)
+#endif
+
+/**
+ * @brief Maximum size of a credential in the persistent store in bytes
+ *
+ * A PSK credential takes 4 bytes plus the length of its key, ID and hint, an
+ * ECDSA credential takes 2 bytes plus 3 + 2 * ecdsa_params_t::client_keys_size
+ * times @ref CREDMAN_VFS_ECDSA_KEY_SIZE. The default fits every ECDSA
+ * credential that can be stored.
+ */
+#ifndef CREDMAN_VFS_BUF_SIZE
+#define CREDMAN_VFS_BUF_SIZE    (2 + (3 + 2 * CREDMAN_VFS_CLIENT_KEYS_MAX) * \
+                                 CREDMAN_VFS_ECDSA_KEY_SIZE)
+#endif
+#endif /* MODULE_CREDMAN_VFS || DOXYGEN */
+
 /**
  * @brief Buffer of the credential
  */
@@ -128,10 +201,14 @@ enum {
 /**
  * @brief Adds a credential to the credential pool
  *
+ * A tag may hold several PSK credentials, one for each identity, e.g. the
+ * clients a DTLS server accepts.
+ *
  * @param[in] credential    Credential to add.
  *
  * @return CREDMAN_OK on success
- * @return CREDMAN_EXIST if credential of @p tag and @p type already exist
+ * @return CREDMAN_EXIST if credential of @p tag and @p type already exist,
+ *         for PSK credentials with the same identity
  * @return CREDMAN_NO_SPACE if credential pool is full
  * @return CREDMAN_TYPE_UNKNOWN if @p credential has unknown
  *         credman_credential_t::type
@@ -149,22 +226,51 @@ int credman_add(const credman_credential_t *credential);
 /**
  * @brief Gets a credential from credential pool
  *
+ * With the `credman_vfs` module, a credential not found in the pool is loaded
+ * from the persistent store. The buffers of a loaded credential stay valid
+ * until it is evicted by @ref CREDMAN_VFS_CACHE_SIZE other loads or deleted.
+ *
  * @param[out] credential   Found credential
  * @param[in] tag           Tag of credential to get
  * @param[in] type          Type of credential to get
  *
  * @return CREDMAN_OK on success
  * @return CREDMAN_NOT_FOUND if no credential with @p tag and @p type found
+ * @return CREDMAN_NO_SPACE if a stored credential was found, but the
+ *         credential pool is full and holds no loaded credential to evict
  * @return CREDMAN_ERROR on other errors
  */
 int credman_get(credman_credential_t *credential, credman_tag_t tag,
                 credman_type_t type);
 
+/**
+ * @brief Gets the PSK credential of an identity from the credential pool
+ *
+ * With the `credman_vfs` module, the PSK credential stored for @p tag is
+ * loaded if the pool holds none of @p tag. @ref credman_get() returns any of
+ * the PSK credentials of @p tag.
+ *
+ * @param[out] credential   Found credential
+ * @param[in] tag           Tag of credential to get
+ * @param[in] id            Identity of the credential
+ * @param[in] id_len        Length of @p id
+ *
+ * @return CREDMAN_OK on success
+ * @return CREDMAN_NOT_FOUND if no PSK credential with @p tag and @p id found
+ * @return CREDMAN_NO_SPACE if a stored credential was found, but the
+ *         credential pool is full and holds no loaded credential to evict
+ * @return CREDMAN_ERROR on other errors
+ */
+int credman_get_psk(credman_credential_t *credential, credman_tag_t tag,
+                    const void *id, size_t id_len);
+
 /**
  * @brief Delete a credential from the credential pool. Does nothing if
  *        credential with credman_credential_t::tag @p tag and
  *        credman_credential_t::type @p type is not found.
  *
+ * All PSK credentials of @p tag are deleted.
+ *
  * @param[in] tag           Tag of the credential
  * @param[in] type          Type of the credential
  */
@@ -179,6 +285,55 @@ void credman_delete(credman_tag_t tag, credman_type_t type);
  */
 int credman_get_used_count(void);
 
+#if defined(MODULE_CREDMAN_VFS) || defined(DOXYGEN)
+/**
+ * @brief Selects the directory of the persistent credential store
+ *
+ * The directory must exist on a mounted file system. Credentials already
+ * loaded from a previously selected directory remain in the pool.
+ *
+ * @param[in] dir   Path of the directory of at most
+ *                  @ref CREDMAN_VFS_PATH_MAX - 6 characters, must stay valid
+ *                  while in use. NULL disables the persistent store.
+ */
+void credman_vfs_init(const char *dir);
+
+/**
+ * @brief Saves a credential of the credential pool to the persistent store
+ *
+ * An existing stored credential with the same tag and type is replaced, so
+ * only one of several PSK credentials of @p tag can be stored.
+ *
+ * @param[in] tag           Tag of the credential
+ * @param[in] type          Type of the credential
+ *
+ * @return CREDMAN_OK on success
+ * @return CREDMAN_NOT_FOUND if no credential with @p tag and @p type is in
+ *         the credential pool
+ * @return CREDMAN_INVALID if the credential does not fit into
+ *         @ref CREDMAN_VFS_BUF_SIZE or has more than
+ *         @ref CREDMAN_VFS_CLIENT_KEYS_MAX client keys
+ * @return CREDMAN_ERROR if no store is selected or writing failed
+ */
+int credman_vfs_save(credman_tag_t tag, credman_type_t type);
+
+/**
+ * @brief Removes a credential from the persistent store
+ *
+ * The credential is also removed from the credential pool, a PSK credential
+ * along with all others of @p tag.
+ *
+ * @param[in] tag           Tag of the credential
+ * @param[in] type          Type of the credential
+ *
+ * @return CREDMAN_OK on success
+ * @return CREDMAN_NOT_FOUND if no credential with @p tag and @p type is in
+ *         the persistent store
+ * @return CREDMAN_ERROR if no store is selected or removing failed
+ */
+int credman_vfs_remove(credman_tag_t tag, credman_type_t type);
+#endif /* MODULE_CREDMAN_VFS || DOXYGEN */
+
 #ifdef TEST_SUITES
 /**
  * @brief Empties the credential pool
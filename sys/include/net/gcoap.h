@@ -153,8 +153,10 @@
  *
  * A CoAP client may register for Observe notifications for any resource that
  * an application has registered with gcoap. An application does not need to
- * take any action to support Observe client registration. However, gcoap
- * limits registration for a given resource to a _single_ observer.
+ * take any action to support Observe client registration. Any number of
+ * clients may observe the same resource, up to a total of
+ * CONFIG_GCOAP_OBS_REGISTRATIONS_MAX registrations for at most
+ * CONFIG_GCOAP_OBS_RESOURCES_MAX distinct resources.
  *
  * It is [suggested](https://tools.ietf.org/html/rfc7641#section-6) that a
  * server adds the 'obs' attribute to resources that are useful for observation
@@ -190,6 +192,20 @@
  * Finally, call gcoap_obs_send() for the resource, with the sum of the
  * metadata length and payload length for the representation.
  *
+ * The notification is serialized only once. gcoap_obs_send() sends it to each
+ * observer of the resource, only rewriting the header in the buffer with the
+ * token and message ID for the observer, and restores it afterwards.
+ *
+ * ### Notifications generated by gcoap ###
+ *
+ * Alternatively, call gcoap_obs_notify() when the resource has changed. gcoap
+ * then generates the notification from its own thread by calling the resource
+ * handler for a GET request, and sends it to all observers. Notifications for
+ * a resource are sent at most once per CONFIG_GCOAP_OBS_NOTIFY_INTERVAL.
+ * Changes in between are coalesced into a single notification, sent when the
+ * interval has passed, so a fast-changing resource does not flood the network
+ * and the observers always receive its latest state.
+ *
  * ### Other considerations ###
  *
  * By default, the value for the Observe option in a notification is three
@@ -336,7 +352,40 @@
  *
  * ### Proxy Server Handling
  *
- * Not implemented yet.
+ * Use the `gcoap_forward_proxy` module to forward requests carrying a
+ * `Proxy-Uri`, see @ref net_gcoap_forward_proxy.
+ *
+ * ## Response Cache ##
+ *
+ * With the `nanocoap_cache` module, gcoap answers requests to its own
+ * resources from the @ref net_nanocoap_cache while the response is fresh. A
+ * response to GET or FETCH is only cached if the resource handler adds a
+ * Max-Age option. A successful request with another method removes the
+ * cached response for the resource.
+ *
+ * ## DTLS as transport security ##
+ *
+ * With the `gcoap_dtls` module, gcoap communicates via CoAPS (CoAP over DTLS)
+ * only, on CONFIG_GCOAPS_PORT. It uses the @ref net_sock_dtls implementation
+ * selected by the application, e.g. `tinydtls_sock_dtls`, with the
+ * @ref net_credman credentials tagged CONFIG_GCOAP_DTLS_CREDENTIAL_TAG.
+ * Requests are sent and received exactly as without DTLS.
+ *
+ * Established sessions are kept in a table of CONFIG_GCOAP_DTLS_MAX_SESSIONS
+ * entries, looked up by hash of the remote endpoint. A request to a server
+ * with a cached session needs no new handshake; when the table is full, the
+ * least recently used session is closed. The DTLS implementation must allow
+ * for as many peers, e.g. with `CONFIG_DTLS_PEER_MAX` for tinydtls.
+ *
+ * Handshakes do not block the gcoap thread. A separate thread owns the DTLS
+ * sock: it receives and decrypts the records and runs the handshake
+ * computations at GCOAP_DTLS_PRIO, below the priority of the gcoap thread.
+ * Outgoing messages are copied to a queue of CONFIG_GCOAP_DTLS_TX_QUEUE_SIZE
+ * entries, from which this thread encrypts and sends them. A request to a server without a session starts the
+ * handshake and is sent once it completes; a non-confirmable request is
+ * dropped instead. A confirmable request restarts a handshake that was not
+ * completed within CONFIG_GCOAP_DTLS_HANDSHAKE_TIMEOUT_USEC when it is
+ * retransmitted.
  *
  * ## Implementation Notes ##
  *
@@ -345,8 +394,20 @@
  * We take advantage of RIOT's asynchronous messaging by using an xtimer to wait
  * for a response, so the gcoap thread does not block while waiting. The user is
  * notified via the same callback, whether the message is received or the wait
- * times out. We track the response with an entry in the
- * `_coap_state.open_reqs` array.
+ * times out. We track the response with a memo allocated from the
+ * `_coap_state.open_reqs` pool. Open memos are hashed by remote endpoint and
+ * token, so matching a response does not depend on the number of
+ * outstanding requests.
+ *
+ * ### Retransmission timeouts ###
+ *
+ * By default a confirmable request is retransmitted with the fixed initial
+ * timeout and binary exponential backoff of RFC 7252. With the `gcoap_cocoa`
+ * pseudomodule, gcoap instead estimates the retransmission timeout (RTO) per
+ * peer from measured round trip times, following the CoCoA algorithm of
+ * draft-ietf-core-cocoa: a strong estimator uses responses to requests that
+ * were not retransmitted, a weak estimator those received after up to two
+ * retransmissions. The backoff factor then depends on the RTO.
  *
  * ## Implementation Status ##
  * gcoap includes server and client capability. Available features include:
@@ -456,6 +517,78 @@ extern "C" {
 #ifndef CONFIG_GCOAP_REQ_WAITING_MAX
 #define CONFIG_GCOAP_REQ_WAITING_MAX   (2)
 #endif
+
+/**
+ * @brief   Number of hash buckets to look up requests awaiting a response
+ *
+ * Requests are looked up by remote endpoint and token. Must be a power of
+ * two.
+ */
+#ifndef CONFIG_GCOAP_REQ_HASH_BUCKETS
+#define CONFIG_GCOAP_REQ_HASH_BUCKETS  (4)
+#endif
+
+/**
+ * @brief   Number of peers to keep retransmission timeout estimates for
+ *
+ * Only used with the `gcoap_cocoa` module. Peers are mapped by hash, a peer
+ * mapped to an occupied entry replaces its previous peer. Must be a power of
+ * two.
+ */
+#ifndef CONFIG_GCOAP_COCOA_PEERS
+#define CONFIG_GCOAP_COCOA_PEERS       (8)
+#endif
+
+/**
+ * @brief   CoAPS server port; use RFC 7252 default if not defined
+ *
+ * Only used with the `gcoap_dtls` module.
+ */
+#ifndef CONFIG_GCOAPS_PORT
+#define CONFIG_GCOAPS_PORT             (5684)
+#endif
+
+/**
+ * @brief   Credential tag of the DTLS credentials used by gcoap
+ */
+#ifndef CONFIG_GCOAP_DTLS_CREDENTIAL_TAG
+#define CONFIG_GCOAP_DTLS_CREDENTIAL_TAG    (10)
+#endif
+
+/**
+ * @brief   Maximum number of DTLS sessions kept by gcoap
+ */
+#ifndef CONFIG_GCOAP_DTLS_MAX_SESSIONS
+#define CONFIG_GCOAP_DTLS_MAX_SESSIONS      (4)
+#endif
+
+/**
+ * @brief   Number of hash buckets to look up DTLS sessions
+ *
+ * Must be a power of two.
+ */
+#ifndef CONFIG_GCOAP_DTLS_SESSION_BUCKETS
+#define CONFIG_GCOAP_DTLS_SESSION_BUCKETS   (4)
+#endif
+
+/**
+ * @brief   Time after which a DTLS handshake started by gcoap is restarted
+ *
+ * Handshakes with ECC can take several seconds on constrained devices.
+ */
+#ifndef CONFIG_GCOAP_DTLS_HANDSHAKE_TIMEOUT_USEC
+#define CONFIG_GCOAP_DTLS_HANDSHAKE_TIMEOUT_USEC    (30 * US_PER_SEC)
+#endif
+
+/**
+ * @brief   Number of messages waiting to be encrypted and sent via DTLS
+ *
+ * A message is dropped if the queue is full; confirmable messages are
+ * retransmitted as usual.
+ */
+#ifndef CONFIG_GCOAP_DTLS_TX_QUEUE_SIZE
+#define CONFIG_GCOAP_DTLS_TX_QUEUE_SIZE     (2)
+#endif
 /** @} */
 
 /**
@@ -535,6 +668,10 @@ extern "C" {
 /**
  * @ingroup net_gcoap_conf
  * @brief   Maximum number of Observe clients
+ *
+ * @deprecated  Unused, observers are tracked per registration, see
+ *              CONFIG_GCOAP_OBS_REGISTRATIONS_MAX. Will be removed after the
+ *              2020.10 release.
  */
 #ifndef CONFIG_GCOAP_OBS_CLIENTS_MAX
 #define CONFIG_GCOAP_OBS_CLIENTS_MAX   (2)
@@ -548,6 +685,34 @@ extern "C" {
 #define CONFIG_GCOAP_OBS_REGISTRATIONS_MAX     (2)
 #endif
 
+/**
+ * @ingroup net_gcoap_conf
+ * @brief   Maximum number of resources observed at the same time
+ */
+#ifndef CONFIG_GCOAP_OBS_RESOURCES_MAX
+#define CONFIG_GCOAP_OBS_RESOURCES_MAX         (2)
+#endif
+
+/**
+ * @ingroup net_gcoap_conf
+ * @brief   Number of hash buckets to look up Observe registrations
+ *
+ * Registrations are looked up by client endpoint and token. Must be a power
+ * of two.
+ */
+#ifndef CONFIG_GCOAP_OBS_HASH_BUCKETS
+#define CONFIG_GCOAP_OBS_HASH_BUCKETS          (4)
+#endif
+
+/**
+ * @ingroup net_gcoap_conf
+ * @brief   Minimum interval between notifications of gcoap_obs_notify() in
+ *          microseconds
+ */
+#ifndef CONFIG_GCOAP_OBS_NOTIFY_INTERVAL
+#define CONFIG_GCOAP_OBS_NOTIFY_INTERVAL       (1000000U)
+#endif
+
 /**
  * @name    States for the memo used to track Observe registrations
  * @{
@@ -609,6 +774,28 @@ extern "C" {
                           + sizeof(coap_pkt_t))
 #endif
 
+/**
+ * @brief   Stack size for the DTLS thread of the `gcoap_dtls` module
+ *
+ * Handshakes with ECC need a large stack.
+ */
+#ifndef GCOAP_DTLS_STACK_SIZE
+#define GCOAP_DTLS_STACK_SIZE (THREAD_STACKSIZE_LARGE + DEBUG_EXTRA_STACKSIZE)
+#endif
+
+/**
+ * @brief   Priority of the DTLS thread of the `gcoap_dtls` module
+ *
+ * Must stay lower than the priority of the gcoap thread
+ * (THREAD_PRIORITY_MAIN - 1): a handshake may compute for a long time, and
+ * the DTLS thread would delay the gcoap thread in the meantime if it had the
+ * same or a higher priority, e.g. retransmissions and responses of sessions
+ * that are established already.
+ */
+#ifndef GCOAP_DTLS_PRIO
+#define GCOAP_DTLS_PRIO         (THREAD_PRIORITY_MAIN)
+#endif
+
 /**
  * @ingroup net_gcoap_conf
  * @brief   Count of PDU buffers available for resending confirmable messages
@@ -688,6 +875,7 @@ typedef struct {
  */
 struct gcoap_request_memo {
     unsigned state;                     /**< State of this memo, a GCOAP_MEMO... */
+    gcoap_request_memo_t *next;         /**< Next memo in the lookup bucket */
     int send_limit;                     /**< Remaining resends, 0 if none;
                                              GCOAP_SEND_LIMIT_NON if non-confirmable */
     union {
@@ -697,21 +885,34 @@ struct gcoap_request_memo {
     } msg;                              /**< Request message data; if confirmable,
                                              supports resending message */
     sock_udp_ep_t remote_ep;            /**< Remote endpoint */
+    uint8_t token[GCOAP_TOKENLEN_MAX];  /**< Token of the request */
+    uint8_t token_len;                  /**< Length of token */
     gcoap_resp_handler_t resp_handler;  /**< Callback for the response */
     void *context;                      /**< ptr to user defined context data */
     event_timeout_t resp_evt_tmout;     /**< Limits wait for response */
     event_callback_t resp_tmout_cb;     /**< Callback for response timeout */
+#if defined(MODULE_GCOAP_COCOA) || defined(DOXYGEN)
+    uint32_t send_time;                 /**< Time of first transmission */
+    uint32_t timeout;                   /**< Current retransmission timeout */
+#endif
 };
 
+/**
+ * @brief   Observe memo forward declaration
+ */
+typedef struct gcoap_observe_memo gcoap_observe_memo_t;
+
 /**
  * @brief   Memo for Observe registration and notifications
  */
-typedef struct {
-    sock_udp_ep_t *observer;            /**< Client endpoint; unused if null */
+struct gcoap_observe_memo {
+    gcoap_observe_memo_t *next;         /**< Next observer of the resource */
+    gcoap_observe_memo_t *bucket_next;  /**< Next memo in the lookup bucket */
+    sock_udp_ep_t observer;             /**< Client endpoint */
     const coap_resource_t *resource;    /**< Entity being observed */
     uint8_t token[GCOAP_TOKENLEN_MAX];  /**< Client token for notifications */
     unsigned token_len;                 /**< Actual length of token attribute */
-} gcoap_observe_memo_t;
+};
 
 /**
  * @brief   Initializes the gcoap thread and device
@@ -849,9 +1050,11 @@ static inline ssize_t gcoap_response(coap_pkt_t *pdu, uint8_t *buf,
 
 /**
  * @brief   Initializes a CoAP Observe notification packet on a buffer, for the
- *          observer registered for a resource
+ *          observers registered for a resource
  *
- * First verifies that an observer has been registered for the resource.
+ * First verifies that an observer has been registered for the resource. The
+ * header is reserved for the longest token of all observers, so that
+ * gcoap_obs_send() can rewrite it in place for each observer.
  *
  * @param[out] pdu      Notification metadata
  * @param[out] buf      Buffer containing the PDU
@@ -866,21 +1069,45 @@ int gcoap_obs_init(coap_pkt_t *pdu, uint8_t *buf, size_t len,
                    const coap_resource_t *resource);
 
 /**
- * @brief   Sends a buffer containing a CoAP Observe notification to the
- *          observer registered for a resource
+ * @brief   Sends a buffer containing a CoAP Observe notification to all
+ *          observers registered for a resource
  *
- * Assumes a single observer for a resource.
+ * The header of the notification, as initialized by gcoap_obs_init(), is
+ * rewritten in place with the token and a new message ID for each observer,
+ * so @p buf must be writable. The original header is restored before this
+ * function returns. Options and payload are not touched.
  *
- * @param[in] buf Buffer containing the PDU
- * @param[in] len Length of the buffer
- * @param[in] resource Resource to send
+ * @note    @p buf must not be accessed by other threads during the call.
  *
- * @return  length of the packet
+ * @param[in,out] buf   Buffer containing the PDU; the header is modified
+ *                      while sending
+ * @param[in] len       Length of the buffer
+ * @param[in] resource  Resource to send
+ *
+ * @return  length of the packet, if sent to at least one observer
  * @return  0 if cannot send
  */
-size_t gcoap_obs_send(const uint8_t *buf, size_t len,
+size_t gcoap_obs_send(uint8_t *buf, size_t len,
                       const coap_resource_t *resource);
 
+/**
+ * @brief   Notifies all observers of a resource about a change
+ *
+ * The notification is generated asynchronously from the gcoap thread by
+ * calling the handler of @p resource for a GET request, and sent to all
+ * observers. Calls within CONFIG_GCOAP_OBS_NOTIFY_INTERVAL of the last
+ * notification are coalesced into a single notification sent when the
+ * interval has passed.
+ *
+ * @note    Must not be called from interrupt context.
+ *
+ * @param[in] resource  Resource that has changed
+ *
+ * @return  0 on success, the notification is scheduled
+ * @return  -ENOENT if there is no observer for @p resource
+ */
+int gcoap_obs_notify(const coap_resource_t *resource);
+
 /**
  * @brief   Provides important operational statistics
  *
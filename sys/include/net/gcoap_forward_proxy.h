@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    net_gcoap_forward_proxy Gcoap Forward Proxy
+ * @ingroup     net_gcoap
+ * @brief       Forward proxy for CoAP requests with a Proxy-Uri
+ *
+ * With the `gcoap_forward_proxy` module, gcoap forwards requests carrying a
+ * Proxy-Uri option with the `coap` scheme, instead of handing them to a local
+ * resource. The Proxy-Uri is translated to Uri-Path and Uri-Query options,
+ * all other options and the payload are forwarded unchanged. The host must be
+ * an IP address literal.
+ *
+ * Responses are kept in the @ref net_nanocoap_cache, so repeated requests
+ * are answered by the proxy while the response is fresh. For a stale response
+ * with an ETag, the proxy asks the origin server to validate it, and answers
+ * from the cache on a 2.03 Valid.
+ *
+ * A confirmable request that can't be answered from the cache is
+ * acknowledged right away. The response of the origin server follows as a
+ * separate, non-confirmable response. A request that times out is answered
+ * with 5.04 Gateway Timeout.
+ *
+ * @{
+ *
+ * @file
+ * @brief       gcoap forward proxy interface
+ */
+
+#ifndef NET_GCOAP_FORWARD_PROXY_H
+#define NET_GCOAP_FORWARD_PROXY_H
+
+#include "net/gcoap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @ingroup net_gcoap_conf
+ * @brief   Maximum number of requests the proxy forwards at the same time
+ *
+ * Each one also takes a slot of @ref CONFIG_GCOAP_REQ_WAITING_MAX.
+ */
+#ifndef CONFIG_GCOAP_FORWARD_PROXY_CLIENTS
+#define CONFIG_GCOAP_FORWARD_PROXY_CLIENTS     (2)
+#endif
+
+/**
+ * @brief   Initialize the forward proxy
+ *
+ * Called by gcoap_init().
+ */
+void gcoap_forward_proxy_init(void);
+
+/**
+ * @brief   Handle a request with a Proxy-Uri option
+ *
+ * @param[in]   pdu     request
+ * @param[out]  buf     buffer for the response to send right away, may hold
+ *                      @p pdu
+ * @param[in]   len     length of @p buf
+ * @param[in]   client  endpoint of the client
+ *
+ * @return  length of the response in @p buf: a cached response, an error or
+ *          an empty acknowledgement
+ * @return  0 if there is nothing to send right away
+ */
+ssize_t gcoap_forward_proxy_request_process(coap_pkt_t *pdu, uint8_t *buf,
+                                            size_t len,
+                                            const sock_udp_ep_t *client);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* NET_GCOAP_FORWARD_PROXY_H */
+/** @} */
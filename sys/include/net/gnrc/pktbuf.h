@@ -298,6 +298,19 @@ int gnrc_pktbuf_merge(gnrc_pktsnip_t *pkt);
  * @details Statistics include maximum number of reserved bytes.
  */
 void gnrc_pktbuf_stats(void);
+
+/**
+ * @brief   Returns the high-water mark of the packet buffer
+ *
+ * @note    Only available with DEVELHELP defined. gnrc_pktbuf_malloc does
+ *          not track it and always returns 0.
+ *
+ * @param[in] reset     start a new measurement after reading the mark
+ *
+ * @return  position of the last byte used in the packet buffer since startup
+ *          or the last reset
+ */
+size_t gnrc_pktbuf_max_used(bool reset);
 #endif
 
 /* for testing */
@@ -41,8 +41,20 @@
  * _Options Write Buffer API_. gcoap uses the more convenient Packet API,
  * described in the section _Options Write Packet API_.
  *
- * For either API, the caller *must* write options in order by option number
- * (see "CoAP option numbers" in [CoAP defines](group__net__coap.html)).
+ * With the Buffer API, the caller *must* write options in order by option
+ * number (see "CoAP option numbers" in [CoAP defines](group__net__coap.html)).
+ * The Packet API inserts an option at its place if it is added out of order,
+ * so callers do not need to track the last option number. This moves the
+ * options with higher numbers, so add a Block option, whose position is kept
+ * in a @ref coap_block_slicer_t, after the options with lower numbers.
+ *
+ * ### Option lookup
+ *
+ * coap_parse() records the position of the first option of each option number
+ * in coap_pkt_t::options, so the option getters do not walk the option list.
+ * With the `nanocoap_opt_index` module, a bitmap of the option numbers below
+ * 32 present in the message, which include all options commonly found in
+ * requests, turns finding such an option into a constant time operation.
  *
  * ## Server path matching
  *
@@ -188,7 +200,12 @@ typedef struct {
     uint8_t *payload;                                 /**< pointer to payload      */
     uint16_t payload_len;                             /**< length of payload       */
     uint16_t options_len;                             /**< length of options array */
-    coap_optpos_t options[CONFIG_NANOCOAP_NOPTS_MAX]; /**< option offset array     */
+    coap_optpos_t options[CONFIG_NANOCOAP_NOPTS_MAX]; /**< first option of each
+                                                           option number, sorted */
+#if defined(MODULE_NANOCOAP_OPT_INDEX) || defined(DOXYGEN)
+    uint32_t opt_mask;                                /**< option numbers < 32
+                                                           present in @p options */
+#endif
 #ifdef MODULE_GCOAP
     uint32_t observe_value;                           /**< observe value           */
 #endif
@@ -248,6 +265,33 @@ typedef struct {
     uint8_t *opt;                   /**< Pointer to the placed option       */
 } coap_block_slicer_t;
 
+/**
+ * @brief Coap block-wise-transfer size SZX
+ */
+typedef enum {
+    COAP_BLOCKSIZE_16 = 0,
+    COAP_BLOCKSIZE_32,
+    COAP_BLOCKSIZE_64,
+    COAP_BLOCKSIZE_128,
+    COAP_BLOCKSIZE_256,
+    COAP_BLOCKSIZE_512,
+    COAP_BLOCKSIZE_1024,
+} coap_blksize_t;
+
+/**
+ * @brief   Coap blockwise request callback descriptor
+ *
+ * @param[in] arg      Pointer to be passed as arguments to the callback
+ * @param[in] offset   Offset of received data
+ * @param[in] buf      Pointer to the received data
+ * @param[in] len      Length of the received data
+ * @param[in] more     -1 for no option, 0 for last block, 1 for more blocks
+ *
+ * @returns    0       on success
+ * @returns   -1       on error
+ */
+typedef int (*coap_blockwise_cb_t)(void *arg, size_t offset, uint8_t *buf, size_t len, int more);
+
 /**
  * @brief   Global CoAP resource list
  */
@@ -830,6 +874,10 @@ static inline unsigned coap_szx2size(unsigned szx)
  * The caller must monitor space remaining in the buffer; however, the API
  * *will not* write past the end of the buffer, and returns -ENOSPC when it is
  * full.
+ *
+ * Options may be added in any order, see @ref net_nanocoap. The functions
+ * return the number of bytes the options grew by, which equals the length of
+ * the added option unless the following option needs a shorter header now.
  */
 /**@{*/
 /**
@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    net_nanocoap_block Nanocoap block-wise streaming
+ * @ingroup     net_nanocoap
+ * @brief       Block-wise transfers from a seekable source and into a sink
+ *
+ * The slicer API of @ref net_nanocoap lets a handler generate the whole
+ * representation for every block and drops what is outside of the requested
+ * block, so serving block N costs O(N * block size). With this module, a
+ * handler instead passes a read callback for a seekable source, e.g. a file
+ * or a flash region, and only the requested block is read:
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~ {.c}
+ * static ssize_t _image_handler(coap_pkt_t *pkt, uint8_t *buf, size_t len,
+ *                               void *ctx)
+ * {
+ *     return coap_block2_reply_stream(pkt, COAP_CODE_CONTENT, buf, len,
+ *                                     COAP_FORMAT_OCTET, IMAGE_SIZE,
+ *                                     coap_block_read_mtd, ctx);
+ * }
+ * ~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * For Block1 requests, coap_block1_sink_handle() writes each block into a
+ * @ref coap_blockwise_cb_t sink as it arrives, without reassembling the
+ * representation in RAM, and builds the 2.31 Continue response.
+ *
+ * The client side, fetching a resource block-wise with several requests in
+ * flight, is nanocoap_get_blockwise() of @ref net_nanosock.
+ *
+ * @{
+ *
+ * @file
+ * @brief       nanocoap block-wise streaming interface
+ */
+
+#ifndef NET_NANOCOAP_BLOCK_H
+#define NET_NANOCOAP_BLOCK_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "net/nanocoap.h"
+
+#ifdef MODULE_MTD
+#include "mtd.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Read callback of a seekable source
+ *
+ * @param[in]   arg     context of the source
+ * @param[in]   offset  offset in the representation to read from
+ * @param[out]  buf     buffer to read into
+ * @param[in]   len     number of bytes to read
+ *
+ * @return  @p len on success
+ * @return  <0 on error
+ */
+typedef ssize_t (*coap_block_read_t)(void *arg, size_t offset, uint8_t *buf,
+                                     size_t len);
+
+/**
+ * @brief   State of a Block1 transfer into a sink
+ */
+typedef struct {
+    coap_blockwise_cb_t write;      /**< sink to write the blocks to */
+    void *arg;                      /**< argument of @p write */
+    size_t offset;                  /**< offset of the next expected block */
+} coap_block1_sink_t;
+
+/**
+ * @brief   Reply to a request with a block of a representation
+ *
+ * Reads the block requested by the Block2 option of @p pkt from @p read, or
+ * the first block if there is none. The block size is reduced to the
+ * configured maximum and to what fits into @p buf. The first block also
+ * carries a Size2 option.
+ *
+ * @param[in]   pkt     request
+ * @param[in]   code    response code
+ * @param[out]  buf     buffer for the response
+ * @param[in]   len     length of @p buf
+ * @param[in]   ct      content format, COAP_FORMAT_NONE for none
+ * @param[in]   size    size of the representation
+ * @param[in]   read    read callback of the source
+ * @param[in]   arg     context of @p read
+ *
+ * @return  length of the response, a 4.02 Bad Option error for a block
+ *          beyond the end or a 5.00 error if @p read failed
+ * @return  -ENOSPC if @p buf is too small
+ */
+ssize_t coap_block2_reply_stream(coap_pkt_t *pkt, unsigned code,
+                                 uint8_t *buf, size_t len, uint16_t ct,
+                                 size_t size, coap_block_read_t read,
+                                 void *arg);
+
+/**
+ * @brief   Initialize a Block1 sink
+ *
+ * @param[out]  sink    sink state to initialize
+ * @param[in]   write   callback called with each block in order
+ * @param[in]   arg     argument of @p write
+ */
+void coap_block1_sink_init(coap_block1_sink_t *sink, coap_blockwise_cb_t write,
+                           void *arg);
+
+/**
+ * @brief   Write the payload of a Block1 request into a sink and reply
+ *
+ * A request without Block1 option is written as a single, last block. A
+ * retransmitted block is acknowledged again without writing it twice, a
+ * block at offset 0 restarts the transfer.
+ *
+ * @param[in,out] sink  sink state
+ * @param[in]   pkt     request
+ * @param[out]  buf     buffer for the response
+ * @param[in]   len     length of @p buf
+ * @param[in]   code    response code after the last block, e.g. 2.04
+ *
+ * @return  length of the response: 2.31 Continue while more blocks follow,
+ *          4.08 Request Entity Incomplete for a block out of order or
+ *          5.00 if the sink failed
+ * @return  -ENOSPC if @p buf is too small
+ */
+ssize_t coap_block1_sink_handle(coap_block1_sink_t *sink, coap_pkt_t *pkt,
+                                uint8_t *buf, size_t len, unsigned code);
+
+#if defined(MODULE_VFS) || defined(DOXYGEN)
+/**
+ * @brief   Read callback for a file
+ *
+ * @param[in]   arg     pointer to the `int` file descriptor
+ */
+ssize_t coap_block_read_vfs(void *arg, size_t offset, uint8_t *buf,
+                            size_t len);
+#endif
+
+#if defined(MODULE_MTD) || defined(DOXYGEN)
+/**
+ * @brief   Flash region read by coap_block_read_mtd()
+ */
+typedef struct {
+    mtd_dev_t *dev;                 /**< device */
+    uint32_t addr;                  /**< start of the region */
+} coap_block_mtd_t;
+
+/**
+ * @brief   Read callback for a flash region
+ *
+ * @param[in]   arg     pointer to a @ref coap_block_mtd_t
+ */
+ssize_t coap_block_read_mtd(void *arg, size_t offset, uint8_t *buf,
+                            size_t len);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* NET_NANOCOAP_BLOCK_H */
+/** @} */
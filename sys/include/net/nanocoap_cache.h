@@ -0,0 +1,313 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @defgroup    net_nanocoap_cache Nanocoap Cache
+ * @ingroup     net_nanocoap
+ * @brief       A cache for CoAP responses
+ *
+ * The cache stores complete responses, looked up by a cache key generated
+ * from a request. Following RFC 7252, section 5.6, the key covers all request
+ * options except those marked NoCacheKey and those only relevant for
+ * validation or observation (ETag, If-Match, If-None-Match, Observe). A
+ * Proxy-Uri is normalised before hashing: scheme and host are compared case
+ * insensitive, the default port and an empty path are ignored. For FETCH, the
+ * payload is part of the key as well.
+ *
+ * A response is fresh for its Max-Age. Responses sent from the cache get
+ * their Max-Age reduced by the time they have already spent in it. A cached
+ * response that also carries an ETag can be validated: if a request carries
+ * the same ETag, the cache answers with 2.03 Valid and no payload, and a 2.03
+ * Valid received for a stale entry makes it fresh again.
+ *
+ * A successful unsafe request (e.g. PUT) invalidates all responses cached for
+ * its request URI. Options like Content-Format or Accept differ between the
+ * unsafe request and the GET requests, so every entry also stores a URI key
+ * built from the Uri-* and Proxy-* options only. The request method is not
+ * part of the cache key, but an entry only answers requests of the method it
+ * was cached for.
+ *
+ * When the cache is full, the least recently used entry is replaced. The
+ * cache is not thread-safe; @ref net_gcoap uses it from its own thread only.
+ *
+ * @{
+ *
+ * @file
+ * @brief       nanocoap cache interface
+ */
+
+#ifndef NET_NANOCOAP_CACHE_H
+#define NET_NANOCOAP_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "clist.h"
+#include "net/nanocoap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup net_nanocoap_cache_conf    Nanocoap cache compile configurations
+ * @ingroup  net_nanocoap_cache
+ * @ingroup  config
+ * @{
+ */
+/**
+ * @brief   Number of responses the cache can hold
+ */
+#ifndef CONFIG_NANOCOAP_CACHE_ENTRIES
+#define CONFIG_NANOCOAP_CACHE_ENTRIES           (8)
+#endif
+
+/**
+ * @brief   Length of a cache key in bytes, at most 32
+ *
+ * The key is a truncated SHA-256 digest.
+ */
+#ifndef CONFIG_NANOCOAP_CACHE_KEY_LENGTH
+#define CONFIG_NANOCOAP_CACHE_KEY_LENGTH        (8)
+#endif
+
+/**
+ * @brief   Maximum length of a cached response in bytes
+ */
+#ifndef CONFIG_NANOCOAP_CACHE_RESPONSE_SIZE
+#define CONFIG_NANOCOAP_CACHE_RESPONSE_SIZE     (128)
+#endif
+/** @} */
+
+/**
+ * @brief   Cache entry
+ */
+typedef struct {
+    clist_node_t node;              /**< list entry, by last use */
+    uint8_t cache_key[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];  /**< cache key */
+    uint8_t uri_key[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];    /**< key of the
+                                         request URI, see
+                                         nanocoap_cache_uri_key_generate() */
+    uint8_t response_buf[CONFIG_NANOCOAP_CACHE_RESPONSE_SIZE];
+                                    /**< complete response PDU */
+    size_t response_len;            /**< length of response_buf */
+    uint8_t request_method;         /**< method of the request */
+    uint8_t etag[COAP_ETAG_LENGTH_MAX]; /**< ETag of the response */
+    uint8_t etag_len;               /**< length of etag, 0 if none */
+    uint32_t max_age;               /**< time the entry becomes stale, see
+                                         nanocoap_cache_now() */
+} nanocoap_cache_entry_t;
+
+/**
+ * @brief   Initialize the cache, dropping all entries
+ */
+void nanocoap_cache_init(void);
+
+/**
+ * @brief   Current time of the cache in seconds
+ */
+uint32_t nanocoap_cache_now(void);
+
+/**
+ * @brief   Generate the cache key for a request
+ *
+ * @param[in]   req         request
+ * @param[out]  cache_key   cache key, CONFIG_NANOCOAP_CACHE_KEY_LENGTH bytes
+ */
+void nanocoap_cache_key_generate(const coap_pkt_t *req, uint8_t *cache_key);
+
+/**
+ * @brief   Generate the key of the request URI
+ *
+ * Only the Uri-Host, Uri-Port, Uri-Path, Uri-Query, Proxy-Uri and
+ * Proxy-Scheme options are used, so an unsafe request yields the same key as
+ * the GET requests for the resource it changes.
+ *
+ * @param[in]   req         request
+ * @param[out]  uri_key     URI key, CONFIG_NANOCOAP_CACHE_KEY_LENGTH bytes
+ */
+void nanocoap_cache_uri_key_generate(const coap_pkt_t *req, uint8_t *uri_key);
+
+/**
+ * @brief   Look up a cache entry by cache key
+ *
+ * The entry may be stale. A found entry becomes the most recently used one.
+ *
+ * @param[in]   cache_key   cache key
+ *
+ * @return  the entry, NULL if not found
+ */
+nanocoap_cache_entry_t *nanocoap_cache_key_lookup(const uint8_t *cache_key);
+
+/**
+ * @brief   Look up the cache entry for a request
+ *
+ * @param[in]   req     request
+ *
+ * @return  the entry, may be stale
+ * @return  NULL if not found or cached for a different method
+ */
+nanocoap_cache_entry_t *nanocoap_cache_request_lookup(const coap_pkt_t *req);
+
+/**
+ * @brief   Add a response to the cache
+ *
+ * Replaces an existing entry for @p cache_key, otherwise a free or the least
+ * recently used entry.
+ *
+ * @param[in]   cache_key       cache key of the request
+ * @param[in]   uri_key         URI key of the request
+ * @param[in]   request_method  method of the request
+ * @param[in]   resp            parsed response
+ * @param[in]   resp_len        length of the response PDU
+ *
+ * @return  the new entry
+ * @return  NULL if the response is too large or has a Max-Age of 0
+ */
+nanocoap_cache_entry_t *nanocoap_cache_add_by_key(const uint8_t *cache_key,
+                                                  const uint8_t *uri_key,
+                                                  unsigned request_method,
+                                                  const coap_pkt_t *resp,
+                                                  size_t resp_len);
+
+/**
+ * @brief   Add a response to the cache, generating the key from the request
+ *
+ * @see nanocoap_cache_add_by_key()
+ *
+ * @param[in]   req         request
+ * @param[in]   resp        parsed response
+ * @param[in]   resp_len    length of the response PDU
+ *
+ * @return  the new entry, NULL if not cached
+ */
+nanocoap_cache_entry_t *nanocoap_cache_add_by_req(const coap_pkt_t *req,
+                                                  const coap_pkt_t *resp,
+                                                  size_t resp_len);
+
+/**
+ * @brief   Update the cache with a response
+ *
+ * Caches responses to GET and FETCH requests with a cacheable code. A 2.03
+ * Valid response refreshes the existing entry if the ETags match. A success
+ * response to any other method removes all entries of the request URI, as
+ * the resource changed (RFC 7252, section 5.6).
+ *
+ * @param[in]   cache_key       cache key of the request
+ * @param[in]   uri_key         URI key of the request
+ * @param[in]   request_method  method of the request
+ * @param[in]   resp            parsed response
+ * @param[in]   resp_len        length of the response PDU
+ *
+ * @return  0 if the cache holds a fresh entry for @p cache_key afterwards
+ * @return  -ENOENT otherwise
+ */
+int nanocoap_cache_process(const uint8_t *cache_key, const uint8_t *uri_key,
+                           unsigned request_method,
+                           const coap_pkt_t *resp, size_t resp_len);
+
+/**
+ * @brief   Remove all entries of a request URI
+ *
+ * @param[in]   uri_key     URI key, see nanocoap_cache_uri_key_generate()
+ *
+ * @return  number of removed entries
+ */
+size_t nanocoap_cache_invalidate(const uint8_t *uri_key);
+
+/**
+ * @brief   Remove an entry from the cache
+ *
+ * @param[in]   ce      entry to remove
+ *
+ * @return  0 on success
+ * @return  -ENOENT if @p ce is not in the cache
+ */
+int nanocoap_cache_del(const nanocoap_cache_entry_t *ce);
+
+/**
+ * @brief   Check whether a cache entry is stale
+ *
+ * @param[in]   ce      cache entry
+ * @param[in]   now     current time, see nanocoap_cache_now()
+ *
+ * @return  true if @p ce must not be used without validation
+ */
+static inline bool nanocoap_cache_entry_is_stale(const nanocoap_cache_entry_t *ce,
+                                                 uint32_t now)
+{
+    return (int32_t)(ce->max_age - now) <= 0;
+}
+
+/**
+ * @brief   Check whether a request carries the ETag of a cache entry
+ *
+ * @param[in]   ce      cache entry
+ * @param[in]   req     request
+ *
+ * @return  true if one of the ETag options of @p req matches
+ */
+bool nanocoap_cache_etag_match(const nanocoap_cache_entry_t *ce,
+                               const coap_pkt_t *req);
+
+/**
+ * @brief   Write a cached response with a new header
+ *
+ * The Max-Age option is set to the remaining freshness of the entry.
+ *
+ * @param[in]   ce          cache entry
+ * @param[in]   type        message type
+ * @param[in]   id          message ID
+ * @param[in]   token       token
+ * @param[in]   token_len   length of @p token
+ * @param[in]   valid       write a 2.03 Valid response with only the ETag and
+ *                          Max-Age options instead of the cached one
+ * @param[out]  buf         buffer to write to
+ * @param[in]   len         length of @p buf
+ *
+ * @return  length of the response
+ * @return  -ENOSPC if @p buf is too small
+ */
+ssize_t nanocoap_cache_build_pdu(const nanocoap_cache_entry_t *ce,
+                                 unsigned type, uint16_t id,
+                                 const uint8_t *token, size_t token_len,
+                                 bool valid, uint8_t *buf, size_t len);
+
+/**
+ * @brief   Write a cached response as reply to a request
+ *
+ * Answers with 2.03 Valid if @p req carries the ETag of the entry. The reply
+ * is piggybacked for a confirmable request. @p buf may hold @p req.
+ *
+ * @param[in]   ce      fresh cache entry
+ * @param[in]   req     request to reply to
+ * @param[out]  buf     buffer to write to
+ * @param[in]   len     length of @p buf
+ *
+ * @return  length of the response
+ * @return  -ENOSPC if @p buf is too small
+ */
+ssize_t nanocoap_cache_build_reply(const nanocoap_cache_entry_t *ce,
+                                   coap_pkt_t *req, uint8_t *buf, size_t len);
+
+/**
+ * @brief   Number of entries in use
+ */
+size_t nanocoap_cache_used_count(void);
+
+/**
+ * @brief   Number of free entries
+ */
+size_t nanocoap_cache_free_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* NET_NANOCOAP_CACHE_H */
+/** @} */
@@ -118,6 +118,16 @@
  * finalizes the packet and calls coap_block2_finish() internally to update
  * the block2 option.
  *
+ * As the handler generates the whole payload for each block, this gets
+ * expensive for large resources. If the payload can be read at any offset,
+ * use coap_block2_reply_stream() of @ref net_nanocoap_block instead.
+ *
+ * # Fetch a Resource Block-wise
+ *
+ * nanocoap_get_blockwise() fetches a resource in blocks and passes them to a
+ * callback in order. With a buffer large enough for several blocks, it keeps
+ * requests for multiple blocks in flight.
+ *
  * @{
  *
  * @file
@@ -139,6 +149,38 @@
 extern "C" {
 #endif
 
+/**
+ * @defgroup net_nanosock_conf  Nanocoap sock compile configurations
+ * @ingroup  net_nanosock
+ * @ingroup  config
+ * @{
+ */
+/**
+ * @brief   Space for header and options of a response to a block request
+ */
+#ifndef CONFIG_NANOCOAP_BLOCK_HEADER_MAX
+#define CONFIG_NANOCOAP_BLOCK_HEADER_MAX        (64)
+#endif
+
+/**
+ * @brief   Maximum number of block requests in flight
+ *
+ * See nanocoap_get_blockwise().
+ */
+#ifndef CONFIG_NANOCOAP_BLOCKWISE_WINDOW_MAX
+#define CONFIG_NANOCOAP_BLOCKWISE_WINDOW_MAX    (4)
+#endif
+/** @} */
+
+/**
+ * @brief   Size of the buffer for nanocoap_get_blockwise()
+ *
+ * @param[in]   blksize     block size, see @ref coap_blksize_t
+ * @param[in]   window      number of block requests in flight
+ */
+#define NANOCOAP_BLOCKWISE_BUF(blksize, window) \
+    (CONFIG_NANOCOAP_BLOCK_HEADER_MAX + ((window) << ((blksize) + 4)))
+
 /**
  * @brief   Start a nanocoap server instance
  *
@@ -183,6 +225,40 @@ ssize_t nanocoap_get(sock_udp_ep_t *remote, const char *path, uint8_t *buf,
 ssize_t nanocoap_request(coap_pkt_t *pkt, sock_udp_ep_t *local,
                          sock_udp_ep_t *remote, size_t len);
 
+/**
+ * @brief   Fetch a resource block-wise
+ *
+ * The first block is requested alone, so the server can pick a smaller block
+ * size. After that, one request per block that fits into @p buf is in
+ * flight, up to CONFIG_NANOCOAP_BLOCKWISE_WINDOW_MAX, see
+ * NANOCOAP_BLOCKWISE_BUF(). Blocks received out of
+ * order are kept in @p buf, so @p callback gets them in order. With @p len
+ * only large enough for a single block, this is a plain stop-and-wait
+ * transfer.
+ *
+ * Only piggybacked responses are supported.
+ *
+ * @param[in]   sock        sock connected to the server
+ * @param[in]   path        remote path
+ * @param[in]   blksize     block size to ask for
+ * @param[in]   buf         work buffer
+ * @param[in]   len         length of @p buf, at least
+ *                          NANOCOAP_BLOCKWISE_BUF(blksize, 1)
+ * @param[in]   callback    called with each block in order
+ * @param[in]   arg         argument of @p callback
+ *
+ * @returns     0 on success
+ * @returns     -ENOBUFS if @p buf is too small
+ * @returns     -ETIMEDOUT if a block was not received
+ * @returns     -EBADMSG on an invalid response
+ * @returns     -ECANCELED if @p callback failed
+ * @returns     the negative response code (e.g. -404) on an error response
+ * @returns     other negative errno values if sending or receiving failed
+ */
+int nanocoap_get_blockwise(sock_udp_t *sock, const char *path,
+                           coap_blksize_t blksize, uint8_t *buf, size_t len,
+                           coap_blockwise_cb_t callback, void *arg);
+
 #ifdef __cplusplus
 }
 #endif
@@ -29,6 +29,10 @@
 #include "net/ntp_packet.h"
 #include "net/sock/udp.h"
 #include "xtimer.h"
+#ifdef MODULE_SNTP_ASYNC
+#include "coro.h"
+#include "net/sock/async/event.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -45,6 +49,59 @@ extern "C" {
  */
 int sntp_sync(sock_udp_ep_t *server, uint32_t timeout);
 
+#if defined(MODULE_SNTP_ASYNC) || defined(DOXYGEN)
+/**
+ * @brief   SNTP request context forward declaration
+ */
+typedef struct sntp_request sntp_request_t;
+
+/**
+ * @brief   Callback for asynchronous synchronization
+ *
+ * @param[in]   req     the finished request
+ * @param[in]   res     0 on success, negative number on error
+ * @param[in]   arg     the argument given to sntp_sync_async()
+ */
+typedef void (*sntp_cb_t)(sntp_request_t *req, int res, void *arg);
+
+/**
+ * @brief   Context of an asynchronous SNTP request
+ *
+ * @note    All members are private.
+ */
+struct sntp_request {
+    coro_t coro;                /**< coroutine running the request */
+    sock_udp_t sock;            /**< sock the request is sent on */
+    ntp_packet_t packet;        /**< request and response packet */
+    sock_udp_ep_t *server;      /**< time server */
+    sntp_cb_t cb;               /**< callback on completion */
+    void *arg;                  /**< callback argument */
+    uint32_t timeout;           /**< response timeout in microseconds */
+    int res;                    /**< result of the request */
+};
+
+/**
+ * @brief   Synchronize with time server without blocking
+ *
+ * Same as @ref sntp_sync(), but runs the request as a coroutine on @p queue
+ * and reports the result to @p cb, called from the thread serving @p queue.
+ *
+ * @note    Only available with module `sntp_async`.
+ *
+ * @param[out] req      context of the request, must stay valid until @p cb
+ *                      was called
+ * @param[in] server    The time server, must stay valid until @p cb was
+ *                      called
+ * @param[in] timeout   Timeout for the server response in microseconds
+ * @param[in] queue     event queue to run the request on
+ * @param[in] cb        callback for the result, may be NULL
+ * @param[in] arg       argument for @p cb
+ */
+void sntp_sync_async(sntp_request_t *req, sock_udp_ep_t *server,
+                     uint32_t timeout, event_queue_t *queue,
+                     sntp_cb_t cb, void *arg);
+#endif
+
 /**
  * @brief Get real time offset from system time as returned by @ref xtimer_now64()
  *
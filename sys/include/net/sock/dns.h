@@ -12,6 +12,15 @@
  *
  * @brief       Sock DNS client
  *
+ * With module `sock_dns_cache`, results of @ref sock_dns_query() and
+ * sock_dns_query_async() are cached for the time-to-live given by the DNS
+ * server, at most for @ref CONFIG_SOCK_DNS_CACHE_MAX_TTL, and failed lookups
+ * for @ref CONFIG_SOCK_DNS_CACHE_NEG_TTL. Queries for a name that is already
+ * being resolved wait for that query instead of sending another one.
+ *
+ * Every query is sent with a random ID. Replies with another ID or questions
+ * other than the ones sent are dropped.
+ *
  * @{
  *
  * @file
@@ -28,6 +37,10 @@
 #include <unistd.h>
 
 #include "net/sock/udp.h"
+#ifdef MODULE_SOCK_DNS_ASYNC
+#include "coro.h"
+#include "net/sock/async/event.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -56,11 +69,39 @@ typedef struct {
 
 #define SOCK_DNS_PORT           (53)
 #define SOCK_DNS_RETRIES        (2)
+#define SOCK_DNS_TIMEOUT        (1000000LU) /* timeout per try in us */
 
 #define SOCK_DNS_BUF_LEN        (128)       /* we're in embedded context. */
 #define SOCK_DNS_MAX_NAME_LEN   (SOCK_DNS_BUF_LEN - sizeof(sock_dns_hdr_t) - 4)
 /** @} */
 
+/**
+ * @brief   Number of entries of the DNS cache
+ */
+#ifndef CONFIG_SOCK_DNS_CACHE_SIZE
+#define CONFIG_SOCK_DNS_CACHE_SIZE      (4)
+#endif
+
+/**
+ * @brief   Time in seconds a failed lookup is cached
+ *
+ * Only lookups the DNS server answered with "no such name" or without a
+ * matching record are cached, not timeouts.
+ */
+#ifndef CONFIG_SOCK_DNS_CACHE_NEG_TTL
+#define CONFIG_SOCK_DNS_CACHE_NEG_TTL   (60)
+#endif
+
+/**
+ * @brief   Maximum time in seconds a result is cached
+ *
+ * Caps the time-to-live given by the DNS server, which may be up to 68
+ * years, so that a wrong result does not stick until the next reboot.
+ */
+#ifndef CONFIG_SOCK_DNS_CACHE_MAX_TTL
+#define CONFIG_SOCK_DNS_CACHE_MAX_TTL   (3600)
+#endif
+
 /**
  * @brief Get IP address for DNS name
  *
@@ -73,6 +114,13 @@ typedef struct {
  * This function will return the first DNS record it receives. IF both A and
  * AAAA are requested, AAAA will be preferred.
  *
+ * With module `sock_dns_cache`, the result is taken from the cache if
+ * possible.
+ *
+ * With module `sock_dns_async`, the query context (sizeof(sock_dns_query_t))
+ * is placed on the stack of the calling thread. Several threads can resolve
+ * at the same time.
+ *
  * @note @p addr_out needs to provide space for any possible result!
  *       (4byte when family==AF_INET, 16byte otherwise)
  *
@@ -85,6 +133,87 @@ typedef struct {
  */
 int sock_dns_query(const char *domain_name, void *addr_out, int family);
 
+#if defined(MODULE_SOCK_DNS_ASYNC) || defined(DOXYGEN)
+/**
+ * @brief   DNS query context forward declaration
+ */
+typedef struct sock_dns_query sock_dns_query_t;
+
+/**
+ * @brief   Callback for asynchronous DNS queries
+ *
+ * @param[in]   query   the finished query
+ * @param[in]   res     the size of the resolved address on success,
+ *                      < 0 otherwise
+ * @param[in]   arg     the argument given to sock_dns_query_async()
+ */
+typedef void (*sock_dns_cb_t)(sock_dns_query_t *query, int res, void *arg);
+
+/**
+ * @brief   Context of an asynchronous DNS query
+ *
+ * @note    All members are private.
+ */
+struct sock_dns_query {
+    coro_t coro;                    /**< coroutine running the query */
+    sock_udp_t sock;                /**< sock the query is sent on */
+    const char *domain_name;        /**< name to resolve */
+    void *addr_out;                 /**< buffer for the result */
+    sock_dns_cb_t cb;               /**< callback on completion */
+    void *arg;                      /**< callback argument */
+    int res;                        /**< result of the query */
+    int family;                     /**< address family to query */
+    uint16_t id;                    /**< random ID of the query */
+    uint8_t retries;                /**< number of tries sent */
+#if defined(MODULE_SOCK_DNS_CACHE) || defined(DOXYGEN)
+    sock_dns_query_t *next;         /**< next query for another name */
+    sock_dns_query_t *waiters;      /**< queries waiting for this one */
+    sock_dns_query_t *leader;       /**< query this one is waiting for */
+    uint32_t ttl;                   /**< time-to-live of the result */
+#endif
+    uint8_t buf[SOCK_DNS_BUF_LEN];  /**< message buffer */
+};
+
+/**
+ * @brief   Resolve a DNS name without blocking
+ *
+ * Same as @ref sock_dns_query(), but runs the query as a coroutine on
+ * @p queue and reports the result to @p cb, called from the thread serving
+ * @p queue. Any number of queries can be outstanding at the same time, each
+ * with its own @p query context.
+ *
+ * @note    Only available with module `sock_dns_async`.
+ *
+ * @param[out]  query           context of the query, must stay valid until
+ *                              @p cb was called
+ * @param[in]   domain_name     DNS name to resolve, must stay valid until
+ *                              @p cb was called
+ * @param[out]  addr_out        buffer to write result into
+ * @param[in]   family          Either AF_INET, AF_INET6 or AF_UNSPEC
+ * @param[in]   queue           event queue to run the query on
+ * @param[in]   cb              callback for the result, may be NULL
+ * @param[in]   arg             argument for @p cb
+ *
+ * @return      0 if the query was started
+ * @return      -ECONNREFUSED if no DNS server is configured
+ * @return      -ENOSPC if @p domain_name is too long
+ */
+int sock_dns_query_async(sock_dns_query_t *query, const char *domain_name,
+                         void *addr_out, int family, event_queue_t *queue,
+                         sock_dns_cb_t cb, void *arg);
+#endif
+
+#if defined(MODULE_SOCK_DNS_CACHE) || defined(DOXYGEN)
+/**
+ * @brief   Drop all entries of the DNS cache
+ *
+ * Call this e.g. after changing @ref sock_dns_server.
+ *
+ * @note    Only available with module `sock_dns_cache`.
+ */
+void sock_dns_cache_flush(void);
+#endif
+
 /**
  * @brief global DNS server endpoint
  */
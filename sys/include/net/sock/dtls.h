@@ -457,6 +457,7 @@
 #define NET_SOCK_DTLS_H
 
 #include <assert.h>
+#include <errno.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <sys/types.h>
@@ -499,6 +500,14 @@ enum {
 };
 /** @} */
 
+/**
+ * @brief   Return value of sock_dtls_recv() for a completed handshake
+ *
+ * Returned negated like an error code, but it is not an errno value: it lies
+ * outside their range, so it cannot be mistaken for a receive error.
+ */
+#define SOCK_DTLS_HANDSHAKE     (0x1000)
+
 /**
  * @brief   Type for a DTLS sock object
  *
@@ -567,6 +576,24 @@ int sock_dtls_create(sock_dtls_t *sock, sock_udp_t *udp_sock,
 int sock_dtls_session_create(sock_dtls_t *sock, const sock_udp_ep_t *ep,
                              sock_dtls_session_t *remote);
 
+/**
+ * @brief Starts a handshake with a DTLS server without waiting for it
+ *
+ * Sends the first message of the handshake to @p ep and returns. The
+ * handshake continues in the following calls of sock_dtls_recv(), which
+ * returns -SOCK_DTLS_HANDSHAKE once it is complete.
+ *
+ * @param[in]  sock     DLTS sock to use
+ * @param[in]  ep       Remote endpoint of the session
+ * @param[out] remote   The session, cannot be NULL
+ *
+ * @return  1, if the handshake was started or is still in progress
+ * @return  0, if a session with @p ep is already established
+ * @return  -ENOMEM, if no memory was available to start the handshake
+ */
+int sock_dtls_session_init(sock_dtls_t *sock, const sock_udp_ep_t *ep,
+                           sock_dtls_session_t *remote);
+
 /**
  * @brief Destroys an existing DTLS session
  *
@@ -602,6 +629,8 @@ void sock_dtls_session_destroy(sock_dtls_t *sock, sock_dtls_session_t *remote);
  *          data.
  * @return  -ENOMEM, if no memory was available to receive @p data.
  * @return  -ETIMEDOUT, if @p timeout expired.
+ * @return  -SOCK_DTLS_HANDSHAKE, if a handshake with @p remote completed
+ *          instead of data being received.
  */
 ssize_t sock_dtls_recv(sock_dtls_t *sock, sock_dtls_session_t *remote,
                        void *data, size_t maxlen, uint32_t timeout);
@@ -273,6 +273,8 @@
 #include <stdlib.h>
 #include <sys/types.h>
 
+#include "iolist.h"
+
 /* net/sock/async/types.h included by net/sock.h needs to re-typedef the
  * `sock_ip_t` to prevent cyclic includes */
 #if defined (__clang__)
@@ -494,6 +496,27 @@ ssize_t sock_udp_recv_buf(sock_udp_t *sock, void **data, void **buf_ctx,
 ssize_t sock_udp_send(sock_udp_t *sock, const void *data, size_t len,
                       const sock_udp_ep_t *remote);
 
+/**
+ * @brief   Sends a UDP message gathered from several buffers
+ *
+ * Same as @ref sock_udp_send(), but the payload is the concatenation of the
+ * buffers in @p snips. This saves assembling e.g. a protocol header and the
+ * payload in one buffer before sending.
+ *
+ * @pre `((sock != NULL || remote != NULL))`
+ *
+ * @param[in] sock      A UDP sock object. May be `NULL`.
+ * @param[in] snips     List of buffers to send. May be `NULL` for an empty
+ *                      message.
+ * @param[in] remote    Remote end point for the sent data.
+ *                      May be `NULL`, if @p sock has a remote end point.
+ *
+ * @return  The number of bytes sent on success.
+ * @return  The same errors as @ref sock_udp_send() otherwise.
+ */
+ssize_t sock_udp_sendv(sock_udp_t *sock, const iolist_t *snips,
+                       const sock_udp_ep_t *remote);
+
 #include "sock_types.h"
 
 #ifdef __cplusplus
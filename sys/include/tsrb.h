@@ -29,6 +29,7 @@
 #include <assert.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <sys/uio.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -36,6 +37,11 @@ extern "C" {
 
 /**
  * @brief     thread-safe ringbuffer struct
+ *
+ * The buffer is safe to use by one reader and one writer at the same time,
+ * e.g. an ISR and a thread, without any locking.  The counters are only
+ * advanced once the data has been copied, so bulk and region based transfers
+ * give the same guarantee.
  */
 typedef struct tsrb {
     uint8_t *buf;               /**< Buffer to operate on. */
@@ -130,12 +136,30 @@ int tsrb_get(tsrb_t *rb, uint8_t *dst, size_t n);
 
 /**
  * @brief       Drop bytes from ringbuffer
+ *
+ * Together with tsrb_peek_iov() this allows reading without copying.
+ *
  * @param[in]   rb  Ringbuffer to operate on
  * @param[in]   n   max number of bytes to drop
  * @return      nr of bytes dropped
  */
 int tsrb_drop(tsrb_t *rb, size_t n);
 
+/**
+ * @brief       Get the regions of the ringbuffer holding the next bytes to
+ *              read, without removing them
+ *
+ * As the data may wrap around the end of the buffer, it is returned as up to
+ * two linear regions.  Unused regions have a length of 0.  Call tsrb_drop()
+ * to remove the data once it has been processed.
+ *
+ * @param[in]   rb  Ringbuffer to operate on
+ * @param[out]  iov the regions, in order
+ * @param[in]   n   max number of bytes to peek at
+ * @return      nr of bytes in @p iov
+ */
+size_t tsrb_peek_iov(const tsrb_t *rb, struct iovec iov[2], size_t n);
+
 /**
  * @brief       Add a byte to ringbuffer
  * @param[in]   rb  Ringbuffer to operate on
@@ -154,6 +178,28 @@ int tsrb_add_one(tsrb_t *rb, uint8_t c);
  */
 int tsrb_add(tsrb_t *rb, const uint8_t *src, size_t n);
 
+/**
+ * @brief       Get the free regions of the ringbuffer to write to directly
+ *
+ * As the free space may wrap around the end of the buffer, it is returned as
+ * up to two linear regions.  Unused regions have a length of 0.  Call
+ * tsrb_commit() to make the written bytes available to the reader.
+ *
+ * @param[in]   rb  Ringbuffer to operate on
+ * @param[out]  iov the regions, in order
+ * @param[in]   n   max number of bytes to reserve
+ * @return      nr of bytes in @p iov
+ */
+size_t tsrb_reserve_iov(const tsrb_t *rb, struct iovec iov[2], size_t n);
+
+/**
+ * @brief       Make bytes written to the regions returned by
+ *              tsrb_reserve_iov() available for reading
+ * @param[in]   rb  Ringbuffer to operate on
+ * @param[in]   n   nr of bytes written, must not exceed the reserved bytes
+ */
+void tsrb_commit(tsrb_t *rb, size_t n);
+
 #ifdef __cplusplus
 }
 #endif
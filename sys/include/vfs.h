@@ -68,6 +68,7 @@
 
 #include "kernel_types.h"
 #include "clist.h"
+#include "iolist.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -151,6 +152,44 @@ extern "C" {
 #define VFS_NAME_MAX (31)
 #endif
 
+#ifndef VFS_PATH_CACHE_SIZE
+/**
+ * @brief Number of entries in the mount lookup cache
+ *
+ * The cache remembers which mount a recently used directory belongs to, so
+ * that repeated operations on files in the same directory do not need to
+ * search the mount table. Set to 0 to disable the cache.
+ */
+#define VFS_PATH_CACHE_SIZE (4)
+#endif
+
+#ifndef VFS_PATH_CACHE_NAME_MAX
+/**
+ * @brief Maximum length of a directory name stored in the mount lookup cache
+ *
+ * Files in directories with longer names are resolved without the cache.
+ */
+#define VFS_PATH_CACHE_NAME_MAX (31)
+#endif
+
+#ifndef VFS_DIRAT_PATH_MAX
+/**
+ * @brief Maximum length of the directory path in a @c vfs_dirat_t (not
+ * including terminating null)
+ */
+#define VFS_DIRAT_PATH_MAX (63)
+#endif
+
+#ifndef VFS_SENDFILE_BUFSIZE
+/**
+ * @brief Size of the stack buffer used by vfs_sendfile() to move data
+ * between file descriptors
+ *
+ * Larger values need fewer read and write calls per transfer.
+ */
+#define VFS_SENDFILE_BUFSIZE (128)
+#endif
+
 /**
  * @brief Used with vfs_bind to bind to any available fd number
  */
@@ -235,6 +274,21 @@ typedef struct {
     } private_data;            /**< File system driver private data, implementation defined */
 } vfs_DIR;
 
+/**
+ * @brief Resolved directory for use with the @c vfs_*at() functions
+ *
+ * Holds a reference on the mount of the directory, the mount can not be
+ * unmounted until the handle has been released with vfs_dirat_close().
+ *
+ * @attention This structure should be treated as an opaque blob and must not be
+ * modified by user code.
+ */
+typedef struct {
+    vfs_mount_t *mp;                        /**< Pointer to mount table entry */
+    size_t path_len;                        /**< Length of @c path */
+    char path[VFS_DIRAT_PATH_MAX + 1];      /**< Absolute path of the directory */
+} vfs_dirat_t;
+
 /**
  * @brief User facing directory entry
  *
@@ -368,6 +422,37 @@ struct vfs_file_ops {
      * @return <0 on error
      */
     ssize_t (*write) (vfs_file_t *filp, const void *src, size_t nbytes);
+
+    /**
+     * @brief Read bytes from an open file into a list of buffers
+     *
+     * The buffers in @p iolist are filled in order, a buffer is only started
+     * when the previous one has been filled completely.
+     *
+     * This function is optional, the VFS layer falls back to calling @c read
+     * for every element of @p iolist if it is NULL.
+     *
+     * @param[in]  filp     pointer to open file
+     * @param[in]  iolist   list of destination buffers
+     *
+     * @return number of bytes read on success
+     * @return <0 on error
+     */
+    ssize_t (*readv) (vfs_file_t *filp, const iolist_t *iolist);
+
+    /**
+     * @brief Write bytes from a list of buffers to an open file
+     *
+     * This function is optional, the VFS layer falls back to calling @c write
+     * for every element of @p iolist if it is NULL.
+     *
+     * @param[in]  filp     pointer to open file
+     * @param[in]  iolist   list of source buffers
+     *
+     * @return number of bytes written on success
+     * @return <0 on error
+     */
+    ssize_t (*writev) (vfs_file_t *filp, const iolist_t *iolist);
 };
 
 /**
@@ -643,6 +728,76 @@ off_t vfs_lseek(int fd, off_t off, int whence);
  */
 int vfs_open(const char *name, int flags, mode_t mode);
 
+/**
+ * @brief Resolve a directory for use with vfs_openat(), vfs_unlinkat() and
+ * vfs_statat()
+ *
+ * The mount point lookup is only done once here, operations relative to
+ * @p dir skip the resolution of the directory part of the path.
+ *
+ * The names passed to the @c vfs_*at() functions must be entries of the
+ * directory itself: names that are empty, contain a '/', or are "." or ".."
+ * are rejected with -EINVAL.
+ *
+ * @param[out] dir      directory handle to initialize
+ * @param[in]  dirname  absolute path of the directory
+ *
+ * @return 0 on success
+ * @return -ENAMETOOLONG if @p dirname is longer than VFS_DIRAT_PATH_MAX
+ * @return <0 on error
+ */
+int vfs_dirat_open(vfs_dirat_t *dir, const char *dirname);
+
+/**
+ * @brief Release a directory handle obtained by vfs_dirat_open()
+ *
+ * @param[in]  dir      directory handle to release
+ *
+ * @return 0 on success
+ * @return <0 on error
+ */
+int vfs_dirat_close(vfs_dirat_t *dir);
+
+/**
+ * @brief Open a file relative to a resolved directory
+ *
+ * @param[in]  dir     directory handle obtained by vfs_dirat_open()
+ * @param[in]  name    file name to open, relative to @p dir
+ * @param[in]  flags   flags for opening, see man 3p open
+ * @param[in]  mode    file mode
+ *
+ * @return fd number on success (>= 0)
+ * @return -EINVAL if @p name is not a single entry of @p dir
+ * @return <0 on error
+ */
+int vfs_openat(const vfs_dirat_t *dir, const char *name, int flags, mode_t mode);
+
+/**
+ * @brief Unlink (delete) a file relative to a resolved directory
+ *
+ * @param[in]  dir     directory handle obtained by vfs_dirat_open()
+ * @param[in]  name    file name to delete, relative to @p dir
+ *
+ * @return 0 on success
+ * @return -EINVAL if @p name is not a single entry of @p dir
+ * @return <0 on error
+ */
+int vfs_unlinkat(const vfs_dirat_t *dir, const char *name);
+
+/**
+ * @brief Get file status of a file relative to a resolved directory
+ *
+ * @param[in]  dir     directory handle obtained by vfs_dirat_open()
+ * @param[in]  name    file name, relative to @p dir
+ * @param[out] buf     pointer to stat struct to fill
+ *
+ * @return 0 on success
+ * @return -EINVAL if @p name is not a single entry of @p dir
+ * @return <0 on error
+ */
+int vfs_statat(const vfs_dirat_t *dir, const char *restrict name,
+               struct stat *restrict buf);
+
 /**
  * @brief Read bytes from an open file
  *
@@ -667,6 +822,60 @@ ssize_t vfs_read(int fd, void *dest, size_t count);
  */
 ssize_t vfs_write(int fd, const void *src, size_t count);
 
+/**
+ * @brief Read bytes from an open file into a list of buffers
+ *
+ * Scatter variant of vfs_read(), the buffers in @p iolist are filled in order.
+ *
+ * @param[in]  fd       fd number obtained from vfs_open
+ * @param[in]  iolist   list of destination buffers
+ *
+ * @return number of bytes read on success
+ * @return <0 on error
+ */
+ssize_t vfs_readv(int fd, const iolist_t *iolist);
+
+/**
+ * @brief Write bytes from a list of buffers to an open file
+ *
+ * Gather variant of vfs_write(), allows writing e.g. a header and a payload
+ * without assembling them in a contiguous buffer first.
+ *
+ * @param[in]  fd       fd number obtained from vfs_open
+ * @param[in]  iolist   list of source buffers
+ *
+ * @return number of bytes written on success
+ * @return <0 on error
+ */
+ssize_t vfs_writev(int fd, const iolist_t *iolist);
+
+/**
+ * @brief Copy bytes from one open file to another
+ *
+ * Similar to Linux sendfile(2). As sockets from @ref posix_sockets are bound
+ * to VFS file descriptors, this can be used to serve a file over a connected
+ * TCP or UDP socket without a staging buffer for the whole file.
+ *
+ * This is a convenience wrapper, not a zero-copy transfer: the data is
+ * copied with vfs_read() and vfs_write() through a buffer of
+ * @ref VFS_SENDFILE_BUFSIZE bytes on the stack of the caller.
+ *
+ * If @p offset is not NULL, reading starts at @p *offset and the file
+ * position of @p in_fd is not modified, @p *offset is updated to the offset
+ * following the last byte read. If @p offset is NULL, reading starts at the
+ * current file position of @p in_fd, which is updated.
+ *
+ * @param[in]     out_fd   fd to write to
+ * @param[in]     in_fd    fd to read from, must support seeking if @p offset
+ *                         is not NULL
+ * @param[in,out] offset   read offset in @p in_fd, may be NULL
+ * @param[in]     count    number of bytes to copy
+ *
+ * @return number of bytes written to @p out_fd on success
+ * @return <0 on error
+ */
+ssize_t vfs_sendfile(int out_fd, int in_fd, off_t *offset, size_t count);
+
 /**
  * @brief Open a directory for reading with readdir
  *
@@ -37,6 +37,21 @@ int isrpipe_write_one(isrpipe_t *isrpipe, uint8_t c)
     return res;
 }
 
+int isrpipe_write(isrpipe_t *isrpipe, const uint8_t *buf, size_t count)
+{
+    int res = tsrb_add(&isrpipe->tsrb, buf, count);
+
+    mutex_unlock(&isrpipe->mutex);
+
+    return res;
+}
+
+void isrpipe_commit(isrpipe_t *isrpipe, size_t count)
+{
+    tsrb_commit(&isrpipe->tsrb, count);
+    mutex_unlock(&isrpipe->mutex);
+}
+
 int isrpipe_read(isrpipe_t *isrpipe, uint8_t *buffer, size_t count)
 {
     int res;
@@ -46,3 +61,13 @@ int isrpipe_read(isrpipe_t *isrpipe, uint8_t *buffer, size_t count)
     }
     return res;
 }
+
+size_t isrpipe_peek_iov(isrpipe_t *isrpipe, struct iovec iov[2], size_t count)
+{
+    size_t res;
+
+    while (!(res = tsrb_peek_iov(&isrpipe->tsrb, iov, count))) {
+        mutex_lock(&isrpipe->mutex);
+    }
+    return res;
+}
@@ -6,7 +6,10 @@
  * directory for more details.
  */
 
+#include <assert.h>
+#include <stdlib.h>
 #include <string.h>
+
 #include "memarray.h"
 
 #define ENABLE_DEBUG    (0)
@@ -20,35 +23,77 @@ void memarray_init(memarray_t *mem, void *data, size_t size, size_t num)
     DEBUG("memarray: Initialize memarray of %u times %u Bytes at %p\n",
           (unsigned)num, (unsigned)size, data);
 
-    mem->free_data = data;
-    mem->size = size;
-    mem->num = num;
+    *mem = (memarray_t)MEMARRAY_INIT(data, size, num);
+}
+
+void memarray_extend(memarray_t *mem, void *data, size_t num)
+{
+    assert((mem != NULL) && (data != NULL));
+
+    DEBUG("memarray: Extend memarray by %u times %u Bytes at %p\n",
+          (unsigned)num, (unsigned)mem->size, data);
+
+    if (mem->unused_num == 0) {
+        mem->unused = data;
+        mem->unused_num = num;
+    }
+    else {
+        for (size_t i = 0; i < num; i++) {
+            memcpy(((char *)data) + (i * mem->size), &mem->free_data,
+                   sizeof(void *));
+            mem->free_data = ((char *)data) + (i * mem->size);
+        }
+    }
+    mem->num += num;
+}
+
+#ifdef MODULE_MEMARRAY_GROW
+static void _grow(memarray_t *mem)
+{
+    void *data = malloc(mem->grow * mem->size);
 
-    for (size_t i = 0; i < (mem->num - 1); i++) {
-        void *next = ((char *)mem->free_data) + ((i + 1) * mem->size);
-        memcpy(((char *)mem->free_data) + (i * mem->size), &next, sizeof(void *));
+    if (data != NULL) {
+        memarray_extend(mem, data, mem->grow);
     }
-    memset(((char *)mem->free_data) + ((mem->num - 1) * (mem->size)), 0, sizeof(void *));
 }
+#endif
 
 void *memarray_alloc(memarray_t *mem)
 {
     assert(mem != NULL);
 
-    if (mem->free_data == NULL) {
+    void *free = mem->free_data;
+
+#ifdef MODULE_MEMARRAY_GROW
+    if ((free == NULL) && (mem->unused_num == 0) && (mem->grow != 0)) {
+        _grow(mem);
+    }
+#endif
+    if (free != NULL) {
+        memcpy(&mem->free_data, free, sizeof(void *));
+    }
+    else if (mem->unused_num != 0) {
+        free = mem->unused;
+        mem->unused = ((char *)mem->unused) + mem->size;
+        mem->unused_num--;
+    }
+    else {
+        mem->failed++;
         return NULL;
     }
-    void *free = mem->free_data;
-    mem->free_data = *((void **)mem->free_data);
+    if (++mem->used > mem->max_used) {
+        mem->max_used = mem->used;
+    }
     DEBUG("memarray: Allocate %u Bytes at %p\n", (unsigned)mem->size, free);
     return free;
 }
 
 void memarray_free(memarray_t *mem, void *ptr)
 {
-    assert((mem != NULL) && (ptr != NULL));
+    assert((mem != NULL) && (ptr != NULL) && (mem->used > 0));
 
     memcpy(ptr, &mem->free_data, sizeof(void *));
     mem->free_data = ptr;
+    mem->used--;
     DEBUG("memarray: Free %u Bytes at %p\n", (unsigned)mem->size, ptr);
 }
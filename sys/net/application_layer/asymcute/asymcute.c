@@ -66,6 +66,7 @@ static char _stack[ASYMCUTE_HANDLER_STACKSIZE];
 
 /* necessary forward function declarations */
 static void _on_req_timeout(void *arg);
+static unsigned _on_pub_timeout(asymcute_con_t *con, asymcute_req_t *req);
 
 static size_t _len_set(uint8_t *buf, size_t len)
 {
@@ -168,22 +169,37 @@ static void _compile_sub_unsub(asymcute_req_t *req, asymcute_con_t *con,
     req->arg = (void *)sub;
 }
 
+static void _req_tx(asymcute_req_t *req, asymcute_con_t *con)
+{
+    /* the payload of asymcute_publishv() is sent right from the user's
+     * buffers */
+    iolist_t snip = {
+        .iol_next = (iolist_t *)req->payload,
+        .iol_base = req->data,
+        .iol_len = req->data_len,
+    };
+    sock_udp_sendv(&con->sock, &snip, &con->server_ep);
+}
+
 static void _req_resend(asymcute_req_t *req, asymcute_con_t *con)
 {
     event_timeout_set(&req->to_timer, RETRY_TO);
-    sock_udp_send(&con->sock, req->data, req->data_len, &con->server_ep);
+    _req_tx(req, con);
 }
 
-/* @pre con is locked */
-static void _req_send(asymcute_req_t *req, asymcute_con_t *con,
+static void _req_init(asymcute_req_t *req, asymcute_con_t *con,
                       asymcute_to_cb_t cb)
 {
-    /* initialize request */
     req->con = con;
     req->cb = cb;
     req->retry_cnt = ASYMCUTE_N_RETRY;
     event_callback_init(&req->to_evt, _on_req_timeout, (void *)req);
     event_timeout_init(&req->to_timer, &_queue, &req->to_evt.super);
+}
+
+/* @pre con is locked */
+static void _req_pend(asymcute_req_t *req, asymcute_con_t *con)
+{
     /* add request to the pending queue (if non-con request) */
     req->next = con->pending;
     con->pending = req;
@@ -191,12 +207,113 @@ static void _req_send(asymcute_req_t *req, asymcute_con_t *con,
     _req_resend(req, con);
 }
 
+/* @pre con is locked */
+static void _req_send(asymcute_req_t *req, asymcute_con_t *con,
+                      asymcute_to_cb_t cb)
+{
+    /* only PUBLISH messages carry a separate payload */
+    req->payload = NULL;
+    _req_init(req, con, cb);
+    _req_pend(req, con);
+}
+
 static void _req_send_once(asymcute_req_t *req, asymcute_con_t *con)
 {
-    sock_udp_send(&con->sock, req->data, req->data_len, &con->server_ep);
+    _req_tx(req, con);
     mutex_unlock(&req->lock);
 }
 
+/* @pre con is locked */
+static void _pub_flush(asymcute_con_t *con)
+{
+    while (con->pub_queue && (con->pub_inflight < ASYMCUTE_PUBLISH_WINDOW)) {
+        asymcute_req_t *req = con->pub_queue;
+        con->pub_queue = req->next;
+        con->pub_inflight++;
+        _req_pend(req, con);
+    }
+}
+
+/* @pre con is locked */
+static void _pub_send(asymcute_req_t *req, asymcute_con_t *con)
+{
+    _req_init(req, con, _on_pub_timeout);
+    /* queue behind earlier publishes to keep their order */
+    req->next = NULL;
+    asymcute_req_t **tail = &con->pub_queue;
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
+    *tail = req;
+    _pub_flush(con);
+}
+
+/* @pre con is locked */
+static void _pub_done(asymcute_con_t *con, asymcute_req_t *req)
+{
+    if ((req->cb == _on_pub_timeout) && con->pub_inflight) {
+        con->pub_inflight--;
+    }
+}
+
+#if ASYMCUTE_TOPIC_CACHE_SIZE
+/* @pre con is locked */
+static uint16_t _topic_cache_get(asymcute_con_t *con, const char *name)
+{
+    for (unsigned i = 0; i < ASYMCUTE_TOPIC_CACHE_SIZE; i++) {
+        if (con->topic_cache[i].id &&
+            (strcmp(con->topic_cache[i].name, name) == 0)) {
+            return con->topic_cache[i].id;
+        }
+    }
+    return 0;
+}
+
+/* @pre con is locked */
+static void _topic_cache_put(asymcute_con_t *con, const asymcute_topic_t *topic)
+{
+    if (topic->flags != MQTTSN_TIT_NORMAL) {
+        return;
+    }
+
+    /* reuse the entry for the same name, otherwise evict the oldest */
+    unsigned i;
+    for (i = 0; i < ASYMCUTE_TOPIC_CACHE_SIZE - 1; i++) {
+        if (!con->topic_cache[i].id ||
+            (strcmp(con->topic_cache[i].name, topic->name) == 0)) {
+            break;
+        }
+    }
+    memmove(&con->topic_cache[1], &con->topic_cache[0],
+            i * sizeof(con->topic_cache[0]));
+    con->topic_cache[0].id = topic->id;
+    strcpy(con->topic_cache[0].name, topic->name);
+}
+
+static void _topic_cache_clear(asymcute_con_t *con)
+{
+    memset(con->topic_cache, 0, sizeof(con->topic_cache));
+}
+#else
+static uint16_t _topic_cache_get(asymcute_con_t *con, const char *name)
+{
+    (void)con;
+    (void)name;
+    return 0;
+}
+
+static void _topic_cache_put(asymcute_con_t *con, const asymcute_topic_t *topic)
+{
+    (void)con;
+    (void)topic;
+}
+
+static void _topic_cache_clear(asymcute_con_t *con)
+{
+    (void)con;
+}
+#endif
+
 static void _req_cancel(asymcute_req_t *req)
 {
     asymcute_con_t *con = req->con;
@@ -222,6 +339,11 @@ static void _disconnect(asymcute_con_t *con, uint8_t state)
             _req_cancel(req);
         }
         con->pending = NULL;
+        for (asymcute_req_t *req = con->pub_queue; req; req = req->next) {
+            _req_cancel(req);
+        }
+        con->pub_queue = NULL;
+        con->pub_inflight = 0;
         for (asymcute_sub_t *sub = con->subscriptions; sub; sub = sub->next) {
             _sub_cancel(sub);
         }
@@ -253,6 +375,7 @@ static void _on_req_timeout(void *arg)
         if (req->cb) {
             ret = req->cb(con, req);
         }
+        _pub_flush(con);
         mutex_unlock(&req->lock);
         mutex_unlock(&con->lock);
         con->user_cb(req, ret);
@@ -275,6 +398,14 @@ static unsigned _on_discon_timeout(asymcute_con_t *con, asymcute_req_t *req)
     return ASYMCUTE_DISCONNECTED;
 }
 
+static unsigned _on_pub_timeout(asymcute_con_t *con, asymcute_req_t *req)
+{
+    (void)req;
+
+    con->pub_inflight--;
+    return ASYMCUTE_TIMEOUT;
+}
+
 static unsigned _on_suback_timeout(asymcute_con_t *con, asymcute_req_t *req)
 {
     (void)con;
@@ -398,6 +529,7 @@ static void _on_regack(asymcute_con_t *con, const uint8_t *data, size_t len)
 
         topic->id = byteorder_bebuftohs(&data[2]);
         topic->con = con;
+        _topic_cache_put(con, topic);
         ret = ASYMCUTE_REGISTERED;
     }
 
@@ -407,6 +539,23 @@ static void _on_regack(asymcute_con_t *con, const uint8_t *data, size_t len)
     con->user_cb(req, ret);
 }
 
+static void _on_reg_cached(void *arg)
+{
+    asymcute_req_t *req = (asymcute_req_t *)arg;
+    asymcute_con_t *con = req->con;
+
+    mutex_lock(&con->lock);
+    unsigned ret = ASYMCUTE_CANCELED;
+    if (asymcute_is_connected(con)) {
+        ((asymcute_topic_t *)req->arg)->con = con;
+        ret = ASYMCUTE_REGISTERED;
+    }
+    req->con = NULL;
+    mutex_unlock(&req->lock);
+    mutex_unlock(&con->lock);
+    con->user_cb(req, ret);
+}
+
 static void _on_publish(asymcute_con_t *con, uint8_t *data,
                         size_t pos, size_t len)
 {
@@ -454,6 +603,9 @@ static void _on_puback(asymcute_con_t *con, const uint8_t *data, size_t len)
         return;
     }
 
+    /* the publish window is refilled once all received messages are
+     * handled */
+    _pub_done(con, req);
     unsigned ret = (data[6] == MQTTSN_ACCEPTED) ?
                     ASYMCUTE_PUBLISHED : ASYMCUTE_REJECTED;
     mutex_unlock(&req->lock);
@@ -481,6 +633,7 @@ static void _on_suback(asymcute_con_t *con, const uint8_t *data, size_t len)
 
         sub->topic->id = byteorder_bebuftohs(&data[3]);
         sub->topic->con = con;
+        _topic_cache_put(con, sub->topic);
         /* insert subscription to connection context */
         sub->next = con->subscriptions;
         con->subscriptions = sub;
@@ -597,9 +750,16 @@ void *_listener(void *arg)
         sock_udp_ep_t remote;
         int n = sock_udp_recv(&con->sock, con->rxbuf, ASYMCUTE_BUFSIZE,
                               SOCK_NO_TIMEOUT, &remote);
-        if (n > 0) {
+        /* handle everything that arrived in the meantime, so a burst of
+         * PUBACKs is answered by a burst of queued publishes */
+        while (n > 0) {
             _on_data(con, (size_t)n, &remote);
+            n = sock_udp_recv(&con->sock, con->rxbuf, ASYMCUTE_BUFSIZE, 0,
+                              &remote);
         }
+        mutex_lock(&con->lock);
+        _pub_flush(con);
+        mutex_unlock(&con->lock);
     }
 
     /* should never be reached */
@@ -741,6 +901,11 @@ int asymcute_connect(asymcute_con_t *con, asymcute_req_t *req,
         goto end;
     }
 
+    /* remembered topic IDs are only valid in a resumed session */
+    if (clean || !sock_udp_ep_equal(&con->server_ep, server)) {
+        _topic_cache_clear(con);
+    }
+
     /* prepare the connection context */
     con->state = CONNECTING;
     strncpy(con->cli_id, cli_id, sizeof(con->cli_id));
@@ -827,6 +992,18 @@ int asymcute_register(asymcute_con_t *con, asymcute_req_t *req,
 
     /* prepare registration request */
     req->msg_id = _msg_id_next(con);
+
+    /* the gateway still knows the topic ID, complete from the handler
+     * thread, like any other request */
+    uint16_t id = _topic_cache_get(con, topic->name);
+    if (id) {
+        topic->id = id;
+        req->con = con;
+        event_callback_init(&req->to_evt, _on_reg_cached, (void *)req);
+        event_post(&_queue, &req->to_evt.super);
+        goto end;
+    }
+
     size_t pos = _len_set(req->data, (topic_len + 5));
     req->data[pos] = MQTTSN_REGISTER;
     byteorder_htobebufs(&req->data[pos + 1], 0);
@@ -842,25 +1019,16 @@ end:
     return ret;
 }
 
-int asymcute_publish(asymcute_con_t *con, asymcute_req_t *req,
-                     const asymcute_topic_t *topic,
-                     const void *data, size_t data_len, uint8_t flags)
+static int _publish(asymcute_con_t *con, asymcute_req_t *req,
+                    const asymcute_topic_t *topic, const void *data,
+                    const iolist_t *payload, size_t data_len, uint8_t flags)
 {
-    assert(con);
-    assert(req);
-    assert(topic);
-    assert((data_len == 0) || data);
-
     int ret = ASYMCUTE_OK;
 
     /* check for valid flags */
     if ((flags & VALID_PUBLISH_FLAGS) != flags) {
         return ASYMCUTE_NOTSUP;
     }
-    /* check for message size */
-    if ((data_len + 9) > ASYMCUTE_BUFSIZE) {
-        return ASYMCUTE_OVERFLOW;
-    }
     /* make sure topic is registered */
     if (!asymcute_topic_is_reg(topic) || (topic->con != con)) {
         return ASYMCUTE_REGERR;
@@ -886,12 +1054,18 @@ int asymcute_publish(asymcute_con_t *con, asymcute_req_t *req,
     req->data[pos + 1] = (flags | topic->flags);
     byteorder_htobebufs(&req->data[pos + 2], topic->id);
     byteorder_htobebufs(&req->data[pos + 4], req->msg_id);
-    memcpy(&req->data[pos + 6], data, data_len);
-    req->data_len = (pos + 6 + data_len);
+    req->payload = payload;
+    if (payload) {
+        req->data_len = (pos + 6);
+    }
+    else {
+        memcpy(&req->data[pos + 6], data, data_len);
+        req->data_len = (pos + 6 + data_len);
+    }
 
     /* publish selected data */
     if (flags & MQTTSN_QOS_1) {
-        _req_send(req, con, NULL);
+        _pub_send(req, con);
     }
     else {
         _req_send_once(req, con);
@@ -902,6 +1076,39 @@ end:
     return ret;
 }
 
+int asymcute_publish(asymcute_con_t *con, asymcute_req_t *req,
+                     const asymcute_topic_t *topic,
+                     const void *data, size_t data_len, uint8_t flags)
+{
+    assert(con);
+    assert(req);
+    assert(topic);
+    assert((data_len == 0) || data);
+
+    /* check for message size */
+    if ((data_len + 9) > ASYMCUTE_BUFSIZE) {
+        return ASYMCUTE_OVERFLOW;
+    }
+    return _publish(con, req, topic, data, NULL, data_len, flags);
+}
+
+int asymcute_publishv(asymcute_con_t *con, asymcute_req_t *req,
+                      const asymcute_topic_t *topic, const iolist_t *data,
+                      uint8_t flags)
+{
+    assert(con);
+    assert(req);
+    assert(topic);
+
+    size_t data_len = iolist_size(data);
+
+    /* the length field of the message is 16 bit wide */
+    if ((data_len + 9) > UINT16_MAX) {
+        return ASYMCUTE_OVERFLOW;
+    }
+    return _publish(con, req, topic, NULL, data, data_len, flags);
+}
+
 int asymcute_subscribe(asymcute_con_t *con, asymcute_req_t *req,
                        asymcute_sub_t *sub, asymcute_topic_t *topic,
                        asymcute_sub_cb_t callback, void *arg, uint8_t flags)
@@ -16,23 +16,53 @@
  */
 
 #include <arpa/inet.h>
+#include <ctype.h>
+#include <stdbool.h>
 #include <string.h>
 #include <stdio.h>
 
 #include "net/dns.h"
 #include "net/sock/udp.h"
 #include "net/sock/dns.h"
+#include "random.h"
+#include "xtimer.h"
 
 #ifdef RIOT_VERSION
 #include "byteorder.h"
 #endif
 
+#ifdef MODULE_SOCK_DNS_CACHE
+#include "mutex.h"
+#endif
+
 /* min domain name length is 1, so minimum record length is 7 */
 #define DNS_MIN_REPLY_LEN   (unsigned)(sizeof(sock_dns_hdr_t ) + 7)
 
+/* set in the flags of a reply */
+#define DNS_FLAG_QR         (0x8000)
+
+/* response code of a reply without error and for a name that does not exist */
+#define DNS_RCODE_NOERROR   (0)
+#define DNS_RCODE_NXDOMAIN  (3)
+
 /* global DNS server UDP endpoint */
 sock_udp_ep_t sock_dns_server;
 
+#ifdef MODULE_SOCK_DNS_CACHE
+typedef struct {
+    uint32_t expires;               /* in seconds since boot */
+    int res;                        /* result of the lookup, 0 if unused */
+    int family;
+    uint8_t addr[16];
+    char name[SOCK_DNS_MAX_NAME_LEN + 1];
+} _cache_entry_t;
+
+/* protects the cache and the list of running queries */
+static mutex_t _cache_lock = MUTEX_INIT;
+static _cache_entry_t _cache[CONFIG_SOCK_DNS_CACHE_SIZE];
+static sock_dns_query_t *_running;
+#endif
+
 static ssize_t _enc_domain_name(uint8_t *out, const char *domain_name)
 {
     /*
@@ -75,6 +105,13 @@ static unsigned _get_short(uint8_t *buf)
     return _tmp;
 }
 
+static uint32_t _get_long(uint8_t *buf)
+{
+    uint32_t _tmp;
+    memcpy(&_tmp, buf, 4);
+    return _tmp;
+}
+
 static ssize_t _skip_hostname(const uint8_t *buf, size_t len, uint8_t *bufpos)
 {
     const uint8_t *buflim = buf + len;
@@ -102,11 +139,15 @@ static ssize_t _skip_hostname(const uint8_t *buf, size_t len, uint8_t *bufpos)
     return res + 1;
 }
 
-static int _parse_dns_reply(uint8_t *buf, size_t len, void* addr_out, int family)
+static int _parse_dns_reply(uint8_t *buf, size_t len, void* addr_out, int family,
+                            uint32_t *ttl)
 {
     const uint8_t *buflim = buf + len;
     sock_dns_hdr_t *hdr = (sock_dns_hdr_t*) buf;
     uint8_t *bufpos = buf + sizeof(*hdr);
+    /* first A record, used if AAAA was requested as well but not found */
+    const uint8_t *addr4 = NULL;
+    uint32_t addr4_ttl = 0;
 
     /* skip all queries that are part of the reply */
     for (unsigned n = 0; n < ntohs(hdr->qdcount); n++) {
@@ -125,14 +166,20 @@ static int _parse_dns_reply(uint8_t *buf, size_t len, void* addr_out, int family
             return tmp;
         }
         bufpos += tmp;
-        if ((bufpos + RR_TYPE_LENGTH + RR_CLASS_LENGTH + RR_TTL_LENGTH) >= buflim) {
+        if ((bufpos + RR_TYPE_LENGTH + RR_CLASS_LENGTH + RR_TTL_LENGTH +
+             RR_RDLENGTH_LENGTH) > buflim) {
             return -EBADMSG;
         }
         uint16_t _type = ntohs(_get_short(bufpos));
         bufpos += RR_TYPE_LENGTH;
         uint16_t class = ntohs(_get_short(bufpos));
         bufpos += RR_CLASS_LENGTH;
-        bufpos += RR_TTL_LENGTH; /* skip ttl */
+        uint32_t _ttl = ntohl(_get_long(bufpos));
+        bufpos += RR_TTL_LENGTH;
+        if (_ttl > INT32_MAX) {
+            /* RFC 2181, section 8: treat as zero */
+            _ttl = 0;
+        }
 
         unsigned addrlen = ntohs(_get_short(bufpos));
         /* skip unwanted answers */
@@ -145,7 +192,7 @@ static int _parse_dns_reply(uint8_t *buf, size_t len, void* addr_out, int family
                 /* buffer wraps around memory space */
                 return -EBADMSG;
             }
-            bufpos += addrlen;
+            bufpos += RR_RDLENGTH_LENGTH + addrlen;
             /* other out-of-bound is checked in `_skip_hostname()` at start of
              * loop */
             continue;
@@ -160,14 +207,475 @@ static int _parse_dns_reply(uint8_t *buf, size_t len, void* addr_out, int family
         if ((bufpos + addrlen) > buflim) {
             return -EBADMSG;
         }
+        if ((family == AF_UNSPEC) && (addrlen == INADDRSZ)) {
+            if (!addr4) {
+                addr4 = bufpos;
+                addr4_ttl = _ttl;
+            }
+            bufpos += addrlen;
+            continue;
+        }
 
         memcpy(addr_out, bufpos, addrlen);
+        if (ttl) {
+            *ttl = _ttl;
+        }
         return addrlen;
     }
 
+    if (addr4) {
+        memcpy(addr_out, addr4, INADDRSZ);
+        if (ttl) {
+            *ttl = addr4_ttl;
+        }
+        return INADDRSZ;
+    }
     return -1;
 }
 
+static size_t _build_query(uint8_t *buf, uint16_t id, const char *domain_name,
+                           int family)
+{
+    sock_dns_hdr_t *hdr = (sock_dns_hdr_t*) buf;
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->id = id;
+    hdr->flags = htons(0x0120);
+    hdr->qdcount = htons(1 + (family == AF_UNSPEC));
+
+    uint8_t *bufpos = buf + sizeof(*hdr);
+
+    unsigned _name_ptr;
+    if ((family == AF_INET6) || (family == AF_UNSPEC)) {
+        _name_ptr = (bufpos - buf);
+        bufpos += _enc_domain_name(bufpos, domain_name);
+        bufpos += _put_short(bufpos, htons(DNS_TYPE_AAAA));
+        bufpos += _put_short(bufpos, htons(DNS_CLASS_IN));
+    }
+
+    if ((family == AF_INET) || (family == AF_UNSPEC)) {
+        if (family == AF_UNSPEC) {
+            bufpos += _put_short(bufpos, htons((0xc000) | (_name_ptr)));
+        }
+        else {
+            bufpos += _enc_domain_name(bufpos, domain_name);
+        }
+        bufpos += _put_short(bufpos, htons(DNS_TYPE_A));
+        bufpos += _put_short(bufpos, htons(DNS_CLASS_IN));
+    }
+
+    return bufpos - buf;
+}
+
+/* compares the possibly compressed name at pos with domain_name, ignoring
+ * case */
+static bool _match_name(const uint8_t *buf, size_t len, const uint8_t *pos,
+                        const char *domain_name)
+{
+    const uint8_t *buflim = buf + len;
+
+    while (pos < buflim) {
+        unsigned label = *pos++;
+
+        if (label >= 192) {
+            if (pos >= buflim) {
+                return false;
+            }
+            size_t offset = ((label & 0x3f) << 8) | *pos;
+            /* only pointers to earlier names, so this terminates */
+            if (offset >= (size_t)(pos - 1 - buf)) {
+                return false;
+            }
+            pos = buf + offset;
+            continue;
+        }
+        if (label == 0) {
+            return *domain_name == '\0';
+        }
+        if ((label > 63) || ((pos + label) > buflim)) {
+            return false;
+        }
+        for (unsigned i = 0; i < label; i++, domain_name++) {
+            if (!*domain_name || (*domain_name == '.') ||
+                (tolower(*domain_name) != tolower(pos[i]))) {
+                return false;
+            }
+        }
+        pos += label;
+        if (*domain_name == '.') {
+            domain_name++;
+        }
+        else if (*domain_name) {
+            return false;
+        }
+    }
+    return false;
+}
+
+/* checks that buf is the reply to the query with id for domain_name, anything
+ * else, e.g. a late reply to an earlier query or a spoofed one, is dropped */
+static bool _reply_matches(uint8_t *buf, size_t len, uint16_t id,
+                           const char *domain_name, int family)
+{
+    sock_dns_hdr_t *hdr = (sock_dns_hdr_t *)buf;
+    const uint8_t *buflim = buf + len;
+    uint8_t *bufpos = buf + sizeof(*hdr);
+    /* one bit per record type asked for: AAAA, A */
+    unsigned expected = ((family != AF_INET) ? 0x1 : 0) |
+                        ((family != AF_INET6) ? 0x2 : 0);
+    unsigned found = 0;
+
+    if ((len < sizeof(*hdr)) || (hdr->id != id) ||
+        !(ntohs(hdr->flags) & DNS_FLAG_QR) ||
+        (ntohs(hdr->qdcount) != (1U + (family == AF_UNSPEC)))) {
+        return false;
+    }
+    for (unsigned n = 0; n < ntohs(hdr->qdcount); n++) {
+        ssize_t tmp = _skip_hostname(buf, len, bufpos);
+        if ((tmp < 0) || !_match_name(buf, len, bufpos, domain_name)) {
+            return false;
+        }
+        bufpos += tmp;
+        if ((bufpos + RR_TYPE_LENGTH + RR_CLASS_LENGTH) > buflim) {
+            return false;
+        }
+        uint16_t _type = ntohs(_get_short(bufpos));
+        bufpos += RR_TYPE_LENGTH;
+        uint16_t class = ntohs(_get_short(bufpos));
+        bufpos += RR_CLASS_LENGTH;
+        if (class != DNS_CLASS_IN) {
+            return false;
+        }
+        found |= (_type == DNS_TYPE_AAAA) ? 0x1 :
+                 (_type == DNS_TYPE_A) ? 0x2 : 0x4;
+    }
+    return found == expected;
+}
+
+static int _handle_reply(uint8_t *buf, ssize_t len, void *addr_out, int family,
+                         uint32_t *ttl)
+{
+    if (len <= (int)DNS_MIN_REPLY_LEN) {
+        return -EBADMSG;
+    }
+    return _parse_dns_reply(buf, len, addr_out, family, ttl);
+}
+
+#ifdef MODULE_SOCK_DNS_CACHE
+static uint32_t _now_sec(void)
+{
+    return xtimer_now_usec64() / US_PER_SEC;
+}
+
+static _cache_entry_t *_cache_find(const char *domain_name, int family)
+{
+    for (unsigned i = 0; i < CONFIG_SOCK_DNS_CACHE_SIZE; i++) {
+        if (_cache[i].res && (_cache[i].family == family) &&
+            (strcmp(_cache[i].name, domain_name) == 0)) {
+            return &_cache[i];
+        }
+    }
+    return NULL;
+}
+
+/* returns 0 if not cached, the cached result otherwise */
+static int _cache_get(const char *domain_name, void *addr_out, int family)
+{
+    _cache_entry_t *entry = _cache_find(domain_name, family);
+
+    if (!entry) {
+        return 0;
+    }
+    if ((int32_t)(entry->expires - _now_sec()) <= 0) {
+        entry->res = 0;
+        return 0;
+    }
+    if (entry->res > 0) {
+        memcpy(addr_out, entry->addr, entry->res);
+    }
+    return entry->res;
+}
+
+static void _cache_put(const char *domain_name, const void *addr, int family,
+                       int res, uint32_t ttl)
+{
+    uint32_t now = _now_sec();
+    _cache_entry_t *entry = _cache_find(domain_name, family);
+
+    if (ttl == 0) {
+        return;
+    }
+    if (ttl > CONFIG_SOCK_DNS_CACHE_MAX_TTL) {
+        ttl = CONFIG_SOCK_DNS_CACHE_MAX_TTL;
+    }
+    if (!entry) {
+        /* replace the entry to expire first, expired ones included */
+        entry = &_cache[0];
+        for (unsigned i = 1; i < CONFIG_SOCK_DNS_CACHE_SIZE; i++) {
+            if (!entry->res) {
+                break;
+            }
+            if (!_cache[i].res ||
+                ((int32_t)(_cache[i].expires - entry->expires) < 0)) {
+                entry = &_cache[i];
+            }
+        }
+        strcpy(entry->name, domain_name);
+        entry->family = family;
+    }
+    entry->expires = now + ttl;
+    entry->res = res;
+    if (res > 0) {
+        memcpy(entry->addr, addr, res);
+    }
+}
+
+void sock_dns_cache_flush(void)
+{
+    mutex_lock(&_cache_lock);
+    for (unsigned i = 0; i < CONFIG_SOCK_DNS_CACHE_SIZE; i++) {
+        _cache[i].res = 0;
+    }
+    mutex_unlock(&_cache_lock);
+}
+#endif /* MODULE_SOCK_DNS_CACHE */
+
+#ifdef MODULE_SOCK_DNS_ASYNC
+static inline uint32_t *_query_ttl(sock_dns_query_t *query)
+{
+#ifdef MODULE_SOCK_DNS_CACHE
+    return &query->ttl;
+#else
+    (void)query;
+    return NULL;
+#endif
+}
+
+#ifdef MODULE_SOCK_DNS_CACHE
+/* checks if a reply without usable record is worth caching */
+static bool _negative_reply(uint8_t *buf, int res)
+{
+    sock_dns_hdr_t *hdr = (sock_dns_hdr_t *)buf;
+    unsigned rcode = ntohs(hdr->flags) & 0xf;
+
+    return (res != -EBADMSG) &&
+           ((rcode == DNS_RCODE_NOERROR) || (rcode == DNS_RCODE_NXDOMAIN));
+}
+#endif
+
+static void _sock_cb(sock_udp_t *sock, sock_async_flags_t type, void *arg)
+{
+    (void)sock;
+    if (type & SOCK_ASYNC_MSG_RECV) {
+        coro_wake(arg);
+    }
+}
+
+/* a reply that arrived with the timeout may have left the event of the sock
+ * queued, the query must not be referenced by it once it is done */
+static void _sock_close(sock_udp_t *sock, event_queue_t *queue)
+{
+    sock_udp_close(sock);
+    event_cancel(queue, &sock_udp_get_async_ctx(sock)->event.super);
+}
+
+#ifdef MODULE_SOCK_DNS_CACHE
+/* returns true if the query is answered from the cache or waits for a running
+ * query for the same name, false if it needs to be sent */
+static bool _query_lookup(sock_dns_query_t *query)
+{
+    bool done = true;
+
+    mutex_lock(&_cache_lock);
+    query->leader = NULL;
+    query->waiters = NULL;
+    query->ttl = 0;
+    query->res = _cache_get(query->domain_name, query->addr_out,
+                            query->family);
+    if (query->res == 0) {
+        sock_dns_query_t *leader = _running;
+
+        while (leader && ((leader->family != query->family) ||
+                          strcmp(leader->domain_name, query->domain_name))) {
+            leader = leader->next;
+        }
+        if (leader) {
+            query->next = leader->waiters;
+            leader->waiters = query;
+            query->leader = leader;
+        }
+        else {
+            query->next = _running;
+            _running = query;
+            done = false;
+        }
+    }
+    mutex_unlock(&_cache_lock);
+    return done;
+}
+
+/* caches the result of a query that was sent and hands it to the queries
+ * waiting for it */
+static void _query_finish(sock_dns_query_t *query)
+{
+    sock_dns_query_t **prev = &_running;
+
+    mutex_lock(&_cache_lock);
+    while (*prev && (*prev != query)) {
+        prev = &(*prev)->next;
+    }
+    if (!*prev) {
+        /* was not sent */
+        mutex_unlock(&_cache_lock);
+        return;
+    }
+    *prev = query->next;
+
+    _cache_put(query->domain_name, query->addr_out, query->family,
+               query->res, query->ttl);
+    for (sock_dns_query_t *waiter = query->waiters; waiter;) {
+        sock_dns_query_t *next = waiter->next;
+
+        waiter->res = query->res;
+        if (query->res > 0) {
+            memcpy(waiter->addr_out, query->addr_out, query->res);
+        }
+        waiter->leader = NULL;
+        coro_wake(&waiter->coro);
+        waiter = next;
+    }
+    mutex_unlock(&_cache_lock);
+}
+#endif /* MODULE_SOCK_DNS_CACHE */
+
+static coro_state_t _query_coro(coro_t *coro)
+{
+    sock_dns_query_t *query = container_of(coro, sock_dns_query_t, coro);
+
+    CORO_BEGIN(coro);
+#ifdef MODULE_SOCK_DNS_CACHE
+    if (_query_lookup(query)) {
+        CORO_WAIT_UNTIL(coro, query->leader == NULL);
+        CORO_EXIT(coro);
+    }
+#endif
+    query->res = sock_udp_create(&query->sock, NULL, &sock_dns_server, 0);
+    if (query->res) {
+        CORO_EXIT(coro);
+    }
+    sock_udp_event_init(&query->sock, coro->queue, _sock_cb, coro);
+
+    for (query->retries = 0; query->retries < SOCK_DNS_RETRIES;
+         query->retries++) {
+        size_t len = _build_query(query->buf, query->id, query->domain_name,
+                                  query->family);
+
+        query->res = sock_udp_send(&query->sock, query->buf, len, NULL);
+        if (query->res <= 0) {
+            continue;
+        }
+
+        coro_set_timeout(coro, SOCK_DNS_TIMEOUT);
+        while (1) {
+            CORO_WAIT(coro);
+            do {
+                query->res = sock_udp_recv(&query->sock, query->buf,
+                                           sizeof(query->buf), 0, NULL);
+            } while ((query->res > 0) &&
+                     !_reply_matches(query->buf, query->res, query->id,
+                                     query->domain_name, query->family));
+            if (query->res != -EAGAIN) {
+                break;
+            }
+            if (coro_timed_out(coro)) {
+                query->res = -ETIMEDOUT;
+                break;
+            }
+        }
+        coro_clear_timeout(coro);
+
+        if (query->res > 0) {
+            query->res = _handle_reply(query->buf, query->res,
+                                       query->addr_out, query->family,
+                                       _query_ttl(query));
+            if (query->res > 0) {
+                break;
+            }
+#ifdef MODULE_SOCK_DNS_CACHE
+            if (_negative_reply(query->buf, query->res)) {
+                /* asking again will not help */
+                query->ttl = CONFIG_SOCK_DNS_CACHE_NEG_TTL;
+                break;
+            }
+#endif
+        }
+    }
+
+    _sock_close(&query->sock, coro->queue);
+    CORO_END(coro);
+}
+
+static void _query_done(coro_t *coro)
+{
+    sock_dns_query_t *query = container_of(coro, sock_dns_query_t, coro);
+
+#ifdef MODULE_SOCK_DNS_CACHE
+    _query_finish(query);
+#endif
+    if (query->cb) {
+        query->cb(query, query->res, query->arg);
+    }
+}
+
+static int _query_init(sock_dns_query_t *query, const char *domain_name,
+                       void *addr_out, int family)
+{
+    if (sock_dns_server.port == 0) {
+        return -ECONNREFUSED;
+    }
+
+    if (strlen(domain_name) > SOCK_DNS_MAX_NAME_LEN) {
+        return -ENOSPC;
+    }
+
+    coro_init(&query->coro, _query_coro, _query_done);
+    query->id = random_uint32();
+    query->domain_name = domain_name;
+    query->addr_out = addr_out;
+    query->family = family;
+    return 0;
+}
+
+int sock_dns_query_async(sock_dns_query_t *query, const char *domain_name,
+                         void *addr_out, int family, event_queue_t *queue,
+                         sock_dns_cb_t cb, void *arg)
+{
+    int res = _query_init(query, domain_name, addr_out, family);
+
+    if (res < 0) {
+        return res;
+    }
+    query->cb = cb;
+    query->arg = arg;
+    coro_start(&query->coro, queue);
+    return 0;
+}
+
+int sock_dns_query(const char *domain_name, void *addr_out, int family)
+{
+    /* not static: with sock_dns_cache, the query of one thread may wait for
+     * the query of another one for the same name */
+    sock_dns_query_t query;
+
+    int res = _query_init(&query, domain_name, addr_out, family);
+
+    if (res < 0) {
+        return res;
+    }
+    query.cb = NULL;
+    coro_run(&query.coro);
+    return query.res;
+}
+#else /* MODULE_SOCK_DNS_ASYNC */
 int sock_dns_query(const char *domain_name, void *addr_out, int family)
 {
     static uint8_t dns_buf[SOCK_DNS_BUF_LEN];
@@ -187,51 +695,34 @@ int sock_dns_query(const char *domain_name, void *addr_out, int family)
         goto out;
     }
 
-    uint16_t id = 0; /* random? */
-    for (int i = 0; i < SOCK_DNS_RETRIES; i++) {
-        uint8_t *buf = dns_buf;
-
-        sock_dns_hdr_t *hdr = (sock_dns_hdr_t*) buf;
-        memset(hdr, 0, sizeof(*hdr));
-        hdr->id = id;
-        hdr->flags = htons(0x0120);
-        hdr->qdcount = htons(1 + (family == AF_UNSPEC));
+    uint16_t id = random_uint32();
 
-        uint8_t *bufpos = buf + sizeof(*hdr);
+    for (int i = 0; i < SOCK_DNS_RETRIES; i++) {
+        size_t len = _build_query(dns_buf, id, domain_name, family);
 
-        unsigned _name_ptr;
-        if ((family == AF_INET6) || (family == AF_UNSPEC)) {
-            _name_ptr = (bufpos - buf);
-            bufpos += _enc_domain_name(bufpos, domain_name);
-            bufpos += _put_short(bufpos, htons(DNS_TYPE_AAAA));
-            bufpos += _put_short(bufpos, htons(DNS_CLASS_IN));
+        res = sock_udp_send(&sock_dns, dns_buf, len, NULL);
+        if (res <= 0) {
+            continue;
         }
-
-        if ((family == AF_INET) || (family == AF_UNSPEC)) {
-            if (family == AF_UNSPEC) {
-                bufpos += _put_short(bufpos, htons((0xc000) | (_name_ptr)));
+        uint32_t start = xtimer_now_usec();
+        uint32_t timeout = SOCK_DNS_TIMEOUT;
+        while ((res = sock_udp_recv(&sock_dns, dns_buf, sizeof(dns_buf),
+                                    timeout, NULL)) > 0) {
+            if (_reply_matches(dns_buf, res, id, domain_name, family)) {
+                break;
             }
-            else {
-                bufpos += _enc_domain_name(bufpos, domain_name);
+            /* wait for the reply for the rest of the timeout */
+            uint32_t elapsed = xtimer_now_usec() - start;
+            if (elapsed >= SOCK_DNS_TIMEOUT) {
+                res = -ETIMEDOUT;
+                break;
             }
-            bufpos += _put_short(bufpos, htons(DNS_TYPE_A));
-            bufpos += _put_short(bufpos, htons(DNS_CLASS_IN));
-        }
-
-        res = sock_udp_send(&sock_dns, buf, (bufpos-buf), NULL);
-        if (res <= 0) {
-            continue;
+            timeout = SOCK_DNS_TIMEOUT - elapsed;
         }
-        res = sock_udp_recv(&sock_dns, dns_buf, sizeof(dns_buf), 1000000LU, NULL);
         if (res > 0) {
-            if (res > (int)DNS_MIN_REPLY_LEN) {
-                if ((res = _parse_dns_reply(dns_buf, res, addr_out,
-                                            family)) > 0) {
-                    goto out;
-                }
-            }
-            else {
-                res = -EBADMSG;
+            if ((res = _handle_reply(dns_buf, res, addr_out, family,
+                                     NULL)) > 0) {
+                goto out;
             }
         }
     }
@@ -240,3 +731,4 @@ out:
     sock_udp_close(&sock_dns);
     return res;
 }
+#endif /* MODULE_SOCK_DNS_ASYNC */
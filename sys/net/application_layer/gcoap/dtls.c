@@ -0,0 +1,418 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     net_gcoap
+ * @{
+ *
+ * @file
+ * @brief       DTLS transport for gcoap
+ *
+ * A separate thread owns the DTLS sock: it receives and decrypts the
+ * records, runs the handshakes and encrypts the outgoing messages, so
+ * handshakes do not block the gcoap thread. Outgoing messages are queued
+ * for it, decrypted messages are handed over to the gcoap thread one at a
+ * time.
+ *
+ * _lock only protects the session table and the send queue and is never
+ * held while calling into the DTLS sock. Only the DTLS thread adds or
+ * removes sessions, so it reads the table without locking.
+ *
+ * @}
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+
+#include "mutex.h"
+#include "net/gcoap.h"
+#include "net/sock/async/event.h"
+#include "net/sock/dtls.h"
+#include "net/sock/util.h"
+#include "thread.h"
+#include "xtimer.h"
+
+#include "gcoap_internal.h"
+
+#define ENABLE_DEBUG (0)
+#include "debug.h"
+
+/* State of a session */
+enum {
+    _SESSION_FREE,
+    _SESSION_HANDSHAKE,             /* handshake started by us */
+    _SESSION_CONNECTED,
+};
+
+typedef struct _session {
+    struct _session *next;          /* next session in the hash bucket */
+    sock_dtls_session_t session;
+    uint32_t last_used;             /* time of last use or handshake start */
+    uint8_t state;
+    bool resend;                    /* requests wait for the handshake */
+} _session_t;
+
+/* Message waiting to be sent by the DTLS thread */
+typedef struct {
+    sock_udp_ep_t remote;
+    size_t len;                     /* 0 to only start a handshake */
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+} _tx_t;
+
+static sock_dtls_t _sock;
+/* protects the session table and the send queue */
+static mutex_t _lock = MUTEX_INIT;
+static _session_t _sessions[CONFIG_GCOAP_DTLS_MAX_SESSIONS];
+static _session_t *_buckets[CONFIG_GCOAP_DTLS_SESSION_BUCKETS];
+
+static _tx_t _tx[CONFIG_GCOAP_DTLS_TX_QUEUE_SIZE];
+static unsigned _tx_head;
+static unsigned _tx_count;
+
+static char _stack[GCOAP_DTLS_STACK_SIZE];
+static event_queue_t _queue;        /* of the DTLS thread */
+static event_queue_t *_gcoap_queue;
+
+/* received message, owned by the gcoap thread while _rx_event is pending */
+static uint8_t _rx_buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+static size_t _rx_len;
+static sock_dtls_session_t _rx_session;
+static mutex_t _rx_done = MUTEX_INIT_LOCKED;
+
+static void _on_tx(event_t *event);
+static void _on_rx(event_t *event);
+static void _on_connected(event_t *event);
+
+static event_t _tx_event = { .handler = _on_tx };
+static event_t _rx_event = { .handler = _on_rx };
+static event_t _connected_event = { .handler = _on_connected };
+
+static _session_t **_bucket(const sock_udp_ep_t *ep)
+{
+    const uint8_t *addr = (const uint8_t *)&ep->addr;
+    size_t addr_len = (ep->family == AF_INET6) ? 16 : 4;
+    uint32_t hash = 5381 + ep->port;
+
+    for (size_t i = 0; i < addr_len; i++) {
+        hash = (hash * 33) ^ addr[i];
+    }
+    return &_buckets[hash & (CONFIG_GCOAP_DTLS_SESSION_BUCKETS - 1)];
+}
+
+static _session_t *_session_find(const sock_udp_ep_t *ep)
+{
+    for (_session_t *s = *_bucket(ep); s; s = s->next) {
+        if (sock_udp_ep_equal(&s->session.ep, ep)) {
+            return s;
+        }
+    }
+    return NULL;
+}
+
+/* Removes a session from the table, must be called with _lock held */
+static void _session_unlink(_session_t *s)
+{
+    _session_t **prev = _bucket(&s->session.ep);
+
+    while (*prev != s) {
+        prev = &(*prev)->next;
+    }
+    *prev = s->next;
+    s->state = _SESSION_FREE;
+}
+
+/* Closes and removes a session, runs in the DTLS thread */
+static void _session_close(_session_t *s)
+{
+    sock_dtls_session_destroy(&_sock, &s->session);
+
+    mutex_lock(&_lock);
+    _session_unlink(s);
+    mutex_unlock(&_lock);
+}
+
+/* Adds a session for ep, replacing the least recently used one if full.
+ * Runs in the DTLS thread. */
+static _session_t *_session_alloc(const sock_udp_ep_t *ep, uint8_t state)
+{
+    _session_t *s = NULL;
+
+    mutex_lock(&_lock);
+    uint32_t now = xtimer_now_usec();
+    for (unsigned i = 0; i < CONFIG_GCOAP_DTLS_MAX_SESSIONS; i++) {
+        if (_sessions[i].state == _SESSION_FREE) {
+            s = &_sessions[i];
+            break;
+        }
+        if (!s || (now - _sessions[i].last_used > now - s->last_used)) {
+            s = &_sessions[i];
+        }
+    }
+    mutex_unlock(&_lock);
+
+    if (s->state != _SESSION_FREE) {
+        DEBUG("gcoap_dtls: closing least recently used session\n");
+        _session_close(s);
+    }
+
+    mutex_lock(&_lock);
+    _session_t **bucket = _bucket(ep);
+    memset(s, 0, sizeof(*s));
+    memcpy(&s->session.ep, ep, sizeof(sock_udp_ep_t));
+    s->state = state;
+    s->last_used = xtimer_now_usec();
+    s->next = *bucket;
+    *bucket = s;
+    mutex_unlock(&_lock);
+    return s;
+}
+
+/* Marks a session as established, must be called with _lock held */
+static void _session_established(_session_t *s,
+                                 const sock_dtls_session_t *session)
+{
+    if (s->state == _SESSION_HANDSHAKE) {
+        s->resend = true;
+        event_post(_gcoap_queue, &_connected_event);
+    }
+    memcpy(&s->session, session, sizeof(*session));
+    s->state = _SESSION_CONNECTED;
+    s->last_used = xtimer_now_usec();
+}
+
+/* Starts a handshake with ep, runs in the DTLS thread */
+static void _session_start(const sock_udp_ep_t *ep)
+{
+    sock_dtls_session_t session;
+    _session_t *s = _session_alloc(ep, _SESSION_HANDSHAKE);
+    int res = sock_dtls_session_init(&_sock, ep, &session);
+
+    mutex_lock(&_lock);
+    if (res < 0) {
+        DEBUG("gcoap_dtls: unable to start handshake: %d\n", res);
+        _session_unlink(s);
+    }
+    else if (res == 0) {
+        /* the DTLS stack still has an established session */
+        _session_established(s, &session);
+    }
+    else {
+        memcpy(&s->session, &session, sizeof(session));
+    }
+    mutex_unlock(&_lock);
+}
+
+/* Marks the session of a received record as established, runs in the DTLS
+ * thread */
+static void _session_connected(const sock_dtls_session_t *session)
+{
+    _session_t *s = _session_find(&session->ep);
+
+    if (!s) {
+        /* a client connected to us */
+        s = _session_alloc(&session->ep, _SESSION_CONNECTED);
+    }
+    mutex_lock(&_lock);
+    _session_established(s, session);
+    mutex_unlock(&_lock);
+}
+
+/* Runs in the DTLS thread */
+static void _send(const _tx_t *tx)
+{
+    _session_t *s = _session_find(&tx->remote);
+
+    /* last_used is also updated by the senders */
+    mutex_lock(&_lock);
+    bool expired = s && (s->state == _SESSION_HANDSHAKE) &&
+                   (xtimer_now_usec() - s->last_used >
+                    CONFIG_GCOAP_DTLS_HANDSHAKE_TIMEOUT_USEC);
+    mutex_unlock(&_lock);
+
+    if (expired) {
+        DEBUG("gcoap_dtls: restarting handshake\n");
+        _session_close(s);
+        s = NULL;
+    }
+    if (!s) {
+        /* a message of a session closed meanwhile is dropped, confirmable
+         * requests are resent once the handshake completed */
+        _session_start(&tx->remote);
+        return;
+    }
+    if ((s->state != _SESSION_CONNECTED) || (tx->len == 0)) {
+        return;
+    }
+
+    ssize_t res = sock_dtls_send(&_sock, &s->session, tx->buf, tx->len);
+    if (res < 0) {
+        DEBUG("gcoap_dtls: send failure: %d\n", (int)res);
+    }
+}
+
+/* Runs in the DTLS thread */
+static void _on_tx(event_t *event)
+{
+    (void)event;
+
+    while (1) {
+        /* producers only write behind the queued messages */
+        mutex_lock(&_lock);
+        const _tx_t *tx = _tx_count ? &_tx[_tx_head] : NULL;
+        mutex_unlock(&_lock);
+        if (!tx) {
+            return;
+        }
+
+        _send(tx);
+
+        mutex_lock(&_lock);
+        _tx_head = (_tx_head + 1) % CONFIG_GCOAP_DTLS_TX_QUEUE_SIZE;
+        _tx_count--;
+        mutex_unlock(&_lock);
+    }
+}
+
+/* Runs in the DTLS thread */
+static void _on_dtls_evt(sock_dtls_t *sock, sock_async_flags_t type,
+                         void *arg)
+{
+    (void)sock;
+    (void)arg;
+    if (!(type & SOCK_ASYNC_MSG_RECV)) {
+        return;
+    }
+
+    while (1) {
+        ssize_t res = sock_dtls_recv(&_sock, &_rx_session, _rx_buf,
+                                     sizeof(_rx_buf), 0);
+        if ((res > 0) || (res == -SOCK_DTLS_HANDSHAKE)) {
+            _session_connected(&_rx_session);
+        }
+
+        if (res > 0) {
+            /* wait until the gcoap thread handled the message */
+            _rx_len = res;
+            event_post(_gcoap_queue, &_rx_event);
+            mutex_lock(&_rx_done);
+        }
+        else if ((res != -ETIMEDOUT) && (res != -SOCK_DTLS_HANDSHAKE)) {
+            /* -ETIMEDOUT: record without data, e.g. of a handshake */
+            if (res != -EAGAIN) {
+                DEBUG("gcoap_dtls: recv failure: %d\n", (int)res);
+            }
+            return;
+        }
+    }
+}
+
+/* Runs in the gcoap thread */
+static void _on_rx(event_t *event)
+{
+    (void)event;
+    gcoap_handle_msg(_rx_buf, sizeof(_rx_buf), _rx_len, &_rx_session.ep);
+    mutex_unlock(&_rx_done);
+}
+
+/* Runs in the gcoap thread */
+static void _on_connected(event_t *event)
+{
+    (void)event;
+    for (unsigned i = 0; i < CONFIG_GCOAP_DTLS_MAX_SESSIONS; i++) {
+        sock_udp_ep_t remote;
+
+        mutex_lock(&_lock);
+        bool resend = _sessions[i].resend &&
+                      (_sessions[i].state == _SESSION_CONNECTED);
+        _sessions[i].resend = false;
+        memcpy(&remote, &_sessions[i].session.ep, sizeof(remote));
+        mutex_unlock(&_lock);
+
+        if (resend) {
+            DEBUG("gcoap_dtls: handshake done, sending requests\n");
+            gcoap_resend_pending(&remote);
+        }
+    }
+}
+
+static void *_dtls_thread(void *arg)
+{
+    (void)arg;
+
+    event_queue_claim(&_queue);
+    sock_dtls_event_init(&_sock, &_queue, _on_dtls_evt, NULL);
+    event_loop(&_queue);
+
+    return NULL;
+}
+
+int gcoap_dtls_init(sock_udp_t *udp, event_queue_t *queue)
+{
+    /* also acts as client, tinydtls does not distinguish */
+    if (sock_dtls_create(&_sock, udp, CONFIG_GCOAP_DTLS_CREDENTIAL_TAG,
+                         SOCK_DTLS_1_2, SOCK_DTLS_SERVER) < 0) {
+        return -EINVAL;
+    }
+    _gcoap_queue = queue;
+    /* messages may be queued before the thread runs */
+    event_queue_init_detached(&_queue);
+
+    kernel_pid_t pid = thread_create(_stack, sizeof(_stack), GCOAP_DTLS_PRIO,
+                                     THREAD_CREATE_STACKTEST, _dtls_thread,
+                                     NULL, "coap dtls");
+    if (pid < 0) {
+        sock_dtls_close(&_sock);
+        return pid;
+    }
+    return 0;
+}
+
+ssize_t gcoap_dtls_send(const uint8_t *buf, size_t len,
+                        const sock_udp_ep_t *remote)
+{
+    assert(len <= sizeof(_tx[0].buf));
+
+    uint32_t now = xtimer_now_usec();
+    ssize_t res = len;
+
+    mutex_lock(&_lock);
+    _session_t *s = _session_find(remote);
+    bool connected = s && (s->state == _SESSION_CONNECTED);
+    if (s && !connected &&
+        (now - s->last_used <= CONFIG_GCOAP_DTLS_HANDSHAKE_TIMEOUT_USEC)) {
+        res = -EINPROGRESS;
+        goto out;
+    }
+    if (_tx_count == CONFIG_GCOAP_DTLS_TX_QUEUE_SIZE) {
+        res = -ENOBUFS;
+        goto out;
+    }
+
+    _tx_t *tx = &_tx[(_tx_head + _tx_count) % CONFIG_GCOAP_DTLS_TX_QUEUE_SIZE];
+    _tx_count++;
+    memcpy(&tx->remote, remote, sizeof(*remote));
+    if (connected) {
+        memcpy(tx->buf, buf, len);
+        tx->len = len;
+        s->last_used = now;
+    }
+    else {
+        /* (re)start the handshake, the message is not sent */
+        tx->len = 0;
+        res = -EINPROGRESS;
+    }
+    mutex_unlock(&_lock);
+
+    event_post(&_queue, &_tx_event);
+    return res;
+
+out:
+    mutex_unlock(&_lock);
+    return res;
+}
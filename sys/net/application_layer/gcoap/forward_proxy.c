@@ -0,0 +1,324 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     net_gcoap_forward_proxy
+ * @{
+ *
+ * @file
+ * @brief       Forward proxy implementation for gcoap
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <strings.h>
+
+#include "net/gcoap_forward_proxy.h"
+#include "net/nanocoap_cache.h"
+#include "net/sock/util.h"
+#include "gcoap_internal.h"
+
+#define ENABLE_DEBUG (0)
+#include "debug.h"
+
+/* A request forwarded on behalf of a client */
+typedef struct {
+    bool in_use;
+    sock_udp_ep_t client;                   /* Client endpoint */
+    uint8_t token[COAP_TOKEN_LENGTH_MAX];   /* Client token */
+    uint8_t token_len;
+    uint8_t method;                         /* Request method */
+    bool validating;                        /* Proxy asks to validate a stale
+                                               cache entry */
+    uint8_t cache_key[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+    uint8_t uri_key[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+} _client_t;
+
+/* Options added to the forwarded request */
+typedef struct {
+    const uint8_t *etag;
+    size_t etag_len;
+    const char *path;
+    size_t path_len;
+    const char *query;
+    size_t query_len;
+    unsigned next;                          /* Lowest option number not yet
+                                               added */
+} _own_opts_t;
+
+static _client_t _clients[CONFIG_GCOAP_FORWARD_PROXY_CLIENTS];
+
+/* Only used from the gcoap thread */
+static uint8_t _buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+static char _uri[CONFIG_SOCK_SCHEME_MAXLEN + CONFIG_SOCK_HOSTPORT_MAXLEN +
+                 CONFIG_SOCK_URLPATH_MAXLEN];
+static char _hostport[CONFIG_SOCK_HOSTPORT_MAXLEN];
+static char _urlpath[CONFIG_SOCK_URLPATH_MAXLEN];
+
+void gcoap_forward_proxy_init(void)
+{
+    memset(_clients, 0, sizeof(_clients));
+}
+
+static _client_t *_client_alloc(void)
+{
+    for (unsigned i = 0; i < CONFIG_GCOAP_FORWARD_PROXY_CLIENTS; i++) {
+        if (!_clients[i].in_use) {
+            _clients[i].in_use = true;
+            return &_clients[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Length of a received PDU; the end of the options is only known from
+ * iterating them if there is no payload.
+ */
+static size_t _pdu_len(coap_pkt_t *pdu)
+{
+    if (pdu->payload_len) {
+        return pdu->payload + pdu->payload_len - (uint8_t *)pdu->hdr;
+    }
+
+    coap_optpos_t opt = { 0, 0 };
+    uint8_t *value;
+    size_t len = coap_get_total_hdr_len(pdu);
+    for (bool init = true; coap_opt_get_next(pdu, &opt, &value, init) >= 0;
+         init = false) {
+        len = opt.offset;
+    }
+    return len;
+}
+
+/*
+ * Splits the Proxy-Uri into origin endpoint, path and query. Only the coap
+ * scheme and IP address literals are supported.
+ */
+static int _parse_proxy_uri(coap_pkt_t *pdu, sock_udp_ep_t *origin,
+                            _own_opts_t *own)
+{
+    uint8_t *value;
+    ssize_t len = coap_opt_get_opaque(pdu, COAP_OPT_PROXY_URI, &value);
+
+    if ((len < 0) || ((size_t)len >= sizeof(_uri))) {
+        return COAP_CODE_BAD_OPTION;
+    }
+    memcpy(_uri, value, len);
+    _uri[len] = '\0';
+
+    if (strncasecmp(_uri, "coap://", 7)) {
+        return COAP_CODE_PROXYING_NOT_SUPPORTED;
+    }
+    if ((sock_urlsplit(_uri, _hostport, _urlpath) < 0) ||
+        (sock_udp_str2ep(origin, _hostport) < 0)) {
+        return COAP_CODE_BAD_GATEWAY;
+    }
+    if (origin->port == 0) {
+        origin->port = COAP_PORT;
+    }
+
+    char *query = strchr(_urlpath, '?');
+    own->path = _urlpath;
+    own->path_len = (query) ? (size_t)(query - _urlpath) : strlen(_urlpath);
+    own->query = (query) ? query + 1 : NULL;
+    own->query_len = (query) ? strlen(query + 1) : 0;
+    return 0;
+}
+
+/* Adds the options generated by the proxy with a number below limit */
+static int _add_own_opts(coap_pkt_t *fwd, _own_opts_t *own, unsigned limit)
+{
+    if ((own->next <= COAP_OPT_ETAG) && (limit > COAP_OPT_ETAG)) {
+        if (own->etag_len &&
+            (coap_opt_add_opaque(fwd, COAP_OPT_ETAG, own->etag, own->etag_len) < 0)) {
+            return -ENOSPC;
+        }
+        own->next = COAP_OPT_ETAG + 1;
+    }
+    if ((own->next <= COAP_OPT_URI_PATH) && (limit > COAP_OPT_URI_PATH)) {
+        if (coap_opt_add_chars(fwd, COAP_OPT_URI_PATH, own->path,
+                               own->path_len, '/') < 0) {
+            return -ENOSPC;
+        }
+        own->next = COAP_OPT_URI_PATH + 1;
+    }
+    if ((own->next <= COAP_OPT_URI_QUERY) && (limit > COAP_OPT_URI_QUERY)) {
+        if (coap_opt_add_chars(fwd, COAP_OPT_URI_QUERY, own->query,
+                               own->query_len, '&') < 0) {
+            return -ENOSPC;
+        }
+        own->next = COAP_OPT_URI_QUERY + 1;
+    }
+    return 0;
+}
+
+/* Builds the request to the origin server in _buf */
+static ssize_t _build_request(coap_pkt_t *pdu, _own_opts_t *own)
+{
+    coap_pkt_t fwd;
+
+    gcoap_req_init(&fwd, _buf, sizeof(_buf), pdu->hdr->code, NULL);
+    coap_hdr_set_type(fwd.hdr, coap_get_type(pdu));
+
+    coap_optpos_t opt = { 0, 0 };
+    uint8_t *value;
+    ssize_t optlen;
+    for (bool init = true; (optlen = coap_opt_get_next(pdu, &opt, &value, init)) >= 0;
+         init = false) {
+        switch (opt.opt_num) {
+        case COAP_OPT_URI_HOST:
+        case COAP_OPT_URI_PORT:
+        case COAP_OPT_URI_PATH:
+        case COAP_OPT_URI_QUERY:
+        case COAP_OPT_PROXY_URI:
+        case COAP_OPT_PROXY_SCHEME:
+            continue;
+        }
+        if ((_add_own_opts(&fwd, own, opt.opt_num) < 0) ||
+            (coap_opt_add_opaque(&fwd, opt.opt_num, value, optlen) < 0)) {
+            return -ENOSPC;
+        }
+    }
+    if (_add_own_opts(&fwd, own, UINT16_MAX) < 0) {
+        return -ENOSPC;
+    }
+
+    if (pdu->payload_len == 0) {
+        return coap_opt_finish(&fwd, COAP_OPT_FINISH_NONE);
+    }
+    ssize_t len = coap_opt_finish(&fwd, COAP_OPT_FINISH_PAYLOAD);
+    if ((len < 0) || (fwd.payload_len < pdu->payload_len)) {
+        return -ENOSPC;
+    }
+    memcpy(fwd.payload, pdu->payload, pdu->payload_len);
+    return len + pdu->payload_len;
+}
+
+/* Builds the response of the origin server for the client in _buf */
+static ssize_t _build_response(const _client_t *cl, coap_pkt_t *pdu)
+{
+    size_t hdr_len = coap_get_total_hdr_len(pdu);
+    size_t len = _pdu_len(pdu) - hdr_len;
+    ssize_t res = coap_build_hdr((coap_hdr_t *)_buf, COAP_TYPE_NON,
+                                 (uint8_t *)cl->token, cl->token_len,
+                                 pdu->hdr->code, gcoap_next_msg_id());
+
+    if (res + len > sizeof(_buf)) {
+        return -ENOSPC;
+    }
+    memcpy(_buf + res, (uint8_t *)pdu->hdr + hdr_len, len);
+    return res + len;
+}
+
+static void _forward_resp_handler(const gcoap_request_memo_t *memo,
+                                  coap_pkt_t *pdu, const sock_udp_ep_t *remote)
+{
+    _client_t *cl = memo->context;
+    ssize_t len;
+
+    (void)remote;
+    if (memo->state == GCOAP_MEMO_RESP) {
+        bool fresh = nanocoap_cache_process(cl->cache_key, cl->uri_key,
+                                            cl->method, pdu,
+                                            _pdu_len(pdu)) == 0;
+        if (cl->validating && fresh &&
+            (coap_get_code_raw(pdu) == COAP_CODE_VALID)) {
+            /* the client asked for the representation, not for validation */
+            len = nanocoap_cache_build_pdu(nanocoap_cache_key_lookup(cl->cache_key),
+                                           COAP_TYPE_NON, gcoap_next_msg_id(),
+                                           cl->token, cl->token_len, false,
+                                           _buf, sizeof(_buf));
+        }
+        else {
+            len = _build_response(cl, pdu);
+        }
+    }
+    else {
+        len = coap_build_hdr((coap_hdr_t *)_buf, COAP_TYPE_NON, cl->token,
+                             cl->token_len, COAP_CODE_GATEWAY_TIMEOUT,
+                             gcoap_next_msg_id());
+    }
+
+    if (len > 0) {
+        gcoap_dispatch(_buf, len, &cl->client);
+    }
+    else {
+        DEBUG("gcoap_forward_proxy: response too long: %d\n", (int)len);
+    }
+    cl->in_use = false;
+}
+
+ssize_t gcoap_forward_proxy_request_process(coap_pkt_t *pdu, uint8_t *buf,
+                                            size_t len,
+                                            const sock_udp_ep_t *client)
+{
+    _own_opts_t own = { .next = 0 };
+    sock_udp_ep_t origin;
+    uint8_t cache_key[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+    uint8_t uri_key[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+    unsigned method = pdu->hdr->code;
+    bool validating = false;
+
+    int code = _parse_proxy_uri(pdu, &origin, &own);
+    if (code) {
+        return gcoap_response(pdu, buf, len, code);
+    }
+
+    nanocoap_cache_key_generate(pdu, cache_key);
+    nanocoap_cache_uri_key_generate(pdu, uri_key);
+    nanocoap_cache_entry_t *ce = nanocoap_cache_key_lookup(cache_key);
+    if (ce && (ce->request_method == method) && !coap_has_observe(pdu)) {
+        if (!nanocoap_cache_entry_is_stale(ce, nanocoap_cache_now())) {
+            DEBUG("gcoap_forward_proxy: answering from cache\n");
+            ssize_t res = nanocoap_cache_build_reply(ce, pdu, buf, len);
+            if (res > 0) {
+                return res;
+            }
+        }
+        else if (ce->etag_len &&
+                 (coap_opt_get_opaque(pdu, COAP_OPT_ETAG, &(uint8_t *){ NULL }) < 0)) {
+            own.etag = ce->etag;
+            own.etag_len = ce->etag_len;
+            validating = true;
+        }
+    }
+
+    _client_t *cl = _client_alloc();
+    if (cl == NULL) {
+        return gcoap_response(pdu, buf, len, COAP_CODE_SERVICE_UNAVAILABLE);
+    }
+    memcpy(&cl->client, client, sizeof(sock_udp_ep_t));
+    cl->token_len = coap_get_token_len(pdu);
+    if (cl->token_len > sizeof(cl->token)) {
+        cl->in_use = false;
+        return gcoap_response(pdu, buf, len, COAP_CODE_BAD_REQUEST);
+    }
+    memcpy(cl->token, pdu->token, cl->token_len);
+    cl->method = method;
+    cl->validating = validating;
+    memcpy(cl->cache_key, cache_key, sizeof(cache_key));
+    memcpy(cl->uri_key, uri_key, sizeof(uri_key));
+
+    ssize_t fwd_len = _build_request(pdu, &own);
+    if ((fwd_len <= 0) ||
+        !gcoap_req_send(_buf, fwd_len, &origin, _forward_resp_handler, cl)) {
+        DEBUG("gcoap_forward_proxy: can't forward request: %d\n", (int)fwd_len);
+        cl->in_use = false;
+        return gcoap_response(pdu, buf, len, COAP_CODE_SERVICE_UNAVAILABLE);
+    }
+
+    if (coap_get_type(pdu) == COAP_TYPE_CON) {
+        /* the response follows separately */
+        return coap_build_hdr((coap_hdr_t *)buf, COAP_TYPE_ACK, NULL, 0,
+                              COAP_CODE_EMPTY, coap_get_id(pdu));
+    }
+    return 0;
+}
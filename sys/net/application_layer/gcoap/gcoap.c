@@ -26,13 +26,22 @@
 #include <string.h>
 
 #include "assert.h"
+#include "memarray.h"
 #include "net/gcoap.h"
+#ifdef MODULE_GCOAP_FORWARD_PROXY
+#include "net/gcoap_forward_proxy.h"
+#endif
+#ifdef MODULE_NANOCOAP_CACHE
+#include "net/nanocoap_cache.h"
+#endif
 #include "net/sock/async/event.h"
 #include "net/sock/util.h"
 #include "mutex.h"
 #include "random.h"
 #include "thread.h"
 
+#include "gcoap_internal.h"
+
 #define ENABLE_DEBUG (0)
 #include "debug.h"
 
@@ -46,20 +55,37 @@
 
 /* Internal functions */
 static void *_event_loop(void *arg);
+#ifndef MODULE_GCOAP_DTLS
 static void _on_sock_evt(sock_udp_t *sock, sock_async_flags_t type, void *arg);
+#endif
+static ssize_t _tl_send(const uint8_t *buf, size_t len,
+                        const sock_udp_ep_t *remote);
 static ssize_t _well_known_core_handler(coap_pkt_t* pdu, uint8_t *buf, size_t len, void *ctx);
 static size_t _handle_req(coap_pkt_t *pdu, uint8_t *buf, size_t len,
                                                          sock_udp_ep_t *remote);
 static void _expire_request(gcoap_request_memo_t *memo);
+#ifdef MODULE_NANOCOAP_CACHE
+static void _cache_response(const uint8_t *cache_key, const uint8_t *uri_key,
+                            unsigned method, uint8_t *buf, size_t len);
+#endif
+static void _release_req_memo(gcoap_request_memo_t *memo);
 static void _find_req_memo(gcoap_request_memo_t **memo_ptr, coap_pkt_t *pdu,
                            const sock_udp_ep_t *remote);
 static int _find_resource(coap_pkt_t *pdu, const coap_resource_t **resource_ptr,
                                             gcoap_listener_t **listener_ptr);
-static int _find_observer(sock_udp_ep_t **observer, sock_udp_ep_t *remote);
-static int _find_obs_memo(gcoap_observe_memo_t **memo, sock_udp_ep_t *remote,
-                                                       coap_pkt_t *pdu);
-static void _find_obs_memo_resource(gcoap_observe_memo_t **memo,
-                                   const coap_resource_t *resource);
+static gcoap_observe_memo_t *_find_obs_memo(const sock_udp_ep_t *remote,
+                                            const uint8_t *token,
+                                            unsigned token_len);
+static gcoap_observe_memo_t *_find_obs_memo_remote(const coap_resource_t *resource,
+                                                   const sock_udp_ep_t *remote);
+static gcoap_observe_memo_t *_obs_register(const coap_resource_t *resource,
+                                           const sock_udp_ep_t *remote,
+                                           const coap_pkt_t *pdu);
+static void _obs_deregister(gcoap_observe_memo_t *memo);
+static void _obs_hash(gcoap_observe_memo_t *memo);
+static void _obs_unhash(gcoap_observe_memo_t *memo);
+static void _obs_set_token(gcoap_observe_memo_t *memo, const coap_pkt_t *pdu);
+static void _on_obs_notify(void *arg);
 
 /* Internal variables */
 const coap_resource_t _default_resources[] = {
@@ -73,24 +99,61 @@ static gcoap_listener_t _default_listener = {
     NULL
 };
 
+/* Observed resource, with the list of its observers */
+typedef struct {
+    const coap_resource_t *resource;    /* Observed resource; unused if NULL */
+    gcoap_observe_memo_t *observers;    /* Registrations for the resource */
+    uint32_t last_notify;               /* Time of the last notification
+                                           generated by gcoap, in usec */
+    bool pending;                       /* Notification is scheduled */
+    event_timeout_t notify_tmout;       /* Delays coalesced notifications */
+    event_callback_t notify_cb;         /* Generates the notification */
+} gcoap_obs_resource_t;
+
+#ifdef MODULE_GCOAP_COCOA
+/* Retransmission timeout state for a peer, see draft-ietf-core-cocoa */
+typedef struct {
+    sock_udp_ep_t remote;               /* Peer; unused if family AF_UNSPEC */
+    uint32_t rto;                       /* Overall RTO, in usec */
+    uint32_t updated;                   /* Time of the last RTO update */
+    uint32_t srtt[2];                   /* Smoothed RTT of strong and weak
+                                           estimator; 0 if no sample yet */
+    uint32_t rttvar[2];                 /* RTT variation of both estimators */
+} gcoap_cocoa_peer_t;
+
+#define COCOA_STRONG        (0)
+#define COCOA_WEAK          (1)
+#define COCOA_RTO_INIT      ((uint32_t)CONFIG_COAP_ACK_TIMEOUT * US_PER_SEC)
+#define COCOA_RTO_MAX       (32U * US_PER_SEC)
+#endif
+
 /* Container for the state of gcoap itself */
 typedef struct {
     mutex_t lock;                       /* Shares state attributes safely */
     gcoap_listener_t *listeners;        /* List of registered listeners */
     gcoap_request_memo_t open_reqs[CONFIG_GCOAP_REQ_WAITING_MAX];
-                                        /* Storage for open requests; if first
-                                           byte of an entry is zero, the entry
-                                           is available */
+                                        /* Storage for open requests */
+    memarray_t req_pool;                /* Allocates from open_reqs */
+    gcoap_request_memo_t *req_buckets[CONFIG_GCOAP_REQ_HASH_BUCKETS];
+                                        /* Open requests by remote and token */
     atomic_uint next_message_id;        /* Next message ID to use */
-    sock_udp_ep_t observers[CONFIG_GCOAP_OBS_CLIENTS_MAX];
-                                        /* Observe clients; allows reuse for
-                                           observe memos */
     gcoap_observe_memo_t observe_memos[CONFIG_GCOAP_OBS_REGISTRATIONS_MAX];
-                                        /* Observed resource registrations */
-    uint8_t resend_bufs[CONFIG_GCOAP_RESEND_BUFS_MAX][CONFIG_GCOAP_PDU_BUF_SIZE];
+                                        /* Storage for observe registrations */
+    memarray_t observe_pool;            /* Allocates from observe_memos */
+    gcoap_observe_memo_t *observe_buckets[CONFIG_GCOAP_OBS_HASH_BUCKETS];
+                                        /* Registrations by endpoint and token */
+    gcoap_obs_resource_t observed[CONFIG_GCOAP_OBS_RESOURCES_MAX];
+                                        /* Resources with observers */
+    uintptr_t resend_bufs[CONFIG_GCOAP_RESEND_BUFS_MAX]
+                         [(CONFIG_GCOAP_PDU_BUF_SIZE + sizeof(uintptr_t) - 1)
+                          / sizeof(uintptr_t)];
                                         /* Buffers for PDU for request resends;
-                                           if first byte of an entry is zero,
-                                           the entry is available */
+                                           word sized to hold the free list */
+    memarray_t resend_pool;             /* Allocates from resend_bufs */
+#ifdef MODULE_GCOAP_COCOA
+    gcoap_cocoa_peer_t peers[CONFIG_GCOAP_COCOA_PEERS];
+                                        /* RTO state by hash of the peer */
+#endif
 } gcoap_state_t;
 
 static gcoap_state_t _coap_state = {
@@ -112,7 +175,11 @@ static void *_event_loop(void *arg)
     memset(&local, 0, sizeof(sock_udp_ep_t));
     local.family = AF_INET6;
     local.netif  = SOCK_ADDR_ANY_NETIF;
+#ifdef MODULE_GCOAP_DTLS
+    local.port   = CONFIG_GCOAPS_PORT;
+#else
     local.port   = CONFIG_GCOAP_PORT;
+#endif
 
     int res = sock_udp_create(&_sock, &local, NULL, 0);
     if (res < 0) {
@@ -121,18 +188,27 @@ static void *_event_loop(void *arg)
     }
 
     event_queue_init(&_queue);
+#ifdef MODULE_GCOAP_DTLS
+    /* the DTLS thread receives on _sock */
+    res = gcoap_dtls_init(&_sock, &_queue);
+    if (res < 0) {
+        DEBUG("gcoap: cannot create DTLS sock: %d\n", res);
+        sock_udp_close(&_sock);
+        return 0;
+    }
+#else
     sock_udp_event_init(&_sock, &_queue, _on_sock_evt, NULL);
+#endif
     event_loop(&_queue);
 
     return 0;
 }
 
+#ifndef MODULE_GCOAP_DTLS
 /* Handles sock events from the event queue. */
 static void _on_sock_evt(sock_udp_t *sock, sock_async_flags_t type, void *arg)
 {
-    coap_pkt_t pdu;
     sock_udp_ep_t remote;
-    gcoap_request_memo_t *memo = NULL;
 
     (void)arg;
     if (type & SOCK_ASYNC_MSG_RECV) {
@@ -142,94 +218,117 @@ static void _on_sock_evt(sock_udp_t *sock, sock_async_flags_t type, void *arg)
             DEBUG("gcoap: udp recv failure: %d\n", (int)res);
             return;
         }
+        gcoap_handle_msg(_listen_buf, sizeof(_listen_buf), res, &remote);
+    }
+}
+#endif
 
-        res = coap_parse(&pdu, _listen_buf, res);
-        if (res < 0) {
-            DEBUG("gcoap: parse failure: %d\n", (int)res);
-            /* If a response, can't clear memo, but it will timeout later. */
-            return;
-        }
+/* Sends a message via the transport of gcoap. */
+static ssize_t _tl_send(const uint8_t *buf, size_t len,
+                        const sock_udp_ep_t *remote)
+{
+#ifdef MODULE_GCOAP_DTLS
+    return gcoap_dtls_send(buf, len, remote);
+#else
+    return sock_udp_send(&_sock, buf, len, remote);
+#endif
+}
 
-        /* validate class and type for incoming */
-        switch (coap_get_code_class(&pdu)) {
-        /* incoming request or empty */
-        case COAP_CLASS_REQ:
-            if (coap_get_code_raw(&pdu) == COAP_CODE_EMPTY) {
-                /* ping request */
-                if (coap_get_type(&pdu) == COAP_TYPE_CON) {
-                    coap_hdr_set_type(pdu.hdr, COAP_TYPE_RST);
-
-                    ssize_t bytes = sock_udp_send(sock, _listen_buf,
-                                                  sizeof(coap_hdr_t), &remote);
-                    if (bytes <= 0) {
-                        DEBUG("gcoap: ping response failed: %d\n", (int)bytes);
-                    }
-                } else if (coap_get_type(&pdu) == COAP_TYPE_NON) {
-                    DEBUG("gcoap: empty NON msg\n");
-                }
-                else {
-                    goto empty_as_response;
-                }
-            }
-            /* normal request */
-            else if (coap_get_type(&pdu) == COAP_TYPE_NON
-                    || coap_get_type(&pdu) == COAP_TYPE_CON) {
-                size_t pdu_len = _handle_req(&pdu, _listen_buf, sizeof(_listen_buf),
-                                             &remote);
-                if (pdu_len > 0) {
-                    ssize_t bytes = sock_udp_send(sock, _listen_buf, pdu_len,
-                                                  &remote);
-                    if (bytes <= 0) {
-                        DEBUG("gcoap: send response failed: %d\n", (int)bytes);
-                    }
+void gcoap_handle_msg(uint8_t *buf, size_t size, size_t len,
+                      sock_udp_ep_t *remote)
+{
+    coap_pkt_t pdu;
+    gcoap_request_memo_t *memo = NULL;
+
+    ssize_t res = coap_parse(&pdu, buf, len);
+    if (res < 0) {
+        DEBUG("gcoap: parse failure: %d\n", (int)res);
+        /* If a response, can't clear memo, but it will timeout later. */
+        return;
+    }
+
+    /* validate class and type for incoming */
+    switch (coap_get_code_class(&pdu)) {
+    /* incoming request or empty */
+    case COAP_CLASS_REQ:
+        if (coap_get_code_raw(&pdu) == COAP_CODE_EMPTY) {
+            /* ping request */
+            if (coap_get_type(&pdu) == COAP_TYPE_CON) {
+                coap_hdr_set_type(pdu.hdr, COAP_TYPE_RST);
+
+                ssize_t bytes = _tl_send(buf, sizeof(coap_hdr_t), remote);
+                if (bytes <= 0) {
+                    DEBUG("gcoap: ping response failed: %d\n", (int)bytes);
                 }
+            } else if (coap_get_type(&pdu) == COAP_TYPE_NON) {
+                DEBUG("gcoap: empty NON msg\n");
             }
             else {
-                DEBUG("gcoap: illegal request type: %u\n", coap_get_type(&pdu));
+                goto empty_as_response;
             }
-            break;
+        }
+        /* normal request */
+        else if (coap_get_type(&pdu) == COAP_TYPE_NON
+                || coap_get_type(&pdu) == COAP_TYPE_CON) {
+            size_t pdu_len = _handle_req(&pdu, buf, size, remote);
+            if (pdu_len > 0) {
+                ssize_t bytes = _tl_send(buf, pdu_len, remote);
+                if (bytes <= 0) {
+                    DEBUG("gcoap: send response failed: %d\n", (int)bytes);
+                }
+            }
+        }
+        else {
+            DEBUG("gcoap: illegal request type: %u\n", coap_get_type(&pdu));
+        }
+        break;
 
 empty_as_response:
-            DEBUG("gcoap: empty ack/reset not handled yet\n");
-            return;
+        DEBUG("gcoap: empty ack/reset not handled yet\n");
+        return;
 
-        /* incoming response */
-        case COAP_CLASS_SUCCESS:
-        case COAP_CLASS_CLIENT_FAILURE:
-        case COAP_CLASS_SERVER_FAILURE:
-            _find_req_memo(&memo, &pdu, &remote);
-            if (memo) {
-                switch (coap_get_type(&pdu)) {
-                case COAP_TYPE_NON:
-                case COAP_TYPE_ACK:
-                    if (memo->resp_evt_tmout.queue) {
-                        event_timeout_clear(&memo->resp_evt_tmout);
-                    }
-                    memo->state = GCOAP_MEMO_RESP;
-                    if (memo->resp_handler) {
-                        memo->resp_handler(memo, &pdu, &remote);
-                    }
-
-                    if (memo->send_limit >= 0) {        /* if confirmable */
-                        *memo->msg.data.pdu_buf = 0;    /* clear resend PDU buffer */
-                    }
-                    memo->state = GCOAP_MEMO_UNUSED;
-                    break;
-                case COAP_TYPE_CON:
-                    DEBUG("gcoap: separate CON response not handled yet\n");
-                    break;
-                default:
-                    DEBUG("gcoap: illegal response type: %u\n", coap_get_type(&pdu));
-                    break;
+    /* incoming response */
+    case COAP_CLASS_SUCCESS:
+    case COAP_CLASS_CLIENT_FAILURE:
+    case COAP_CLASS_SERVER_FAILURE:
+        mutex_lock(&_coap_state.lock);
+        _find_req_memo(&memo, &pdu, remote);
+        mutex_unlock(&_coap_state.lock);
+        if (memo) {
+            switch (coap_get_type(&pdu)) {
+            case COAP_TYPE_NON:
+            case COAP_TYPE_ACK:
+                if (memo->resp_evt_tmout.queue) {
+                    event_timeout_clear(&memo->resp_evt_tmout);
                 }
+                memo->state = GCOAP_MEMO_RESP;
+#ifdef MODULE_GCOAP_COCOA
+                if (memo->send_limit >= 0) {        /* if confirmable */
+                    uint32_t now = xtimer_now_usec();
+                    gcoap_cocoa_update(&memo->remote_ep, now - memo->send_time,
+                                       CONFIG_COAP_MAX_RETRANSMIT - memo->send_limit,
+                                       now);
+                }
+#endif
+                if (memo->resp_handler) {
+                    memo->resp_handler(memo, &pdu, remote);
+                }
+                _release_req_memo(memo);
+                break;
+            case COAP_TYPE_CON:
+                DEBUG("gcoap: separate CON response not handled yet\n");
+                break;
+            default:
+                DEBUG("gcoap: illegal response type: %u\n", coap_get_type(&pdu));
+                break;
             }
-            else {
-                DEBUG("gcoap: msg not found for ID: %u\n", coap_get_id(&pdu));
-            }
-            break;
-        default:
-            DEBUG("gcoap: illegal code class: %u\n", coap_get_code_class(&pdu));
         }
+        else {
+            DEBUG("gcoap: msg not found for ID: %u\n", coap_get_id(&pdu));
+        }
+        break;
+    default:
+        DEBUG("gcoap: illegal code class: %u\n", coap_get_code_class(&pdu));
     }
 }
 
@@ -241,9 +340,13 @@ static void _on_resp_timeout(void *arg) {
     if ((memo->send_limit == GCOAP_SEND_LIMIT_NON) || (memo->send_limit == 0)) {
         _expire_request(memo);
     }
-    /* reduce retries remaining, double timeout and resend */
+    /* reduce retries remaining, back off timeout and resend */
     else {
         memo->send_limit--;
+#ifdef MODULE_GCOAP_COCOA
+        memo->timeout = gcoap_cocoa_backoff(memo->timeout);
+        uint32_t timeout = memo->timeout;
+#else
 #ifdef CONFIG_GCOAP_NO_RETRANS_BACKOFF
         unsigned i        = 0;
 #else
@@ -254,12 +357,20 @@ static void _on_resp_timeout(void *arg) {
         uint32_t end = ((uint32_t)TIMEOUT_RANGE_END << i) * US_PER_SEC;
         timeout = random_uint32_range(timeout, end);
 #endif
+#endif /* MODULE_GCOAP_COCOA */
         event_timeout_set(&memo->resp_evt_tmout, timeout);
 
-        ssize_t bytes = sock_udp_send(&_sock, memo->msg.data.pdu_buf,
-                                      memo->msg.data.pdu_len, &memo->remote_ep);
+        ssize_t bytes = _tl_send(memo->msg.data.pdu_buf, memo->msg.data.pdu_len,
+                                 &memo->remote_ep);
+#ifdef MODULE_GCOAP_DTLS
+        if (bytes == -EINPROGRESS) {
+            /* still waiting for the handshake */
+            bytes = memo->msg.data.pdu_len;
+        }
+#endif
         if (bytes <= 0) {
             DEBUG("gcoap: sock resend failed: %d\n", (int)bytes);
+            event_timeout_clear(&memo->resp_evt_tmout);
             _expire_request(memo);
         }
     }
@@ -277,9 +388,15 @@ static size_t _handle_req(coap_pkt_t *pdu, uint8_t *buf, size_t len,
 {
     const coap_resource_t *resource     = NULL;
     gcoap_listener_t *listener          = NULL;
-    sock_udp_ep_t *observer             = NULL;
     gcoap_observe_memo_t *memo          = NULL;
-    gcoap_observe_memo_t *resource_memo = NULL;
+
+#ifdef MODULE_GCOAP_FORWARD_PROXY
+    uint8_t *proxy_uri;
+    if (coap_opt_get_opaque(pdu, COAP_OPT_PROXY_URI, &proxy_uri) >= 0) {
+        ssize_t res = gcoap_forward_proxy_request_process(pdu, buf, len, remote);
+        return (res > 0) ? (size_t)res : 0;
+    }
+#endif
 
     switch (_find_resource(pdu, &resource, &listener)) {
         case GCOAP_RESOURCE_WRONG_METHOD:
@@ -287,80 +404,70 @@ static size_t _handle_req(coap_pkt_t *pdu, uint8_t *buf, size_t len,
         case GCOAP_RESOURCE_NO_PATH:
             return gcoap_response(pdu, buf, len, COAP_CODE_PATH_NOT_FOUND);
         case GCOAP_RESOURCE_FOUND:
-            /* find observe registration for resource */
-            _find_obs_memo_resource(&resource_memo, resource);
             break;
     }
 
+#ifdef MODULE_NANOCOAP_CACHE
+    /* each notification must come from the handler */
+    bool use_cache = !coap_has_observe(pdu);
+    unsigned method = coap_get_code_raw(pdu);
+    uint8_t cache_key[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+    uint8_t uri_key[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+    if (use_cache) {
+        nanocoap_cache_key_generate(pdu, cache_key);
+        nanocoap_cache_uri_key_generate(pdu, uri_key);
+        nanocoap_cache_entry_t *ce = nanocoap_cache_key_lookup(cache_key);
+        if (ce && (ce->request_method == method) &&
+            !nanocoap_cache_entry_is_stale(ce, nanocoap_cache_now())) {
+            ssize_t res = nanocoap_cache_build_reply(ce, pdu, buf, len);
+            if (res > 0) {
+                DEBUG("gcoap: response from cache\n");
+                return res;
+            }
+        }
+    }
+#endif
+
     if (coap_get_observe(pdu) == COAP_OBS_REGISTER) {
+        mutex_lock(&_coap_state.lock);
         /* lookup remote+token */
-        int empty_slot = _find_obs_memo(&memo, remote, pdu);
-        /* validate re-registration request */
-        if (resource_memo != NULL) {
+        memo = _find_obs_memo(remote, pdu->token, coap_get_token_len(pdu));
+        if (memo == NULL) {
+            /* accept new token for a resource the remote already observes */
+            memo = _find_obs_memo_remote(resource, remote);
             if (memo != NULL) {
-                if (memo != resource_memo) {
-                    /* reject token already used for a different resource */
-                    memo = NULL;
-                    coap_clear_observe(pdu);
-                    DEBUG("gcoap: can't change resource for token\n");
-                }
-                /* otherwise OK to re-register resource with the same token */
-            }
-            else if (sock_udp_ep_equal(remote, resource_memo->observer)) {
-                /* accept new token for resource */
-                memo = resource_memo;
+                _obs_unhash(memo);
+                _obs_set_token(memo, pdu);
+                _obs_hash(memo);
             }
-        }
-        /* initialize new registration request */
-        if ((memo == NULL) && coap_has_observe(pdu)) {
-            /* verify resource not already registered (for another endpoint) */
-            if ((empty_slot >= 0) && (resource_memo == NULL)) {
-                int obs_slot = _find_observer(&observer, remote);
-                /* cache new observer */
-                if (observer == NULL) {
-                    if (obs_slot >= 0) {
-                        observer = &_coap_state.observers[obs_slot];
-                        memcpy(observer, remote, sizeof(sock_udp_ep_t));
-                    } else {
-                        DEBUG("gcoap: can't register observer\n");
-                    }
-                }
-                if (observer != NULL) {
-                    memo = &_coap_state.observe_memos[empty_slot];
-                    memo->observer = observer;
-                }
+            else {
+                memo = _obs_register(resource, remote, pdu);
             }
             if (memo == NULL) {
                 coap_clear_observe(pdu);
                 DEBUG("gcoap: can't register observe memo\n");
             }
         }
-        /* finish registration */
+        else if (memo->resource != resource) {
+            /* reject token already used for a different resource */
+            memo = NULL;
+            coap_clear_observe(pdu);
+            DEBUG("gcoap: can't change resource for token\n");
+        }
+        /* otherwise OK to re-register resource with the same token */
         if (memo != NULL) {
-            /* resource may be assigned here if it is not already registered */
-            memo->resource = resource;
-            memo->token_len = coap_get_token_len(pdu);
-            if (memo->token_len) {
-                memcpy(&memo->token[0], pdu->token, memo->token_len);
-            }
             DEBUG("gcoap: Registered observer for: %s\n", memo->resource->path);
         }
+        mutex_unlock(&_coap_state.lock);
 
     } else if (coap_get_observe(pdu) == COAP_OBS_DEREGISTER) {
-        _find_obs_memo(&memo, remote, pdu);
-        /* clear memo, and clear observer if no other memos */
+        mutex_lock(&_coap_state.lock);
+        memo = _find_obs_memo(remote, pdu->token, coap_get_token_len(pdu));
         if (memo != NULL) {
             DEBUG("gcoap: Deregistering observer for: %s\n", memo->resource->path);
-            memo->observer = NULL;
-            memo           = NULL;
-            _find_obs_memo(&memo, remote, NULL);
-            if (memo == NULL) {
-                _find_observer(&observer, remote);
-                if (observer != NULL) {
-                    observer->family = AF_UNSPEC;
-                }
-            }
+            _obs_deregister(memo);
         }
+        mutex_unlock(&_coap_state.lock);
         coap_clear_observe(pdu);
 
     } else if (coap_has_observe(pdu)) {
@@ -374,9 +481,37 @@ static size_t _handle_req(coap_pkt_t *pdu, uint8_t *buf, size_t len,
         pdu_len = gcoap_response(pdu, buf, len,
                                  COAP_CODE_INTERNAL_SERVER_ERROR);
     }
+#ifdef MODULE_NANOCOAP_CACHE
+    if (use_cache && (pdu_len > 0)) {
+        _cache_response(cache_key, uri_key, method, buf, pdu_len);
+    }
+#endif
     return pdu_len;
 }
 
+#ifdef MODULE_NANOCOAP_CACHE
+/*
+ * Updates the cache with the response of a local resource. Only responses
+ * with an explicit Max-Age are cached, as a resource handler usually is not
+ * aware of the default freshness of 60 seconds.
+ */
+static void _cache_response(const uint8_t *cache_key, const uint8_t *uri_key,
+                            unsigned method, uint8_t *buf, size_t len)
+{
+    coap_pkt_t resp;
+    uint32_t max_age;
+
+    if (coap_parse(&resp, buf, len) < 0) {
+        return;
+    }
+    if (((method == COAP_METHOD_GET) || (method == COAP_METHOD_FETCH)) &&
+        (coap_opt_get_uint(&resp, COAP_OPT_MAX_AGE, &max_age) < 0)) {
+        return;
+    }
+    nanocoap_cache_process(cache_key, uri_key, method, &resp, len);
+}
+#endif
+
 /*
  * Searches listener registrations for the resource matching the path in a PDU.
  *
@@ -434,8 +569,37 @@ static int _find_resource(coap_pkt_t *pdu, const coap_resource_t **resource_ptr,
 }
 
 /*
- * Finds the memo for an outstanding request within the _coap_state.open_reqs
- * array. Matches on remote endpoint and token.
+ * Hash over remote endpoint and token, used to look up requests and
+ * observe registrations.
+ */
+static uint32_t _ep_token_hash(const sock_udp_ep_t *remote,
+                               const uint8_t *token, unsigned token_len)
+{
+    const uint8_t *addr = (const uint8_t *)&remote->addr;
+    size_t addr_len = (remote->family == AF_INET6) ? 16 : 4;
+    uint32_t hash = 5381 + remote->port;
+
+    for (size_t i = 0; i < addr_len; i++) {
+        hash = (hash * 33) ^ addr[i];
+    }
+    for (unsigned i = 0; i < token_len; i++) {
+        hash = (hash * 33) ^ token[i];
+    }
+    return hash;
+}
+
+static gcoap_request_memo_t **_req_bucket(const sock_udp_ep_t *remote,
+                                          const uint8_t *token,
+                                          unsigned token_len)
+{
+    uint32_t hash = _ep_token_hash(remote, token, token_len);
+
+    return &_coap_state.req_buckets[hash & (CONFIG_GCOAP_REQ_HASH_BUCKETS - 1)];
+}
+
+/*
+ * Finds the memo for an outstanding request. Matches on remote endpoint and
+ * token, which both select the hash bucket of the memo.
  *
  * memo_ptr[out] -- Registered request memo, or NULL if not found
  * src_pdu[in] -- PDU for token to match
@@ -444,36 +608,143 @@ static int _find_resource(coap_pkt_t *pdu, const coap_resource_t **resource_ptr,
 static void _find_req_memo(gcoap_request_memo_t **memo_ptr, coap_pkt_t *src_pdu,
                            const sock_udp_ep_t *remote)
 {
-    *memo_ptr = NULL;
-    /* no need to initialize struct; we only care about buffer contents below */
-    coap_pkt_t memo_pdu_data;
-    coap_pkt_t *memo_pdu = &memo_pdu_data;
-    unsigned cmplen      = coap_get_token_len(src_pdu);
+    unsigned cmplen = coap_get_token_len(src_pdu);
+    gcoap_request_memo_t *memo = *_req_bucket(remote, src_pdu->token, cmplen);
 
-    for (int i = 0; i < CONFIG_GCOAP_REQ_WAITING_MAX; i++) {
-        if (_coap_state.open_reqs[i].state == GCOAP_MEMO_UNUSED) {
-            continue;
+    for (; memo; memo = memo->next) {
+        if ((memo->token_len == cmplen)
+                && (memcmp(src_pdu->token, memo->token, cmplen) == 0)
+                && sock_udp_ep_equal(&memo->remote_ep, remote)) {
+            break;
         }
+    }
+    *memo_ptr = memo;
+}
+
+/*
+ * Removes a request memo from the lookup table and returns it and its resend
+ * buffer to their pools.
+ */
+static void _release_req_memo(gcoap_request_memo_t *memo)
+{
+    mutex_lock(&_coap_state.lock);
+    gcoap_request_memo_t **prev = _req_bucket(&memo->remote_ep, memo->token,
+                                              memo->token_len);
+    while (*prev && (*prev != memo)) {
+        prev = &(*prev)->next;
+    }
+    if (*prev) {
+        *prev = memo->next;
+    }
+    if ((memo->send_limit != GCOAP_SEND_LIMIT_NON) && memo->msg.data.pdu_buf) {
+        memarray_free(&_coap_state.resend_pool, memo->msg.data.pdu_buf);
+    }
+    memo->state = GCOAP_MEMO_UNUSED;
+    memarray_free(&_coap_state.req_pool, memo);
+    mutex_unlock(&_coap_state.lock);
+}
 
-        gcoap_request_memo_t *memo = &_coap_state.open_reqs[i];
-        if (memo->send_limit == GCOAP_SEND_LIMIT_NON) {
-            memo_pdu->hdr = (coap_hdr_t *) &memo->msg.hdr_buf[0];
+#ifdef MODULE_GCOAP_COCOA
+static gcoap_cocoa_peer_t *_cocoa_peer(const sock_udp_ep_t *remote)
+{
+    uint32_t hash = _ep_token_hash(remote, NULL, 0);
+
+    return &_coap_state.peers[hash & (CONFIG_GCOAP_COCOA_PEERS - 1)];
+}
+
+/*
+ * Current RTO for a peer, aged if not updated for a while: small RTOs are
+ * doubled after 16 * RTO, large RTOs approach the initial RTO after 4 * RTO.
+ */
+uint32_t gcoap_cocoa_rto(const sock_udp_ep_t *remote, uint32_t now)
+{
+    uint32_t rto = COCOA_RTO_INIT;
+
+    mutex_lock(&_coap_state.lock);
+    gcoap_cocoa_peer_t *peer = _cocoa_peer(remote);
+    if ((peer->remote.family != AF_UNSPEC)
+            && sock_udp_ep_equal(&peer->remote, remote)) {
+        uint32_t idle = now - peer->updated;
+        if ((peer->rto < US_PER_SEC) && (idle > 16 * peer->rto)) {
+            peer->rto *= 2;
+            peer->updated = now;
         }
-        else {
-            memo_pdu->hdr = (coap_hdr_t *) memo->msg.data.pdu_buf;
+        else if ((peer->rto > 3 * US_PER_SEC) && (idle > 4 * peer->rto)) {
+            peer->rto = (COCOA_RTO_INIT + peer->rto) / 2;
+            peer->updated = now;
         }
+        rto = peer->rto;
+    }
+    mutex_unlock(&_coap_state.lock);
+    return rto;
+}
 
-        if (coap_get_token_len(memo_pdu) == cmplen) {
-            memo_pdu->token = coap_hdr_data_ptr(memo_pdu->hdr);
-            if ((memcmp(src_pdu->token, memo_pdu->token, cmplen) == 0)
-                    && sock_udp_ep_equal(&memo->remote_ep, remote)) {
-                *memo_ptr = memo;
-                break;
-            }
-        }
+/*
+ * Variable backoff factor: 3 for RTOs below 1 s, 1.5 above 3 s, 2 otherwise.
+ */
+uint32_t gcoap_cocoa_backoff(uint32_t timeout)
+{
+    if (timeout < US_PER_SEC) {
+        timeout *= 3;
+    }
+    else if (timeout > 3 * US_PER_SEC) {
+        timeout += timeout / 2;
+    }
+    else {
+        timeout *= 2;
     }
+    return timeout;
 }
 
+/*
+ * Feeds an RTT sample into the strong (no retransmission) or weak (up to two
+ * retransmissions) estimator of the peer, and updates its overall RTO.
+ */
+void gcoap_cocoa_update(const sock_udp_ep_t *remote, uint32_t rtt,
+                        unsigned retransmissions, uint32_t now)
+{
+    if (retransmissions > 2) {
+        return;
+    }
+
+    mutex_lock(&_coap_state.lock);
+    gcoap_cocoa_peer_t *peer = _cocoa_peer(remote);
+    if ((peer->remote.family == AF_UNSPEC)
+            || !sock_udp_ep_equal(&peer->remote, remote)) {
+        /* take over the slot; loses the state of a colliding peer */
+        memset(peer, 0, sizeof(*peer));
+        memcpy(&peer->remote, remote, sizeof(sock_udp_ep_t));
+        peer->rto = COCOA_RTO_INIT;
+    }
+
+    unsigned est = (retransmissions) ? COCOA_WEAK : COCOA_STRONG;
+    if (peer->srtt[est] == 0) {
+        peer->srtt[est] = rtt;
+        peer->rttvar[est] = rtt / 2;
+    }
+    else {
+        uint32_t delta = (peer->srtt[est] > rtt) ? peer->srtt[est] - rtt
+                                                 : rtt - peer->srtt[est];
+        peer->rttvar[est] = (3 * peer->rttvar[est] + delta) / 4;
+        peer->srtt[est] = (7 * peer->srtt[est] + rtt) / 8;
+    }
+
+    if (est == COCOA_STRONG) {
+        uint32_t rto = peer->srtt[est] + 4 * peer->rttvar[est];
+        peer->rto = (rto + peer->rto) / 2;
+    }
+    else {
+        uint32_t rto = peer->srtt[est] + peer->rttvar[est];
+        peer->rto = (rto + 3 * peer->rto) / 4;
+    }
+    if (peer->rto > COCOA_RTO_MAX) {
+        peer->rto = COCOA_RTO_MAX;
+    }
+    peer->updated = now;
+    mutex_unlock(&_coap_state.lock);
+}
+#endif /* MODULE_GCOAP_COCOA */
+
 /* Calls handler callback on receipt of a timeout message. */
 static void _expire_request(gcoap_request_memo_t *memo)
 {
@@ -491,10 +762,7 @@ static void _expire_request(gcoap_request_memo_t *memo)
             }
             memo->resp_handler(memo, &req, NULL);
         }
-        if (memo->send_limit != GCOAP_SEND_LIMIT_NON) {
-            *memo->msg.data.pdu_buf = 0;    /* clear resend buffer */
-        }
-        memo->state = GCOAP_MEMO_UNUSED;
+        _release_req_memo(memo);
     }
     else {
         /* Response already handled; timeout must have fired while response */
@@ -521,93 +789,274 @@ static ssize_t _well_known_core_handler(coap_pkt_t* pdu, uint8_t *buf, size_t le
 }
 
 /*
- * Find registered observer for a remote address and port.
- *
- * observer[out] -- Registered observer, or NULL if not found
- * remote[in] -- Endpoint to match
+ * Hash bucket of an observe registration, over remote endpoint and token.
+ */
+static unsigned _obs_bucket(const sock_udp_ep_t *remote, const uint8_t *token,
+                            unsigned token_len)
+{
+    return _ep_token_hash(remote, token, token_len)
+           & (CONFIG_GCOAP_OBS_HASH_BUCKETS - 1);
+}
+
+static void _obs_hash(gcoap_observe_memo_t *memo)
+{
+    gcoap_observe_memo_t **bucket = &_coap_state.observe_buckets[
+        _obs_bucket(&memo->observer, memo->token, memo->token_len)];
+
+    memo->bucket_next = *bucket;
+    *bucket = memo;
+}
+
+static void _obs_unhash(gcoap_observe_memo_t *memo)
+{
+    gcoap_observe_memo_t **prev = &_coap_state.observe_buckets[
+        _obs_bucket(&memo->observer, memo->token, memo->token_len)];
+
+    while (*prev != memo) {
+        prev = &(*prev)->bucket_next;
+    }
+    *prev = memo->bucket_next;
+}
+
+static void _obs_set_token(gcoap_observe_memo_t *memo, const coap_pkt_t *pdu)
+{
+    memo->token_len = coap_get_token_len(pdu);
+    if (memo->token_len) {
+        memcpy(&memo->token[0], pdu->token, memo->token_len);
+    }
+}
+
+/*
+ * Find registered observe memo for a remote endpoint and token.
  *
- * return Index of empty slot, suitable for registering new observer; or -1
- *        if no empty slots. Undefined if observer found.
+ * return Registered observe memo, or NULL if not found
  */
-static int _find_observer(sock_udp_ep_t **observer, sock_udp_ep_t *remote)
+static gcoap_observe_memo_t *_find_obs_memo(const sock_udp_ep_t *remote,
+                                            const uint8_t *token,
+                                            unsigned token_len)
 {
-    int empty_slot = -1;
-    *observer      = NULL;
-    for (unsigned i = 0; i < CONFIG_GCOAP_OBS_CLIENTS_MAX; i++) {
+    gcoap_observe_memo_t *memo = _coap_state.observe_buckets[
+        _obs_bucket(remote, token, token_len)];
 
-        if (_coap_state.observers[i].family == AF_UNSPEC) {
-            empty_slot = i;
-        }
-        else if (sock_udp_ep_equal(&_coap_state.observers[i], remote)) {
-            *observer = &_coap_state.observers[i];
+    for (; memo; memo = memo->bucket_next) {
+        if ((memo->token_len == token_len) &&
+                (memcmp(&memo->token[0], token, token_len) == 0) &&
+                sock_udp_ep_equal(&memo->observer, remote)) {
             break;
         }
     }
-    return empty_slot;
+    return memo;
 }
 
 /*
- * Find registered observe memo for a remote address and token.
+ * Find the entry of an observed resource.
  *
- * memo[out] -- Registered observe memo, or NULL if not found
- * remote[in] -- Endpoint for address to match
- * pdu[in] -- PDU for token to match, or NULL to match only on remote address
+ * return Entry for the resource, or NULL if the resource is not observed
+ */
+static gcoap_obs_resource_t *_find_obs_resource(const coap_resource_t *resource)
+{
+    for (unsigned i = 0; i < CONFIG_GCOAP_OBS_RESOURCES_MAX; i++) {
+        if (_coap_state.observed[i].resource == resource) {
+            return &_coap_state.observed[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Find the registration of a remote endpoint for a resource, regardless of
+ * the token.
+ */
+static gcoap_observe_memo_t *_find_obs_memo_remote(const coap_resource_t *resource,
+                                                   const sock_udp_ep_t *remote)
+{
+    gcoap_obs_resource_t *entry = _find_obs_resource(resource);
+
+    if (entry == NULL) {
+        return NULL;
+    }
+    for (gcoap_observe_memo_t *memo = entry->observers; memo; memo = memo->next) {
+        if (sock_udp_ep_equal(&memo->observer, remote)) {
+            return memo;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Register a new observer for a resource.
  *
- * return Index of empty slot, suitable for registering new memo; or -1 if no
- *        empty slots. Undefined if memo found.
+ * return New observe memo, or NULL if out of memos or resource entries
  */
-static int _find_obs_memo(gcoap_observe_memo_t **memo, sock_udp_ep_t *remote,
-                                                       coap_pkt_t *pdu)
+static gcoap_observe_memo_t *_obs_register(const coap_resource_t *resource,
+                                           const sock_udp_ep_t *remote,
+                                           const coap_pkt_t *pdu)
 {
-    int empty_slot = -1;
-    *memo          = NULL;
+    gcoap_obs_resource_t *entry = _find_obs_resource(resource);
 
-    sock_udp_ep_t *remote_observer = NULL;
-    _find_observer(&remote_observer, remote);
+    if (entry == NULL) {
+        entry = _find_obs_resource(NULL);
+        if (entry == NULL) {
+            DEBUG("gcoap: can't observe more resources\n");
+            return NULL;
+        }
+    }
 
-    for (unsigned i = 0; i < CONFIG_GCOAP_OBS_REGISTRATIONS_MAX; i++) {
-        if (_coap_state.observe_memos[i].observer == NULL) {
-            empty_slot = i;
-            continue;
+    gcoap_observe_memo_t *memo = memarray_alloc(&_coap_state.observe_pool);
+    if (memo == NULL) {
+        return NULL;
+    }
+
+    if (entry->resource == NULL) {
+        entry->resource = resource;
+        entry->pending = false;
+        /* allow the first generated notification right away */
+        entry->last_notify = xtimer_now_usec() - CONFIG_GCOAP_OBS_NOTIFY_INTERVAL;
+        event_callback_init(&entry->notify_cb, _on_obs_notify, entry);
+        event_timeout_init(&entry->notify_tmout, &_queue,
+                           &entry->notify_cb.super);
+    }
+
+    memo->resource = resource;
+    memcpy(&memo->observer, remote, sizeof(sock_udp_ep_t));
+    _obs_set_token(memo, pdu);
+    _obs_hash(memo);
+    memo->next = entry->observers;
+    entry->observers = memo;
+    return memo;
+}
+
+/*
+ * Remove an observe registration; releases the resource entry if it was the
+ * last observer.
+ */
+static void _obs_deregister(gcoap_observe_memo_t *memo)
+{
+    gcoap_obs_resource_t *entry = _find_obs_resource(memo->resource);
+    gcoap_observe_memo_t **prev = &entry->observers;
+
+    while (*prev != memo) {
+        prev = &(*prev)->next;
+    }
+    *prev = memo->next;
+    _obs_unhash(memo);
+    memarray_free(&_coap_state.observe_pool, memo);
+
+    if (entry->observers == NULL) {
+        if (entry->pending) {
+            event_timeout_clear(&entry->notify_tmout);
+            event_cancel(&_queue, &entry->notify_cb.super);
         }
+        entry->resource = NULL;
+    }
+}
 
-        if (_coap_state.observe_memos[i].observer == remote_observer) {
-            if (pdu == NULL) {
-                *memo = &_coap_state.observe_memos[i];
-                break;
-            }
+/*
+ * Longest token of all observers of a resource; the notification header is
+ * reserved for it, so it can be rewritten in place for all observers.
+ */
+static gcoap_observe_memo_t *_obs_longest_token(const gcoap_obs_resource_t *entry)
+{
+    gcoap_observe_memo_t *longest = entry->observers;
 
-            if (_coap_state.observe_memos[i].token_len == coap_get_token_len(pdu)) {
-                unsigned cmplen = _coap_state.observe_memos[i].token_len;
-                if (cmplen &&
-                        memcmp(&_coap_state.observe_memos[i].token[0], &pdu->token[0],
-                                                                       cmplen) == 0) {
-                    *memo = &_coap_state.observe_memos[i];
-                    break;
-                }
-            }
+    for (gcoap_observe_memo_t *memo = entry->observers; memo; memo = memo->next) {
+        if (memo->token_len > longest->token_len) {
+            longest = memo;
         }
     }
-    return empty_slot;
+    return longest;
 }
 
 /*
- * Find registered observe memo for a resource.
+ * Send a notification in buf to all observers of a resource.
+ *
+ * Only the header is rewritten for each observer: as it was reserved for the
+ * longest token, the header for a shorter token starts further into buf, so
+ * that it still ends right before the options. The original header is
+ * restored afterwards.
  *
- * memo[out] -- Registered observe memo, or NULL if not found
- * resource[in] -- Resource to match
+ * return true if sent to at least one observer
  */
-static void _find_obs_memo_resource(gcoap_observe_memo_t **memo,
-                                   const coap_resource_t *resource)
-{
-    *memo = NULL;
-    for (int i = 0; i < CONFIG_GCOAP_OBS_REGISTRATIONS_MAX; i++) {
-        if (_coap_state.observe_memos[i].observer != NULL
-                && _coap_state.observe_memos[i].resource == resource) {
-            *memo = &_coap_state.observe_memos[i];
-            break;
+static bool _obs_fanout(uint8_t *buf, size_t len, gcoap_obs_resource_t *entry)
+{
+    coap_hdr_t *hdr = (coap_hdr_t *)buf;
+    unsigned tkl    = hdr->ver_t_tkl & 0xf;
+    unsigned code   = hdr->code;
+    bool sent       = false;
+    uint8_t orig[sizeof(coap_hdr_t) + COAP_TOKEN_LENGTH_MAX];
+
+    if (tkl > COAP_TOKEN_LENGTH_MAX) {
+        return false;
+    }
+    memcpy(orig, buf, sizeof(coap_hdr_t) + tkl);
+
+    for (gcoap_observe_memo_t *memo = entry->observers; memo; memo = memo->next) {
+        if (memo->token_len > tkl) {
+            /* registered after the notification was initialized */
+            DEBUG("gcoap: skipping notification, token too long\n");
+            continue;
+        }
+
+        unsigned offset = tkl - memo->token_len;
+        uint16_t msgid  = (uint16_t)atomic_fetch_add(&_coap_state.next_message_id, 1);
+        coap_build_hdr((coap_hdr_t *)&buf[offset], COAP_TYPE_NON, memo->token,
+                       memo->token_len, code, msgid);
+
+        ssize_t bytes = _tl_send(&buf[offset], len - offset, &memo->observer);
+        if (bytes > 0) {
+            sent = true;
+        }
+        else {
+            DEBUG("gcoap: sending notification failed: %d\n", (int)bytes);
         }
     }
+
+    memcpy(buf, orig, sizeof(coap_hdr_t) + tkl);
+    return sent;
+}
+
+/* Generates a notification from the resource handler and sends it. */
+static void _on_obs_notify(void *arg)
+{
+    gcoap_obs_resource_t *entry = arg;
+    coap_pkt_t pdu;
+
+    mutex_lock(&_coap_state.lock);
+    const coap_resource_t *resource = entry->resource;
+    entry->pending = false;
+    entry->last_notify = xtimer_now_usec();
+    if (resource == NULL) {
+        mutex_unlock(&_coap_state.lock);
+        return;
+    }
+
+    /* build a GET request for the resource handler; runs in the gcoap thread,
+     * so the receive buffer is available */
+    gcoap_observe_memo_t *longest = _obs_longest_token(entry);
+    ssize_t res = coap_build_hdr((coap_hdr_t *)_listen_buf, COAP_TYPE_NON,
+                                 longest->token, longest->token_len,
+                                 COAP_METHOD_GET, 0);
+    mutex_unlock(&_coap_state.lock);
+
+    coap_pkt_init(&pdu, _listen_buf, sizeof(_listen_buf), res);
+    coap_opt_add_uint(&pdu, COAP_OPT_OBSERVE, COAP_OBS_REGISTER);
+    coap_opt_add_uri_path(&pdu, resource->path);
+    res = coap_opt_finish(&pdu, COAP_OPT_FINISH_NONE);
+    if ((res < 0) || (coap_parse(&pdu, _listen_buf, res) < 0)) {
+        DEBUG("gcoap: can't build request for notification\n");
+        return;
+    }
+
+    res = resource->handler(&pdu, _listen_buf, sizeof(_listen_buf),
+                            resource->context);
+    if (res <= 0) {
+        DEBUG("gcoap: no notification from handler: %d\n", (int)res);
+        return;
+    }
+
+    mutex_lock(&_coap_state.lock);
+    _obs_fanout(_listen_buf, res, entry);
+    mutex_unlock(&_coap_state.lock);
 }
 
 /*
@@ -624,12 +1073,29 @@ kernel_pid_t gcoap_init(void)
 
     mutex_init(&_coap_state.lock);
     /* Blank lists so we know if an entry is available. */
-    memset(&_coap_state.open_reqs[0], 0, sizeof(_coap_state.open_reqs));
-    memset(&_coap_state.observers[0], 0, sizeof(_coap_state.observers));
-    memset(&_coap_state.observe_memos[0], 0, sizeof(_coap_state.observe_memos));
-    memset(&_coap_state.resend_bufs[0], 0, sizeof(_coap_state.resend_bufs));
+    memset(&_coap_state.req_buckets[0], 0, sizeof(_coap_state.req_buckets));
+    memarray_init(&_coap_state.req_pool, _coap_state.open_reqs,
+                  sizeof(gcoap_request_memo_t), CONFIG_GCOAP_REQ_WAITING_MAX);
+    memset(&_coap_state.observe_buckets[0], 0,
+           sizeof(_coap_state.observe_buckets));
+    memset(&_coap_state.observed[0], 0, sizeof(_coap_state.observed));
+    memarray_init(&_coap_state.observe_pool, _coap_state.observe_memos,
+                  sizeof(gcoap_observe_memo_t),
+                  CONFIG_GCOAP_OBS_REGISTRATIONS_MAX);
+    memarray_init(&_coap_state.resend_pool, _coap_state.resend_bufs,
+                  sizeof(_coap_state.resend_bufs[0]),
+                  CONFIG_GCOAP_RESEND_BUFS_MAX);
+#ifdef MODULE_GCOAP_COCOA
+    memset(&_coap_state.peers[0], 0, sizeof(_coap_state.peers));
+#endif
     /* randomize initial value */
     atomic_init(&_coap_state.next_message_id, (unsigned)random_uint32());
+#ifdef MODULE_NANOCOAP_CACHE
+    nanocoap_cache_init();
+#endif
+#ifdef MODULE_GCOAP_FORWARD_PROXY
+    gcoap_forward_proxy_init();
+#endif
 
     return _pid;
 }
@@ -739,47 +1205,56 @@ size_t gcoap_req_send(const uint8_t *buf, size_t len,
     /* Only allocate memory if necessary (i.e. if user is interested in the
      * response or request is confirmable) */
     if ((resp_handler != NULL) || (msg_type == COAP_TYPE_CON)) {
-        mutex_lock(&_coap_state.lock);
-        /* Find empty slot in list of open requests. */
-        for (int i = 0; i < CONFIG_GCOAP_REQ_WAITING_MAX; i++) {
-            if (_coap_state.open_reqs[i].state == GCOAP_MEMO_UNUSED) {
-                memo = &_coap_state.open_reqs[i];
-                memo->state = GCOAP_MEMO_WAIT;
-                break;
-            }
+        unsigned token_len = *buf & 0x0f;
+
+        if ((token_len > GCOAP_TOKENLEN_MAX)
+                || (len < sizeof(coap_hdr_t) + token_len)
+                || (len > CONFIG_GCOAP_PDU_BUF_SIZE)) {
+            DEBUG("gcoap: illegal request PDU\n");
+            return 0;
         }
+#ifdef MODULE_GCOAP_COCOA
+        uint32_t now = xtimer_now_usec();
+        uint32_t rto = (msg_type == COAP_TYPE_CON) ? gcoap_cocoa_rto(remote, now)
+                                                   : 0;
+#endif
+
+        mutex_lock(&_coap_state.lock);
+        memo = memarray_alloc(&_coap_state.req_pool);
         if (!memo) {
             mutex_unlock(&_coap_state.lock);
             DEBUG("gcoap: dropping request; no space for response tracking\n");
             return 0;
         }
-
+        memset(memo, 0, sizeof(*memo));
+        memo->state = GCOAP_MEMO_WAIT;
         memo->resp_handler = resp_handler;
         memo->context = context;
         memcpy(&memo->remote_ep, remote, sizeof(sock_udp_ep_t));
+        memcpy(memo->token, buf + sizeof(coap_hdr_t), token_len);
+        memo->token_len = token_len;
 
         switch (msg_type) {
         case COAP_TYPE_CON:
-            /* copy buf to resend_bufs record */
-            memo->msg.data.pdu_buf = NULL;
-            for (int i = 0; i < CONFIG_GCOAP_RESEND_BUFS_MAX; i++) {
-                if (!_coap_state.resend_bufs[i][0]) {
-                    memo->msg.data.pdu_buf = &_coap_state.resend_bufs[i][0];
-                    memcpy(memo->msg.data.pdu_buf, buf,
-                           CONFIG_GCOAP_PDU_BUF_SIZE);
-                    memo->msg.data.pdu_len = len;
-                    break;
-                }
-            }
+            /* copy buf to a resend buffer */
+            memo->send_limit = CONFIG_COAP_MAX_RETRANSMIT;
+            memo->msg.data.pdu_buf = memarray_alloc(&_coap_state.resend_pool);
             if (memo->msg.data.pdu_buf) {
-                memo->send_limit  = CONFIG_COAP_MAX_RETRANSMIT;
-                timeout           = (uint32_t)CONFIG_COAP_ACK_TIMEOUT * US_PER_SEC;
+                memcpy(memo->msg.data.pdu_buf, buf, len);
+                memo->msg.data.pdu_len = len;
+#ifdef MODULE_GCOAP_COCOA
+                timeout = random_uint32_range(rto, (uint32_t)(((uint64_t)rto
+                                              * CONFIG_COAP_RANDOM_FACTOR_1000) / 1000) + 1);
+                memo->timeout = timeout;
+                memo->send_time = now;
+#else
+                timeout = (uint32_t)CONFIG_COAP_ACK_TIMEOUT * US_PER_SEC;
 #if CONFIG_COAP_RANDOM_FACTOR_1000 > 1000
                 timeout = random_uint32_range(timeout, TIMEOUT_RANGE_END * US_PER_SEC);
+#endif
 #endif
             }
             else {
-                memo->state = GCOAP_MEMO_UNUSED;
                 DEBUG("gcoap: no space for PDU in resend bufs\n");
             }
             break;
@@ -790,14 +1265,21 @@ size_t gcoap_req_send(const uint8_t *buf, size_t len,
             timeout = CONFIG_GCOAP_NON_TIMEOUT;
             break;
         default:
-            memo->state = GCOAP_MEMO_UNUSED;
             DEBUG("gcoap: illegal msg type %u\n", msg_type);
             break;
         }
-        mutex_unlock(&_coap_state.lock);
-        if (memo->state == GCOAP_MEMO_UNUSED) {
+        if (timeout == 0 && msg_type != COAP_TYPE_NON) {
+            memo->state = GCOAP_MEMO_UNUSED;
+            memarray_free(&_coap_state.req_pool, memo);
+            mutex_unlock(&_coap_state.lock);
             return 0;
         }
+        /* make visible for response matching before sending */
+        gcoap_request_memo_t **bucket = _req_bucket(remote, memo->token,
+                                                    memo->token_len);
+        memo->next = *bucket;
+        *bucket = memo;
+        mutex_unlock(&_coap_state.lock);
     }
 
     /* set response timeout; may be zero for non-confirmable */
@@ -813,16 +1295,19 @@ size_t gcoap_req_send(const uint8_t *buf, size_t len,
         }
     }
 
-    ssize_t res = sock_udp_send(&_sock, buf, len, remote);
+    ssize_t res = _tl_send(buf, len, remote);
+#ifdef MODULE_GCOAP_DTLS
+    if ((res == -EINPROGRESS) && (msg_type == COAP_TYPE_CON)) {
+        /* resent once the handshake completed */
+        res = len;
+    }
+#endif
     if (res <= 0) {
         if (memo != NULL) {
-            if (msg_type == COAP_TYPE_CON) {
-                *memo->msg.data.pdu_buf = 0;    /* clear resend buffer */
-            }
             if (timeout > 0) {
                 event_timeout_clear(&memo->resp_evt_tmout);
             }
-            memo->state = GCOAP_MEMO_UNUSED;
+            _release_req_memo(memo);
         }
         DEBUG("gcoap: sock send failed: %d\n", (int)res);
     }
@@ -839,6 +1324,9 @@ int gcoap_resp_init(coap_pkt_t *pdu, uint8_t *buf, size_t len, unsigned code)
     unsigned header_len  = coap_get_total_hdr_len(pdu);
 
     pdu->options_len = 0;
+#ifdef MODULE_NANOCOAP_OPT_INDEX
+    pdu->opt_mask    = 0;
+#endif
     pdu->payload     = buf + header_len;
     pdu->payload_len = len - header_len - CONFIG_GCOAP_RESP_OPTIONS_BUF;
 
@@ -855,18 +1343,25 @@ int gcoap_resp_init(coap_pkt_t *pdu, uint8_t *buf, size_t len, unsigned code)
 int gcoap_obs_init(coap_pkt_t *pdu, uint8_t *buf, size_t len,
                                                   const coap_resource_t *resource)
 {
-    gcoap_observe_memo_t *memo = NULL;
+    uint8_t token[GCOAP_TOKENLEN_MAX];
+    unsigned token_len;
 
-    _find_obs_memo_resource(&memo, resource);
-    if (memo == NULL) {
+    mutex_lock(&_coap_state.lock);
+    gcoap_obs_resource_t *entry = _find_obs_resource(resource);
+    if (entry == NULL) {
+        mutex_unlock(&_coap_state.lock);
         /* Unique return value to specify there is not an observer */
         return GCOAP_OBS_INIT_UNUSED;
     }
+    gcoap_observe_memo_t *memo = _obs_longest_token(entry);
+    token_len = memo->token_len;
+    memcpy(token, memo->token, token_len);
+    mutex_unlock(&_coap_state.lock);
 
     pdu->hdr       = (coap_hdr_t *)buf;
     uint16_t msgid = (uint16_t)atomic_fetch_add(&_coap_state.next_message_id, 1);
-    ssize_t hdrlen = coap_build_hdr(pdu->hdr, COAP_TYPE_NON, &memo->token[0],
-                                    memo->token_len, COAP_CODE_CONTENT, msgid);
+    ssize_t hdrlen = coap_build_hdr(pdu->hdr, COAP_TYPE_NON, token, token_len,
+                                    COAP_CODE_CONTENT, msgid);
 
     if (hdrlen > 0) {
         coap_pkt_init(pdu, buf, len - CONFIG_GCOAP_OBS_OPTIONS_BUF, hdrlen);
@@ -883,31 +1378,85 @@ int gcoap_obs_init(coap_pkt_t *pdu, uint8_t *buf, size_t len,
     }
 }
 
-size_t gcoap_obs_send(const uint8_t *buf, size_t len,
+size_t gcoap_obs_send(uint8_t *buf, size_t len,
                       const coap_resource_t *resource)
 {
-    gcoap_observe_memo_t *memo = NULL;
+    bool sent = false;
+
+    mutex_lock(&_coap_state.lock);
+    gcoap_obs_resource_t *entry = _find_obs_resource(resource);
+    if (entry) {
+        /* the header is rewritten per observer, options and payload are
+         * sent as they are */
+        sent = _obs_fanout(buf, len, entry);
+    }
+    mutex_unlock(&_coap_state.lock);
 
-    _find_obs_memo_resource(&memo, resource);
+    return (sent) ? len : 0;
+}
+
+int gcoap_obs_notify(const coap_resource_t *resource)
+{
+    int res = 0;
 
-    if (memo) {
-        ssize_t bytes = sock_udp_send(&_sock, buf, len, memo->observer);
-        return (size_t)((bytes > 0) ? bytes : 0);
+    mutex_lock(&_coap_state.lock);
+    gcoap_obs_resource_t *entry = _find_obs_resource(resource);
+    if (entry == NULL) {
+        res = -ENOENT;
     }
-    else {
-        return 0;
+    else if (!entry->pending) {
+        uint32_t since = xtimer_now_usec() - entry->last_notify;
+
+        entry->pending = true;
+        if (since >= CONFIG_GCOAP_OBS_NOTIFY_INTERVAL) {
+            event_post(&_queue, &entry->notify_cb.super);
+        }
+        else {
+            event_timeout_set(&entry->notify_tmout,
+                              CONFIG_GCOAP_OBS_NOTIFY_INTERVAL - since);
+        }
     }
+    /* otherwise coalesced with the pending notification */
+    mutex_unlock(&_coap_state.lock);
+
+    return res;
 }
 
-uint8_t gcoap_op_state(void)
+uint16_t gcoap_next_msg_id(void)
+{
+    return (uint16_t)atomic_fetch_add(&_coap_state.next_message_id, 1);
+}
+
+ssize_t gcoap_dispatch(const uint8_t *buf, size_t len,
+                       const sock_udp_ep_t *remote)
+{
+    return _tl_send(buf, len, remote);
+}
+
+#ifdef MODULE_GCOAP_DTLS
+void gcoap_resend_pending(const sock_udp_ep_t *remote)
 {
-    uint8_t count = 0;
-    for (int i = 0; i < CONFIG_GCOAP_REQ_WAITING_MAX; i++) {
-        if (_coap_state.open_reqs[i].state != GCOAP_MEMO_UNUSED) {
-            count++;
+    mutex_lock(&_coap_state.lock);
+    for (unsigned i = 0; i < CONFIG_GCOAP_REQ_HASH_BUCKETS; i++) {
+        for (gcoap_request_memo_t *memo = _coap_state.req_buckets[i]; memo;
+             memo = memo->next) {
+            if ((memo->state == GCOAP_MEMO_WAIT)
+                    && (memo->send_limit != GCOAP_SEND_LIMIT_NON)
+                    && sock_udp_ep_equal(&memo->remote_ep, remote)) {
+                _tl_send(memo->msg.data.pdu_buf, memo->msg.data.pdu_len,
+                         remote);
+            }
         }
     }
-    return count;
+    mutex_unlock(&_coap_state.lock);
+}
+#endif
+
+uint8_t gcoap_op_state(void)
+{
+    size_t count = memarray_used(&_coap_state.req_pool);
+
+    return (count > UINT8_MAX) ? UINT8_MAX : count;
 }
 
 int gcoap_get_resource_list(void *buf, size_t maxlen, uint8_t cf)
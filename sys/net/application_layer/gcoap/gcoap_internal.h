@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     net_gcoap
+ * @{
+ *
+ * @file
+ * @brief       gcoap internals shared with its submodules
+ */
+
+#ifndef GCOAP_INTERNAL_H
+#define GCOAP_INTERNAL_H
+
+#include "net/gcoap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Get a message ID for a new message
+ */
+uint16_t gcoap_next_msg_id(void);
+
+/**
+ * @brief   Send a message from the gcoap server port, without tracking it
+ *
+ * @param[in]   buf     message to send
+ * @param[in]   len     length of @p buf
+ * @param[in]   remote  destination
+ *
+ * @return  length of the sent message
+ * @return  <= 0 on error
+ */
+ssize_t gcoap_dispatch(const uint8_t *buf, size_t len,
+                       const sock_udp_ep_t *remote);
+
+/**
+ * @brief   Handle a received message
+ *
+ * Must be called from the gcoap thread. The response is written to @p buf.
+ *
+ * @param[in,out] buf   message
+ * @param[in]   size    size of @p buf
+ * @param[in]   len     length of the message
+ * @param[in]   remote  sender
+ */
+void gcoap_handle_msg(uint8_t *buf, size_t size, size_t len,
+                      sock_udp_ep_t *remote);
+
+#if defined(MODULE_GCOAP_COCOA) || defined(DOXYGEN)
+/**
+ * @brief   Get the retransmission timeout for a confirmable request
+ *
+ * Ages the estimate of @p remote, if it was not updated for a while. Without
+ * an estimate, this is the initial timeout of RFC 7252.
+ *
+ * @param[in]   remote  server
+ * @param[in]   now     current time, in usec
+ *
+ * @return  retransmission timeout, in usec
+ */
+uint32_t gcoap_cocoa_rto(const sock_udp_ep_t *remote, uint32_t now);
+
+/**
+ * @brief   Back off a retransmission timeout
+ *
+ * @param[in]   timeout the timeout of the last transmission, in usec
+ *
+ * @return  the timeout of the next transmission, in usec
+ */
+uint32_t gcoap_cocoa_backoff(uint32_t timeout);
+
+/**
+ * @brief   Update the retransmission timeout of a server with a round trip
+ *          time sample
+ *
+ * Samples of requests retransmitted more than twice are ignored.
+ *
+ * @param[in]   remote          server
+ * @param[in]   rtt             time from the first transmission of the request
+ *                              to the response, in usec
+ * @param[in]   retransmissions number of retransmissions of the request
+ * @param[in]   now             current time, in usec
+ */
+void gcoap_cocoa_update(const sock_udp_ep_t *remote, uint32_t rtt,
+                        unsigned retransmissions, uint32_t now);
+#endif
+
+#if defined(MODULE_GCOAP_DTLS) || defined(DOXYGEN)
+/**
+ * @brief   Start receiving DTLS records on a UDP sock
+ *
+ * @param[in]   udp     UDP sock bound to the CoAPS port
+ * @param[in]   queue   event queue of the gcoap thread
+ *
+ * @return  0 on success
+ * @return  <0 on error
+ */
+int gcoap_dtls_init(sock_udp_t *udp, event_queue_t *queue);
+
+/**
+ * @brief   Send a message via DTLS
+ *
+ * Copies the message to the send queue of the DTLS thread. Starts a
+ * handshake if there is no session with @p remote.
+ *
+ * @param[in]   buf     message to send, at most CONFIG_GCOAP_PDU_BUF_SIZE
+ *                      bytes
+ * @param[in]   len     length of @p buf
+ * @param[in]   remote  destination
+ *
+ * @return  length of the queued message
+ * @return  -EINPROGRESS if not sent while the handshake with @p remote is in
+ *          progress
+ * @return  -ENOBUFS if the send queue is full
+ */
+ssize_t gcoap_dtls_send(const uint8_t *buf, size_t len,
+                        const sock_udp_ep_t *remote);
+
+/**
+ * @brief   Resend the confirmable requests waiting for a handshake
+ *
+ * Called from the gcoap thread once the handshake with @p remote completed.
+ *
+ * @param[in]   remote  server
+ */
+void gcoap_resend_pending(const sock_udp_ep_t *remote);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* GCOAP_INTERNAL_H */
+/** @} */
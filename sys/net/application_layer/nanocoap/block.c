@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     net_nanocoap_block
+ * @{
+ *
+ * @file
+ * @brief       nanocoap block-wise streaming implementation
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "net/nanocoap_block.h"
+
+#ifdef MODULE_VFS
+#include "vfs.h"
+#endif
+
+#define ENABLE_DEBUG (0)
+#include "debug.h"
+
+/* Content-Format, Block2, Size2 and payload marker */
+#define BLOCK2_OPTS_MAX     (3 + 4 + 5 + 1)
+
+ssize_t coap_block2_reply_stream(coap_pkt_t *pkt, unsigned code,
+                                 uint8_t *buf, size_t len, uint16_t ct,
+                                 size_t size, coap_block_read_t read,
+                                 void *arg)
+{
+    uint32_t blknum = 0;
+    unsigned szx = CONFIG_NANOCOAP_BLOCK_SIZE_EXP_MAX - 4;
+    size_t hdr_len = coap_get_total_hdr_len(pkt);
+
+    if (coap_get_blockopt(pkt, COAP_OPT_BLOCK2, &blknum, &szx) < 0) {
+        blknum = 0;
+        szx = CONFIG_NANOCOAP_BLOCK_SIZE_EXP_MAX - 4;
+    }
+    size_t offset = (size_t)blknum << (szx + 4);
+
+    /* late negotiation: a smaller block size keeps the offset */
+    if (szx > CONFIG_NANOCOAP_BLOCK_SIZE_EXP_MAX - 4) {
+        szx = CONFIG_NANOCOAP_BLOCK_SIZE_EXP_MAX - 4;
+    }
+    while ((szx > 0) && (hdr_len + BLOCK2_OPTS_MAX + coap_szx2size(szx) > len)) {
+        szx--;
+    }
+    blknum = offset >> (szx + 4);
+
+    if ((offset > size) || ((offset == size) && size)) {
+        return coap_build_reply(pkt, COAP_CODE_BAD_OPTION, buf, len, 0);
+    }
+
+    size_t payload_len = size - offset;
+    if (payload_len > coap_szx2size(szx)) {
+        payload_len = coap_szx2size(szx);
+    }
+    if (hdr_len + BLOCK2_OPTS_MAX + payload_len > len) {
+        return -ENOSPC;
+    }
+    bool more = offset + payload_len < size;
+
+    uint8_t *bufpos = buf + hdr_len;
+    uint16_t lastonum = 0;
+    if (ct != COAP_FORMAT_NONE) {
+        bufpos += coap_put_option_ct(bufpos, 0, ct);
+        lastonum = COAP_OPT_CONTENT_FORMAT;
+    }
+    bufpos += coap_opt_put_uint(bufpos, lastonum, COAP_OPT_BLOCK2,
+                                (blknum << 4) | (more << 3) | szx);
+    if (blknum == 0) {
+        bufpos += coap_opt_put_uint(bufpos, COAP_OPT_BLOCK2, COAP_OPT_SIZE2,
+                                    size);
+    }
+    if (payload_len) {
+        *bufpos++ = 0xff;
+        ssize_t res = read(arg, offset, bufpos, payload_len);
+        if (res != (ssize_t)payload_len) {
+            DEBUG("nanocoap: reading block %u failed: %d\n", (unsigned)blknum,
+                  (int)res);
+            return coap_build_reply(pkt, COAP_CODE_INTERNAL_SERVER_ERROR, buf,
+                                    len, 0);
+        }
+    }
+
+    return coap_build_reply(pkt, code, buf, len,
+                            bufpos - (buf + hdr_len) + payload_len);
+}
+
+void coap_block1_sink_init(coap_block1_sink_t *sink, coap_blockwise_cb_t write,
+                           void *arg)
+{
+    sink->write = write;
+    sink->arg = arg;
+    sink->offset = 0;
+}
+
+ssize_t coap_block1_sink_handle(coap_block1_sink_t *sink, coap_pkt_t *pkt,
+                                uint8_t *buf, size_t len, unsigned code)
+{
+    coap_block1_t block1;
+    bool has_block = coap_get_block1(pkt, &block1);
+    uint8_t *payload_start = buf + coap_get_total_hdr_len(pkt);
+    uint8_t *bufpos = payload_start;
+    unsigned resp_code;
+
+    if (!has_block) {
+        block1.more = 0;
+    }
+
+    if ((block1.offset < sink->offset) &&
+        (block1.offset + pkt->payload_len == sink->offset)) {
+        /* our response to the last block got lost */
+        resp_code = (block1.more == 1) ? COAP_CODE_CONTINUE : code;
+    }
+    else {
+        if (block1.offset == 0) {
+            sink->offset = 0;
+        }
+        if ((block1.offset != sink->offset) ||
+            ((block1.more == 1) &&
+             (pkt->payload_len != coap_szx2size(block1.szx)))) {
+            resp_code = COAP_CODE_REQUEST_ENTITY_INCOMPLETE;
+        }
+        else if (sink->write(sink->arg, block1.offset, pkt->payload,
+                             pkt->payload_len, block1.more)) {
+            resp_code = COAP_CODE_INTERNAL_SERVER_ERROR;
+        }
+        else {
+            sink->offset += pkt->payload_len;
+            resp_code = (block1.more == 1) ? COAP_CODE_CONTINUE : code;
+        }
+    }
+
+    if (has_block && ((resp_code >> 5) == COAP_CLASS_SUCCESS)) {
+        /* also tells the client our preferred block size */
+        unsigned szx = block1.szx;
+        if (szx > CONFIG_NANOCOAP_BLOCK_SIZE_EXP_MAX - 4) {
+            szx = CONFIG_NANOCOAP_BLOCK_SIZE_EXP_MAX - 4;
+        }
+        if (payload_start + 4 > buf + len) {
+            return -ENOSPC;
+        }
+        bufpos += coap_put_option_block1(bufpos, 0, block1.blknum, szx,
+                                         block1.more == 1);
+    }
+
+    return coap_build_reply(pkt, resp_code, buf, len, bufpos - payload_start);
+}
+
+#ifdef MODULE_VFS
+ssize_t coap_block_read_vfs(void *arg, size_t offset, uint8_t *buf,
+                            size_t len)
+{
+    int fd = *(int *)arg;
+    off_t pos = vfs_lseek(fd, offset, SEEK_SET);
+
+    if (pos < 0) {
+        return pos;
+    }
+    for (size_t done = 0; done < len;) {
+        ssize_t res = vfs_read(fd, buf + done, len - done);
+        if (res <= 0) {
+            return (res < 0) ? res : -EIO;
+        }
+        done += res;
+    }
+    return len;
+}
+#endif
+
+#ifdef MODULE_MTD
+ssize_t coap_block_read_mtd(void *arg, size_t offset, uint8_t *buf,
+                            size_t len)
+{
+    coap_block_mtd_t *region = arg;
+    int res = mtd_read(region->dev, buf, region->addr + offset, len);
+
+    return (res < 0) ? res : (ssize_t)len;
+}
+#endif
@@ -0,0 +1,502 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     net_nanocoap_cache
+ * @{
+ *
+ * @file
+ * @brief       Implementation of the nanocoap response cache
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <strings.h>
+
+#include "hashes/sha256.h"
+#include "net/nanocoap_cache.h"
+#include "xtimer.h"
+
+#define ENABLE_DEBUG (0)
+#include "debug.h"
+
+static nanocoap_cache_entry_t _cache_entries[CONFIG_NANOCOAP_CACHE_ENTRIES];
+
+/* entries in use, least recently used first */
+static clist_node_t _cache_list_head = { NULL };
+static clist_node_t _empty_list_head = { NULL };
+
+void nanocoap_cache_init(void)
+{
+    _cache_list_head.next = NULL;
+    _empty_list_head.next = NULL;
+    memset(_cache_entries, 0, sizeof(_cache_entries));
+    for (unsigned i = 0; i < CONFIG_NANOCOAP_CACHE_ENTRIES; i++) {
+        clist_rpush(&_empty_list_head, &_cache_entries[i].node);
+    }
+}
+
+uint32_t nanocoap_cache_now(void)
+{
+    return (uint32_t)(xtimer_now_usec64() / US_PER_SEC);
+}
+
+/* Options not used to tell requests apart, see RFC 7252, section 5.4.6 */
+static bool _is_cache_key(unsigned opt_num)
+{
+    if ((opt_num & 0x1e) == 0x1c) {
+        /* NoCacheKey */
+        return false;
+    }
+    switch (opt_num) {
+    case COAP_OPT_IF_MATCH:
+    case COAP_OPT_ETAG:
+    case COAP_OPT_IF_NONE_MATCH:
+    case COAP_OPT_OBSERVE:
+        return false;
+    default:
+        return true;
+    }
+}
+
+static void _hash_lower(sha256_context_t *ctx, const uint8_t *str, size_t len)
+{
+    uint8_t chunk[16];
+
+    while (len) {
+        size_t n = (len < sizeof(chunk)) ? len : sizeof(chunk);
+        for (size_t i = 0; i < n; i++) {
+            chunk[i] = ((str[i] >= 'A') && (str[i] <= 'Z')) ? str[i] + ('a' - 'A')
+                                                             : str[i];
+        }
+        sha256_update(ctx, chunk, n);
+        str += n;
+        len -= n;
+    }
+}
+
+/*
+ * Hashes a Proxy-Uri with case insensitive scheme and host, and without the
+ * default port or an empty path or query.
+ */
+static void _hash_proxy_uri(sha256_context_t *ctx, const uint8_t *uri,
+                            size_t len)
+{
+    const uint8_t *end = uri + len;
+    const uint8_t *host = NULL;
+
+    for (const uint8_t *pos = uri; pos + 3 <= end; pos++) {
+        if (!memcmp(pos, "://", 3)) {
+            host = pos + 3;
+            break;
+        }
+    }
+    if (host == NULL) {
+        sha256_update(ctx, uri, len);
+        return;
+    }
+    _hash_lower(ctx, uri, host - uri);
+
+    const uint8_t *path = host;
+    while ((path < end) && (*path != '/') && (*path != '?')) {
+        path++;
+    }
+    const uint8_t *host_end = path;
+    for (const uint8_t *pos = path; pos > host; pos--) {
+        if (pos[-1] == ']') {
+            break;
+        }
+        if (pos[-1] == ':') {
+            if ((path - pos == 4) && !memcmp(pos, "5683", 4) &&
+                (host - uri == 7) && !strncasecmp((const char *)uri, "coap", 4)) {
+                host_end = pos - 1;
+            }
+            break;
+        }
+    }
+    _hash_lower(ctx, host, host_end - host);
+
+    if ((path < end) && (end[-1] == '?')) {
+        end--;
+    }
+    if ((end - path == 1) && (*path == '/')) {
+        end--;
+    }
+    sha256_update(ctx, path, end - path);
+}
+
+/* Options identifying the target resource, see RFC 7252, section 6.5 */
+static bool _is_uri(unsigned opt_num)
+{
+    switch (opt_num) {
+    case COAP_OPT_URI_HOST:
+    case COAP_OPT_URI_PORT:
+    case COAP_OPT_URI_PATH:
+    case COAP_OPT_URI_QUERY:
+    case COAP_OPT_PROXY_URI:
+    case COAP_OPT_PROXY_SCHEME:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void _key_generate(const coap_pkt_t *req, uint8_t *key, bool uri_only)
+{
+    sha256_context_t ctx;
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    coap_optpos_t opt = { 0, 0 };
+    uint8_t *value;
+    ssize_t optlen;
+
+    sha256_init(&ctx);
+    for (bool init = true; (optlen = coap_opt_get_next(req, &opt, &value, init)) >= 0;
+         init = false) {
+        if (uri_only ? !_is_uri(opt.opt_num) : !_is_cache_key(opt.opt_num)) {
+            continue;
+        }
+        uint16_t tag[2] = { opt.opt_num, (uint16_t)optlen };
+        if (opt.opt_num == COAP_OPT_PROXY_URI) {
+            /* length changes with normalisation */
+            tag[1] = 0;
+            sha256_update(&ctx, tag, sizeof(tag));
+            _hash_proxy_uri(&ctx, value, optlen);
+            sha256_update(&ctx, "", 1);
+        }
+        else {
+            sha256_update(&ctx, tag, sizeof(tag));
+            sha256_update(&ctx, value, optlen);
+        }
+    }
+    if (!uri_only && (req->hdr->code == COAP_METHOD_FETCH) && req->payload_len) {
+        sha256_update(&ctx, "\xff", 1);
+        sha256_update(&ctx, req->payload, req->payload_len);
+    }
+    sha256_final(&ctx, digest);
+    memcpy(key, digest, CONFIG_NANOCOAP_CACHE_KEY_LENGTH);
+}
+
+void nanocoap_cache_key_generate(const coap_pkt_t *req, uint8_t *cache_key)
+{
+    _key_generate(req, cache_key, false);
+}
+
+void nanocoap_cache_uri_key_generate(const coap_pkt_t *req, uint8_t *uri_key)
+{
+    _key_generate(req, uri_key, true);
+}
+
+static int _cmp_key(clist_node_t *node, void *arg)
+{
+    nanocoap_cache_entry_t *ce = (nanocoap_cache_entry_t *)node;
+
+    return !memcmp(ce->cache_key, arg, CONFIG_NANOCOAP_CACHE_KEY_LENGTH);
+}
+
+static nanocoap_cache_entry_t *_find(const uint8_t *cache_key)
+{
+    return (nanocoap_cache_entry_t *)clist_foreach(&_cache_list_head, _cmp_key,
+                                                   (void *)cache_key);
+}
+
+nanocoap_cache_entry_t *nanocoap_cache_key_lookup(const uint8_t *cache_key)
+{
+    nanocoap_cache_entry_t *ce = _find(cache_key);
+
+    if (ce) {
+        /* mark as most recently used */
+        clist_remove(&_cache_list_head, &ce->node);
+        clist_rpush(&_cache_list_head, &ce->node);
+    }
+    return ce;
+}
+
+nanocoap_cache_entry_t *nanocoap_cache_request_lookup(const coap_pkt_t *req)
+{
+    uint8_t cache_key[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+
+    nanocoap_cache_key_generate(req, cache_key);
+    nanocoap_cache_entry_t *ce = nanocoap_cache_key_lookup(cache_key);
+    if (ce && (ce->request_method != req->hdr->code)) {
+        return NULL;
+    }
+    return ce;
+}
+
+static uint32_t _max_age(const coap_pkt_t *resp)
+{
+    uint32_t max_age = COAP_MAX_AGE_DEFAULT;
+
+    coap_opt_get_uint(resp, COAP_OPT_MAX_AGE, &max_age);
+    return max_age;
+}
+
+nanocoap_cache_entry_t *nanocoap_cache_add_by_key(const uint8_t *cache_key,
+                                                  const uint8_t *uri_key,
+                                                  unsigned request_method,
+                                                  const coap_pkt_t *resp,
+                                                  size_t resp_len)
+{
+    nanocoap_cache_entry_t *ce = _find(cache_key);
+    uint32_t max_age = _max_age(resp);
+
+    if ((max_age == 0) || (resp_len > CONFIG_NANOCOAP_CACHE_RESPONSE_SIZE)) {
+        /* the previous response must not be used any longer either */
+        if (ce) {
+            nanocoap_cache_del(ce);
+        }
+        DEBUG("nanocoap_cache: not caching response\n");
+        return NULL;
+    }
+
+    if (ce) {
+        clist_remove(&_cache_list_head, &ce->node);
+    }
+    else {
+        ce = (nanocoap_cache_entry_t *)clist_lpop(&_empty_list_head);
+    }
+    if (ce == NULL) {
+        ce = (nanocoap_cache_entry_t *)clist_lpop(&_cache_list_head);
+        DEBUG("nanocoap_cache: replacing least recently used entry\n");
+    }
+
+    memcpy(ce->cache_key, cache_key, CONFIG_NANOCOAP_CACHE_KEY_LENGTH);
+    memcpy(ce->uri_key, uri_key, CONFIG_NANOCOAP_CACHE_KEY_LENGTH);
+    memcpy(ce->response_buf, resp->hdr, resp_len);
+    ce->response_len = resp_len;
+    ce->request_method = request_method;
+    ce->max_age = nanocoap_cache_now() + max_age;
+
+    uint8_t *etag;
+    ssize_t etag_len = coap_opt_get_opaque(resp, COAP_OPT_ETAG, &etag);
+    if ((etag_len > 0) && (etag_len <= (ssize_t)COAP_ETAG_LENGTH_MAX)) {
+        memcpy(ce->etag, etag, etag_len);
+        ce->etag_len = etag_len;
+    }
+    else {
+        ce->etag_len = 0;
+    }
+
+    clist_rpush(&_cache_list_head, &ce->node);
+    return ce;
+}
+
+nanocoap_cache_entry_t *nanocoap_cache_add_by_req(const coap_pkt_t *req,
+                                                  const coap_pkt_t *resp,
+                                                  size_t resp_len)
+{
+    uint8_t cache_key[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+    uint8_t uri_key[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+
+    nanocoap_cache_key_generate(req, cache_key);
+    nanocoap_cache_uri_key_generate(req, uri_key);
+    return nanocoap_cache_add_by_key(cache_key, uri_key, req->hdr->code, resp,
+                                     resp_len);
+}
+
+/* Codes cacheable by default, see RFC 7252, section 5.9 */
+static bool _is_cacheable(unsigned code)
+{
+    unsigned cls = code >> 5;
+
+    return (code == COAP_CODE_CONTENT) || (cls == COAP_CLASS_CLIENT_FAILURE) ||
+           (cls == COAP_CLASS_SERVER_FAILURE);
+}
+
+size_t nanocoap_cache_invalidate(const uint8_t *uri_key)
+{
+    size_t removed = 0;
+
+    /* entries are moved to the empty list, so walk a fixed number of times */
+    for (size_t n = clist_count(&_cache_list_head); n; n--) {
+        nanocoap_cache_entry_t *ce =
+            (nanocoap_cache_entry_t *)clist_lpop(&_cache_list_head);
+        if (!memcmp(ce->uri_key, uri_key, CONFIG_NANOCOAP_CACHE_KEY_LENGTH)) {
+            clist_rpush(&_empty_list_head, &ce->node);
+            removed++;
+        }
+        else {
+            /* keeps the order of last use */
+            clist_rpush(&_cache_list_head, &ce->node);
+        }
+    }
+    return removed;
+}
+
+int nanocoap_cache_process(const uint8_t *cache_key, const uint8_t *uri_key,
+                           unsigned request_method,
+                           const coap_pkt_t *resp, size_t resp_len)
+{
+    nanocoap_cache_entry_t *ce = _find(cache_key);
+    unsigned code = resp->hdr->code;
+
+    if ((request_method != COAP_METHOD_GET) &&
+        (request_method != COAP_METHOD_FETCH)) {
+        if ((code >> 5) == COAP_CLASS_SUCCESS) {
+            nanocoap_cache_invalidate(uri_key);
+            ce = NULL;
+        }
+    }
+    else if (code == COAP_CODE_VALID) {
+        if (ce && (ce->request_method != request_method)) {
+            ce = NULL;
+        }
+        if (ce) {
+            uint8_t *etag;
+            ssize_t etag_len = coap_opt_get_opaque(resp, COAP_OPT_ETAG, &etag);
+            if ((etag_len >= 0) && ((etag_len != ce->etag_len) ||
+                                    memcmp(etag, ce->etag, etag_len))) {
+                /* validated a different representation */
+                nanocoap_cache_del(ce);
+                ce = NULL;
+            }
+            else {
+                ce->max_age = nanocoap_cache_now() + _max_age(resp);
+            }
+        }
+    }
+    else if (_is_cacheable(code)) {
+        ce = nanocoap_cache_add_by_key(cache_key, uri_key, request_method,
+                                       resp, resp_len);
+    }
+
+    if ((ce == NULL) || nanocoap_cache_entry_is_stale(ce, nanocoap_cache_now())) {
+        return -ENOENT;
+    }
+    return 0;
+}
+
+int nanocoap_cache_del(const nanocoap_cache_entry_t *ce)
+{
+    nanocoap_cache_entry_t *entry = (nanocoap_cache_entry_t *)ce;
+
+    if (clist_remove(&_cache_list_head, &entry->node) == NULL) {
+        return -ENOENT;
+    }
+    clist_rpush(&_empty_list_head, &entry->node);
+    return 0;
+}
+
+bool nanocoap_cache_etag_match(const nanocoap_cache_entry_t *ce,
+                               const coap_pkt_t *req)
+{
+    coap_optpos_t opt = { 0, 0 };
+    uint8_t *value;
+    ssize_t optlen;
+
+    if (ce->etag_len == 0) {
+        return false;
+    }
+    for (bool init = true; (optlen = coap_opt_get_next(req, &opt, &value, init)) >= 0;
+         init = false) {
+        if ((opt.opt_num == COAP_OPT_ETAG) && (optlen == ce->etag_len) &&
+            !memcmp(value, ce->etag, optlen)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+ssize_t nanocoap_cache_build_pdu(const nanocoap_cache_entry_t *ce,
+                                 unsigned type, uint16_t id,
+                                 const uint8_t *token, size_t token_len,
+                                 bool valid, uint8_t *buf, size_t len)
+{
+    coap_pkt_t cached;
+    uint8_t tkn[COAP_TOKEN_LENGTH_MAX];
+    uint32_t now = nanocoap_cache_now();
+    uint32_t max_age = nanocoap_cache_entry_is_stale(ce, now) ? 0 : ce->max_age - now;
+
+    if (token_len > sizeof(tkn)) {
+        return -EINVAL;
+    }
+    if (len < sizeof(coap_hdr_t) + token_len) {
+        return -ENOSPC;
+    }
+    /* coap_parse() does not modify the buffer */
+    if (coap_parse(&cached, (uint8_t *)ce->response_buf, ce->response_len) < 0) {
+        return -EINVAL;
+    }
+
+    /* the token may be part of buf */
+    if (token_len) {
+        memcpy(tkn, token, token_len);
+    }
+    uint8_t *pos = buf + coap_build_hdr((coap_hdr_t *)buf, type, tkn, token_len,
+                                        valid ? COAP_CODE_VALID : cached.hdr->code,
+                                        id);
+    uint8_t *end = buf + len;
+
+    /* copy options, replacing Max-Age with the remaining time */
+    coap_optpos_t opt = { 0, 0 };
+    uint8_t *value;
+    ssize_t optlen;
+    uint16_t lastonum = 0;
+    bool max_age_done = false;
+
+    for (bool init = true; (optlen = coap_opt_get_next(&cached, &opt, &value, init)) >= 0;
+         init = false) {
+        if (!max_age_done && (opt.opt_num >= COAP_OPT_MAX_AGE)) {
+            if (end - pos < 6) {
+                return -ENOSPC;
+            }
+            pos += coap_opt_put_uint(pos, lastonum, COAP_OPT_MAX_AGE, max_age);
+            lastonum = COAP_OPT_MAX_AGE;
+            max_age_done = true;
+        }
+        if ((opt.opt_num == COAP_OPT_MAX_AGE) ||
+            (valid && (opt.opt_num != COAP_OPT_ETAG))) {
+            continue;
+        }
+        /* option header takes up to 5 bytes */
+        if (end - pos < optlen + 5) {
+            return -ENOSPC;
+        }
+        pos += coap_put_option(pos, lastonum, opt.opt_num, value, optlen);
+        lastonum = opt.opt_num;
+    }
+    if (!max_age_done) {
+        if (end - pos < 6) {
+            return -ENOSPC;
+        }
+        pos += coap_opt_put_uint(pos, lastonum, COAP_OPT_MAX_AGE, max_age);
+    }
+
+    if (!valid && cached.payload_len) {
+        if (end - pos < cached.payload_len + 1) {
+            return -ENOSPC;
+        }
+        *pos++ = 0xff;
+        memcpy(pos, cached.payload, cached.payload_len);
+        pos += cached.payload_len;
+    }
+    return pos - buf;
+}
+
+ssize_t nanocoap_cache_build_reply(const nanocoap_cache_entry_t *ce,
+                                   coap_pkt_t *req, uint8_t *buf, size_t len)
+{
+    unsigned type = (coap_get_type(req) == COAP_TYPE_CON) ? COAP_TYPE_ACK
+                                                          : COAP_TYPE_NON;
+
+    return nanocoap_cache_build_pdu(ce, type, coap_get_id(req), req->token,
+                                    coap_get_token_len(req),
+                                    nanocoap_cache_etag_match(ce, req), buf, len);
+}
+
+size_t nanocoap_cache_used_count(void)
+{
+    return clist_count(&_cache_list_head);
+}
+
+size_t nanocoap_cache_free_count(void)
+{
+    return clist_count(&_empty_list_head);
+}
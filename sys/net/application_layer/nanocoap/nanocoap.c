@@ -90,6 +90,9 @@ int coap_parse(coap_pkt_t *pkt, uint8_t *buf, size_t len)
     coap_optpos_t *optpos = pkt->options;
     unsigned option_count = 0;
     unsigned option_nr = 0;
+#ifdef MODULE_NANOCOAP_OPT_INDEX
+    pkt->opt_mask = 0;
+#endif
 
     /* parse options */
     while (pkt_pos != pkt_end) {
@@ -123,6 +126,11 @@ int coap_parse(coap_pkt_t *pkt, uint8_t *buf, size_t len)
 
                 optpos->opt_num = option_nr;
                 optpos->offset = (uintptr_t)option_start - (uintptr_t)hdr;
+#ifdef MODULE_NANOCOAP_OPT_INDEX
+                if (option_nr < 32) {
+                    pkt->opt_mask |= (uint32_t)1 << option_nr;
+                }
+#endif
                 DEBUG("optpos option_nr=%u %u\n", (unsigned)option_nr, (unsigned)optpos->offset);
                 optpos++;
                 option_count++;
@@ -176,9 +184,28 @@ uint8_t *coap_find_option(const coap_pkt_t *pkt, unsigned opt_num)
     const coap_optpos_t *optpos = pkt->options;
     unsigned opt_count = pkt->options_len;
 
+#ifdef MODULE_NANOCOAP_OPT_INDEX
+    /* pkt->options is sorted and holds one entry per option number, so the
+     * lower option numbers present give the index */
+    if (opt_num < 32) {
+        uint32_t bit = (uint32_t)1 << opt_num;
+        if (!(pkt->opt_mask & bit)) {
+            return NULL;
+        }
+        optpos += bitarithm_bits_set_u32(pkt->opt_mask & (bit - 1));
+        return (uint8_t*)pkt->hdr + optpos->offset;
+    }
+    unsigned skip = bitarithm_bits_set_u32(pkt->opt_mask);
+    optpos += skip;
+    opt_count -= skip;
+#endif
+
     while (opt_count--) {
-        if (optpos->opt_num == opt_num) {
-            return (uint8_t*)pkt->hdr + optpos->offset;
+        if (optpos->opt_num >= opt_num) {
+            if (optpos->opt_num == opt_num) {
+                return (uint8_t*)pkt->hdr + optpos->offset;
+            }
+            break;
         }
         optpos++;
     }
@@ -787,36 +814,81 @@ size_t coap_opt_put_uint(uint8_t *buf, uint16_t lastonum, uint16_t onum,
     return coap_put_option(buf, lastonum, onum, (uint8_t *)&value, uint_len);
 }
 
+/* Writes an option header without value, returns its length */
+static size_t _put_opt_hdr(uint8_t *buf, unsigned delta, size_t olen)
+{
+    *buf = 0;
+    return _put_delta_optlen(buf, _put_delta_optlen(buf, 1, 4, delta), 0, olen);
+}
+
 /* Common functionality for addition of an option */
 static ssize_t _add_opt_pkt(coap_pkt_t *pkt, uint16_t optnum, const uint8_t *val,
                             size_t val_len)
 {
-    if (pkt->options_len >= CONFIG_NANOCOAP_NOPTS_MAX) {
-        return -ENOSPC;
+    /* insert behind all options with a number up to optnum */
+    unsigned idx = pkt->options_len;
+    while (idx && (pkt->options[idx - 1].opt_num > optnum)) {
+        idx--;
     }
+    uint16_t lastonum = idx ? pkt->options[idx - 1].opt_num : 0;
+    bool new_num = !idx || (lastonum != optnum);
 
-    uint16_t lastonum = (pkt->options_len)
-            ? pkt->options[pkt->options_len - 1].opt_num : 0;
-    assert(optnum >= lastonum);
+    if (new_num && (pkt->options_len >= CONFIG_NANOCOAP_NOPTS_MAX)) {
+        return -ENOSPC;
+    }
 
     /* calculate option length */
-    uint8_t dummy[3] = { 0 };
-    size_t optlen = _put_delta_optlen(dummy, 1, 4, optnum - lastonum);
-    optlen += _put_delta_optlen(dummy, 0, 0, val_len);
-    optlen += val_len;
-    if (pkt->payload_len < optlen) {
+    uint8_t opt_hdr[5];
+    size_t optlen = _put_opt_hdr(opt_hdr, optnum - lastonum, val_len) + val_len;
+    uint8_t *pos = pkt->payload;
+    size_t next_hdr_len = 0;
+    size_t old_hdr_len = 0;
+
+    if (idx < pkt->options_len) {
+        /* the delta of the following option becomes smaller */
+        pos = (uint8_t *)pkt->hdr + pkt->options[idx].offset;
+        uint8_t *end = pos + 1;
+        int delta = _decode_value(*pos >> 4, &end, pkt->payload);
+        int len = _decode_value(*pos & 0xf, &end, pkt->payload);
+        assert((delta >= 0) && (len >= 0));
+        old_hdr_len = end - pos;
+        next_hdr_len = _put_opt_hdr(opt_hdr, lastonum + delta - optnum, len);
+    }
+
+    /* cannot get negative, the deltas add up to the old one */
+    size_t growth = optlen + next_hdr_len - old_hdr_len;
+    if (pkt->payload_len < growth) {
         return -ENOSPC;
     }
 
-    coap_put_option(pkt->payload, lastonum, optnum, val, val_len);
-
-    pkt->options[pkt->options_len].opt_num = optnum;
-    pkt->options[pkt->options_len].offset = pkt->payload - (uint8_t *)pkt->hdr;
-    pkt->options_len++;
-    pkt->payload += optlen;
-    pkt->payload_len -= optlen;
+    if (idx < pkt->options_len) {
+        memmove(pos + optlen + next_hdr_len, pos + old_hdr_len,
+                pkt->payload - (pos + old_hdr_len));
+        memcpy(pos + optlen, opt_hdr, next_hdr_len);
+        /* only the options behind the rewritten header move by growth */
+        pkt->options[idx].offset += optlen;
+        for (unsigned i = idx + 1; i < pkt->options_len; i++) {
+            pkt->options[i].offset += growth;
+        }
+    }
+    coap_put_option(pos, lastonum, optnum, val, val_len);
+
+    if (new_num) {
+        memmove(&pkt->options[idx + 1], &pkt->options[idx],
+                (pkt->options_len - idx) * sizeof(pkt->options[0]));
+        pkt->options[idx].opt_num = optnum;
+        pkt->options[idx].offset = pos - (uint8_t *)pkt->hdr;
+        pkt->options_len++;
+#ifdef MODULE_NANOCOAP_OPT_INDEX
+        if (optnum < 32) {
+            pkt->opt_mask |= (uint32_t)1 << optnum;
+        }
+#endif
+    }
+    pkt->payload += growth;
+    pkt->payload_len -= growth;
 
-    return optlen;
+    return growth;
 }
 
 ssize_t coap_opt_add_chars(coap_pkt_t *pkt, uint16_t optnum, const char *chars,
@@ -906,9 +978,12 @@ ssize_t coap_opt_add_uint(coap_pkt_t *pkt, uint16_t optnum, uint32_t value)
 ssize_t coap_opt_add_block(coap_pkt_t *pkt, coap_block_slicer_t *slicer,
                            bool more, uint16_t option)
 {
-    slicer->opt = pkt->payload;
+    ssize_t res = coap_opt_add_uint(pkt, option, _slicer2blkopt(slicer, more));
+
+    /* may have been inserted in front of other options */
+    slicer->opt = coap_find_option(pkt, option);
 
-    return coap_opt_add_uint(pkt, option, _slicer2blkopt(slicer, more));
+    return res;
 }
 
 ssize_t coap_opt_add_proxy_uri(coap_pkt_t *pkt, const char *uri)
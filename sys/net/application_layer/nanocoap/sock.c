@@ -26,6 +26,7 @@
 
 #include "net/nanocoap_sock.h"
 #include "net/sock/udp.h"
+#include "xtimer.h"
 
 #define ENABLE_DEBUG (0)
 #include "debug.h"
@@ -118,6 +119,207 @@ ssize_t nanocoap_get(sock_udp_ep_t *remote, const char *path, uint8_t *buf, size
     return res;
 }
 
+/* State of a block request in the window */
+enum {
+    _BLK_FREE,
+    _BLK_WAIT,                  /* request sent */
+    _BLK_DONE,                  /* payload stored */
+    _BLK_ERROR,                 /* error response */
+};
+
+typedef struct {
+    uint32_t deadline;
+    uint32_t timeout;
+    uint16_t len;               /* stored payload length, or response code */
+    uint8_t tries_left;
+    uint8_t state;
+    int8_t more;
+} _blk_t;
+
+static ssize_t _send_block_req(sock_udp_t *sock, uint8_t *buf, const char *path,
+                               uint32_t num, unsigned szx)
+{
+    uint8_t *pktpos = buf;
+
+    /* the message ID is the block number */
+    pktpos += coap_build_hdr((coap_hdr_t *)buf, COAP_TYPE_CON, NULL, 0,
+                             COAP_METHOD_GET, num);
+    pktpos += coap_opt_put_uri_path(pktpos, 0, path);
+    pktpos += coap_opt_put_uint(pktpos, COAP_OPT_URI_PATH, COAP_OPT_BLOCK2,
+                                (num << 4) | szx);
+
+    return sock_udp_send(sock, buf, pktpos - buf, NULL);
+}
+
+static unsigned _window(size_t len, size_t rx_len, unsigned szx)
+{
+    size_t window = 1 + (len - rx_len) / coap_szx2size(szx);
+
+    return (window > CONFIG_NANOCOAP_BLOCKWISE_WINDOW_MAX)
+           ? CONFIG_NANOCOAP_BLOCKWISE_WINDOW_MAX : window;
+}
+
+int nanocoap_get_blockwise(sock_udp_t *sock, const char *path,
+                           coap_blksize_t blksize, uint8_t *buf, size_t len,
+                           coap_blockwise_cb_t callback, void *arg)
+{
+    _blk_t blks[CONFIG_NANOCOAP_BLOCKWISE_WINDOW_MAX];
+    size_t rx_len = CONFIG_NANOCOAP_BLOCK_HEADER_MAX + coap_szx2size(blksize);
+    uint8_t *store = buf + rx_len;
+    unsigned szx = blksize;
+    unsigned window = 1;        /* until the block size is negotiated */
+    uint32_t next = 0;          /* next block to pass to callback */
+    uint32_t req = 0;           /* next block to request */
+    uint32_t last = UINT32_MAX; /* last block, once known */
+
+    if (len < rx_len) {
+        return -ENOBUFS;
+    }
+    memset(blks, 0, sizeof(blks));
+
+    while (next <= last) {
+        /* fill the window */
+        for (; (req < next + window) && (req <= last); req++) {
+            _blk_t *blk = &blks[req % window];
+            ssize_t res = _send_block_req(sock, buf, path, req, szx);
+            if (res <= 0) {
+                DEBUG("nanocoap: error sending block request, %d\n", (int)res);
+                return (res < 0) ? res : -EIO;
+            }
+            blk->state = _BLK_WAIT;
+            blk->timeout = CONFIG_COAP_ACK_TIMEOUT * US_PER_SEC;
+            blk->tries_left = CONFIG_COAP_MAX_RETRANSMIT;
+            blk->deadline = xtimer_now_usec() + blk->timeout;
+        }
+
+        /* wait for a response until the first retransmission is due; the
+         * requests past the last block are given up */
+        uint32_t now = xtimer_now_usec();
+        uint32_t timeout = UINT32_MAX;
+        for (uint32_t num = next; (num < req) && (num <= last); num++) {
+            _blk_t *blk = &blks[num % window];
+            if (blk->state == _BLK_WAIT) {
+                int32_t left = (int32_t)(blk->deadline - now);
+                if (left < 0) {
+                    left = 0;
+                }
+                if ((uint32_t)left < timeout) {
+                    timeout = left;
+                }
+            }
+        }
+
+        ssize_t res = sock_udp_recv(sock, buf, rx_len, timeout, NULL);
+        if ((res == -ETIMEDOUT) || (res == -EAGAIN)) {
+            now = xtimer_now_usec();
+            for (uint32_t num = next; (num < req) && (num <= last); num++) {
+                _blk_t *blk = &blks[num % window];
+                if ((blk->state != _BLK_WAIT) ||
+                    ((int32_t)(blk->deadline - now) > 0)) {
+                    continue;
+                }
+                if (!blk->tries_left) {
+                    DEBUG("nanocoap: maximum retries reached\n");
+                    return -ETIMEDOUT;
+                }
+                blk->tries_left--;
+                blk->timeout *= 2;
+                blk->deadline = now + blk->timeout;
+                res = _send_block_req(sock, buf, path, num, szx);
+                if (res <= 0) {
+                    return (res < 0) ? res : -EIO;
+                }
+            }
+            continue;
+        }
+        if (res <= 0) {
+            DEBUG("nanocoap: error receiving coap response, %d\n", (int)res);
+            return (res < 0) ? res : -EIO;
+        }
+
+        coap_pkt_t pkt;
+        if (coap_parse(&pkt, buf, res) < 0) {
+            DEBUG("nanocoap: error parsing packet\n");
+            continue;
+        }
+        if (coap_get_code_raw(&pkt) == COAP_CODE_EMPTY) {
+            /* separate responses are not supported, wait for a retransmission */
+            continue;
+        }
+
+        /* find the request, ignoring duplicates */
+        uint32_t num = next + (uint16_t)(coap_get_id(&pkt) - (uint16_t)next);
+        if ((num >= req) || (blks[num % window].state != _BLK_WAIT)) {
+            continue;
+        }
+        _blk_t *blk = &blks[num % window];
+
+        if (coap_get_code_raw(&pkt) != COAP_CODE_CONTENT) {
+            blk->state = _BLK_ERROR;
+            blk->len = coap_get_code(&pkt);
+        }
+        else {
+            coap_block1_t block2;
+            if (!coap_get_block2(&pkt, &block2)) {
+                /* the server does not support block-wise transfers */
+                block2.blknum = 0;
+                block2.szx = szx;
+                block2.more = 0;
+            }
+            if ((num == 0) && (block2.szx < szx)) {
+                szx = block2.szx;
+            }
+            if ((block2.blknum != num) || (block2.szx != szx) ||
+                (pkt.payload_len > rx_len - CONFIG_NANOCOAP_BLOCK_HEADER_MAX) ||
+                (block2.more && (pkt.payload_len != coap_szx2size(szx)))) {
+                DEBUG("nanocoap: unexpected block\n");
+                return -EBADMSG;
+            }
+            if (!block2.more) {
+                last = num;
+            }
+            if (num == next) {
+                if (callback(arg, (size_t)num << (szx + 4), pkt.payload,
+                             pkt.payload_len, block2.more)) {
+                    return -ECANCELED;
+                }
+                blk->state = _BLK_FREE;
+                next++;
+            }
+            else {
+                memcpy(store + (num % (window - 1)) * coap_szx2size(szx),
+                       pkt.payload, pkt.payload_len);
+                blk->state = _BLK_DONE;
+                blk->len = pkt.payload_len;
+                blk->more = block2.more;
+            }
+        }
+
+        /* pass on the blocks received out of order */
+        for (; next < req; next++) {
+            blk = &blks[next % window];
+            if ((blk->state == _BLK_ERROR) && (next <= last)) {
+                return -blk->len;
+            }
+            if (blk->state != _BLK_DONE) {
+                break;
+            }
+            if (callback(arg, (size_t)next << (szx + 4),
+                         store + (next % (window - 1)) * coap_szx2size(szx),
+                         blk->len, blk->more)) {
+                return -ECANCELED;
+            }
+            blk->state = _BLK_FREE;
+        }
+
+        if ((next == 1) && (window == 1)) {
+            window = _window(len, rx_len, szx);
+        }
+    }
+
+    return 0;
+}
+
 int nanocoap_server(sock_udp_ep_t *local, uint8_t *buf, size_t bufsize)
 {
     sock_udp_t sock;
@@ -29,9 +29,125 @@
 #define ENABLE_DEBUG    (0)
 #include "debug.h"
 
-static sock_udp_t _sntp_sock;
 static int64_t _sntp_offset = 0;
 static mutex_t _sntp_mutex = MUTEX_INIT;
+
+static void _init_packet(ntp_packet_t *packet)
+{
+    memset(packet, 0, sizeof(*packet));
+    ntp_packet_set_vn(packet);
+    ntp_packet_set_mode(packet, NTP_MODE_CLIENT);
+}
+
+static void _set_offset(const ntp_packet_t *packet)
+{
+    mutex_lock(&_sntp_mutex);
+    _sntp_offset = (((int64_t)byteorder_ntohl(packet->transmit.seconds)) * US_PER_SEC) +
+                   ((((int64_t)byteorder_ntohl(packet->transmit.fraction)) * 232)
+                   / 1000000) - xtimer_now_usec64();
+    mutex_unlock(&_sntp_mutex);
+}
+
+#ifdef MODULE_SNTP_ASYNC
+static void _sock_cb(sock_udp_t *sock, sock_async_flags_t type, void *arg)
+{
+    (void)sock;
+    if (type & SOCK_ASYNC_MSG_RECV) {
+        coro_wake(arg);
+    }
+}
+
+/* closes the sock of a coroutine and drops its event if it is still queued:
+ * the memory of the sock may be released once the coroutine is done. The
+ * event is cancelled after closing, so nothing can post it again. */
+static void _sock_close(sock_udp_t *sock, event_queue_t *queue)
+{
+    sock_udp_close(sock);
+    event_cancel(queue, &sock_udp_get_async_ctx(sock)->event.super);
+}
+
+static coro_state_t _sync_coro(coro_t *coro)
+{
+    sntp_request_t *req = container_of(coro, sntp_request_t, coro);
+
+    CORO_BEGIN(coro);
+    if ((req->res = sock_udp_create(&req->sock, NULL, req->server, 0)) < 0) {
+        DEBUG("Error creating UDP sock\n");
+        CORO_EXIT(coro);
+    }
+    sock_udp_event_init(&req->sock, coro->queue, _sock_cb, coro);
+
+    _init_packet(&req->packet);
+    if ((req->res = (int)sock_udp_send(&req->sock, &req->packet,
+                                       sizeof(req->packet), NULL)) < 0) {
+        DEBUG("Error sending message\n");
+        _sock_close(&req->sock, coro->queue);
+        CORO_EXIT(coro);
+    }
+
+    coro_set_timeout(coro, req->timeout);
+    while (1) {
+        CORO_WAIT(coro);
+        req->res = (int)sock_udp_recv(&req->sock, &req->packet,
+                                      sizeof(req->packet), 0, NULL);
+        if (req->res != -EAGAIN) {
+            break;
+        }
+        if (coro_timed_out(coro)) {
+            req->res = -ETIMEDOUT;
+            break;
+        }
+    }
+    _sock_close(&req->sock, coro->queue);
+
+    if (req->res < 0) {
+        DEBUG("Error receiving message\n");
+        CORO_EXIT(coro);
+    }
+    _set_offset(&req->packet);
+    req->res = 0;
+    CORO_END(coro);
+}
+
+static void _sync_done(coro_t *coro)
+{
+    sntp_request_t *req = container_of(coro, sntp_request_t, coro);
+
+    if (req->cb) {
+        req->cb(req, req->res, req->arg);
+    }
+}
+
+static void _request_init(sntp_request_t *req, sock_udp_ep_t *server,
+                          uint32_t timeout)
+{
+    coro_init(&req->coro, _sync_coro, _sync_done);
+    req->server = server;
+    req->timeout = timeout;
+}
+
+void sntp_sync_async(sntp_request_t *req, sock_udp_ep_t *server,
+                     uint32_t timeout, event_queue_t *queue,
+                     sntp_cb_t cb, void *arg)
+{
+    _request_init(req, server, timeout);
+    req->cb = cb;
+    req->arg = arg;
+    coro_start(&req->coro, queue);
+}
+
+int sntp_sync(sock_udp_ep_t *server, uint32_t timeout)
+{
+    /* not static: sntp_sync() may be called from several threads */
+    sntp_request_t req;
+
+    _request_init(&req, server, timeout);
+    req.cb = NULL;
+    coro_run(&req.coro);
+    return req.res;
+}
+#else /* MODULE_SNTP_ASYNC */
+static sock_udp_t _sntp_sock;
 static ntp_packet_t _sntp_packet;
 
 int sntp_sync(sock_udp_ep_t *server, uint32_t timeout)
@@ -45,9 +161,7 @@ int sntp_sync(sock_udp_ep_t *server, uint32_t timeout)
         DEBUG("Error creating UDP sock\n");
         return result;
     }
-    memset(&_sntp_packet, 0, sizeof(_sntp_packet));
-    ntp_packet_set_vn(&_sntp_packet);
-    ntp_packet_set_mode(&_sntp_packet, NTP_MODE_CLIENT);
+    _init_packet(&_sntp_packet);
 
     if ((result = (int)sock_udp_send(&_sntp_sock,
                                      &_sntp_packet,
@@ -67,13 +181,10 @@ int sntp_sync(sock_udp_ep_t *server, uint32_t timeout)
         return result;
     }
     sock_udp_close(&_sntp_sock);
-    mutex_lock(&_sntp_mutex);
-    _sntp_offset = (((int64_t)byteorder_ntohl(_sntp_packet.transmit.seconds)) * US_PER_SEC) +
-                   ((((int64_t)byteorder_ntohl(_sntp_packet.transmit.fraction)) * 232)
-                   / 1000000) - xtimer_now_usec64();
-    mutex_unlock(&_sntp_mutex);
+    _set_offset(&_sntp_packet);
     return 0;
 }
+#endif /* MODULE_SNTP_ASYNC */
 
 int64_t sntp_get_offset(void)
 {
@@ -19,25 +19,67 @@
 #include "net/credman.h"
 #include "mutex.h"
 
+#include <stdbool.h>
 #include <string.h>
 
+#ifdef MODULE_CREDMAN_VFS
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+
+#include "vfs.h"
+#endif
+
 #define ENABLE_DEBUG (0)
 #include "debug.h"
 
+#if CREDMAN_INDEX_SIZE <= CREDMAN_MAX_CREDENTIALS
+#error "CREDMAN_INDEX_SIZE must be greater than CREDMAN_MAX_CREDENTIALS"
+#endif
+
+#if CREDMAN_MAX_CREDENTIALS < UINT8_MAX
+typedef uint8_t _slot_t;
+#else
+typedef uint16_t _slot_t;
+#endif
+
 static mutex_t _mutex = MUTEX_INIT;
 
+/* credentials[0] to credentials[used - 1] are in use */
 static credman_credential_t credentials[CREDMAN_MAX_CREDENTIALS];
+/* position in credentials + 1 for each credential, 0 for empty slots */
+static _slot_t _index[CREDMAN_INDEX_SIZE];
 static unsigned used = 0;
 
-static int _find_credential_pos(credman_tag_t tag, credman_type_t type,
-                                credman_credential_t **empty);
+#ifdef MODULE_CREDMAN_VFS
+#define VFS_FORMAT_VERSION  (1U)
+
+typedef struct {
+    credman_tag_t tag;          /**< CREDMAN_TAG_EMPTY if unused */
+    credman_type_t type;
+    ecdsa_public_key_t client_keys[CREDMAN_VFS_CLIENT_KEYS_MAX];
+    uint8_t buf[CREDMAN_VFS_BUF_SIZE];
+} _vfs_entry_t;
+
+static const char *_vfs_dir;
+static _vfs_entry_t _vfs_cache[CREDMAN_VFS_CACHE_SIZE];
+static unsigned _vfs_next;
+
+static int _vfs_load(credman_tag_t tag, credman_type_t type);
+static void _vfs_forget(credman_tag_t tag, credman_type_t type);
+#endif
+
+static bool _id_matches(const credman_credential_t *c,
+                        const credman_buffer_t *id);
+static unsigned _find_slot(credman_tag_t tag, credman_type_t type,
+                           const credman_buffer_t *id);
+static void _remove(unsigned slot);
 
 int credman_add(const credman_credential_t *credential)
 {
-    credman_credential_t *entry = NULL;
     assert(credential);
     mutex_lock(&_mutex);
-    int pos = -1;
+    unsigned slot;
     int ret = CREDMAN_ERROR;
 
     if ((credential->type == CREDMAN_TYPE_EMPTY) ||
@@ -69,19 +111,22 @@ int credman_add(const credman_credential_t *credential)
         goto end;
     }
 
-    pos = _find_credential_pos(credential->tag, credential->type, &entry);
-    if (pos >= 0) {
+    /* PSK credentials of one tag are told apart by their identity */
+    slot = _find_slot(credential->tag, credential->type,
+                      (credential->type == CREDMAN_TYPE_PSK)
+                      ? &credential->params.psk.id : NULL);
+    if (_index[slot]) {
         DEBUG("credman: credential with tag %d and type %d already exist\n",
               credential->tag, credential->type);
         ret = CREDMAN_EXIST;
     }
-    else if (entry == NULL) {
+    else if (used == CREDMAN_MAX_CREDENTIALS) {
         DEBUG("credman: no space for new credential\n");
         ret = CREDMAN_NO_SPACE;
     }
     else {
-        *entry = *credential;
-        used++;
+        credentials[used] = *credential;
+        _index[slot] = ++used;
         ret = CREDMAN_OK;
     }
 end:
@@ -96,11 +141,47 @@ int credman_get(credman_credential_t *credential, credman_tag_t tag,
     mutex_lock(&_mutex);
     int ret = CREDMAN_ERROR;
 
-    int pos = _find_credential_pos(tag, type, NULL);
+    int pos = (int)_index[_find_slot(tag, type, NULL)] - 1;
+#ifdef MODULE_CREDMAN_VFS
+    if (pos < 0) {
+        pos = _vfs_load(tag, type);
+    }
+#endif
     if (pos < 0) {
         DEBUG("credman: credential with tag %d and type %d not found\n",
               tag, type);
-        ret = CREDMAN_NOT_FOUND;
+        ret = (pos == -1) ? CREDMAN_NOT_FOUND : pos;
+    }
+    else {
+        memcpy(credential, &credentials[pos], sizeof(credman_credential_t));
+        ret = CREDMAN_OK;
+    }
+    mutex_unlock(&_mutex);
+    return ret;
+}
+
+int credman_get_psk(credman_credential_t *credential, credman_tag_t tag,
+                    const void *id, size_t id_len)
+{
+    assert(credential);
+    assert(id || !id_len);
+    mutex_lock(&_mutex);
+    credman_buffer_t _id = { .s = id, .len = id_len };
+    int ret = CREDMAN_ERROR;
+
+    int pos = (int)_index[_find_slot(tag, CREDMAN_TYPE_PSK, &_id)] - 1;
+#ifdef MODULE_CREDMAN_VFS
+    /* the store holds a single PSK credential per tag */
+    if ((pos < 0) && !_index[_find_slot(tag, CREDMAN_TYPE_PSK, NULL)]) {
+        pos = _vfs_load(tag, CREDMAN_TYPE_PSK);
+        if ((pos >= 0) && !_id_matches(&credentials[pos], &_id)) {
+            pos = CREDMAN_NOT_FOUND;
+        }
+    }
+#endif
+    if (pos < 0) {
+        DEBUG("credman: PSK credential with tag %d not found\n", tag);
+        ret = (pos == -1) ? CREDMAN_NOT_FOUND : pos;
     }
     else {
         memcpy(credential, &credentials[pos], sizeof(credman_credential_t));
@@ -113,11 +194,14 @@ int credman_get(credman_credential_t *credential, credman_tag_t tag,
 void credman_delete(credman_tag_t tag, credman_type_t type)
 {
     mutex_lock(&_mutex);
-    int pos = _find_credential_pos(tag, type, NULL);
-    if (pos >= 0) {
-        memset(&credentials[pos], 0, sizeof(credman_credential_t));
-        used--;
+    unsigned slot;
+    /* all PSK credentials of the tag */
+    while (_index[slot = _find_slot(tag, type, NULL)]) {
+        _remove(slot);
     }
+#ifdef MODULE_CREDMAN_VFS
+    _vfs_forget(tag, type);
+#endif
     mutex_unlock(&_mutex);
 }
 
@@ -126,22 +210,378 @@ int credman_get_used_count(void)
     return used;
 }
 
-static int _find_credential_pos(credman_tag_t tag, credman_type_t type,
-                                credman_credential_t **empty)
+static unsigned _hash(credman_tag_t tag, credman_type_t type)
+{
+    uint32_t key = ((uint32_t)tag << 8) | (uint8_t)type;
+    /* multiplicative hashing, the upper bits are mixed best */
+    return ((key * 2654435761U) >> 16) % CREDMAN_INDEX_SIZE;
+}
+
+static bool _id_matches(const credman_credential_t *c,
+                        const credman_buffer_t *id)
+{
+    return (c->params.psk.id.len == id->len) &&
+           ((id->len == 0) || !memcmp(c->params.psk.id.s, id->s, id->len));
+}
+
+/* returns the slot of the credential or the empty slot ending its probe
+ * sequence, there always is one as the index is bigger than the pool; PSK
+ * credentials of the same tag share a probe sequence, @p id selects one of
+ * them by its identity or NULL the first one */
+static unsigned _find_slot(credman_tag_t tag, credman_type_t type,
+                           const credman_buffer_t *id)
+{
+    unsigned slot = _hash(tag, type);
+
+    while (_index[slot]) {
+        credman_credential_t *c = &credentials[_index[slot] - 1];
+        if ((c->tag == tag) && (c->type == type) &&
+            ((id == NULL) || _id_matches(c, id))) {
+            break;
+        }
+        slot = (slot + 1) % CREDMAN_INDEX_SIZE;
+    }
+    return slot;
+}
+
+static void _remove(unsigned slot)
+{
+    unsigned pos = _index[slot] - 1;
+    unsigned hole = slot;
+
+    /* move following entries of the probe sequence up, so that no lookup
+     * ends at the hole prematurely */
+    _index[hole] = 0;
+    for (unsigned i = (hole + 1) % CREDMAN_INDEX_SIZE; _index[i];
+         i = (i + 1) % CREDMAN_INDEX_SIZE) {
+        credman_credential_t *c = &credentials[_index[i] - 1];
+        unsigned home = _hash(c->tag, c->type);
+        /* entries whose home slot lies between the hole and them stay */
+        if ((hole < i) ? ((hole < home) && (home <= i))
+                       : ((hole < home) || (home <= i))) {
+            continue;
+        }
+        _index[hole] = _index[i];
+        _index[i] = 0;
+        hole = i;
+    }
+
+    /* keep the pool dense by moving the last credential into the gap */
+    used--;
+    if (pos != used) {
+        credentials[pos] = credentials[used];
+        /* the slot referring to the old position of the last credential is
+         * in its probe sequence, which may hold others of the same tag */
+        unsigned i = _hash(credentials[pos].tag, credentials[pos].type);
+        while (_index[i] != used + 1) {
+            i = (i + 1) % CREDMAN_INDEX_SIZE;
+        }
+        _index[i] = pos + 1;
+    }
+    memset(&credentials[used], 0, sizeof(credman_credential_t));
+}
+
+#ifdef MODULE_CREDMAN_VFS
+static int _vfs_path(char *path, size_t len, credman_tag_t tag,
+                     credman_type_t type)
+{
+    if (_vfs_dir == NULL) {
+        return CREDMAN_ERROR;
+    }
+    int res = snprintf(path, len, "%s/%c%04x", _vfs_dir,
+                       (type == CREDMAN_TYPE_PSK) ? 'p' : 'e', tag);
+    if ((res < 0) || ((size_t)res >= len)) {
+        DEBUG("credman: path of store too long\n");
+        return CREDMAN_ERROR;
+    }
+    return CREDMAN_OK;
+}
+
+static int _put_buffer(uint8_t *buf, size_t *pos, const credman_buffer_t *b)
+{
+    if ((b->len > UINT8_MAX) || (*pos + 1 + b->len > CREDMAN_VFS_BUF_SIZE)) {
+        return CREDMAN_INVALID;
+    }
+    buf[(*pos)++] = b->len;
+    if (b->len) {
+        memcpy(&buf[*pos], b->s, b->len);
+    }
+    *pos += b->len;
+    return CREDMAN_OK;
+}
+
+static int _get_buffer(const uint8_t *buf, size_t len, size_t *pos,
+                       credman_buffer_t *b)
+{
+    if ((*pos >= len) || (*pos + 1 + buf[*pos] > len)) {
+        return CREDMAN_ERROR;
+    }
+    b->len = buf[(*pos)++];
+    b->s = b->len ? &buf[*pos] : NULL;
+    *pos += b->len;
+    return CREDMAN_OK;
+}
+
+static int _put_key(uint8_t *buf, size_t *pos, const void *key)
+{
+    if (*pos + CREDMAN_VFS_ECDSA_KEY_SIZE > CREDMAN_VFS_BUF_SIZE) {
+        return CREDMAN_INVALID;
+    }
+    memcpy(&buf[*pos], key, CREDMAN_VFS_ECDSA_KEY_SIZE);
+    *pos += CREDMAN_VFS_ECDSA_KEY_SIZE;
+    return CREDMAN_OK;
+}
+
+static ssize_t _vfs_serialize(uint8_t *buf, const credman_credential_t *c)
 {
-    for (unsigned i = 0; i < CREDMAN_MAX_CREDENTIALS; i++) {
-        credman_credential_t *c = &credentials[i];
-        if ((c->tag == tag) && (c->type == type)) {
-            return i;
+    size_t pos = 0;
+    int res = CREDMAN_OK;
+
+    buf[pos++] = VFS_FORMAT_VERSION;
+    if (c->type == CREDMAN_TYPE_PSK) {
+        if (((res = _put_buffer(buf, &pos, &c->params.psk.key)) < 0) ||
+            ((res = _put_buffer(buf, &pos, &c->params.psk.id)) < 0) ||
+            ((res = _put_buffer(buf, &pos, &c->params.psk.hint)) < 0)) {
+            return res;
         }
-        /* only check until empty position found */
-        if ((empty) && (*empty == NULL) &&
-            (c->tag == CREDMAN_TAG_EMPTY) && (c->type == CREDMAN_TYPE_EMPTY)) {
-            *empty = c;
+        return pos;
+    }
+
+    const ecdsa_params_t *ecdsa = &c->params.ecdsa;
+    if (ecdsa->client_keys_size > CREDMAN_VFS_CLIENT_KEYS_MAX) {
+        return CREDMAN_INVALID;
+    }
+    buf[pos++] = ecdsa->client_keys_size;
+    if (((res = _put_key(buf, &pos, ecdsa->private_key)) < 0) ||
+        ((res = _put_key(buf, &pos, ecdsa->public_key.x)) < 0) ||
+        ((res = _put_key(buf, &pos, ecdsa->public_key.y)) < 0)) {
+        return res;
+    }
+    for (unsigned i = 0; i < ecdsa->client_keys_size; i++) {
+        if (((res = _put_key(buf, &pos, ecdsa->client_keys[i].x)) < 0) ||
+            ((res = _put_key(buf, &pos, ecdsa->client_keys[i].y)) < 0)) {
+            return res;
         }
     }
-    return -1;
+    return pos;
+}
+
+/* parses the stored credential in buf into the parameters of c, the buffers of
+ * which then point into buf and client_keys */
+static int _vfs_parse(const uint8_t *buf, size_t len,
+                      ecdsa_public_key_t *client_keys, credman_credential_t *c)
+{
+    size_t pos = 1;
+
+    if ((len < 2) || (buf[0] != VFS_FORMAT_VERSION)) {
+        return CREDMAN_ERROR;
+    }
+    memset(&c->params, 0, sizeof(c->params));
+    if (c->type == CREDMAN_TYPE_PSK) {
+        if ((_get_buffer(buf, len, &pos, &c->params.psk.key) < 0) ||
+            (_get_buffer(buf, len, &pos, &c->params.psk.id) < 0) ||
+            (_get_buffer(buf, len, &pos, &c->params.psk.hint) < 0) ||
+            (pos != len) || (c->params.psk.key.len == 0)) {
+            return CREDMAN_ERROR;
+        }
+        return CREDMAN_OK;
+    }
+
+    ecdsa_params_t *ecdsa = &c->params.ecdsa;
+    unsigned clients = buf[pos++];
+    if ((clients > CREDMAN_VFS_CLIENT_KEYS_MAX) ||
+        (len != pos + (3 + 2 * clients) * CREDMAN_VFS_ECDSA_KEY_SIZE)) {
+        return CREDMAN_ERROR;
+    }
+    ecdsa->private_key = &buf[pos];
+    pos += CREDMAN_VFS_ECDSA_KEY_SIZE;
+    ecdsa->public_key.x = &buf[pos];
+    pos += CREDMAN_VFS_ECDSA_KEY_SIZE;
+    ecdsa->public_key.y = &buf[pos];
+    pos += CREDMAN_VFS_ECDSA_KEY_SIZE;
+    for (unsigned i = 0; i < clients; i++) {
+        client_keys[i].x = &buf[pos];
+        pos += CREDMAN_VFS_ECDSA_KEY_SIZE;
+        client_keys[i].y = &buf[pos];
+        pos += CREDMAN_VFS_ECDSA_KEY_SIZE;
+    }
+    ecdsa->client_keys = clients ? client_keys : NULL;
+    ecdsa->client_keys_size = clients;
+    return CREDMAN_OK;
+}
+
+static ssize_t _vfs_read(int fd, uint8_t *buf)
+{
+    size_t len = 0;
+    ssize_t res;
+
+    while ((res = vfs_read(fd, &buf[len], CREDMAN_VFS_BUF_SIZE - len)) > 0) {
+        len += res;
+        if (len == CREDMAN_VFS_BUF_SIZE) {
+            uint8_t tmp;
+            /* the stored credential must not be bigger than the buffer */
+            res = (vfs_read(fd, &tmp, 1) == 0) ? 0 : -EFBIG;
+            break;
+        }
+    }
+    return (res < 0) ? res : (ssize_t)len;
+}
+
+/* returns a free cache entry, or evicts the next loaded credential in
+ * round-robin order if the cache or the pool is full; NULL if the pool is full
+ * without any loaded credential */
+static _vfs_entry_t *_vfs_victim(void)
+{
+    _vfs_entry_t *e = NULL;
+
+    if (used < CREDMAN_MAX_CREDENTIALS) {
+        for (unsigned i = 0; i < CREDMAN_VFS_CACHE_SIZE; i++) {
+            if (_vfs_cache[i].tag == CREDMAN_TAG_EMPTY) {
+                return &_vfs_cache[i];
+            }
+        }
+    }
+    for (unsigned i = 0; (e == NULL) && (i < CREDMAN_VFS_CACHE_SIZE); i++) {
+        if (_vfs_cache[_vfs_next].tag != CREDMAN_TAG_EMPTY) {
+            e = &_vfs_cache[_vfs_next];
+        }
+        _vfs_next = (_vfs_next + 1) % CREDMAN_VFS_CACHE_SIZE;
+    }
+    if (e == NULL) {
+        return NULL;
+    }
+
+    /* a loaded credential stays in the pool until its entry is reused */
+    DEBUG("credman: evict credential with tag %d and type %d\n",
+          e->tag, e->type);
+    /* it comes first among the credentials of its tag and type, as it is only
+     * loaded if there is none and removing keeps the probe sequence order */
+    _remove(_find_slot(e->tag, e->type, NULL));
+    e->tag = CREDMAN_TAG_EMPTY;
+    return e;
+}
+
+static int _vfs_load(credman_tag_t tag, credman_type_t type)
+{
+    char path[CREDMAN_VFS_PATH_MAX + 1];
+    uint8_t buf[CREDMAN_VFS_BUF_SIZE];
+    ecdsa_public_key_t client_keys[CREDMAN_VFS_CLIENT_KEYS_MAX];
+    credman_credential_t c = { .tag = tag, .type = type };
+
+    if ((tag == CREDMAN_TAG_EMPTY) ||
+        ((type != CREDMAN_TYPE_PSK) && (type != CREDMAN_TYPE_ECDSA)) ||
+        (_vfs_path(path, sizeof(path), tag, type) < 0)) {
+        return CREDMAN_NOT_FOUND;
+    }
+    int fd = vfs_open(path, O_RDONLY, 0);
+    if (fd < 0) {
+        return (fd == -ENOENT) ? CREDMAN_NOT_FOUND : CREDMAN_ERROR;
+    }
+
+    /* the cache is only touched once the stored credential is known to be
+     * valid */
+    ssize_t len = _vfs_read(fd, buf);
+    vfs_close(fd);
+    if ((len < 0) || (_vfs_parse(buf, len, client_keys, &c) < 0)) {
+        DEBUG("credman: invalid stored credential %s\n", path);
+        return CREDMAN_ERROR;
+    }
+
+    _vfs_entry_t *e = _vfs_victim();
+    if (e == NULL) {
+        return CREDMAN_NO_SPACE;
+    }
+    /* parse again, so that the credential refers to the cache entry */
+    memcpy(e->buf, buf, len);
+    _vfs_parse(e->buf, len, e->client_keys, &c);
+    e->tag = tag;
+    e->type = type;
+    credentials[used] = c;
+    _index[_find_slot(tag, type, NULL)] = ++used;
+    return used - 1;
+}
+
+static void _vfs_forget(credman_tag_t tag, credman_type_t type)
+{
+    for (unsigned i = 0; i < CREDMAN_VFS_CACHE_SIZE; i++) {
+        if ((_vfs_cache[i].tag == tag) && (_vfs_cache[i].type == type)) {
+            _vfs_cache[i].tag = CREDMAN_TAG_EMPTY;
+        }
+    }
+}
+
+void credman_vfs_init(const char *dir)
+{
+    mutex_lock(&_mutex);
+    _vfs_dir = dir;
+    mutex_unlock(&_mutex);
+}
+
+int credman_vfs_save(credman_tag_t tag, credman_type_t type)
+{
+    char path[CREDMAN_VFS_PATH_MAX + 1];
+    uint8_t buf[CREDMAN_VFS_BUF_SIZE];
+    int ret;
+
+    mutex_lock(&_mutex);
+    int pos = (int)_index[_find_slot(tag, type, NULL)] - 1;
+    if (pos < 0) {
+        ret = CREDMAN_NOT_FOUND;
+        goto end;
+    }
+    if ((ret = _vfs_path(path, sizeof(path), tag, type)) < 0) {
+        goto end;
+    }
+    ssize_t len = _vfs_serialize(buf, &credentials[pos]);
+    if (len < 0) {
+        ret = len;
+        goto end;
+    }
+    int fd = vfs_open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        DEBUG("credman: unable to open %s: %d\n", path, fd);
+        ret = CREDMAN_ERROR;
+        goto end;
+    }
+    for (ssize_t done = 0, res; done < len; done += res) {
+        res = vfs_write(fd, &buf[done], len - done);
+        if (res <= 0) {
+            DEBUG("credman: unable to write %s: %d\n", path, (int)res);
+            ret = CREDMAN_ERROR;
+            break;
+        }
+    }
+    if ((vfs_close(fd) < 0) && (ret == CREDMAN_OK)) {
+        ret = CREDMAN_ERROR;
+    }
+end:
+    mutex_unlock(&_mutex);
+    return ret;
+}
+
+int credman_vfs_remove(credman_tag_t tag, credman_type_t type)
+{
+    char path[CREDMAN_VFS_PATH_MAX + 1];
+    int ret;
+
+    mutex_lock(&_mutex);
+    if ((ret = _vfs_path(path, sizeof(path), tag, type)) < 0) {
+        goto end;
+    }
+    int res = vfs_unlink(path);
+    if (res < 0) {
+        ret = (res == -ENOENT) ? CREDMAN_NOT_FOUND : CREDMAN_ERROR;
+    }
+    unsigned slot;
+    while (_index[slot = _find_slot(tag, type, NULL)]) {
+        _remove(slot);
+    }
+    _vfs_forget(tag, type);
+end:
+    mutex_unlock(&_mutex);
+    return ret;
 }
+#endif /* MODULE_CREDMAN_VFS */
 
 #ifdef TEST_SUITES
 void credman_reset(void)
@@ -149,7 +589,12 @@ void credman_reset(void)
     mutex_lock(&_mutex);
     memset(credentials, 0,
            sizeof(credman_credential_t) * CREDMAN_MAX_CREDENTIALS);
+    memset(_index, 0, sizeof(_index));
     used = 0;
+#ifdef MODULE_CREDMAN_VFS
+    memset(_vfs_cache, 0, sizeof(_vfs_cache));
+    _vfs_next = 0;
+#endif
     mutex_unlock(&_mutex);
 }
 #endif /* TEST_SUITES */
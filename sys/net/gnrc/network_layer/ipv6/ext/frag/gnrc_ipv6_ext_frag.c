@@ -17,6 +17,7 @@
 #include <stdbool.h>
 
 #include "byteorder.h"
+#include "memarray.h"
 #include "net/ipv6/ext/frag.h"
 #include "net/ipv6/addr.h"
 #include "net/ipv6/hdr.h"
@@ -35,6 +36,7 @@
 #include "debug.h"
 
 static gnrc_ipv6_ext_frag_send_t _snd_bufs[CONFIG_GNRC_IPV6_EXT_FRAG_SEND_SIZE];
+static memarray_t _snd_buf_pool;
 static gnrc_ipv6_ext_frag_rbuf_t _rbuf[CONFIG_GNRC_IPV6_EXT_FRAG_RBUF_SIZE];
 static gnrc_ipv6_ext_frag_limits_t _limits_pool[CONFIG_GNRC_IPV6_EXT_FRAG_LIMITS_POOL_SIZE];
 static clist_node_t _free_limits;
@@ -62,6 +64,8 @@ void gnrc_ipv6_ext_frag_init(void)
     memset(_rbuf, 0, sizeof(_rbuf));
 #endif
     _last_id = random_uint32();
+    memarray_init(&_snd_buf_pool, _snd_bufs, sizeof(gnrc_ipv6_ext_frag_send_t),
+                  CONFIG_GNRC_IPV6_EXT_FRAG_SEND_SIZE);
     for (unsigned i = 0; i < CONFIG_GNRC_IPV6_EXT_FRAG_LIMITS_POOL_SIZE; i++) {
         clist_rpush(&_free_limits, (clist_node_t *)&_limits_pool[i]);
     }
@@ -273,22 +277,19 @@ void gnrc_ipv6_ext_frag_send(gnrc_ipv6_ext_frag_send_t *snd_buf)
 
 static gnrc_ipv6_ext_frag_send_t *_snd_buf_alloc(void)
 {
-    for (unsigned i = 0; i < CONFIG_GNRC_IPV6_EXT_FRAG_SEND_SIZE; i++) {
-        gnrc_ipv6_ext_frag_send_t *snd_buf = &_snd_bufs[i];
-        if (snd_buf->pkt == NULL) {
-            return snd_buf;
-        }
-    }
-    if (IS_USED(MODULE_GNRC_IPV6_EXT_FRAG_STATS)) {
+    gnrc_ipv6_ext_frag_send_t *snd_buf = memarray_alloc(&_snd_buf_pool);
+
+    if ((snd_buf == NULL) && IS_USED(MODULE_GNRC_IPV6_EXT_FRAG_STATS)) {
         _stats.frag_full++;
     }
-    return NULL;
+    return snd_buf;
 }
 
 static void _snd_buf_del(gnrc_ipv6_ext_frag_send_t *snd_buf)
 {
     snd_buf->per_frag = NULL;
     snd_buf->pkt = NULL;
+    memarray_free(&_snd_buf_pool, snd_buf);
 }
 
 static void _snd_buf_free(gnrc_ipv6_ext_frag_send_t *snd_buf)
@@ -48,6 +48,9 @@ static rmutex_t _nib_mutex = RMUTEX_INIT;
 static char addr_str[IPV6_ADDR_MAX_STR_LEN];
 
 evtimer_msg_t _nib_evtimer;
+#if IS_ACTIVE(CONFIG_GNRC_IPV6_NIB_DNS)
+evtimer_msg_event_t _nib_rdnss_timeout;
+#endif
 
 static void _override_node(const ipv6_addr_t *addr, unsigned iface,
                            _nib_onl_entry_t *node);
@@ -846,19 +849,12 @@ static inline bool _node_unreachable(_nib_onl_entry_t *node)
     }
 }
 
-uint32_t _evtimer_lookup(const void *ctx, uint16_t type)
+uint32_t _evtimer_lookup(const evtimer_msg_event_t *event, uint16_t type)
 {
-    evtimer_msg_event_t *event = (evtimer_msg_event_t *)_nib_evtimer.events;
-    uint32_t offset = 0;
-
-    DEBUG("nib: lookup ctx = %p, type = %04x\n", (void *)ctx, type);
-    while (event != NULL) {
-        offset += event->event.offset;
-        if ((event->msg.type == type) &&
-            ((ctx == NULL) || (event->msg.content.ptr == ctx))) {
-            return offset;
-        }
-        event = (evtimer_msg_event_t *)event->event.next;
+    DEBUG("nib: lookup ctx = %p, type = %04x\n", event->msg.content.ptr, type);
+    if ((event->msg.type == type) &&
+        evtimer_is_scheduled((evtimer_t *)&_nib_evtimer, &event->event)) {
+        return evtimer_left_msec((evtimer_t *)&_nib_evtimer, &event->event);
     }
     return UINT32_MAX;
 }
@@ -247,6 +247,13 @@ typedef struct {
  */
 extern evtimer_msg_t _nib_evtimer;
 
+#if IS_ACTIVE(CONFIG_GNRC_IPV6_NIB_DNS) || defined(DOXYGEN)
+/**
+ * @brief   Event for the timeout of the RDNSS option in @ref sock_dns_server
+ */
+extern evtimer_msg_event_t _nib_rdnss_timeout;
+#endif
+
 /**
  * @brief   Primary default router.
  *
@@ -796,13 +803,17 @@ int _nib_get_route(const ipv6_addr_t *dst, gnrc_pktsnip_t *ctx,
 /**
  * @brief   Looks up if an event is queued in the event timer
  *
- * @param[in] ctx   Context of the event. May be NULL for any event context.
- * @param[in] type  [Type of the event](@ref net_gnrc_ipv6_nib_msg).
+ * The events of the NIB are embedded in the entries they belong to, so this
+ * only checks @p event itself instead of searching the event timer.
+ *
+ * @param[in] event Event of the context, e.g. _nib_onl_entry_t::nud_timeout.
+ * @param[in] type  [Type of the event](@ref net_gnrc_ipv6_nib_msg), as
+ *                  @p event may be used for different types.
  *
  * @return  Milliseconds to the event, if event in queue.
  * @return  UINT32_MAX, event is not in queue.
  */
-uint32_t _evtimer_lookup(const void *ctx, uint16_t type);
+uint32_t _evtimer_lookup(const evtimer_msg_event_t *event, uint16_t type);
 
 /**
  * @brief   Adds an event to the event timer
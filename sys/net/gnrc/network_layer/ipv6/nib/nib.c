@@ -51,10 +51,6 @@ static char addr_str[IPV6_ADDR_MAX_STR_LEN];
 static gnrc_pktqueue_t _queue_pool[CONFIG_GNRC_IPV6_NIB_NUMOF];
 #endif  /* CONFIG_GNRC_IPV6_NIB_QUEUE_PKT */
 
-#if IS_ACTIVE(CONFIG_GNRC_IPV6_NIB_DNS)
-static evtimer_msg_event_t _rdnss_timeout;
-#endif
-
 /**
  * @internal
  * @{
@@ -86,13 +82,9 @@ static void _handle_rdnss_timeout(sock_udp_ep_t *dns_server);
 
 void gnrc_ipv6_nib_init(void)
 {
-    evtimer_event_t *tmp;
-
     _nib_acquire();
-    for (evtimer_event_t *ptr = _nib_evtimer.events;
-         (ptr != NULL) && (tmp = (ptr->next), 1);
-         ptr = tmp) {
-        evtimer_del((evtimer_t *)(&_nib_evtimer), ptr);
+    while (_nib_evtimer.events) {
+        evtimer_del((evtimer_t *)(&_nib_evtimer), _nib_evtimer.events);
     }
     _nib_init();
     _nib_release();
@@ -512,7 +504,7 @@ static void _handle_rtr_sol(gnrc_netif_t *netif, const ipv6_hdr_t *ipv6,
     }
     if (!gnrc_netif_is_6ln(netif)) {
         uint32_t next_ra_delay = random_uint32_range(0, NDP_MAX_RA_DELAY);
-        uint32_t next_ra_scheduled = _evtimer_lookup(netif,
+        uint32_t next_ra_scheduled = _evtimer_lookup(&netif->ipv6.snd_mc_ra,
                                                      GNRC_IPV6_NIB_SND_MC_RA);
         if (next_ra_scheduled < next_ra_delay) {
             DEBUG("nib: There is a MC RA scheduled within the next %" PRIu32 "ms. "
@@ -1321,7 +1313,8 @@ void _handle_search_rtr(gnrc_netif_t *netif)
 #if !IS_ACTIVE(CONFIG_GNRC_IPV6_NIB_NO_RTR_SOL)
     gnrc_netif_acquire(netif);
     if (!(gnrc_netif_is_rtr_adv(netif)) || gnrc_netif_is_6ln(netif)) {
-        uint32_t next_rs = _evtimer_lookup(netif, GNRC_IPV6_NIB_SEARCH_RTR);
+        uint32_t next_rs = _evtimer_lookup(&netif->ipv6.search_rtr,
+                                         GNRC_IPV6_NIB_SEARCH_RTR);
         uint32_t interval = _get_next_rs_interval(netif);
 
         if (next_rs > interval) {
@@ -1407,11 +1400,11 @@ static uint32_t _handle_rdnsso(gnrc_netif_t *netif, const icmpv6_hdr_t *icmpv6,
                 ltime = (ltime > (UINT32_MAX / MS_PER_SEC)) ?
                               (UINT32_MAX - 1) : ltime * MS_PER_SEC;
                 _evtimer_add(&sock_dns_server, GNRC_IPV6_NIB_RDNSS_TIMEOUT,
-                             &_rdnss_timeout, ltime);
+                             &_nib_rdnss_timeout, ltime);
             }
         }
         else {
-            evtimer_del(&_nib_evtimer, &_rdnss_timeout.event);
+            evtimer_del(&_nib_evtimer, &_nib_rdnss_timeout.event);
             _handle_rdnss_timeout(&sock_dns_server);
         }
     }
@@ -335,6 +335,17 @@ void gnrc_pktbuf_stats(void)
     DEBUG("pktbuf: needs od module\n");
 #endif
 }
+
+size_t gnrc_pktbuf_max_used(bool reset)
+{
+    mutex_lock(&_mutex);
+    size_t res = max_byte_count;
+    if (reset) {
+        max_byte_count = 0;
+    }
+    mutex_unlock(&_mutex);
+    return res;
+}
 #endif
 
 #ifdef TEST_SUITES
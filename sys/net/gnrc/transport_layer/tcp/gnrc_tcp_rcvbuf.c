@@ -16,6 +16,8 @@
  * @author      Simon Brummer <simon.brummer@posteo.de>
  */
 #include <errno.h>
+
+#include "kernel_defines.h"
 #include "internal/rcvbuf.h"
 
 #define ENABLE_DEBUG (0)
@@ -33,9 +35,8 @@ void _rcvbuf_init(void)
 {
     DEBUG("gnrc_tcp_rcvbuf.c : _rcvbuf_init() : entry\n");
     mutex_init(&(_static_buf.lock));
-    for (size_t i = 0; i < GNRC_TCP_RCV_BUFFERS; ++i) {
-        _static_buf.entries[i].used = 0;
-    }
+    memarray_init(&(_static_buf.pool), _static_buf.entries,
+                  sizeof(rcvbuf_entry_t), GNRC_TCP_RCV_BUFFERS);
 }
 
 /**
@@ -46,18 +47,11 @@ void _rcvbuf_init(void)
  */
 static void* _rcvbuf_alloc(void)
 {
-    void *result = NULL;
     DEBUG("gnrc_tcp_rcvbuf.c : _rcvbuf_alloc() : Entry\n");
     mutex_lock(&(_static_buf.lock));
-    for (size_t i = 0; i < GNRC_TCP_RCV_BUFFERS; ++i) {
-        if (_static_buf.entries[i].used == 0) {
-            _static_buf.entries[i].used = 1;
-            result = (void *)(_static_buf.entries[i].buffer);
-            break;
-        }
-    }
+    rcvbuf_entry_t *entry = memarray_alloc(&(_static_buf.pool));
     mutex_unlock(&(_static_buf.lock));
-    return result;
+    return (entry != NULL) ? (void *)(entry->buffer) : NULL;
 }
 
 /**
@@ -69,11 +63,7 @@ static void _rcvbuf_free(void * const buf)
 {
     DEBUG("gnrc_tcp_rcvbuf.c : _rcvbuf_free() : Entry\n");
     mutex_lock(&(_static_buf.lock));
-    for (size_t i = 0; i < GNRC_TCP_RCV_BUFFERS; ++i) {
-        if ((_static_buf.entries[i].used == 1) && (buf == _static_buf.entries[i].buffer)) {
-            _static_buf.entries[i].used = 0;
-        }
-    }
+    memarray_free(&(_static_buf.pool), container_of(buf, rcvbuf_entry_t, buffer));
     mutex_unlock(&(_static_buf.lock));
 }
 
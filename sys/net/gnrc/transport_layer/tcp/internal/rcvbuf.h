@@ -21,6 +21,7 @@
 #define RCVBUF_H
 
 #include <stdint.h>
+#include "memarray.h"
 #include "mutex.h"
 #include "net/gnrc/tcp/config.h"
 #include "net/gnrc/tcp/tcb.h"
@@ -33,7 +34,6 @@ extern "C" {
  * @brief Receive buffer entry.
  */
 typedef struct rcvbuf_entry {
-    uint8_t used;                          /**< Flag: Is buffer in use? */
     uint8_t buffer[GNRC_TCP_RCV_BUF_SIZE]; /**< Receive buffer storage */
 } rcvbuf_entry_t;
 
@@ -42,6 +42,7 @@ typedef struct rcvbuf_entry {
  */
 typedef struct rcvbuf {
     mutex_t lock;                                 /**< Lock for allocation synchronization */
+    memarray_t pool;                              /**< Pool of unused entries */
     rcvbuf_entry_t entries[GNRC_TCP_RCV_BUFFERS]; /**< Maintained receive buffers */
 } rcvbuf_t;
 
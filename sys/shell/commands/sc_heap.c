@@ -20,7 +20,8 @@
 
 #include "cpu_conf.h"
 
-#if defined(MODULE_NEWLIB_SYSCALLS_DEFAULT) || defined (HAVE_HEAP_STATS)
+#if defined(MODULE_NEWLIB_SYSCALLS_DEFAULT) || defined (HAVE_HEAP_STATS) || \
+    defined(MODULE_TLSF_MALLOC)
 extern void heap_stats(void);
 #else
 #include <stdio.h>
@@ -31,7 +32,8 @@ int _heap_handler(int argc, char **argv)
     (void) argc;
     (void) argv;
 
-#if defined(MODULE_NEWLIB_SYSCALLS_DEFAULT) || defined (HAVE_HEAP_STATS)
+#if defined(MODULE_NEWLIB_SYSCALLS_DEFAULT) || defined (HAVE_HEAP_STATS) || \
+    defined(MODULE_TLSF_MALLOC)
     heap_stats();
     return 0;
 #else
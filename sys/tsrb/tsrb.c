@@ -17,6 +17,8 @@
  * @}
  */
 
+#include <string.h>
+
 #include "tsrb.h"
 
 static void _push(tsrb_t *rb, uint8_t c)
@@ -39,24 +41,51 @@ int tsrb_get_one(tsrb_t *rb)
     }
 }
 
+/* Fill iov with the up to two linear regions of n bytes starting at index
+ * pos */
+static size_t _regions(const tsrb_t *rb, unsigned pos, size_t n,
+                       struct iovec iov[2])
+{
+    unsigned idx = pos & (rb->size - 1);
+    size_t till_end = rb->size - idx;
+
+    iov[0].iov_base = &rb->buf[idx];
+    iov[0].iov_len = (n < till_end) ? n : till_end;
+    iov[1].iov_base = rb->buf;
+    iov[1].iov_len = n - iov[0].iov_len;
+    return n;
+}
+
 int tsrb_get(tsrb_t *rb, uint8_t *dst, size_t n)
 {
-    size_t tmp = n;
-    while (tmp && !tsrb_empty(rb)) {
-        *dst++ = _pop(rb);
-        tmp--;
-    }
-    return (n - tmp);
+    struct iovec iov[2];
+
+    n = tsrb_peek_iov(rb, iov, n);
+    memcpy(dst, iov[0].iov_base, iov[0].iov_len);
+    memcpy(dst + iov[0].iov_len, iov[1].iov_base, iov[1].iov_len);
+    rb->reads += n;
+    return n;
 }
 
 int tsrb_drop(tsrb_t *rb, size_t n)
 {
-    size_t tmp = n;
-    while (tmp && !tsrb_empty(rb)) {
-        _pop(rb);
-        tmp--;
+    unsigned avail = tsrb_avail(rb);
+
+    if (n > avail) {
+        n = avail;
     }
-    return (n - tmp);
+    rb->reads += n;
+    return n;
+}
+
+size_t tsrb_peek_iov(const tsrb_t *rb, struct iovec iov[2], size_t n)
+{
+    unsigned avail = tsrb_avail(rb);
+
+    if (n > avail) {
+        n = avail;
+    }
+    return _regions(rb, rb->reads, n, iov);
 }
 
 int tsrb_add_one(tsrb_t *rb, uint8_t c)
@@ -72,10 +101,27 @@ int tsrb_add_one(tsrb_t *rb, uint8_t c)
 
 int tsrb_add(tsrb_t *rb, const uint8_t *src, size_t n)
 {
-    size_t tmp = n;
-    while (tmp && !tsrb_full(rb)) {
-        _push(rb, *src++);
-        tmp--;
+    struct iovec iov[2];
+
+    n = tsrb_reserve_iov(rb, iov, n);
+    memcpy(iov[0].iov_base, src, iov[0].iov_len);
+    memcpy(iov[1].iov_base, src + iov[0].iov_len, iov[1].iov_len);
+    rb->writes += n;
+    return n;
+}
+
+size_t tsrb_reserve_iov(const tsrb_t *rb, struct iovec iov[2], size_t n)
+{
+    unsigned space = tsrb_free(rb);
+
+    if (n > space) {
+        n = space;
     }
-    return (n - tmp);
+    return _regions(rb, rb->writes, n, iov);
+}
+
+void tsrb_commit(tsrb_t *rb, size_t n)
+{
+    assert(n <= tsrb_free(rb));
+    rb->writes += n;
 }
@@ -59,6 +59,28 @@ static vfs_file_t _vfs_open_files[VFS_MAX_OPEN_FILES];
  */
 static clist_node_t _vfs_mounts_list;
 
+#if VFS_PATH_CACHE_SIZE
+/**
+ * @internal
+ * @brief Entry in the mount lookup cache
+ */
+typedef struct {
+    vfs_mount_t *mp;                    /**< mount of the directory, NULL if unused */
+    size_t match_len;                   /**< length of the matched mount point prefix */
+    size_t dir_len;                     /**< length of @c dir */
+    char dir[VFS_PATH_CACHE_NAME_MAX];  /**< directory name, not null terminated */
+} _path_cache_entry_t;
+
+/**
+ * @internal
+ * @brief Direct mapped cache of directory name to mount lookups
+ *
+ * Only accessed with _mount_mutex held, flushed on every change to
+ * _vfs_mounts_list.
+ */
+static _path_cache_entry_t _path_cache[VFS_PATH_CACHE_SIZE];
+#endif
+
 /**
  * @internal
  * @brief Find an unused entry in the _vfs_open_files array and mark it as used
@@ -118,6 +140,48 @@ static inline int _init_fd(int fd, const vfs_file_ops_t *f_op, vfs_mount_t *moun
  */
 static inline int _find_mount(vfs_mount_t **mountpp, const char *name, const char **rel_path);
 
+/**
+ * @internal
+ * @brief Build the absolute path of @p name relative to @p dir in @p buf
+ *
+ * @p buf must have space for at least VFS_DIRAT_PATH_MAX + VFS_NAME_MAX + 2 bytes.
+ *
+ * @param[in]  dir       resolved directory
+ * @param[in]  name      file name relative to @p dir
+ * @param[out] buf       output buffer for the absolute path
+ * @param[out] rel_path  output pointer for the mount point relative path
+ *
+ * @return 0 on success
+ * @return <0 on error
+ */
+static int _dirat_path(const vfs_dirat_t *dir, const char *name, char *buf,
+                       const char **rel_path);
+
+/**
+ * @internal
+ * @brief Allocate an fd and open @p rel_path on the already resolved mount
+ *
+ * The caller must hold a reference in the open_files counter of @p mountp,
+ * the reference is handed over to the new fd, or dropped on error.
+ *
+ * @return fd number on success (>= 0)
+ * @return <0 on error
+ */
+static int _open(vfs_mount_t *mountp, const char *rel_path, const char *abs_path,
+                 int flags, mode_t mode);
+
+/**
+ * @internal
+ * @brief Unlink @p rel_path on the already resolved mount
+ */
+static int _unlink(vfs_mount_t *mountp, const char *rel_path);
+
+/**
+ * @internal
+ * @brief Stat @p rel_path on the already resolved mount
+ */
+static int _stat(vfs_mount_t *mountp, const char *rel_path, struct stat *buf);
+
 /**
  * @internal
  * @brief Check that a given fd number is valid
@@ -132,6 +196,19 @@ static inline int _fd_is_valid(int fd);
 static mutex_t _mount_mutex = MUTEX_INIT;
 static mutex_t _open_mutex = MUTEX_INIT;
 
+/**
+ * @internal
+ * @brief Invalidate all entries in the mount lookup cache
+ *
+ * Must be called with _mount_mutex held.
+ */
+static inline void _path_cache_flush(void)
+{
+#if VFS_PATH_CACHE_SIZE
+    memset(_path_cache, 0, sizeof(_path_cache));
+#endif
+}
+
 int vfs_close(int fd)
 {
     DEBUG("vfs_close: %d\n", fd);
@@ -264,28 +341,65 @@ int vfs_open(const char *name, int flags, mode_t mode)
         DEBUG("vfs_open: no matching mount\n");
         return res;
     }
-    mutex_lock(&_open_mutex);
-    int fd = _init_fd(VFS_ANY_FD, mountp->fs->f_op, mountp, flags, NULL);
-    mutex_unlock(&_open_mutex);
-    if (fd < 0) {
-        DEBUG("vfs_open: _init_fd: ERR %d!\n", fd);
-        /* remember to decrement the open_files count */
-        atomic_fetch_sub(&mountp->open_files, 1);
-        return fd;
+    return _open(mountp, rel_path, name, flags, mode);
+}
+
+int vfs_dirat_open(vfs_dirat_t *dir, const char *dirname)
+{
+    DEBUG("vfs_dirat_open: %p, \"%s\"\n", (void *)dir, dirname);
+    if ((dir == NULL) || (dirname == NULL)) {
+        return -EINVAL;
     }
-    vfs_file_t *filp = &_vfs_open_files[fd];
-    if (filp->f_op->open != NULL) {
-        res = filp->f_op->open(filp, rel_path, flags, mode, name);
-        if (res < 0) {
-            /* something went wrong during open */
-            DEBUG("vfs_open: open: ERR %d!\n", res);
-            /* clean up */
-            _free_fd(fd);
-            return res;
-        }
+    size_t len = strlen(dirname);
+    /* strip trailing slashes, the separator is added by the *at functions */
+    while ((len > 0) && (dirname[len - 1] == '/')) {
+        --len;
     }
-    DEBUG("vfs_open: opened %d\n", fd);
-    return fd;
+    if (len > VFS_DIRAT_PATH_MAX) {
+        return -ENAMETOOLONG;
+    }
+    const char *rel_path;
+    int res = _find_mount(&dir->mp, dirname, &rel_path);
+    /* _find_mount implicitly increments the open_files count on success,
+     * the reference is held until vfs_dirat_close */
+    if (res < 0) {
+        DEBUG("vfs_dirat_open: no matching mount\n");
+        dir->mp = NULL;
+        return res;
+    }
+    memcpy(dir->path, dirname, len);
+    dir->path[len] = '\0';
+    dir->path_len = len;
+    return 0;
+}
+
+int vfs_dirat_close(vfs_dirat_t *dir)
+{
+    DEBUG("vfs_dirat_close: %p\n", (void *)dir);
+    if (dir == NULL) {
+        return -EINVAL;
+    }
+    if (dir->mp == NULL) {
+        return -EBADF;
+    }
+    atomic_fetch_sub(&dir->mp->open_files, 1);
+    dir->mp = NULL;
+    return 0;
+}
+
+int vfs_openat(const vfs_dirat_t *dir, const char *name, int flags, mode_t mode)
+{
+    DEBUG("vfs_openat: %p, \"%s\", 0x%x, 0%03lo\n",
+          (void *)dir, name, flags, (long unsigned int)mode);
+    char buf[VFS_DIRAT_PATH_MAX + VFS_NAME_MAX + 2];
+    const char *rel_path;
+    int res = _dirat_path(dir, name, buf, &rel_path);
+    if (res < 0) {
+        return res;
+    }
+    /* the new fd needs its own reference on the mount */
+    atomic_fetch_add(&dir->mp->open_files, 1);
+    return _open(dir->mp, rel_path, buf, flags, mode);
 }
 
 ssize_t vfs_read(int fd, void *dest, size_t count)
@@ -333,6 +447,138 @@ ssize_t vfs_write(int fd, const void *src, size_t count)
     return filp->f_op->write(filp, src, count);
 }
 
+ssize_t vfs_readv(int fd, const iolist_t *iolist)
+{
+    DEBUG("vfs_readv: %d, %p\n", fd, (void *)iolist);
+    int res = _fd_is_valid(fd);
+    if (res < 0) {
+        return res;
+    }
+    vfs_file_t *filp = &_vfs_open_files[fd];
+    if (((filp->flags & O_ACCMODE) != O_RDONLY) & ((filp->flags & O_ACCMODE) != O_RDWR)) {
+        /* File not open for reading */
+        return -EBADF;
+    }
+    if (filp->f_op->readv != NULL) {
+        return filp->f_op->readv(filp, iolist);
+    }
+    if (filp->f_op->read == NULL) {
+        /* driver does not implement read() */
+        return -EINVAL;
+    }
+    ssize_t total = 0;
+    for (; iolist; iolist = iolist->iol_next) {
+        if (iolist->iol_len == 0) {
+            continue;
+        }
+        ssize_t n = filp->f_op->read(filp, iolist->iol_base, iolist->iol_len);
+        if (n < 0) {
+            /* only report the error if nothing was transferred yet */
+            return (total > 0) ? total : n;
+        }
+        total += n;
+        if ((size_t)n < iolist->iol_len) {
+            /* end of file */
+            break;
+        }
+    }
+    return total;
+}
+
+ssize_t vfs_writev(int fd, const iolist_t *iolist)
+{
+    DEBUG_NOT_STDOUT(fd, "vfs_writev: %d, %p\n", fd, (void *)iolist);
+    int res = _fd_is_valid(fd);
+    if (res < 0) {
+        return res;
+    }
+    vfs_file_t *filp = &_vfs_open_files[fd];
+    if (((filp->flags & O_ACCMODE) != O_WRONLY) & ((filp->flags & O_ACCMODE) != O_RDWR)) {
+        /* File not open for writing */
+        return -EBADF;
+    }
+    if (filp->f_op->writev != NULL) {
+        return filp->f_op->writev(filp, iolist);
+    }
+    if (filp->f_op->write == NULL) {
+        /* driver does not implement write() */
+        return -EINVAL;
+    }
+    ssize_t total = 0;
+    for (; iolist; iolist = iolist->iol_next) {
+        if (iolist->iol_len == 0) {
+            continue;
+        }
+        ssize_t n = filp->f_op->write(filp, iolist->iol_base, iolist->iol_len);
+        if (n < 0) {
+            /* only report the error if nothing was transferred yet */
+            return (total > 0) ? total : n;
+        }
+        total += n;
+        if ((size_t)n < iolist->iol_len) {
+            /* short write, e.g. file system full */
+            break;
+        }
+    }
+    return total;
+}
+
+ssize_t vfs_sendfile(int out_fd, int in_fd, off_t *offset, size_t count)
+{
+    DEBUG("vfs_sendfile: %d, %d, %p, %lu\n",
+          out_fd, in_fd, (void *)offset, (unsigned long)count);
+    off_t saved_pos = 0;
+    if (offset != NULL) {
+        saved_pos = vfs_lseek(in_fd, 0, SEEK_CUR);
+        if (saved_pos < 0) {
+            return saved_pos;
+        }
+        off_t pos = vfs_lseek(in_fd, *offset, SEEK_SET);
+        if (pos < 0) {
+            return pos;
+        }
+    }
+    uint8_t buf[VFS_SENDFILE_BUFSIZE];
+    ssize_t total = 0;
+    ssize_t res = 0;
+    while ((size_t)total < count) {
+        size_t chunk = count - total;
+        if (chunk > sizeof(buf)) {
+            chunk = sizeof(buf);
+        }
+        ssize_t nread = vfs_read(in_fd, buf, chunk);
+        if (nread <= 0) {
+            /* end of file or error */
+            res = nread;
+            break;
+        }
+        ssize_t nwritten = 0;
+        while (nwritten < nread) {
+            res = vfs_write(out_fd, &buf[nwritten], nread - nwritten);
+            if (res <= 0) {
+                break;
+            }
+            nwritten += res;
+        }
+        total += nwritten;
+        if (nwritten < nread) {
+            /* the bytes not written must be read again by the next call */
+            if (offset == NULL) {
+                vfs_lseek(in_fd, nwritten - nread, SEEK_CUR);
+            }
+            break;
+        }
+    }
+    if (offset != NULL) {
+        *offset += total;
+        vfs_lseek(in_fd, saved_pos, SEEK_SET);
+    }
+    if ((total == 0) && (res < 0)) {
+        return res;
+    }
+    return total;
+}
+
 int vfs_opendir(vfs_DIR *dirp, const char *dirname)
 {
     DEBUG("vfs_opendir: %p, \"%s\"\n", (void *)dirp, dirname);
@@ -483,6 +729,7 @@ int vfs_mount(vfs_mount_t *mountp)
     }
     /* insert last in list */
     clist_rpush(&_vfs_mounts_list, &mountp->list_entry);
+    _path_cache_flush();
     mutex_unlock(&_mount_mutex);
     DEBUG("vfs_mount: mount done\n");
     return 0;
@@ -529,6 +776,7 @@ int vfs_umount(vfs_mount_t *mountp)
         mutex_unlock(&_mount_mutex);
         return -EINVAL;
     }
+    _path_cache_flush();
     mutex_unlock(&_mount_mutex);
     return 0;
 }
@@ -607,27 +855,25 @@ int vfs_unlink(const char *name)
         DEBUG("vfs_unlink: no matching mount\n");
         return res;
     }
-    if ((mountp->fs->fs_op == NULL) || (mountp->fs->fs_op->unlink == NULL)) {
-        /* unlink not supported */
-        DEBUG("vfs_unlink: unlink not supported by fs!\n");
-        /* remember to decrement the open_files count */
-        atomic_fetch_sub(&mountp->open_files, 1);
-        return -EPERM;
-    }
-    res = mountp->fs->fs_op->unlink(mountp, rel_path);
-    DEBUG("vfs_unlink: unlink %p, \"%s\"", (void *)mountp, rel_path);
-    if (res < 0) {
-        /* something went wrong during unlink */
-        DEBUG(": ERR %d!\n", res);
-    }
-    else {
-        DEBUG("\n");
-    }
+    res = _unlink(mountp, rel_path);
     /* remember to decrement the open_files count */
     atomic_fetch_sub(&mountp->open_files, 1);
     return res;
 }
 
+int vfs_unlinkat(const vfs_dirat_t *dir, const char *name)
+{
+    DEBUG("vfs_unlinkat: %p, \"%s\"\n", (void *)dir, name);
+    char buf[VFS_DIRAT_PATH_MAX + VFS_NAME_MAX + 2];
+    const char *rel_path;
+    int res = _dirat_path(dir, name, buf, &rel_path);
+    if (res < 0) {
+        return res;
+    }
+    /* dir holds a reference on the mount for us */
+    return _unlink(dir->mp, rel_path);
+}
+
 int vfs_mkdir(const char *name, mode_t mode)
 {
     DEBUG("vfs_mkdir: \"%s\", 0%03lo\n", name, (long unsigned int)mode);
@@ -718,19 +964,29 @@ int vfs_stat(const char *restrict path, struct stat *restrict buf)
         DEBUG("vfs_stat: no matching mount\n");
         return res;
     }
-    if ((mountp->fs->fs_op == NULL) || (mountp->fs->fs_op->stat == NULL)) {
-        /* stat not supported */
-        DEBUG("vfs_stat: stat not supported by fs!\n");
-        /* remember to decrement the open_files count */
-        atomic_fetch_sub(&mountp->open_files, 1);
-        return -EPERM;
-    }
-    res = mountp->fs->fs_op->stat(mountp, rel_path, buf);
+    res = _stat(mountp, rel_path, buf);
     /* remember to decrement the open_files count */
     atomic_fetch_sub(&mountp->open_files, 1);
     return res;
 }
 
+int vfs_statat(const vfs_dirat_t *dir, const char *restrict name,
+               struct stat *restrict buf)
+{
+    DEBUG("vfs_statat: %p, \"%s\", %p\n", (void *)dir, name, (void *)buf);
+    if (buf == NULL) {
+        return -EINVAL;
+    }
+    char path[VFS_DIRAT_PATH_MAX + VFS_NAME_MAX + 2];
+    const char *rel_path;
+    int res = _dirat_path(dir, name, path, &rel_path);
+    if (res < 0) {
+        return res;
+    }
+    /* dir holds a reference on the mount for us */
+    return _stat(dir->mp, rel_path, buf);
+}
+
 int vfs_statvfs(const char *restrict path, struct statvfs *restrict buf)
 {
     DEBUG("vfs_statvfs: \"%s\", %p\n", path, (void *)buf);
@@ -922,6 +1178,18 @@ static inline int _init_fd(int fd, const vfs_file_ops_t *f_op, vfs_mount_t *moun
     return fd;
 }
 
+#if VFS_PATH_CACHE_SIZE
+static inline _path_cache_entry_t *_path_cache_slot(const char *dir, size_t dir_len)
+{
+    /* djb2 */
+    uint32_t hash = 5381;
+    for (size_t i = 0; i < dir_len; i++) {
+        hash = ((hash << 5) + hash) + (uint8_t)dir[i];
+    }
+    return &_path_cache[hash % VFS_PATH_CACHE_SIZE];
+}
+#endif
+
 static inline int _find_mount(vfs_mount_t **mountpp, const char *name, const char **rel_path)
 {
     size_t longest_match = 0;
@@ -935,10 +1203,40 @@ static inline int _find_mount(vfs_mount_t **mountpp, const char *name, const cha
         return -ENOENT;
     }
     vfs_mount_t *mountp = NULL;
-    do {
+#if VFS_PATH_CACHE_SIZE
+    /* The mount of a file is determined by its directory name, unless a mount
+     * point lives inside that directory. Use the cache if the directory name
+     * fits, the check for nested mount points is done when filling it. */
+    _path_cache_entry_t *entry = NULL;
+    const char *sep = strrchr(name, '/');
+    size_t dir_len = (sep != NULL) ? (size_t)(sep - name) : 0;
+    if ((sep != NULL) && (dir_len <= VFS_PATH_CACHE_NAME_MAX)) {
+        entry = _path_cache_slot(name, dir_len);
+        if ((entry->mp != NULL) && (entry->dir_len == dir_len) &&
+            (memcmp(entry->dir, name, dir_len) == 0)) {
+            DEBUG("vfs: _find_mount: cache hit \"%s\"\n", name);
+            mountp = entry->mp;
+            longest_match = entry->match_len;
+            /* skip the mount table search below */
+            node = NULL;
+        }
+    }
+#endif
+    while (node != NULL) {
         node = node->next;
         vfs_mount_t *it = container_of(node, vfs_mount_t, list_entry);
         size_t len = it->mount_point_len;
+#if VFS_PATH_CACHE_SIZE
+        if ((entry != NULL) && (len > dir_len) && (it->mount_point[dir_len] == '/') &&
+            (strncmp(name, it->mount_point, dir_len) == 0)) {
+            /* mount point inside the directory of name, can not be cached */
+            entry = NULL;
+        }
+#endif
+        if (node == _vfs_mounts_list.next) {
+            /* last iteration */
+            node = NULL;
+        }
         if (len < longest_match) {
             /* Already found a longer prefix */
             continue;
@@ -959,12 +1257,21 @@ static inline int _find_mount(vfs_mount_t **mountpp, const char *name, const cha
             }
             mountp = it;
         }
-    } while (node != _vfs_mounts_list.next);
+    }
     if (mountp == NULL) {
         /* not found */
         mutex_unlock(&_mount_mutex);
         return -ENOENT;
     }
+#if VFS_PATH_CACHE_SIZE
+    if ((entry != NULL) && (entry->mp != mountp || entry->dir_len != dir_len ||
+                            memcmp(entry->dir, name, dir_len) != 0)) {
+        entry->mp = mountp;
+        entry->match_len = longest_match;
+        entry->dir_len = dir_len;
+        memcpy(entry->dir, name, dir_len);
+    }
+#endif
     /* Increment open files counter for this mount */
     atomic_fetch_add(&mountp->open_files, 1);
     mutex_unlock(&_mount_mutex);
@@ -975,6 +1282,89 @@ static inline int _find_mount(vfs_mount_t **mountpp, const char *name, const cha
     return 0;
 }
 
+static int _dirat_path(const vfs_dirat_t *dir, const char *name, char *buf,
+                       const char **rel_path)
+{
+    if ((dir == NULL) || (name == NULL)) {
+        return -EINVAL;
+    }
+    if (dir->mp == NULL) {
+        return -EBADF;
+    }
+    /* name must be a single entry of dir, so it can not leave it */
+    if ((name[0] == '\0') || (strchr(name, '/') != NULL) ||
+        (strcmp(name, ".") == 0) || (strcmp(name, "..") == 0)) {
+        return -EINVAL;
+    }
+    size_t name_len = strlen(name);
+    if (name_len > VFS_NAME_MAX) {
+        return -ENAMETOOLONG;
+    }
+    memcpy(buf, dir->path, dir->path_len);
+    buf[dir->path_len] = '/';
+    memcpy(&buf[dir->path_len + 1], name, name_len + 1);
+    /* same as _find_mount: mount_point == "/" is not stripped */
+    size_t len = dir->mp->mount_point_len;
+    *rel_path = &buf[(len > 1) ? len : 0];
+    return 0;
+}
+
+static int _open(vfs_mount_t *mountp, const char *rel_path, const char *abs_path,
+                 int flags, mode_t mode)
+{
+    mutex_lock(&_open_mutex);
+    int fd = _init_fd(VFS_ANY_FD, mountp->fs->f_op, mountp, flags, NULL);
+    mutex_unlock(&_open_mutex);
+    if (fd < 0) {
+        DEBUG("vfs_open: _init_fd: ERR %d!\n", fd);
+        /* remember to decrement the open_files count */
+        atomic_fetch_sub(&mountp->open_files, 1);
+        return fd;
+    }
+    vfs_file_t *filp = &_vfs_open_files[fd];
+    if (filp->f_op->open != NULL) {
+        int res = filp->f_op->open(filp, rel_path, flags, mode, abs_path);
+        if (res < 0) {
+            /* something went wrong during open */
+            DEBUG("vfs_open: open: ERR %d!\n", res);
+            /* clean up */
+            _free_fd(fd);
+            return res;
+        }
+    }
+    DEBUG("vfs_open: opened %d\n", fd);
+    return fd;
+}
+
+static int _unlink(vfs_mount_t *mountp, const char *rel_path)
+{
+    if ((mountp->fs->fs_op == NULL) || (mountp->fs->fs_op->unlink == NULL)) {
+        /* unlink not supported */
+        DEBUG("vfs_unlink: unlink not supported by fs!\n");
+        return -EPERM;
+    }
+    int res = mountp->fs->fs_op->unlink(mountp, rel_path);
+    DEBUG("vfs_unlink: unlink %p, \"%s\"", (void *)mountp, rel_path);
+    if (res < 0) {
+        /* something went wrong during unlink */
+        DEBUG(": ERR %d!\n", res);
+    }
+    else {
+        DEBUG("\n");
+    }
+    return res;
+}
+
+static int _stat(vfs_mount_t *mountp, const char *rel_path, struct stat *buf)
+{
+    if ((mountp->fs->fs_op == NULL) || (mountp->fs->fs_op->stat == NULL)) {
+        /* stat not supported */
+        DEBUG("vfs_stat: stat not supported by fs!\n");
+        return -EPERM;
+    }
+    return mountp->fs->fs_op->stat(mountp, rel_path, buf);
+}
+
 static inline int _fd_is_valid(int fd)
 {
     if ((unsigned int)fd >= VFS_MAX_OPEN_FILES) {
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Asymcute MQTT-SN test application
+ *
+ * Drives the publish window, the topic ID cache and gathered publishes of
+ * asymcute against the gateway in tests/01-run.py.
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "net/asymcute.h"
+#include "net/sock/util.h"
+#include "shell.h"
+#include "thread.h"
+
+#define LISTENER_PRIO       (THREAD_PRIORITY_MAIN - 1)
+#define CLI_ID              "asymcute-test"
+
+/* enough publishes to fill the publish window twice */
+#define PUB_NUMOF           (2 * ASYMCUTE_PUBLISH_WINDOW)
+
+#define MAIN_QUEUE_SIZE     (8)
+static msg_t _main_msg_queue[MAIN_QUEUE_SIZE];
+
+static char _listener_stack[ASYMCUTE_LISTENER_STACKSIZE];
+
+static asymcute_con_t _con;
+static asymcute_req_t _req;
+static asymcute_topic_t _topic;
+
+static asymcute_req_t _pub_reqs[PUB_NUMOF];
+static char _pub_nums[PUB_NUMOF][4];
+static iolist_t _pub_data[PUB_NUMOF][2];
+
+static void _on_con_evt(asymcute_req_t *req, unsigned evt_type)
+{
+    const char *ctx = "";
+    char num[8];
+
+    if ((req >= &_pub_reqs[0]) && (req < &_pub_reqs[PUB_NUMOF])) {
+        snprintf(num, sizeof(num), " %u", (unsigned)(req - _pub_reqs));
+        ctx = num;
+    }
+    switch (evt_type) {
+        case ASYMCUTE_CONNECTED:
+            puts("connected");
+            break;
+        case ASYMCUTE_DISCONNECTED:
+            /* registrations are only valid within a connection */
+            asymcute_topic_reset(&_topic);
+            puts("disconnected");
+            break;
+        case ASYMCUTE_REGISTERED:
+            printf("registered %s %u\n", _topic.name, (unsigned)_topic.id);
+            break;
+        case ASYMCUTE_PUBLISHED:
+            printf("published%s\n", ctx);
+            break;
+        case ASYMCUTE_TIMEOUT:
+            printf("timeout%s\n", ctx);
+            break;
+        case ASYMCUTE_REJECTED:
+            printf("rejected%s\n", ctx);
+            break;
+        case ASYMCUTE_CANCELED:
+            printf("canceled%s\n", ctx);
+            break;
+        default:
+            printf("event %u%s\n", evt_type, ctx);
+            break;
+    }
+}
+
+static int _cmd_con(int argc, char **argv)
+{
+    sock_udp_ep_t gw;
+
+    if (argc < 3) {
+        printf("usage: %s <[addr]:port> <clean session (0|1)>\n", argv[0]);
+        return 1;
+    }
+    if (sock_udp_str2ep(&gw, argv[1]) != 0) {
+        puts("error: unable to parse gateway address");
+        return 1;
+    }
+    if (gw.port == 0) {
+        gw.port = MQTTSN_DEFAULT_PORT;
+    }
+    int res = asymcute_connect(&_con, &_req, &gw, CLI_ID, atoi(argv[2]),
+                               NULL);
+    if (res != ASYMCUTE_OK) {
+        printf("error: unable to connect (%d)\n", res);
+        return 1;
+    }
+    return 0;
+}
+
+static int _cmd_discon(int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+
+    int res = asymcute_disconnect(&_con, &_req);
+    if (res != ASYMCUTE_OK) {
+        printf("error: unable to disconnect (%d)\n", res);
+        return 1;
+    }
+    return 0;
+}
+
+static int _cmd_reg(int argc, char **argv)
+{
+    if (argc < 2) {
+        printf("usage: %s <topic>\n", argv[0]);
+        return 1;
+    }
+    asymcute_topic_reset(&_topic);
+    if (asymcute_topic_init(&_topic, argv[1], 0) != ASYMCUTE_OK) {
+        puts("error: unable to initialize topic");
+        return 1;
+    }
+    int res = asymcute_register(&_con, &_req, &_topic);
+    if (res != ASYMCUTE_OK) {
+        printf("error: unable to register (%d)\n", res);
+        return 1;
+    }
+    return 0;
+}
+
+static int _cmd_pub(int argc, char **argv)
+{
+    if (argc < 2) {
+        printf("usage: %s <count>\n", argv[0]);
+        return 1;
+    }
+    unsigned count = atoi(argv[1]);
+    if (count > PUB_NUMOF) {
+        printf("error: at most %u publishes\n", (unsigned)PUB_NUMOF);
+        return 1;
+    }
+    /* payload "pub-<n>" is gathered from two buffers */
+    for (unsigned i = 0; i < count; i++) {
+        snprintf(_pub_nums[i], sizeof(_pub_nums[i]), "%u", i);
+        _pub_data[i][0].iol_next = &_pub_data[i][1];
+        _pub_data[i][0].iol_base = "pub-";
+        _pub_data[i][0].iol_len = 4;
+        _pub_data[i][1].iol_next = NULL;
+        _pub_data[i][1].iol_base = _pub_nums[i];
+        _pub_data[i][1].iol_len = strlen(_pub_nums[i]);
+
+        int res = asymcute_publishv(&_con, &_pub_reqs[i], &_topic,
+                                    _pub_data[i], MQTTSN_QOS_1);
+        if (res != ASYMCUTE_OK) {
+            printf("error: unable to publish %u (%d)\n", i, res);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static const shell_command_t _shell_commands[] = {
+    { "con", "connect to gateway", _cmd_con },
+    { "discon", "disconnect from gateway", _cmd_discon },
+    { "reg", "register topic", _cmd_reg },
+    { "pub", "publish with QoS 1", _cmd_pub },
+    { NULL, NULL, NULL },
+};
+
+int main(void)
+{
+    msg_init_queue(_main_msg_queue, MAIN_QUEUE_SIZE);
+    asymcute_listener_run(&_con, _listener_stack, sizeof(_listener_stack),
+                          LISTENER_PRIO, _on_con_evt);
+
+    char line_buf[SHELL_DEFAULT_BUFSIZE];
+    shell_run(_shell_commands, line_buf, SHELL_DEFAULT_BUFSIZE);
+    return 0;
+}
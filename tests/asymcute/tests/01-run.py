@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Freie Universität Berlin
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import os
+import re
+import socket
+import struct
+import subprocess
+import sys
+import time
+
+from testrunner import run
+
+SERVER_PORT = 1883
+TIMEOUT = 5
+TOPIC_NAME = "/test"
+TOPIC_ID = 0x42
+PUBLISH_WINDOW = 4          # ASYMCUTE_PUBLISH_WINDOW
+PUB_NUMOF = 2 * PUBLISH_WINDOW
+
+CONNECT = 0x04
+CONNACK = 0x05
+REGISTER = 0x0a
+REGACK = 0x0b
+PUBLISH = 0x0c
+PUBACK = 0x0d
+DISCONNECT = 0x18
+
+FLAG_QOS_1 = 0x20
+
+
+class Gateway:
+    """Minimal MQTT-SN gateway answering one client on a plain UDP socket"""
+
+    def __init__(self, bind_addr, bind_port=SERVER_PORT):
+        info = socket.getaddrinfo(bind_addr, bind_port, socket.AF_INET6,
+                                  socket.SOCK_DGRAM)[0]
+        self.sock = socket.socket(info[0], info[1])
+        self.sock.bind(info[4])
+        self.sock.settimeout(TIMEOUT)
+        self.remote = None
+
+    def close(self):
+        self.sock.close()
+
+    def recv(self, exp_type):
+        data, self.remote = self.sock.recvfrom(1024)
+        assert len(data) >= 2 and data[0] == len(data), data
+        assert data[1] == exp_type, \
+            "expected type 0x{:02x}, got {}".format(exp_type, data)
+        return data[2:]
+
+    def expect_nothing(self, timeout=1):
+        self.sock.settimeout(timeout)
+        try:
+            data, _ = self.sock.recvfrom(1024)
+            raise AssertionError("unexpected message {}".format(data))
+        except socket.timeout:
+            pass
+        finally:
+            self.sock.settimeout(TIMEOUT)
+
+    def send(self, msg_type, body=b""):
+        self.sock.sendto(bytes([len(body) + 2, msg_type]) + body, self.remote)
+
+
+def get_bridge(tap):
+    try:
+        output = subprocess.check_output(["bridge", "link"]).decode("utf-8")
+    except (OSError, subprocess.CalledProcessError):
+        return tap
+    m = re.search(r"{}.+master\s+(?P<master>[^\s]+)".format(tap), output)
+    return tap if m is None else m.group("master")
+
+
+def get_host_lladdr(tap):
+    output = subprocess.check_output(
+        ["ip", "addr", "show", "dev", tap, "scope", "link"]).decode("utf-8")
+    m = re.search(r"inet6\s+(?P<lladdr>[0-9A-Fa-f:]+)/\d+", output)
+    if m is None:
+        raise AssertionError(
+            "Can't find host link-local address on interface {}".format(tap))
+    return m.group("lladdr")
+
+
+def connect(child, gw, gw_addr, clean):
+    child.sendline("con [{}]:{} {}".format(gw_addr, SERVER_PORT, clean))
+    body = gw.recv(CONNECT)
+    assert body[1] == 0x01, "unexpected protocol ID"
+    assert body[4:] == b"asymcute-test", "unexpected client ID"
+    gw.send(CONNACK, b"\x00")
+    child.expect_exact("connected")
+
+
+def disconnect(child, gw):
+    child.sendline("discon")
+    gw.recv(DISCONNECT)
+    gw.send(DISCONNECT)
+    child.expect_exact("disconnected")
+
+
+def register(child, gw):
+    child.sendline("reg {}".format(TOPIC_NAME))
+    body = gw.recv(REGISTER)
+    _, mid = struct.unpack("!HH", body[:4])
+    assert body[4:] == TOPIC_NAME.encode(), "unexpected topic name"
+    gw.send(REGACK, struct.pack("!HHB", TOPIC_ID, mid, 0))
+    child.expect_exact("registered {} {}".format(TOPIC_NAME, TOPIC_ID))
+
+
+def publish(child, gw):
+    child.sendline("pub {}".format(PUB_NUMOF))
+    pending = []
+    for i in range(PUB_NUMOF):
+        if len(pending) == PUBLISH_WINDOW:
+            # the window is full: nothing may be sent before an ack
+            gw.expect_nothing()
+            for mid in pending:
+                gw.send(PUBACK, struct.pack("!HHB", TOPIC_ID, mid, 0))
+            pending = []
+        body = gw.recv(PUBLISH)
+        flags, tid, mid = struct.unpack("!BHH", body[:5])
+        assert flags & FLAG_QOS_1, "PUBLISH is not QoS 1"
+        assert tid == TOPIC_ID, "unexpected topic ID"
+        # the payload is gathered from two iolist snips on the node
+        assert body[5:] == "pub-{}".format(i).encode(), body[5:]
+        pending.append(mid)
+    for mid in pending:
+        gw.send(PUBACK, struct.pack("!HHB", TOPIC_ID, mid, 0))
+    for i in range(PUB_NUMOF):
+        child.expect(r"published (\d+)")
+
+
+def testfunc(child):
+    tap = get_bridge(os.environ["TAP"])
+    gw_addr = get_host_lladdr(tap) + "%" + tap
+    gw = Gateway(gw_addr)
+    # the node resolves the scope through its only interface
+    node_gw_addr = gw_addr.split("%")[0]
+
+    time.sleep(1)
+    try:
+        connect(child, gw, node_gw_addr, 1)
+        register(child, gw)
+        publish(child, gw)
+        disconnect(child, gw)
+
+        # same gateway, session kept: topic ID comes from the cache
+        connect(child, gw, node_gw_addr, 0)
+        child.sendline("reg {}".format(TOPIC_NAME))
+        child.expect_exact("registered {} {}".format(TOPIC_NAME, TOPIC_ID))
+        gw.expect_nothing()
+        disconnect(child, gw)
+
+        # clean session: the cache is flushed and REGISTER is sent again
+        connect(child, gw, node_gw_addr, 1)
+        register(child, gw)
+        disconnect(child, gw)
+    finally:
+        gw.close()
+    print("SUCCESS")
+
+
+if __name__ == "__main__":
+    sys.exit(run(testfunc, timeout=TIMEOUT, echo=False))
@@ -0,0 +1,369 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Freie Universität Berlin
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+"""CoAP load generator for the bench_coap application.
+
+Runs a configurable number of concurrent clients against the node for a fixed
+duration and reports throughput, latency percentiles and timeouts. Only the
+Python standard library is used, so the script runs on any host with a TAP
+interface towards the node.
+
+Example:
+
+    ./coap_load.py fe80::2%tap0 --mode mixed --concurrency 8 --duration 10
+"""
+
+import argparse
+import asyncio
+import json
+import os
+import random
+import socket
+import struct
+import sys
+import time
+
+
+COAP_PORT = 5683
+
+TYPE_CON = 0
+TYPE_NON = 1
+TYPE_ACK = 2
+TYPE_RST = 3
+
+CODE_GET = 1
+CODE_PUT = 3
+
+OPT_OBSERVE = 6
+OPT_URI_PATH = 11
+OPT_BLOCK2 = 23
+
+MODES = ("get", "put", "obs", "block", "mixed")
+
+
+def _opt_ext(val):
+    if val < 13:
+        return val, b""
+    if val < 269:
+        return 13, bytes([val - 13])
+    return 14, struct.pack("!H", val - 269)
+
+
+def _uint_opt(val):
+    if val == 0:
+        return b""
+    return val.to_bytes((val.bit_length() + 7) // 8, "big")
+
+
+def encode(mtype, code, mid, token, options, payload=b""):
+    """Encodes a CoAP message, `options` being (number, value) tuples"""
+    out = bytearray(struct.pack("!BBH", 0x40 | (mtype << 4) | len(token),
+                                code, mid))
+    out += token
+    last = 0
+    for num, val in sorted(options, key=lambda o: o[0]):
+        delta, delta_ext = _opt_ext(num - last)
+        length, length_ext = _opt_ext(len(val))
+        out.append((delta << 4) | length)
+        out += delta_ext + length_ext + val
+        last = num
+    if payload:
+        out.append(0xff)
+        out += payload
+    return bytes(out)
+
+
+def decode(data):
+    """Decodes a CoAP message into (type, code, mid, token, options, payload)
+
+    Returns None for malformed messages.
+    """
+    if len(data) < 4 or (data[0] >> 6) != 1:
+        return None
+    mtype = (data[0] >> 4) & 0x3
+    tkl = data[0] & 0xf
+    code = data[1]
+    mid = struct.unpack("!H", data[2:4])[0]
+    token = data[4:4 + tkl]
+    pos = 4 + tkl
+    options = {}
+    num = 0
+    try:
+        while pos < len(data) and data[pos] != 0xff:
+            delta = data[pos] >> 4
+            length = data[pos] & 0xf
+            pos += 1
+            for field in ("delta", "length"):
+                val = delta if field == "delta" else length
+                if val == 13:
+                    val = data[pos] + 13
+                    pos += 1
+                elif val == 14:
+                    val = struct.unpack("!H", data[pos:pos + 2])[0] + 269
+                    pos += 2
+                if field == "delta":
+                    delta = val
+                else:
+                    length = val
+            num += delta
+            options.setdefault(num, []).append(data[pos:pos + length])
+            pos += length
+    except IndexError:
+        return None
+    payload = data[pos + 1:] if pos < len(data) else b""
+    return mtype, code, mid, token, options, payload
+
+
+def path_options(path):
+    return [(OPT_URI_PATH, seg.encode()) for seg in path.strip("/").split("/")]
+
+
+def percentile(values, pct):
+    if not values:
+        return None
+    values = sorted(values)
+    idx = min(len(values) - 1, int(round(pct / 100 * (len(values) - 1))))
+    return values[idx]
+
+
+class Client(asyncio.DatagramProtocol):
+    """Shared endpoint matching responses to pending requests by token"""
+
+    def __init__(self):
+        self.transport = None
+        self.pending = {}
+        self.observers = {}
+        self.mid = random.randrange(0x10000)
+        self.token = random.randrange(1 << 32)
+
+    def connection_made(self, transport):
+        self.transport = transport
+
+    def next_mid(self):
+        self.mid = (self.mid + 1) & 0xffff
+        return self.mid
+
+    def next_token(self):
+        self.token = (self.token + 1) & 0xffffffff
+        return struct.pack("!I", self.token)
+
+    def datagram_received(self, data, addr):
+        msg = decode(data)
+        if msg is None:
+            return
+        mtype, code, mid, token, options, payload = msg
+        if mtype == TYPE_CON:
+            self.transport.sendto(encode(TYPE_ACK, 0, mid, b"", []), addr)
+        if code == 0:
+            # empty ACK of a separate response or RST
+            return
+        if token in self.observers and OPT_OBSERVE in options:
+            self.observers[token] += 1
+        fut = self.pending.pop(token, None)
+        if fut is not None and not fut.done():
+            fut.set_result(msg)
+
+    async def request(self, remote, code, options, payload=b"", timeout=2.0,
+                      token=None):
+        token = token or self.next_token()
+        fut = asyncio.get_event_loop().create_future()
+        self.pending[token] = fut
+        self.transport.sendto(encode(TYPE_CON, code, self.next_mid(), token,
+                                     options, payload), remote)
+        try:
+            return await asyncio.wait_for(fut, timeout)
+        finally:
+            self.pending.pop(token, None)
+
+
+class Stats:
+    def __init__(self):
+        self.latencies = {}
+        self.timeouts = {}
+        self.errors = {}
+        self.notifications = 0
+
+    def add(self, kind, latency):
+        self.latencies.setdefault(kind, []).append(latency)
+
+    def report(self, duration):
+        res = {"duration_s": duration, "modes": {}}
+        for kind in sorted(set(self.latencies) | set(self.timeouts) |
+                           set(self.errors)):
+            lat = self.latencies.get(kind, [])
+            p50 = percentile(lat, 50)
+            p99 = percentile(lat, 99)
+            res["modes"][kind] = {
+                "requests": len(lat),
+                "req_per_s": round(len(lat) / duration, 1),
+                "p50_ms": None if p50 is None else round(p50 * 1000, 3),
+                "p99_ms": None if p99 is None else round(p99 * 1000, 3),
+                "timeouts": self.timeouts.get(kind, 0),
+                "errors": self.errors.get(kind, 0),
+            }
+        if self.notifications:
+            res["notifications"] = self.notifications
+            res["notifications_per_s"] = round(self.notifications / duration,
+                                               1)
+        return res
+
+
+async def _timed(client, stats, kind, remote, code, options, payload=b"",
+                 timeout=2.0, token=None):
+    start = time.monotonic()
+    try:
+        msg = await client.request(remote, code, options, payload, timeout,
+                                   token)
+    except asyncio.TimeoutError:
+        stats.timeouts[kind] = stats.timeouts.get(kind, 0) + 1
+        return None
+    if (msg[1] >> 5) != 2:
+        stats.errors[kind] = stats.errors.get(kind, 0) + 1
+        return None
+    stats.add(kind, time.monotonic() - start)
+    return msg
+
+
+async def _block_transfer(client, stats, remote, szx, timeout):
+    """Fetches /bench/block, the latency covering the whole transfer"""
+    start = time.monotonic()
+    num = 0
+    while True:
+        block = _uint_opt((num << 4) | szx)
+        try:
+            msg = await client.request(remote, CODE_GET,
+                                       path_options("/bench/block") +
+                                       [(OPT_BLOCK2, block)], timeout=timeout)
+        except asyncio.TimeoutError:
+            stats.timeouts["block"] = stats.timeouts.get("block", 0) + 1
+            return
+        if (msg[1] >> 5) != 2 or OPT_BLOCK2 not in msg[4]:
+            stats.errors["block"] = stats.errors.get("block", 0) + 1
+            return
+        val = int.from_bytes(msg[4][OPT_BLOCK2][0], "big")
+        if not val & 0x8:
+            break
+        # follow the block size the server chose
+        szx = val & 0x7
+        num = (val >> 4) + 1
+    stats.add("block", time.monotonic() - start)
+
+
+async def _worker(client, stats, remote, mode, deadline, args, idx):
+    payload = os.urandom(args.payload)
+    kinds = ("get", "put", "block")
+    i = idx
+    while time.monotonic() < deadline:
+        kind = kinds[i % len(kinds)] if mode == "mixed" else mode
+        i += 1
+        if kind == "get":
+            await _timed(client, stats, "get", remote, CODE_GET,
+                         path_options("/bench/get"), timeout=args.timeout)
+        elif kind == "put":
+            await _timed(client, stats, "put", remote, CODE_PUT,
+                         path_options("/bench/put"), payload,
+                         timeout=args.timeout)
+        else:
+            await _block_transfer(client, stats, remote, args.szx,
+                                  args.timeout)
+
+
+async def _observer(client, stats, remote, deadline, args):
+    token = client.next_token()
+    client.observers[token] = 0
+    # the registration response is the first notification
+    msg = await _timed(client, stats, "obs", remote, CODE_GET,
+                       [(OPT_OBSERVE, b"")] + path_options("/bench/obs"),
+                       timeout=args.timeout, token=token)
+    if msg is not None:
+        await asyncio.sleep(max(0, deadline - time.monotonic()))
+        try:
+            await client.request(remote, CODE_GET,
+                                 [(OPT_OBSERVE, _uint_opt(1))] +
+                                 path_options("/bench/obs"),
+                                 timeout=args.timeout, token=token)
+        except asyncio.TimeoutError:
+            pass
+    stats.notifications += client.observers.pop(token)
+
+
+async def run(host, args):
+    """Runs the load described by `args` against `host`
+
+    @return a dictionary with the results, see Stats.report()
+    """
+    loop = asyncio.get_event_loop()
+    info = socket.getaddrinfo(host, args.port, socket.AF_INET6,
+                              socket.SOCK_DGRAM)[0]
+    # the scope of link-local addresses is taken from the remote address
+    transport, client = await loop.create_datagram_endpoint(
+        Client, family=info[0])
+    remote = info[4]
+    stats = Stats()
+    start = time.monotonic()
+    deadline = start + args.duration
+    try:
+        if args.mode == "obs":
+            tasks = [_observer(client, stats, remote, deadline, args)
+                     for _ in range(args.concurrency)]
+        else:
+            tasks = [_worker(client, stats, remote, args.mode, deadline, args,
+                             i) for i in range(args.concurrency)]
+        await asyncio.gather(*tasks)
+    finally:
+        transport.close()
+    return stats.report(time.monotonic() - start)
+
+
+def parse_args(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("host",
+                        help="address of the node, e.g. fe80::2%%tap0")
+    parser.add_argument("-p", "--port", type=int, default=COAP_PORT)
+    parser.add_argument("-m", "--mode", choices=MODES, default="get")
+    parser.add_argument("-c", "--concurrency", type=int, default=1,
+                        help="number of outstanding requests (or observers)")
+    parser.add_argument("-d", "--duration", type=float, default=10.0,
+                        help="duration of the run in seconds")
+    parser.add_argument("-s", "--payload", type=int, default=64,
+                        help="payload size of PUT requests in bytes")
+    parser.add_argument("-z", "--szx", type=int, default=6,
+                        choices=range(7),
+                        help="initial block size exponent (size 2^(4+szx))")
+    parser.add_argument("-t", "--timeout", type=float, default=2.0,
+                        help="per-request timeout in seconds")
+    parser.add_argument("-j", "--json", action="store_true",
+                        help="print the results as JSON")
+    return parser.parse_args(argv)
+
+
+def main_loop(host, args):
+    """Runs the load to completion, returns the results of run()"""
+    return asyncio.get_event_loop().run_until_complete(run(host, args))
+
+
+def main(argv=None):
+    args = parse_args(argv)
+    res = main_loop(args.host, args)
+    if args.json:
+        print(json.dumps(res))
+        return 0
+    print("{:<6} {:>9} {:>9} {:>9} {:>9} {:>8} {:>6}".format(
+        "mode", "requests", "req/s", "p50 ms", "p99 ms", "timeouts", "errors"))
+    for kind, m in res["modes"].items():
+        print("{:<6} {:>9} {:>9} {:>9} {:>9} {:>8} {:>6}".format(
+            kind, m["requests"], m["req_per_s"], str(m["p50_ms"]),
+            str(m["p99_ms"]), m["timeouts"], m["errors"]))
+    if "notifications" in res:
+        print("notifications: {} ({}/s)".format(res["notifications"],
+                                                res["notifications_per_s"]))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
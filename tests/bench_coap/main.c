@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       CoAP server for load and latency benchmarks
+ *
+ * Serves resources for GET, PUT, Observe and block-wise traffic generated by
+ * coap_load.py, and reports request counts and resource usage with the
+ * `bench` shell command.
+ *
+ * @}
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "irq.h"
+#include "msg.h"
+#include "net/gcoap.h"
+#include "net/gnrc/pktbuf.h"
+#include "net/nanocoap_block.h"
+#include "schedstatistics.h"
+#include "shell.h"
+#include "thread.h"
+#include "xtimer.h"
+
+#ifndef BENCH_OBS_INTERVAL
+#define BENCH_OBS_INTERVAL  (20U * US_PER_MS)
+#endif
+
+#ifndef BENCH_BLOCK_SIZE
+#define BENCH_BLOCK_SIZE    (1024U)
+#endif
+
+#define MAIN_QUEUE_SIZE     (8)
+
+enum {
+    _GET,
+    _PUT,
+    _OBS,
+    _BLOCK,
+    _NUMOF,
+};
+
+static ssize_t _block_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                              void *ctx);
+static ssize_t _get_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                            void *ctx);
+static ssize_t _obs_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                            void *ctx);
+static ssize_t _put_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                            void *ctx);
+
+/* must be sorted by path */
+static const coap_resource_t _resources[] = {
+    { "/bench/block", COAP_GET, _block_handler, NULL },
+    { "/bench/get", COAP_GET, _get_handler, NULL },
+    { "/bench/obs", COAP_GET, _obs_handler, NULL },
+    { "/bench/put", COAP_PUT | COAP_POST, _put_handler, NULL },
+};
+
+static gcoap_listener_t _listener = {
+    .resources = _resources,
+    .resources_len = ARRAY_SIZE(_resources),
+};
+
+static const char *_names[] = { "get", "put", "obs", "block" };
+
+/* written by the gcoap thread only */
+static uint32_t _count[_NUMOF];
+static uint32_t _put_bytes;
+static uint32_t _obs_value;
+
+static char _notify_stack[THREAD_STACKSIZE_DEFAULT];
+static msg_t _main_msg_queue[MAIN_QUEUE_SIZE];
+
+static ssize_t _block_read(void *arg, size_t offset, uint8_t *buf, size_t len)
+{
+    (void)arg;
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = (uint8_t)(offset + i);
+    }
+    return len;
+}
+
+static ssize_t _block_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                              void *ctx)
+{
+    (void)ctx;
+    _count[_BLOCK]++;
+    return coap_block2_reply_stream(pdu, COAP_CODE_CONTENT, buf, len,
+                                    COAP_FORMAT_OCTET, BENCH_BLOCK_SIZE,
+                                    _block_read, NULL);
+}
+
+static ssize_t _get_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                            void *ctx)
+{
+    (void)ctx;
+    _count[_GET]++;
+    return coap_reply_simple(pdu, COAP_CODE_CONTENT, buf, len,
+                             COAP_FORMAT_TEXT, (uint8_t *)"ok", 2);
+}
+
+static ssize_t _obs_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                            void *ctx)
+{
+    (void)ctx;
+    _count[_OBS]++;
+    gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
+    coap_opt_add_format(pdu, COAP_FORMAT_TEXT);
+    size_t resp_len = coap_opt_finish(pdu, COAP_OPT_FINISH_PAYLOAD);
+
+    int n = snprintf((char *)pdu->payload, pdu->payload_len, "%" PRIu32,
+                     _obs_value);
+    return resp_len + n;
+}
+
+static ssize_t _put_handler(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                            void *ctx)
+{
+    (void)ctx;
+    _count[_PUT]++;
+    _put_bytes += pdu->payload_len;
+    return coap_reply_simple(pdu, COAP_CODE_CHANGED, buf, len,
+                             COAP_FORMAT_NONE, NULL, 0);
+}
+
+static void *_notify_thread(void *arg)
+{
+    (void)arg;
+    xtimer_ticks32_t last = xtimer_now();
+
+    while (1) {
+        xtimer_periodic_wakeup(&last, BENCH_OBS_INTERVAL);
+        _obs_value++;
+        /* -ENOENT while nobody observes */
+        gcoap_obs_notify(&_resources[_OBS]);
+    }
+    return NULL;
+}
+
+static void _print_stats(void)
+{
+    printf("{\"requests\": {");
+    for (unsigned i = 0; i < _NUMOF; i++) {
+        printf("%s\"%s\": %" PRIu32, i ? ", " : "", _names[i], _count[i]);
+    }
+    printf("}, \"put_bytes\": %" PRIu32, _put_bytes);
+#ifdef DEVELHELP
+    printf(", \"pktbuf_max\": %u", (unsigned)gnrc_pktbuf_max_used(false));
+#endif
+    printf(", \"threads\": [");
+    bool first = true;
+    for (kernel_pid_t i = KERNEL_PID_FIRST; i <= KERNEL_PID_LAST; i++) {
+        thread_t *p = (thread_t *)sched_threads[i];
+        if (p == NULL) {
+            continue;
+        }
+        unsigned state = irq_disable();
+        uint64_t runtime = sched_pidlist[i].runtime_ticks;
+        unsigned switches = sched_pidlist[i].schedules;
+        irq_restore(state);
+        xtimer_ticks64_t ticks = { runtime };
+
+        printf("%s{\"pid\": %d", first ? "" : ", ", (int)i);
+#ifdef DEVELHELP
+        printf(", \"name\": \"%s\", \"stack\": %d, \"stack_used\": %d", p->name,
+               p->stack_size,
+               (int)(p->stack_size - thread_measure_stack_free(p->stack_start)));
+#endif
+        printf(", \"runtime_us\": %" PRIu64 ", \"switches\": %u}",
+               xtimer_usec_from_ticks64(ticks), switches);
+        first = false;
+    }
+    puts("]}");
+}
+
+static void _reset_stats(void)
+{
+    unsigned state = irq_disable();
+    memset(_count, 0, sizeof(_count));
+    _put_bytes = 0;
+    for (kernel_pid_t i = KERNEL_PID_FIRST; i <= KERNEL_PID_LAST; i++) {
+        sched_pidlist[i].runtime_ticks = 0;
+        sched_pidlist[i].schedules = 0;
+    }
+    irq_restore(state);
+#ifdef DEVELHELP
+    gnrc_pktbuf_max_used(true);
+#endif
+}
+
+static int _bench_cmd(int argc, char **argv)
+{
+    if ((argc == 2) && (strcmp(argv[1], "stats") == 0)) {
+        _print_stats();
+        return 0;
+    }
+    if ((argc == 2) && (strcmp(argv[1], "reset") == 0)) {
+        _reset_stats();
+        puts("bench: statistics reset");
+        return 0;
+    }
+    printf("usage: %s stats|reset\n", argv[0]);
+    return 1;
+}
+
+static const shell_command_t _shell_commands[] = {
+    { "bench", "print or reset benchmark statistics", _bench_cmd },
+    { NULL, NULL, NULL }
+};
+
+int main(void)
+{
+    /* for the thread running the shell */
+    msg_init_queue(_main_msg_queue, MAIN_QUEUE_SIZE);
+
+    gcoap_register_listener(&_listener);
+    thread_create(_notify_stack, sizeof(_notify_stack),
+                  THREAD_PRIORITY_MAIN - 1, THREAD_CREATE_STACKTEST,
+                  _notify_thread, NULL, "bench notify");
+
+    puts("CoAP benchmark server");
+    char line_buf[SHELL_DEFAULT_BUFSIZE];
+    shell_run(_shell_commands, line_buf, SHELL_DEFAULT_BUFSIZE);
+
+    return 0;
+}
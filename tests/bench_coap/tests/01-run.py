@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Freie Universität Berlin
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import json
+import os
+import sys
+
+from testrunner import run
+
+sys.path.append(os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                             ".."))
+import coap_load   # noqa: E402
+
+
+BENCH_DURATION = float(os.environ.get("BENCH_DURATION", 2))
+BENCH_CONCURRENCY = int(os.environ.get("BENCH_CONCURRENCY", 4))
+
+
+def get_node_lladdr(child):
+    child.sendline("ifconfig")
+    child.expect(r"inet6 addr:\s+(?P<lladdr>fe80:[0-9a-f:]+)\s+scope:\s+link")
+    return child.match.group("lladdr")
+
+
+def get_stats(child):
+    child.sendline("bench stats")
+    child.expect(r"(\{\"requests\".+\})\r?\n")
+    return json.loads(child.match.group(1))
+
+
+def testfunc(child):
+    tap = os.environ["TAP"]
+    host = "{}%{}".format(get_node_lladdr(child), tap)
+
+    child.sendline("bench reset")
+    child.expect_exact("bench: statistics reset")
+    for mode in coap_load.MODES:
+        args = coap_load.parse_args([host, "-m", mode,
+                                     "-c", str(BENCH_CONCURRENCY),
+                                     "-d", str(BENCH_DURATION), "-j"])
+        res = coap_load.main_loop(host, args)
+        print(json.dumps({mode: res}))
+        for kind, m in res["modes"].items():
+            assert m["requests"] > 0, "no {} requests answered".format(kind)
+        if mode == "obs":
+            assert res.get("notifications", 0) > 0
+
+    stats = get_stats(child)
+    print(json.dumps(stats))
+    for kind in ("get", "put", "obs", "block"):
+        assert stats["requests"][kind] > 0
+    assert stats["put_bytes"] > 0
+    assert any(t["runtime_us"] > 0 for t in stats["threads"])
+    print("SUCCESS")
+
+
+if __name__ == "__main__":
+    sys.exit(run(testfunc, timeout=60))
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Measure throughput of tsrb, ringbuffer and isrpipe
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "benchmark.h"
+#include "isrpipe.h"
+#include "ringbuffer.h"
+#include "tsrb.h"
+
+#ifndef BENCH_RUNS
+#define BENCH_RUNS          (10UL * 1000UL)
+#endif
+
+#ifndef BENCH_BLOCK
+#define BENCH_BLOCK         (48U)
+#endif
+
+/* not a multiple of BENCH_BLOCK, so transfers wrap around */
+#define BUF_SIZE            (128U)
+
+static uint8_t _src[BENCH_BLOCK];
+static uint8_t _dst[BENCH_BLOCK];
+
+static uint8_t _tsrb_buf[BUF_SIZE];
+static tsrb_t _tsrb = TSRB_INIT(_tsrb_buf);
+
+static char _rb_buf[BUF_SIZE];
+static ringbuffer_t _rb = RINGBUFFER_INIT(_rb_buf);
+
+static uint8_t _pipe_buf[BUF_SIZE];
+static isrpipe_t _pipe = ISRPIPE_INIT(_pipe_buf);
+
+static void _tsrb_bytewise(void)
+{
+    for (unsigned i = 0; i < BENCH_BLOCK; i++) {
+        tsrb_add_one(&_tsrb, _src[i]);
+    }
+    for (unsigned i = 0; i < BENCH_BLOCK; i++) {
+        _dst[i] = tsrb_get_one(&_tsrb);
+    }
+}
+
+static void _tsrb_bulk(void)
+{
+    tsrb_add(&_tsrb, _src, BENCH_BLOCK);
+    tsrb_get(&_tsrb, _dst, BENCH_BLOCK);
+}
+
+static void _tsrb_iov(void)
+{
+    struct iovec iov[2];
+
+    tsrb_reserve_iov(&_tsrb, iov, BENCH_BLOCK);
+    memcpy(iov[0].iov_base, _src, iov[0].iov_len);
+    memcpy(iov[1].iov_base, _src + iov[0].iov_len, iov[1].iov_len);
+    tsrb_commit(&_tsrb, BENCH_BLOCK);
+
+    tsrb_peek_iov(&_tsrb, iov, BENCH_BLOCK);
+    memcpy(_dst, iov[0].iov_base, iov[0].iov_len);
+    memcpy(_dst + iov[0].iov_len, iov[1].iov_base, iov[1].iov_len);
+    tsrb_drop(&_tsrb, BENCH_BLOCK);
+}
+
+static void _rb_bytewise(void)
+{
+    for (unsigned i = 0; i < BENCH_BLOCK; i++) {
+        ringbuffer_add_one(&_rb, _src[i]);
+    }
+    for (unsigned i = 0; i < BENCH_BLOCK; i++) {
+        _dst[i] = ringbuffer_get_one(&_rb);
+    }
+}
+
+static void _rb_bulk(void)
+{
+    ringbuffer_add(&_rb, (char *)_src, BENCH_BLOCK);
+    ringbuffer_get(&_rb, (char *)_dst, BENCH_BLOCK);
+}
+
+static void _pipe_bytewise(void)
+{
+    for (unsigned i = 0; i < BENCH_BLOCK; i++) {
+        isrpipe_write_one(&_pipe, _src[i]);
+    }
+    isrpipe_read(&_pipe, _dst, BENCH_BLOCK);
+}
+
+static void _pipe_bulk(void)
+{
+    isrpipe_write(&_pipe, _src, BENCH_BLOCK);
+    isrpipe_read(&_pipe, _dst, BENCH_BLOCK);
+}
+
+static int _check(void)
+{
+    int res = memcmp(_src, _dst, BENCH_BLOCK);
+
+    memset(_dst, 0, sizeof(_dst));
+    return res;
+}
+
+int main(void)
+{
+    int res = 0;
+
+    puts("Throughput of ringbuffer implementations\n");
+    printf("%u bytes per call\n\n", BENCH_BLOCK);
+
+    for (unsigned i = 0; i < BENCH_BLOCK; i++) {
+        _src[i] = i;
+    }
+
+    BENCHMARK_FUNC("tsrb bytewise", BENCH_RUNS, _tsrb_bytewise());
+    res |= _check();
+    BENCHMARK_FUNC("tsrb bulk", BENCH_RUNS, _tsrb_bulk());
+    res |= _check();
+    BENCHMARK_FUNC("tsrb iov", BENCH_RUNS, _tsrb_iov());
+    res |= _check();
+    puts("");
+    BENCHMARK_FUNC("ringbuffer bytewise", BENCH_RUNS, _rb_bytewise());
+    res |= _check();
+    BENCHMARK_FUNC("ringbuffer bulk", BENCH_RUNS, _rb_bulk());
+    res |= _check();
+    puts("");
+    BENCHMARK_FUNC("isrpipe bytewise", BENCH_RUNS, _pipe_bytewise());
+    res |= _check();
+    BENCHMARK_FUNC("isrpipe bulk", BENCH_RUNS, _pipe_bulk());
+    res |= _check();
+
+    puts(res ? "\n[FAILED]" : "\n[SUCCESS]");
+    return 0;
+}
@@ -0,0 +1,26 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Freie Universität Berlin
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import sys
+from testrunner import run
+
+
+BENCHMARK_REGEXP = r"\s+{func}:\s+\d+us\s+---\s+\d*\.*\d+us per call\s+---\s+\d+ calls per sec"
+
+
+def testfunc(child):
+    child.expect_exact('Throughput of ringbuffer implementations')
+    for func in ("tsrb bytewise", "tsrb bulk", "tsrb iov",
+                 "ringbuffer bytewise", "ringbuffer bulk",
+                 "isrpipe bytewise", "isrpipe bulk"):
+        child.expect(BENCHMARK_REGEXP.format(func=func))
+    child.expect_exact('[SUCCESS]')
+
+
+if __name__ == "__main__":
+    sys.exit(run(testfunc))
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Runtime of selected core API functions
+ *
+ * @}
+ */
+
+#include "benchmark.h"
+#include "bench_suite.h"
+#include "kernel_defines.h"
+#include "msg.h"
+#include "mutex.h"
+#include "thread.h"
+#include "thread_flags.h"
+
+#define FLAG        (0x0001)
+
+static mutex_t _lock;
+static thread_t *_me;
+static msg_t _msg;
+
+static void _nop(void *arg)
+{
+    (void)arg;
+    __asm__ volatile ("nop");
+}
+
+static void _mutex_init(void *arg)
+{
+    (void)arg;
+    mutex_init(&_lock);
+}
+
+static void _mutex_lockunlock(void *arg)
+{
+    (void)arg;
+    mutex_lock(&_lock);
+    mutex_unlock(&_lock);
+}
+
+static void _flags_set(void *arg)
+{
+    (void)arg;
+    thread_flags_set(_me, FLAG);
+}
+
+static void _flags_clear(void *arg)
+{
+    (void)arg;
+    thread_flags_clear(FLAG);
+}
+
+static void _flags_waitany(void *arg)
+{
+    (void)arg;
+    thread_flags_set(_me, FLAG);
+    thread_flags_wait_any(FLAG);
+}
+
+static void _msg_try_receive(void *arg)
+{
+    (void)arg;
+    msg_try_receive(&_msg);
+}
+
+static void _msg_avail(void *arg)
+{
+    (void)arg;
+    msg_avail();
+}
+
+static benchmark_t _benchmarks[] = {
+    BENCHMARK_INIT("nop loop", _nop, NULL, 1000),
+    BENCHMARK_INIT("mutex_init()", _mutex_init, NULL, 1000),
+    BENCHMARK_INIT("mutex lock/unlock", _mutex_lockunlock, NULL, 1000),
+    BENCHMARK_INIT("thread_flags_set()", _flags_set, NULL, 1000),
+    BENCHMARK_INIT("thread_flags_clear()", _flags_clear, NULL, 1000),
+    BENCHMARK_INIT("thread flags set/wait any", _flags_waitany, NULL, 1000),
+    BENCHMARK_INIT("msg_try_receive()", _msg_try_receive, NULL, 1000),
+    BENCHMARK_INIT("msg_avail()", _msg_avail, NULL, 1000),
+};
+
+void bench_core_register(void)
+{
+    _me = (thread_t *)sched_active_thread;
+
+    for (unsigned i = 0; i < ARRAY_SIZE(_benchmarks); i++) {
+        benchmark_register(&_benchmarks[i]);
+    }
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Context switch benchmarks
+ *
+ * Each call wakes up a higher priority thread, which immediately blocks
+ * again, so every call measures two context switches.
+ *
+ * @}
+ */
+
+#include "benchmark.h"
+#include "bench_suite.h"
+#include "kernel_defines.h"
+#include "msg.h"
+#include "mutex.h"
+#include "thread.h"
+#include "thread_flags.h"
+
+static char _mutex_stack[THREAD_STACKSIZE_DEFAULT];
+static char _flags_stack[THREAD_STACKSIZE_DEFAULT];
+static char _msg_stack[THREAD_STACKSIZE_DEFAULT];
+
+static mutex_t _mutex = MUTEX_INIT;
+static thread_t *_flags_thread;
+static kernel_pid_t _msg_pid;
+
+static void *_mutex_thread(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        mutex_lock(&_mutex);
+    }
+
+    return NULL;
+}
+
+static void *_flags_waiter(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        thread_flags_wait_any(0x0 - 1);
+    }
+
+    return NULL;
+}
+
+static void *_msg_receiver(void *arg)
+{
+    (void)arg;
+    msg_t msg;
+
+    while (1) {
+        msg_receive(&msg);
+    }
+
+    return NULL;
+}
+
+static kernel_pid_t _start(char *stack, size_t size, thread_task_func_t func,
+                           const char *name)
+{
+    return thread_create(stack, size, THREAD_PRIORITY_MAIN - 1,
+                         THREAD_CREATE_STACKTEST, func, NULL, name);
+}
+
+static void _mutex_setup(void *arg)
+{
+    (void)arg;
+    /* lock the mutex, then let the other thread block on it */
+    mutex_lock(&_mutex);
+    _start(_mutex_stack, sizeof(_mutex_stack), _mutex_thread, "bench_mutex");
+}
+
+static void _mutex_pingpong(void *arg)
+{
+    (void)arg;
+    mutex_unlock(&_mutex);
+}
+
+static void _flags_setup(void *arg)
+{
+    (void)arg;
+    kernel_pid_t pid = _start(_flags_stack, sizeof(_flags_stack),
+                              _flags_waiter, "bench_flags");
+    _flags_thread = (thread_t *)sched_threads[pid];
+}
+
+static void _flags_pingpong(void *arg)
+{
+    (void)arg;
+    thread_flags_set(_flags_thread, 0x1);
+}
+
+static void _msg_setup(void *arg)
+{
+    (void)arg;
+    _msg_pid = _start(_msg_stack, sizeof(_msg_stack), _msg_receiver,
+                      "bench_msg");
+}
+
+static void _msg_pingpong(void *arg)
+{
+    (void)arg;
+    msg_t msg;
+
+    msg_send(&msg, _msg_pid);
+}
+
+static benchmark_t _benchmarks[] = {
+    {
+        .name = "mutex pingpong",
+        .func = _mutex_pingpong,
+        .setup = _mutex_setup,
+        .runs = 100,
+        .flags = BENCHMARK_FLAG_IRQ,
+    },
+    {
+        .name = "thread flags pingpong",
+        .func = _flags_pingpong,
+        .setup = _flags_setup,
+        .runs = 100,
+        .flags = BENCHMARK_FLAG_IRQ,
+    },
+    {
+        .name = "msg pingpong",
+        .func = _msg_pingpong,
+        .setup = _msg_setup,
+        .runs = 100,
+        .flags = BENCHMARK_FLAG_IRQ,
+    },
+};
+
+void bench_pingpong_register(void)
+{
+    for (unsigned i = 0; i < ARRAY_SIZE(_benchmarks); i++) {
+        benchmark_register(&_benchmarks[i]);
+    }
+}
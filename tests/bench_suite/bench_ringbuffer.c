@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Throughput of tsrb, ringbuffer and isrpipe
+ *
+ * @}
+ */
+
+#include <stdint.h>
+
+#include "benchmark.h"
+#include "bench_suite.h"
+#include "isrpipe.h"
+#include "kernel_defines.h"
+#include "ringbuffer.h"
+#include "tsrb.h"
+
+#ifndef BENCH_BLOCK
+#define BENCH_BLOCK         (48U)
+#endif
+
+/* not a multiple of BENCH_BLOCK, so transfers wrap around */
+#define BUF_SIZE            (128U)
+
+static uint8_t _src[BENCH_BLOCK];
+static uint8_t _dst[BENCH_BLOCK];
+
+static uint8_t _tsrb_buf[BUF_SIZE];
+static tsrb_t _tsrb = TSRB_INIT(_tsrb_buf);
+
+static char _rb_buf[BUF_SIZE];
+static ringbuffer_t _rb = RINGBUFFER_INIT(_rb_buf);
+
+static uint8_t _pipe_buf[BUF_SIZE];
+static isrpipe_t _pipe = ISRPIPE_INIT(_pipe_buf);
+
+static void _tsrb_bytewise(void *arg)
+{
+    (void)arg;
+    for (unsigned i = 0; i < BENCH_BLOCK; i++) {
+        tsrb_add_one(&_tsrb, _src[i]);
+    }
+    for (unsigned i = 0; i < BENCH_BLOCK; i++) {
+        _dst[i] = tsrb_get_one(&_tsrb);
+    }
+}
+
+static void _tsrb_bulk(void *arg)
+{
+    (void)arg;
+    tsrb_add(&_tsrb, _src, BENCH_BLOCK);
+    tsrb_get(&_tsrb, _dst, BENCH_BLOCK);
+}
+
+static void _rb_bytewise(void *arg)
+{
+    (void)arg;
+    for (unsigned i = 0; i < BENCH_BLOCK; i++) {
+        ringbuffer_add_one(&_rb, _src[i]);
+    }
+    for (unsigned i = 0; i < BENCH_BLOCK; i++) {
+        _dst[i] = ringbuffer_get_one(&_rb);
+    }
+}
+
+static void _rb_bulk(void *arg)
+{
+    (void)arg;
+    ringbuffer_add(&_rb, (char *)_src, BENCH_BLOCK);
+    ringbuffer_get(&_rb, (char *)_dst, BENCH_BLOCK);
+}
+
+static void _pipe_bulk(void *arg)
+{
+    (void)arg;
+    isrpipe_write(&_pipe, _src, BENCH_BLOCK);
+    isrpipe_read(&_pipe, _dst, BENCH_BLOCK);
+}
+
+static benchmark_t _benchmarks[] = {
+    BENCHMARK_INIT("tsrb bytewise", _tsrb_bytewise, NULL, 10),
+    BENCHMARK_INIT("tsrb bulk", _tsrb_bulk, NULL, 10),
+    BENCHMARK_INIT("ringbuffer bytewise", _rb_bytewise, NULL, 10),
+    BENCHMARK_INIT("ringbuffer bulk", _rb_bulk, NULL, 10),
+    BENCHMARK_INIT("isrpipe bulk", _pipe_bulk, NULL, 10),
+};
+
+void bench_ringbuffer_register(void)
+{
+    for (unsigned i = 0; i < BENCH_BLOCK; i++) {
+        _src[i] = i;
+    }
+    for (unsigned i = 0; i < ARRAY_SIZE(_benchmarks); i++) {
+        benchmark_register(&_benchmarks[i]);
+    }
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Benchmarks of the benchmark suite
+ */
+
+#ifndef BENCH_SUITE_H
+#define BENCH_SUITE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Register benchmarks of selected core API functions
+ */
+void bench_core_register(void);
+
+/**
+ * @brief   Register context switch benchmarks
+ */
+void bench_pingpong_register(void);
+
+/**
+ * @brief   Register ringbuffer benchmarks
+ */
+void bench_ringbuffer_register(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BENCH_SUITE_H */
+/** @} */
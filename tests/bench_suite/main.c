@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Suite of core benchmarks
+ *
+ * @}
+ */
+
+#include <stdio.h>
+
+#include "benchmark.h"
+#include "bench_suite.h"
+
+#ifndef BENCH_OUTPUT
+#define BENCH_OUTPUT        BENCHMARK_OUTPUT_JSON
+#endif
+
+int main(void)
+{
+    puts("Benchmark suite\n");
+
+    bench_core_register();
+    bench_ringbuffer_register();
+    bench_pingpong_register();
+
+    unsigned count = benchmark_run_all(BENCH_OUTPUT);
+
+    printf("\n%u benchmarks run\n", count);
+    puts("[SUCCESS]");
+    return 0;
+}
@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+
+# Copyright (C) 2020 Freie Universität Berlin
+#
+# This file is subject to the terms and conditions of the GNU Lesser
+# General Public License v2.1. See the file LICENSE in the top level
+# directory for more details.
+
+import json
+import sys
+from testrunner import run
+
+
+# The default timeout is not enough for this test on some of the slower boards
+TIMEOUT = 60
+BENCHMARKS = [
+    "nop loop",
+    "mutex_init()",
+    "mutex lock/unlock",
+    "thread_flags_set()",
+    "thread_flags_clear()",
+    "thread flags set/wait any",
+    "msg_try_receive()",
+    "msg_avail()",
+    "tsrb bytewise",
+    "tsrb bulk",
+    "ringbuffer bytewise",
+    "ringbuffer bulk",
+    "isrpipe bulk",
+    "mutex pingpong",
+    "thread flags pingpong",
+    "msg pingpong",
+]
+
+
+def testfunc(child):
+    child.expect_exact('Benchmark suite')
+    child.expect(r'(\{"riot": .*\})\r?\n')
+    header = json.loads(child.match.group(1))
+    assert header["unit"] in ("cycles", "ns", "us")
+    for name in BENCHMARKS:
+        child.expect(r'(\{"name": .*\})\r?\n', timeout=TIMEOUT)
+        res = json.loads(child.match.group(1))
+        assert res["name"] == name
+        assert res["min"] <= res["median"] <= res["p99"] <= res["max"]
+    child.expect_exact('{} benchmarks run'.format(len(BENCHMARKS)))
+    child.expect_exact('[SUCCESS]')
+
+
+if __name__ == "__main__":
+    sys.exit(run(testfunc))
@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Tests the dispatching of received frames by the CAN router
+ *
+ * The test thread subscribes to frames of interface 0 with filters of
+ * different masks and params, and receives the RX indications itself.
+ *
+ * @}
+ */
+
+#include <errno.h>
+
+#include "embUnit.h"
+#include "kernel_defines.h"
+#include "msg.h"
+#include "thread.h"
+
+#include "can/pkt.h"
+#include "can/raw.h"
+#include "can/router.h"
+
+#define IFNUM               (0)
+#define MSG_QUEUE_SIZE      (8U)
+#define FILTERS_NUMOF       (4U)
+
+static msg_t _msg_queue[MSG_QUEUE_SIZE];
+static can_reg_entry_t _entry;
+static int _param1, _param2;
+
+/* the third mask does not get a mask group, so that filter is checked one
+ * by one */
+static const struct {
+    canid_t can_id;
+    canid_t mask;
+    void *param;
+} _filters[FILTERS_NUMOF] = {
+    { 0x100, 0x7ff, &_param1 },
+    { 0x100, 0x700, &_param1 },
+    { 0x000, 0x000, &_param2 },
+    { 0x200, 0x7ff, &_param1 },
+};
+
+static bool _registered[FILTERS_NUMOF];
+
+static int _register(unsigned idx)
+{
+    _registered[idx] = true;
+    return can_router_register(&_entry, _filters[idx].can_id,
+                               _filters[idx].mask, _filters[idx].param);
+}
+
+static int _unregister(unsigned idx)
+{
+    _registered[idx] = false;
+    return can_router_unregister(&_entry, _filters[idx].can_id,
+                                 _filters[idx].mask, _filters[idx].param);
+}
+
+static can_pkt_t *_dispatch(canid_t can_id)
+{
+    struct can_frame frame = { .can_id = can_id, .can_dlc = 1 };
+    can_pkt_t *pkt = can_pkt_alloc_rx(IFNUM, &frame);
+
+    TEST_ASSERT_NOT_NULL(pkt);
+    TEST_ASSERT_EQUAL_INT(0, can_router_dispatch_rx_indic(pkt));
+    return pkt;
+}
+
+static unsigned _recv(can_rx_data_t **rx, unsigned max)
+{
+    unsigned numof = 0;
+    msg_t msg;
+
+    while (msg_try_receive(&msg) == 1) {
+        TEST_ASSERT(numof < max);
+        TEST_ASSERT_EQUAL_INT(CAN_MSG_RX_INDICATION, msg.type);
+        rx[numof++] = msg.content.ptr;
+    }
+    return numof;
+}
+
+/* All packets and RX data were released, if the whole pool can be taken */
+static void _assert_pool_free(void)
+{
+    static const struct can_frame frame = { .can_id = 0 };
+    can_pkt_t *pkts[CAN_PKT_BUF_SIZE];
+
+    for (unsigned i = 0; i < ARRAY_SIZE(pkts); i++) {
+        pkts[i] = can_pkt_alloc_rx(IFNUM, &frame);
+        TEST_ASSERT_NOT_NULL(pkts[i]);
+    }
+    TEST_ASSERT_NULL(can_pkt_alloc_rx(IFNUM, &frame));
+    for (unsigned i = 0; i < ARRAY_SIZE(pkts); i++) {
+        can_pkt_free(pkts[i]);
+    }
+}
+
+static void set_up(void)
+{
+    can_pkt_init();
+    can_router_init();
+    _entry.ifnum = IFNUM;
+    _entry.target.pid = thread_getpid();
+#ifdef MODULE_CAN_MBOX
+    _entry.type = CAN_TYPE_DEFAULT;
+#endif
+}
+
+static void tear_down(void)
+{
+    can_rx_data_t *rx[MSG_QUEUE_SIZE];
+
+    for (unsigned i = 0; i < FILTERS_NUMOF; i++) {
+        if (_registered[i]) {
+            _unregister(i);
+        }
+    }
+    for (unsigned i = _recv(rx, ARRAY_SIZE(rx)); i > 0; i--) {
+        raw_can_free_frame(rx[i - 1]);
+    }
+}
+
+static void test_can_router__register(void)
+{
+    /* the return value tells if a filter was in use before */
+    TEST_ASSERT_EQUAL_INT(0, _register(0));
+    TEST_ASSERT_EQUAL_INT(1, can_router_register(&_entry, 0x100, 0x7ff,
+                                                 &_param2));
+    TEST_ASSERT_EQUAL_INT(0, _register(1));
+    TEST_ASSERT_EQUAL_INT(0, _register(2));
+
+    TEST_ASSERT_EQUAL_INT(1, can_router_unregister(&_entry, 0x100, 0x7ff,
+                                                   &_param2));
+    TEST_ASSERT_EQUAL_INT(-EINVAL, can_router_unregister(&_entry, 0x100, 0x7ff,
+                                                         &_param2));
+    TEST_ASSERT_EQUAL_INT(0, _unregister(0));
+    TEST_ASSERT_EQUAL_INT(0, _unregister(1));
+    TEST_ASSERT_EQUAL_INT(0, _unregister(2));
+
+    /* a released mask group is available to the next mask */
+    TEST_ASSERT_EQUAL_INT(0, _register(3));
+    can_pkt_t *pkt = _dispatch(0x200);
+    can_rx_data_t *rx[FILTERS_NUMOF];
+
+    TEST_ASSERT_EQUAL_INT(1, _recv(rx, ARRAY_SIZE(rx)));
+    TEST_ASSERT(rx[0]->data.iov_base == &pkt->frame);
+    raw_can_free_frame(rx[0]);
+    _assert_pool_free();
+}
+
+static void test_can_router__dispatch(void)
+{
+    can_rx_data_t *rx[FILTERS_NUMOF];
+
+    for (unsigned i = 0; i < FILTERS_NUMOF; i++) {
+        _register(i);
+    }
+    can_pkt_t *pkt = _dispatch(0x100);
+
+    /* two filters of param 1 match, in different mask groups */
+    TEST_ASSERT_EQUAL_INT(3, _recv(rx, ARRAY_SIZE(rx)));
+    TEST_ASSERT_EQUAL_INT(3, atomic_load(&pkt->ref_count));
+    TEST_ASSERT(rx[0] == rx[1]);
+    TEST_ASSERT(rx[0]->arg == &_param1);
+    TEST_ASSERT_EQUAL_INT(2, rx[0]->ref_count);
+    TEST_ASSERT(rx[2] != rx[0]);
+    TEST_ASSERT(rx[2]->arg == &_param2);
+    TEST_ASSERT_EQUAL_INT(1, rx[2]->ref_count);
+    for (unsigned i = 0; i < 3; i++) {
+        TEST_ASSERT(rx[i]->data.iov_base == &pkt->frame);
+        TEST_ASSERT_EQUAL_INT(sizeof(pkt->frame), rx[i]->data.iov_len);
+    }
+
+    /* the shared RX data stays valid until its last user is done */
+    raw_can_free_frame(rx[0]);
+    TEST_ASSERT_EQUAL_INT(1, rx[1]->ref_count);
+    TEST_ASSERT(rx[1]->data.iov_base == &pkt->frame);
+    TEST_ASSERT_EQUAL_INT(0x100, pkt->frame.can_id);
+    raw_can_free_frame(rx[1]);
+    raw_can_free_frame(rx[2]);
+    _assert_pool_free();
+
+    /* only the filter without mask matches */
+    _dispatch(0x300 | CAN_EFF_FLAG);
+    TEST_ASSERT_EQUAL_INT(1, _recv(rx, ARRAY_SIZE(rx)));
+    TEST_ASSERT(rx[0]->arg == &_param2);
+    raw_can_free_frame(rx[0]);
+    /* nobody is interested, the router frees the packet */
+    _unregister(2);
+    _dispatch(0x300);
+    TEST_ASSERT_EQUAL_INT(0, _recv(rx, ARRAY_SIZE(rx)));
+    _assert_pool_free();
+}
+
+static void test_can_router__frames(void)
+{
+    can_rx_data_t *rx1[FILTERS_NUMOF];
+    can_rx_data_t *rx2[FILTERS_NUMOF];
+
+    _register(0);
+    _register(1);
+    can_pkt_t *pkt1 = _dispatch(0x100);
+    TEST_ASSERT_EQUAL_INT(2, _recv(rx1, ARRAY_SIZE(rx1)));
+    can_pkt_t *pkt2 = _dispatch(0x100);
+    TEST_ASSERT_EQUAL_INT(2, _recv(rx2, ARRAY_SIZE(rx2)));
+
+    /* RX data is only shared for the same frame */
+    TEST_ASSERT(pkt1 != pkt2);
+    TEST_ASSERT(rx1[0] == rx1[1]);
+    TEST_ASSERT(rx2[0] == rx2[1]);
+    TEST_ASSERT(rx1[0] != rx2[0]);
+    TEST_ASSERT(rx1[0]->data.iov_base == &pkt1->frame);
+    TEST_ASSERT(rx2[0]->data.iov_base == &pkt2->frame);
+
+    /* releasing the first frame leaves the second one alone */
+    raw_can_free_frame(rx1[0]);
+    raw_can_free_frame(rx1[1]);
+    TEST_ASSERT_EQUAL_INT(2, atomic_load(&pkt2->ref_count));
+    TEST_ASSERT_EQUAL_INT(2, rx2[0]->ref_count);
+    raw_can_free_frame(rx2[0]);
+    raw_can_free_frame(rx2[1]);
+    _assert_pool_free();
+}
+
+Test *tests_can_router(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_can_router__register),
+        new_TestFixture(test_can_router__dispatch),
+        new_TestFixture(test_can_router__frames),
+    };
+
+    EMB_UNIT_TESTCALLER(can_router_tests, set_up, tear_down, fixtures);
+    return (Test *)&can_router_tests;
+}
+
+int main(void)
+{
+    msg_init_queue(_msg_queue, MSG_QUEUE_SIZE);
+
+    TESTS_START();
+    TESTS_RUN(tests_can_router());
+    TESTS_END();
+
+    return 0;
+}
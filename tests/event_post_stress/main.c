@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Stress test of the lock-free event_post()
+ *
+ * Two threads and a timer interrupt post events to the same queue, while a
+ * lower priority thread handles them. One of the threads cancels an event
+ * the interrupt keeps posting as well.
+ *
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "event.h"
+#include "kernel_defines.h"
+#include "test_utils/expect.h"
+#include "thread.h"
+#include "xtimer.h"
+
+#define PRODUCERS_NUMOF     (2U)
+#define RING_SIZE           (8U)
+#ifndef POSTS_NUMOF
+#define POSTS_NUMOF         (10000U)
+#endif
+#define ISR_PERIOD          (50U)
+#define WAIT_USEC           (100U)
+
+typedef struct {
+    event_t super;
+    unsigned producer;
+    unsigned seq;
+    volatile bool queued;
+} seq_event_t;
+
+static event_queue_t _queue = EVENT_QUEUE_INIT_DETACHED;
+
+static char _consumer_stack[THREAD_STACKSIZE_DEFAULT];
+static char _producer_stacks[PRODUCERS_NUMOF][THREAD_STACKSIZE_DEFAULT];
+
+static seq_event_t _ring[PRODUCERS_NUMOF][RING_SIZE];
+static unsigned _next_seq[PRODUCERS_NUMOF];
+static volatile unsigned _producers_done;
+
+static xtimer_t _timer;
+static volatile bool _stop;
+static volatile unsigned _isr_posts;
+static volatile unsigned _isr_handled;
+static volatile unsigned _shared_posts;
+static volatile unsigned _shared_handled;
+
+static void _seq_handler(event_t *event)
+{
+    seq_event_t *e = container_of(event, seq_event_t, super);
+
+    /* the events of one producer are handled in posting order */
+    expect(e->seq == _next_seq[e->producer]);
+    _next_seq[e->producer]++;
+    e->queued = false;
+}
+
+static void _isr_handler(event_t *event)
+{
+    (void)event;
+    _isr_handled++;
+}
+
+static void _shared_handler(event_t *event)
+{
+    (void)event;
+    _shared_handled++;
+}
+
+static event_t _isr_event = { .handler = _isr_handler };
+static event_t _shared_event = { .handler = _shared_handler };
+
+static void _timer_cb(void *arg)
+{
+    (void)arg;
+    event_post(&_queue, &_isr_event);
+    event_post(&_queue, &_shared_event);
+    _isr_posts++;
+    _shared_posts++;
+    if (!_stop) {
+        xtimer_set(&_timer, ISR_PERIOD);
+    }
+}
+
+static void *_consumer(void *arg)
+{
+    (void)arg;
+    /* events were posted before, the claim must not miss them */
+    event_queue_claim(&_queue);
+    event_loop(&_queue);
+    return NULL;
+}
+
+static void *_producer(void *arg)
+{
+    unsigned producer = (unsigned)(uintptr_t)arg;
+
+    for (unsigned seq = 0; seq < POSTS_NUMOF; seq++) {
+        seq_event_t *e = &_ring[producer][seq % RING_SIZE];
+
+        /* the consumer has a lower priority, let it catch up */
+        while (e->queued) {
+            xtimer_usleep(WAIT_USEC);
+        }
+        e->seq = seq;
+        e->queued = true;
+        event_post(&_queue, &e->super);
+
+        if (producer == 0) {
+            /* cancel racing the posts of the interrupt */
+            event_post(&_queue, &_shared_event);
+            _shared_posts++;
+            if (seq % 3 == 0) {
+                event_cancel(&_queue, &_shared_event);
+            }
+        }
+    }
+    _producers_done++;
+    return NULL;
+}
+
+int main(void)
+{
+    puts("event_post() stress test");
+
+    for (unsigned i = 0; i < PRODUCERS_NUMOF; i++) {
+        for (unsigned j = 0; j < RING_SIZE; j++) {
+            _ring[i][j].super.handler = _seq_handler;
+            _ring[i][j].producer = i;
+        }
+    }
+
+    _timer.callback = _timer_cb;
+    xtimer_set(&_timer, ISR_PERIOD);
+    xtimer_usleep(10 * ISR_PERIOD);
+
+    thread_create(_consumer_stack, sizeof(_consumer_stack),
+                  THREAD_PRIORITY_MAIN - 1, THREAD_CREATE_STACKTEST,
+                  _consumer, NULL, "consumer");
+    for (unsigned i = 0; i < PRODUCERS_NUMOF; i++) {
+        thread_create(_producer_stacks[i], sizeof(_producer_stacks[i]),
+                      THREAD_PRIORITY_MAIN - 2, THREAD_CREATE_STACKTEST,
+                      _producer, (void *)(uintptr_t)i, "producer");
+    }
+
+    while (_producers_done < PRODUCERS_NUMOF) {
+        xtimer_usleep(10 * WAIT_USEC);
+    }
+    _stop = true;
+    xtimer_remove(&_timer);
+    /* the consumer handles everything left while main sleeps */
+    xtimer_usleep(10 * ISR_PERIOD);
+
+    for (unsigned i = 0; i < PRODUCERS_NUMOF; i++) {
+        expect(_next_seq[i] == POSTS_NUMOF);
+    }
+    printf("interrupt: %u posts, %u handled\n", _isr_posts, _isr_handled);
+    expect((_isr_handled > 0) && (_isr_handled <= _isr_posts));
+    printf("shared: %u posts, %u handled\n", _shared_posts, _shared_handled);
+    expect((_shared_handled > 0) && (_shared_handled <= _shared_posts));
+
+    /* neither event was left marked as queued */
+    unsigned shared_handled = _shared_handled;
+    unsigned isr_handled = _isr_handled;
+    event_post(&_queue, &_shared_event);
+    event_post(&_queue, &_isr_event);
+    xtimer_usleep(10 * WAIT_USEC);
+    expect(_shared_handled == shared_handled + 1);
+    expect(_isr_handled == isr_handled + 1);
+
+    puts("[SUCCESS]");
+    return 0;
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Test application for serving all event queues from one thread
+ *
+ * @}
+ */
+
+#include <stdio.h>
+
+#include "irq.h"
+#include "thread.h"
+#include "event/thread.h"
+
+static void _handler_high(event_t *event) {
+    (void)event;
+    puts("high");
+}
+
+static event_t event_high = { .handler=_handler_high };
+
+static void _handler_medium(event_t *event) {
+    (void)event;
+    puts("medium");
+}
+
+static event_t event_medium = { .handler=_handler_medium };
+
+static void _handler_low(event_t *event) {
+    (void)event;
+    puts("low");
+}
+
+static event_t event_low = { .handler=_handler_low };
+
+int main(void)
+{
+    /* queue all events before the (higher priority) event thread gets to run,
+     * so dispatch order only depends on the queue priorities */
+    unsigned state = irq_disable();
+    event_post(EVENT_PRIO_LOWEST, &event_low);
+    event_post(EVENT_PRIO_MEDIUM, &event_medium);
+    event_post(EVENT_PRIO_HIGHEST, &event_high);
+    irq_restore(state);
+
+    puts("main done");
+
+    return 0;
+}
@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Tests the event heap of evtimer on a mock clock
+ *
+ * The event timer runs on a ztimer_mock_t clock, so events expire exactly
+ * when the tests advance the clock, also across the wraparound of the 32-bit
+ * millisecond clock and for offsets larger than EVTIMER_MAX_OFFSET.
+ *
+ * @}
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "embUnit.h"
+#include "evtimer.h"
+#include "kernel_defines.h"
+#include "ztimer/mock.h"
+
+#define EVENTS_NUMOF    (8U)
+
+static ztimer_mock_t _mock;
+ztimer_clock_t *const EVTIMER_ZTIMER = &_mock.super;
+
+static evtimer_t _evtimer;
+static evtimer_event_t _events[EVENTS_NUMOF];
+static evtimer_event_t *_fired[EVENTS_NUMOF];
+static uint32_t _fired_at[EVENTS_NUMOF];
+static unsigned _fired_numof;
+
+static void _cb(evtimer_event_t *event)
+{
+    TEST_ASSERT(_fired_numof < EVENTS_NUMOF);
+    _fired[_fired_numof] = event;
+    _fired_at[_fired_numof] = ztimer_now(EVTIMER_ZTIMER);
+    _fired_numof++;
+}
+
+static void _add(unsigned idx, uint32_t offset)
+{
+    _events[idx].offset = offset;
+    evtimer_add(&_evtimer, &_events[idx]);
+}
+
+static unsigned _count(void)
+{
+    evtimer_event_t *event = NULL;
+    unsigned count = 0;
+
+    while ((event = evtimer_iter(&_evtimer, event))) {
+        count++;
+    }
+    return count;
+}
+
+static void _assert_fired(unsigned pos, unsigned idx, uint32_t at)
+{
+    TEST_ASSERT(pos < _fired_numof);
+    TEST_ASSERT(_fired[pos] == &_events[idx]);
+    TEST_ASSERT_EQUAL_INT(at, _fired_at[pos]);
+    TEST_ASSERT(!evtimer_is_scheduled(&_evtimer, &_events[idx]));
+    TEST_ASSERT_NULL(_events[idx].next);
+    TEST_ASSERT_NULL(_events[idx].prev);
+    TEST_ASSERT_NULL(_events[idx].child);
+}
+
+static void set_up(void)
+{
+    ztimer_mock_init(&_mock, 32);
+    memset(_events, 0, sizeof(_events));
+    evtimer_init(&_evtimer, _cb);
+    _fired_numof = 0;
+}
+
+static void tear_down(void)
+{
+    while (_evtimer.events) {
+        evtimer_del(&_evtimer, _evtimer.events);
+    }
+}
+
+static void test_evtimer__heap(void)
+{
+    static const uint32_t offsets[] = {
+        500, 100, 300, 100, 700, 200, 600, 400
+    };
+
+    for (unsigned i = 0; i < ARRAY_SIZE(offsets); i++) {
+        _add(i, offsets[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(ARRAY_SIZE(offsets), _count());
+    for (unsigned i = 0; i < ARRAY_SIZE(offsets); i++) {
+        TEST_ASSERT(evtimer_is_scheduled(&_evtimer, &_events[i]));
+        TEST_ASSERT_EQUAL_INT(offsets[i],
+                              evtimer_left_msec(&_evtimer, &_events[i]));
+    }
+
+    /* the first of two events with the same deadline is the root */
+    TEST_ASSERT(_evtimer.events == &_events[1]);
+    evtimer_del(&_evtimer, &_events[1]);
+    TEST_ASSERT(_evtimer.events == &_events[3]);
+    /* remove an event from within the heap */
+    evtimer_del(&_evtimer, &_events[2]);
+    TEST_ASSERT(!evtimer_is_scheduled(&_evtimer, &_events[2]));
+    /* deleting it again does nothing */
+    evtimer_del(&_evtimer, &_events[2]);
+    TEST_ASSERT_EQUAL_INT(ARRAY_SIZE(offsets) - 2, _count());
+
+    /* rescheduling moves an event to the top */
+    _add(4, 50);
+    TEST_ASSERT(_evtimer.events == &_events[4]);
+    TEST_ASSERT_EQUAL_INT(ARRAY_SIZE(offsets) - 2, _count());
+
+    ztimer_mock_advance(&_mock, 100);
+    TEST_ASSERT_EQUAL_INT(2, _fired_numof);
+    _assert_fired(0, 4, 50);
+    _assert_fired(1, 3, 100);
+
+    /* a removed event can be added again */
+    _add(1, 250);
+    ztimer_mock_advance(&_mock, 900);
+    TEST_ASSERT_EQUAL_INT(7, _fired_numof);
+    _assert_fired(2, 5, 200);
+    _assert_fired(3, 1, 350);
+    _assert_fired(4, 7, 400);
+    _assert_fired(5, 0, 500);
+    _assert_fired(6, 6, 600);
+    TEST_ASSERT_NULL(_evtimer.events);
+    TEST_ASSERT_EQUAL_INT(0, _count());
+}
+
+static void test_evtimer__same_deadline(void)
+{
+    for (unsigned i = 0; i < EVENTS_NUMOF; i++) {
+        _add(i, 100);
+    }
+    ztimer_mock_advance(&_mock, 99);
+    TEST_ASSERT_EQUAL_INT(0, _fired_numof);
+
+    /* all events are handled in one pass, so the timer is only set again
+     * once nothing is left to do */
+    unsigned sets = _mock.calls.set;
+    ztimer_mock_advance(&_mock, 1);
+    TEST_ASSERT_EQUAL_INT(EVENTS_NUMOF, _fired_numof);
+    for (unsigned i = 0; i < EVENTS_NUMOF; i++) {
+        TEST_ASSERT_EQUAL_INT(100, _fired_at[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(sets, _mock.calls.set);
+    TEST_ASSERT_NULL(_evtimer.events);
+}
+
+static void test_evtimer__wraparound(void)
+{
+    const uint32_t start = UINT32_MAX - 100;
+
+    ztimer_mock_jump(&_mock, start);
+    _add(0, 300);
+    _add(1, 50);
+    _add(2, 150);
+    TEST_ASSERT(_evtimer.events == &_events[1]);
+    TEST_ASSERT_EQUAL_INT(300, evtimer_left_msec(&_evtimer, &_events[0]));
+    TEST_ASSERT_EQUAL_INT(150, evtimer_left_msec(&_evtimer, &_events[2]));
+
+    ztimer_mock_advance(&_mock, 60);
+    TEST_ASSERT_EQUAL_INT(1, _fired_numof);
+    _assert_fired(0, 1, start + 50);
+
+    /* the deadlines of the remaining events lie beyond the wraparound */
+    TEST_ASSERT(_evtimer.events == &_events[2]);
+    TEST_ASSERT_EQUAL_INT(90, evtimer_left_msec(&_evtimer, &_events[2]));
+    TEST_ASSERT_EQUAL_INT(240, evtimer_left_msec(&_evtimer, &_events[0]));
+
+    ztimer_mock_advance(&_mock, 100);
+    TEST_ASSERT_EQUAL_INT(2, _fired_numof);
+    _assert_fired(1, 2, 49);
+    TEST_ASSERT_EQUAL_INT(140, evtimer_left_msec(&_evtimer, &_events[0]));
+
+    ztimer_mock_advance(&_mock, 140);
+    TEST_ASSERT_EQUAL_INT(3, _fired_numof);
+    _assert_fired(2, 0, 199);
+}
+
+static void test_evtimer__max_offset(void)
+{
+    const uint32_t start = 1000;
+    const uint32_t rest = UINT32_MAX - EVTIMER_MAX_OFFSET;
+
+    ztimer_mock_jump(&_mock, start);
+    _add(0, UINT32_MAX);
+
+    /* only EVTIMER_MAX_OFFSET is scheduled, the rest is kept in offset */
+    TEST_ASSERT_EQUAL_INT(start + EVTIMER_MAX_OFFSET, _events[0].deadline);
+    TEST_ASSERT_EQUAL_INT(rest, _events[0].offset);
+    TEST_ASSERT_EQUAL_INT(UINT32_MAX,
+                          evtimer_left_msec(&_evtimer, &_events[0]));
+
+    /* shorter events are not blocked by it */
+    _add(1, 1000);
+    TEST_ASSERT(_evtimer.events == &_events[1]);
+    ztimer_mock_advance(&_mock, 1000);
+    TEST_ASSERT_EQUAL_INT(1, _fired_numof);
+    _assert_fired(0, 1, start + 1000);
+    TEST_ASSERT_EQUAL_INT(UINT32_MAX - 1000,
+                          evtimer_left_msec(&_evtimer, &_events[0]));
+
+    /* after the first period, the event is scheduled again, the rest of
+     * UINT32_MAX still exceeds EVTIMER_MAX_OFFSET by one */
+    ztimer_mock_advance(&_mock, EVTIMER_MAX_OFFSET - 1000);
+    TEST_ASSERT_EQUAL_INT(1, _fired_numof);
+    TEST_ASSERT(evtimer_is_scheduled(&_evtimer, &_events[0]));
+    TEST_ASSERT_EQUAL_INT(rest - EVTIMER_MAX_OFFSET, _events[0].offset);
+    TEST_ASSERT_EQUAL_INT(rest, evtimer_left_msec(&_evtimer, &_events[0]));
+
+    ztimer_mock_advance(&_mock, EVTIMER_MAX_OFFSET);
+    TEST_ASSERT_EQUAL_INT(1, _fired_numof);
+    TEST_ASSERT_EQUAL_INT(0, _events[0].offset);
+    TEST_ASSERT_EQUAL_INT(1, evtimer_left_msec(&_evtimer, &_events[0]));
+    ztimer_mock_advance(&_mock, 1);
+    TEST_ASSERT_EQUAL_INT(2, _fired_numof);
+    _assert_fired(1, 0, start + UINT32_MAX);
+}
+
+Test *tests_evtimer(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_evtimer__heap),
+        new_TestFixture(test_evtimer__same_deadline),
+        new_TestFixture(test_evtimer__wraparound),
+        new_TestFixture(test_evtimer__max_offset),
+    };
+
+    EMB_UNIT_TESTCALLER(evtimer_tests, set_up, tear_down, fixtures);
+    return (Test *)&evtimer_tests;
+}
+
+int main(void)
+{
+    TESTS_START();
+    TESTS_RUN(tests_evtimer());
+    TESTS_END();
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Types of the DTLS sock mock
+ *
+ * @}
+ */
+
+#ifndef SOCK_DTLS_TYPES_H
+#define SOCK_DTLS_TYPES_H
+
+#include "net/sock/udp.h"
+#ifdef SOCK_HAS_ASYNC
+#include "net/sock/async/types.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Mocked DTLS sock
+ */
+struct sock_dtls {
+#if defined(SOCK_HAS_ASYNC) || defined(DOXYGEN)
+    sock_dtls_cb_t async_cb;                /**< asynchronous event callback */
+    void *async_cb_arg;                     /**< asynchronous callback
+                                                argument */
+#if defined(SOCK_HAS_ASYNC_CTX) || defined(DOXYGEN)
+    sock_async_ctx_t async_ctx;             /**< asynchronous event context */
+#endif
+#endif
+};
+
+/**
+ * @brief   Mocked DTLS session
+ */
+struct sock_dtls_session {
+    sock_udp_ep_t ep;                       /**< remote endpoint */
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOCK_DTLS_TYPES_H */
+/** @} */
@@ -0,0 +1,321 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Tests the session cache of the gcoap DTLS transport
+ *
+ * The DTLS sock is mocked: it records the sessions started, closed and used
+ * for sending, and receives what the tests inject.
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "embUnit.h"
+#include "net/gcoap.h"
+#include "net/sock/dtls.h"
+#include "net/sock/util.h"
+#include "thread.h"
+#include "xtimer.h"
+
+/* the session cache compares ages in microseconds */
+#define AGE_STEP_USEC       (1000U)
+
+static struct {
+    sock_dtls_t *sock;
+    int init_res;               /* result of sock_dtls_session_init() */
+    unsigned inits;
+    sock_udp_ep_t init_ep;
+    unsigned destroys;
+    sock_udp_ep_t destroy_ep;
+    unsigned sends;
+    sock_udp_ep_t send_ep;
+    uint8_t send_buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+    size_t send_len;
+    ssize_t recv_res;           /* next result of sock_dtls_recv() */
+    sock_udp_ep_t recv_ep;
+    uint8_t recv_buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+} _mock = { .init_res = 1, .recv_res = -EAGAIN };
+
+static unsigned _resp_code;
+
+void sock_dtls_init(void)
+{
+}
+
+int sock_dtls_create(sock_dtls_t *sock, sock_udp_t *udp_sock,
+                     credman_tag_t tag, unsigned version, unsigned role)
+{
+    (void)udp_sock;
+    (void)tag;
+    (void)version;
+    (void)role;
+    _mock.sock = sock;
+    return 0;
+}
+
+void sock_dtls_close(sock_dtls_t *sock)
+{
+    (void)sock;
+}
+
+int sock_dtls_session_init(sock_dtls_t *sock, const sock_udp_ep_t *ep,
+                           sock_dtls_session_t *remote)
+{
+    (void)sock;
+    _mock.inits++;
+    _mock.init_ep = *ep;
+    remote->ep = *ep;
+    return _mock.init_res;
+}
+
+void sock_dtls_session_destroy(sock_dtls_t *sock, sock_dtls_session_t *remote)
+{
+    (void)sock;
+    _mock.destroys++;
+    _mock.destroy_ep = remote->ep;
+}
+
+ssize_t sock_dtls_send(sock_dtls_t *sock, sock_dtls_session_t *remote,
+                       const void *data, size_t len)
+{
+    (void)sock;
+    _mock.sends++;
+    _mock.send_ep = remote->ep;
+    memcpy(_mock.send_buf, data, len);
+    _mock.send_len = len;
+    return len;
+}
+
+ssize_t sock_dtls_recv(sock_dtls_t *sock, sock_dtls_session_t *remote,
+                       void *data, size_t maxlen, uint32_t timeout)
+{
+    (void)sock;
+    (void)timeout;
+    ssize_t res = _mock.recv_res;
+
+    _mock.recv_res = -EAGAIN;
+    if (res == -EAGAIN) {
+        return res;
+    }
+    remote->ep = _mock.recv_ep;
+    if (res > 0) {
+        memcpy(data, _mock.recv_buf, ((size_t)res < maxlen) ? (size_t)res
+                                                             : maxlen);
+    }
+    return res;
+}
+
+void sock_dtls_set_cb(sock_dtls_t *sock, sock_dtls_cb_t cb, void *cb_arg)
+{
+    sock->async_cb = cb;
+    sock->async_cb_arg = cb_arg;
+}
+
+sock_async_ctx_t *sock_dtls_get_async_ctx(sock_dtls_t *sock)
+{
+    return &sock->async_ctx;
+}
+
+/* The DTLS thread runs at the priority of this thread by default, so it
+ * is only scheduled when this thread yields. It then handles all its events
+ * before this thread continues, the gcoap thread preempts both. */
+static void _dtls_run(void)
+{
+    thread_yield();
+}
+
+/* Lets the DTLS thread receive res, which both gcoap threads handle before
+ * this returns */
+static void _recv(const sock_udp_ep_t *remote, ssize_t res,
+                  const uint8_t *buf)
+{
+    _mock.recv_ep = *remote;
+    _mock.recv_res = res;
+    if (res > 0) {
+        memcpy(_mock.recv_buf, buf, res);
+    }
+    _mock.sock->async_cb(_mock.sock, SOCK_ASYNC_MSG_RECV,
+                         _mock.sock->async_cb_arg);
+    _dtls_run();
+}
+
+static void _remote(sock_udp_ep_t *remote, uint8_t id)
+{
+    memset(remote, 0, sizeof(*remote));
+    remote->family = AF_INET6;
+    remote->addr.ipv6[0] = 0xfe;
+    remote->addr.ipv6[1] = 0x80;
+    remote->addr.ipv6[15] = id;
+    remote->port = CONFIG_GCOAPS_PORT;
+}
+
+static void _resp_handler(const gcoap_request_memo_t *memo, coap_pkt_t *pdu,
+                          const sock_udp_ep_t *remote)
+{
+    (void)remote;
+    _resp_code = (memo->state == GCOAP_MEMO_RESP) ? coap_get_code_raw(pdu) : 0;
+}
+
+static size_t _send_req(uint8_t *buf, size_t len, unsigned type,
+                        const sock_udp_ep_t *remote)
+{
+    coap_pkt_t pdu;
+
+    gcoap_req_init(&pdu, buf, len, COAP_METHOD_GET, "/a");
+    coap_hdr_set_type(pdu.hdr, type);
+    len = coap_opt_finish(&pdu, COAP_OPT_FINISH_NONE);
+    len = gcoap_req_send(buf, len, remote,
+                         (type == COAP_TYPE_CON) ? _resp_handler : NULL,
+                         NULL);
+    /* lets the DTLS thread send it */
+    _dtls_run();
+    return len;
+}
+
+/* Answers the request the mock sent last */
+static void _respond(void)
+{
+    coap_pkt_t req;
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+
+    TEST_ASSERT_EQUAL_INT(0, coap_parse(&req, _mock.send_buf,
+                                        _mock.send_len));
+    ssize_t len = coap_build_hdr((coap_hdr_t *)buf, COAP_TYPE_ACK,
+                                 req.token,
+                                 coap_get_token_len(&req),
+                                 COAP_CODE_CONTENT, coap_get_id(&req));
+    _resp_code = 0;
+    _recv(&_mock.send_ep, len, buf);
+    TEST_ASSERT_EQUAL_INT(COAP_CODE_CONTENT, _resp_code);
+}
+
+static void test_gcoap_dtls__resend_pending(void)
+{
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+    sock_udp_ep_t server;
+
+    _remote(&server, 1);
+
+    /* the request waits for the handshake */
+    size_t len = _send_req(buf, sizeof(buf), COAP_TYPE_CON, &server);
+    TEST_ASSERT(len > 0);
+    TEST_ASSERT_EQUAL_INT(1, _mock.inits);
+    TEST_ASSERT(sock_udp_ep_equal(&server, &_mock.init_ep));
+    TEST_ASSERT_EQUAL_INT(0, _mock.sends);
+
+    /* a request while the handshake is in progress does not restart it */
+    TEST_ASSERT_EQUAL_INT(0, _send_req(buf + len, sizeof(buf) - len,
+                                       COAP_TYPE_NON, &server));
+    TEST_ASSERT_EQUAL_INT(1, _mock.inits);
+
+    /* the request is sent once the handshake completed */
+    _recv(&server, -SOCK_DTLS_HANDSHAKE, NULL);
+    TEST_ASSERT_EQUAL_INT(1, _mock.sends);
+    TEST_ASSERT(sock_udp_ep_equal(&server, &_mock.send_ep));
+    TEST_ASSERT_EQUAL_INT(len, _mock.send_len);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(buf, _mock.send_buf, len));
+    _respond();
+}
+
+static void test_gcoap_dtls__session_cache(void)
+{
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+    sock_udp_ep_t server;
+    unsigned inits = _mock.inits;
+    unsigned sends = _mock.sends;
+
+    _remote(&server, 1);
+
+    /* the session of the previous test is reused */
+    TEST_ASSERT(_send_req(buf, sizeof(buf), COAP_TYPE_CON, &server) > 0);
+    TEST_ASSERT_EQUAL_INT(inits, _mock.inits);
+    TEST_ASSERT_EQUAL_INT(sends + 1, _mock.sends);
+    _respond();
+    TEST_ASSERT_EQUAL_INT(0, _mock.destroys);
+}
+
+static void test_gcoap_dtls__lru_eviction(void)
+{
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+    sock_udp_ep_t server, client1, client2;
+    unsigned inits = _mock.inits;
+
+    _remote(&server, 1);
+    _remote(&client1, 2);
+    _remote(&client2, 3);
+
+    /* a client connecting to us fills the table */
+    xtimer_usleep(AGE_STEP_USEC);
+    _recv(&client1, -SOCK_DTLS_HANDSHAKE, NULL);
+    TEST_ASSERT_EQUAL_INT(0, _mock.destroys);
+
+    /* using the session with server makes client1 the oldest one */
+    xtimer_usleep(AGE_STEP_USEC);
+    TEST_ASSERT(_send_req(buf, sizeof(buf), COAP_TYPE_NON, &server) > 0);
+    xtimer_usleep(AGE_STEP_USEC);
+    _recv(&client2, -SOCK_DTLS_HANDSHAKE, NULL);
+    TEST_ASSERT_EQUAL_INT(1, _mock.destroys);
+    TEST_ASSERT(sock_udp_ep_equal(&client1, &_mock.destroy_ep));
+
+    /* client1 needs a new handshake, which replaces server */
+    xtimer_usleep(AGE_STEP_USEC);
+    TEST_ASSERT_EQUAL_INT(0, _send_req(buf, sizeof(buf), COAP_TYPE_NON,
+                                       &client1));
+    TEST_ASSERT_EQUAL_INT(inits + 1, _mock.inits);
+    TEST_ASSERT(sock_udp_ep_equal(&client1, &_mock.init_ep));
+    TEST_ASSERT_EQUAL_INT(2, _mock.destroys);
+    TEST_ASSERT(sock_udp_ep_equal(&server, &_mock.destroy_ep));
+}
+
+static void test_gcoap_dtls__known_peer(void)
+{
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+    sock_udp_ep_t server;
+    unsigned sends = _mock.sends;
+
+    _remote(&server, 4);
+
+    /* the DTLS stack still has an established session with server */
+    _mock.init_res = 0;
+    size_t len = _send_req(buf, sizeof(buf), COAP_TYPE_CON, &server);
+    _mock.init_res = 1;
+    TEST_ASSERT(len > 0);
+    TEST_ASSERT_EQUAL_INT(sends + 1, _mock.sends);
+    TEST_ASSERT(sock_udp_ep_equal(&server, &_mock.send_ep));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(buf, _mock.send_buf, len));
+    _respond();
+}
+
+Test *tests_gcoap_dtls(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_gcoap_dtls__resend_pending),
+        new_TestFixture(test_gcoap_dtls__session_cache),
+        new_TestFixture(test_gcoap_dtls__lru_eviction),
+        new_TestFixture(test_gcoap_dtls__known_peer),
+    };
+
+    EMB_UNIT_TESTCALLER(gcoap_dtls_tests, NULL, NULL, fixtures);
+    return (Test *)&gcoap_dtls_tests;
+}
+
+int main(void)
+{
+    TESTS_START();
+    TESTS_RUN(tests_gcoap_dtls());
+    TESTS_END();
+
+    return 0;
+}
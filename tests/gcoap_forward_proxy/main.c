@@ -0,0 +1,308 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Tests the forward proxy of gcoap
+ *
+ * The client and the origin server are UDP socks of the application, which
+ * reach the proxy via the loopback address. The origin server is scripted by
+ * the tests: it checks each forwarded request and answers it, or not.
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "embUnit.h"
+#include "kernel_defines.h"
+#include "net/gcoap.h"
+#include "net/ipv6/addr.h"
+#include "net/sock/udp.h"
+#include "xtimer.h"
+
+#define CLIENT_PORT         (6000U)
+#define ORIGIN_PORT         (5700U)
+#define ORIGIN_URI          "coap://[::1]:5700"
+#define RECV_TIMEOUT        (1000000U)
+/* no forwarded request reaches the origin server */
+#define SILENCE_TIMEOUT     (100000U)
+
+static const uint8_t _token[] = { 0xc1, 0x1e, 0x47 };
+static const uint8_t _etag[] = { 0x01, 0x02 };
+
+static sock_udp_t _client;
+static sock_udp_t _origin;
+static sock_udp_ep_t _proxy;
+static uint16_t _msgid;
+
+static void _loopback(sock_udp_ep_t *ep, uint16_t port)
+{
+    memset(ep, 0, sizeof(*ep));
+    ep->family = AF_INET6;
+    ep->netif = SOCK_ADDR_ANY_NETIF;
+    memcpy(ep->addr.ipv6, &ipv6_addr_loopback, sizeof(ep->addr.ipv6));
+    ep->port = port;
+}
+
+/* Starts a request of the client; the Proxy-Uri has to be added last, all
+ * other options of the tests have lower numbers */
+static void _client_req_init(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                             unsigned type, unsigned code)
+{
+    ssize_t hdr_len = coap_build_hdr((coap_hdr_t *)buf, type,
+                                     (uint8_t *)_token, sizeof(_token), code,
+                                     ++_msgid);
+    coap_pkt_init(pdu, buf, len, hdr_len);
+}
+
+static void _client_send(const uint8_t *buf, ssize_t len)
+{
+    TEST_ASSERT(len > 0);
+    TEST_ASSERT_EQUAL_INT(len, sock_udp_send(&_client, buf, len, &_proxy));
+}
+
+/* Receives the response of the proxy for the client */
+static void _client_recv(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                         unsigned code)
+{
+    ssize_t res = sock_udp_recv(&_client, buf, len, RECV_TIMEOUT, NULL);
+
+    TEST_ASSERT(res > 0);
+    TEST_ASSERT_EQUAL_INT(0, coap_parse(pdu, buf, res));
+    TEST_ASSERT_EQUAL_INT(COAP_TYPE_NON, coap_get_type(pdu));
+    TEST_ASSERT_EQUAL_INT(code, coap_get_code_raw(pdu));
+    TEST_ASSERT_EQUAL_INT(sizeof(_token), coap_get_token_len(pdu));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(_token, pdu->token, sizeof(_token)));
+}
+
+/* Receives the forwarded request at the origin server */
+static void _origin_recv(coap_pkt_t *pdu, uint8_t *buf, size_t len,
+                         sock_udp_ep_t *proxy, unsigned type, unsigned method)
+{
+    ssize_t res = sock_udp_recv(&_origin, buf, len, RECV_TIMEOUT, proxy);
+
+    TEST_ASSERT(res > 0);
+    TEST_ASSERT_EQUAL_INT(0, coap_parse(pdu, buf, res));
+    TEST_ASSERT_EQUAL_INT(type, coap_get_type(pdu));
+    TEST_ASSERT_EQUAL_INT(method, coap_get_code_raw(pdu));
+    /* the proxy uses a token of its own */
+    TEST_ASSERT(coap_get_token_len(pdu) > 0);
+}
+
+/* Answers the forwarded request req, piggybacked if it is confirmable */
+static void _origin_reply(coap_pkt_t *req, const sock_udp_ep_t *proxy,
+                          unsigned code, bool etag, uint32_t max_age,
+                          const char *payload)
+{
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+    coap_pkt_t pdu;
+    bool con = (coap_get_type(req) == COAP_TYPE_CON);
+    ssize_t len = coap_build_hdr((coap_hdr_t *)buf,
+                                 con ? COAP_TYPE_ACK : COAP_TYPE_NON,
+                                 req->token, coap_get_token_len(req), code,
+                                 con ? coap_get_id(req) : ++_msgid);
+
+    coap_pkt_init(&pdu, buf, sizeof(buf), len);
+    if (etag) {
+        coap_opt_add_opaque(&pdu, COAP_OPT_ETAG, _etag, sizeof(_etag));
+    }
+    coap_opt_add_uint(&pdu, COAP_OPT_MAX_AGE, max_age);
+    if (payload) {
+        len = coap_opt_finish(&pdu, COAP_OPT_FINISH_PAYLOAD);
+        memcpy(pdu.payload, payload, strlen(payload));
+        len += strlen(payload);
+    }
+    else {
+        len = coap_opt_finish(&pdu, COAP_OPT_FINISH_NONE);
+    }
+    TEST_ASSERT_EQUAL_INT(len, sock_udp_send(&_origin, buf, len, proxy));
+}
+
+static void _assert_payload(const coap_pkt_t *pdu, const char *payload)
+{
+    TEST_ASSERT_EQUAL_INT(strlen(payload), pdu->payload_len);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(payload, pdu->payload, pdu->payload_len));
+}
+
+static void test_gcoap_forward_proxy__options(void)
+{
+    static const struct {
+        uint16_t num;
+        const char *value;
+    } exp[] = {
+        { COAP_OPT_IF_MATCH, "\xaa" },
+        { COAP_OPT_URI_PATH, "a" },
+        { COAP_OPT_URI_PATH, "b" },
+        { COAP_OPT_CONTENT_FORMAT, "\x32" },
+        { COAP_OPT_URI_QUERY, "x=1" },
+        { COAP_OPT_URI_QUERY, "y=2" },
+        { COAP_OPT_ACCEPT, "\x3c" },
+    };
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+    sock_udp_ep_t proxy;
+    coap_pkt_t pdu;
+
+    /* options below, between and above the Uri-Path and Uri-Query options
+     * the proxy builds from the Proxy-Uri */
+    _client_req_init(&pdu, buf, sizeof(buf), COAP_TYPE_NON, COAP_METHOD_POST);
+    coap_opt_add_opaque(&pdu, COAP_OPT_IF_MATCH, (uint8_t *)"\xaa", 1);
+    coap_opt_add_format(&pdu, COAP_FORMAT_JSON);
+    coap_opt_add_uint(&pdu, COAP_OPT_ACCEPT, COAP_FORMAT_CBOR);
+    coap_opt_add_proxy_uri(&pdu, ORIGIN_URI "/a/b?x=1&y=2");
+    ssize_t len = coap_opt_finish(&pdu, COAP_OPT_FINISH_PAYLOAD);
+    memcpy(pdu.payload, "req", 3);
+    _client_send(buf, len + 3);
+
+    _origin_recv(&pdu, buf, sizeof(buf), &proxy, COAP_TYPE_NON,
+                 COAP_METHOD_POST);
+    coap_optpos_t opt = { 0, 0 };
+    uint8_t *value;
+    unsigned i = 0;
+    for (bool init = true;
+         (len = coap_opt_get_next(&pdu, &opt, &value, init)) >= 0;
+         init = false, i++) {
+        TEST_ASSERT(i < ARRAY_SIZE(exp));
+        TEST_ASSERT_EQUAL_INT(exp[i].num, opt.opt_num);
+        TEST_ASSERT_EQUAL_INT(strlen(exp[i].value), len);
+        TEST_ASSERT_EQUAL_INT(0, memcmp(exp[i].value, value, len));
+    }
+    /* no Proxy-Uri */
+    TEST_ASSERT_EQUAL_INT(ARRAY_SIZE(exp), i);
+    _assert_payload(&pdu, "req");
+
+    _origin_reply(&pdu, &proxy, COAP_CODE_CHANGED, false, 0, "ok");
+    _client_recv(&pdu, buf, sizeof(buf), COAP_CODE_CHANGED);
+    _assert_payload(&pdu, "ok");
+}
+
+static void test_gcoap_forward_proxy__con(void)
+{
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+    sock_udp_ep_t proxy;
+    coap_pkt_t pdu;
+
+    _client_req_init(&pdu, buf, sizeof(buf), COAP_TYPE_CON, COAP_METHOD_GET);
+    coap_opt_add_proxy_uri(&pdu, ORIGIN_URI "/con");
+    _client_send(buf, coap_opt_finish(&pdu, COAP_OPT_FINISH_NONE));
+
+    /* acknowledged right away, the origin server has not answered yet */
+    ssize_t res = sock_udp_recv(&_client, buf, sizeof(buf), RECV_TIMEOUT,
+                                NULL);
+    TEST_ASSERT_EQUAL_INT(sizeof(coap_hdr_t), res);
+    TEST_ASSERT_EQUAL_INT(0, coap_parse(&pdu, buf, res));
+    TEST_ASSERT_EQUAL_INT(COAP_TYPE_ACK, coap_get_type(&pdu));
+    TEST_ASSERT_EQUAL_INT(COAP_CODE_EMPTY, coap_get_code_raw(&pdu));
+    TEST_ASSERT_EQUAL_INT(_msgid, coap_get_id(&pdu));
+
+    /* the response follows separately */
+    _origin_recv(&pdu, buf, sizeof(buf), &proxy, COAP_TYPE_CON,
+                 COAP_METHOD_GET);
+    _origin_reply(&pdu, &proxy, COAP_CODE_CONTENT, false, 60, "con");
+    _client_recv(&pdu, buf, sizeof(buf), COAP_CODE_CONTENT);
+    _assert_payload(&pdu, "con");
+}
+
+static void test_gcoap_forward_proxy__revalidate(void)
+{
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+    uint8_t *etag;
+    sock_udp_ep_t proxy;
+    coap_pkt_t pdu;
+
+    _client_req_init(&pdu, buf, sizeof(buf), COAP_TYPE_NON, COAP_METHOD_GET);
+    coap_opt_add_proxy_uri(&pdu, ORIGIN_URI "/etag");
+    _client_send(buf, coap_opt_finish(&pdu, COAP_OPT_FINISH_NONE));
+
+    _origin_recv(&pdu, buf, sizeof(buf), &proxy, COAP_TYPE_NON,
+                 COAP_METHOD_GET);
+    TEST_ASSERT_EQUAL_INT(-ENOENT,
+                          coap_opt_get_opaque(&pdu, COAP_OPT_ETAG, &etag));
+    _origin_reply(&pdu, &proxy, COAP_CODE_CONTENT, true, 1, "v1");
+    _client_recv(&pdu, buf, sizeof(buf), COAP_CODE_CONTENT);
+    _assert_payload(&pdu, "v1");
+
+    /* the stale response is validated with its ETag */
+    xtimer_sleep(2);
+    _client_req_init(&pdu, buf, sizeof(buf), COAP_TYPE_NON, COAP_METHOD_GET);
+    coap_opt_add_proxy_uri(&pdu, ORIGIN_URI "/etag");
+    _client_send(buf, coap_opt_finish(&pdu, COAP_OPT_FINISH_NONE));
+
+    _origin_recv(&pdu, buf, sizeof(buf), &proxy, COAP_TYPE_NON,
+                 COAP_METHOD_GET);
+    TEST_ASSERT_EQUAL_INT(sizeof(_etag),
+                          coap_opt_get_opaque(&pdu, COAP_OPT_ETAG, &etag));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(_etag, etag, sizeof(_etag)));
+    _origin_reply(&pdu, &proxy, COAP_CODE_VALID, true, 60, NULL);
+
+    /* the client did not ask for validation, and gets the representation */
+    _client_recv(&pdu, buf, sizeof(buf), COAP_CODE_CONTENT);
+    _assert_payload(&pdu, "v1");
+
+    /* which is fresh again */
+    _client_req_init(&pdu, buf, sizeof(buf), COAP_TYPE_NON, COAP_METHOD_GET);
+    coap_opt_add_proxy_uri(&pdu, ORIGIN_URI "/etag");
+    _client_send(buf, coap_opt_finish(&pdu, COAP_OPT_FINISH_NONE));
+    _client_recv(&pdu, buf, sizeof(buf), COAP_CODE_CONTENT);
+    _assert_payload(&pdu, "v1");
+    TEST_ASSERT_EQUAL_INT(-ETIMEDOUT,
+                          sock_udp_recv(&_origin, buf, sizeof(buf),
+                                        SILENCE_TIMEOUT, NULL));
+}
+
+static void test_gcoap_forward_proxy__timeout(void)
+{
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+    sock_udp_ep_t proxy;
+    coap_pkt_t pdu;
+
+    _client_req_init(&pdu, buf, sizeof(buf), COAP_TYPE_NON, COAP_METHOD_GET);
+    coap_opt_add_proxy_uri(&pdu, ORIGIN_URI "/timeout");
+    _client_send(buf, coap_opt_finish(&pdu, COAP_OPT_FINISH_NONE));
+
+    /* the origin server does not answer */
+    _origin_recv(&pdu, buf, sizeof(buf), &proxy, COAP_TYPE_NON,
+                 COAP_METHOD_GET);
+    _client_recv(&pdu, buf, sizeof(buf), COAP_CODE_GATEWAY_TIMEOUT);
+    TEST_ASSERT_EQUAL_INT(0, pdu.payload_len);
+}
+
+Test *tests_gcoap_forward_proxy(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_gcoap_forward_proxy__options),
+        new_TestFixture(test_gcoap_forward_proxy__con),
+        new_TestFixture(test_gcoap_forward_proxy__revalidate),
+        new_TestFixture(test_gcoap_forward_proxy__timeout),
+    };
+
+    EMB_UNIT_TESTCALLER(gcoap_forward_proxy_tests, NULL, NULL, fixtures);
+    return (Test *)&gcoap_forward_proxy_tests;
+}
+
+int main(void)
+{
+    sock_udp_ep_t local;
+
+    _loopback(&_proxy, CONFIG_GCOAP_PORT);
+    _loopback(&local, CLIENT_PORT);
+    sock_udp_create(&_client, &local, NULL, 0);
+    _loopback(&local, ORIGIN_PORT);
+    sock_udp_create(&_origin, &local, NULL, 0);
+
+    TESTS_START();
+    TESTS_RUN(tests_gcoap_forward_proxy());
+    TESTS_END();
+
+    return 0;
+}
@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Tests the notifications of gcoap to multiple observers
+ *
+ * The observers are UDP socks of the application, with tokens of different
+ * lengths, which reach gcoap via the loopback address.
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "embUnit.h"
+#include "kernel_defines.h"
+#include "net/gcoap.h"
+#include "net/ipv6/addr.h"
+#include "net/sock/udp.h"
+
+#define OBSERVERS_NUMOF     (3U)
+#define OBSERVER_PORT       (6000U)
+#define RECV_TIMEOUT        (1000000U)
+
+static ssize_t _handler(coap_pkt_t *pdu, uint8_t *buf, size_t len, void *ctx);
+
+static const coap_resource_t _resources[] = {
+    { "/obs", COAP_GET, _handler, NULL },
+    { "/other", COAP_GET, _handler, NULL },
+};
+
+static gcoap_listener_t _listener = {
+    &_resources[0],
+    ARRAY_SIZE(_resources),
+    NULL,
+    NULL
+};
+
+/* tokens of the observers; the notification header is reserved for the
+ * longest one */
+static const uint8_t _tokens[OBSERVERS_NUMOF][GCOAP_TOKENLEN_MAX] = {
+    { 0x01 },
+    { 0x02, 0x02, 0x02, 0x02 },
+    { 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03 },
+};
+static const uint8_t _token_lens[OBSERVERS_NUMOF] = { 1, 4, 8 };
+
+static sock_udp_t _socks[OBSERVERS_NUMOF];
+static sock_udp_ep_t _server;
+static char _value = '0';
+static unsigned _handler_calls;
+
+static ssize_t _handler(coap_pkt_t *pdu, uint8_t *buf, size_t len, void *ctx)
+{
+    (void)ctx;
+    _handler_calls++;
+
+    gcoap_resp_init(pdu, buf, len, COAP_CODE_CONTENT);
+    coap_opt_add_format(pdu, COAP_FORMAT_TEXT);
+    size_t resp_len = coap_opt_finish(pdu, COAP_OPT_FINISH_PAYLOAD);
+
+    pdu->payload[0] = _value;
+    return resp_len + 1;
+}
+
+static void _loopback(sock_udp_ep_t *ep, uint16_t port)
+{
+    memset(ep, 0, sizeof(*ep));
+    ep->family = AF_INET6;
+    ep->netif = SOCK_ADDR_ANY_NETIF;
+    memcpy(ep->addr.ipv6, &ipv6_addr_loopback, sizeof(ep->addr.ipv6));
+    ep->port = port;
+}
+
+/* Receives a 2.05 response or notification of the observer idx */
+static void _recv(unsigned idx, coap_pkt_t *pdu, uint8_t *buf, size_t len)
+{
+    ssize_t res = sock_udp_recv(&_socks[idx], buf, len, RECV_TIMEOUT, NULL);
+
+    TEST_ASSERT(res > 0);
+    TEST_ASSERT_EQUAL_INT(0, coap_parse(pdu, buf, res));
+    TEST_ASSERT_EQUAL_INT(COAP_TYPE_NON, coap_get_type(pdu));
+    TEST_ASSERT_EQUAL_INT(COAP_CODE_CONTENT, coap_get_code_raw(pdu));
+    TEST_ASSERT_EQUAL_INT(_token_lens[idx], coap_get_token_len(pdu));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(_tokens[idx], pdu->token,
+                                    _token_lens[idx]));
+    TEST_ASSERT(coap_has_observe(pdu));
+    TEST_ASSERT_EQUAL_INT(1, pdu->payload_len);
+}
+
+static void test_gcoap_observe__register(void)
+{
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+    coap_pkt_t pdu;
+
+    for (unsigned i = 0; i < OBSERVERS_NUMOF; i++) {
+        ssize_t len = coap_build_hdr((coap_hdr_t *)buf, COAP_TYPE_NON,
+                                     (uint8_t *)_tokens[i], _token_lens[i],
+                                     COAP_METHOD_GET, i + 1);
+        coap_pkt_init(&pdu, buf, sizeof(buf), len);
+        coap_opt_add_uint(&pdu, COAP_OPT_OBSERVE, COAP_OBS_REGISTER);
+        coap_opt_add_uri_path(&pdu, _resources[0].path);
+        len = coap_opt_finish(&pdu, COAP_OPT_FINISH_NONE);
+        TEST_ASSERT_EQUAL_INT(len, sock_udp_send(&_socks[i], buf, len,
+                                                 &_server));
+
+        _recv(i, &pdu, buf, sizeof(buf));
+        TEST_ASSERT_EQUAL_INT('0', pdu.payload[0]);
+    }
+    TEST_ASSERT_EQUAL_INT(OBSERVERS_NUMOF, _handler_calls);
+}
+
+static void test_gcoap_observe__send(void)
+{
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+    uint8_t orig[CONFIG_GCOAP_PDU_BUF_SIZE];
+    unsigned msgids[OBSERVERS_NUMOF];
+    coap_pkt_t pdu;
+
+    TEST_ASSERT_EQUAL_INT(GCOAP_OBS_INIT_UNUSED,
+                          gcoap_obs_init(&pdu, buf, sizeof(buf),
+                                         &_resources[1]));
+    TEST_ASSERT_EQUAL_INT(GCOAP_OBS_INIT_OK,
+                          gcoap_obs_init(&pdu, buf, sizeof(buf),
+                                         &_resources[0]));
+    coap_opt_add_format(&pdu, COAP_FORMAT_TEXT);
+    size_t len = coap_opt_finish(&pdu, COAP_OPT_FINISH_PAYLOAD);
+    pdu.payload[0] = 's';
+    len++;
+    memcpy(orig, buf, len);
+
+    /* the notification is sent to all observers, and the header restored */
+    TEST_ASSERT_EQUAL_INT(len, gcoap_obs_send(buf, len, &_resources[0]));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(orig, buf, len));
+
+    for (unsigned i = 0; i < OBSERVERS_NUMOF; i++) {
+        _recv(i, &pdu, orig, sizeof(orig));
+        TEST_ASSERT_EQUAL_INT('s', pdu.payload[0]);
+        msgids[i] = coap_get_id(&pdu);
+        for (unsigned j = 0; j < i; j++) {
+            TEST_ASSERT(msgids[i] != msgids[j]);
+        }
+    }
+    /* gcoap did not call the handler */
+    TEST_ASSERT_EQUAL_INT(OBSERVERS_NUMOF, _handler_calls);
+}
+
+static void test_gcoap_observe__notify(void)
+{
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+    coap_pkt_t pdu;
+    unsigned calls = _handler_calls;
+
+    TEST_ASSERT_EQUAL_INT(-ENOENT, gcoap_obs_notify(&_resources[1]));
+
+    /* the first change is notified right away */
+    _value = '1';
+    TEST_ASSERT_EQUAL_INT(0, gcoap_obs_notify(&_resources[0]));
+    for (unsigned i = 0; i < OBSERVERS_NUMOF; i++) {
+        _recv(i, &pdu, buf, sizeof(buf));
+        TEST_ASSERT_EQUAL_INT('1', pdu.payload[0]);
+    }
+    TEST_ASSERT_EQUAL_INT(calls + 1, _handler_calls);
+
+    /* changes within the interval are coalesced into one notification of
+     * the latest state */
+    _value = '2';
+    TEST_ASSERT_EQUAL_INT(0, gcoap_obs_notify(&_resources[0]));
+    _value = '3';
+    TEST_ASSERT_EQUAL_INT(0, gcoap_obs_notify(&_resources[0]));
+    TEST_ASSERT_EQUAL_INT(calls + 1, _handler_calls);
+    for (unsigned i = 0; i < OBSERVERS_NUMOF; i++) {
+        _recv(i, &pdu, buf, sizeof(buf));
+        TEST_ASSERT_EQUAL_INT('3', pdu.payload[0]);
+    }
+    TEST_ASSERT_EQUAL_INT(calls + 2, _handler_calls);
+
+    for (unsigned i = 0; i < OBSERVERS_NUMOF; i++) {
+        TEST_ASSERT_EQUAL_INT(-ETIMEDOUT,
+                              sock_udp_recv(&_socks[i], buf, sizeof(buf),
+                                            2 * CONFIG_GCOAP_OBS_NOTIFY_INTERVAL,
+                                            NULL));
+    }
+    TEST_ASSERT_EQUAL_INT(calls + 2, _handler_calls);
+}
+
+Test *tests_gcoap_observe(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_gcoap_observe__register),
+        new_TestFixture(test_gcoap_observe__send),
+        new_TestFixture(test_gcoap_observe__notify),
+    };
+
+    EMB_UNIT_TESTCALLER(gcoap_observe_tests, NULL, NULL, fixtures);
+    return (Test *)&gcoap_observe_tests;
+}
+
+int main(void)
+{
+    gcoap_register_listener(&_listener);
+    _loopback(&_server, CONFIG_GCOAP_PORT);
+    for (unsigned i = 0; i < OBSERVERS_NUMOF; i++) {
+        sock_udp_ep_t local;
+
+        _loopback(&local, OBSERVER_PORT + i);
+        sock_udp_create(&_socks[i], &local, NULL, 0);
+    }
+
+    TESTS_START();
+    TESTS_RUN(tests_gcoap_observe());
+    TESTS_END();
+
+    return 0;
+}
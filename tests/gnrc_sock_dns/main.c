@@ -23,12 +23,20 @@
 
 #include <arpa/inet.h>
 
+#include "mutex.h"
 #include "net/sock/dns.h"
 #include "shell.h"
+#include "thread.h"
 
 #define MAIN_QUEUE_SIZE     (8)
+#define PARALLEL_NUMOF      (2)
+
 static msg_t _main_msg_queue[MAIN_QUEUE_SIZE];
 
+static char _stacks[PARALLEL_NUMOF][THREAD_STACKSIZE_MAIN];
+static mutex_t _done[PARALLEL_NUMOF];
+static const char *_parallel_name;
+
 static int _dns(int argc, char **argv);
 
 static const shell_command_t _shell_commands[] = {
@@ -41,6 +49,8 @@ static void _usage(char *cmd)
 {
     printf("usage: %s server <DNS server addr> <DNS server port>\n", cmd);
     printf("       %s request <name>\n", cmd);
+    printf("       %s parallel <name>\n", cmd);
+    printf("       %s flush\n", cmd);
 }
 
 static int _dns_server(int argc, char **argv)
@@ -70,25 +80,60 @@ static int _dns_server(int argc, char **argv)
     return 0;
 }
 
-static int _dns_request(char **argv)
+static int _resolve(const char *name)
 {
     uint8_t addr[16] = {0};
-    int res = sock_dns_query(argv[2], addr, AF_UNSPEC);
+    int res = sock_dns_query(name, addr, AF_UNSPEC);
 
     if (res > 0) {
         char addrstr[INET6_ADDRSTRLEN];
 
         inet_ntop(res == 4 ? AF_INET : AF_INET6, addr, addrstr,
                   sizeof(addrstr));
-        printf("%s resolves to %s\n", argv[2], addrstr);
+        printf("%s resolves to %s\n", name, addrstr);
     }
     else {
-        printf("error resolving %s\n", argv[2]);
+        printf("error resolving %s\n", name);
         return 1;
     }
     return 0;
 }
 
+static int _dns_request(char **argv)
+{
+    return _resolve(argv[2]);
+}
+
+static void *_parallel_thread(void *arg)
+{
+    unsigned i = (uintptr_t)arg;
+
+    _resolve(_parallel_name);
+    mutex_unlock(&_done[i]);
+    return NULL;
+}
+
+/* resolves the same name from several threads at the same time */
+static int _dns_parallel(char **argv)
+{
+    _parallel_name = argv[2];
+    for (unsigned i = 0; i < PARALLEL_NUMOF; i++) {
+        mutex_init(&_done[i]);
+        mutex_lock(&_done[i]);
+        if (thread_create(_stacks[i], sizeof(_stacks[i]),
+                          THREAD_PRIORITY_MAIN - 1, THREAD_CREATE_STACKTEST,
+                          _parallel_thread, (void *)(uintptr_t)i,
+                          "dns") < 0) {
+            puts("error creating thread");
+            return 1;
+        }
+    }
+    for (unsigned i = 0; i < PARALLEL_NUMOF; i++) {
+        mutex_lock(&_done[i]);
+    }
+    return 0;
+}
+
 static int _dns(int argc, char **argv)
 {
     if ((argc > 1) && (strcmp(argv[1], "server") == 0)) {
@@ -97,6 +142,13 @@ static int _dns(int argc, char **argv)
     else if ((argc > 2) && (strcmp(argv[1], "request") == 0)) {
         return _dns_request(argv);
     }
+    else if ((argc > 2) && (strcmp(argv[1], "parallel") == 0)) {
+        return _dns_parallel(argv);
+    }
+    else if ((argc > 1) && (strcmp(argv[1], "flush") == 0)) {
+        sock_dns_cache_flush();
+        return 0;
+    }
     else {
         _usage(argv[0]);
         return 1;
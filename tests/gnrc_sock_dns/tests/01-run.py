@@ -10,6 +10,7 @@ import base64
 import os
 import re
 import socket
+import struct
 import sys
 import subprocess
 import threading
@@ -20,6 +21,7 @@ from testrunner import run
 
 
 SERVER_TIMEOUT = 5
+SERVER_POLL_INTERVAL = 0.1
 SERVER_PORT = 5335  # 53 requires root and 5353 is used by e.g. Chrome for MDNS
 
 
@@ -33,8 +35,15 @@ DNS_MSG_COMP_MASK = b"\xc0"
 TEST_NAME = "example.org"
 TEST_A_DATA = "10.0.0.1"
 TEST_AAAA_DATA = "2001:db8::1"
+TEST_CNAME = "www.example.org"
 TEST_QDCOUNT = 2
 TEST_ANCOUNT = 2
+TEST_TTL = 2
+TEST_MAX_TTL = 3    # CONFIG_SOCK_DNS_CACHE_MAX_TTL set in the Makefile
+TEST_SPOOF_NAME = "example.com"
+TEST_SPOOF_AAAA_DATA = "2001:db8::bad"
+DNS_RCODE_NXDOMAIN = 3
+DNS_RR_TYPE_CNAME = 5
 
 
 class Server(threading.Thread):
@@ -49,16 +58,21 @@ class Server(threading.Thread):
             else:
                 sockaddr = ("", bind_port)
             self.socket.bind(sockaddr)
+        self.socket.settimeout(SERVER_POLL_INTERVAL)
         self.stopped = False
-        self.enter_loop = threading.Event()
+        self.reply = None
+        self.delay = 0
+        self.spoof = None
+        self.spoof_id_delta = 0
+        self.queries = 0
 
     def run(self):
-        while True:
-            self.enter_loop.wait()
-            self.enter_loop.clear()
-            if self.stopped:
-                return
-            p, remote = self.socket.recvfrom(1500)
+        while not self.stopped:
+            try:
+                p, remote = self.socket.recvfrom(1500)
+            except socket.timeout:
+                continue
+            self.queries += 1
             p = DNS(raw(p))
             # check received packet for correctness
             assert(p is not None)
@@ -75,18 +89,37 @@ class Server(threading.Thread):
             assert(any(p[DNS].qd[i].qtype == DNS_RR_TYPE_AAAA
                        for i in range(qdcount)))    # one is AAAA
             if self.reply is not None:
-                self.socket.sendto(raw(self.reply), remote)
-                self.reply = None
-
-    def listen(self, reply=None):
+                time.sleep(self.delay)
+                if self.spoof is not None:
+                    self.socket.sendto(self.answer(p, self.spoof,
+                                                   self.spoof_id_delta),
+                                       remote)
+                self.socket.sendto(self.answer(p, self.reply), remote)
+
+    @staticmethod
+    def answer(query, reply, id_delta=0):
+        """returns reply with the ID of query, changed by id_delta"""
+        reply = raw(reply)
+        if len(reply) < 2:
+            return reply
+        return struct.pack("!H", (query[DNS].id + id_delta) & 0xffff) + \
+            reply[2:]
+
+    def listen(self, reply=None, delay=0, spoof=None, spoof_id_delta=0):
+        """answers all following queries with reply and counts them
+
+        spoof is sent before reply, with the ID of the query changed by
+        spoof_id_delta"""
         self.reply = reply
-        self.enter_loop.set()
+        self.delay = delay
+        self.spoof = spoof
+        self.spoof_id_delta = spoof_id_delta
+        self.queries = 0
 
     def stop(self):
         self.stopped = True
-        self.enter_loop.set()
-        self.socket.close()
         self.join()
+        self.socket.close()
 
 
 server = None
@@ -130,6 +163,12 @@ def dns_server(child, server, port=53):
     child.expect(r"DNS server: \[{}\]:{:d}".format(server, port))
 
 
+def dns_flush(child):
+    child.sendline("dns flush")
+    child.sendline("dns server")
+    child.expect(r"DNS server: \[[0-9A-Fa-f:]+\]:\d+")
+
+
 def successful_dns_request(child, name, exp_addr=None):
     child.sendline("dns request {}".format(name))
     res = child.expect(["error resolving {}".format(name),
@@ -138,6 +177,16 @@ def successful_dns_request(child, name, exp_addr=None):
     return ((res > 0) and (exp_addr is not None))
 
 
+def success_reply(ttl=86400, name=TEST_NAME, aaaa_data=TEST_AAAA_DATA):
+    return DNS(qr=1, qdcount=TEST_QDCOUNT, ancount=TEST_ANCOUNT,
+               qd=(DNSQR(qname=name, qtype=DNS_RR_TYPE_AAAA) /
+                   DNSQR(qname=name, qtype=DNS_RR_TYPE_A)),
+               an=(DNSRR(rrname=name, type=DNS_RR_TYPE_AAAA, ttl=ttl,
+                         rdlen=DNS_RR_TYPE_AAAA_DLEN, rdata=aaaa_data) /
+                   DNSRR(rrname=name, type=DNS_RR_TYPE_A, ttl=ttl,
+                         rdlen=DNS_RR_TYPE_A_DLEN, rdata=TEST_A_DATA)))
+
+
 def test_success(child):
     server.listen(DNS(qr=1, qdcount=TEST_QDCOUNT, ancount=TEST_ANCOUNT,
                       qd=(DNSQR(qname=TEST_NAME, qtype=DNS_RR_TYPE_AAAA) /
@@ -154,6 +203,107 @@ def test_timeout(child):
     # listen but send no reply
     server.listen()
     assert(not successful_dns_request(child, TEST_NAME, TEST_AAAA_DATA))
+    # a timeout is not cached
+    server.listen(success_reply())
+    assert(successful_dns_request(child, TEST_NAME, TEST_AAAA_DATA))
+    assert(server.queries == 1)
+
+
+def test_aaaa_preferred(child):
+    # the AAAA record is used even if it comes second
+    server.listen(DNS(qr=1, qdcount=TEST_QDCOUNT, ancount=TEST_ANCOUNT,
+                      qd=(DNSQR(qname=TEST_NAME, qtype=DNS_RR_TYPE_AAAA) /
+                          DNSQR(qname=TEST_NAME, qtype=DNS_RR_TYPE_A)),
+                      an=(DNSRR(rrname=TEST_NAME, type=DNS_RR_TYPE_A,
+                                rdlen=DNS_RR_TYPE_A_DLEN, rdata=TEST_A_DATA) /
+                          DNSRR(rrname=TEST_NAME, type=DNS_RR_TYPE_AAAA,
+                                rdlen=DNS_RR_TYPE_AAAA_DLEN,
+                                rdata=TEST_AAAA_DATA))))
+    assert(successful_dns_request(child, TEST_NAME, TEST_AAAA_DATA))
+
+
+def test_a_fallback(child):
+    server.listen(DNS(qr=1, qdcount=TEST_QDCOUNT, ancount=1,
+                      qd=(DNSQR(qname=TEST_NAME, qtype=DNS_RR_TYPE_AAAA) /
+                          DNSQR(qname=TEST_NAME, qtype=DNS_RR_TYPE_A)),
+                      an=DNSRR(rrname=TEST_NAME, type=DNS_RR_TYPE_A,
+                               rdlen=DNS_RR_TYPE_A_DLEN, rdata=TEST_A_DATA)))
+    assert(successful_dns_request(child, TEST_NAME, TEST_A_DATA))
+
+
+def test_skip_cname(child):
+    # the RDATA of the CNAME record must be skipped along with its RDLENGTH
+    server.listen(DNS(qr=1, qdcount=TEST_QDCOUNT, ancount=TEST_ANCOUNT,
+                      qd=(DNSQR(qname=TEST_NAME, qtype=DNS_RR_TYPE_AAAA) /
+                          DNSQR(qname=TEST_NAME, qtype=DNS_RR_TYPE_A)),
+                      an=(DNSRR(rrname=TEST_NAME, type=DNS_RR_TYPE_CNAME,
+                                rdata=TEST_CNAME) /
+                          DNSRR(rrname=TEST_CNAME, type=DNS_RR_TYPE_AAAA,
+                                rdlen=DNS_RR_TYPE_AAAA_DLEN,
+                                rdata=TEST_AAAA_DATA))))
+    assert(successful_dns_request(child, TEST_NAME, TEST_AAAA_DATA))
+
+
+def test_cache_ttl(child):
+    server.listen(success_reply(ttl=TEST_TTL))
+    assert(successful_dns_request(child, TEST_NAME, TEST_AAAA_DATA))
+    assert(successful_dns_request(child, TEST_NAME, TEST_AAAA_DATA))
+    assert(server.queries == 1)
+    # asked again once the TTL expired
+    time.sleep(TEST_TTL + 1)
+    assert(successful_dns_request(child, TEST_NAME, TEST_AAAA_DATA))
+    assert(server.queries == 2)
+
+
+def test_cache_max_ttl(child):
+    # the TTL of the server is capped
+    server.listen(success_reply())
+    assert(successful_dns_request(child, TEST_NAME, TEST_AAAA_DATA))
+    time.sleep(TEST_MAX_TTL + 1)
+    assert(successful_dns_request(child, TEST_NAME, TEST_AAAA_DATA))
+    assert(server.queries == 2)
+
+
+def test_spoofed_id(child):
+    # a reply with another ID is dropped, the one to the query is used
+    server.listen(success_reply(),
+                  spoof=success_reply(aaaa_data=TEST_SPOOF_AAAA_DATA),
+                  spoof_id_delta=1)
+    assert(successful_dns_request(child, TEST_NAME, TEST_AAAA_DATA))
+
+
+def test_spoofed_question(child):
+    # a reply with the right ID but for another name is dropped as well
+    server.listen(success_reply(),
+                  spoof=success_reply(name=TEST_SPOOF_NAME,
+                                      aaaa_data=TEST_SPOOF_AAAA_DATA))
+    assert(successful_dns_request(child, TEST_NAME, TEST_AAAA_DATA))
+
+
+def test_cache_negative(child):
+    server.listen(DNS(qr=1, rcode=DNS_RCODE_NXDOMAIN, qdcount=TEST_QDCOUNT,
+                      ancount=0,
+                      qd=(DNSQR(qname=TEST_NAME, qtype=DNS_RR_TYPE_AAAA) /
+                          DNSQR(qname=TEST_NAME, qtype=DNS_RR_TYPE_A))))
+    assert(not successful_dns_request(child, TEST_NAME))
+    assert(server.queries == 1)
+    # the failure is cached, not asked again
+    assert(not successful_dns_request(child, TEST_NAME))
+    assert(server.queries == 1)
+    dns_flush(child)
+    assert(not successful_dns_request(child, TEST_NAME))
+    assert(server.queries == 2)
+
+
+def test_coalescing(child):
+    # the reply is delayed so the queries of both threads overlap
+    server.listen(success_reply(), delay=0.5)
+    child.sendline("dns parallel {}".format(TEST_NAME))
+    for _ in range(2):
+        child.expect_exact("{} resolves to {}".format(TEST_NAME,
+                                                      TEST_AAAA_DATA),
+                           timeout=3)
+    assert(server.queries == 1)
 
 
 def test_too_short_response(child):
@@ -283,6 +433,8 @@ def testfunc(child):
         dns_server(child, lladdr, SERVER_PORT)
 
         def run(func):
+            # every test starts without cached results
+            dns_flush(child)
             if child.logfile == sys.stdout:
                 print(func.__name__)
                 func(child)
@@ -308,6 +460,15 @@ def testfunc(child):
         run(test_addrlen_too_large)
         run(test_addrlen_wrong_ip6)
         run(test_addrlen_wrong_ip4)
+        run(test_aaaa_preferred)
+        run(test_a_fallback)
+        run(test_skip_cname)
+        run(test_cache_ttl)
+        run(test_cache_max_ttl)
+        run(test_cache_negative)
+        run(test_coalescing)
+        run(test_spoofed_id)
+        run(test_spoofed_question)
         print("SUCCESS")
     finally:
         if server is not None:
@@ -719,6 +719,53 @@ static void test_sock_udp_send__no_sock(void)
     expect(_check_net());
 }
 
+static void test_sock_udp_sendv__socketed(void)
+{
+    static const ipv6_addr_t src_addr = { .u8 = _TEST_ADDR_LOCAL };
+    static const ipv6_addr_t dst_addr = { .u8 = _TEST_ADDR_REMOTE };
+    static const sock_udp_ep_t local = { .addr = { .ipv6 = _TEST_ADDR_LOCAL },
+                                         .family = AF_INET6,
+                                         .netif = _TEST_NETIF,
+                                         .port = _TEST_PORT_LOCAL };
+    static const sock_udp_ep_t remote = { .addr = { .ipv6 = _TEST_ADDR_REMOTE },
+                                          .family = AF_INET6,
+                                          .port = _TEST_PORT_REMOTE };
+    /* empty snip in between must not show up in the packet */
+    iolist_t snips[] = {
+        { .iol_next = &snips[1], .iol_base = "AB", .iol_len = 2 },
+        { .iol_next = &snips[2], .iol_base = NULL, .iol_len = 0 },
+        { .iol_next = NULL, .iol_base = "CD", .iol_len = sizeof("CD") },
+    };
+
+    expect(0 == sock_udp_create(&_sock, &local, &remote, SOCK_FLAGS_REUSE_EP));
+    expect(sizeof("ABCD") == sock_udp_sendv(&_sock, snips, NULL));
+    expect(_check_packet(&src_addr, &dst_addr, _TEST_PORT_LOCAL,
+                         _TEST_PORT_REMOTE, "ABCD", sizeof("ABCD"),
+                         _TEST_NETIF, false));
+    xtimer_usleep(1000);    /* let GNRC stack finish */
+    expect(_check_net());
+}
+
+static void test_sock_udp_sendv__no_sock(void)
+{
+    static const ipv6_addr_t dst_addr = { .u8 = _TEST_ADDR_REMOTE };
+    static const sock_udp_ep_t remote = { .addr = { .ipv6 = _TEST_ADDR_REMOTE },
+                                          .family = AF_INET6,
+                                          .netif = _TEST_NETIF,
+                                          .port = _TEST_PORT_REMOTE };
+    iolist_t snips[] = {
+        { .iol_next = &snips[1], .iol_base = "A", .iol_len = 1 },
+        { .iol_next = NULL, .iol_base = "BCD", .iol_len = sizeof("BCD") },
+    };
+
+    expect(sizeof("ABCD") == sock_udp_sendv(NULL, snips, &remote));
+    expect(_check_packet(&ipv6_addr_unspecified, &dst_addr, 0,
+                         _TEST_PORT_REMOTE, "ABCD", sizeof("ABCD"),
+                         _TEST_NETIF, true));
+    xtimer_usleep(1000);    /* let GNRC stack finish */
+    expect(_check_net());
+}
+
 int main(void)
 {
     _net_init();
@@ -768,6 +815,8 @@ int main(void)
     CALL(test_sock_udp_send__unsocketed());
     CALL(test_sock_udp_send__no_sock_no_netif());
     CALL(test_sock_udp_send__no_sock());
+    CALL(test_sock_udp_sendv__socketed());
+    CALL(test_sock_udp_sendv__no_sock());
 
     puts("ALL TESTS SUCCESSFUL");
 
@@ -1314,6 +1314,53 @@ static void test_sock_udp_send6__no_sock(void)
     xtimer_usleep(1000);    /* let lwIP stack finish */
     expect(_check_net());
 }
+
+static void test_sock_udp_sendv6__socketed(void)
+{
+    static const ipv6_addr_t src_addr = { .u8 = _TEST_ADDR6_LOCAL };
+    static const ipv6_addr_t dst_addr = { .u8 = _TEST_ADDR6_REMOTE };
+    static const sock_udp_ep_t local = { .addr = { .ipv6 = _TEST_ADDR6_LOCAL },
+                                         .family = AF_INET6,
+                                         .netif = _TEST_NETIF,
+                                         .port = _TEST_PORT_LOCAL };
+    static const sock_udp_ep_t remote = { .addr = { .ipv6 = _TEST_ADDR6_REMOTE },
+                                          .family = AF_INET6,
+                                          .port = _TEST_PORT_REMOTE };
+    /* empty snip in between must not show up in the packet */
+    iolist_t snips[] = {
+        { .iol_next = &snips[1], .iol_base = "AB", .iol_len = 2 },
+        { .iol_next = &snips[2], .iol_base = NULL, .iol_len = 0 },
+        { .iol_next = NULL, .iol_base = "CD", .iol_len = sizeof("CD") },
+    };
+
+    expect(0 == sock_udp_create(&_sock, &local, &remote, SOCK_FLAGS_REUSE_EP));
+    expect(sizeof("ABCD") == sock_udp_sendv(&_sock, snips, NULL));
+    expect(_check_6packet(&src_addr, &dst_addr, _TEST_PORT_LOCAL,
+                          _TEST_PORT_REMOTE, "ABCD", sizeof("ABCD"),
+                          _TEST_NETIF, false));
+    xtimer_usleep(1000);    /* let lwIP stack finish */
+    expect(_check_net());
+}
+
+static void test_sock_udp_sendv6__no_sock(void)
+{
+    static const ipv6_addr_t dst_addr = { .u8 = _TEST_ADDR6_REMOTE };
+    static const sock_udp_ep_t remote = { .addr = { .ipv6 = _TEST_ADDR6_REMOTE },
+                                          .family = AF_INET6,
+                                          .netif = _TEST_NETIF,
+                                          .port = _TEST_PORT_REMOTE };
+    iolist_t snips[] = {
+        { .iol_next = &snips[1], .iol_base = "A", .iol_len = 1 },
+        { .iol_next = NULL, .iol_base = "BCD", .iol_len = sizeof("BCD") },
+    };
+
+    expect(sizeof("ABCD") == sock_udp_sendv(NULL, snips, &remote));
+    expect(_check_6packet(&ipv6_addr_unspecified, &dst_addr, 0,
+                          _TEST_PORT_REMOTE, "ABCD", sizeof("ABCD"),
+                          _TEST_NETIF, true));
+    xtimer_usleep(1000);    /* let lwIP stack finish */
+    expect(_check_net());
+}
 #endif /* MODULE_LWIP_IPV6 */
 
 int main(void)
@@ -1425,6 +1472,8 @@ int main(void)
     CALL(test_sock_udp_send6__unsocketed());
     CALL(test_sock_udp_send6__no_sock_no_netif());
     CALL(test_sock_udp_send6__no_sock());
+    CALL(test_sock_udp_sendv6__socketed());
+    CALL(test_sock_udp_sendv6__no_sock());
 #endif /* MODULE_LWIP_IPV6 */
 
     puts("ALL TESTS SUCCESSFUL");
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Types of the UDP sock mock
+ *
+ * @}
+ */
+
+#ifndef SOCK_TYPES_H
+#define SOCK_TYPES_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Mocked UDP sock, connected to the scripted server
+ */
+struct sock_udp {
+    sock_udp_ep_t remote;                   /**< remote endpoint */
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOCK_TYPES_H */
+/** @} */
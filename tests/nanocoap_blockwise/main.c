@@ -0,0 +1,382 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Tests the block-wise GET of nanocoap against a scripted server
+ *
+ * The UDP sock is mocked: requests sent are queued at the server, which
+ * answers one of them on each receive. The script of a test makes the server
+ * answer out of order, lose and duplicate responses, switch the block size
+ * or fail. Requests for blocks past the end of the resource are never
+ * answered.
+ *
+ * @}
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "embUnit.h"
+#include "net/nanocoap_sock.h"
+#include "xtimer.h"
+
+#define RESOURCE_LEN        (200U)
+/* blocks of 16 bytes, the last one holds 8 */
+#define LAST_BLOCK          (12U)
+#define REQS_MAX            (16U)
+#define BLOCKS_MAX          (32U)
+
+typedef struct {
+    uint16_t id;
+    uint32_t num;
+    unsigned szx;
+    unsigned attempt;           /* 1 for the first request of the block */
+    bool copy;                  /* duplicate of an answered request */
+} _req_t;
+
+static struct {
+    /* script of the test */
+    unsigned szx;               /* largest block size of the server */
+    bool lifo;                  /* answers the latest request first */
+    uint8_t drop[BLOCKS_MAX];   /* lost responses to the first requests */
+    uint32_t dup;               /* blocks with a duplicated response */
+    uint32_t error;             /* blocks answered with 4.04 */
+    uint32_t resize;            /* blocks answered with a larger block size */
+    /* record of the requests */
+    _req_t pending[REQS_MAX];
+    unsigned pending_num;
+    unsigned in_flight_max;
+    unsigned reqs[BLOCKS_MAX];
+    uint32_t szx_seen;          /* sizes asked for after the first block */
+} _server;
+
+static struct {
+    uint8_t data[RESOURCE_LEN];
+    size_t len;
+    bool ordered;               /* blocks passed in order, more flags right */
+    unsigned cancel;            /* number of the block to fail on */
+} _rx;
+
+static uint8_t _resource[RESOURCE_LEN];
+/* connected to the server by definition */
+static sock_udp_t _sock;
+
+int sock_udp_create(sock_udp_t *sock, const sock_udp_ep_t *local,
+                    const sock_udp_ep_t *remote, uint16_t flags)
+{
+    (void)local;
+    (void)flags;
+    if (remote) {
+        sock->remote = *remote;
+    }
+    return 0;
+}
+
+void sock_udp_close(sock_udp_t *sock)
+{
+    (void)sock;
+}
+
+ssize_t sock_udp_send(sock_udp_t *sock, const void *data, size_t len,
+                      const sock_udp_ep_t *remote)
+{
+    uint8_t buf[CONFIG_NANOCOAP_BLOCK_HEADER_MAX];
+    coap_pkt_t pdu;
+    coap_block1_t block2;
+
+    (void)sock;
+    (void)remote;
+    if ((len > sizeof(buf)) || (_server.pending_num == REQS_MAX)) {
+        return -ENOMEM;
+    }
+    memcpy(buf, data, len);
+    if ((coap_parse(&pdu, buf, len) < 0) || !coap_get_block2(&pdu, &block2) ||
+        (block2.blknum >= BLOCKS_MAX)) {
+        return -EINVAL;
+    }
+
+    _req_t *req = &_server.pending[_server.pending_num++];
+    req->id = coap_get_id(&pdu);
+    req->num = block2.blknum;
+    req->szx = block2.szx;
+    req->attempt = ++_server.reqs[block2.blknum];
+    req->copy = false;
+    if (block2.blknum > 0) {
+        _server.szx_seen |= 1U << block2.szx;
+    }
+    if (_server.pending_num > _server.in_flight_max) {
+        _server.in_flight_max = _server.pending_num;
+    }
+    return len;
+}
+
+static _req_t _take(void)
+{
+    _req_t req;
+
+    if (_server.lifo) {
+        req = _server.pending[--_server.pending_num];
+    }
+    else {
+        req = _server.pending[0];
+        memmove(&_server.pending[0], &_server.pending[1],
+                --_server.pending_num * sizeof(_req_t));
+    }
+    return req;
+}
+
+static ssize_t _reply(const _req_t *req, uint8_t *buf, size_t len)
+{
+    unsigned bit = 1U << req->num;
+    unsigned szx = (req->szx < _server.szx) ? req->szx : _server.szx;
+    coap_pkt_t pdu;
+
+    if (_server.resize & bit) {
+        szx++;
+    }
+    size_t size = coap_szx2size(szx);
+    size_t offset = req->num * size;
+    size_t n = ((offset + size) < RESOURCE_LEN) ? size : RESOURCE_LEN - offset;
+    ssize_t res = coap_build_hdr((coap_hdr_t *)buf, COAP_TYPE_ACK, NULL, 0,
+                                 (_server.error & bit)
+                                 ? COAP_CODE_PATH_NOT_FOUND : COAP_CODE_CONTENT,
+                                 req->id);
+
+    coap_pkt_init(&pdu, buf, len, res);
+    if (_server.error & bit) {
+        return coap_opt_finish(&pdu, COAP_OPT_FINISH_NONE);
+    }
+    coap_opt_add_uint(&pdu, COAP_OPT_BLOCK2,
+                      (req->num << 4) |
+                      ((offset + n < RESOURCE_LEN) ? 0x8 : 0) | szx);
+    res = coap_opt_finish(&pdu, COAP_OPT_FINISH_PAYLOAD);
+    if (pdu.payload_len < n) {
+        return -ENOBUFS;
+    }
+    memcpy(pdu.payload, &_resource[offset], n);
+    return res + n;
+}
+
+ssize_t sock_udp_recv(sock_udp_t *sock, void *data, size_t max_len,
+                      uint32_t timeout, sock_udp_ep_t *remote)
+{
+    (void)sock;
+    (void)remote;
+    while (_server.pending_num) {
+        _req_t req = _take();
+        unsigned size = coap_szx2size((req.szx < _server.szx) ? req.szx
+                                                              : _server.szx);
+
+        if ((req.num * size >= RESOURCE_LEN) ||
+            (!req.copy && (req.attempt <= _server.drop[req.num]))) {
+            continue;
+        }
+        if (!req.copy && (_server.dup & (1U << req.num))) {
+            _server.pending[_server.pending_num] = req;
+            _server.pending[_server.pending_num++].copy = true;
+        }
+        return _reply(&req, data, max_len);
+    }
+    if (timeout == SOCK_NO_TIMEOUT) {
+        return -EINVAL;
+    }
+    xtimer_usleep(timeout);
+    return -ETIMEDOUT;
+}
+
+static int _callback(void *arg, size_t offset, uint8_t *buf, size_t len,
+                     int more)
+{
+    (void)arg;
+    if ((offset != _rx.len) || (offset + len > RESOURCE_LEN) ||
+        (more != (offset + len < RESOURCE_LEN))) {
+        _rx.ordered = false;
+        return -1;
+    }
+    if (_rx.cancel && (offset >= _rx.cancel * 16)) {
+        return -1;
+    }
+    memcpy(&_rx.data[offset], buf, len);
+    _rx.len += len;
+    return 0;
+}
+
+static void set_up(void)
+{
+    memset(&_server, 0, sizeof(_server));
+    _server.szx = COAP_BLOCKSIZE_1024;
+    memset(&_rx, 0, sizeof(_rx));
+    _rx.ordered = true;
+    for (unsigned i = 0; i < RESOURCE_LEN; i++) {
+        _resource[i] = i;
+    }
+}
+
+static void _assert_complete(void)
+{
+    TEST_ASSERT(_rx.ordered);
+    TEST_ASSERT_EQUAL_INT(RESOURCE_LEN, _rx.len);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(_resource, _rx.data, RESOURCE_LEN));
+    /* requests past the last block are sent at most once */
+    for (unsigned i = LAST_BLOCK + 1; i < BLOCKS_MAX; i++) {
+        TEST_ASSERT(_server.reqs[i] <= 1);
+    }
+}
+
+static void test_nanocoap_blockwise__stop_and_wait(void)
+{
+    uint8_t buf[NANOCOAP_BLOCKWISE_BUF(COAP_BLOCKSIZE_16, 1)];
+
+    TEST_ASSERT_EQUAL_INT(0, nanocoap_get_blockwise(&_sock, "/res",
+                                                    COAP_BLOCKSIZE_16, buf,
+                                                    sizeof(buf), _callback,
+                                                    NULL));
+    _assert_complete();
+    TEST_ASSERT_EQUAL_INT(1, _server.in_flight_max);
+    for (unsigned i = 0; i <= LAST_BLOCK; i++) {
+        TEST_ASSERT_EQUAL_INT(1, _server.reqs[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(0, _server.reqs[LAST_BLOCK + 1]);
+}
+
+static void test_nanocoap_blockwise__window(void)
+{
+    uint8_t buf[NANOCOAP_BLOCKWISE_BUF(COAP_BLOCKSIZE_16, 4)];
+
+    TEST_ASSERT_EQUAL_INT(0, nanocoap_get_blockwise(&_sock, "/res",
+                                                    COAP_BLOCKSIZE_16, buf,
+                                                    sizeof(buf), _callback,
+                                                    NULL));
+    _assert_complete();
+    TEST_ASSERT_EQUAL_INT(4, _server.in_flight_max);
+    for (unsigned i = 0; i <= LAST_BLOCK; i++) {
+        TEST_ASSERT_EQUAL_INT(1, _server.reqs[i]);
+    }
+}
+
+static void test_nanocoap_blockwise__reorder(void)
+{
+    uint8_t buf[NANOCOAP_BLOCKWISE_BUF(COAP_BLOCKSIZE_16, 4)];
+
+    /* each window is answered backwards, so all but its first block go
+     * through the store of the buffer; duplicates are ignored */
+    _server.lifo = true;
+    _server.dup = (1U << 0) | (1U << 4) | (1U << 6) | (1U << LAST_BLOCK);
+    TEST_ASSERT_EQUAL_INT(0, nanocoap_get_blockwise(&_sock, "/res",
+                                                    COAP_BLOCKSIZE_16, buf,
+                                                    sizeof(buf), _callback,
+                                                    NULL));
+    _assert_complete();
+    for (unsigned i = 0; i <= LAST_BLOCK; i++) {
+        TEST_ASSERT_EQUAL_INT(1, _server.reqs[i]);
+    }
+}
+
+static void test_nanocoap_blockwise__retransmit(void)
+{
+    uint8_t buf[NANOCOAP_BLOCKWISE_BUF(COAP_BLOCKSIZE_16, 4)];
+
+    /* a lost response stalls the window, the blocks after it are kept; the
+     * last block is known while block 11 is still missing, the requests
+     * past it time out meanwhile */
+    _server.drop[3] = 1;
+    _server.drop[11] = 2;
+    TEST_ASSERT_EQUAL_INT(0, nanocoap_get_blockwise(&_sock, "/res",
+                                                    COAP_BLOCKSIZE_16, buf,
+                                                    sizeof(buf), _callback,
+                                                    NULL));
+    _assert_complete();
+    TEST_ASSERT_EQUAL_INT(2, _server.reqs[3]);
+    TEST_ASSERT_EQUAL_INT(3, _server.reqs[11]);
+    TEST_ASSERT_EQUAL_INT(1, _server.reqs[LAST_BLOCK + 1]);
+}
+
+static void test_nanocoap_blockwise__renegotiate(void)
+{
+    uint8_t buf[NANOCOAP_BLOCKWISE_BUF(COAP_BLOCKSIZE_64, 2)];
+
+    /* the server only sends 16 bytes per block, the space of one block of
+     * 64 bytes holds four of them */
+    _server.szx = COAP_BLOCKSIZE_16;
+    _server.lifo = true;
+    TEST_ASSERT_EQUAL_INT(0, nanocoap_get_blockwise(&_sock, "/res",
+                                                    COAP_BLOCKSIZE_64, buf,
+                                                    sizeof(buf), _callback,
+                                                    NULL));
+    _assert_complete();
+    TEST_ASSERT_EQUAL_INT(1U << COAP_BLOCKSIZE_16, _server.szx_seen);
+    TEST_ASSERT_EQUAL_INT(CONFIG_NANOCOAP_BLOCKWISE_WINDOW_MAX,
+                          _server.in_flight_max);
+}
+
+static void test_nanocoap_blockwise__errors(void)
+{
+    uint8_t buf[NANOCOAP_BLOCKWISE_BUF(COAP_BLOCKSIZE_16, 4)];
+
+    /* the blocks before the failed one are passed on */
+    _server.error = 1U << 5;
+    TEST_ASSERT_EQUAL_INT(-404, nanocoap_get_blockwise(&_sock, "/res",
+                                                       COAP_BLOCKSIZE_16, buf,
+                                                       sizeof(buf), _callback,
+                                                       NULL));
+    TEST_ASSERT(_rx.ordered);
+    TEST_ASSERT_EQUAL_INT(5 * 16, _rx.len);
+
+    /* a block of a size not negotiated */
+    set_up();
+    _server.resize = 1U << 4;
+    TEST_ASSERT_EQUAL_INT(-EBADMSG, nanocoap_get_blockwise(&_sock, "/res",
+                                                           COAP_BLOCKSIZE_16,
+                                                           buf, sizeof(buf),
+                                                           _callback, NULL));
+
+    /* the callback fails */
+    set_up();
+    _rx.cancel = 7;
+    TEST_ASSERT_EQUAL_INT(-ECANCELED, nanocoap_get_blockwise(&_sock, "/res",
+                                                             COAP_BLOCKSIZE_16,
+                                                             buf, sizeof(buf),
+                                                             _callback, NULL));
+    TEST_ASSERT(_rx.ordered);
+    TEST_ASSERT_EQUAL_INT(7 * 16, _rx.len);
+
+    /* the buffer does not hold a single block */
+    TEST_ASSERT_EQUAL_INT(-ENOBUFS, nanocoap_get_blockwise(&_sock, "/res",
+                                                           COAP_BLOCKSIZE_128,
+                                                           buf, sizeof(buf),
+                                                           _callback, NULL));
+}
+
+Test *tests_nanocoap_blockwise(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_nanocoap_blockwise__stop_and_wait),
+        new_TestFixture(test_nanocoap_blockwise__window),
+        new_TestFixture(test_nanocoap_blockwise__reorder),
+        new_TestFixture(test_nanocoap_blockwise__retransmit),
+        new_TestFixture(test_nanocoap_blockwise__renegotiate),
+        new_TestFixture(test_nanocoap_blockwise__errors),
+    };
+
+    EMB_UNIT_TESTCALLER(nanocoap_blockwise_tests, set_up, NULL, fixtures);
+    return (Test *)&nanocoap_blockwise_tests;
+}
+
+int main(void)
+{
+    TESTS_START();
+    TESTS_RUN(tests_nanocoap_blockwise());
+    TESTS_END();
+
+    return 0;
+}
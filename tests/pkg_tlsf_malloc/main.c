@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Tests the arenas and the fast path of tlsf-malloc
+ *
+ * @}
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "embUnit.h"
+#include "kernel_defines.h"
+#include "thread.h"
+#include "tlsf-malloc.h"
+
+#define ARENA_SIZE      (2048U)
+#define POOL_SIZE       (2048U)
+
+static uint32_t _arena_mem[ARENA_SIZE / sizeof(uint32_t)];
+static uint32_t _fast_mem[ARENA_SIZE / sizeof(uint32_t)];
+static uint32_t _pool_mem[POOL_SIZE / sizeof(uint32_t)];
+static tlsf_arena_t _arena;
+static tlsf_arena_t _fast_arena;
+
+static char _stack[THREAD_STACKSIZE_DEFAULT];
+static void *_thread_ptr;
+
+static void test_tlsf_malloc__arena(void)
+{
+    tlsf_arena_stats_t before, stats;
+
+    tlsf_arena_get_stats(&_arena, &before);
+    TEST_ASSERT(before.size > 0);
+    TEST_ASSERT(before.size <= ARENA_SIZE);
+
+    uint8_t *ptr = tlsf_arena_malloc(&_arena, 100);
+    TEST_ASSERT_NOT_NULL(ptr);
+    TEST_ASSERT(ptr >= (uint8_t *)_arena_mem);
+    TEST_ASSERT(ptr + 100 <= (uint8_t *)_arena_mem + ARENA_SIZE);
+    TEST_ASSERT(tlsf_arena_find(ptr) == &_arena);
+
+    tlsf_arena_get_stats(&_arena, &stats);
+    TEST_ASSERT(stats.used >= before.used + 100);
+    TEST_ASSERT(stats.max_used >= stats.used);
+    TEST_ASSERT_EQUAL_INT(before.allocs + 1, stats.allocs);
+
+    /* realloc stays within the arena the block came from */
+    ptr = tlsf_arena_realloc(tlsf_arena_global(), ptr, 200);
+    TEST_ASSERT_NOT_NULL(ptr);
+    TEST_ASSERT(tlsf_arena_find(ptr) == &_arena);
+
+    TEST_ASSERT_NULL(tlsf_arena_malloc(&_arena, 2 * ARENA_SIZE));
+    tlsf_arena_free(ptr);
+
+    tlsf_arena_get_stats(&_arena, &stats);
+    TEST_ASSERT_EQUAL_INT(before.used, stats.used);
+    TEST_ASSERT_EQUAL_INT(before.frees + 1, stats.frees);
+    TEST_ASSERT_EQUAL_INT(before.failed + 1, stats.failed);
+}
+
+static void test_tlsf_malloc__global_pools(void)
+{
+    tlsf_arena_stats_t before, stats;
+
+    /* make sure the global heap exists, so the pool is added to it */
+    free(malloc(1));
+    tlsf_arena_get_stats(tlsf_arena_global(), &before);
+    TEST_ASSERT_EQUAL_INT(0, tlsf_add_global_pool(_pool_mem, sizeof(_pool_mem)));
+
+    /* the statistics cover all pools of the heap */
+    tlsf_arena_get_stats(tlsf_arena_global(), &stats);
+    TEST_ASSERT(stats.size > before.size + POOL_SIZE / 2);
+    TEST_ASSERT(stats.size <= before.size + POOL_SIZE);
+    TEST_ASSERT(stats.free_max >= before.free_max);
+
+    /* everything outside of other arenas belongs to the global heap */
+    TEST_ASSERT(tlsf_arena_find(_pool_mem) == tlsf_arena_global());
+}
+
+#ifdef MODULE_TLSF_MALLOC_FAST
+static void test_tlsf_malloc__fast(void)
+{
+    tlsf_arena_stats_t before, stats;
+    void *ptrs[CONFIG_TLSF_MALLOC_FAST_DEPTH + 1];
+
+    tlsf_arena_get_stats(&_fast_arena, &before);
+    void *ptr = tlsf_arena_malloc(&_fast_arena, CONFIG_TLSF_MALLOC_FAST_MIN_SIZE - 4);
+    TEST_ASSERT_NOT_NULL(ptr);
+    tlsf_arena_get_stats(&_fast_arena, &stats);
+    size_t block = stats.used - before.used;
+    tlsf_arena_free(ptr);
+
+    /* the block stays cached and serves the next request of its class */
+    tlsf_arena_get_stats(&_fast_arena, &stats);
+    TEST_ASSERT_EQUAL_INT(before.used + block, stats.used);
+    TEST_ASSERT(tlsf_arena_malloc(&_fast_arena,
+                                  CONFIG_TLSF_MALLOC_FAST_MIN_SIZE) == ptr);
+
+    /* it is too small for the next class */
+    tlsf_arena_free(ptr);
+    void *large = tlsf_arena_malloc(&_fast_arena,
+                                    2 * CONFIG_TLSF_MALLOC_FAST_MIN_SIZE);
+    TEST_ASSERT_NOT_NULL(large);
+    TEST_ASSERT(large != ptr);
+    tlsf_arena_free(large);
+    TEST_ASSERT(tlsf_arena_malloc(&_fast_arena,
+                                  CONFIG_TLSF_MALLOC_FAST_MIN_SIZE) == ptr);
+    tlsf_arena_free(ptr);
+
+    /* a full cache returns blocks to TLSF */
+    for (unsigned i = 0; i < ARRAY_SIZE(ptrs); i++) {
+        ptrs[i] = tlsf_arena_malloc(&_fast_arena,
+                                    CONFIG_TLSF_MALLOC_FAST_MIN_SIZE);
+        TEST_ASSERT_NOT_NULL(ptrs[i]);
+    }
+    tlsf_arena_get_stats(&_fast_arena, &before);
+    for (unsigned i = 0; i < ARRAY_SIZE(ptrs); i++) {
+        tlsf_arena_free(ptrs[i]);
+    }
+    tlsf_arena_get_stats(&_fast_arena, &stats);
+    TEST_ASSERT_EQUAL_INT(before.used - block, stats.used);
+    TEST_ASSERT_EQUAL_INT(before.frees + ARRAY_SIZE(ptrs), stats.frees);
+}
+#endif
+
+static void *_bound_thread(void *arg)
+{
+    (void)arg;
+    tlsf_arena_bind_thread(thread_getpid(), &_arena);
+    _thread_ptr = malloc(16);
+    free(_thread_ptr);
+    return NULL;
+}
+
+static void *_unbound_thread(void *arg)
+{
+    (void)arg;
+    _thread_ptr = malloc(16);
+    free(_thread_ptr);
+    return NULL;
+}
+
+static void test_tlsf_malloc__thread_arena(void)
+{
+    /* both threads run to completion right away */
+    kernel_pid_t pid = thread_create(_stack, sizeof(_stack),
+                                     THREAD_PRIORITY_MAIN - 1, 0,
+                                     _bound_thread, NULL, "bound");
+    TEST_ASSERT(pid_is_valid(pid));
+    TEST_ASSERT(tlsf_arena_find(_thread_ptr) == &_arena);
+
+    /* the arena is not passed on to the next thread with that PID */
+    TEST_ASSERT_EQUAL_INT(pid, thread_create(_stack, sizeof(_stack),
+                                             THREAD_PRIORITY_MAIN - 1, 0,
+                                             _unbound_thread, NULL,
+                                             "unbound"));
+    TEST_ASSERT(tlsf_arena_find(_thread_ptr) == tlsf_arena_global());
+
+    /* main is not affected */
+    TEST_ASSERT(tlsf_arena_current() == tlsf_arena_global());
+}
+
+Test *tests_tlsf_malloc(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_tlsf_malloc__arena),
+        new_TestFixture(test_tlsf_malloc__global_pools),
+#ifdef MODULE_TLSF_MALLOC_FAST
+        new_TestFixture(test_tlsf_malloc__fast),
+#endif
+        new_TestFixture(test_tlsf_malloc__thread_arena),
+    };
+
+    EMB_UNIT_TESTCALLER(tlsf_malloc_tests, NULL, NULL, fixtures);
+    return (Test *)&tlsf_malloc_tests;
+}
+
+int main(void)
+{
+    /* arenas are registered once and stay for the lifetime of the program */
+    tlsf_arena_init(&_arena, "test", _arena_mem, sizeof(_arena_mem));
+    tlsf_arena_init(&_fast_arena, "fast", _fast_mem, sizeof(_fast_mem));
+
+    TESTS_START();
+    TESTS_RUN(tests_tlsf_malloc());
+    TESTS_END();
+
+    return 0;
+}
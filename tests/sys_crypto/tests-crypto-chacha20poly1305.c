@@ -76,10 +76,61 @@ static void test_crypto_chacha20poly1305_1(void)
     _test_chacha20poly1305(key_1, nonce_1, msg_1, sizeof(msg_1), aad_1, sizeof(aad_1));
 }
 
+static void test_crypto_chacha20poly1305_iolist(void)
+{
+    const size_t msglen = sizeof(msg_1);
+    uint8_t tag[CHACHA20POLY1305_TAG_BYTES];
+
+    /* split message and aad at odd offsets */
+    memcpy(ebuf, msg_1, msglen);
+    iolist_t data2 = { NULL, &ebuf[70], msglen - 70 };
+    iolist_t data1 = { &data2, &ebuf[7], 63 };
+    iolist_t data0 = { &data1, ebuf, 7 };
+    iolist_t aad1 = { NULL, (void *)&aad_1[5], sizeof(aad_1) - 5 };
+    iolist_t aad0 = { &aad1, (void *)aad_1, 5 };
+
+    chacha20poly1305_encrypt_iolist(&data0, &aad0, tag, key_1, nonce_1);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(ebuf, ciphertext_1, msglen));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(tag, &ciphertext_1[msglen], sizeof(tag)));
+
+    /* a modified tag must not touch the ciphertext */
+    tag[0] ^= 1;
+    TEST_ASSERT_EQUAL_INT(0,
+            chacha20poly1305_decrypt_iolist(&data0, &aad0, tag, key_1, nonce_1));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(ebuf, ciphertext_1, msglen));
+    tag[0] ^= 1;
+
+    TEST_ASSERT_EQUAL_INT(1,
+            chacha20poly1305_decrypt_iolist(&data0, &aad0, tag, key_1, nonce_1));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(ebuf, msg_1, msglen));
+}
+
+static void test_crypto_chacha20poly1305_iolist_long(void)
+{
+    /* longer than several batches of keystream blocks */
+    const size_t msglen = 600;
+    uint8_t tag[CHACHA20POLY1305_TAG_BYTES];
+
+    for (unsigned i = 0; i < msglen; i++) {
+        pbuf[i] = i;
+    }
+    chacha20poly1305_encrypt(ebuf, pbuf, msglen, aad_1, sizeof(aad_1),
+                             key_1, nonce_1);
+
+    iolist_t data1 = { NULL, &pbuf[257], msglen - 257 };
+    iolist_t data0 = { &data1, pbuf, 257 };
+    iolist_t aad = { NULL, (void *)aad_1, sizeof(aad_1) };
+    chacha20poly1305_encrypt_iolist(&data0, &aad, tag, key_1, nonce_1);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(pbuf, ebuf, msglen));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(tag, &ebuf[msglen], sizeof(tag)));
+}
+
 Test *tests_crypto_chacha20poly1305_tests(void)
 {
     EMB_UNIT_TESTFIXTURES(fixtures) {
         new_TestFixture(test_crypto_chacha20poly1305_1),
+        new_TestFixture(test_crypto_chacha20poly1305_iolist),
+        new_TestFixture(test_crypto_chacha20poly1305_iolist_long),
     };
     EMB_UNIT_TESTCALLER(crypto_chacha20poly1305_tests, NULL, NULL, fixtures);
     return (Test *) &crypto_chacha20poly1305_tests;
@@ -60,6 +60,66 @@ static void test_crypto_cipher_aes_decrypt(void)
     TEST_ASSERT_MESSAGE(1 == cmp, "wrong plaintext");
 }
 
+static void test_crypto_cipher_aes_blocks(void)
+{
+    cipher_t cipher;
+    int err, cmp;
+    uint8_t data[3 * 16];
+
+    err = cipher_init(&cipher, CIPHER_AES_128, TEST_KEY, 16);
+    TEST_ASSERT_EQUAL_INT(1, err);
+
+    for (unsigned i = 0; i < 3; i++) {
+        memcpy(&data[i * 16], TEST_INP, 16);
+    }
+
+    /* in place */
+    err = cipher_encrypt_blocks(&cipher, data, data, 3);
+    TEST_ASSERT_EQUAL_INT(1, err);
+    for (unsigned i = 0; i < 3; i++) {
+        cmp = compare(TEST_ENC_AES, &data[i * 16], 16);
+        TEST_ASSERT_MESSAGE(1 == cmp, "wrong ciphertext");
+    }
+
+    err = cipher_decrypt_blocks(&cipher, data, data, 3);
+    TEST_ASSERT_EQUAL_INT(1, err);
+    for (unsigned i = 0; i < 3; i++) {
+        cmp = compare(TEST_INP, &data[i * 16], 16);
+        TEST_ASSERT_MESSAGE(1 == cmp, "wrong plaintext");
+    }
+}
+
+static void test_crypto_cipher_aes_cbc_mac(void)
+{
+    cipher_t cipher;
+    int err, cmp;
+    uint8_t data[3 * 16];
+    uint8_t mac[16] = { 0 };
+    uint8_t expected[16] = { 0 };
+
+    err = cipher_init(&cipher, CIPHER_AES_128, TEST_KEY, 16);
+    TEST_ASSERT_EQUAL_INT(1, err);
+
+    for (unsigned i = 0; i < 3; i++) {
+        memcpy(&data[i * 16], TEST_INP, 16);
+        data[i * 16] ^= i;
+    }
+
+    /* chain the blocks by hand */
+    for (unsigned i = 0; i < 3; i++) {
+        for (unsigned j = 0; j < 16; j++) {
+            expected[j] ^= data[i * 16 + j];
+        }
+        err = cipher_encrypt(&cipher, expected, expected);
+        TEST_ASSERT_EQUAL_INT(1, err);
+    }
+
+    err = cipher_cbc_mac_blocks(&cipher, mac, data, 3);
+    TEST_ASSERT_EQUAL_INT(1, err);
+    cmp = compare(expected, mac, 16);
+    TEST_ASSERT_MESSAGE(1 == cmp, "wrong CBC-MAC");
+}
+
 static void test_crypto_cipher_init_aes_key_length(void)
 {
     cipher_t cipher;
@@ -99,6 +159,8 @@ Test *tests_crypto_cipher_tests(void)
     EMB_UNIT_TESTFIXTURES(fixtures) {
         new_TestFixture(test_crypto_cipher_aes_encrypt),
         new_TestFixture(test_crypto_cipher_aes_decrypt),
+        new_TestFixture(test_crypto_cipher_aes_blocks),
+        new_TestFixture(test_crypto_cipher_aes_cbc_mac),
         new_TestFixture(test_crypto_cipher_init_aes_key_length),
     };
 
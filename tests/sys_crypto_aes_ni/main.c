@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @ingroup     tests
+ * @{
+ *
+ * @file
+ * @brief       Tests AES using the x86 AES instructions
+ *
+ * Uses the vectors of FIPS-197, NIST SP 800-38A, F.1.1 (ECB-AES128) and
+ * RFC 3610, packet vector #2. On a CPU without the instructions, the same
+ * tests check the fallback.
+ *
+ * @}
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "embUnit.h"
+#include "crypto/aes.h"
+#include "crypto/ciphers.h"
+#include "crypto/modes/ccm.h"
+
+#include "aes_ni.h"
+
+#define SP800_38A_BLOCKS    (5U)
+
+static const uint8_t FIPS197_KEY[] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+static const uint8_t FIPS197_PLAIN[] = {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+    0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+};
+static const uint8_t FIPS197_CIPHER[] = {
+    0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+    0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a
+};
+
+static const uint8_t SP800_38A_KEY[] = {
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+    0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+/* the four blocks of F.1.1, followed by the first one again, to cross the
+ * four interleaved blocks */
+static const uint8_t SP800_38A_PLAIN[SP800_38A_BLOCKS * AES_BLOCK_SIZE] = {
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96,
+    0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c,
+    0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+    0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11,
+    0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+    0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17,
+    0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10,
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96,
+    0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+};
+static const uint8_t SP800_38A_CIPHER[SP800_38A_BLOCKS * AES_BLOCK_SIZE] = {
+    0x3a, 0xd7, 0x7b, 0xb4, 0x0d, 0x7a, 0x36, 0x60,
+    0xa8, 0x9e, 0xca, 0xf3, 0x24, 0x66, 0xef, 0x97,
+    0xf5, 0xd3, 0xd5, 0x85, 0x03, 0xb9, 0x69, 0x9d,
+    0xe7, 0x85, 0x89, 0x5a, 0x96, 0xfd, 0xba, 0xaf,
+    0x43, 0xb1, 0xcd, 0x7f, 0x59, 0x8e, 0xce, 0x23,
+    0x88, 0x1b, 0x00, 0xe3, 0xed, 0x03, 0x06, 0x88,
+    0x7b, 0x0c, 0x78, 0x5e, 0x27, 0xe8, 0xad, 0x3f,
+    0x82, 0x23, 0x20, 0x71, 0x04, 0x72, 0x5d, 0xd4,
+    0x3a, 0xd7, 0x7b, 0xb4, 0x0d, 0x7a, 0x36, 0x60,
+    0xa8, 0x9e, 0xca, 0xf3, 0x24, 0x66, 0xef, 0x97,
+};
+
+static const uint8_t RFC3610_KEY[] = {
+    0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7,
+    0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF,
+};
+static const uint8_t RFC3610_NONCE[] = {
+    0x00, 0x00, 0x00, 0x04, 0x03, 0x02, 0x01, 0xA0,
+    0xA1, 0xA2, 0xA3, 0xA4, 0xA5,
+};
+static const uint8_t RFC3610_ADATA[] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+};
+static const uint8_t RFC3610_PLAIN[] = {
+    0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+    0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F,
+};
+static const uint8_t RFC3610_CIPHER[] = {
+    0x72, 0xC9, 0x1A, 0x36, 0xE1, 0x35, 0xF8, 0xCF,
+    0x29, 0x1C, 0xA8, 0x94, 0x08, 0x5C, 0x87, 0xE3,
+    0xCC, 0x15, 0xC4, 0x39, 0xC9, 0xE4, 0x3A, 0x3B,
+    0xA0, 0x91, 0xD5, 0x6E, 0x10, 0x40, 0x09, 0x16,
+};
+#define RFC3610_MAC_LEN     (8U)
+
+static void test_aes_ni__single_block(void)
+{
+    cipher_context_t ctx;
+    uint8_t data[AES_BLOCK_SIZE];
+
+    TEST_ASSERT_EQUAL_INT(CIPHER_INIT_SUCCESS,
+                          aes_init(&ctx, FIPS197_KEY, sizeof(FIPS197_KEY)));
+    TEST_ASSERT_EQUAL_INT(1, aes_encrypt(&ctx, FIPS197_PLAIN, data));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(FIPS197_CIPHER, data, sizeof(data)));
+    TEST_ASSERT_EQUAL_INT(1, aes_decrypt(&ctx, data, data));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(FIPS197_PLAIN, data, sizeof(data)));
+}
+
+static void test_aes_ni__blocks(void)
+{
+    cipher_context_t ctx;
+    uint8_t data[sizeof(SP800_38A_PLAIN)];
+
+    aes_init(&ctx, SP800_38A_KEY, sizeof(SP800_38A_KEY));
+
+    /* less than, exactly and more than the interleaved blocks */
+    for (unsigned n = 1; n <= SP800_38A_BLOCKS; n++) {
+        size_t len = n * AES_BLOCK_SIZE;
+
+        memset(data, 0, sizeof(data));
+        TEST_ASSERT_EQUAL_INT(1, aes_encrypt_blocks(&ctx, SP800_38A_PLAIN,
+                                                    data, n));
+        TEST_ASSERT_EQUAL_INT(0, memcmp(SP800_38A_CIPHER, data, len));
+        /* nothing beyond the last block is written */
+        for (size_t i = len; i < sizeof(data); i++) {
+            TEST_ASSERT_EQUAL_INT(0, data[i]);
+        }
+        /* in place */
+        TEST_ASSERT_EQUAL_INT(1, aes_decrypt_blocks(&ctx, data, data, n));
+        TEST_ASSERT_EQUAL_INT(0, memcmp(SP800_38A_PLAIN, data, len));
+    }
+}
+
+static void test_aes_ni__cbc_mac(void)
+{
+    cipher_context_t ctx;
+    uint8_t mac[AES_BLOCK_SIZE];
+    uint8_t expected[AES_BLOCK_SIZE];
+
+    aes_init(&ctx, SP800_38A_KEY, sizeof(SP800_38A_KEY));
+
+    /* the chaining done by hand, block by block */
+    memset(expected, 0x5a, sizeof(expected));
+    for (unsigned i = 0; i < SP800_38A_BLOCKS; i++) {
+        for (unsigned j = 0; j < AES_BLOCK_SIZE; j++) {
+            expected[j] ^= SP800_38A_PLAIN[i * AES_BLOCK_SIZE + j];
+        }
+        TEST_ASSERT_EQUAL_INT(1, aes_encrypt(&ctx, expected, expected));
+    }
+
+    memset(mac, 0x5a, sizeof(mac));
+    TEST_ASSERT_EQUAL_INT(1, aes_cbc_mac_blocks(&ctx, mac, SP800_38A_PLAIN,
+                                                SP800_38A_BLOCKS));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(expected, mac, sizeof(mac)));
+}
+
+static void test_aes_ni__ccm(void)
+{
+    cipher_t cipher;
+    uint8_t data[sizeof(RFC3610_PLAIN) + RFC3610_MAC_LEN];
+
+    TEST_ASSERT_EQUAL_INT(1, cipher_init(&cipher, CIPHER_AES_128, RFC3610_KEY,
+                                         sizeof(RFC3610_KEY)));
+    TEST_ASSERT_EQUAL_INT(sizeof(RFC3610_CIPHER),
+                          cipher_encrypt_ccm(&cipher, RFC3610_ADATA,
+                                             sizeof(RFC3610_ADATA),
+                                             RFC3610_MAC_LEN, 2,
+                                             RFC3610_NONCE,
+                                             sizeof(RFC3610_NONCE),
+                                             RFC3610_PLAIN,
+                                             sizeof(RFC3610_PLAIN), data));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(RFC3610_CIPHER, data, sizeof(data)));
+
+    TEST_ASSERT_EQUAL_INT(sizeof(RFC3610_PLAIN),
+                          cipher_decrypt_ccm(&cipher, RFC3610_ADATA,
+                                             sizeof(RFC3610_ADATA),
+                                             RFC3610_MAC_LEN, 2,
+                                             RFC3610_NONCE,
+                                             sizeof(RFC3610_NONCE),
+                                             RFC3610_CIPHER,
+                                             sizeof(RFC3610_CIPHER), data));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(RFC3610_PLAIN, data,
+                                    sizeof(RFC3610_PLAIN)));
+}
+
+Test *tests_aes_ni(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_aes_ni__single_block),
+        new_TestFixture(test_aes_ni__blocks),
+        new_TestFixture(test_aes_ni__cbc_mac),
+        new_TestFixture(test_aes_ni__ccm),
+    };
+
+    EMB_UNIT_TESTCALLER(aes_ni_tests, NULL, NULL, fixtures);
+    return (Test *)&aes_ni_tests;
+}
+
+int main(void)
+{
+    printf("AES instructions: %s\n", aes_ni_supported() ? "yes" : "no");
+
+    TESTS_START();
+    TESTS_RUN(tests_aes_ni());
+    TESTS_END();
+
+    return 0;
+}
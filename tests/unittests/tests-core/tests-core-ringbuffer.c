@@ -16,6 +16,8 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
+#include <string.h>
+
 #include "thread.h"
 #include "ringbuffer.h"
 #include "mutex.h"
@@ -152,12 +154,63 @@ static void tests_core_ringbuffer_remove_underflow(void)
     TEST_ASSERT_EQUAL_INT(1, ringbuffer_empty(&buf));
 }
 
+static void tests_core_ringbuffer_add_get_wrap(void)
+{
+    char mem[5];
+    char data[7] = { 1, 2, 3, 4, 5, 6, 7 };
+    char out[7] = { 0 };
+    ringbuffer_t buf;
+    ringbuffer_init(&buf, mem, sizeof(mem));
+
+    TEST_ASSERT_EQUAL_INT(3, ringbuffer_add(&buf, data, 3));
+    TEST_ASSERT_EQUAL_INT(3, ringbuffer_remove(&buf, 3));
+
+    TEST_ASSERT_EQUAL_INT(5, ringbuffer_add(&buf, data, sizeof(data)));
+    TEST_ASSERT_EQUAL_INT(1, ringbuffer_full(&buf));
+    TEST_ASSERT_EQUAL_INT(5, ringbuffer_get(&buf, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(data, out, 5));
+    TEST_ASSERT_EQUAL_INT(0, out[5]);
+}
+
+static void tests_core_ringbuffer_iov(void)
+{
+    char mem[5];
+    struct iovec iov[2];
+    ringbuffer_t buf;
+    ringbuffer_init(&buf, mem, sizeof(mem));
+
+    ringbuffer_add_one(&buf, 0);
+    ringbuffer_add_one(&buf, 1);
+    ringbuffer_add_one(&buf, 2);
+    ringbuffer_remove(&buf, 2);
+
+    TEST_ASSERT_EQUAL_INT(4, ringbuffer_reserve_iov(&buf, iov, 10));
+    TEST_ASSERT(iov[0].iov_base == &mem[3]);
+    TEST_ASSERT_EQUAL_INT(2, iov[0].iov_len);
+    TEST_ASSERT(iov[1].iov_base == mem);
+    TEST_ASSERT_EQUAL_INT(2, iov[1].iov_len);
+    mem[3] = 3;
+    mem[4] = 4;
+    mem[0] = 5;
+    ringbuffer_commit(&buf, 3);
+
+    TEST_ASSERT_EQUAL_INT(4, ringbuffer_peek_iov(&buf, iov, 10));
+    TEST_ASSERT(iov[0].iov_base == &mem[2]);
+    TEST_ASSERT_EQUAL_INT(3, iov[0].iov_len);
+    TEST_ASSERT_EQUAL_INT(1, iov[1].iov_len);
+    TEST_ASSERT_EQUAL_INT(4, ringbuffer_remove(&buf, 4));
+
+    TEST_ASSERT_EQUAL_INT(1, ringbuffer_empty(&buf));
+}
+
 Test *tests_core_ringbuffer_tests(void)
 {
     EMB_UNIT_TESTFIXTURES(fixtures) {
         new_TestFixture(tests_core_ringbuffer),
         new_TestFixture(tests_core_ringbuffer_remove),
         new_TestFixture(tests_core_ringbuffer_remove_underflow),
+        new_TestFixture(tests_core_ringbuffer_add_get_wrap),
+        new_TestFixture(tests_core_ringbuffer_iov),
     };
 
     EMB_UNIT_TESTCALLER(ringbuffer_tests, NULL, NULL, fixtures);
@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @{
+ *
+ * @file
+ */
+#include <stdbool.h>
+#include <string.h>
+
+#include "embUnit/embUnit.h"
+
+#include "coro.h"
+#include "tests-coro.h"
+
+#define TEST_TIMEOUT_US     (1000U)
+#define TEST_ROUNDS         (3U)
+
+typedef struct {
+    coro_t coro;
+    event_t source;     /* stands in for the event of an asynchronous sock */
+} _owner_t;
+
+static coro_t _coro;
+static _owner_t _owner;
+static unsigned _count;
+static unsigned _done;
+
+static void set_up(void)
+{
+    _count = 0;
+    _done = 0;
+}
+
+static void _done_cb(coro_t *coro)
+{
+    TEST_ASSERT(!coro_is_running(coro));
+    _done++;
+}
+
+static coro_state_t _yield(coro_t *coro)
+{
+    CORO_BEGIN(coro);
+    while (_count < TEST_ROUNDS) {
+        _count++;
+        CORO_YIELD(coro);
+    }
+    CORO_END(coro);
+}
+
+static bool _poll(coro_t *coro)
+{
+    _count++;
+    coro_wake(coro);
+    return _count >= TEST_ROUNDS;
+}
+
+static coro_state_t _wait_until(coro_t *coro)
+{
+    CORO_BEGIN(coro);
+    CORO_WAIT_UNTIL(coro, _poll(coro));
+    CORO_END(coro);
+}
+
+static coro_state_t _exit_early(coro_t *coro)
+{
+    CORO_BEGIN(coro);
+    _count++;
+    CORO_EXIT(coro);
+    _count++;
+    CORO_END(coro);
+}
+
+static coro_state_t _timeout(coro_t *coro)
+{
+    CORO_BEGIN(coro);
+    coro_set_timeout(coro, TEST_TIMEOUT_US);
+    CORO_WAIT(coro);
+    if (coro_timed_out(coro)) {
+        _count++;
+    }
+    CORO_END(coro);
+}
+
+static void _source_handler(event_t *event)
+{
+    _owner_t *owner = container_of(event, _owner_t, source);
+
+    coro_wake(&owner->coro);
+}
+
+static coro_state_t _release(coro_t *coro)
+{
+    _owner_t *owner = container_of(coro, _owner_t, coro);
+
+    CORO_BEGIN(coro);
+    event_post(coro->queue, &owner->source);
+    CORO_WAIT(coro);
+    _count++;
+    /* another event of the source and a wakeup race the exit */
+    event_post(coro->queue, &owner->source);
+    coro_wake(coro);
+    event_cancel(coro->queue, &owner->source);
+    CORO_END(coro);
+}
+
+static void _release_cb(coro_t *coro)
+{
+    /* nothing may refer to the owner once it is released */
+    TEST_ASSERT(event_get(coro->queue) == NULL);
+    memset(container_of(coro, _owner_t, coro), 0xff, sizeof(_owner_t));
+    _done++;
+}
+
+static void test_coro_init(void)
+{
+    coro_init(&_coro, _yield, _done_cb);
+    TEST_ASSERT(!coro_is_running(&_coro));
+    TEST_ASSERT(!coro_timed_out(&_coro));
+}
+
+static void test_coro_run_yield(void)
+{
+    coro_init(&_coro, _yield, _done_cb);
+    coro_run(&_coro);
+    TEST_ASSERT(!coro_is_running(&_coro));
+    TEST_ASSERT_EQUAL_INT(TEST_ROUNDS, _count);
+    TEST_ASSERT_EQUAL_INT(1, _done);
+}
+
+static void test_coro_run_wait_until(void)
+{
+    coro_init(&_coro, _wait_until, _done_cb);
+    coro_run(&_coro);
+    TEST_ASSERT_EQUAL_INT(TEST_ROUNDS, _count);
+    TEST_ASSERT_EQUAL_INT(1, _done);
+}
+
+static void test_coro_run_exit(void)
+{
+    coro_init(&_coro, _exit_early, NULL);
+    coro_run(&_coro);
+    TEST_ASSERT(!coro_is_running(&_coro));
+    TEST_ASSERT_EQUAL_INT(1, _count);
+}
+
+static void test_coro_run_timeout(void)
+{
+    coro_init(&_coro, _timeout, _done_cb);
+    coro_run(&_coro);
+    TEST_ASSERT(coro_timed_out(&_coro));
+    TEST_ASSERT_EQUAL_INT(1, _count);
+    TEST_ASSERT_EQUAL_INT(1, _done);
+}
+
+static void test_coro_run_restart(void)
+{
+    coro_init(&_coro, _yield, _done_cb);
+    coro_run(&_coro);
+    _count = 0;
+    coro_run(&_coro);
+    TEST_ASSERT_EQUAL_INT(TEST_ROUNDS, _count);
+    TEST_ASSERT_EQUAL_INT(2, _done);
+}
+
+static void test_coro_release_in_done(void)
+{
+    event_queue_t queue;
+    event_t *event;
+
+    event_queue_init(&queue);
+    _owner.source.list_node.next = NULL;
+    _owner.source.handler = _source_handler;
+    coro_init(&_owner.coro, _release, _release_cb);
+    coro_start(&_owner.coro, &queue);
+    while ((event = event_get(&queue))) {
+        event->handler(event);
+    }
+    TEST_ASSERT_EQUAL_INT(1, _count);
+    TEST_ASSERT_EQUAL_INT(1, _done);
+}
+
+static Test *tests_coro_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_coro_init),
+        new_TestFixture(test_coro_run_yield),
+        new_TestFixture(test_coro_run_wait_until),
+        new_TestFixture(test_coro_run_exit),
+        new_TestFixture(test_coro_run_timeout),
+        new_TestFixture(test_coro_run_restart),
+        new_TestFixture(test_coro_release_in_done),
+    };
+
+    EMB_UNIT_TESTCALLER(coro_tests, set_up, NULL, fixtures);
+
+    return (Test *)&coro_tests;
+}
+
+void tests_coro(void)
+{
+    TESTS_RUN(tests_coro_tests());
+}
+/** @} */
@@ -0,0 +1,273 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @{
+ *
+ * @file
+ * @brief       Tests loading credentials from a persistent store on constfs
+ */
+
+#include <string.h>
+
+#include "embUnit.h"
+#include "fs/constfs.h"
+#include "kernel_defines.h"
+#include "vfs.h"
+
+#include "credentials.h"
+#include "tests-credman.h"
+
+#include "net/credman.h"
+
+#define STORE_DIR   "/credman"
+
+#define TAG_PSK     (1)     /* valid PSK credential */
+#define TAG_ECDSA   (2)     /* valid ECDSA credential */
+#define TAG_VERSION (3)     /* unknown format version */
+#define TAG_SHORT   (4)     /* truncated PSK credential */
+#define TAG_BIG     (5)     /* bigger than CREDMAN_VFS_BUF_SIZE */
+#define TAG_PSK2    (6)
+#define TAG_PSK3    (7)
+
+static const uint8_t _psk[] = { 1, 4, 'k', 'e', 'y', '1', 2, 'i', 'd', 0 };
+static const uint8_t _psk2[] = { 1, 4, 'k', 'e', 'y', '2', 0, 0 };
+static const uint8_t _psk3[] = { 1, 4, 'k', 'e', 'y', '3', 0, 0 };
+static const uint8_t _version[] = { 2, 4, 'k', 'e', 'y', '1', 0, 0 };
+static const uint8_t _short[] = { 1, 4, 'k', 'e', 'y' };
+static const uint8_t _big[CREDMAN_VFS_BUF_SIZE + 1] = { 1, 4, 'k', 'e', 'y' };
+/* version, number of client keys, private key and public key */
+static uint8_t _ecdsa[2 + 3 * CREDMAN_VFS_ECDSA_KEY_SIZE];
+
+static const constfs_file_t _files[] = {
+    { .path = "/p0001", .data = _psk, .size = sizeof(_psk) },
+    { .path = "/e0002", .data = _ecdsa, .size = sizeof(_ecdsa) },
+    { .path = "/p0003", .data = _version, .size = sizeof(_version) },
+    { .path = "/p0004", .data = _short, .size = sizeof(_short) },
+    { .path = "/p0005", .data = _big, .size = sizeof(_big) },
+    { .path = "/p0006", .data = _psk2, .size = sizeof(_psk2) },
+    { .path = "/p0007", .data = _psk3, .size = sizeof(_psk3) },
+};
+
+static const constfs_t _fs_data = {
+    .files = _files,
+    .nfiles = ARRAY_SIZE(_files),
+};
+
+static vfs_mount_t _mount = {
+    .mount_point = STORE_DIR,
+    .fs = &constfs_file_system,
+    .private_data = (void *)&_fs_data,
+};
+
+static const credman_credential_t _added = {
+    .tag = TAG_PSK3 + 1,
+    .type = CREDMAN_TYPE_PSK,
+    .params = {
+        .psk = {
+            .key = { .s = "added", .len = sizeof("added") - 1 },
+        },
+    },
+};
+
+static void set_up(void)
+{
+    _ecdsa[0] = 1;
+    _ecdsa[1] = 0;
+    memcpy(&_ecdsa[2], ecdsa_priv_key, CREDMAN_VFS_ECDSA_KEY_SIZE);
+    memcpy(&_ecdsa[2 + CREDMAN_VFS_ECDSA_KEY_SIZE], ecdsa_pub_key_x,
+           CREDMAN_VFS_ECDSA_KEY_SIZE);
+    memcpy(&_ecdsa[2 + 2 * CREDMAN_VFS_ECDSA_KEY_SIZE], ecdsa_pub_key_y,
+           CREDMAN_VFS_ECDSA_KEY_SIZE);
+
+    credman_reset();
+    vfs_mount(&_mount);
+    credman_vfs_init(STORE_DIR);
+}
+
+static void tear_down(void)
+{
+    credman_vfs_init(NULL);
+    vfs_umount(&_mount);
+}
+
+static void _assert_psk(credman_tag_t tag, const char *key)
+{
+    credman_credential_t c;
+
+    TEST_ASSERT_EQUAL_INT(CREDMAN_OK, credman_get(&c, tag, CREDMAN_TYPE_PSK));
+    TEST_ASSERT_EQUAL_INT(tag, c.tag);
+    TEST_ASSERT_EQUAL_INT(strlen(key), c.params.psk.key.len);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(key, c.params.psk.key.s, strlen(key)));
+}
+
+static void test_credman_vfs_load(void)
+{
+    credman_credential_t c;
+
+    _assert_psk(TAG_PSK, "key1");
+    TEST_ASSERT_EQUAL_INT(1, credman_get_used_count());
+    TEST_ASSERT_EQUAL_INT(CREDMAN_OK,
+                          credman_get(&c, TAG_PSK, CREDMAN_TYPE_PSK));
+    TEST_ASSERT_EQUAL_INT(2, c.params.psk.id.len);
+    TEST_ASSERT_EQUAL_INT(0, memcmp("id", c.params.psk.id.s, 2));
+    TEST_ASSERT_EQUAL_INT(0, c.params.psk.hint.len);
+    /* a loaded credential is found in the pool */
+    TEST_ASSERT_EQUAL_INT(1, credman_get_used_count());
+
+    TEST_ASSERT_EQUAL_INT(CREDMAN_OK,
+                          credman_get(&c, TAG_ECDSA, CREDMAN_TYPE_ECDSA));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(ecdsa_priv_key, c.params.ecdsa.private_key,
+                                    CREDMAN_VFS_ECDSA_KEY_SIZE));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(ecdsa_pub_key_y,
+                                    c.params.ecdsa.public_key.y,
+                                    CREDMAN_VFS_ECDSA_KEY_SIZE));
+    TEST_ASSERT_EQUAL_INT(0, c.params.ecdsa.client_keys_size);
+    TEST_ASSERT_EQUAL_INT(2, credman_get_used_count());
+
+    TEST_ASSERT_EQUAL_INT(CREDMAN_NOT_FOUND,
+                          credman_get(&c, TAG_PSK, CREDMAN_TYPE_ECDSA));
+
+    /* deleting a loaded credential frees its cache entry */
+    credman_delete(TAG_PSK, CREDMAN_TYPE_PSK);
+    TEST_ASSERT_EQUAL_INT(1, credman_get_used_count());
+    _assert_psk(TAG_PSK2, "key2");
+    TEST_ASSERT_EQUAL_INT(2, credman_get_used_count());
+}
+
+static void test_credman_vfs_invalid(void)
+{
+    credman_credential_t c;
+
+    /* fill the cache */
+    _assert_psk(TAG_PSK, "key1");
+    _assert_psk(TAG_PSK2, "key2");
+
+    /* an invalid stored credential does not evict a loaded one */
+    TEST_ASSERT_EQUAL_INT(CREDMAN_ERROR,
+                          credman_get(&c, TAG_VERSION, CREDMAN_TYPE_PSK));
+    TEST_ASSERT_EQUAL_INT(CREDMAN_ERROR,
+                          credman_get(&c, TAG_SHORT, CREDMAN_TYPE_PSK));
+    TEST_ASSERT_EQUAL_INT(CREDMAN_ERROR,
+                          credman_get(&c, TAG_BIG, CREDMAN_TYPE_PSK));
+    /* neither does a missing one */
+    TEST_ASSERT_EQUAL_INT(CREDMAN_NOT_FOUND,
+                          credman_get(&c, TAG_ECDSA, CREDMAN_TYPE_PSK));
+    TEST_ASSERT_EQUAL_INT(2, credman_get_used_count());
+    _assert_psk(TAG_PSK, "key1");
+    _assert_psk(TAG_PSK2, "key2");
+}
+
+static void test_credman_vfs_evict(void)
+{
+    credman_credential_t c;
+
+    _assert_psk(TAG_PSK, "key1");
+    _assert_psk(TAG_PSK2, "key2");
+
+    /* the oldest load makes room, the other one stays valid */
+    TEST_ASSERT_EQUAL_INT(CREDMAN_OK,
+                          credman_get(&c, TAG_PSK2, CREDMAN_TYPE_PSK));
+    _assert_psk(TAG_PSK3, "key3");
+    TEST_ASSERT_EQUAL_INT(2, credman_get_used_count());
+    TEST_ASSERT_EQUAL_INT(0, memcmp("key2", c.params.psk.key.s, 4));
+    credman_delete(TAG_PSK2, CREDMAN_TYPE_PSK);
+    credman_delete(TAG_PSK3, CREDMAN_TYPE_PSK);
+    TEST_ASSERT_EQUAL_INT(0, credman_get_used_count());
+}
+
+static void test_credman_vfs_pool_full(void)
+{
+    credman_credential_t c = _added;
+
+    /* nothing loaded to evict */
+    TEST_ASSERT_EQUAL_INT(CREDMAN_OK, credman_add(&c));
+    c.tag++;
+    TEST_ASSERT_EQUAL_INT(CREDMAN_OK, credman_add(&c));
+    TEST_ASSERT_EQUAL_INT(CREDMAN_NO_SPACE,
+                          credman_get(&c, TAG_PSK, CREDMAN_TYPE_PSK));
+    TEST_ASSERT_EQUAL_INT(CREDMAN_MAX_CREDENTIALS, credman_get_used_count());
+
+    /* with a free cache entry, a loaded credential still makes room */
+    credman_delete(_added.tag, _added.type);
+    _assert_psk(TAG_PSK, "key1");
+    _assert_psk(TAG_PSK2, "key2");
+    TEST_ASSERT_EQUAL_INT(CREDMAN_MAX_CREDENTIALS, credman_get_used_count());
+    credman_delete(_added.tag + 1, _added.type);
+    TEST_ASSERT_EQUAL_INT(1, credman_get_used_count());
+    TEST_ASSERT_EQUAL_INT(CREDMAN_OK,
+                          credman_get(&c, TAG_PSK2, CREDMAN_TYPE_PSK));
+    TEST_ASSERT_EQUAL_INT(1, credman_get_used_count());
+}
+
+static void test_credman_vfs_read_only(void)
+{
+    credman_credential_t c;
+
+    /* constfs can not be written */
+    TEST_ASSERT_EQUAL_INT(CREDMAN_OK, credman_add(&_added));
+    TEST_ASSERT_EQUAL_INT(CREDMAN_ERROR,
+                          credman_vfs_save(_added.tag, _added.type));
+    TEST_ASSERT_EQUAL_INT(CREDMAN_NOT_FOUND,
+                          credman_vfs_save(TAG_PSK, CREDMAN_TYPE_PSK));
+    TEST_ASSERT_EQUAL_INT(CREDMAN_ERROR,
+                          credman_vfs_remove(TAG_PSK, CREDMAN_TYPE_PSK));
+
+    /* without a store, nothing is loaded */
+    credman_vfs_init(NULL);
+    TEST_ASSERT_EQUAL_INT(CREDMAN_NOT_FOUND,
+                          credman_get(&c, TAG_PSK, CREDMAN_TYPE_PSK));
+    TEST_ASSERT_EQUAL_INT(1, credman_get_used_count());
+}
+
+static void test_credman_vfs_psk_identity(void)
+{
+    credman_credential_t c = _added;
+
+    /* the stored credential only matches its own identity */
+    TEST_ASSERT_EQUAL_INT(CREDMAN_NOT_FOUND,
+                          credman_get_psk(&c, TAG_PSK, "other", 5));
+    TEST_ASSERT_EQUAL_INT(CREDMAN_OK, credman_get_psk(&c, TAG_PSK, "id", 2));
+    TEST_ASSERT_EQUAL_INT(0, memcmp("key1", c.params.psk.key.s, 4));
+    TEST_ASSERT_EQUAL_INT(1, credman_get_used_count());
+
+    /* another identity of the same tag next to the loaded one */
+    c = _added;
+    c.tag = TAG_PSK;
+    c.params.psk.id.s = "other";
+    c.params.psk.id.len = 5;
+    TEST_ASSERT_EQUAL_INT(CREDMAN_OK, credman_add(&c));
+    TEST_ASSERT_EQUAL_INT(CREDMAN_OK, credman_get_psk(&c, TAG_PSK, "id", 2));
+    TEST_ASSERT_EQUAL_INT(0, memcmp("key1", c.params.psk.key.s, 4));
+
+    /* evicting the loaded credential keeps the added one */
+    _assert_psk(TAG_PSK2, "key2");
+    TEST_ASSERT_EQUAL_INT(2, credman_get_used_count());
+    TEST_ASSERT_EQUAL_INT(CREDMAN_OK,
+                          credman_get_psk(&c, TAG_PSK, "other", 5));
+    TEST_ASSERT_EQUAL_INT(0, memcmp("added", c.params.psk.key.s, 5));
+    TEST_ASSERT_EQUAL_INT(CREDMAN_NOT_FOUND,
+                          credman_get_psk(&c, TAG_PSK, "id", 2));
+}
+
+Test *tests_credman_vfs_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_credman_vfs_load),
+        new_TestFixture(test_credman_vfs_invalid),
+        new_TestFixture(test_credman_vfs_evict),
+        new_TestFixture(test_credman_vfs_pool_full),
+        new_TestFixture(test_credman_vfs_read_only),
+        new_TestFixture(test_credman_vfs_psk_identity),
+    };
+
+    EMB_UNIT_TESTCALLER(credman_vfs_tests, set_up, tear_down, fixtures);
+
+    return (Test *)&credman_vfs_tests;
+}
+/** @} */
@@ -228,6 +228,148 @@ static void test_credman_add_delete_all(void)
     TEST_ASSERT_EQUAL_INT(2, credman_get_used_count());
 }
 
+static void test_credman_get_after_delete_cycles(void)
+{
+    credman_credential_t out_credential;
+    credman_credential_t in_credential = {
+        .type = CREDMAN_TYPE_ECDSA,
+        .params = {
+            .ecdsa = {
+                .private_key = ecdsa_priv_key,
+                .public_key = { .x = ecdsa_pub_key_x, .y = ecdsa_pub_key_y },
+                .client_keys = NULL,
+                .client_keys_size = 0,
+            },
+        },
+    };
+
+    /* add and delete in alternating order, so that colliding hash index
+     * entries get shifted and the pool is compacted both ways */
+    for (credman_tag_t tag = 1; tag < 512; tag++) {
+        in_credential.tag = tag;
+        TEST_ASSERT_EQUAL_INT(CREDMAN_OK, credman_add(&in_credential));
+        if (tag > 1) {
+            TEST_ASSERT_EQUAL_INT(CREDMAN_OK,
+                                  credman_get(&out_credential, tag - 1,
+                                              in_credential.type));
+            TEST_ASSERT_EQUAL_INT(tag - 1, out_credential.tag);
+            /* same tag, but other type */
+            TEST_ASSERT_EQUAL_INT(CREDMAN_NOT_FOUND,
+                                  credman_get(&out_credential, tag - 1,
+                                              CREDMAN_TYPE_PSK));
+            credman_delete((tag & 1) ? tag - 1 : tag, in_credential.type);
+            TEST_ASSERT_EQUAL_INT(1, credman_get_used_count());
+            credman_delete((tag & 1) ? tag : tag - 1, in_credential.type);
+            TEST_ASSERT_EQUAL_INT(0, credman_get_used_count());
+            TEST_ASSERT_EQUAL_INT(CREDMAN_OK, credman_add(&in_credential));
+        }
+        TEST_ASSERT_EQUAL_INT(CREDMAN_OK,
+                              credman_get(&out_credential, tag,
+                                          in_credential.type));
+        TEST_ASSERT(!_compare_credentials(&in_credential, &out_credential));
+    }
+}
+
+static void test_credman_get_psk(void)
+{
+    credman_credential_t out_credential;
+    credman_credential_t in_credential = {
+        .tag = CREDMAN_TEST_TAG,
+        .type = CREDMAN_TYPE_PSK,
+        .params = {
+            .psk = {
+                .id = { .s = (void *)"Client_A", .len = sizeof("Client_A") - 1 },
+                .key = { .s = (void *)"secretA", .len = sizeof("secretA") - 1 },
+            },
+        },
+    };
+
+    /* a server accepting two clients with one tag */
+    TEST_ASSERT_EQUAL_INT(CREDMAN_OK, credman_add(&in_credential));
+    in_credential.params.psk.id.s = "Client_B";
+    in_credential.params.psk.key.s = "secretB";
+    TEST_ASSERT_EQUAL_INT(CREDMAN_OK, credman_add(&in_credential));
+    TEST_ASSERT_EQUAL_INT(2, credman_get_used_count());
+    TEST_ASSERT_EQUAL_INT(CREDMAN_EXIST, credman_add(&in_credential));
+
+    TEST_ASSERT_EQUAL_INT(CREDMAN_OK,
+                          credman_get_psk(&out_credential, CREDMAN_TEST_TAG,
+                                          "Client_A", 8));
+    TEST_ASSERT_EQUAL_INT(0, memcmp("secretA", out_credential.params.psk.key.s,
+                                    out_credential.params.psk.key.len));
+    TEST_ASSERT_EQUAL_INT(CREDMAN_OK,
+                          credman_get_psk(&out_credential, CREDMAN_TEST_TAG,
+                                          "Client_B", 8));
+    TEST_ASSERT_EQUAL_INT(0, memcmp("secretB", out_credential.params.psk.key.s,
+                                    out_credential.params.psk.key.len));
+    /* unknown identity, prefix of a known one and other tag */
+    TEST_ASSERT_EQUAL_INT(CREDMAN_NOT_FOUND,
+                          credman_get_psk(&out_credential, CREDMAN_TEST_TAG,
+                                          "Client_C", 8));
+    TEST_ASSERT_EQUAL_INT(CREDMAN_NOT_FOUND,
+                          credman_get_psk(&out_credential, CREDMAN_TEST_TAG,
+                                          "Client", 6));
+    TEST_ASSERT_EQUAL_INT(CREDMAN_NOT_FOUND,
+                          credman_get_psk(&out_credential,
+                                          CREDMAN_TEST_TAG + 1,
+                                          "Client_A", 8));
+    /* any of them without an identity */
+    TEST_ASSERT_EQUAL_INT(CREDMAN_OK,
+                          credman_get(&out_credential, CREDMAN_TEST_TAG,
+                                      CREDMAN_TYPE_PSK));
+
+    credman_delete(CREDMAN_TEST_TAG, CREDMAN_TYPE_PSK);
+    TEST_ASSERT_EQUAL_INT(0, credman_get_used_count());
+    TEST_ASSERT_EQUAL_INT(CREDMAN_NOT_FOUND,
+                          credman_get_psk(&out_credential, CREDMAN_TEST_TAG,
+                                          "Client_B", 8));
+}
+
+static void test_credman_get_psk_after_compaction(void)
+{
+    credman_credential_t out_credential;
+    credman_credential_t ecdsa_credential = {
+        .tag = CREDMAN_TEST_TAG,
+        .type = CREDMAN_TYPE_ECDSA,
+        .params = {
+            .ecdsa = {
+                .private_key = ecdsa_priv_key,
+                .public_key = { .x = ecdsa_pub_key_x, .y = ecdsa_pub_key_y },
+            },
+        },
+    };
+    credman_credential_t psk_credential = {
+        .tag = CREDMAN_TEST_TAG,
+        .type = CREDMAN_TYPE_PSK,
+        .params = {
+            .psk = {
+                .id = { .s = (void *)"Client_A", .len = sizeof("Client_A") - 1 },
+                .key = { .s = (void *)"secretA", .len = sizeof("secretA") - 1 },
+            },
+        },
+    };
+
+    /* the first PSK credential moves into the gap of the deleted one, the
+     * second shares its probe sequence */
+    TEST_ASSERT_EQUAL_INT(CREDMAN_OK, credman_add(&ecdsa_credential));
+    TEST_ASSERT_EQUAL_INT(CREDMAN_OK, credman_add(&psk_credential));
+    credman_delete(CREDMAN_TEST_TAG, CREDMAN_TYPE_ECDSA);
+    psk_credential.params.psk.id.s = "Client_B";
+    psk_credential.params.psk.key.s = "secretB";
+    TEST_ASSERT_EQUAL_INT(CREDMAN_OK, credman_add(&psk_credential));
+
+    TEST_ASSERT_EQUAL_INT(CREDMAN_OK,
+                          credman_get_psk(&out_credential, CREDMAN_TEST_TAG,
+                                          "Client_A", 8));
+    TEST_ASSERT_EQUAL_INT(0, memcmp("secretA", out_credential.params.psk.key.s,
+                                    out_credential.params.psk.key.len));
+    TEST_ASSERT_EQUAL_INT(CREDMAN_OK,
+                          credman_get_psk(&out_credential, CREDMAN_TEST_TAG,
+                                          "Client_B", 8));
+    TEST_ASSERT_EQUAL_INT(0, memcmp("secretB", out_credential.params.psk.key.s,
+                                    out_credential.params.psk.key.len));
+}
+
 Test *tests_credman_tests(void)
 {
     EMB_UNIT_TESTFIXTURES(fixtures) {
@@ -236,6 +378,9 @@ Test *tests_credman_tests(void)
         new_TestFixture(test_credman_delete),
         new_TestFixture(test_credman_delete_random_order),
         new_TestFixture(test_credman_add_delete_all),
+        new_TestFixture(test_credman_get_after_delete_cycles),
+        new_TestFixture(test_credman_get_psk),
+        new_TestFixture(test_credman_get_psk_after_compaction),
     };
 
     EMB_UNIT_TESTCALLER(credman_tests,
@@ -248,4 +393,5 @@ Test *tests_credman_tests(void)
 void tests_credman(void)
 {
     TESTS_RUN(tests_credman_tests());
+    TESTS_RUN(tests_credman_vfs_tests());
 }
@@ -36,6 +36,13 @@ void tests_credman(void);
  */
 Test *tests_credman_tests(void);
 
+/**
+ * @brief   Generates tests for the persistent store of credman
+ *
+ * @return  embUnit tests if successful, NULL if not.
+ */
+Test *tests_credman_vfs_tests(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @{
+ *
+ * @file
+ * @brief       Tests matching responses to open requests, and the
+ *              retransmission timeouts of CoCoA
+ *
+ * Requests are sent to UDP socks of the test, which act as servers on the
+ * loopback address.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "embUnit.h"
+#include "mutex.h"
+#include "net/gcoap.h"
+#include "net/ipv6/addr.h"
+#include "net/sock/udp.h"
+#include "xtimer.h"
+
+#include "gcoap_internal.h"
+#include "tests-gcoap.h"
+
+#define SERVERS_NUMOF       (2U)
+#define SERVER_PORT         (5700U)
+#define RECV_TIMEOUT        (1000000U)
+/* time to wait for a response which must not be matched */
+#define NO_RESP_TIMEOUT     (100000U)
+
+static sock_udp_t _servers[SERVERS_NUMOF];
+static sock_udp_ep_t _gcoap_ep;
+static int _ctx[2];
+
+static mutex_t _resp_lock = MUTEX_INIT_LOCKED;
+static unsigned _resp_state;
+static void *_resp_ctx;
+static char _resp_payload;
+
+static void _resp_handler(const gcoap_request_memo_t *memo, coap_pkt_t *pdu,
+                          const sock_udp_ep_t *remote)
+{
+    (void)remote;
+    _resp_state = memo->state;
+    _resp_ctx = memo->context;
+    _resp_payload = (pdu->payload_len) ? pdu->payload[0] : 0;
+    mutex_unlock(&_resp_lock);
+}
+
+static void _loopback(sock_udp_ep_t *ep, uint16_t port)
+{
+    memset(ep, 0, sizeof(*ep));
+    ep->family = AF_INET6;
+    ep->netif = SOCK_ADDR_ANY_NETIF;
+    memcpy(ep->addr.ipv6, &ipv6_addr_loopback, sizeof(ep->addr.ipv6));
+    ep->port = port;
+}
+
+/* Sends a request with a one byte token, which is also its message ID */
+static size_t _send_req(unsigned server, unsigned type, uint8_t token,
+                        void *ctx)
+{
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+    sock_udp_ep_t remote;
+    coap_pkt_t pdu;
+
+    ssize_t len = coap_build_hdr((coap_hdr_t *)buf, type, &token, 1,
+                                 COAP_METHOD_GET, token);
+    coap_pkt_init(&pdu, buf, sizeof(buf), len);
+    coap_opt_add_uri_path(&pdu, "/memo");
+    len = coap_opt_finish(&pdu, COAP_OPT_FINISH_NONE);
+
+    _loopback(&remote, SERVER_PORT + server);
+    return gcoap_req_send(buf, len, &remote, _resp_handler, ctx);
+}
+
+static void _recv_req(unsigned server, uint8_t token)
+{
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+    coap_pkt_t pdu;
+    ssize_t res = sock_udp_recv(&_servers[server], buf, sizeof(buf),
+                                RECV_TIMEOUT, NULL);
+
+    TEST_ASSERT(res > 0);
+    TEST_ASSERT_EQUAL_INT(0, coap_parse(&pdu, buf, res));
+    TEST_ASSERT_EQUAL_INT(1, coap_get_token_len(&pdu));
+    TEST_ASSERT_EQUAL_INT(token, pdu.token[0]);
+}
+
+static void _respond(unsigned server, unsigned type, uint8_t token,
+                     char payload)
+{
+    uint8_t buf[CONFIG_GCOAP_PDU_BUF_SIZE];
+    coap_pkt_t pdu;
+
+    ssize_t len = coap_build_hdr((coap_hdr_t *)buf, type, &token, 1,
+                                 COAP_CODE_CONTENT, token);
+    coap_pkt_init(&pdu, buf, sizeof(buf), len);
+    len = coap_opt_finish(&pdu, COAP_OPT_FINISH_PAYLOAD);
+    pdu.payload[0] = payload;
+    len++;
+    TEST_ASSERT_EQUAL_INT(len, sock_udp_send(&_servers[server], buf, len,
+                                             &_gcoap_ep));
+}
+
+static void _assert_resp(void *ctx, char payload)
+{
+    TEST_ASSERT_EQUAL_INT(0, xtimer_mutex_lock_timeout(&_resp_lock,
+                                                       RECV_TIMEOUT));
+    TEST_ASSERT_EQUAL_INT(GCOAP_MEMO_RESP, _resp_state);
+    TEST_ASSERT(_resp_ctx == ctx);
+    TEST_ASSERT_EQUAL_INT(payload, _resp_payload);
+}
+
+static void _assert_no_resp(void)
+{
+    TEST_ASSERT_EQUAL_INT(-1, xtimer_mutex_lock_timeout(&_resp_lock,
+                                                        NO_RESP_TIMEOUT));
+}
+
+static void set_up(void)
+{
+    _loopback(&_gcoap_ep, CONFIG_GCOAP_PORT);
+    for (unsigned i = 0; i < SERVERS_NUMOF; i++) {
+        sock_udp_ep_t local;
+
+        _loopback(&local, SERVER_PORT + i);
+        sock_udp_create(&_servers[i], &local, NULL, 0);
+    }
+}
+
+static void tear_down(void)
+{
+    for (unsigned i = 0; i < SERVERS_NUMOF; i++) {
+        sock_udp_close(&_servers[i]);
+    }
+}
+
+static void test_gcoap_memo__lookup(void)
+{
+    TEST_ASSERT(_send_req(0, COAP_TYPE_NON, 0x11, &_ctx[0]) > 0);
+    TEST_ASSERT(_send_req(0, COAP_TYPE_NON, 0x22, &_ctx[1]) > 0);
+    _recv_req(0, 0x11);
+    _recv_req(0, 0x22);
+
+    /* neither an unknown token, nor a known token from another server match */
+    _respond(0, COAP_TYPE_NON, 0x44, 'x');
+    _assert_no_resp();
+    _respond(1, COAP_TYPE_NON, 0x11, 'x');
+    _assert_no_resp();
+
+    /* responses are matched in any order */
+    _respond(0, COAP_TYPE_NON, 0x22, 'b');
+    _assert_resp(&_ctx[1], 'b');
+    _respond(0, COAP_TYPE_NON, 0x11, 'a');
+    _assert_resp(&_ctx[0], 'a');
+
+    /* a request is released with its response */
+    _respond(0, COAP_TYPE_NON, 0x11, 'a');
+    _assert_no_resp();
+
+    /* the same token is used for different servers */
+    TEST_ASSERT(_send_req(0, COAP_TYPE_NON, 0x55, &_ctx[0]) > 0);
+    TEST_ASSERT(_send_req(1, COAP_TYPE_NON, 0x55, &_ctx[1]) > 0);
+    _recv_req(0, 0x55);
+    _recv_req(1, 0x55);
+    _respond(1, COAP_TYPE_NON, 0x55, 'd');
+    _assert_resp(&_ctx[1], 'd');
+    _respond(0, COAP_TYPE_NON, 0x55, 'c');
+    _assert_resp(&_ctx[0], 'c');
+}
+
+static void test_gcoap_memo__pools(void)
+{
+    sock_udp_ep_t remote;
+
+    _loopback(&remote, SERVER_PORT);
+
+    /* all request memos are in use */
+    TEST_ASSERT(_send_req(0, COAP_TYPE_NON, 0x11, &_ctx[0]) > 0);
+    TEST_ASSERT(_send_req(0, COAP_TYPE_NON, 0x22, &_ctx[1]) > 0);
+    TEST_ASSERT_EQUAL_INT(0, _send_req(1, COAP_TYPE_NON, 0x33, NULL));
+    _recv_req(0, 0x11);
+    _recv_req(0, 0x22);
+    _respond(0, COAP_TYPE_NON, 0x11, 'a');
+    _assert_resp(&_ctx[0], 'a');
+    _respond(0, COAP_TYPE_NON, 0x22, 'b');
+    _assert_resp(&_ctx[1], 'b');
+
+    /* the only resend buffer is taken by the first confirmable request */
+    TEST_ASSERT(_send_req(0, COAP_TYPE_CON, 0x66, &_ctx[0]) > 0);
+    TEST_ASSERT_EQUAL_INT(0, _send_req(1, COAP_TYPE_CON, 0x77, NULL));
+    /* the failed request did not keep its memo */
+    TEST_ASSERT(_send_req(1, COAP_TYPE_NON, 0x77, &_ctx[1]) > 0);
+    _recv_req(0, 0x66);
+    _recv_req(1, 0x77);
+    _respond(0, COAP_TYPE_ACK, 0x66, 'e');
+    _assert_resp(&_ctx[0], 'e');
+    _respond(1, COAP_TYPE_NON, 0x77, 'f');
+    _assert_resp(&_ctx[1], 'f');
+#ifdef MODULE_GCOAP_COCOA
+    /* the response fed the strong estimator */
+    TEST_ASSERT(gcoap_cocoa_rto(&remote, xtimer_now_usec())
+                < CONFIG_COAP_ACK_TIMEOUT * US_PER_SEC);
+#endif
+
+    /* the resend buffer is released with the response */
+    TEST_ASSERT(_send_req(1, COAP_TYPE_CON, 0x88, &_ctx[0]) > 0);
+    _recv_req(1, 0x88);
+    _respond(1, COAP_TYPE_ACK, 0x88, 'g');
+    _assert_resp(&_ctx[0], 'g');
+}
+
+#ifdef MODULE_GCOAP_COCOA
+/* peers without a sock, so no request of gcoap updates them */
+#define COCOA_PORT          (5790U)
+#define RTO_INIT            (CONFIG_COAP_ACK_TIMEOUT * US_PER_SEC)
+
+static void test_gcoap_memo__cocoa_rto(void)
+{
+    const uint32_t start = 1000;
+    sock_udp_ep_t remote;
+
+    _loopback(&remote, COCOA_PORT);
+    TEST_ASSERT_EQUAL_INT(RTO_INIT, gcoap_cocoa_rto(&remote, start));
+
+    /* strong estimator: RTO = SRTT + 4 * RTTVAR, averaged with the last */
+    gcoap_cocoa_update(&remote, 100000, 0, start);
+    TEST_ASSERT_EQUAL_INT((300000 + RTO_INIT) / 2,
+                          gcoap_cocoa_rto(&remote, start));
+    gcoap_cocoa_update(&remote, 100000, 0, start);
+    TEST_ASSERT_EQUAL_INT(700000, gcoap_cocoa_rto(&remote, start));
+
+    /* weak estimator: RTO = SRTT + RTTVAR, weighted 1:3 with the last */
+    gcoap_cocoa_update(&remote, 1000000, 1, start);
+    TEST_ASSERT_EQUAL_INT(900000, gcoap_cocoa_rto(&remote, start));
+    /* too many retransmissions */
+    gcoap_cocoa_update(&remote, 10000, 3, start);
+    TEST_ASSERT_EQUAL_INT(900000, gcoap_cocoa_rto(&remote, start));
+
+    /* a small RTO doubles after 16 * RTO without update */
+    TEST_ASSERT_EQUAL_INT(900000,
+                          gcoap_cocoa_rto(&remote, start + 16 * 900000));
+    TEST_ASSERT_EQUAL_INT(1800000,
+                          gcoap_cocoa_rto(&remote, start + 16 * 900000 + 1));
+    TEST_ASSERT_EQUAL_INT(1800000,
+                          gcoap_cocoa_rto(&remote, start + 16 * 900000 + 2));
+
+    /* a large RTO approaches the initial RTO after 4 * RTO */
+    _loopback(&remote, COCOA_PORT + 1);
+    gcoap_cocoa_update(&remote, 20000000, 2, start);
+    TEST_ASSERT_EQUAL_INT(9000000, gcoap_cocoa_rto(&remote, start));
+    TEST_ASSERT_EQUAL_INT((RTO_INIT + 9000000) / 2,
+                          gcoap_cocoa_rto(&remote, start + 4 * 9000000 + 1));
+
+    /* the RTO is limited */
+    gcoap_cocoa_update(&remote, 1000000000, 1, start);
+    TEST_ASSERT_EQUAL_INT(32 * US_PER_SEC, gcoap_cocoa_rto(&remote, start));
+}
+
+static void test_gcoap_memo__cocoa_backoff(void)
+{
+    /* factor 3 below 1 s, 1.5 above 3 s, 2 otherwise */
+    TEST_ASSERT_EQUAL_INT(1500000, gcoap_cocoa_backoff(500000));
+    TEST_ASSERT_EQUAL_INT(2000000, gcoap_cocoa_backoff(1000000));
+    TEST_ASSERT_EQUAL_INT(6000000, gcoap_cocoa_backoff(3000000));
+    TEST_ASSERT_EQUAL_INT(6000000, gcoap_cocoa_backoff(4000000));
+}
+#endif
+
+Test *tests_gcoap_memo_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_gcoap_memo__lookup),
+        new_TestFixture(test_gcoap_memo__pools),
+#ifdef MODULE_GCOAP_COCOA
+        new_TestFixture(test_gcoap_memo__cocoa_rto),
+        new_TestFixture(test_gcoap_memo__cocoa_backoff),
+#endif
+    };
+
+    EMB_UNIT_TESTCALLER(gcoap_memo_tests, set_up, tear_down, fixtures);
+
+    return (Test *)&gcoap_memo_tests;
+}
+/** @} */
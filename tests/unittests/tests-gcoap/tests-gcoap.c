@@ -409,5 +409,6 @@ Test *tests_gcoap_tests(void)
 void tests_gcoap(void)
 {
     TESTS_RUN(tests_gcoap_tests());
+    TESTS_RUN(tests_gcoap_memo_tests());
 }
 /** @} */
@@ -32,6 +32,14 @@ extern "C" {
  */
 void tests_gcoap(void);
 
+/**
+ * @brief   Generates tests for matching responses to open requests, and for
+ *          the retransmission timeouts of CoCoA
+ *
+ * @return  embUnit tests if successful, NULL if not.
+ */
+Test *tests_gcoap_memo_tests(void);
+
 #ifdef __cplusplus
 }
 #endif
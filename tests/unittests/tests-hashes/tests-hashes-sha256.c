@@ -28,6 +28,7 @@
 #include <stdlib.h>
 
 #include "embUnit/embUnit.h"
+#include "kernel_defines.h"
 
 #include "hashes/sha256.h"
 
@@ -212,6 +213,42 @@ static void test_hashes_sha256_hash_long_sequence(void)
                     hlong_sequence));
 }
 
+/**
+ * @brief expected hash for 1000 bytes of (i * 7 + 3) & 0xff
+ * i.e. 1e9bc38cbf860b9ec31918b065f9b52476c549a782e0e7990bed8ce3868d2371
+ */
+static const unsigned char hchunked[] = {0x1e, 0x9b, 0xc3, 0x8c, 0xbf, 0x86, 0x0b, 0x9e,
+                                         0xc3, 0x19, 0x18, 0xb0, 0x65, 0xf9, 0xb5, 0x24,
+                                         0x76, 0xc5, 0x49, 0xa7, 0x82, 0xe0, 0xe7, 0x99,
+                                         0x0b, 0xed, 0x8c, 0xe3, 0x86, 0x8d, 0x23, 0x71};
+
+static void test_hashes_sha256_hash_chunked(void)
+{
+    /* uneven chunk sizes so that updates both straddle block boundaries and
+     * cover several whole blocks at once */
+    static const size_t chunks[] = { 1, 63, 64, 200, 7, 129, 536 };
+    static unsigned char data[1000];
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    sha256_context_t ctx;
+    size_t pos = 0;
+
+    for (unsigned i = 0; i < sizeof(data); i++) {
+        data[i] = (i * 7 + 3) & 0xff;
+    }
+
+    sha256_init(&ctx);
+    for (unsigned i = 0; i < ARRAY_SIZE(chunks); i++) {
+        sha256_update(&ctx, &data[pos], chunks[i]);
+        pos += chunks[i];
+    }
+    TEST_ASSERT_EQUAL_INT(sizeof(data), pos);
+    sha256_final(&ctx, hash);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(hash, hchunked, sizeof(hash)));
+
+    sha256(data, sizeof(data), hash);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(hash, hchunked, sizeof(hash)));
+}
+
 Test *tests_hashes_sha256_tests(void)
 {
     EMB_UNIT_TESTFIXTURES(fixtures) {
@@ -227,6 +264,7 @@ Test *tests_hashes_sha256_tests(void)
         new_TestFixture(test_hashes_sha256_hash_sequence_failing_compare),
 
         new_TestFixture(test_hashes_sha256_hash_long_sequence),
+        new_TestFixture(test_hashes_sha256_hash_chunked),
     };
 
     EMB_UNIT_TESTCALLER(hashes_sha256_tests, NULL, NULL,
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @{
+ *
+ * @file
+ */
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "embUnit/embUnit.h"
+
+#include "memarray.h"
+#include "tests-memarray.h"
+
+#define TEST_NUM        (4U)
+#define TEST_GROW       (2U)
+
+typedef struct {
+    void *next;
+    uint32_t value;
+} elem_t;
+
+static elem_t _data[TEST_NUM];
+static elem_t _ext[TEST_NUM];
+static memarray_t _pool;
+
+static void set_up(void)
+{
+    memarray_init(&_pool, _data, sizeof(elem_t), TEST_NUM);
+}
+
+static void test_memarray_static_init(void)
+{
+    static memarray_t pool = MEMARRAY_INIT(_data, sizeof(elem_t), TEST_NUM);
+
+    TEST_ASSERT_EQUAL_INT(TEST_NUM, memarray_available(&pool));
+    for (unsigned i = 0; i < TEST_NUM; i++) {
+        TEST_ASSERT(memarray_alloc(&pool) == &_data[i]);
+    }
+    TEST_ASSERT_NULL(memarray_alloc(&pool));
+}
+
+static void test_memarray_alloc_free(void)
+{
+    elem_t *elems[TEST_NUM];
+
+    for (unsigned i = 0; i < TEST_NUM; i++) {
+        elems[i] = memarray_alloc(&_pool);
+        TEST_ASSERT_NOT_NULL(elems[i]);
+        elems[i]->value = i;
+    }
+    TEST_ASSERT_NULL(memarray_alloc(&_pool));
+    memarray_free(&_pool, elems[1]);
+    TEST_ASSERT(memarray_alloc(&_pool) == elems[1]);
+    for (unsigned i = 0; i < TEST_NUM; i++) {
+        TEST_ASSERT(elems[i] >= &_data[0]);
+        TEST_ASSERT(elems[i] <= &_data[TEST_NUM - 1]);
+        memarray_free(&_pool, elems[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(TEST_NUM, memarray_available(&_pool));
+}
+
+static void test_memarray_stats(void)
+{
+    void *a = memarray_alloc(&_pool);
+    void *b = memarray_alloc(&_pool);
+
+    memarray_free(&_pool, a);
+    TEST_ASSERT_EQUAL_INT(1, memarray_used(&_pool));
+    TEST_ASSERT_EQUAL_INT(2, memarray_max_used(&_pool));
+    TEST_ASSERT_EQUAL_INT(TEST_NUM - 1, memarray_available(&_pool));
+    for (unsigned i = 0; i < TEST_NUM; i++) {
+        memarray_alloc(&_pool);
+    }
+    TEST_ASSERT_EQUAL_INT(1, memarray_failed(&_pool));
+    TEST_ASSERT_EQUAL_INT(TEST_NUM, memarray_max_used(&_pool));
+    (void)b;
+}
+
+static void test_memarray_extend(void)
+{
+    for (unsigned i = 0; i < TEST_NUM; i++) {
+        memarray_alloc(&_pool);
+    }
+    memarray_extend(&_pool, _ext, TEST_NUM);
+    TEST_ASSERT_EQUAL_INT(TEST_NUM, memarray_available(&_pool));
+    for (unsigned i = 0; i < TEST_NUM; i++) {
+        elem_t *elem = memarray_alloc(&_pool);
+        TEST_ASSERT(elem == &_ext[i]);
+    }
+    TEST_ASSERT_NULL(memarray_alloc(&_pool));
+}
+
+static void test_memarray_extend_partial(void)
+{
+    /* extending a pool with unused elements left chains the new ones into the
+     * free list */
+    memarray_alloc(&_pool);
+    memarray_extend(&_pool, _ext, TEST_NUM);
+    for (unsigned i = 0; i < (2 * TEST_NUM) - 1; i++) {
+        TEST_ASSERT_NOT_NULL(memarray_alloc(&_pool));
+    }
+    TEST_ASSERT_NULL(memarray_alloc(&_pool));
+}
+
+static void test_memarray_grow(void)
+{
+    elem_t *elem;
+
+    memarray_set_grow(&_pool, TEST_GROW);
+    for (unsigned i = 0; i < TEST_NUM; i++) {
+        memarray_alloc(&_pool);
+    }
+    elem = memarray_alloc(&_pool);
+    TEST_ASSERT_NOT_NULL(elem);
+    TEST_ASSERT((elem < &_data[0]) || (elem > &_data[TEST_NUM - 1]));
+    TEST_ASSERT_EQUAL_INT(TEST_NUM + TEST_GROW, _pool.num);
+    TEST_ASSERT_EQUAL_INT(TEST_GROW - 1, memarray_available(&_pool));
+    /* the grown chunk stays with the pool, release it for the test */
+    free(elem);
+}
+
+static Test *tests_memarray_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_memarray_static_init),
+        new_TestFixture(test_memarray_alloc_free),
+        new_TestFixture(test_memarray_stats),
+        new_TestFixture(test_memarray_extend),
+        new_TestFixture(test_memarray_extend_partial),
+        new_TestFixture(test_memarray_grow),
+    };
+
+    EMB_UNIT_TESTCALLER(memarray_tests, set_up, NULL, fixtures);
+
+    return (Test *)&memarray_tests;
+}
+
+void tests_memarray(void)
+{
+    TESTS_RUN(tests_memarray_tests());
+}
+/** @} */
@@ -774,6 +774,72 @@ static void test_nanocoap__add_path_unterminated_string(void)
     TEST_ASSERT_EQUAL_INT(0, strncmp(path, uri, path_len));
 }
 
+/*
+ * Builds the same request with options added in order and out of order.
+ * Proxy-Uri is inserted in front of Proxy-Scheme, whose header shrinks then.
+ */
+static void test_nanocoap__add_opts_unsorted(void)
+{
+    uint8_t buf[_BUF_SIZE];
+    uint8_t exp_buf[_BUF_SIZE];
+    coap_pkt_t pkt;
+    coap_pkt_t exp_pkt;
+    uint16_t msgid = 0xABCD;
+    uint8_t token[2] = {0xDA, 0xEC};
+    char path[] = "/riot/value";
+    char proxy_uri[] = "coap://[fe80::1]/";
+    uint8_t scheme[] = "coap";
+
+    size_t len = coap_build_hdr((coap_hdr_t *)&exp_buf[0], COAP_TYPE_NON,
+                                &token[0], 2, COAP_METHOD_GET, msgid);
+    coap_pkt_init(&exp_pkt, &exp_buf[0], sizeof(exp_buf), len);
+    coap_opt_add_uri_path(&exp_pkt, path);
+    coap_opt_add_format(&exp_pkt, COAP_FORMAT_LINK);
+    coap_opt_add_uri_query(&exp_pkt, "a", "1");
+    coap_opt_add_proxy_uri(&exp_pkt, proxy_uri);
+    coap_opt_add_opaque(&exp_pkt, COAP_OPT_PROXY_SCHEME, scheme, 4);
+    ssize_t exp_len = coap_opt_finish(&exp_pkt, COAP_OPT_FINISH_NONE);
+
+    len = coap_build_hdr((coap_hdr_t *)&buf[0], COAP_TYPE_NON,
+                         &token[0], 2, COAP_METHOD_GET, msgid);
+    coap_pkt_init(&pkt, &buf[0], sizeof(buf), len);
+    coap_opt_add_opaque(&pkt, COAP_OPT_PROXY_SCHEME, scheme, 4);
+    coap_opt_add_uri_query(&pkt, "a", "1");
+    /* 3 byte option header, Proxy-Scheme header shrinks by 1 byte */
+    TEST_ASSERT_EQUAL_INT(3 + sizeof(proxy_uri) - 1 - 1,
+                          coap_opt_add_proxy_uri(&pkt, proxy_uri));
+    coap_opt_add_format(&pkt, COAP_FORMAT_LINK);
+    coap_opt_add_uri_path(&pkt, path);
+    len = coap_opt_finish(&pkt, COAP_OPT_FINISH_NONE);
+
+    TEST_ASSERT_EQUAL_INT(exp_len, len);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(exp_buf, buf, len));
+    TEST_ASSERT_EQUAL_INT(exp_pkt.options_len, pkt.options_len);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(exp_pkt.options, pkt.options,
+                                    pkt.options_len * sizeof(coap_optpos_t)));
+
+    /* the getters find all options in the parsed message */
+    TEST_ASSERT_EQUAL_INT(0, coap_parse(&pkt, buf, len));
+    TEST_ASSERT_EQUAL_INT(5, pkt.options_len);
+
+    char uri[CONFIG_NANOCOAP_URI_MAX];
+    coap_get_uri_path(&pkt, (uint8_t *)&uri[0]);
+    TEST_ASSERT_EQUAL_STRING(path, uri);
+    TEST_ASSERT_EQUAL_INT(COAP_FORMAT_LINK, coap_get_content_type(&pkt));
+
+    uint8_t *value;
+    TEST_ASSERT_EQUAL_INT(4, coap_opt_get_opaque(&pkt, COAP_OPT_PROXY_SCHEME,
+                                                 &value));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(scheme, value, 4));
+    TEST_ASSERT_EQUAL_INT(sizeof(proxy_uri) - 1,
+                          coap_opt_get_opaque(&pkt, COAP_OPT_PROXY_URI,
+                                              &value));
+    TEST_ASSERT_EQUAL_INT(-ENOENT, coap_opt_get_opaque(&pkt, COAP_OPT_ACCEPT,
+                                                       &value));
+    TEST_ASSERT_EQUAL_INT(-ENOENT, coap_opt_get_opaque(&pkt, COAP_OPT_SIZE1,
+                                                       &value));
+}
+
 Test *tests_nanocoap_tests(void)
 {
     EMB_UNIT_TESTFIXTURES(fixtures) {
@@ -799,6 +865,7 @@ Test *tests_nanocoap_tests(void)
         new_TestFixture(test_nanocoap__server_option_count_overflow),
         new_TestFixture(test_nanocoap__empty),
         new_TestFixture(test_nanocoap__add_path_unterminated_string),
+        new_TestFixture(test_nanocoap__add_opts_unsorted),
     };
 
     EMB_UNIT_TESTCALLER(nanocoap_tests, NULL, NULL, fixtures);
@@ -0,0 +1,304 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @{
+ *
+ * @file
+ */
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "embUnit.h"
+
+#include "net/nanocoap.h"
+#include "net/nanocoap_block.h"
+
+#include "tests-nanocoap_block.h"
+
+#define _BUF_SIZE       (128U)
+#define _DATA_SIZE      (100U)
+#define _SZX_MAX        (CONFIG_NANOCOAP_BLOCK_SIZE_EXP_MAX - 4)
+
+static uint8_t _req_buf[_BUF_SIZE];
+static uint8_t _resp_buf[_BUF_SIZE];
+static uint8_t _data[_DATA_SIZE];
+static uint8_t _sink_buf[_DATA_SIZE];
+static unsigned _writes;
+
+static ssize_t _read(void *arg, size_t offset, uint8_t *buf, size_t len)
+{
+    (void)arg;
+    memcpy(buf, _data + offset, len);
+    return len;
+}
+
+static ssize_t _read_fail(void *arg, size_t offset, uint8_t *buf, size_t len)
+{
+    (void)arg;
+    (void)offset;
+    (void)buf;
+    (void)len;
+    return -EIO;
+}
+
+static int _write(void *arg, size_t offset, uint8_t *buf, size_t len, int more)
+{
+    (void)arg;
+    (void)more;
+    if (offset + len > sizeof(_sink_buf)) {
+        return -1;
+    }
+    memcpy(_sink_buf + offset, buf, len);
+    _writes++;
+    return 0;
+}
+
+/* Builds a request with a Block1 or Block2 option, blknum < 0 for none */
+static void _build_req(coap_pkt_t *pkt, unsigned method, unsigned onum,
+                       int blknum, unsigned szx, bool more, size_t payload_len)
+{
+    uint8_t token[2] = { 0x12, 0x34 };
+    ssize_t len = coap_build_hdr((coap_hdr_t *)_req_buf, COAP_TYPE_CON, token,
+                                 sizeof(token), method, 42);
+
+    coap_pkt_init(pkt, _req_buf, sizeof(_req_buf), len);
+    coap_opt_add_uri_path(pkt, "/data");
+    if (blknum >= 0) {
+        coap_opt_add_uint(pkt, onum, (blknum << 4) | (more << 3) | szx);
+    }
+    if (payload_len) {
+        len = coap_opt_finish(pkt, COAP_OPT_FINISH_PAYLOAD);
+        memcpy(pkt->payload, _data + (blknum << (szx + 4)), payload_len);
+        len += payload_len;
+    }
+    else {
+        len = coap_opt_finish(pkt, COAP_OPT_FINISH_NONE);
+    }
+    coap_parse(pkt, _req_buf, len);
+}
+
+static void _parse_resp(coap_pkt_t *pkt, ssize_t len)
+{
+    TEST_ASSERT(len > 0);
+    TEST_ASSERT_EQUAL_INT(0, coap_parse(pkt, _resp_buf, len));
+}
+
+static void set_up(void)
+{
+    for (unsigned i = 0; i < sizeof(_data); i++) {
+        _data[i] = i;
+    }
+    memset(_sink_buf, 0, sizeof(_sink_buf));
+    _writes = 0;
+}
+
+static void test_nanocoap_block__reply_first(void)
+{
+    coap_pkt_t req, resp;
+    coap_block1_t block2;
+    uint32_t size2;
+
+    _build_req(&req, COAP_METHOD_GET, COAP_OPT_BLOCK2, -1, 0, false, 0);
+    ssize_t len = coap_block2_reply_stream(&req, COAP_CODE_CONTENT, _resp_buf,
+                                           sizeof(_resp_buf), COAP_FORMAT_OCTET,
+                                           sizeof(_data), _read, NULL);
+    _parse_resp(&resp, len);
+
+    TEST_ASSERT_EQUAL_INT(COAP_CODE_CONTENT, coap_get_code_raw(&resp));
+    TEST_ASSERT_EQUAL_INT(COAP_FORMAT_OCTET, coap_get_content_type(&resp));
+    TEST_ASSERT(coap_get_block2(&resp, &block2));
+    TEST_ASSERT_EQUAL_INT(0, block2.blknum);
+    TEST_ASSERT_EQUAL_INT(_SZX_MAX, block2.szx);
+    TEST_ASSERT_EQUAL_INT(1, block2.more);
+    TEST_ASSERT_EQUAL_INT(0, coap_opt_get_uint(&resp, COAP_OPT_SIZE2, &size2));
+    TEST_ASSERT_EQUAL_INT(sizeof(_data), size2);
+    TEST_ASSERT_EQUAL_INT(coap_szx2size(_SZX_MAX), resp.payload_len);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(resp.payload, _data, resp.payload_len));
+}
+
+static void test_nanocoap_block__reply_last(void)
+{
+    coap_pkt_t req, resp;
+    coap_block1_t block2;
+    uint32_t size2;
+
+    /* 32 byte blocks, the last one is short */
+    _build_req(&req, COAP_METHOD_GET, COAP_OPT_BLOCK2, 3, 1, false, 0);
+    ssize_t len = coap_block2_reply_stream(&req, COAP_CODE_CONTENT, _resp_buf,
+                                           sizeof(_resp_buf), COAP_FORMAT_NONE,
+                                           sizeof(_data), _read, NULL);
+    _parse_resp(&resp, len);
+
+    TEST_ASSERT(coap_get_block2(&resp, &block2));
+    TEST_ASSERT_EQUAL_INT(3, block2.blknum);
+    TEST_ASSERT_EQUAL_INT(1, block2.szx);
+    TEST_ASSERT_EQUAL_INT(0, block2.more);
+    TEST_ASSERT(coap_opt_get_uint(&resp, COAP_OPT_SIZE2, &size2) < 0);
+    TEST_ASSERT_EQUAL_INT(sizeof(_data) - 96, resp.payload_len);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(resp.payload, _data + 96,
+                                    resp.payload_len));
+}
+
+static void test_nanocoap_block__reply_small_buf(void)
+{
+    coap_pkt_t req, resp;
+    coap_block1_t block2;
+
+    /* block 1 of 64 bytes only fits as block 2 of 32 bytes */
+    _build_req(&req, COAP_METHOD_GET, COAP_OPT_BLOCK2, 1, 2, false, 0);
+    ssize_t len = coap_block2_reply_stream(&req, COAP_CODE_CONTENT, _resp_buf,
+                                           64, COAP_FORMAT_NONE,
+                                           sizeof(_data), _read, NULL);
+    _parse_resp(&resp, len);
+
+    TEST_ASSERT(coap_get_block2(&resp, &block2));
+    TEST_ASSERT_EQUAL_INT(2, block2.blknum);
+    TEST_ASSERT_EQUAL_INT(1, block2.szx);
+    TEST_ASSERT_EQUAL_INT(1, block2.more);
+    TEST_ASSERT_EQUAL_INT(32, resp.payload_len);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(resp.payload, _data + 64, 32));
+}
+
+static void test_nanocoap_block__reply_errors(void)
+{
+    coap_pkt_t req, resp;
+
+    _build_req(&req, COAP_METHOD_GET, COAP_OPT_BLOCK2, 4, 1, false, 0);
+    ssize_t len = coap_block2_reply_stream(&req, COAP_CODE_CONTENT, _resp_buf,
+                                           sizeof(_resp_buf), COAP_FORMAT_NONE,
+                                           sizeof(_data), _read, NULL);
+    _parse_resp(&resp, len);
+    TEST_ASSERT_EQUAL_INT(COAP_CODE_BAD_OPTION, coap_get_code_raw(&resp));
+
+    _build_req(&req, COAP_METHOD_GET, COAP_OPT_BLOCK2, 0, 1, false, 0);
+    len = coap_block2_reply_stream(&req, COAP_CODE_CONTENT, _resp_buf,
+                                   sizeof(_resp_buf), COAP_FORMAT_NONE,
+                                   sizeof(_data), _read_fail, NULL);
+    _parse_resp(&resp, len);
+    TEST_ASSERT_EQUAL_INT(COAP_CODE_INTERNAL_SERVER_ERROR,
+                          coap_get_code_raw(&resp));
+}
+
+static void test_nanocoap_block__sink(void)
+{
+    coap_block1_sink_t sink;
+    coap_pkt_t req, resp;
+    coap_block1_t block1;
+
+    coap_block1_sink_init(&sink, _write, NULL);
+
+    for (unsigned num = 0; num < 4; num++) {
+        bool more = num < 3;
+        _build_req(&req, COAP_METHOD_PUT, COAP_OPT_BLOCK1, num, 1, more,
+                   more ? 32 : sizeof(_data) - 96);
+        ssize_t len = coap_block1_sink_handle(&sink, &req, _resp_buf,
+                                              sizeof(_resp_buf),
+                                              COAP_CODE_CHANGED);
+        _parse_resp(&resp, len);
+        TEST_ASSERT_EQUAL_INT(more ? COAP_CODE_CONTINUE : COAP_CODE_CHANGED,
+                              coap_get_code_raw(&resp));
+        TEST_ASSERT(coap_get_block1(&resp, &block1));
+        TEST_ASSERT_EQUAL_INT(num, block1.blknum);
+        TEST_ASSERT_EQUAL_INT(more, block1.more);
+    }
+    TEST_ASSERT_EQUAL_INT(4, _writes);
+    TEST_ASSERT_EQUAL_INT(sizeof(_data), sink.offset);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(_sink_buf, _data, sizeof(_data)));
+}
+
+static void test_nanocoap_block__sink_retransmit(void)
+{
+    coap_block1_sink_t sink;
+    coap_pkt_t req, resp;
+
+    coap_block1_sink_init(&sink, _write, NULL);
+
+    for (unsigned i = 0; i < 2; i++) {
+        _build_req(&req, COAP_METHOD_PUT, COAP_OPT_BLOCK1, 0, 1, true, 32);
+        ssize_t len = coap_block1_sink_handle(&sink, &req, _resp_buf,
+                                              sizeof(_resp_buf),
+                                              COAP_CODE_CHANGED);
+        _parse_resp(&resp, len);
+        TEST_ASSERT_EQUAL_INT(COAP_CODE_CONTINUE, coap_get_code_raw(&resp));
+    }
+    /* the retransmission is acknowledged, but not written again */
+    TEST_ASSERT_EQUAL_INT(1, _writes);
+    TEST_ASSERT_EQUAL_INT(32, sink.offset);
+
+    _build_req(&req, COAP_METHOD_PUT, COAP_OPT_BLOCK1, 1, 1, true, 32);
+    coap_block1_sink_handle(&sink, &req, _resp_buf, sizeof(_resp_buf),
+                            COAP_CODE_CHANGED);
+    _build_req(&req, COAP_METHOD_PUT, COAP_OPT_BLOCK1, 1, 1, true, 32);
+    ssize_t len = coap_block1_sink_handle(&sink, &req, _resp_buf,
+                                          sizeof(_resp_buf),
+                                          COAP_CODE_CHANGED);
+    _parse_resp(&resp, len);
+    TEST_ASSERT_EQUAL_INT(COAP_CODE_CONTINUE, coap_get_code_raw(&resp));
+    TEST_ASSERT_EQUAL_INT(2, _writes);
+    TEST_ASSERT_EQUAL_INT(64, sink.offset);
+
+    /* a new transfer starts over at block 0 */
+    _build_req(&req, COAP_METHOD_PUT, COAP_OPT_BLOCK1, 0, 1, true, 32);
+    len = coap_block1_sink_handle(&sink, &req, _resp_buf, sizeof(_resp_buf),
+                                  COAP_CODE_CHANGED);
+    _parse_resp(&resp, len);
+    TEST_ASSERT_EQUAL_INT(COAP_CODE_CONTINUE, coap_get_code_raw(&resp));
+    TEST_ASSERT_EQUAL_INT(3, _writes);
+    TEST_ASSERT_EQUAL_INT(32, sink.offset);
+}
+
+static void test_nanocoap_block__sink_incomplete(void)
+{
+    coap_block1_sink_t sink;
+    coap_pkt_t req, resp;
+
+    coap_block1_sink_init(&sink, _write, NULL);
+
+    /* block 1 before block 0 */
+    _build_req(&req, COAP_METHOD_PUT, COAP_OPT_BLOCK1, 1, 1, true, 32);
+    ssize_t len = coap_block1_sink_handle(&sink, &req, _resp_buf,
+                                          sizeof(_resp_buf),
+                                          COAP_CODE_CHANGED);
+    _parse_resp(&resp, len);
+    TEST_ASSERT_EQUAL_INT(COAP_CODE_REQUEST_ENTITY_INCOMPLETE,
+                          coap_get_code_raw(&resp));
+
+    /* short block with more blocks following */
+    _build_req(&req, COAP_METHOD_PUT, COAP_OPT_BLOCK1, 0, 1, true, 16);
+    len = coap_block1_sink_handle(&sink, &req, _resp_buf, sizeof(_resp_buf),
+                                  COAP_CODE_CHANGED);
+    _parse_resp(&resp, len);
+    TEST_ASSERT_EQUAL_INT(COAP_CODE_REQUEST_ENTITY_INCOMPLETE,
+                          coap_get_code_raw(&resp));
+    TEST_ASSERT_EQUAL_INT(0, _writes);
+}
+
+Test *tests_nanocoap_block_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_nanocoap_block__reply_first),
+        new_TestFixture(test_nanocoap_block__reply_last),
+        new_TestFixture(test_nanocoap_block__reply_small_buf),
+        new_TestFixture(test_nanocoap_block__reply_errors),
+        new_TestFixture(test_nanocoap_block__sink),
+        new_TestFixture(test_nanocoap_block__sink_retransmit),
+        new_TestFixture(test_nanocoap_block__sink_incomplete),
+    };
+
+    EMB_UNIT_TESTCALLER(nanocoap_block_tests, set_up, NULL, fixtures);
+
+    return (Test *)&nanocoap_block_tests;
+}
+
+void tests_nanocoap_block(void)
+{
+    TESTS_RUN(tests_nanocoap_block_tests());
+}
+/** @} */
@@ -0,0 +1,395 @@
+/*
+ * Copyright (C) 2020 Freie Universität Berlin
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v2.1. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * @{
+ *
+ * @file
+ */
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "embUnit.h"
+
+#include "net/nanocoap.h"
+#include "net/nanocoap_cache.h"
+
+#include "tests-nanocoap_cache.h"
+
+#define _BUF_SIZE (128U)
+
+static uint8_t _req_buf[_BUF_SIZE];
+static uint8_t _resp_buf[_BUF_SIZE];
+static uint8_t _out_buf[_BUF_SIZE];
+
+static const uint8_t _etag[] = { 0xde, 0xad };
+
+static void _build_req(coap_pkt_t *pkt, unsigned method, unsigned type,
+                       const char *path, const char *proxy_uri)
+{
+    uint8_t token[2] = { 0x12, 0x34 };
+    ssize_t len = coap_build_hdr((coap_hdr_t *)_req_buf, type, token,
+                                 sizeof(token), method, 42);
+
+    coap_pkt_init(pkt, _req_buf, sizeof(_req_buf), len);
+    if (path) {
+        coap_opt_add_uri_path(pkt, path);
+    }
+    if (proxy_uri) {
+        coap_opt_add_opaque(pkt, COAP_OPT_PROXY_URI, (uint8_t *)proxy_uri,
+                            strlen(proxy_uri));
+    }
+    len = coap_opt_finish(pkt, COAP_OPT_FINISH_NONE);
+    coap_parse(pkt, _req_buf, len);
+}
+
+/* GET with an Accept option, or PUT with a payload and Content-Format */
+static void _build_req_format(coap_pkt_t *pkt, unsigned method,
+                              const char *path, uint16_t format)
+{
+    uint8_t token[2] = { 0x56, 0x78 };
+    ssize_t len = coap_build_hdr((coap_hdr_t *)_req_buf, COAP_TYPE_CON, token,
+                                 sizeof(token), method, 43);
+
+    coap_pkt_init(pkt, _req_buf, sizeof(_req_buf), len);
+    if (method == COAP_METHOD_PUT) {
+        coap_opt_add_uri_path(pkt, path);
+        coap_opt_add_format(pkt, format);
+        len = coap_opt_finish(pkt, COAP_OPT_FINISH_PAYLOAD);
+        memcpy(pkt->payload, "new", 3);
+        len += 3;
+    }
+    else {
+        coap_opt_add_uri_path(pkt, path);
+        coap_opt_add_uint(pkt, COAP_OPT_ACCEPT, format);
+        len = coap_opt_finish(pkt, COAP_OPT_FINISH_NONE);
+    }
+    coap_parse(pkt, _req_buf, len);
+}
+
+static size_t _build_resp(coap_pkt_t *pkt, unsigned code, int max_age,
+                          const char *payload)
+{
+    uint8_t token[2] = { 0x12, 0x34 };
+    ssize_t len = coap_build_hdr((coap_hdr_t *)_resp_buf, COAP_TYPE_ACK, token,
+                                 sizeof(token), code, 42);
+
+    coap_pkt_init(pkt, _resp_buf, sizeof(_resp_buf), len);
+    coap_opt_add_opaque(pkt, COAP_OPT_ETAG, _etag, sizeof(_etag));
+    if (max_age >= 0) {
+        coap_opt_add_uint(pkt, COAP_OPT_MAX_AGE, max_age);
+    }
+    if (payload) {
+        len = coap_opt_finish(pkt, COAP_OPT_FINISH_PAYLOAD);
+        memcpy(pkt->payload, payload, strlen(payload));
+        len += strlen(payload);
+    }
+    else {
+        len = coap_opt_finish(pkt, COAP_OPT_FINISH_NONE);
+    }
+    coap_parse(pkt, _resp_buf, len);
+    return len;
+}
+
+static void set_up(void)
+{
+    nanocoap_cache_init();
+}
+
+static void test_nanocoap_cache__key(void)
+{
+    coap_pkt_t req;
+    uint8_t key1[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+    uint8_t key2[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+
+    _build_req(&req, COAP_METHOD_GET, COAP_TYPE_CON, "/a/b", NULL);
+    nanocoap_cache_key_generate(&req, key1);
+
+    /* method and message type are not part of the key */
+    _build_req(&req, COAP_METHOD_PUT, COAP_TYPE_NON, "/a/b", NULL);
+    nanocoap_cache_key_generate(&req, key2);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(key1, key2, sizeof(key1)));
+
+    _build_req(&req, COAP_METHOD_GET, COAP_TYPE_CON, "/a/c", NULL);
+    nanocoap_cache_key_generate(&req, key2);
+    TEST_ASSERT(memcmp(key1, key2, sizeof(key1)) != 0);
+
+    _build_req(&req, COAP_METHOD_GET, COAP_TYPE_CON, "/ab", NULL);
+    nanocoap_cache_key_generate(&req, key2);
+    TEST_ASSERT(memcmp(key1, key2, sizeof(key1)) != 0);
+}
+
+static void test_nanocoap_cache__key_proxy_uri(void)
+{
+    coap_pkt_t req;
+    uint8_t key1[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+    uint8_t key2[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+
+    _build_req(&req, COAP_METHOD_GET, COAP_TYPE_CON, NULL,
+               "coap://[2001:db8::1]/");
+    nanocoap_cache_key_generate(&req, key1);
+
+    _build_req(&req, COAP_METHOD_GET, COAP_TYPE_CON, NULL,
+               "COAP://[2001:DB8::1]:5683");
+    nanocoap_cache_key_generate(&req, key2);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(key1, key2, sizeof(key1)));
+
+    _build_req(&req, COAP_METHOD_GET, COAP_TYPE_CON, NULL,
+               "coap://[2001:db8::1]:5684/");
+    nanocoap_cache_key_generate(&req, key2);
+    TEST_ASSERT(memcmp(key1, key2, sizeof(key1)) != 0);
+
+    _build_req(&req, COAP_METHOD_GET, COAP_TYPE_CON, NULL,
+               "coap://[2001:db8::1]/A");
+    nanocoap_cache_key_generate(&req, key1);
+    _build_req(&req, COAP_METHOD_GET, COAP_TYPE_CON, NULL,
+               "coap://[2001:db8::1]/a");
+    nanocoap_cache_key_generate(&req, key2);
+    TEST_ASSERT(memcmp(key1, key2, sizeof(key1)) != 0);
+}
+
+static void test_nanocoap_cache__add_lookup(void)
+{
+    coap_pkt_t req, resp;
+
+    _build_req(&req, COAP_METHOD_GET, COAP_TYPE_CON, "/a", NULL);
+    TEST_ASSERT_NULL(nanocoap_cache_request_lookup(&req));
+
+    size_t len = _build_resp(&resp, COAP_CODE_CONTENT, 30, "abc");
+    nanocoap_cache_entry_t *ce = nanocoap_cache_add_by_req(&req, &resp, len);
+    TEST_ASSERT_NOT_NULL(ce);
+    TEST_ASSERT_EQUAL_INT(1, nanocoap_cache_used_count());
+    TEST_ASSERT_EQUAL_INT(CONFIG_NANOCOAP_CACHE_ENTRIES - 1,
+                          nanocoap_cache_free_count());
+    TEST_ASSERT(ce == nanocoap_cache_request_lookup(&req));
+    TEST_ASSERT(!nanocoap_cache_entry_is_stale(ce, nanocoap_cache_now()));
+    TEST_ASSERT(nanocoap_cache_entry_is_stale(ce, nanocoap_cache_now() + 30));
+    TEST_ASSERT_EQUAL_INT(sizeof(_etag), ce->etag_len);
+
+    /* an entry only answers the method it was cached for */
+    _build_req(&req, COAP_METHOD_FETCH, COAP_TYPE_CON, "/a", NULL);
+    TEST_ASSERT_NULL(nanocoap_cache_request_lookup(&req));
+
+    TEST_ASSERT_EQUAL_INT(0, nanocoap_cache_del(ce));
+    TEST_ASSERT_EQUAL_INT(-ENOENT, nanocoap_cache_del(ce));
+    TEST_ASSERT_EQUAL_INT(0, nanocoap_cache_used_count());
+}
+
+static void test_nanocoap_cache__not_cacheable(void)
+{
+    coap_pkt_t req, resp;
+    uint8_t key[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+    uint8_t uri[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+
+    _build_req(&req, COAP_METHOD_GET, COAP_TYPE_CON, "/a", NULL);
+    nanocoap_cache_key_generate(&req, key);
+    nanocoap_cache_uri_key_generate(&req, uri);
+
+    size_t len = _build_resp(&resp, COAP_CODE_CONTENT, 0, "abc");
+    TEST_ASSERT_NULL(nanocoap_cache_add_by_key(key, uri, COAP_METHOD_GET,
+                                               &resp, len));
+
+    /* 2.04 Changed is not cacheable */
+    len = _build_resp(&resp, COAP_CODE_CHANGED, 30, NULL);
+    TEST_ASSERT_EQUAL_INT(-ENOENT, nanocoap_cache_process(key, uri,
+                                                          COAP_METHOD_GET,
+                                                          &resp, len));
+    TEST_ASSERT_EQUAL_INT(0, nanocoap_cache_used_count());
+}
+
+static void test_nanocoap_cache__lru(void)
+{
+    coap_pkt_t req, resp;
+    uint8_t key[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+    uint8_t uri[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+    char path[8];
+
+    size_t len = _build_resp(&resp, COAP_CODE_CONTENT, 30, "abc");
+    for (unsigned i = 0; i <= CONFIG_NANOCOAP_CACHE_ENTRIES; i++) {
+        snprintf(path, sizeof(path), "/%u", i);
+        _build_req(&req, COAP_METHOD_GET, COAP_TYPE_CON, path, NULL);
+        nanocoap_cache_key_generate(&req, key);
+        nanocoap_cache_uri_key_generate(&req, uri);
+        TEST_ASSERT_NOT_NULL(nanocoap_cache_add_by_key(key, uri,
+                                                       COAP_METHOD_GET,
+                                                       &resp, len));
+        if (i == 0) {
+            continue;
+        }
+        /* keep the first entry in use */
+        _build_req(&req, COAP_METHOD_GET, COAP_TYPE_CON, "/0", NULL);
+        TEST_ASSERT_NOT_NULL(nanocoap_cache_request_lookup(&req));
+    }
+    TEST_ASSERT_EQUAL_INT(CONFIG_NANOCOAP_CACHE_ENTRIES,
+                          nanocoap_cache_used_count());
+
+    _build_req(&req, COAP_METHOD_GET, COAP_TYPE_CON, "/0", NULL);
+    TEST_ASSERT_NOT_NULL(nanocoap_cache_request_lookup(&req));
+    _build_req(&req, COAP_METHOD_GET, COAP_TYPE_CON, "/1", NULL);
+    TEST_ASSERT_NULL(nanocoap_cache_request_lookup(&req));
+    _build_req(&req, COAP_METHOD_GET, COAP_TYPE_CON, "/2", NULL);
+    TEST_ASSERT_NOT_NULL(nanocoap_cache_request_lookup(&req));
+}
+
+static void test_nanocoap_cache__uri_key(void)
+{
+    coap_pkt_t req;
+    uint8_t key1[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+    uint8_t key2[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+    uint8_t uri1[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+    uint8_t uri2[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+
+    _build_req_format(&req, COAP_METHOD_GET, "/a", COAP_FORMAT_TEXT);
+    nanocoap_cache_key_generate(&req, key1);
+    nanocoap_cache_uri_key_generate(&req, uri1);
+
+    /* Content-Format and Accept are part of the cache key only */
+    _build_req_format(&req, COAP_METHOD_PUT, "/a", COAP_FORMAT_JSON);
+    nanocoap_cache_key_generate(&req, key2);
+    nanocoap_cache_uri_key_generate(&req, uri2);
+    TEST_ASSERT(memcmp(key1, key2, sizeof(key1)) != 0);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(uri1, uri2, sizeof(uri1)));
+
+    _build_req_format(&req, COAP_METHOD_PUT, "/b", COAP_FORMAT_TEXT);
+    nanocoap_cache_uri_key_generate(&req, uri2);
+    TEST_ASSERT(memcmp(uri1, uri2, sizeof(uri1)) != 0);
+}
+
+static void test_nanocoap_cache__invalidate(void)
+{
+    coap_pkt_t req, resp;
+    uint8_t key[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+    uint8_t uri[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+    size_t len = _build_resp(&resp, COAP_CODE_CONTENT, 30, "abc");
+
+    /* two representations of /a and one of /b */
+    _build_req_format(&req, COAP_METHOD_GET, "/a", COAP_FORMAT_TEXT);
+    TEST_ASSERT_NOT_NULL(nanocoap_cache_add_by_req(&req, &resp, len));
+    _build_req_format(&req, COAP_METHOD_GET, "/a", COAP_FORMAT_JSON);
+    TEST_ASSERT_NOT_NULL(nanocoap_cache_add_by_req(&req, &resp, len));
+    _build_req_format(&req, COAP_METHOD_GET, "/b", COAP_FORMAT_TEXT);
+    TEST_ASSERT_NOT_NULL(nanocoap_cache_add_by_req(&req, &resp, len));
+    TEST_ASSERT_EQUAL_INT(3, nanocoap_cache_used_count());
+
+    _build_req_format(&req, COAP_METHOD_PUT, "/a", COAP_FORMAT_TEXT);
+    nanocoap_cache_key_generate(&req, key);
+    nanocoap_cache_uri_key_generate(&req, uri);
+
+    /* a failed PUT keeps the entries */
+    len = _build_resp(&resp, COAP_CODE_BAD_REQUEST, -1, NULL);
+    TEST_ASSERT_EQUAL_INT(-ENOENT, nanocoap_cache_process(key, uri,
+                                                          COAP_METHOD_PUT,
+                                                          &resp, len));
+    TEST_ASSERT_EQUAL_INT(3, nanocoap_cache_used_count());
+
+    len = _build_resp(&resp, COAP_CODE_CHANGED, -1, NULL);
+    TEST_ASSERT_EQUAL_INT(-ENOENT, nanocoap_cache_process(key, uri,
+                                                          COAP_METHOD_PUT,
+                                                          &resp, len));
+    TEST_ASSERT_EQUAL_INT(1, nanocoap_cache_used_count());
+    _build_req_format(&req, COAP_METHOD_GET, "/a", COAP_FORMAT_TEXT);
+    TEST_ASSERT_NULL(nanocoap_cache_request_lookup(&req));
+    _build_req_format(&req, COAP_METHOD_GET, "/a", COAP_FORMAT_JSON);
+    TEST_ASSERT_NULL(nanocoap_cache_request_lookup(&req));
+    _build_req_format(&req, COAP_METHOD_GET, "/b", COAP_FORMAT_TEXT);
+    TEST_ASSERT_NOT_NULL(nanocoap_cache_request_lookup(&req));
+}
+
+static void test_nanocoap_cache__validate(void)
+{
+    coap_pkt_t req, resp;
+    uint8_t key[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+    uint8_t uri[CONFIG_NANOCOAP_CACHE_KEY_LENGTH];
+
+    _build_req(&req, COAP_METHOD_GET, COAP_TYPE_CON, "/a", NULL);
+    nanocoap_cache_key_generate(&req, key);
+    nanocoap_cache_uri_key_generate(&req, uri);
+    size_t len = _build_resp(&resp, COAP_CODE_CONTENT, 30, "abc");
+    nanocoap_cache_entry_t *ce = nanocoap_cache_add_by_key(key, uri,
+                                                           COAP_METHOD_GET,
+                                                           &resp, len);
+    TEST_ASSERT_NOT_NULL(ce);
+    ce->max_age = nanocoap_cache_now();
+    TEST_ASSERT(nanocoap_cache_entry_is_stale(ce, nanocoap_cache_now()));
+
+    /* 2.03 Valid with the cached ETag makes the entry fresh again */
+    len = _build_resp(&resp, COAP_CODE_VALID, 30, NULL);
+    TEST_ASSERT_EQUAL_INT(0, nanocoap_cache_process(key, uri, COAP_METHOD_GET,
+                                                    &resp, len));
+    TEST_ASSERT(!nanocoap_cache_entry_is_stale(ce, nanocoap_cache_now()));
+    /* the cached representation is kept */
+    TEST_ASSERT_EQUAL_INT(0, memcmp(ce->response_buf + ce->response_len - 3,
+                                    "abc", 3));
+}
+
+static void test_nanocoap_cache__build_reply(void)
+{
+    coap_pkt_t req, resp, reply;
+    uint32_t max_age;
+
+    _build_req(&req, COAP_METHOD_GET, COAP_TYPE_CON, "/a", NULL);
+    size_t len = _build_resp(&resp, COAP_CODE_CONTENT, 30, "abc");
+    nanocoap_cache_entry_t *ce = nanocoap_cache_add_by_req(&req, &resp, len);
+    TEST_ASSERT_NOT_NULL(ce);
+
+    ssize_t res = nanocoap_cache_build_reply(ce, &req, _out_buf,
+                                             sizeof(_out_buf));
+    TEST_ASSERT(res > 0);
+    TEST_ASSERT_EQUAL_INT(0, coap_parse(&reply, _out_buf, res));
+    TEST_ASSERT_EQUAL_INT(COAP_TYPE_ACK, coap_get_type(&reply));
+    TEST_ASSERT_EQUAL_INT(42, coap_get_id(&reply));
+    TEST_ASSERT_EQUAL_INT(COAP_CODE_CONTENT, coap_get_code_raw(&reply));
+    TEST_ASSERT_EQUAL_INT(3, reply.payload_len);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(reply.payload, "abc", 3));
+    TEST_ASSERT_EQUAL_INT(0, coap_opt_get_uint(&reply, COAP_OPT_MAX_AGE,
+                                               &max_age));
+    TEST_ASSERT(max_age <= 30);
+
+    /* a request with the ETag of the entry gets 2.03 Valid */
+    coap_pkt_init(&req, _req_buf, sizeof(_req_buf), coap_get_total_hdr_len(&req));
+    coap_opt_add_opaque(&req, COAP_OPT_ETAG, _etag, sizeof(_etag));
+    coap_opt_add_uri_path(&req, "/a");
+    len = coap_opt_finish(&req, COAP_OPT_FINISH_NONE);
+    coap_parse(&req, _req_buf, len);
+    TEST_ASSERT(nanocoap_cache_etag_match(ce, &req));
+
+    /* the request buffer may be used for the reply */
+    res = nanocoap_cache_build_reply(ce, &req, _req_buf, sizeof(_req_buf));
+    TEST_ASSERT(res > 0);
+    TEST_ASSERT_EQUAL_INT(0, coap_parse(&reply, _req_buf, res));
+    TEST_ASSERT_EQUAL_INT(COAP_CODE_VALID, coap_get_code_raw(&reply));
+    TEST_ASSERT_EQUAL_INT(0, reply.payload_len);
+    TEST_ASSERT_EQUAL_INT(2, coap_get_token_len(&reply));
+    TEST_ASSERT_EQUAL_INT(0x34, reply.token[1]);
+}
+
+Test *tests_nanocoap_cache_tests(void)
+{
+    EMB_UNIT_TESTFIXTURES(fixtures) {
+        new_TestFixture(test_nanocoap_cache__key),
+        new_TestFixture(test_nanocoap_cache__key_proxy_uri),
+        new_TestFixture(test_nanocoap_cache__add_lookup),
+        new_TestFixture(test_nanocoap_cache__not_cacheable),
+        new_TestFixture(test_nanocoap_cache__lru),
+        new_TestFixture(test_nanocoap_cache__uri_key),
+        new_TestFixture(test_nanocoap_cache__invalidate),
+        new_TestFixture(test_nanocoap_cache__validate),
+        new_TestFixture(test_nanocoap_cache__build_reply),
+    };
+
+    EMB_UNIT_TESTCALLER(nanocoap_cache_tests, set_up, NULL, fixtures);
+
+    return (Test *)&nanocoap_cache_tests;
+}
+
+void tests_nanocoap_cache(void)
+{
+    TESTS_RUN(tests_nanocoap_cache_tests());
+}
+/** @} */
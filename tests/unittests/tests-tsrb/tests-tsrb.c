@@ -162,6 +162,63 @@ static void test_add(void)
     }
 }
 
+static void test_add_get_wrap(void)
+{
+    for (int i = 0; i < (int)sizeof(_io_buffer); i++) {
+        _io_buffer[i] = TEST_INPUT + i;
+    }
+    /* move read and write position to the middle of the buffer */
+    TEST_ASSERT_EQUAL_INT(BUFFER_SIZE / 2, tsrb_add(&_tsrb, _io_buffer,
+                                                    BUFFER_SIZE / 2));
+    TEST_ASSERT_EQUAL_INT(BUFFER_SIZE / 2, tsrb_drop(&_tsrb, BUFFER_SIZE));
+
+    TEST_ASSERT_EQUAL_INT(BUFFER_SIZE, tsrb_add(&_tsrb, _io_buffer,
+                                                sizeof(_io_buffer)));
+    memset(_io_buffer, IO_BUFFER_CANARY, sizeof(_io_buffer));
+    TEST_ASSERT_EQUAL_INT(BUFFER_SIZE, tsrb_get(&_tsrb, _io_buffer,
+                                                sizeof(_io_buffer)));
+    for (int i = 0; i < BUFFER_SIZE; i++) {
+        TEST_ASSERT_EQUAL_INT((uint8_t)(TEST_INPUT + i), _io_buffer[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(IO_BUFFER_CANARY, _io_buffer[BUFFER_SIZE]);
+}
+
+static void test_iov(void)
+{
+    struct iovec iov[2];
+
+    /* move read and write position close to the end of the buffer */
+    TEST_ASSERT_EQUAL_INT(BUFFER_SIZE - 3, tsrb_reserve_iov(&_tsrb, iov,
+                                                            BUFFER_SIZE - 3));
+    tsrb_commit(&_tsrb, BUFFER_SIZE - 3);
+    TEST_ASSERT_EQUAL_INT(BUFFER_SIZE - 3, tsrb_drop(&_tsrb, BUFFER_SIZE));
+
+    /* free space wraps around */
+    TEST_ASSERT_EQUAL_INT(BUFFER_SIZE, tsrb_reserve_iov(&_tsrb, iov,
+                                                        sizeof(_io_buffer)));
+    TEST_ASSERT(iov[0].iov_base == &_tsrb_buffer[BUFFER_SIZE - 3]);
+    TEST_ASSERT_EQUAL_INT(3, iov[0].iov_len);
+    TEST_ASSERT(iov[1].iov_base == _tsrb_buffer);
+    TEST_ASSERT_EQUAL_INT(BUFFER_SIZE - 3, iov[1].iov_len);
+    memset(iov[0].iov_base, TEST_INPUT, iov[0].iov_len);
+    memset(iov[1].iov_base, TEST_INPUT + 1, 2);
+    tsrb_commit(&_tsrb, 5);
+    TEST_ASSERT_EQUAL_INT(5, tsrb_avail(&_tsrb));
+
+    /* so does the data */
+    TEST_ASSERT_EQUAL_INT(5, tsrb_peek_iov(&_tsrb, iov, sizeof(_io_buffer)));
+    TEST_ASSERT_EQUAL_INT(3, iov[0].iov_len);
+    TEST_ASSERT_EQUAL_INT(2, iov[1].iov_len);
+    TEST_ASSERT_EQUAL_INT(TEST_INPUT, *(uint8_t *)iov[0].iov_base);
+    TEST_ASSERT_EQUAL_INT(TEST_INPUT + 1, *(uint8_t *)iov[1].iov_base);
+    TEST_ASSERT_EQUAL_INT(5, tsrb_avail(&_tsrb));
+
+    /* peeking less than available only uses the first region */
+    TEST_ASSERT_EQUAL_INT(2, tsrb_peek_iov(&_tsrb, iov, 2));
+    TEST_ASSERT_EQUAL_INT(2, iov[0].iov_len);
+    TEST_ASSERT_EQUAL_INT(0, iov[1].iov_len);
+}
+
 static Test *tests_tsrb_tests(void)
 {
     EMB_UNIT_TESTFIXTURES(fixtures) {
@@ -174,6 +231,8 @@ static Test *tests_tsrb_tests(void)
         new_TestFixture(test_drop),
         new_TestFixture(test_add_one),
         new_TestFixture(test_add),
+        new_TestFixture(test_add_get_wrap),
+        new_TestFixture(test_iov),
     };
 
     EMB_UNIT_TESTCALLER(tsrb_tests, NULL, tear_down, fixtures);
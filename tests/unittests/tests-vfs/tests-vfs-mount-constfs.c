@@ -171,6 +171,185 @@ static void test_vfs_constfs_read_lseek(void)
     TEST_ASSERT_EQUAL_INT(0, res);
 }
 
+static uint8_t _sink_buf[64];
+static size_t _sink_len;
+
+static ssize_t _sink_write(vfs_file_t *filp, const void *src, size_t nbytes)
+{
+    (void)filp;
+    /* accept at most 5 bytes per call to exercise partial transfers */
+    if (nbytes > 5) {
+        nbytes = 5;
+    }
+    if (nbytes > sizeof(_sink_buf) - _sink_len) {
+        nbytes = sizeof(_sink_buf) - _sink_len;
+    }
+    memcpy(&_sink_buf[_sink_len], src, nbytes);
+    _sink_len += nbytes;
+    return nbytes;
+}
+
+static const vfs_file_ops_t _sink_ops = {
+    .write = _sink_write,
+};
+
+static void test_vfs_constfs_readv_writev(void)
+{
+    int res;
+    res = vfs_mount(&_test_vfs_mount);
+    TEST_ASSERT_EQUAL_INT(0, res);
+
+    int fd = vfs_open("/test/test.txt", O_RDONLY, 0);
+    TEST_ASSERT(fd >= 0);
+
+    char head[4];
+    char tail[64];
+    memset(tail, '\0', sizeof(tail));
+    iolist_t iol_tail = { .iol_base = tail, .iol_len = sizeof(tail) };
+    iolist_t iol_head = { .iol_next = &iol_tail, .iol_base = head, .iol_len = sizeof(head) };
+    ssize_t nbytes = vfs_readv(fd, &iol_head);
+    TEST_ASSERT_EQUAL_INT(sizeof(str_data), nbytes);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(head, str_data, sizeof(head)));
+    TEST_ASSERT_EQUAL_STRING((const char *)&str_data[sizeof(head)], &tail[0]);
+
+    res = vfs_close(fd);
+    TEST_ASSERT_EQUAL_INT(0, res);
+
+    int sink = vfs_bind(VFS_ANY_FD, O_WRONLY, &_sink_ops, NULL);
+    TEST_ASSERT(sink >= 0);
+    _sink_len = 0;
+    iol_head.iol_base = (void *)str_data;
+    iol_tail.iol_base = (void *)&str_data[sizeof(head)];
+    iol_tail.iol_len = sizeof(str_data) - sizeof(head);
+    /* the write fallback stops at the first short write */
+    nbytes = vfs_writev(sink, &iol_head);
+    TEST_ASSERT_EQUAL_INT(sizeof(head) + 5, nbytes);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(_sink_buf, str_data, nbytes));
+
+    res = vfs_close(sink);
+    TEST_ASSERT_EQUAL_INT(0, res);
+
+    res = vfs_umount(&_test_vfs_mount);
+    TEST_ASSERT_EQUAL_INT(0, res);
+}
+
+static void test_vfs_constfs_sendfile(void)
+{
+    int res;
+    res = vfs_mount(&_test_vfs_mount);
+    TEST_ASSERT_EQUAL_INT(0, res);
+
+    int fd = vfs_open("/test/data.bin", O_RDONLY, 0);
+    TEST_ASSERT(fd >= 0);
+    int sink = vfs_bind(VFS_ANY_FD, O_WRONLY, &_sink_ops, NULL);
+    TEST_ASSERT(sink >= 0);
+
+    /* sendfile with explicit offset leaves the file position alone */
+    _sink_len = 0;
+    off_t off = 2;
+    ssize_t nbytes = vfs_sendfile(sink, fd, &off, 20);
+    TEST_ASSERT_EQUAL_INT(20, nbytes);
+    TEST_ASSERT_EQUAL_INT(22, off);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(_sink_buf, &bin_data[2], 20));
+    TEST_ASSERT_EQUAL_INT(0, vfs_lseek(fd, 0, SEEK_CUR));
+
+    /* sendfile from the current position stops at the end of file */
+    _sink_len = 0;
+    nbytes = vfs_sendfile(sink, fd, NULL, sizeof(bin_data) + 10);
+    TEST_ASSERT_EQUAL_INT(sizeof(bin_data), nbytes);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(_sink_buf, bin_data, sizeof(bin_data)));
+
+    res = vfs_close(sink);
+    TEST_ASSERT_EQUAL_INT(0, res);
+    res = vfs_close(fd);
+    TEST_ASSERT_EQUAL_INT(0, res);
+
+    res = vfs_umount(&_test_vfs_mount);
+    TEST_ASSERT_EQUAL_INT(0, res);
+}
+
+static void test_vfs_constfs_remount(void)
+{
+    int res;
+    res = vfs_mount(&_test_vfs_mount);
+    TEST_ASSERT_EQUAL_INT(0, res);
+
+    /* open twice to exercise the mount lookup cache */
+    for (unsigned i = 0; i < 2; i++) {
+        int fd = vfs_open("/test/test.txt", O_RDONLY, 0);
+        TEST_ASSERT(fd >= 0);
+        res = vfs_close(fd);
+        TEST_ASSERT_EQUAL_INT(0, res);
+    }
+
+    res = vfs_umount(&_test_vfs_mount);
+    TEST_ASSERT_EQUAL_INT(0, res);
+
+    /* stale cache entries must not resolve to the unmounted file system */
+    int fd = vfs_open("/test/test.txt", O_RDONLY, 0);
+    TEST_ASSERT_EQUAL_INT(-ENOENT, fd);
+}
+
+static void test_vfs_constfs_openat(void)
+{
+    int res;
+    res = vfs_mount(&_test_vfs_mount);
+    TEST_ASSERT_EQUAL_INT(0, res);
+
+    vfs_dirat_t dir;
+    res = vfs_dirat_open(&dir, "/test/");
+    TEST_ASSERT_EQUAL_INT(0, res);
+
+    /* the mount is busy while the directory handle is held */
+    res = vfs_umount(&_test_vfs_mount);
+    TEST_ASSERT_EQUAL_INT(-EBUSY, res);
+
+    int fd = vfs_openat(&dir, "notfound", O_RDONLY, 0);
+    TEST_ASSERT_EQUAL_INT(-ENOENT, fd);
+
+    fd = vfs_openat(&dir, "test.txt", O_RDONLY, 0);
+    TEST_ASSERT(fd >= 0);
+    char strbuf[64];
+    memset(strbuf, '\0', sizeof(strbuf));
+    ssize_t nbytes = vfs_read(fd, strbuf, sizeof(strbuf));
+    TEST_ASSERT_EQUAL_INT(sizeof(str_data), nbytes);
+    TEST_ASSERT_EQUAL_STRING((const char *)&str_data[0], (const char *)&strbuf[0]);
+    res = vfs_close(fd);
+    TEST_ASSERT_EQUAL_INT(0, res);
+
+    struct stat buf;
+    res = vfs_statat(&dir, "data.bin", &buf);
+    TEST_ASSERT_EQUAL_INT(0, res);
+    TEST_ASSERT_EQUAL_INT(sizeof(bin_data), buf.st_size);
+
+    res = vfs_unlinkat(&dir, "data.bin");
+    TEST_ASSERT(res < 0);
+
+    /* names can not reach outside of the directory */
+    fd = vfs_openat(&dir, "../test/test.txt", O_RDONLY, 0);
+    TEST_ASSERT_EQUAL_INT(-EINVAL, fd);
+    fd = vfs_openat(&dir, "sub/test.txt", O_RDONLY, 0);
+    TEST_ASSERT_EQUAL_INT(-EINVAL, fd);
+    fd = vfs_openat(&dir, "..", O_RDONLY, 0);
+    TEST_ASSERT_EQUAL_INT(-EINVAL, fd);
+    fd = vfs_openat(&dir, ".", O_RDONLY, 0);
+    TEST_ASSERT_EQUAL_INT(-EINVAL, fd);
+    fd = vfs_openat(&dir, "", O_RDONLY, 0);
+    TEST_ASSERT_EQUAL_INT(-EINVAL, fd);
+    res = vfs_statat(&dir, "/data.bin", &buf);
+    TEST_ASSERT_EQUAL_INT(-EINVAL, res);
+    res = vfs_unlinkat(&dir, "../data.bin");
+    TEST_ASSERT_EQUAL_INT(-EINVAL, res);
+
+    res = vfs_dirat_close(&dir);
+    TEST_ASSERT_EQUAL_INT(0, res);
+    res = vfs_openat(&dir, "test.txt", O_RDONLY, 0);
+    TEST_ASSERT_EQUAL_INT(-EBADF, res);
+
+    res = vfs_umount(&_test_vfs_mount);
+    TEST_ASSERT_EQUAL_INT(0, res);
+}
+
 #if MODULE_NEWLIB || defined(BOARD_NATIVE)
 static void test_vfs_constfs__posix(void)
 {
@@ -210,6 +389,10 @@ Test *tests_vfs_mount_constfs_tests(void)
         new_TestFixture(test_vfs_umount__invalid_mount),
         new_TestFixture(test_vfs_constfs_open),
         new_TestFixture(test_vfs_constfs_read_lseek),
+        new_TestFixture(test_vfs_constfs_readv_writev),
+        new_TestFixture(test_vfs_constfs_sendfile),
+        new_TestFixture(test_vfs_constfs_remount),
+        new_TestFixture(test_vfs_constfs_openat),
 #if MODULE_NEWLIB || defined(BOARD_NATIVE)
         new_TestFixture(test_vfs_constfs__posix),
 #endif